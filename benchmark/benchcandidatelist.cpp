@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "fcitx/candidatelist.h"
+#include "fcitx/text.h"
+
+using namespace fcitx;
+
+namespace {
+
+void BM_CandidateListBuild(benchmark::State &state) {
+    for (auto _ : state) {
+        auto list = std::make_unique<CommonCandidateList>();
+        list->setPageSize(9);
+        for (int64_t i = 0; i < state.range(0); i++) {
+            list->append<DisplayOnlyCandidateWord>(Text(std::to_string(i)));
+        }
+        benchmark::DoNotOptimize(list->size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CandidateListBuild)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_CandidateListPage(benchmark::State &state) {
+    CommonCandidateList list;
+    list.setPageSize(9);
+    for (int i = 0; i < 1000; i++) {
+        list.append<DisplayOnlyCandidateWord>(Text(std::to_string(i)));
+    }
+    for (auto _ : state) {
+        if (list.hasNext()) {
+            list.next();
+        } else {
+            list.setPage(0);
+        }
+        for (int i = 0; i < list.size(); i++) {
+            benchmark::DoNotOptimize(&list.candidate(i).text());
+        }
+    }
+}
+BENCHMARK(BM_CandidateListPage);
+
+} // namespace
@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/dbus/bus.h"
+#include "fcitx-utils/dbus/message.h"
+#include "fcitx-utils/dbus/variant.h"
+#include "fcitx-utils/event.h"
+
+using namespace fcitx;
+using namespace fcitx::dbus;
+
+namespace {
+
+// Similar to the formatted preedit signal of the dbus frontend.
+using Preedit = std::vector<DBusStruct<std::string, int32_t>>;
+
+Preedit samplePreedit() {
+    Preedit preedit;
+    for (int i = 0; i < 8; i++) {
+        preedit.emplace_back(std::make_tuple("segment", i));
+    }
+    return preedit;
+}
+
+// Messages need a bus to be created, skip if there is no session bus.
+template <typename Callback>
+void withBus(benchmark::State &state, Callback callback) {
+    try {
+        Bus bus(BusType::Session);
+        callback(bus);
+    } catch (const std::exception &e) {
+        state.SkipWithError(e.what());
+    }
+}
+
+void BM_DBusMessageMarshall(benchmark::State &state) {
+    const auto preedit = samplePreedit();
+    withBus(state, [&state, &preedit](Bus &bus) {
+        for (auto _ : state) {
+            auto message =
+                bus.createSignal("/benchmark", "org.fcitx.Benchmark", "Test");
+            message << preedit << 3;
+            benchmark::DoNotOptimize(message);
+        }
+    });
+}
+BENCHMARK(BM_DBusMessageMarshall);
+
+void BM_DBusMessageVariant(benchmark::State &state) {
+    withBus(state, [&state](Bus &bus) {
+        for (auto _ : state) {
+            auto message =
+                bus.createSignal("/benchmark", "org.fcitx.Benchmark", "Test");
+            message << Variant(std::string("value")) << Variant(int32_t(1));
+            benchmark::DoNotOptimize(message);
+        }
+    });
+}
+BENCHMARK(BM_DBusMessageVariant);
+
+// A burst of calls from one connection to another, which covers how many
+// queued messages are handled in one wakeup.
+void BM_DBusCallBurst(benchmark::State &state) {
+    withBus(state, [&state](Bus &server) {
+        Bus client(BusType::Session);
+        EventLoop loop;
+        server.attachEventLoop(&loop);
+        client.attachEventLoop(&loop);
+        const auto name = server.uniqueName();
+        const auto burst = state.range(0);
+        for (auto _ : state) {
+            int64_t replies = 0;
+            std::vector<std::unique_ptr<Slot>> slots;
+            for (int64_t i = 0; i < burst; i++) {
+                auto message = client.createMethodCall(
+                    name.c_str(), "/", "org.freedesktop.DBus.Peer", "Ping");
+                slots.push_back(message.callAsync(
+                    0, [&replies, &loop, burst](Message &) {
+                        if (++replies == burst) {
+                            loop.exit();
+                        }
+                        return true;
+                    }));
+            }
+            loop.exec();
+        }
+        server.detachEventLoop();
+        client.detachEventLoop();
+        state.SetItemsProcessed(state.iterations() * burst);
+    });
+}
+BENCHMARK(BM_DBusCallBurst)->Arg(1)->Arg(100);
+
+} // namespace
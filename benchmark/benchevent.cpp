@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/event.h"
+
+using namespace fcitx;
+
+namespace {
+
+std::vector<std::unique_ptr<EventSourceTime>> addTimers(EventLoop &loop,
+                                                        int64_t count,
+                                                        uint64_t base) {
+    std::vector<std::unique_ptr<EventSourceTime>> timers;
+    timers.reserve(count);
+    for (int64_t i = 0; i < count; i++) {
+        timers.push_back(
+            loop.addTimeEvent(CLOCK_MONOTONIC, base + (i % 97) * 1000, 0,
+                              [](EventSourceTime *, uint64_t) { return true; }));
+    }
+    return timers;
+}
+
+void BM_TimerAdd(benchmark::State &state) {
+    EventLoop loop;
+    const auto base = now(CLOCK_MONOTONIC) + 10000000;
+    for (auto _ : state) {
+        auto timers = addTimers(loop, state.range(0), base);
+        benchmark::DoNotOptimize(timers.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimerAdd)->Arg(100)->Arg(10000);
+
+void BM_TimerReschedule(benchmark::State &state) {
+    EventLoop loop;
+    const auto base = now(CLOCK_MONOTONIC) + 10000000;
+    auto timers = addTimers(loop, state.range(0), base);
+    uint64_t offset = 0;
+    for (auto _ : state) {
+        offset = (offset + 1) % 89;
+        for (auto &timer : timers) {
+            timer->setTime(base + offset * 1000);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimerReschedule)->Arg(100)->Arg(10000);
+
+// Fire a batch of timers that are all due, which covers the dispatch.
+void BM_TimerDispatch(benchmark::State &state) {
+    EventLoop loop;
+    const auto batch = state.range(0);
+    int64_t count = 0;
+    std::vector<std::unique_ptr<EventSourceTime>> timers;
+    timers.reserve(batch);
+    for (int64_t i = 0; i < batch; i++) {
+        timers.push_back(loop.addTimeEvent(
+            CLOCK_MONOTONIC, 0, 0,
+            [&count, &loop, batch](EventSourceTime *, uint64_t) {
+                if (++count == batch) {
+                    loop.exit();
+                }
+                return true;
+            }));
+    }
+    for (auto _ : state) {
+        count = 0;
+        const auto current = now(CLOCK_MONOTONIC);
+        for (auto &timer : timers) {
+            timer->setTime(current);
+            timer->setOneShot();
+        }
+        loop.exec();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_TimerDispatch)->Arg(1)->Arg(1000);
+
+} // namespace
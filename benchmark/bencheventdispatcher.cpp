@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/eventdispatcher.h"
+
+using namespace fcitx;
+
+namespace {
+
+// Schedule a batch from the loop thread and run it, which covers both the
+// wake up and the dispatch.
+void BM_EventDispatcherSchedule(benchmark::State &state) {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+    const auto batch = state.range(0);
+    for (auto _ : state) {
+        int64_t count = 0;
+        for (int64_t i = 0; i < batch; i++) {
+            dispatcher.schedule([&count, &loop, batch]() {
+                if (++count == batch) {
+                    loop.exit();
+                }
+            });
+        }
+        loop.exec();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_EventDispatcherSchedule)->Arg(1)->Arg(64);
+
+} // namespace
@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstddef>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "fcitx-config/flatrawconfig.h"
+#include "fcitx-config/iniparser.h"
+#include "fcitx-config/rawconfig.h"
+#include "fcitx-utils/stringutils.h"
+
+using namespace fcitx;
+
+namespace {
+
+// Roughly the size of a profile with a few groups.
+std::string sampleIni() {
+    std::string ini;
+    for (int group = 0; group < 8; group++) {
+        ini += "[Groups/" + std::to_string(group) + "]\n";
+        ini += "Name=Group " + std::to_string(group) + "\n";
+        ini += "Default Layout=us\nDefaultIM=pinyin\n\n";
+        for (int item = 0; item < 4; item++) {
+            ini += "[Groups/" + std::to_string(group) + "/Items/" +
+                   std::to_string(item) + "]\n";
+            ini += "Name=keyboard-us\nLayout=\n\n";
+        }
+    }
+    ini += "[GroupOrder]\n0=Group 0\n1=Group 1\n";
+    return ini;
+}
+
+void BM_IniParse(benchmark::State &state) {
+    const auto ini = sampleIni();
+    for (auto _ : state) {
+        RawConfig config;
+        readFromIni(config, ini);
+        benchmark::DoNotOptimize(config.subItemsSize());
+    }
+    state.SetBytesProcessed(state.iterations() * ini.size());
+}
+BENCHMARK(BM_IniParse);
+
+void BM_IniWrite(benchmark::State &state) {
+    RawConfig config;
+    readFromIni(config, sampleIni());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writeAsIni(config));
+    }
+}
+BENCHMARK(BM_IniWrite);
+
+// A large config, e.g. a loaded theme or an input method table definition.
+RawConfig largeConfig() {
+    RawConfig config;
+    for (int i = 0; i < 200; i++) {
+        auto group = stringutils::concat("Group", i);
+        for (int j = 0; j < 20; j++) {
+            config.setValueByPath(stringutils::concat(group, "/Key", j),
+                                  stringutils::concat("Value", i * j));
+        }
+    }
+    return config;
+}
+
+void BM_RawConfigCopy(benchmark::State &state) {
+    const auto config = largeConfig();
+    for (auto _ : state) {
+        RawConfig copy(config);
+        benchmark::DoNotOptimize(copy.subItemsSize());
+    }
+}
+BENCHMARK(BM_RawConfigCopy);
+
+void BM_FlatRawConfigCopy(benchmark::State &state) {
+    const FlatRawConfig config(largeConfig());
+    for (auto _ : state) {
+        FlatRawConfig copy(config);
+        benchmark::DoNotOptimize(copy.size());
+    }
+}
+BENCHMARK(BM_FlatRawConfigCopy);
+
+void BM_RawConfigWalk(benchmark::State &state) {
+    const auto config = largeConfig();
+    for (auto _ : state) {
+        size_t total = 0;
+        config.visitSubItems(
+            [&total](const RawConfig &item, const std::string &) {
+                total += item.value().size();
+                return true;
+            },
+            "", true);
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_RawConfigWalk);
+
+void BM_FlatRawConfigWalk(benchmark::State &state) {
+    const FlatRawConfig config(largeConfig());
+    for (auto _ : state) {
+        size_t total = 0;
+        for (FlatRawConfig::Index i = 0; i < config.size(); i++) {
+            total += config.value(i).size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+}
+BENCHMARK(BM_FlatRawConfigWalk);
+
+} // namespace
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/capabilityflags.h"
+#include "fcitx-utils/key.h"
+#include "fcitx/event.h"
+#include "fcitx/inputcontext.h"
+#include "fcitx/inputcontextmanager.h"
+#include "fcitx/inputpanel.h"
+#include "fcitx/text.h"
+
+using namespace fcitx;
+
+namespace {
+
+class BenchInputContext : public InputContext {
+public:
+    using InputContext::InputContext;
+
+    ~BenchInputContext() override { destroy(); }
+
+    const char *frontend() const override { return "benchmark"; }
+
+    void commitStringImpl(const std::string &text) override {
+        committed_ += text.size();
+    }
+    void deleteSurroundingTextImpl(int, unsigned int) override {}
+    void forwardKeyImpl(const ForwardKeyEvent &) override { forwarded_++; }
+    void updatePreeditImpl() override { preedit_++; }
+
+    size_t committed_ = 0;
+    size_t forwarded_ = 0;
+    size_t preedit_ = 0;
+};
+
+// Fast typing while the client is blocked, every key produces a commit and a
+// preedit update that are delivered once the client is unblocked.
+void BM_BlockedEventDelivery(benchmark::State &state) {
+    InputContextManager manager;
+    auto ic = std::make_unique<BenchInputContext>(manager, "benchmark");
+    ic->setCapabilityFlags(CapabilityFlag::Preedit);
+    ic->inputPanel().setClientPreedit(Text("a"));
+    const auto keys = state.range(0);
+    for (auto _ : state) {
+        ic->setBlockEventToClient(true);
+        for (int64_t i = 0; i < keys; i++) {
+            ic->commitString("a");
+            ic->updatePreedit();
+        }
+        ic->forwardKey(Key(FcitxKey_BackSpace));
+        ic->setBlockEventToClient(false);
+    }
+    benchmark::DoNotOptimize(ic->committed_);
+    state.SetItemsProcessed(state.iterations() * (keys * 2 + 1));
+}
+BENCHMARK(BM_BlockedEventDelivery)->Arg(1)->Arg(8);
+
+} // namespace
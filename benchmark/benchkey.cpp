@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/key.h"
+#include "fcitx-utils/keydata.h"
+#include "fcitx-utils/macros.h"
+
+using namespace fcitx;
+
+namespace {
+
+constexpr char keyListString[] =
+    "Control+space Zenkaku_Hankaku Hangul Control+Shift+F Super+space "
+    "Alt+grave Shift_L Control+Alt+Delete";
+
+void BM_KeyParse(benchmark::State &state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Key("Control+Shift+F"));
+    }
+}
+BENCHMARK(BM_KeyParse);
+
+void BM_KeyListParse(benchmark::State &state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Key::keyListFromString(keyListString));
+    }
+}
+BENCHMARK(BM_KeyListParse);
+
+void BM_KeyToString(benchmark::State &state) {
+    const Key key("Control+Shift+F");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(key.toString());
+    }
+}
+BENCHMARK(BM_KeyToString);
+
+void BM_KeyFromUnicode(benchmark::State &state) {
+    uint32_t unicode = 0x20;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Key::keySymFromUnicode(unicode));
+        unicode = unicode == 0x3000 ? 0x20 : unicode + 1;
+    }
+}
+BENCHMARK(BM_KeyFromUnicode);
+
+// Convert every entry of the keysym table in both directions.
+void BM_KeySymUnicodeTable(benchmark::State &state) {
+    for (auto _ : state) {
+        for (const auto &item : keysym_to_unicode_tab) {
+            benchmark::DoNotOptimize(
+                Key::keySymToUnicode(static_cast<KeySym>(item.keysym)));
+            benchmark::DoNotOptimize(Key::keySymFromUnicode(item.ucs));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            FCITX_ARRAY_SIZE(keysym_to_unicode_tab) * 2);
+}
+BENCHMARK(BM_KeySymUnicodeTable);
+
+} // namespace
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/log.h"
+
+using namespace fcitx;
+
+namespace {
+
+FCITX_DEFINE_LOG_CATEGORY(benchmark_log, "benchmark", LogLevel::Info);
+
+// A debug log that is disabled should only cost the cached level check.
+void BM_DisabledLog(benchmark::State &state) {
+    int value = 0;
+    for (auto _ : state) {
+        ++value;
+        FCITX_LOGC(benchmark_log, Debug) << "value: " << value;
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_DisabledLog);
+
+void BM_CheckLogLevel(benchmark::State &state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            benchmark_log().checkLogLevel(LogLevel::Debug));
+    }
+}
+BENCHMARK(BM_CheckLogLevel);
+
+} // namespace
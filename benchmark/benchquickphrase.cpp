@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/stringutils.h"
+#include "quickphrasestore.h"
+
+using namespace fcitx;
+
+namespace {
+
+// Phrases with a key shared by about 4 of them, like the data files.
+std::vector<std::pair<std::string, std::string>> phrases(int64_t count) {
+    std::vector<std::pair<std::string, std::string>> result;
+    result.reserve(count);
+    for (int64_t i = 0; i < count; i++) {
+        result.emplace_back(stringutils::concat("k", (i * 7919) % (count / 4)),
+                            stringutils::concat("phrase", i));
+    }
+    return result;
+}
+
+std::vector<std::string> prefixes(int64_t count) {
+    std::vector<std::string> result;
+    for (int64_t i = 0; i < 1000; i++) {
+        result.push_back(stringutils::concat("k", (i * 37) % (count / 4)));
+    }
+    return result;
+}
+
+void BM_QuickPhraseStoreBuild(benchmark::State &state) {
+    const auto input = phrases(state.range(0));
+    for (auto _ : state) {
+        QuickPhraseStore store;
+        for (const auto &[key, value] : input) {
+            store.add(key, value);
+        }
+        store.build();
+        benchmark::DoNotOptimize(store.size());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_QuickPhraseStoreBuild)->Range(1000, 200000);
+
+void BM_MultimapBuild(benchmark::State &state) {
+    const auto input = phrases(state.range(0));
+    for (auto _ : state) {
+        std::multimap<std::string, std::string> map;
+        for (const auto &[key, value] : input) {
+            map.emplace(key, value);
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_MultimapBuild)->Range(1000, 200000);
+
+void BM_QuickPhraseStoreLookup(benchmark::State &state) {
+    QuickPhraseStore store;
+    for (const auto &[key, value] : phrases(state.range(0))) {
+        store.add(key, value);
+    }
+    store.build();
+    const auto lookups = prefixes(state.range(0));
+    for (auto _ : state) {
+        size_t count = 0;
+        for (const auto &prefix : lookups) {
+            store.forEachPrefix(
+                prefix, [&count](std::string_view key, std::string_view value) {
+                    count += key.size() + value.size();
+                });
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+BENCHMARK(BM_QuickPhraseStoreLookup)->Range(1000, 200000);
+
+void BM_MultimapLookup(benchmark::State &state) {
+    std::multimap<std::string, std::string> map;
+    for (auto &[key, value] : phrases(state.range(0))) {
+        map.emplace(std::move(key), std::move(value));
+    }
+    const auto lookups = prefixes(state.range(0));
+    for (auto _ : state) {
+        size_t count = 0;
+        for (const auto &prefix : lookups) {
+            for (auto iter = map.lower_bound(prefix);
+                 iter != map.end() &&
+                 stringutils::startsWith(iter->first, prefix);
+                 ++iter) {
+                count += iter->first.size() + iter->second.size();
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+BENCHMARK(BM_MultimapLookup)->Range(1000, 200000);
+
+} // namespace
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/handlertable.h"
+#include "fcitx-utils/signals.h"
+
+using namespace fcitx;
+
+namespace {
+
+void BM_SignalEmit(benchmark::State &state) {
+    Signal<void(int)> signal;
+    int sum = 0;
+    std::vector<ScopedConnection> connections;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        connections.emplace_back(signal.connect([&sum](int v) { sum += v; }));
+    }
+    for (auto _ : state) {
+        signal(1);
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SignalEmit)->Arg(1)->Arg(8)->Arg(64);
+
+void BM_HandlerTableIterate(benchmark::State &state) {
+    HandlerTable<std::function<void(int)>> table;
+    int sum = 0;
+    std::vector<std::unique_ptr<HandlerTableEntry<std::function<void(int)>>>>
+        entries;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        entries.push_back(table.add([&sum](int v) { sum += v; }));
+    }
+    for (auto _ : state) {
+        for (auto &handler : table.view()) {
+            handler(1);
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HandlerTableIterate)->Arg(1)->Arg(8)->Arg(64);
+
+} // namespace
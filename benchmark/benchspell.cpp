@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/testing.h"
+#include "spell-custom-dict.h"
+
+using namespace fcitx;
+
+namespace {
+
+// The en dict compiled in the build tree, nullptr if it is not available.
+SpellCustomDict *englishDict() {
+    static std::unique_ptr<SpellCustomDict> dict = []() {
+        setupTestingEnvironment(FCITX5_BINARY_DIR, {}, {"src/modules"});
+        try {
+            return std::unique_ptr<SpellCustomDict>(
+                SpellCustomDict::requestDict("en"));
+        } catch (const std::exception &) {
+            return std::unique_ptr<SpellCustomDict>();
+        }
+    }();
+    return dict.get();
+}
+
+void BM_CustomDictHint(benchmark::State &state) {
+    auto *dict = englishDict();
+    if (!dict) {
+        state.SkipWithError("en dict is not available");
+        return;
+    }
+    const std::vector<std::string> words = {
+        "a",     "ap",    "aple",     "Helo",       "teh",        "recieve",
+        "wrold", "HELLO", "langauge", "experiance", "definately", "zxqv"};
+    for (auto _ : state) {
+        for (const auto &word : words) {
+            benchmark::DoNotOptimize(dict->hint(word, 10));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_CustomDictHint);
+
+} // namespace
@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <benchmark/benchmark.h>
+#include "fcitx/text.h"
+
+using namespace fcitx;
+
+namespace {
+
+void BM_TextBuild(benchmark::State &state) {
+    for (auto _ : state) {
+        Text text;
+        text.append("ni", TextFormatFlag::Underline);
+        text.append("hao", TextFormatFlag::HighLight);
+        text.append("你好");
+        text.setCursor(2);
+        benchmark::DoNotOptimize(text.toString());
+    }
+}
+BENCHMARK(BM_TextBuild);
+
+void BM_TextToString(benchmark::State &state) {
+    Text text;
+    for (int i = 0; i < 16; i++) {
+        text.append("segment", TextFormatFlag::Underline);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(text.toString());
+    }
+}
+BENCHMARK(BM_TextToString);
+
+} // namespace
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <cstdint>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "fcitx-utils/cutf8.h"
+#include "fcitx-utils/utf8.h"
+
+using namespace fcitx;
+
+namespace {
+
+// Mixed ASCII and CJK text, similar to a preedit or a candidate.
+std::string sampleText() {
+    std::string text;
+    for (int i = 0; i < 64; i++) {
+        text += "fcitx输入法";
+    }
+    return text;
+}
+
+void BM_UTF8Length(benchmark::State &state) {
+    const auto text = sampleText();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(utf8::length(text));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8Length);
+
+void BM_UTF8Validate(benchmark::State &state) {
+    const auto text = sampleText();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(utf8::validate(text));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8Validate);
+
+// Long plain ASCII (0) or mostly CJK (1) text, the two cases that the fast
+// paths of fcitx_utf8_strnlen are tuned for.
+std::string longText(int64_t kind) {
+    std::string text;
+    for (int i = 0; i < 256; i++) {
+        if (kind == 0) {
+            text += "The quick brown fox jumps over the lazy dog. ";
+        } else {
+            text += "你好，世界。abc ";
+        }
+    }
+    return text;
+}
+
+void BM_UTF8StrnlenValidated(benchmark::State &state) {
+    const auto text = longText(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            fcitx_utf8_strnlen_validated(text.data(), text.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8StrnlenValidated)->Arg(0)->Arg(1);
+
+void BM_UTF8Strnlen(benchmark::State &state) {
+    const auto text = longText(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fcitx_utf8_strnlen(text.data(), text.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8Strnlen)->Arg(0)->Arg(1);
+
+void BM_UTF8Iterate(benchmark::State &state) {
+    const auto text = sampleText();
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (auto c : utf8::MakeUTF8CharRange(text)) {
+            sum += c;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8Iterate);
+
+void BM_UCS4ToUTF8(benchmark::State &state) {
+    uint32_t code = 0x4e00;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(utf8::UCS4ToUTF8(code));
+        code = code == 0x9fff ? 0x4e00 : code + 1;
+    }
+}
+BENCHMARK(BM_UCS4ToUTF8);
+
+} // namespace
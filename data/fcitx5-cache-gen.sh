@@ -0,0 +1,58 @@
+#!/bin/sh
+#--------------------------------------
+# fcitx5-cache-gen
+#
+# Generate the metadata snapshots of addons, input methods, keyboard layouts
+# and compose tables, which can be shared by all the users on the host. List
+# the output directory in FCITX_CACHE_DIRS to use them. Run it again after
+# those data are updated, e.g. from a package manager hook.
+#
+# Snapshots of keyboard layouts and compose tables depend on the locale, so
+# only the users with the same LANG and no LANGUAGE, LC_ALL or LC_MESSAGES
+# share them.
+
+usage() {
+    echo "Usage: $0 [-l LOCALE] DIRECTORY"
+    echo "    -l LOCALE    locale to generate for, default to current LANG"
+}
+
+locale="$LANG"
+while getopts "l:h" opt; do
+    case "$opt" in
+        l)
+            locale="$OPTARG"
+            ;;
+        h)
+            usage
+            exit 0
+            ;;
+        *)
+            usage >&2
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ]; then
+    usage >&2
+    exit 1
+fi
+
+dir="$1"
+mkdir -p "$dir" || exit 1
+
+# Run with an empty home, so nothing of the current user ends up in snapshots.
+home="$(mktemp -d)" || exit 1
+trap 'rm -rf "$home"' EXIT
+
+(
+    unset LANGUAGE LC_ALL LC_MESSAGES XCOMPOSEFILE XDG_CONFIG_HOME \
+        XDG_DATA_HOME DISPLAY WAYLAND_DISPLAY
+    HOME="$home" XDG_CACHE_HOME="$dir" LANG="$locale" \
+        '@FCITX_INSTALL_BINDIR@/fcitx5' --benchmark-startup --disable=all \
+        --enable=keyboard > /dev/null
+) || exit 1
+
+# fcitx5 creates files with umask 077.
+chmod -R a+rX "$dir/fcitx5"
@@ -6,10 +6,20 @@
  */
 
 #include "dbusfrontend.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "fcitx-utils/dbus/message.h"
 #include "fcitx-utils/dbus/objectvtable.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
 #include "fcitx-utils/dbus/variant.h"
+#include "fcitx-utils/endian_p.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/metastring.h"
 #include "fcitx/inputcontext.h"
@@ -31,11 +41,49 @@ enum {
     BATCHED_COMMIT_STRING = 0,
     BATCHED_PREEDIT,
     BATCHED_FORWARD_KEY,
-    BATCHED_DELETE_SURROUNDING
+    BATCHED_DELETE_SURROUNDING,
+    // Only sent with CapabilityFlag::BatchedEvents.
+    BATCHED_CLIENT_SIDE_UI,
+    // Only sent with CapabilityFlag::BatchedEvents and
+    // CapabilityFlag::CompactClientSideUI.
+    BATCHED_CLIENT_SIDE_UI_COMPACT,
 };
 
 using DBusBlockedEvent = dbus::DBusStruct<uint32_t, dbus::Variant>;
 
+// Time to wait for a deferred key event before passing the key through, in
+// microseconds.
+constexpr uint64_t deferredKeyEventTimeout = 2000000;
+
+// Reply of a ProcessKeyEvent call, sent at most once. If the result is never
+// delivered, the key is passed through.
+class KeyEventReply {
+public:
+    explicit KeyEventReply(dbus::Message reply) : reply_(std::move(reply)) {}
+
+    ~KeyEventReply() { send(false); }
+
+    void send(bool accepted) {
+        if (sent_) {
+            return;
+        }
+        sent_ = true;
+        reply_ << accepted;
+        reply_.send();
+    }
+
+    bool sent() const { return sent_; }
+
+    void setTimeout(std::unique_ptr<EventSourceTime> timeout) {
+        timeout_ = std::move(timeout);
+    }
+
+private:
+    dbus::Message reply_;
+    bool sent_ = false;
+    std::unique_ptr<EventSourceTime> timeout_;
+};
+
 bool useClientSideUI(Instance *instance) {
     if (instance->userInterfaceManager().currentUI() != "kimpanel") {
         return true;
@@ -62,6 +110,153 @@ buildFormattedTextVector(const Text &text) {
     return vector;
 }
 
+template <typename T>
+bool sameStructs(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+    return std::equal(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const T &a, const T &b) { return a.data() == b.data(); });
+}
+
+/**
+ * Packed form of UpdateClientSideUI, sent with
+ * CapabilityFlag::CompactClientSideUI.
+ *
+ * All numbers are 32bit little endian. Layout:
+ *   u8 version, u8 flags (has prev, has next, reset), u8 changed sections
+ *   (preedit, aux up, aux down, candidates), u8 padding,
+ *   i32 preedit cursor, i32 candidate index, i32 layout hint,
+ *   u32 string count, then each string as u32 length and the bytes,
+ *   each changed text: u32 segment count, then (u32 string, i32 format),
+ *   if candidates changed: u32 candidate count, u32 updated count, then
+ *   (u32 position, u32 label string, u32 text string) for each updated one.
+ *
+ * Strings are referred by index in the string table of the same message. A
+ * section or candidate that is not included is the same as the previous
+ * message, unless the reset flag is set.
+ */
+class CompactClientSideUI {
+public:
+    using FormattedText = std::vector<dbus::DBusStruct<std::string, int>>;
+    using Candidates = std::vector<dbus::DBusStruct<std::string, std::string>>;
+
+    enum : uint8_t { Version = 1 };
+    enum : uint8_t { HasPrev = 1, HasNext = 2, Reset = 4 };
+    enum : uint8_t {
+        PreeditChanged = 1,
+        AuxUpChanged = 2,
+        AuxDownChanged = 4,
+        CandidatesChanged = 8
+    };
+
+    // Client needs a full update, e.g. it just enabled the capability.
+    void reset() { valid_ = false; }
+
+    std::vector<uint8_t> encode(FormattedText preedit, int preeditCursor,
+                                FormattedText auxUp, FormattedText auxDown,
+                                Candidates candidates, int cursorIndex,
+                                int layoutHint, bool hasPrev, bool hasNext) {
+        FormattedText *texts[] = {&preedit, &auxUp, &auxDown};
+        uint8_t changed = 0;
+        for (size_t i = 0; i < std::size(texts); i++) {
+            if (!valid_ || !sameStructs(*texts[i], lastTexts_[i])) {
+                changed |= (1 << i);
+            }
+        }
+        if (!valid_ || !sameStructs(candidates, lastCandidates_)) {
+            changed |= CandidatesChanged;
+        }
+
+        body_.clear();
+        strings_.clear();
+        stringTable_.clear();
+        for (size_t i = 0; i < std::size(texts); i++) {
+            if (!(changed & (1 << i))) {
+                continue;
+            }
+            append(texts[i]->size());
+            for (const auto &segment : *texts[i]) {
+                append(intern(std::get<0>(segment.data())));
+                append(std::get<1>(segment.data()));
+            }
+        }
+        if (changed & CandidatesChanged) {
+            append(candidates.size());
+            const auto countOffset = body_.size();
+            append(0);
+            uint32_t updated = 0;
+            for (size_t i = 0; i < candidates.size(); i++) {
+                if (valid_ && i < lastCandidates_.size() &&
+                    candidates[i].data() == lastCandidates_[i].data()) {
+                    continue;
+                }
+                append(i);
+                append(intern(std::get<0>(candidates[i].data())));
+                append(intern(std::get<1>(candidates[i].data())));
+                updated++;
+            }
+            const auto value = htole32(updated);
+            memcpy(&body_[countOffset], &value, sizeof(value));
+        }
+
+        std::vector<uint8_t> result;
+        result.push_back(Version);
+        result.push_back((hasPrev ? HasPrev : 0) | (hasNext ? HasNext : 0) |
+                         (valid_ ? 0 : Reset));
+        result.push_back(changed);
+        result.push_back(0);
+        append(result, preeditCursor);
+        append(result, cursorIndex);
+        append(result, layoutHint);
+        append(result, stringTable_.size());
+        for (const auto &str : stringTable_) {
+            append(result, str.size());
+            result.insert(result.end(), str.begin(), str.end());
+        }
+        result.insert(result.end(), body_.begin(), body_.end());
+
+        // Views in the string table point into the input, drop them before
+        // the input is moved.
+        strings_.clear();
+        stringTable_.clear();
+        for (size_t i = 0; i < std::size(texts); i++) {
+            lastTexts_[i] = std::move(*texts[i]);
+        }
+        lastCandidates_ = std::move(candidates);
+        valid_ = true;
+        return result;
+    }
+
+private:
+    template <typename T>
+    static void append(std::vector<uint8_t> &buffer, T value) {
+        const uint32_t le = htole32(static_cast<uint32_t>(value));
+        const auto *data = reinterpret_cast<const uint8_t *>(&le);
+        buffer.insert(buffer.end(), data, data + sizeof(le));
+    }
+
+    template <typename T>
+    void append(T value) {
+        append(body_, value);
+    }
+
+    uint32_t intern(std::string_view str) {
+        auto [iter, inserted] =
+            strings_.emplace(str, static_cast<uint32_t>(stringTable_.size()));
+        if (inserted) {
+            stringTable_.push_back(str);
+        }
+        return iter->second;
+    }
+
+    bool valid_ = false;
+    FormattedText lastTexts_[3];
+    Candidates lastCandidates_;
+    // Scratch buffers kept for the capacity.
+    std::vector<uint8_t> body_;
+    std::unordered_map<std::string_view, uint32_t> strings_;
+    std::vector<std::string_view> stringTable_;
+};
+
 std::string
 getArgument(const std::unordered_map<std::string, std::string> &args,
             const std::string &name, const std::string &defaultValue = "") {
@@ -119,13 +314,29 @@ public:
                        })),
           name_(sender) {
         processKeyEventMethod.setClosureFunction(
-            [this](dbus::Message message, const dbus::ObjectMethod &method) {
-                if (capabilityFlags().test(CapabilityFlag::KeyEventOrderFix)) {
-                    InputContextEventBlocker blocker(this);
-                    return method(std::move(message));
-                }
-                return method(std::move(message));
+            [this](dbus::Message message, const dbus::ObjectMethod &) {
+                return batchEvents(
+                    std::move(message), [this](dbus::Message msg) {
+                        if (capabilityFlags().test(
+                                CapabilityFlag::KeyEventOrderFix)) {
+                            InputContextEventBlocker blocker(this);
+                            processKeyEventAsync(std::move(msg));
+                        } else {
+                            processKeyEventAsync(std::move(msg));
+                        }
+                        return true;
+                    });
             });
+        for (auto *batchedMethod :
+             {&focusInDBusMethod, &focusOutDBusMethod, &resetDBusMethod,
+              &prevPageMethod, &nextPageMethod, &selectCandidateMethod,
+              &invokeActionDBusMethod}) {
+            batchedMethod->setClosureFunction(
+                [this](dbus::Message message,
+                       const dbus::ObjectMethod &method) {
+                    return batchEvents(std::move(message), method);
+                });
+        }
 
         setClientControlVirtualkeyboardShow(
             getArgument(args, "clientControlVirtualkeyboardShow", "false") ==
@@ -157,6 +368,13 @@ public:
     void updateIM(const InputMethodEntry *entry) {
         currentIMTo(name_, entry->name(), entry->uniqueName(),
                     entry->languageCode());
+        updateSurroundingTextWindow(entry->surroundingTextWindow());
+    }
+
+    void updateSurroundingTextWindow(unsigned int window) {
+        if (rawCapabilityFlags_.test(CapabilityFlag::SurroundingTextWindow)) {
+            surroundingTextWindowDBusTo(name_, window);
+        }
     }
 
     void commitStringImpl(const std::string &text) override {
@@ -232,6 +450,37 @@ public:
             }
             layoutHint = static_cast<int>(candidateList->layoutHint());
         }
+        if (capabilityFlags().test(CapabilityFlag::CompactClientSideUI)) {
+            auto data = compactUI_.encode(
+                std::move(preeditStrings), preedit.cursor(),
+                std::move(auxUpStrings), std::move(auxDownStrings),
+                std::move(candidates), cursorIndex, layoutHint, hasPrev,
+                hasNext);
+            if (blocked_ &&
+                capabilityFlags().test(CapabilityFlag::BatchedEvents)) {
+                blockedEvents_.emplace_back(BATCHED_CLIENT_SIDE_UI_COMPACT,
+                                            dbus::Variant(std::move(data)));
+                return;
+            }
+            updateClientSideUICompactTo(name_, data);
+            return;
+        }
+        if (blocked_ && capabilityFlags().test(CapabilityFlag::BatchedEvents)) {
+            blockedEvents_.emplace_back(
+                BATCHED_CLIENT_SIDE_UI,
+                dbus::DBusStruct<
+                    std::vector<dbus::DBusStruct<std::string, int32_t>>,
+                    int32_t,
+                    std::vector<dbus::DBusStruct<std::string, int32_t>>,
+                    std::vector<dbus::DBusStruct<std::string, int32_t>>,
+                    std::vector<dbus::DBusStruct<std::string, std::string>>,
+                    int32_t, int32_t, bool, bool>(
+                    std::move(preeditStrings), preedit.cursor(),
+                    std::move(auxUpStrings), std::move(auxDownStrings),
+                    std::move(candidates), cursorIndex, layoutHint, hasPrev,
+                    hasNext));
+            return;
+        }
         updateClientSideUITo(name_, preeditStrings, preedit.cursor(),
                              auxUpStrings, auxDownStrings, candidates,
                              cursorIndex, layoutHint, hasPrev, hasNext);
@@ -299,20 +548,42 @@ public:
         } else if ((cap & (~static_cast<uint64_t>(0xffffffffffull))) != 0ull) {
             cap &= 0xffffffffull;
         }
+        const bool hadWindow =
+            rawCapabilityFlags_.test(CapabilityFlag::SurroundingTextWindow);
         rawCapabilityFlags_ = CapabilityFlags(cap);
+        if (!rawCapabilityFlags_.test(CapabilityFlag::CompactClientSideUI)) {
+            compactUI_.reset();
+        }
+        if (!hadWindow) {
+            updateSurroundingTextWindow(
+                surroundingTextWindow(im_->instance(), this));
+        }
         updateCapability();
     }
 
-    void setSurroundingText(const std::string &str, uint32_t cursor,
+    void setSurroundingText(std::string_view str, uint32_t cursor,
                             uint32_t anchor) {
         CHECK_SENDER_OR_RETURN;
-        surroundingText().setText(str, cursor, anchor);
+        // Only the clients that know about the window expect the text to be
+        // trimmed, since the later positions are relative to the trimmed text.
+        const auto window =
+            rawCapabilityFlags_.test(CapabilityFlag::SurroundingTextWindow)
+                ? surroundingTextWindow(im_->instance(), this)
+                : 0;
+        surroundingTextOffset_ =
+            surroundingText().setTextInWindow(str, cursor, anchor, window);
         updateSurroundingText();
     }
 
     void setSurroundingTextPosition(uint32_t cursor, uint32_t anchor) {
         CHECK_SENDER_OR_RETURN;
-        surroundingText().setCursor(cursor, anchor);
+        if (cursor < surroundingTextOffset_ ||
+            anchor < surroundingTextOffset_) {
+            surroundingText().invalidate();
+        } else {
+            surroundingText().setCursor(cursor - surroundingTextOffset_,
+                                        anchor - surroundingTextOffset_);
+        }
         updateSurroundingText();
     }
 
@@ -335,6 +606,45 @@ public:
         return keyEvent(event);
     }
 
+    // Same as processKeyEvent, but the reply is sent when the result is
+    // known, so the engine may defer it with deferKeyEvent.
+    void processKeyEventAsync(dbus::Message message) {
+        uint32_t keyval;
+        uint32_t keycode;
+        uint32_t state;
+        bool isRelease;
+        uint32_t time;
+        message >> keyval >> keycode >> state >> isRelease >> time;
+        auto reply = std::make_shared<KeyEventReply>(message.createReply());
+        if (message.sender() != name_) {
+            reply->send(false);
+            return;
+        }
+        KeyEvent event(
+            this, Key(static_cast<KeySym>(keyval), KeyStates(state), keycode),
+            isRelease, time);
+        // Force focus if there's keyevent.
+        if (!hasFocus()) {
+            focusIn();
+        }
+
+        keyEventAsync(event,
+                      [reply](bool accepted) { reply->send(accepted); });
+        if (reply->sent()) {
+            return;
+        }
+        std::weak_ptr<KeyEventReply> weakReply = reply;
+        reply->setTimeout(im_->instance()->eventLoop().addTimeEvent(
+            CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + deferredKeyEventTimeout, 0,
+            [weakReply](EventSourceTime *, uint64_t) {
+                if (auto reply = weakReply.lock()) {
+                    FCITX_WARN() << "Deferred key event timed out.";
+                    reply->send(false);
+                }
+                return true;
+            }));
+    }
+
     std::tuple<std::vector<DBusBlockedEvent>, bool>
     processKeyEventBatch(uint32_t keyval, uint32_t keycode, uint32_t state,
                          bool isRelease, uint32_t time);
@@ -432,6 +742,25 @@ public:
 
     void sendFocusOut() { notifyFocusOutTo(name_); }
 
+    // Collect the events produced by the call, and send them in one signal if
+    // client supports it.
+    template <typename Callback>
+    bool batchEvents(dbus::Message message, const Callback &callback) {
+        if (blocked_ ||
+            !capabilityFlags().test(CapabilityFlag::BatchedEvents)) {
+            return callback(std::move(message));
+        }
+        setBlocked();
+        auto result = callback(std::move(message));
+        std::vector<DBusBlockedEvent> events;
+        setUnblocked(events);
+        if (!events.empty()) {
+            batchedEventsDBusTo(name_, events);
+            bus()->flush();
+        }
+        return result;
+    }
+
 private:
     FCITX_OBJECT_VTABLE_METHOD(focusInDBus, "FocusIn", "", "");
     FCITX_OBJECT_VTABLE_METHOD(focusOutDBus, "FocusOut", "", "");
@@ -442,8 +771,9 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(setCapability, "SetCapability", "t", "");
     FCITX_OBJECT_VTABLE_METHOD(setSupportedCapability, "SetSupportedCapability",
                                "t", "");
-    FCITX_OBJECT_VTABLE_METHOD(setSurroundingText, "SetSurroundingText", "suu",
-                               "");
+    FCITX_OBJECT_VTABLE_METHOD_BORROWED(setSurroundingText,
+                                        "SetSurroundingText", "suu",
+                                        "");
     FCITX_OBJECT_VTABLE_METHOD(setSurroundingTextPosition,
                                "SetSurroundingTextPosition", "uu", "");
     FCITX_OBJECT_VTABLE_METHOD(destroyDBus, "DestroyIC", "", "");
@@ -480,8 +810,20 @@ private:
     // - bb prev page / next page
     FCITX_OBJECT_VTABLE_SIGNAL(updateClientSideUI, "UpdateClientSideUI",
                                "a(si)ia(si)a(si)a(ss)iibb");
+    // Same content as UpdateClientSideUI, packed as CompactClientSideUI,
+    // sent with CapabilityFlag::CompactClientSideUI.
+    FCITX_OBJECT_VTABLE_SIGNAL(updateClientSideUICompact,
+                               "UpdateClientSideUICompact", "ay");
     FCITX_OBJECT_VTABLE_SIGNAL(forwardKeyDBus, "ForwardKey", "uub");
+    // Number of characters around the cursor that the current input method
+    // needs from surrounding text, 0 for the whole text. Sent with
+    // CapabilityFlag::SurroundingTextWindow.
+    FCITX_OBJECT_VTABLE_SIGNAL(surroundingTextWindowDBus,
+                               "SurroundingTextWindow", "u");
     FCITX_OBJECT_VTABLE_SIGNAL(notifyFocusOut, "NotifyFocusOut", "");
+    // Same as the events returned by ProcessKeyEventBatch, sent with
+    // CapabilityFlag::BatchedEvents.
+    FCITX_OBJECT_VTABLE_SIGNAL(batchedEventsDBus, "BatchedEvents", "a(uv)");
 
     FCITX_OBJECT_VTABLE_SIGNAL(virtualKeyboardVisibilityChanged,
                                "VirtualKeyboardVisibilityChanged", "b");
@@ -494,6 +836,9 @@ private:
     std::optional<uint64_t> supportedCapability_;
     bool blocked_ = false;
     std::vector<DBusBlockedEvent> blockedEvents_;
+    CompactClientSideUI compactUI_;
+    // Offset of the trimmed surrounding text in the text sent by client.
+    unsigned int surroundingTextOffset_ = 0;
     std::unique_ptr<HandlerTableEntry<EventHandler>> vkVisibilityChanged_;
 };
 
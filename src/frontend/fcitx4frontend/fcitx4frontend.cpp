@@ -6,6 +6,9 @@
  */
 
 #include "fcitx4frontend.h"
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
 #include "fcitx-utils/dbus/message.h"
 #include "fcitx-utils/dbus/objectvtable.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
@@ -63,6 +66,8 @@ int getDisplayNumber(const std::string &var) {
 }
 } // namespace
 
+class Fcitx4InputContext;
+
 class Fcitx4InputMethod : public dbus::ObjectVTable<Fcitx4InputMethod> {
 public:
     Fcitx4InputMethod(int display, Fcitx4FrontendModule *module, dbus::Bus *bus)
@@ -101,14 +106,11 @@ public:
         }
     }
 
-    ~Fcitx4InputMethod() override {
-        if (!pathWrote_.empty()) {
-            unlink(pathWrote_.data());
-        }
-    }
+    ~Fcitx4InputMethod() override;
 
     std::tuple<int, bool, uint32_t, uint32_t, uint32_t, uint32_t>
     createICv3(const std::string &appname, int pid);
+    void unregisterInputContext(int id) { inputContexts_.erase(id); }
     dbus::Bus *bus() { return bus_.get(); }
     auto *instance() { return module_->instance(); }
     auto *parent() { return module_; }
@@ -117,11 +119,17 @@ private:
     // V1 and V2 are too old, so we just ignore them.
     FCITX_OBJECT_VTABLE_METHOD(createICv3, "CreateICv3", "si", "ibuuuu");
 
+    Fcitx4InputContext *findInputContext(const std::string &path) const;
+
     int display_;
     Fcitx4FrontendModule *module_;
     Instance *instance_;
     std::unique_ptr<dbus::Bus> bus_;
     std::string pathWrote_;
+    // Input contexts share one fallback vtable, instead of registering their
+    // own objects on the bus.
+    std::unordered_map<int, Fcitx4InputContext *> inputContexts_;
+    std::unique_ptr<dbus::Slot> inputContextSlot_;
 };
 
 class Fcitx4InputContext : public InputContext,
@@ -140,11 +148,14 @@ public:
                       delete this;
                   }
               })),
-          name_(sender) {
+          name_(sender), id_(id) {
         created();
     }
 
-    ~Fcitx4InputContext() override { InputContext::destroy(); }
+    ~Fcitx4InputContext() override {
+        im_->unregisterInputContext(id_);
+        InputContext::destroy();
+    }
 
     const char *frontend() const override { return "fcitx4"; }
 
@@ -282,8 +293,36 @@ private:
     Fcitx4InputMethod *im_;
     std::unique_ptr<HandlerTableEntry<dbus::ServiceWatcherCallback>> handler_;
     std::string name_;
+    int id_;
 };
 
+Fcitx4InputMethod::~Fcitx4InputMethod() {
+    // Input contexts can not outlive the bus they are dispatched from.
+    while (!inputContexts_.empty()) {
+        delete inputContexts_.begin()->second;
+    }
+    if (!pathWrote_.empty()) {
+        unlink(pathWrote_.data());
+    }
+}
+
+Fcitx4InputContext *
+Fcitx4InputMethod::findInputContext(const std::string &path) const {
+    constexpr std::string_view prefix = "/inputcontext_";
+    if (!stringutils::startsWith(path, prefix)) {
+        return nullptr;
+    }
+    const char *begin = path.data() + prefix.size();
+    const char *end = path.data() + path.size();
+    int id;
+    auto [ptr, ec] = std::from_chars(begin, end, id);
+    if (ec != std::errc() || ptr != end) {
+        return nullptr;
+    }
+    auto iter = inputContexts_.find(id);
+    return iter != inputContexts_.end() ? iter->second : nullptr;
+}
+
 std::tuple<int, bool, uint32_t, uint32_t, uint32_t, uint32_t>
 Fcitx4InputMethod::createICv3(const std::string &appname, int /*pid*/) {
     auto sender = currentMessage()->sender();
@@ -296,8 +335,16 @@ Fcitx4InputMethod::createICv3(const std::string &appname, int /*pid*/) {
         group = instance_->defaultFocusGroup("x11:");
     }
     ic->setFocusGroup(group);
-    bus_->addObjectVTable(ic->path().path(), FCITX_INPUTCONTEXT_DBUS_INTERFACE,
-                          *ic);
+    bus_->bindObjectVTable(ic->path().path(), FCITX_INPUTCONTEXT_DBUS_INTERFACE,
+                           *ic);
+    inputContexts_[icid] = ic;
+    if (!inputContextSlot_) {
+        inputContextSlot_ = bus_->addObjectVTableFallback(
+            "/", FCITX_INPUTCONTEXT_DBUS_INTERFACE, *ic,
+            [this](const std::string &path) -> dbus::ObjectVTableBase * {
+                return findInputContext(path);
+            });
+    }
 
     return std::make_tuple(icid, true, 0, 0, 0, 0);
 }
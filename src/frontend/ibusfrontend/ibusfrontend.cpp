@@ -11,16 +11,20 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <cerrno>
+#include <charconv>
 #include <csignal>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <fmt/core.h>
@@ -184,6 +188,8 @@ using IBusText = FCITX_STRING_TO_DBUS_TYPE("(sa{sv}sv)");
 using IBusAttrList = FCITX_STRING_TO_DBUS_TYPE("(sa{sv}av)");
 using IBusAttribute = FCITX_STRING_TO_DBUS_TYPE("(sa{sv}uuuu)");
 
+class IBusInputContext;
+
 class IBusFrontend : public dbus::ObjectVTable<IBusFrontend> {
 public:
     IBusFrontend(IBusFrontendModule *module, dbus::Bus *bus,
@@ -195,8 +201,13 @@ public:
         }
     }
 
+    ~IBusFrontend();
+
     dbus::ObjectPath createInputContext(const std::string &args);
 
+    void registerInputContext(int id, IBusInputContext *ic);
+    void unregisterInputContext(int id) { inputContexts_.erase(id); }
+
     dbus::ServiceWatcher &serviceWatcher() { return *watcher_; }
     dbus::Bus *bus() { return bus_; }
     Instance *instance() { return module_->instance(); }
@@ -205,15 +216,63 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(createInputContext, "CreateInputContext", "s",
                                "o");
 
+    IBusInputContext *findInputContext(const std::string &path) const;
+
     IBusFrontendModule *module_;
     Instance *instance_;
     int icIdx = 0;
     dbus::Bus *bus_;
     std::unique_ptr<dbus::ServiceWatcher> watcher_;
+    // Input contexts share one fallback vtable per interface, instead of
+    // registering their own objects on the bus.
+    std::unordered_map<int, IBusInputContext *> inputContexts_;
+    std::unique_ptr<dbus::Slot> inputContextSlot_;
+    std::unique_ptr<dbus::Slot> serviceSlot_;
 };
 
 constexpr uint32_t releaseMask = (1 << 30);
 
+// Time to wait for a deferred key event before passing the key through, in
+// microseconds.
+constexpr uint64_t deferredKeyEventTimeout = 2000000;
+
+// Reply of a ProcessKeyEvent call, sent at most once. The first result wins,
+// so a deferred result that arrives after the timeout is ignored. If no result
+// is set, the key is passed through.
+class KeyEventReply {
+public:
+    explicit KeyEventReply(dbus::Message reply) : reply_(std::move(reply)) {}
+
+    ~KeyEventReply() { send(); }
+
+    void setResult(bool accepted) {
+        if (!result_) {
+            result_ = accepted;
+        }
+    }
+
+    bool hasResult() const { return result_.has_value(); }
+
+    void send() {
+        if (sent_) {
+            return;
+        }
+        sent_ = true;
+        reply_ << result_.value_or(false);
+        reply_.send();
+    }
+
+    void setTimeout(std::unique_ptr<EventSourceTime> timeout) {
+        timeout_ = std::move(timeout);
+    }
+
+private:
+    dbus::Message reply_;
+    std::optional<bool> result_;
+    bool sent_ = false;
+    std::unique_ptr<EventSourceTime> timeout_;
+};
+
 IBusAttribute makeIBusAttr(uint32_t type, uint32_t value, uint32_t start,
                            uint32_t end) {
     IBusAttribute attr;
@@ -239,7 +298,6 @@ IBusText makeSimpleIBusText(const std::string &str) {
     return text;
 }
 
-class IBusInputContext;
 class IBusService : public dbus::ObjectVTable<IBusService> {
 public:
     IBusService(IBusInputContext *ic) : ic_(ic) {}
@@ -266,15 +324,24 @@ public:
                                delete this;
                            }
                        })),
-          name_(sender) {
-        im->bus()->addObjectVTable(path().path(),
-                                   IBUS_INPUTCONTEXT_DBUS_INTERFACE, *this);
-        im->bus()->addObjectVTable(path().path(), IBUS_SERVICE_DBUS_INTERFACE,
-                                   service_);
+          name_(sender), id_(id) {
+        processKeyEventMethod.setClosureFunction(
+            [this](dbus::Message message, const dbus::ObjectMethod &) {
+                processKeyEventAsync(std::move(message));
+                return true;
+            });
+        im->bus()->bindObjectVTable(path().path(),
+                                    IBUS_INPUTCONTEXT_DBUS_INTERFACE, *this);
+        im->bus()->bindObjectVTable(path().path(), IBUS_SERVICE_DBUS_INTERFACE,
+                                    service_);
+        im->registerInputContext(id, this);
         created();
     }
 
-    ~IBusInputContext() override { InputContext::destroy(); }
+    ~IBusInputContext() override {
+        im_->unregisterInputContext(id_);
+        InputContext::destroy();
+    }
 
     const char *frontend() const override { return "ibus"; }
 
@@ -412,7 +479,9 @@ public:
     void setSurroundingText(const std::string &str, uint32_t cursor,
                             uint32_t anchor) {
         CHECK_SENDER_OR_RETURN;
-        surroundingText().setText(str, cursor, anchor);
+        surroundingText().setTextInWindow(
+            str, cursor, anchor,
+            surroundingTextWindow(im_->instance(), this));
         updateSurroundingText();
     }
 
@@ -430,6 +499,65 @@ public:
         return keyEvent(event);
     }
 
+    // Same as processKeyEvent, but the reply is sent when the result is
+    // known, so the engine may defer it with deferKeyEvent.
+    void processKeyEventAsync(dbus::Message message) {
+        uint32_t keyval;
+        uint32_t keycode;
+        uint32_t state;
+        message >> keyval >> keycode >> state;
+        auto reply = std::make_shared<KeyEventReply>(message.createReply());
+        // Replies are sent in the order of the calls, a deferred key event
+        // holds back the replies of the keys after it.
+        pendingReplies_.push_back(reply);
+        if (message.sender() != name_) {
+            reply->setResult(false);
+            flushReplies();
+            return;
+        }
+        KeyEvent event(this,
+                       Key(static_cast<KeySym>(keyval),
+                           KeyStates(state & (~releaseMask)), keycode + 8),
+                       state & releaseMask, 0);
+        // Force focus if there's keyevent.
+        if (!hasFocus()) {
+            focusIn();
+        }
+
+        std::weak_ptr<KeyEventReply> weakReply = reply;
+        auto ref = InputContext::watch();
+        keyEventAsync(event, [this, ref, weakReply](bool accepted) {
+            auto reply = weakReply.lock();
+            if (!reply || !ref.isValid()) {
+                return;
+            }
+            reply->setResult(accepted);
+            flushReplies();
+        });
+        if (reply->hasResult()) {
+            return;
+        }
+        reply->setTimeout(im_->instance()->eventLoop().addTimeEvent(
+            CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + deferredKeyEventTimeout, 0,
+            [this, weakReply](EventSourceTime *, uint64_t) {
+                if (auto reply = weakReply.lock()) {
+                    FCITX_IBUS_WARN() << "Deferred key event timed out.";
+                    reply->setResult(false);
+                    flushReplies();
+                }
+                return true;
+            }));
+    }
+
+    void flushReplies() {
+        while (!pendingReplies_.empty() &&
+               pendingReplies_.front()->hasResult()) {
+            auto reply = std::move(pendingReplies_.front());
+            pendingReplies_.pop_front();
+            reply->send();
+        }
+    }
+
     void enable() {}
     void disable() {}
     static bool isEnabled() { return true; }
@@ -445,7 +573,9 @@ public:
             return;
         }
         const auto &s = text.dataAs<IBusText>();
-        surroundingText().setText(std::get<2>(s), cursor, anchor);
+        surroundingText().setTextInWindow(
+            std::get<2>(s), cursor, anchor,
+            surroundingTextWindow(im_->instance(), this));
         updateSurroundingText();
     }
     IBusService &service() { return service_; }
@@ -632,8 +762,11 @@ private:
     IBusFrontend *im_;
     std::unique_ptr<HandlerTableEntry<dbus::ServiceWatcherCallback>> handler_;
     std::string name_;
+    int id_;
     bool clientCommitPreedit_ = false;
     bool effectivePostProcessKeyEvent_ = false;
+    // Replies of ProcessKeyEvent calls not sent yet, in the order of calls.
+    std::deque<std::shared_ptr<KeyEventReply>> pendingReplies_;
 
     IBusService service_{this};
 };
@@ -645,6 +778,50 @@ void IBusService::destroyDBus() {
     delete ic_;
 }
 
+IBusFrontend::~IBusFrontend() {
+    // Input contexts can not outlive the vtables they are dispatched from.
+    while (!inputContexts_.empty()) {
+        delete inputContexts_.begin()->second;
+    }
+}
+
+void IBusFrontend::registerInputContext(int id, IBusInputContext *ic) {
+    inputContexts_[id] = ic;
+    if (inputContextSlot_) {
+        return;
+    }
+    inputContextSlot_ = bus_->addObjectVTableFallback(
+        "/org/freedesktop/IBus", IBUS_INPUTCONTEXT_DBUS_INTERFACE, *ic,
+        [this](const std::string &path) -> dbus::ObjectVTableBase * {
+            return findInputContext(path);
+        });
+    serviceSlot_ = bus_->addObjectVTableFallback(
+        "/org/freedesktop/IBus", IBUS_SERVICE_DBUS_INTERFACE, ic->service(),
+        [this](const std::string &path) -> dbus::ObjectVTableBase * {
+            if (auto *ic = findInputContext(path)) {
+                return &ic->service();
+            }
+            return nullptr;
+        });
+}
+
+IBusInputContext *
+IBusFrontend::findInputContext(const std::string &path) const {
+    constexpr std::string_view prefix = "/org/freedesktop/IBus/InputContext_";
+    if (!stringutils::startsWith(path, prefix)) {
+        return nullptr;
+    }
+    const char *begin = path.data() + prefix.size();
+    const char *end = path.data() + path.size();
+    int id;
+    auto [ptr, ec] = std::from_chars(begin, end, id);
+    if (ec != std::errc() || ptr != end) {
+        return nullptr;
+    }
+    auto iter = inputContexts_.find(id);
+    return iter != inputContexts_.end() ? iter->second : nullptr;
+}
+
 dbus::ObjectPath
 IBusFrontend::createInputContext(const std::string & /* unused */) {
     auto sender = currentMessage()->sender();
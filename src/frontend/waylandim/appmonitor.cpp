@@ -6,9 +6,65 @@
  */
 #include "appmonitor.h"
 #include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace fcitx {
 
+void AppMonitor::updateApp(const std::string &key, const std::string &appId,
+                           bool active) {
+    if (appId.empty()) {
+        removeApp(key);
+        return;
+    }
+    setApp(key, appId);
+    if (active) {
+        activeApps_.insert(key);
+        if (focus_ != key) {
+            setFocus(key);
+        }
+    } else if (activeApps_.erase(key) && focus_ == key) {
+        setFocus(activeApps_.empty()
+                     ? std::nullopt
+                     : std::make_optional(*activeApps_.begin()));
+    }
+}
+
+void AppMonitor::setApp(const std::string &key, const std::string &appId) {
+    auto [iter, inserted] = appState_.try_emplace(key, appId);
+    if (!inserted) {
+        if (iter->second == appId) {
+            return;
+        }
+        iter->second = appId;
+    }
+    appChanged(key, appId);
+}
+
+void AppMonitor::removeApp(const std::string &key) {
+    auto iter = appState_.find(key);
+    if (iter == appState_.end()) {
+        return;
+    }
+    activeApps_.erase(key);
+    if (focus_ == key) {
+        setFocus(activeApps_.empty()
+                     ? std::nullopt
+                     : std::make_optional(*activeApps_.begin()));
+    }
+    appState_.erase(iter);
+    appRemoved(key);
+}
+
+void AppMonitor::setFocus(const std::optional<std::string> &focus) {
+    if (focus_ == focus) {
+        return;
+    }
+    focus_ = focus;
+    focusChanged(focus_);
+}
+
 AggregatedAppMonitor::AggregatedAppMonitor() = default;
 
 bool AggregatedAppMonitor::isAvailable() const {
@@ -27,14 +83,50 @@ AppMonitor *AggregatedAppMonitor::activeMonitor() const {
 void AggregatedAppMonitor::addSubMonitor(std::unique_ptr<AppMonitor> monitor) {
     subMonitors_.emplace_back(std::move(monitor));
 
-    subMonitors_.back()->appUpdated.connect(
-        [this, monitor = subMonitors_.back().get()](
-            const std::unordered_map<std::string, std::string> &appState,
-            const std::optional<std::string> &focus) {
-            if (activeMonitor() == monitor) {
-                appUpdated(appState, focus);
+    auto *subMonitor = subMonitors_.back().get();
+    subMonitor->appChanged.connect(
+        [this, subMonitor](const std::string &key, const std::string &appId) {
+            if (sync(subMonitor)) {
+                setApp(key, appId);
+            }
+        });
+    subMonitor->appRemoved.connect(
+        [this, subMonitor](const std::string &key) {
+            if (sync(subMonitor)) {
+                removeApp(key);
             }
         });
+    subMonitor->focusChanged.connect(
+        [this, subMonitor](const std::optional<std::string> &focus) {
+            if (sync(subMonitor)) {
+                setFocus(focus);
+            }
+        });
+}
+
+bool AggregatedAppMonitor::sync(AppMonitor *monitor) {
+    if (activeMonitor() != monitor) {
+        return false;
+    }
+    if (syncedMonitor_ == monitor) {
+        return true;
+    }
+    // The active monitor is changed, replace the whole state with the one of
+    // the new monitor, which already includes current change.
+    syncedMonitor_ = monitor;
+    setFocus(std::nullopt);
+    std::vector<std::string> keys;
+    for (const auto &[key, _] : appState()) {
+        keys.push_back(key);
+    }
+    for (const auto &key : keys) {
+        removeApp(key);
+    }
+    for (const auto &[key, appId] : monitor->appState()) {
+        setApp(key, appId);
+    }
+    setFocus(monitor->focus());
+    return false;
 }
 
 } // namespace fcitx
\ No newline at end of file
@@ -7,20 +7,50 @@
 #ifndef _FCITX5_FRONTEND_WAYLANDIM_APPMONITOR_H_
 #define _FCITX5_FRONTEND_WAYLANDIM_APPMONITOR_H_
 
+#include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "fcitx-utils/signals.h"
 
 namespace fcitx {
 
+// Monitor the apps of windows, each app is identified by a key of its window.
+// Changes are emitted as deltas, so the cost of an update does not depend on
+// the number of windows.
 class AppMonitor {
 public:
     virtual ~AppMonitor() = default;
-    Signal<void(const std::unordered_map<std::string, std::string> &appState,
-                const std::optional<std::string> &focus)>
-        appUpdated;
+    // App is added, or its app id is changed.
+    Signal<void(const std::string &key, const std::string &appId)> appChanged;
+    // Emitted after the focus is moved away from the app.
+    Signal<void(const std::string &key)> appRemoved;
+    Signal<void(const std::optional<std::string> &focus)> focusChanged;
 
     virtual bool isAvailable() const = 0;
+
+    // Key to app id of all the apps.
+    const std::unordered_map<std::string, std::string> &appState() const {
+        return appState_;
+    }
+    // Key of the focused app, always an app in appState().
+    const std::optional<std::string> &focus() const { return focus_; }
+
+protected:
+    // Update the app of a window, an empty app id removes it.
+    void updateApp(const std::string &key, const std::string &appId,
+                   bool active);
+    void setApp(const std::string &key, const std::string &appId);
+    void removeApp(const std::string &key);
+    void setFocus(const std::optional<std::string> &focus);
+
+private:
+    std::unordered_map<std::string, std::string> appState_;
+    // Apps that are active, used to find the next focus.
+    std::unordered_set<std::string> activeApps_;
+    std::optional<std::string> focus_;
 };
 
 class AggregatedAppMonitor : public AppMonitor {
@@ -32,7 +62,12 @@ public:
     AppMonitor *activeMonitor() const;
 
 private:
+    // Return whether the change from monitor need to be forwarded, replace
+    // the state with the one of monitor if it becomes active.
+    bool sync(AppMonitor *monitor);
+
     std::vector<std::unique_ptr<AppMonitor>> subMonitors_;
+    AppMonitor *syncedMonitor_ = nullptr;
 };
 
 } // namespace fcitx
@@ -19,12 +19,12 @@ public:
             window->stateChanged().connect([this](uint32_t state) {
                 active_ =
                     (state & ORG_KDE_PLASMA_WINDOW_MANAGEMENT_STATE_ACTIVE);
-                parent_->refresh();
+                parent_->refresh(this);
             }));
         conns_.emplace_back(
             window->appIdChanged().connect([this](const char *appId) {
                 appId_ = appId;
-                parent_->refresh();
+                parent_->refresh(this);
             }));
     }
 
@@ -75,23 +75,16 @@ void PlasmaAppMonitor::setup(
 }
 
 void PlasmaAppMonitor::remove(wayland::OrgKdePlasmaWindow *window) {
-    windows_.erase(window);
-    refresh();
+    auto iter = windows_.find(window);
+    if (iter == windows_.end()) {
+        return;
+    }
+    removeApp(iter->second->key());
+    windows_.erase(iter);
 }
 
-void PlasmaAppMonitor::refresh() {
-    std::unordered_map<std::string, std::string> state;
-    std::optional<std::string> focus;
-    for (const auto &[_, plasmaWindow] : windows_) {
-        if (!plasmaWindow->appId().empty()) {
-            auto iter =
-                state.emplace(plasmaWindow->key(), plasmaWindow->appId());
-            if (plasmaWindow->active() && !focus && iter.second) {
-                focus = iter.first->first;
-            }
-        }
-    }
-    appUpdated(state, focus);
+void PlasmaAppMonitor::refresh(PlasmaWindow *window) {
+    updateApp(window->key(), window->appId(), window->active());
 }
 
 } // namespace fcitx
\ No newline at end of file
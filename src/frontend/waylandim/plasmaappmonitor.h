@@ -25,7 +25,7 @@ public:
 
     void setup(wayland::OrgKdePlasmaWindowManagement *management);
     void remove(wayland::OrgKdePlasmaWindow *window);
-    void refresh();
+    void refresh(PlasmaWindow *window);
     bool isAvailable() const override;
 
 private:
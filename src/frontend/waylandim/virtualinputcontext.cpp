@@ -5,12 +5,28 @@
  *
  */
 #include "virtualinputcontext.h"
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <memory>
 #include <string>
+#include <utility>
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx/inputcontext.h"
+#include "fcitx/inputcontextmanager.h"
+#include "fcitx/instance.h"
 
 namespace fcitx {
 
+namespace {
+
+// Short lived windows, e.g. dialogs, tend to come and go in bursts.
+constexpr size_t maxIdleInputContexts = 8;
+constexpr uint64_t idleInputContextTimeout = 30000000;
+
+} // namespace
+
 InputContext *VirtualInputContextGlue::delegatedInputContext() {
     if (virtualICManager_) {
         if (auto *virtualIC = virtualICManager_->focusedVirtualIC()) {
@@ -55,11 +71,10 @@ VirtualInputContextManager::VirtualInputContextManager(
     InputContextManager *manager, VirtualInputContextGlue *parent,
     AppMonitor *app)
     : manager_(manager), parentIC_(parent), app_(app) {
-    conn_ = app_->appUpdated.connect(
-        [this](const std::unordered_map<std::string, std::string> &appState,
-               const std::optional<std::string> &focus) {
-            appUpdated(appState, focus);
-        });
+    appRemovedConn_ = app_->appRemoved.connect(
+        [this](const std::string &key) { releaseInputContext(key); });
+    focusChangedConn_ = app_->focusChanged.connect(
+        [this](const std::optional<std::string> &) { updateFocus(); });
     parent->setVirtualInputContextManager(this);
 }
 
@@ -74,14 +89,11 @@ void VirtualInputContextManager::setRealFocus(bool focus) {
 
 void VirtualInputContextManager::updateFocus() {
     InputContext *ic = nullptr;
-    if (focus_) {
-        if (auto *value = findValue(managed_, *focus_)) {
+    if (const auto &focus = app_->focus()) {
+        if (auto *value = findValue(managed_, *focus)) {
             ic = value->get();
         } else {
-            auto result = managed_.emplace(
-                *focus_,
-                std::make_unique<VirtualInputContext>(
-                    *manager_, *findValue(lastAppState_, *focus_), parentIC_));
+            auto result = managed_.emplace(*focus, acquireInputContext(*focus));
             assert(result.second);
             ic = result.first->second.get();
         }
@@ -105,29 +117,70 @@ void VirtualInputContextManager::updateFocus() {
     }
 }
 
-InputContext *VirtualInputContextManager::focusedVirtualIC() {
-    if (!focus_) {
-        return nullptr;
+void VirtualInputContextManager::releaseInputContext(const std::string &key) {
+    auto iter = managed_.find(key);
+    if (iter == managed_.end()) {
+        return;
+    }
+    auto ic = std::move(iter->second);
+    managed_.erase(iter);
+    ic->focusOut();
+    if (idle_.size() >= maxIdleInputContexts) {
+        idle_.pop_front();
+    }
+    std::string program = ic->program();
+    idle_.push_back({std::move(program), now(CLOCK_MONOTONIC), std::move(ic)});
+    const auto evictTime = idle_.front().time + idleInputContextTimeout;
+    if (!evictEvent_) {
+        evictEvent_ = manager_->instance()->eventLoop().addTimeEvent(
+            CLOCK_MONOTONIC, evictTime, 0,
+            [this](EventSourceTime *, uint64_t) {
+                evictIdleInputContexts();
+                return true;
+            });
+    } else if (!evictEvent_->isEnabled()) {
+        evictEvent_->setTime(evictTime);
+        evictEvent_->setOneShot();
     }
-    auto *inputContext = findValue(managed_, *focus_);
-    return inputContext ? inputContext->get() : nullptr;
 }
 
-void VirtualInputContextManager::appUpdated(
-    const std::unordered_map<std::string, std::string> &appState,
-    std::optional<std::string> focus) {
-    assert(!focus || appState.count(*focus));
-    lastAppState_ = appState;
-    for (auto iter = managed_.begin(); iter != managed_.end();) {
-        if (!findValue(lastAppState_, iter->first)) {
-            iter = managed_.erase(iter);
-        } else {
-            ++iter;
-        }
+std::unique_ptr<InputContext>
+VirtualInputContextManager::acquireInputContext(const std::string &key) {
+    const auto &program = *findValue(app_->appState(), key);
+    // Prefer the most recently closed one.
+    auto iter = std::find_if(
+        idle_.rbegin(), idle_.rend(),
+        [&program](const IdleInputContext &idle) {
+            return idle.program == program;
+        });
+    if (iter == idle_.rend()) {
+        return std::make_unique<VirtualInputContext>(*manager_, program,
+                                                     parentIC_);
     }
+    auto ic = std::move(iter->ic);
+    idle_.erase(std::next(iter).base());
+    return ic;
+}
 
-    focus_ = std::move(focus);
-    updateFocus();
+void VirtualInputContextManager::evictIdleInputContexts() {
+    const auto current = now(CLOCK_MONOTONIC);
+    while (!idle_.empty() &&
+           idle_.front().time + idleInputContextTimeout <= current) {
+        idle_.pop_front();
+    }
+    if (!idle_.empty()) {
+        evictEvent_->setTime(idle_.front().time + idleInputContextTimeout);
+        evictEvent_->setOneShot();
+    }
+}
+
+InputContext *VirtualInputContextManager::focusedVirtualIC() {
+    const auto &focus = app_->focus();
+    if (!focus) {
+        return nullptr;
+    }
+    auto *inputContext = findValue(managed_, *focus);
+    return inputContext ? inputContext->get() : nullptr;
 }
 
 } // namespace fcitx
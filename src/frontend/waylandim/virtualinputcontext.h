@@ -7,9 +7,15 @@
 #ifndef _FCITX5_FRONTEND_WAYLANDIM_VIRTUALINPUTCONTEXT_H_
 #define _FCITX5_FRONTEND_WAYLANDIM_VIRTUALINPUTCONTEXT_H_
 
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <fcitx/inputcontext.h>
 #include "fcitx-utils/capabilityflags.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/signals.h"
 #include "appmonitor.h"
 
@@ -114,19 +120,27 @@ public:
     InputContext *focusedVirtualIC();
 
 private:
-    void
-    appUpdated(const std::unordered_map<std::string, std::string> &appState,
-               std::optional<std::string> focus);
+    // Input context of a closed app, kept for a while so a new window of the
+    // same program can reuse it instead of creating a new one.
+    struct IdleInputContext {
+        std::string program;
+        uint64_t time;
+        std::unique_ptr<InputContext> ic;
+    };
 
     void updateFocus();
+    void releaseInputContext(const std::string &key);
+    std::unique_ptr<InputContext> acquireInputContext(const std::string &key);
+    void evictIdleInputContexts();
 
-    ScopedConnection conn_;
+    ScopedConnection appRemovedConn_;
+    ScopedConnection focusChangedConn_;
     InputContextManager *manager_;
     VirtualInputContextGlue *parentIC_;
     AppMonitor *app_;
-    std::unordered_map<std::string, std::string> lastAppState_;
     std::unordered_map<std::string, std::unique_ptr<InputContext>> managed_;
-    std::optional<std::string> focus_;
+    std::deque<IdleInputContext> idle_;
+    std::unique_ptr<EventSourceTime> evictEvent_;
 };
 
 } // namespace fcitx
@@ -5,11 +5,13 @@
  *
  */
 #include "waylandimserver.h"
-#include <sys/mman.h>
 #include <algorithm>
 #include <memory>
+#include <string_view>
 #include "fcitx-utils/macros.h"
+#include "fcitx-utils/unixfd.h"
 #include "fcitx-utils/utf8.h"
+#include "fcitx/misc_p.h"
 #include "virtualinputcontext.h"
 #include "wayland-text-input-unstable-v1-client-protocol.h"
 #include "wayland_public.h"
@@ -49,6 +51,18 @@ inline unsigned int waylandFormat(TextFormatFlags flags) {
     return ZWP_TEXT_INPUT_V1_PREEDIT_STYLE_NONE;
 }
 
+const WaylandIMServerBase::ModifierNames &modifierNames() {
+    static const WaylandIMServerBase::ModifierNames names = {
+        {"Shift", KeyState::Shift},  {"Lock", KeyState::CapsLock},
+        {"Control", KeyState::Ctrl}, {"Mod1", KeyState::Alt},
+        {"Mod2", KeyState::NumLock}, {"Super", KeyState::Super},
+        {"Mod4", KeyState::Super},   {"Hyper", KeyState::Hyper},
+        {"Mod3", KeyState::Hyper},   {"Mod5", KeyState::Mod5},
+        {"Meta", KeyState::Meta},
+    };
+    return names;
+}
+
 } // namespace
 
 WaylandIMServer::WaylandIMServer(wl_display *display, FocusGroup *group,
@@ -221,7 +235,8 @@ void WaylandIMInputContextV1::repeat() {
         false, repeatTime_);
 
     sendKeyToVK(repeatTime_, event.rawKey(), WL_KEYBOARD_KEY_STATE_RELEASED);
-    if (!ic->keyEvent(event)) {
+    // Skip the dispatch if the input method does not care about the repeat.
+    if (ic->isKeyRepeatPassThrough() || !ic->keyEvent(event)) {
         sendKeyToVK(repeatTime_, event.rawKey(), WL_KEYBOARD_KEY_STATE_PRESSED);
     }
 
@@ -253,7 +268,10 @@ void WaylandIMInputContextV1::surroundingTextCallback(const char *text,
         if (anchorByChar == utf8::INVALID_LENGTH) {
             break;
         }
-        surroundingText().setText(text, cursorByChar, anchorByChar);
+        surroundingText().setTextInWindow(
+            str, cursorByChar, anchorByChar,
+            surroundingTextWindow(server_->instance(),
+                                  delegatedInputContext()));
     } while (false);
     updateSurroundingTextWrapper();
 }
@@ -373,68 +391,8 @@ void WaylandIMInputContextV1::preferredLanguageCallback(const char *language) {
 
 void WaylandIMInputContextV1::keymapCallback(uint32_t format, int32_t fd,
                                              uint32_t size) {
-    FCITX_UNUSED(size);
-    if (!server_->context_) {
-        server_->context_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
-        xkb_context_set_log_level(server_->context_.get(),
-                                  XKB_LOG_LEVEL_CRITICAL);
-    }
-
-    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
-        close(fd);
-        return;
-    }
-
-    if (server_->keymap_) {
-        server_->keymap_.reset();
-    }
-
-    auto *mapStr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (mapStr == MAP_FAILED) {
-        close(fd);
-        return;
-    }
-
-    server_->keymap_.reset(xkb_keymap_new_from_string(
-        server_->context_.get(), static_cast<const char *>(mapStr),
-        XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS));
-
-    munmap(mapStr, size);
-    close(fd);
-
-    if (!server_->keymap_) {
-        return;
-    }
-
-    server_->state_.reset(xkb_state_new(server_->keymap_.get()));
-    if (!server_->state_) {
-        server_->keymap_.reset();
-        return;
-    }
-
-    server_->stateMask_.shift_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Shift");
-    server_->stateMask_.lock_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Lock");
-    server_->stateMask_.control_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Control");
-    server_->stateMask_.mod1_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod1");
-    server_->stateMask_.mod2_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod2");
-    server_->stateMask_.mod3_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod3");
-    server_->stateMask_.mod4_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod4");
-    server_->stateMask_.mod5_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod5");
-    server_->stateMask_.super_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Super");
-    server_->stateMask_.hyper_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Hyper");
-    server_->stateMask_.meta_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Meta");
-
+    UnixFD scopeFD = UnixFD::own(fd);
+    server_->updateKeymap(format, fd, size, modifierNames());
     server_->parent_->wayland()->call<IWaylandModule::reloadXkbOption>();
 }
 
@@ -477,9 +435,14 @@ void WaylandIMInputContextV1::keyCallback(uint32_t serial, uint32_t time,
 
     WAYLANDIM_DEBUG() << event.key().toString()
                       << " IsRelease=" << event.isRelease();
-    if (!ic->keyEvent(event)) {
-        sendKeyToVK(time, event.rawKey(), state);
-    }
+    // The engine may defer the result, forward the key once it is known.
+    ic->keyEventAsync(event, [ref = watch(), time, key = event.rawKey(),
+                              state](bool accepted) {
+        if (auto *self = static_cast<WaylandIMInputContextV1 *>(ref.get());
+            self && !accepted) {
+            self->sendKeyToVK(time, key, state);
+        }
+    });
 
     // This means our engine is being too slow, this is usually transient (e.g.
     // cold start up due to data loading, high CPU usage etc).
@@ -503,49 +466,10 @@ void WaylandIMInputContextV1::modifiersCallback(uint32_t serial,
         return;
     }
 
-    xkb_mod_mask_t mask;
-
-    xkb_state_update_mask(server_->state_.get(), mods_depressed, mods_latched,
-                          mods_locked, 0, 0, group);
-    server_->instance()->updateXkbStateMask(
-        server_->group()->display(), mods_depressed, mods_latched, mods_locked);
-    mask = xkb_state_serialize_mods(server_->state_.get(),
-                                    XKB_STATE_MODS_EFFECTIVE);
-
-    server_->modifiers_ = 0;
-    if (mask & server_->stateMask_.shift_mask) {
-        server_->modifiers_ |= KeyState::Shift;
-    }
-    if (mask & server_->stateMask_.lock_mask) {
-        server_->modifiers_ |= KeyState::CapsLock;
-    }
-    if (mask & server_->stateMask_.control_mask) {
-        server_->modifiers_ |= KeyState::Ctrl;
-    }
-    if (mask & server_->stateMask_.mod1_mask) {
-        server_->modifiers_ |= KeyState::Alt;
-    }
-    if (mask & server_->stateMask_.mod2_mask) {
-        server_->modifiers_ |= KeyState::NumLock;
-    }
-    if (mask & server_->stateMask_.super_mask) {
-        server_->modifiers_ |= KeyState::Super;
-    }
-    if (mask & server_->stateMask_.mod4_mask) {
-        server_->modifiers_ |= KeyState::Super;
-    }
-    if (mask & server_->stateMask_.hyper_mask) {
-        server_->modifiers_ |= KeyState::Hyper;
-    }
-    if (mask & server_->stateMask_.mod3_mask) {
-        server_->modifiers_ |= KeyState::Hyper;
-    }
-    if (mask & server_->stateMask_.mod5_mask) {
-        server_->modifiers_ |= KeyState::Mod5;
-    }
-    if (mask & server_->stateMask_.meta_mask) {
-        server_->modifiers_ |= KeyState::Meta;
-    }
+    // Repeated key will have different modifiers.
+    delegatedInputContext()->setKeyRepeatPassThrough(false);
+    server_->updateModifiers(mods_depressed, mods_latched, mods_locked, group,
+                             XKB_STATE_MODS_EFFECTIVE);
 }
 
 // This is not sent by either kwin/weston, but since it's unclear whether any
@@ -616,19 +540,21 @@ void WaylandIMInputContextV1::deleteSurroundingTextDelegate(
         return;
     }
 
-    const auto &text = ic->surroundingText().text();
-    auto len = utf8::length(text);
-
+    const auto &surroundingText = ic->surroundingText();
     size_t start = cursor + offset;
     size_t end = cursor + offset + size;
-    if (cursor > len || start > len || end > len) {
+    // byteOffset also validates the length.
+    auto startBytes = surroundingText.byteOffset(start);
+    auto cursorBytes = surroundingText.byteOffset(cursor);
+    auto endBytes = surroundingText.byteOffset(end);
+    if (startBytes == std::string::npos || cursorBytes == std::string::npos ||
+        endBytes == std::string::npos) {
         return;
     }
 
-    auto startBytes = utf8::ncharByteLength(text.begin(), start);
-    auto cursorBytes = utf8::ncharByteLength(text.begin(), cursor);
-    auto sizeBytes = utf8::ncharByteLength(text.begin() + startBytes, size);
-    ic_->deleteSurroundingText(startBytes - cursorBytes, sizeBytes);
+    ic_->deleteSurroundingText(static_cast<int32_t>(startBytes) -
+                                   static_cast<int32_t>(cursorBytes),
+                               endBytes - startBytes);
     ic_->commitString(serial_, "");
 }
 
@@ -45,20 +45,6 @@ private:
 
     ScopedConnection globalConn_;
 
-    struct StateMask {
-        uint32_t shift_mask = 0;
-        uint32_t lock_mask = 0;
-        uint32_t control_mask = 0;
-        uint32_t mod1_mask = 0;
-        uint32_t mod2_mask = 0;
-        uint32_t mod3_mask = 0;
-        uint32_t mod4_mask = 0;
-        uint32_t mod5_mask = 0;
-        uint32_t super_mask = 0;
-        uint32_t hyper_mask = 0;
-        uint32_t meta_mask = 0;
-    } stateMask_;
-
     TrackableObjectReference<InputContext> globalIc_;
 };
 
@@ -5,10 +5,13 @@
  */
 
 #include "waylandimserverbase.h"
+#include <sys/mman.h>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <wayland-client-core.h>
 #include "fcitx-utils/utf8.h"
+#include "fcitx/instance.h"
 #include "waylandim.h"
 #include "wl_seat.h"
 
@@ -37,6 +40,68 @@ WaylandIMServerBase::mayCommitAsText(const Key &key, uint32_t state) const {
     return std::nullopt;
 }
 
+bool WaylandIMServerBase::updateKeymap(uint32_t format, int32_t fd,
+                                       uint32_t size,
+                                       const ModifierNames &names) {
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+        return false;
+    }
+
+    auto *mapStr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapStr == MAP_FAILED) {
+        return false;
+    }
+
+    // Keymaps are shared by content, so an unchanged keymap gives the same
+    // object.
+    auto *keymap = parent_->instance()->xkbKeymapFromString(
+        std::string_view(static_cast<const char *>(mapStr), size));
+    munmap(mapStr, size);
+    const bool keymapChanged = keymap != keymap_.get();
+    if (keymapChanged) {
+        keymap_.reset(keymap ? xkb_keymap_ref(keymap) : nullptr);
+        modifierMasks_.clear();
+    }
+
+    if (!keymap_) {
+        state_.reset();
+        return keymapChanged;
+    }
+
+    state_.reset(xkb_state_new(keymap_.get()));
+    if (!state_) {
+        keymap_.reset();
+        return true;
+    }
+
+    if (keymapChanged) {
+        for (const auto &[name, states] : names) {
+            auto index = xkb_keymap_mod_get_index(keymap_.get(), name);
+            if (index != XKB_MOD_INVALID) {
+                modifierMasks_.emplace_back(1U << index, states);
+            }
+        }
+    }
+    return keymapChanged;
+}
+
+void WaylandIMServerBase::updateModifiers(uint32_t depressed, uint32_t latched,
+                                          uint32_t locked, uint32_t group,
+                                          xkb_state_component components) {
+    xkb_state_update_mask(state_.get(), depressed, latched, locked, 0, 0,
+                          group);
+    parent_->instance()->updateXkbStateMask(group_->display(), depressed,
+                                            latched, locked);
+    auto mask = xkb_state_serialize_mods(state_.get(), components);
+
+    modifiers_ = 0;
+    for (const auto &[modMask, states] : modifierMasks_) {
+        if (mask & modMask) {
+            modifiers_ |= states;
+        }
+    }
+}
+
 std::optional<std::tuple<int32_t, int32_t>> WaylandIMServerBase::repeatInfo(
     const std::shared_ptr<wayland::WlSeat> &seat,
     const std::optional<std::tuple<int32_t, int32_t>> &defaultValue) const {
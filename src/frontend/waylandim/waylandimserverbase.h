@@ -7,7 +7,10 @@
 #ifndef _FCITX5_FRONTEND_WAYLANDIM_WAYLANDIMSERVERBASE_H_
 #define _FCITX5_FRONTEND_WAYLANDIM_WAYLANDIMSERVERBASE_H_
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 #include <xkbcommon/xkbcommon.h>
 #include "fcitx-utils/misc.h"
 #include "display.h"
@@ -18,6 +21,9 @@ namespace fcitx {
 
 class WaylandIMServerBase {
 public:
+    // Modifier names of the keymap and the key states that they map to.
+    using ModifierNames = std::vector<std::pair<const char *, KeyStates>>;
+
     WaylandIMServerBase(wl_display *display, FocusGroup *group,
                         std::string name, WaylandIMModule *waylandim);
     virtual ~WaylandIMServerBase() = default;
@@ -36,18 +42,33 @@ public:
         const std::optional<std::tuple<int32_t, int32_t>> &defaultValue) const;
 
 protected:
+    /**
+     * Update keymap from a wl_keyboard keymap event, fd is not owned.
+     *
+     * The keymap is shared by content within the instance, and the mask of
+     * modifiers is only computed again if keymap is changed. The xkb state is
+     * always recreated. Return whether keymap is changed.
+     */
+    bool updateKeymap(uint32_t format, int32_t fd, uint32_t size,
+                      const ModifierNames &names);
+
+    /// Update xkb state and modifiers_ from a modifiers event.
+    void updateModifiers(uint32_t depressed, uint32_t latched, uint32_t locked,
+                         uint32_t group, xkb_state_component components);
+
     FocusGroup *group_;
     std::string name_;
     WaylandIMModule *parent_;
     wayland::Display *display_;
 
-    UniqueCPtr<struct xkb_context, xkb_context_unref> context_;
     UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap_;
     UniqueCPtr<struct xkb_state, xkb_state_unref> state_;
 
     KeyStates modifiers_;
 
 private:
+    std::vector<std::pair<xkb_mod_mask_t, KeyStates>> modifierMasks_;
+
     std::optional<std::tuple<int32_t, int32_t>> repeatInfo(
         const std::shared_ptr<wayland::WlSeat> &seat,
         const std::optional<std::tuple<int32_t, int32_t>> &defaultValue) const;
@@ -5,8 +5,9 @@
  *
  */
 #include "waylandimserverv2.h"
-#include <sys/mman.h>
 #include <ctime>
+#include <utility>
+#include <string_view>
 #include "fcitx-utils/keysymgen.h"
 #include "fcitx-utils/unixfd.h"
 #include "fcitx-utils/utf8.h"
@@ -22,6 +23,20 @@ constexpr CapabilityFlags baseFlags{
     CapabilityFlag::Preedit, CapabilityFlag::FormattedPreedit,
     CapabilityFlag::SurroundingText, CapabilityFlag::ClientUnfocusCommit};
 
+namespace {
+
+const WaylandIMServerBase::ModifierNames &modifierNames() {
+    static const WaylandIMServerBase::ModifierNames names = {
+        {"Shift", KeyState::Shift},  {"Lock", KeyState::CapsLock},
+        {"Control", KeyState::Ctrl}, {"Mod1", KeyState::Alt},
+        {"Mod2", KeyState::NumLock}, {"Mod4", KeyState::Super},
+        {"Mod3", KeyState::Mod3},    {"Mod5", KeyState::Mod5},
+    };
+    return names;
+}
+
+} // namespace
+
 WaylandIMServerV2::WaylandIMServerV2(wl_display *display, FocusGroup *group,
                                      const std::string &name,
                                      WaylandIMModule *waylandim)
@@ -120,6 +135,26 @@ void WaylandIMServerV2::remove(wayland::WlSeat *seat) {
     }
 }
 
+void WaylandIMServerV2::scheduleFlush(const WaylandIMInputContextV2 *ic) {
+    pendingFlush_.insert(ic);
+    if (flushEvent_) {
+        flushEvent_->setOneShot();
+        return;
+    }
+    flushEvent_ = instance()->eventLoop().addDeferEvent([this](EventSource *) {
+        flush();
+        return true;
+    });
+}
+
+void WaylandIMServerV2::flush() {
+    auto pendingFlush = std::move(pendingFlush_);
+    pendingFlush_.clear();
+    for (const auto *ic : pendingFlush) {
+        ic->flush();
+    }
+}
+
 WaylandIMInputContextV2::WaylandIMInputContextV2(
     InputContextManager &inputContextManager, WaylandIMServerV2 *server,
     std::shared_ptr<wayland::WlSeat> seat, wayland::ZwpVirtualKeyboardV1 *vk)
@@ -142,6 +177,8 @@ WaylandIMInputContextV2::WaylandIMInputContextV2(
     });
     ic_->done().connect([this]() {
         WAYLANDIM_DEBUG() << "DONE";
+        // Pending requests belong to the state before this done.
+        flush();
         ++serial_;
         if (pendingDeactivate_) {
             pendingDeactivate_ = false;
@@ -231,6 +268,8 @@ WaylandIMInputContextV2::WaylandIMInputContextV2(
 WaylandIMInputContextV2::~WaylandIMInputContextV2() {
     server_->remove(seat_.get());
     destroy();
+    // destroy() may update the preedit again.
+    server_->pendingFlush_.erase(this);
 }
 
 void WaylandIMInputContextV2::repeat() {
@@ -243,9 +282,11 @@ void WaylandIMInputContextV2::repeat() {
         Key(repeatSym_, server_->modifiers_ | KeyState::Repeat, repeatKey_ + 8),
         false, repeatTime_);
     sendKeyToVK(repeatTime_, event.rawKey(), WL_KEYBOARD_KEY_STATE_RELEASED);
-    if (!ic->keyEvent(event)) {
+    // Skip the dispatch if the input method does not care about the repeat.
+    if (ic->isKeyRepeatPassThrough() || !ic->keyEvent(event)) {
         sendKeyToVK(repeatTime_, event.rawKey(), WL_KEYBOARD_KEY_STATE_PRESSED);
     }
+    flush();
     uint64_t interval = 1000000 / repeatRate();
     timeEvent_->setTime(timeEvent_->time() + interval);
     timeEvent_->setOneShot();
@@ -254,28 +295,9 @@ void WaylandIMInputContextV2::repeat() {
 void WaylandIMInputContextV2::surroundingTextCallback(const char *text,
                                                       uint32_t cursor,
                                                       uint32_t anchor) {
-    std::string str(text);
-    surroundingText().invalidate();
-    do {
-        auto length = utf8::lengthValidated(str);
-        if (length == utf8::INVALID_LENGTH) {
-            break;
-        }
-        if (cursor > str.size() || anchor > str.size()) {
-            break;
-        }
-        size_t cursorByChar =
-            utf8::lengthValidated(str.begin(), str.begin() + cursor);
-        if (cursorByChar == utf8::INVALID_LENGTH) {
-            break;
-        }
-        size_t anchorByChar =
-            utf8::lengthValidated(str.begin(), str.begin() + anchor);
-        if (anchorByChar == utf8::INVALID_LENGTH) {
-            break;
-        }
-        surroundingText().setText(text, cursorByChar, anchorByChar);
-    } while (false);
+    // Clients send the whole text on every change, usually with only a small
+    // part of it changed.
+    surroundingText().setTextWithByteOffset(text, cursor, anchor);
     updateSurroundingTextWrapper();
 }
 void WaylandIMInputContextV2::resetCallback() {
@@ -362,64 +384,14 @@ void WaylandIMInputContextV2::contentTypeCallback(uint32_t hint,
 void WaylandIMInputContextV2::keymapCallback(uint32_t format, int32_t fd,
                                              uint32_t size) {
     WAYLANDIM_DEBUG() << "keymapCallback";
-    if (!server_->context_) {
-        server_->context_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
-        xkb_context_set_log_level(server_->context_.get(),
-                                  XKB_LOG_LEVEL_CRITICAL);
-    }
-
     UnixFD scopeFD = UnixFD::own(fd);
 
-    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
-        return;
-    }
-
-    auto *mapStr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (mapStr == MAP_FAILED) {
-        return;
-    }
-
     const bool keymapChanged =
-        (size != server_->keymapData_.size() ||
-         memcmp(mapStr, server_->keymapData_.data(), size) != 0);
-    if (keymapChanged) {
-        server_->keymapData_.resize(size);
-        server_->keymapData_.assign(static_cast<const char *>(mapStr),
-                                    static_cast<const char *>(mapStr) + size);
-        server_->keymap_.reset(xkb_keymap_new_from_string(
-            server_->context_.get(), static_cast<const char *>(mapStr),
-            XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS));
-    }
-
-    munmap(mapStr, size);
-
+        server_->updateKeymap(format, fd, size, modifierNames());
     if (!server_->keymap_) {
         return;
     }
 
-    server_->state_.reset(xkb_state_new(server_->keymap_.get()));
-    if (!server_->state_) {
-        server_->keymap_.reset();
-        return;
-    }
-
-    server_->stateMask_.shift_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Shift");
-    server_->stateMask_.lock_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Lock");
-    server_->stateMask_.control_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Control");
-    server_->stateMask_.mod1_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod1");
-    server_->stateMask_.mod2_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod2");
-    server_->stateMask_.mod3_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod3");
-    server_->stateMask_.mod4_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod4");
-    server_->stateMask_.mod5_mask =
-        1 << xkb_keymap_mod_get_index(server_->keymap_.get(), "Mod5");
-
     if (keymapChanged) {
         vk_->keymap(format, scopeFD.fd(), size);
         vkReady_ = true;
@@ -467,11 +439,18 @@ void WaylandIMInputContextV2::keyCallback(uint32_t serial, uint32_t time,
 
     WAYLANDIM_DEBUG() << event.key().toString()
                       << " IsRelease=" << event.isRelease();
-    if (!ic->keyEvent(event)) {
-        sendKeyToVK(time, event.rawKey(),
-                    event.isRelease() ? WL_KEYBOARD_KEY_STATE_RELEASED
-                                      : WL_KEYBOARD_KEY_STATE_PRESSED);
-    }
+    // The engine may defer the result, forward the key once it is known.
+    ic->keyEventAsync(event, [ref = watch(), time, key = event.rawKey(),
+                              isRelease = event.isRelease()](bool accepted) {
+        if (auto *self = static_cast<WaylandIMInputContextV2 *>(ref.get());
+            self && !accepted) {
+            self->sendKeyToVK(time, key,
+                              isRelease ? WL_KEYBOARD_KEY_STATE_RELEASED
+                                        : WL_KEYBOARD_KEY_STATE_PRESSED);
+        }
+    });
+    // Send everything produced by the key at once.
+    flush();
 
     // This means our engine is being too slow, this is usually transient (e.g.
     // cold start up due to data loading, high CPU usage etc).
@@ -494,43 +473,15 @@ void WaylandIMInputContextV2::modifiersCallback(uint32_t /*serial*/,
         return;
     }
 
-    xkb_mod_mask_t mask;
-
-    xkb_state_update_mask(server_->state_.get(), mods_depressed, mods_latched,
-                          mods_locked, 0, 0, group);
-    server_->instance()->updateXkbStateMask(
-        server_->group()->display(), mods_depressed, mods_latched, mods_locked);
-    mask = xkb_state_serialize_mods(
-        server_->state_.get(), static_cast<xkb_state_component>(
-                                   XKB_STATE_DEPRESSED | XKB_STATE_LATCHED));
-
-    server_->modifiers_ = 0;
-    if (mask & server_->stateMask_.shift_mask) {
-        server_->modifiers_ |= KeyState::Shift;
-    }
-    if (mask & server_->stateMask_.lock_mask) {
-        server_->modifiers_ |= KeyState::CapsLock;
-    }
-    if (mask & server_->stateMask_.control_mask) {
-        server_->modifiers_ |= KeyState::Ctrl;
-    }
-    if (mask & server_->stateMask_.mod1_mask) {
-        server_->modifiers_ |= KeyState::Alt;
-    }
-    if (mask & server_->stateMask_.mod2_mask) {
-        server_->modifiers_ |= KeyState::NumLock;
-    }
-    if (mask & server_->stateMask_.mod4_mask) {
-        server_->modifiers_ |= KeyState::Super;
-    }
-    if (mask & server_->stateMask_.mod3_mask) {
-        server_->modifiers_ |= KeyState::Mod3;
-    }
-    if (mask & server_->stateMask_.mod5_mask) {
-        server_->modifiers_ |= KeyState::Mod5;
-    }
+    // Repeated key will have different modifiers.
+    delegatedInputContext()->setKeyRepeatPassThrough(false);
+    server_->updateModifiers(
+        mods_depressed, mods_latched, mods_locked, group,
+        static_cast<xkb_state_component>(XKB_STATE_DEPRESSED |
+                                         XKB_STATE_LATCHED));
 
     if (vkReady_) {
+        flush();
         vk_->modifiers(mods_depressed, mods_latched, mods_locked, group);
     }
 }
@@ -556,9 +507,46 @@ void WaylandIMInputContextV2::sendKeyToVK(uint32_t time, const Key &key,
         xkb_keymap_key_repeats(server_->keymap_.get(), key.code())) {
         pressedVKKey_[code] = time;
     }
+    // Keep the order with text sent to the client.
+    flush();
     vk_->key(time, code, state);
 }
 
+void WaylandIMInputContextV2::flush() const {
+    if (!pending_.dirty) {
+        return;
+    }
+    auto pending = std::exchange(pending_, PendingState());
+    if (!ic_) {
+        return;
+    }
+    if (pending.deleteSurrounding) {
+        ic_->deleteSurroundingText(pending.deleteSurrounding->first,
+                                   pending.deleteSurrounding->second);
+    }
+    if (!pending.commit.empty()) {
+        ic_->commitString(pending.commit.c_str());
+    }
+    if (!pending.preedit.empty()) {
+        ic_->setPreeditString(pending.preedit.c_str(),
+                              pending.preeditCursorBegin,
+                              pending.preeditCursorEnd);
+    }
+    ic_->commit(serial_);
+}
+
+void WaylandIMInputContextV2::commitStringDelegate(
+    const InputContext * /*ic*/, const std::string &text) const {
+    if (!ic_) {
+        return;
+    }
+    // Preedit is cleared by the commit request, until it is set again.
+    pending_.commit.append(text);
+    pending_.preedit.clear();
+    pending_.dirty = true;
+    server_->scheduleFlush(this);
+}
+
 void WaylandIMInputContextV2::forwardKeyDelegate(
     InputContext * /*ic*/, const ForwardKeyEvent &key) const {
     uint32_t code = 0;
@@ -625,14 +613,17 @@ void WaylandIMInputContextV2::updatePreeditDelegate(InputContext *ic) const {
         }
     }
 
+    pending_.preedit.clear();
     if (preedit.textLength()) {
         if (cursorStart < 0) {
             cursorStart = cursorEnd = preedit.textLength();
         }
-        ic_->setPreeditString(preedit.toString().data(), cursorStart,
-                              cursorEnd);
+        pending_.preedit = preedit.toString();
+        pending_.preeditCursorBegin = cursorStart;
+        pending_.preeditCursorEnd = cursorEnd;
     }
-    ic_->commit(serial_);
+    pending_.dirty = true;
+    server_->scheduleFlush(this);
 }
 
 void WaylandIMInputContextV2::deleteSurroundingTextDelegate(
@@ -651,22 +642,28 @@ void WaylandIMInputContextV2::deleteSurroundingTextDelegate(
         return;
     }
 
-    const auto &text = ic->surroundingText().text();
-    auto len = utf8::length(text);
-
+    const auto &surroundingText = ic->surroundingText();
     size_t start = cursor + offset;
     size_t end = cursor + offset + size;
-    // validate length.
-    if (cursor > len || start > len || end > len) {
+    // byteOffset also validates the length.
+    auto startBytes = surroundingText.byteOffset(start);
+    auto cursorBytes = surroundingText.byteOffset(cursor);
+    auto endBytes = surroundingText.byteOffset(end);
+    if (startBytes == std::string::npos || cursorBytes == std::string::npos ||
+        endBytes == std::string::npos) {
         return;
     }
 
-    auto startBytes = utf8::ncharByteLength(text.begin(), start);
-    auto cursorBytes = utf8::ncharByteLength(text.begin(), cursor);
-    auto sizeBytes = utf8::ncharByteLength(text.begin() + startBytes, size);
-    ic_->deleteSurroundingText(cursorBytes - startBytes,
-                               startBytes + sizeBytes - cursorBytes);
-    ic_->commit(serial_);
+    // Delete is applied before commit string in one commit request, and only
+    // one delete is allowed.
+    if (!pending_.commit.empty() || pending_.deleteSurrounding) {
+        flush();
+    }
+    pending_.deleteSurrounding.emplace(cursorBytes - startBytes,
+                                       endBytes - cursorBytes);
+    pending_.preedit.clear();
+    pending_.dirty = true;
+    server_->scheduleFlush(this);
 }
 
 int32_t WaylandIMInputContextV2::repeatRate() const {
@@ -8,6 +8,10 @@
 #define _FCITX5_FRONTEND_WAYLANDIM_WAYLANDIMSERVERV2_H_
 
 #include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/misc_p.h"
 #include "virtualinputcontext.h"
@@ -37,6 +41,9 @@ public:
     void refreshSeat();
     void add(WaylandIMInputContextV2 *ic, wayland::WlSeat *seat);
     void remove(wayland::WlSeat *seat);
+    // Flush the buffered requests of ic later in this event loop iteration.
+    void scheduleFlush(const WaylandIMInputContextV2 *ic);
+    void flush();
     Instance *instance();
     FocusGroup *group() { return group_; }
     auto *xkbState() { return state_.get(); }
@@ -50,22 +57,11 @@ private:
     std::shared_ptr<wayland::ZwpVirtualKeyboardManagerV1>
         virtualKeyboardManagerV1_;
 
-    std::vector<char> keymapData_;
-
     ScopedConnection globalConn_;
 
-    struct StateMask {
-        uint32_t shift_mask = 0;
-        uint32_t lock_mask = 0;
-        uint32_t control_mask = 0;
-        uint32_t mod1_mask = 0;
-        uint32_t mod2_mask = 0;
-        uint32_t mod3_mask = 0;
-        uint32_t mod4_mask = 0;
-        uint32_t mod5_mask = 0;
-    } stateMask_;
-
     std::unordered_map<wayland::WlSeat *, WaylandIMInputContextV2 *> icMap_;
+    std::unordered_set<const WaylandIMInputContextV2 *> pendingFlush_;
+    std::unique_ptr<EventSource> flushEvent_;
 };
 
 class WaylandIMInputContextV2 : public VirtualInputContextGlue {
@@ -82,15 +78,12 @@ public:
 
     bool hasKeyboardGrab() const { return keyboardGrab_.get(); }
 
+    // Send the buffered requests with a single commit.
+    void flush() const;
+
 protected:
     void commitStringDelegate(const InputContext * /*ic*/,
-                              const std::string &text) const override {
-        if (!ic_) {
-            return;
-        }
-        ic_->commitString(text.c_str());
-        ic_->commit(serial_);
-    }
+                              const std::string &text) const override;
     void deleteSurroundingTextDelegate(InputContext *ic, int offset,
                                        unsigned int size) const override;
     void forwardKeyDelegate(InputContext * /*ic*/,
@@ -140,6 +133,17 @@ private:
     std::optional<std::tuple<int32_t, int32_t>> repeatInfo_;
 
     mutable OrderedMap<uint32_t, uint32_t> pressedVKKey_;
+
+    // Pending state of zwp_input_method_v2, sent on flush.
+    struct PendingState {
+        bool dirty = false;
+        std::string commit;
+        std::optional<std::pair<uint32_t, uint32_t>> deleteSurrounding;
+        std::string preedit;
+        int32_t preeditCursorBegin = 0;
+        int32_t preeditCursorEnd = 0;
+    };
+    mutable PendingState pending_;
 };
 
 } // namespace fcitx
@@ -29,11 +29,11 @@ public:
         }));
         conns_.emplace_back(window->done().connect([this]() {
             active_ = pendingActive_;
-            parent_->refresh();
+            parent_->refresh(this);
         }));
         conns_.emplace_back(window->appId().connect([this](const char *appId) {
             appId_ = appId;
-            parent_->refresh();
+            parent_->refresh(this);
         }));
     }
 
@@ -82,22 +82,16 @@ void WlrAppMonitor::setup(wayland::ZwlrForeignToplevelManagerV1 *management) {
 }
 
 void WlrAppMonitor::remove(wayland::ZwlrForeignToplevelHandleV1 *handle) {
-    windows_.erase(handle);
-    refresh();
+    auto iter = windows_.find(handle);
+    if (iter == windows_.end()) {
+        return;
+    }
+    removeApp(iter->second->key());
+    windows_.erase(iter);
 }
 
-void WlrAppMonitor::refresh() {
-    std::unordered_map<std::string, std::string> state;
-    std::optional<std::string> focus;
-    for (const auto &[_, wlrWindow] : windows_) {
-        if (!wlrWindow->appId().empty()) {
-            auto iter = state.emplace(wlrWindow->key(), wlrWindow->appId());
-            if (wlrWindow->active() && !focus && iter.second) {
-                focus = iter.first->first;
-            }
-        }
-    }
-    appUpdated(state, focus);
+void WlrAppMonitor::refresh(WlrWindow *window) {
+    updateApp(window->key(), window->appId(), window->active());
 }
 
 } // namespace fcitx
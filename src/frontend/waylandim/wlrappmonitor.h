@@ -27,7 +27,7 @@ public:
 
     void setup(wayland::ZwlrForeignToplevelManagerV1 *management);
     void remove(wayland::ZwlrForeignToplevelHandleV1 *window);
-    void refresh();
+    void refresh(WlrWindow *window);
 
 private:
     ScopedConnection globalConn_;
@@ -35,7 +35,6 @@ private:
     std::unordered_map<wayland::ZwlrForeignToplevelHandleV1 *,
                        std::unique_ptr<WlrWindow>>
         windows_;
-    std::unordered_map<std::string, uint32_t> appState_;
 };
 
 } // namespace fcitx
@@ -7,11 +7,19 @@
 
 #include "xim.h"
 #include <unistd.h>
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <xcb-imdkit/encoding.h>
 #include <xcb/xcb_aux.h>
 #include <xkbcommon/xkbcommon.h>
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/misc.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/stringutils.h"
@@ -89,6 +97,44 @@ void XimLogFunc(const char *fmt, ...) {
     XIM_DEBUG() << buf.data();
 }
 
+// Program names of the most recently used client windows.
+class ProgramNameCache {
+public:
+    const std::string *find(xcb_window_t window) {
+        auto iter = index_.find(window);
+        if (iter == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, iter->second);
+        return &iter->second->second;
+    }
+
+    void insert(xcb_window_t window, std::string name) {
+        remove(window);
+        entries_.emplace_front(window, std::move(name));
+        index_[window] = entries_.begin();
+        if (entries_.size() > maxSize) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    void remove(xcb_window_t window) {
+        auto iter = index_.find(window);
+        if (iter == index_.end()) {
+            return;
+        }
+        entries_.erase(iter->second);
+        index_.erase(iter);
+    }
+
+private:
+    using EntryList = std::list<std::pair<xcb_window_t, std::string>>;
+    static constexpr size_t maxSize = 64;
+    EntryList entries_;
+    std::unordered_map<xcb_window_t, EntryList::iterator> index_;
+};
+
 } // namespace
 
 class XIMServer {
@@ -118,10 +164,17 @@ public:
         if (::xim().checkLogLevel(LogLevel::Debug)) {
             xcb_im_set_log_handler(im_.get(), XimLogFunc);
         }
-        xcb_im_set_use_sync_mode(im_.get(), true);
+        // Forward events asynchronously, so a slow client does not block the
+        // others. Clients that need sync mode switch it on in setSyncMode.
+        xcb_im_set_use_sync_mode(im_.get(), syncMode_);
 
         filter_ = parent_->xcb()->call<fcitx::IXCBModule::addEventFilter>(
             name, [this](xcb_connection_t *, xcb_generic_event_t *event) {
+                if ((event->response_type & ~0x80) == XCB_DESTROY_NOTIFY) {
+                    auto *destroy =
+                        reinterpret_cast<xcb_destroy_notify_event_t *>(event);
+                    programNameCache_.remove(destroy->window);
+                }
                 bool result = xcb_im_filter_event(im_.get(), event);
                 if (result) {
                     XIM_DEBUG() << "XIM filtered event";
@@ -165,12 +218,44 @@ public:
 
     auto im() { return im_.get(); }
     auto conn() { return conn_; }
+    const auto &config() { return parent_->config(); }
+
+    // Sync mode is a state of the whole xim server, so it is updated before
+    // talking to a client.
+    void setSyncMode(bool sync) {
+        if (syncMode_ != sync) {
+            syncMode_ = sync;
+            xcb_im_set_use_sync_mode(im_.get(), sync);
+        }
+    }
     auto root() const { return root_; }
     auto ewmh() { return ewmh_; }
+    auto &programNameCache() { return programNameCache_; }
+
+    // Get notified when window is destroyed, so its cached program name can be
+    // dropped.
+    void watchWindowDestroy(xcb_window_t window) {
+        auto cookie = xcb_get_window_attributes(conn_, window);
+        auto reply = makeUniqueCPtr(
+            xcb_get_window_attributes_reply(conn_, cookie, nullptr));
+        if (!reply) {
+            return;
+        }
+        if (!(reply->your_event_mask & XCB_EVENT_MASK_STRUCTURE_NOTIFY)) {
+            const uint32_t mask =
+                reply->your_event_mask | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+            xcb_change_window_attributes(conn_, window, XCB_CW_EVENT_MASK,
+                                         &mask);
+        }
+    }
     auto focusGroup() { return group_; }
     auto xkbState() {
         return parent_->xcb()->call<IXCBModule::xkbState>(name_);
     }
+    // Requests sent outside of the xcb event filter need to be flushed.
+    void scheduleFlush() {
+        parent_->xcb()->call<IXCBModule::scheduleFlush>(name_);
+    }
 
 private:
     xcb_connection_t *conn_;
@@ -186,6 +271,8 @@ private:
     std::unordered_map<xcb_im_client_t *, bool> clientEncodingMapping_;
     std::unordered_set<uint32_t> supportedStyles_;
     UniqueCPtr<struct xkb_state, xkb_state_unref> localState_;
+    bool syncMode_ = false;
+    ProgramNameCache programNameCache_;
 };
 
 pid_t getWindowPid(xcb_ewmh_connection_t *ewmh, xcb_window_t w) {
@@ -197,31 +284,47 @@ pid_t getWindowPid(xcb_ewmh_connection_t *ewmh, xcb_window_t w) {
     return 0;
 }
 
+std::string resolveProgramName(XIMServer *server, xcb_window_t w) {
+    while (w != server->root()) {
+        if (auto pid = getWindowPid(server->ewmh(), w)) {
+            return getProcessName(pid);
+        }
+
+        auto cookie = xcb_query_tree(server->conn(), w);
+        auto reply = makeUniqueCPtr(
+            xcb_query_tree_reply(server->conn(), cookie, nullptr));
+        if (!reply) {
+            break;
+        }
+        // This should never happen, but just as a sanity check.
+        if (reply->root != server->root() || w == reply->parent) {
+            break;
+        }
+        w = reply->parent;
+    }
+    return {};
+}
+
 std::string getProgramName(XIMServer *server, xcb_im_input_context_t *ic) {
     auto w = xcb_im_input_context_get_client_window(ic);
     if (!w) {
         w = xcb_im_input_context_get_focus_window(ic);
     }
-    if (w) {
-        while (w != server->root()) {
-            if (auto pid = getWindowPid(server->ewmh(), w)) {
-                return getProcessName(pid);
-            }
-
-            auto cookie = xcb_query_tree(server->conn(), w);
-            auto reply = makeUniqueCPtr(
-                xcb_query_tree_reply(server->conn(), cookie, nullptr));
-            if (!reply) {
-                break;
-            }
-            // This should never happen, but just as a sanity check.
-            if (reply->root != server->root() || w == reply->parent) {
-                break;
-            }
-            w = reply->parent;
-        }
+    if (!w) {
+        return {};
     }
-    return {};
+    // Some programs, e.g. LibreOffice, create a lot of input contexts for one
+    // window.
+    if (const auto *name = server->programNameCache().find(w)) {
+        return *name;
+    }
+    auto name = resolveProgramName(server, w);
+    // Pid may be set later, so only cache the successful result.
+    if (!name.empty()) {
+        server->watchWindowDestroy(w);
+        server->programNameCache().insert(w, name);
+    }
+    return name;
 }
 
 class XIMInputContext final : public InputContext {
@@ -230,6 +333,10 @@ public:
                     xcb_im_input_context_t *ic, bool useUtf8)
         : InputContext(inputContextManager, getProgramName(server, ic)),
           server_(server), xic_(ic), useUtf8_(useUtf8) {
+        const auto &syncModePrograms = *server->config().syncModePrograms;
+        useSyncMode_ = std::find(syncModePrograms.begin(),
+                                 syncModePrograms.end(),
+                                 program()) != syncModePrograms.end();
         setFocusGroup(server->focusGroup());
         xcb_im_input_context_set_data(xic_, this, nullptr);
 
@@ -265,6 +372,8 @@ public:
 
     const char *frontend() const override { return "xim"; }
 
+    void applySyncMode() { server_->setSyncMode(useSyncMode_); }
+
     void maybeUpdateCursorLocationForRootStyle() {
         if ((validatedInputStyle() & XCB_IM_PreeditPosition) ==
             XCB_IM_PreeditPosition) {
@@ -358,6 +467,20 @@ public:
         lastTime_ = 0;
     }
 
+    // Send the pending preedit, if any. Called before anything else is sent
+    // to the client to keep the order.
+    void flushPreedit() {
+        if (!preeditDirty_) {
+            return;
+        }
+        preeditDirty_ = false;
+        if (preeditEvent_) {
+            preeditEvent_->setEnabled(false);
+        }
+        drawPreedit();
+        server_->scheduleFlush();
+    }
+
 protected:
     void commitStringImpl(const std::string &text) override {
         UniqueCPtr<char> compoundText;
@@ -375,8 +498,11 @@ protected:
         }
         XIM_DEBUG() << "XIM commit: " << text;
 
+        flushPreedit();
+        applySyncMode();
         xcb_im_commit_string(server_->im(), xic_, XCB_XIM_LOOKUP_CHARS, commit,
                              length, 0);
+        server_->scheduleFlush();
     }
     void deleteSurroundingTextImpl(int, unsigned int) override {}
     void forwardKeyImpl(const ForwardKeyEvent &key) override {
@@ -412,14 +538,34 @@ protected:
         xcbEvent.child = XCB_WINDOW_NONE;
         xcbEvent.same_screen = 0;
         xcbEvent.sequence = 0;
+        flushPreedit();
+        applySyncMode();
         xcb_im_forward_event(server_->im(), xic_, &xcbEvent);
+        server_->scheduleFlush();
     }
+    // Preedit updates are only drawn once per event loop iteration, so the
+    // intermediate updates within one key event are not sent to the client.
     void updatePreeditImpl() override {
+        preeditDirty_ = true;
+        if (preeditEvent_) {
+            preeditEvent_->setOneShot();
+            return;
+        }
+        preeditEvent_ = server_->instance()->eventLoop().addDeferEvent(
+            [this](EventSource *) {
+                flushPreedit();
+                return true;
+            });
+    }
+
+private:
+    void drawPreedit() {
         auto text = server_->instance()->outputFilter(
             this, inputPanel().clientPreedit());
         auto strPreedit = text.toString();
 
         if (strPreedit.empty() && preeditStarted) {
+            applySyncMode();
             xcb_im_preedit_draw_fr_t frame;
             memset(&frame, 0, sizeof(xcb_im_preedit_draw_fr_t));
             frame.caret = 0;
@@ -434,12 +580,9 @@ protected:
             xcb_im_preedit_done_callback(server_->im(), xic_);
             preeditStarted = false;
             lastPreeditLength_ = 0;
+            lastPreedit_.clear();
         }
 
-        if (!strPreedit.empty() && !preeditStarted) {
-            xcb_im_preedit_start_callback(server_->im(), xic_);
-            preeditStarted = true;
-        }
         if (!strPreedit.empty()) {
             size_t utf8Length = utf8::length(strPreedit);
             if (utf8Length == utf8::INVALID_LENGTH) {
@@ -464,14 +607,27 @@ protected:
             }
             feedbackBuffer_.push_back(0);
 
-            xcb_im_preedit_draw_fr_t frame;
-            memset(&frame, 0, sizeof(xcb_im_preedit_draw_fr_t));
+            uint32_t caret = 0;
             if (text.cursor() >= 0 &&
                 static_cast<size_t>(text.cursor()) <= strPreedit.size()) {
-                frame.caret =
+                caret =
                     utf8::length(strPreedit.begin(),
                                  std::next(strPreedit.begin(), text.cursor()));
             }
+            // Nothing changed since the last draw.
+            if (preeditStarted && strPreedit == lastPreedit_ &&
+                caret == lastCaret_ && feedbackBuffer_ == lastFeedback_) {
+                return;
+            }
+
+            applySyncMode();
+            if (!preeditStarted) {
+                xcb_im_preedit_start_callback(server_->im(), xic_);
+                preeditStarted = true;
+            }
+            xcb_im_preedit_draw_fr_t frame;
+            memset(&frame, 0, sizeof(xcb_im_preedit_draw_fr_t));
+            frame.caret = caret;
             UniqueCPtr<char> compoundText;
             frame.chg_first = 0;
             frame.chg_length = lastPreeditLength_;
@@ -496,6 +652,9 @@ protected:
             frame.status = frame.feedback_array.size ? 0 : 2;
             lastPreeditLength_ = utf8Length;
             xcb_im_preedit_draw_callback(server_->im(), xic_, &frame);
+            lastPreedit_ = std::move(strPreedit);
+            lastCaret_ = caret;
+            lastFeedback_.swap(feedbackBuffer_);
         }
     }
 
@@ -503,8 +662,14 @@ private:
     XIMServer *server_;
     xcb_im_input_context_t *xic_;
     const bool useUtf8_ = false;
+    bool useSyncMode_ = false;
     bool preeditStarted = false;
     int lastPreeditLength_ = 0;
+    bool preeditDirty_ = false;
+    std::unique_ptr<EventSource> preeditEvent_;
+    std::string lastPreedit_;
+    uint32_t lastCaret_ = 0;
+    std::vector<uint32_t> lastFeedback_;
     std::vector<uint32_t> feedbackBuffer_;
     bool lastIsRelease_ = false;
     unsigned int lastTime_ = 0;
@@ -546,6 +711,7 @@ void XIMServer::callback(xcb_im_client_t *client, xcb_im_input_context_t *xic,
         if (!ic) {
             return;
         }
+        ic->applySyncMode();
     }
 
     switch (hdr->major_opcode) {
@@ -555,8 +721,9 @@ void XIMServer::callback(xcb_im_client_t *client, xcb_im_input_context_t *xic,
             entry && *entry) {
             useUtf8 = true;
         }
-        new XIMInputContext(parent_->instance()->inputContextManager(), this,
-                            xic, useUtf8);
+        ic = new XIMInputContext(parent_->instance()->inputContextManager(),
+                                 this, xic, useUtf8);
+        ic->applySyncMode();
     } break;
     case XCB_XIM_DESTROY_IC:
         delete ic;
@@ -604,6 +771,7 @@ void XIMServer::callback(xcb_im_client_t *client, xcb_im_input_context_t *xic,
             InputContextEventBlocker blocker(ic);
             result = ic->keyEvent(event);
         }
+        ic->flushPreedit();
         if (!result) {
             xcb_im_forward_event(im(), xic, xevent);
         }
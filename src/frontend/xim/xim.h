@@ -7,7 +7,9 @@
 #ifndef _FCITX_FRONTEND_XIM_XIM_H_
 #define _FCITX_FRONTEND_XIM_XIM_H_
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 #include <xcb-imdkit/imdkit.h>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/i18n.h"
@@ -21,10 +23,15 @@ namespace fcitx {
 
 class XIMServer;
 
-FCITX_CONFIGURATION(XIMConfig,
-                    Option<bool> useOnTheSpot{
-                        this, "UseOnTheSpot",
-                        _("Use On The Spot Style (Needs restarting)"), false};);
+FCITX_CONFIGURATION(
+    XIMConfig,
+    Option<bool> useOnTheSpot{this, "UseOnTheSpot",
+                              _("Use On The Spot Style (Needs restarting)"),
+                              false};
+    Option<std::vector<std::string>> syncModePrograms{
+        this, "SyncModePrograms",
+        _("Programs that need synchronous key forwarding"),
+        {}};);
 
 class XIMModule : public AddonInstance {
 public:
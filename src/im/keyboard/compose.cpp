@@ -6,6 +6,8 @@
  */
 
 #include "compose.h"
+#include <iterator>
+#include <utility>
 #include <fcitx-utils/utf8.h>
 
 namespace fcitx {
@@ -80,9 +82,50 @@ void appendDeadKey(std::string &string, KeySym keysym) {
     }
 }
 
+void appendPreedit(std::string &string, KeySym keysym) {
+    if (keysym == FcitxKey_Multi_key) {
+        string.append("·");
+    } else if (isDeadKey(keysym)) {
+        appendDeadKey(string, keysym);
+    } else {
+        string.append(Key::keySymToUTF8(keysym));
+    }
+}
+
 ComposeState::ComposeState(Instance *instance, InputContext *inputContext)
     : instance_(instance), inputContext_(inputContext) {}
 
+void ComposeState::push(KeySym sym) {
+    if (!composeBuffer_.empty()) {
+        appendPreedit(preeditTail_, sym);
+    }
+    if (numDeadPrefix_ == composeBuffer_.size() && isDeadKey(sym)) {
+        numDeadPrefix_ += 1;
+    }
+    composeBuffer_.push_back(sym);
+}
+
+void ComposeState::popBack() {
+    composeBuffer_.pop_back();
+    // Only happens to the key just pushed, rebuilding is cheap.
+    preeditTail_.clear();
+    numDeadPrefix_ = 0;
+    for (size_t i = 0; i < composeBuffer_.size(); i++) {
+        if (i > 0) {
+            appendPreedit(preeditTail_, composeBuffer_[i]);
+        }
+        if (numDeadPrefix_ == i && isDeadKey(composeBuffer_[i])) {
+            numDeadPrefix_ += 1;
+        }
+    }
+}
+
+void ComposeState::clearBuffer() {
+    composeBuffer_.clear();
+    preeditTail_.clear();
+    numDeadPrefix_ = 0;
+}
+
 std::tuple<std::string, bool> ComposeState::type(KeySym sym) {
     std::string result;
     bool consumeKey = typeImpl(sym, result);
@@ -97,7 +140,7 @@ bool ComposeState::typeImpl(KeySym sym, std::string &result) {
         wasComposing = false;
     }
 
-    composeBuffer_.push_back(sym);
+    push(sym);
     // check compose first.
     auto composeResult = instance_->processComposeString(inputContext_, sym);
     if (!composeResult) {
@@ -109,20 +152,13 @@ bool ComposeState::typeImpl(KeySym sym, std::string &result) {
         // ignore this.
         if (!wasComposing) {
             assert(composeBuffer_.size() == 1);
-            composeBuffer_.clear();
+            clearBuffer();
             return false;
         }
         assert(composeBuffer_.size() > 1);
 
         // Check for dead key prefix.
-        size_t numDeadPrefix = 0;
-        for (auto sym : composeBuffer_) {
-            if (isDeadKey(sym)) {
-                numDeadPrefix += 1;
-            } else {
-                break;
-            }
-        }
+        const size_t numDeadPrefix = numDeadPrefix_;
         if (composeBuffer_.size() > 1 &&
             numDeadPrefix >= composeBuffer_.size() - 1) {
             // If compose sequence ends with a non dead key.
@@ -139,10 +175,8 @@ bool ComposeState::typeImpl(KeySym sym, std::string &result) {
             // If everything is dead key, commit the first dead key.
             appendDeadKey(result, composeBuffer_[0]);
             // Then backtrack.
-            composeBuffer_.pop_front();
-            std::deque<KeySym> buffer;
-            using std::swap;
-            swap(buffer, composeBuffer_);
+            std::vector<KeySym> buffer(std::next(composeBuffer_.begin()),
+                                       composeBuffer_.end());
             reset();
             bool consumed = false;
             for (auto iter = buffer.begin(), end = buffer.end(); iter != end;
@@ -164,7 +198,7 @@ bool ComposeState::typeImpl(KeySym sym, std::string &result) {
     // Empty string but composing, means ignored
     if (instance_->isComposing(inputContext_)) {
         // Do not push feed ignore key into compose buffer.
-        composeBuffer_.pop_back();
+        popBack();
         return false;
     }
 
@@ -179,21 +213,17 @@ bool ComposeState::typeImpl(KeySym sym, std::string &result) {
 }
 
 std::string ComposeState::preedit() const {
+    if (composeBuffer_.empty()) {
+        return {};
+    }
     std::string result;
-    for (size_t i = 0, e = composeBuffer_.size(); i < e; i++) {
-        if (composeBuffer_[i] == FcitxKey_Multi_key) {
-            if (e == 1 || i > 0 ||
-                (i + 1 < e && composeBuffer_[i + 1] == FcitxKey_Multi_key)) {
-                result.append("·");
-            }
-        } else {
-            if (isDeadKey(composeBuffer_[i])) {
-                appendDeadKey(result, composeBuffer_[i]);
-            } else {
-                result.append(Key::keySymToUTF8(composeBuffer_[i]));
-            }
-        }
+    // A leading Multi_key is only shown alone or before another Multi_key.
+    if (composeBuffer_[0] != FcitxKey_Multi_key ||
+        composeBuffer_.size() == 1 ||
+        composeBuffer_[1] == FcitxKey_Multi_key) {
+        appendPreedit(result, composeBuffer_[0]);
     }
+    result.append(preeditTail_);
     return result;
 }
 
@@ -201,9 +231,7 @@ void ComposeState::backspace() {
     if (composeBuffer_.empty()) {
         return;
     }
-    std::deque<KeySym> buffer;
-    using std::swap;
-    swap(buffer, composeBuffer_);
+    auto buffer = std::move(composeBuffer_);
     reset();
     buffer.pop_back();
     for (auto sym : buffer) {
@@ -213,7 +241,7 @@ void ComposeState::backspace() {
 
 void ComposeState::reset() {
     instance_->resetCompose(inputContext_);
-    composeBuffer_.clear();
+    clearBuffer();
 }
 
 } // namespace fcitx
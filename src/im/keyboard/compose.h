@@ -7,7 +7,8 @@
 #ifndef _FCITX_IM_KEYBOARD_COMPOSE_H_
 #define _FCITX_IM_KEYBOARD_COMPOSE_H_
 
-#include <deque>
+#include <string>
+#include <vector>
 #include <fcitx/instance.h>
 
 namespace fcitx {
@@ -22,9 +23,18 @@ public:
 
 private:
     bool typeImpl(KeySym sym, std::string &result);
+    void push(KeySym sym);
+    void popBack();
+    void clearBuffer();
+
     Instance *instance_;
     InputContext *inputContext_;
-    std::deque<KeySym> composeBuffer_;
+    std::vector<KeySym> composeBuffer_;
+    // Preedit of composeBuffer_ but the first key, whose text depends on the
+    // key after it. It is appended as keys are pushed.
+    std::string preeditTail_;
+    // Number of dead keys at the beginning of composeBuffer_.
+    size_t numDeadPrefix_ = 0;
 };
 } // namespace fcitx
 
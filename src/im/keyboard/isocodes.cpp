@@ -6,9 +6,12 @@
  */
 
 #include "isocodes.h"
+#include <algorithm>
 #include <cstring>
+#include <utility>
 #include <json-c/json.h>
 #include "fcitx-utils/metastring.h"
+#include "fcitx-utils/misc.h"
 
 namespace fcitx {
 
@@ -39,7 +42,7 @@ public:
 class IsoCodes639Parser
     : public IsoCodesJsonParser<fcitxMakeMetaString("639-3")> {
 public:
-    IsoCodes639Parser(IsoCodes *that) : that_(that) {}
+    IsoCodes639Parser(const IsoCodes *that) : that_(that) {}
 
     void handle(json_object *entry) override {
         json_object *alpha2 = json_object_object_get(entry, "alpha_2");
@@ -81,26 +84,18 @@ public:
                                  json_object_get_string_len(alpha3));
         if ((!e.iso_639_2B_code.empty() || !e.iso_639_2T_code.empty()) &&
             !e.name.empty()) {
-            that_->iso639entires.emplace_back(e);
-            if (!e.iso_639_2B_code.empty()) {
-                that_->iso6392B.emplace(e.iso_639_2B_code,
-                                        that_->iso639entires.size() - 1);
-            }
-            if (!e.iso_639_2T_code.empty()) {
-                that_->iso6392T.emplace(e.iso_639_2T_code,
-                                        that_->iso639entires.size() - 1);
-            }
+            that_->iso639entires.emplace_back(std::move(e));
         }
     }
 
 private:
-    IsoCodes *that_;
+    const IsoCodes *that_;
 };
 
 class IsoCodes3166Parser
     : public IsoCodesJsonParser<fcitxMakeMetaString("3166-1")> {
 public:
-    IsoCodes3166Parser(IsoCodes *that) : that_(that) {}
+    IsoCodes3166Parser(const IsoCodes *that) : that_(that) {}
 
     void handle(json_object *entry) override {
         json_object *alpha2 = json_object_object_get(entry, "alpha_2");
@@ -123,13 +118,87 @@ public:
     }
 
 private:
-    IsoCodes *that_;
+    const IsoCodes *that_;
 };
 
-void IsoCodes::read(const std::string &iso639, const std::string &iso3166) {
+void IsoCodes::read(const std::string &iso639File,
+                    const std::string &iso3166File) {
+    iso639File_ = iso639File;
+    iso3166File_ = iso3166File;
+    iso639Loaded_ = false;
+    iso3166Loaded_ = false;
+    iso639entires.clear();
+    iso6392B.clear();
+    iso6392T.clear();
+    iso3166.clear();
+}
+
+void IsoCodes::load639() const {
+    if (iso639Loaded_) {
+        return;
+    }
+    iso639Loaded_ = true;
     IsoCodes639Parser parser639(this);
-    parser639.parse(iso639);
+    parser639.parse(iso639File_);
+    iso639entires.shrink_to_fit();
+
+    auto buildIndex = [this](std::vector<uint32_t> &index,
+                             std::string IsoCodes639Entry::*code) {
+        for (uint32_t i = 0; i < iso639entires.size(); i++) {
+            if (!(iso639entires[i].*code).empty()) {
+                index.push_back(i);
+            }
+        }
+        std::stable_sort(index.begin(), index.end(),
+                         [this, code](uint32_t lhs, uint32_t rhs) {
+                             return iso639entires[lhs].*code <
+                                    iso639entires[rhs].*code;
+                         });
+    };
+    buildIndex(iso6392B, &IsoCodes639Entry::iso_639_2B_code);
+    buildIndex(iso6392T, &IsoCodes639Entry::iso_639_2T_code);
+}
+
+void IsoCodes::load3166() const {
+    if (iso3166Loaded_) {
+        return;
+    }
+    iso3166Loaded_ = true;
     IsoCodes3166Parser parser3166(this);
-    parser3166.parse(iso3166);
+    parser3166.parse(iso3166File_);
+}
+
+const IsoCodes639Entry *
+IsoCodes::find639(const std::vector<uint32_t> &index,
+                  std::string IsoCodes639Entry::*code,
+                  const std::string &name) const {
+    auto iter = std::lower_bound(
+        index.begin(), index.end(), name,
+        [this, code](uint32_t i, const std::string &value) {
+            return iso639entires[i].*code < value;
+        });
+    if (iter == index.end() || iso639entires[*iter].*code != name) {
+        return nullptr;
+    }
+    return &iso639entires[*iter];
+}
+
+const IsoCodes639Entry *IsoCodes::entry(const std::string &name) const {
+    load639();
+    const auto *entry =
+        find639(iso6392B, &IsoCodes639Entry::iso_639_2B_code, name);
+    if (!entry) {
+        entry = find639(iso6392T, &IsoCodes639Entry::iso_639_2T_code, name);
+    }
+    return entry;
+}
+
+const std::string *IsoCodes::country(const std::string &alpha2) const {
+    load3166();
+    auto iter = iso3166.find(alpha2);
+    if (iter == iso3166.end()) {
+        return nullptr;
+    }
+    return &iter->second;
 }
 } // namespace fcitx
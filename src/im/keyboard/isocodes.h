@@ -7,10 +7,10 @@
 #ifndef _FCITX_IM_KEYBOARD_ISOCODES_H_
 #define _FCITX_IM_KEYBOARD_ISOCODES_H_
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include "fcitx/misc_p.h"
 
 namespace fcitx {
 
@@ -26,25 +26,32 @@ class IsoCodes {
     friend class IsoCodes3166Parser;
 
 public:
-    void read(const std::string &iso639, const std::string &iso3166);
-
-    const IsoCodes639Entry *entry(const std::string &name) const {
-        const auto *entry = findValue(iso6392B, name);
-        if (!entry) {
-            entry = findValue(iso6392T, name);
-        }
-        if (!entry) {
-            return nullptr;
-        }
-        return &iso639entires[*entry];
-    }
+    // Files are only parsed when they are needed for the first time.
+    void read(const std::string &iso639File, const std::string &iso3166File);
 
-private:
-    std::vector<IsoCodes639Entry> iso639entires;
-    std::unordered_map<std::string, int> iso6392B;
-    std::unordered_map<std::string, int> iso6392T;
+    const IsoCodes639Entry *entry(const std::string &name) const;
+    const std::string *country(const std::string &alpha2) const;
 
-    std::unordered_map<std::string, std::string> iso3166;
+private:
+    void load639() const;
+    void load3166() const;
+    const IsoCodes639Entry *
+    find639(const std::vector<uint32_t> &index,
+            std::string IsoCodes639Entry::*code,
+            const std::string &name) const;
+
+    std::string iso639File_;
+    std::string iso3166File_;
+    mutable bool iso639Loaded_ = false;
+    mutable bool iso3166Loaded_ = false;
+
+    mutable std::vector<IsoCodes639Entry> iso639entires;
+    // Indexes of iso639entires sorted by the code, entries with the same code
+    // are in the order of the file.
+    mutable std::vector<uint32_t> iso6392B;
+    mutable std::vector<uint32_t> iso6392T;
+
+    mutable std::unordered_map<std::string, std::string> iso3166;
 };
 } // namespace fcitx
 
@@ -7,10 +7,13 @@
 
 #include "keyboard.h"
 #include <algorithm>
+#include <cstdlib>
+#include <memory>
 #include <fmt/format.h>
 #include <xkbcommon/xkbcommon.h>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/i18n.h"
+#include "fcitx-utils/standardpath.h"
 #include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/utf8.h"
 #include "fcitx/inputcontextmanager.h"
@@ -35,6 +38,9 @@
 
 const char imNamePrefix[] = "keyboard-";
 #define FCITX_KEYBOARD_MAX_BUFFER 20
+constexpr size_t QuickPhraseEmojiLimit = 32;
+// Delay of hint lookup in microseconds, keys typed within it are merged.
+constexpr uint64_t HintLookupDelay = 20000;
 
 namespace fcitx {
 
@@ -193,14 +199,76 @@ KeyboardEngine::KeyboardEngine(Instance *instance) : instance_(instance) {
     if (directories.empty()) {
         directories.push_back(XKEYBOARDCONFIG_XKBBASE);
     }
-    if (!xkbRules_.read(directories, ruleName, extraRuleFile)) {
-        xkbRules_.read(directories, DEFAULT_XKB_RULES, "");
+
+    // Parsing the rules and the iso codes is slow, so both the rules and the
+    // input method list are kept in a snapshot.
+    snapshot_ = std::make_unique<MetadataSnapshot>("keyboard",
+                                                   StandardPath::global());
+    snapshot_->addKey(ruleName);
+    for (const auto &directory : directories) {
+        for (const auto &name : {ruleName, std::string(DEFAULT_XKB_RULES)}) {
+            snapshot_->addDependency(stringutils::joinPath(
+                directory, "rules", stringutils::concat(name, ".xml")));
+            snapshot_->addDependency(stringutils::joinPath(
+                directory, "rules", stringutils::concat(name, ".extras.xml")));
+        }
+    }
+    if (!extraRuleFile.empty()) {
+        snapshot_->addDependency(extraRuleFile);
+    }
+    snapshot_->addDependency(ISOCODES_ISO639_JSON);
+    // Descriptions are translated.
+    for (const char *env : {"LANGUAGE", "LC_ALL", "LC_MESSAGES", "LANG"}) {
+        const char *value = getenv(env);
+        snapshot_->addKey(value ? value : "");
+    }
+    if (!snapshot_->load([this](MetadataSnapshot::Reader &reader) {
+            uint32_t size;
+            if (!xkbRules_.load(reader) || !reader.readSize(size)) {
+                return false;
+            }
+            snapshotInputMethods_.resize(size);
+            for (auto &item : snapshotInputMethods_) {
+                if (!reader.read(item.uniqueName) || !reader.read(item.name) ||
+                    !reader.read(item.languageCode) ||
+                    !reader.read(item.label)) {
+                    return false;
+                }
+            }
+            return true;
+        })) {
+        snapshotInputMethods_.clear();
+        if (!xkbRules_.read(directories, ruleName, extraRuleFile)) {
+            xkbRules_.read(directories, DEFAULT_XKB_RULES, "");
+        }
     }
 
     instance_->inputContextManager().registerProperty("keyboardState",
                                                       &factory_);
+    // Only the state derived from a changed option is updated.
+    configWatcher_ =
+        config_.watchOptionChanged([this](const OptionBase &option) {
+            if (&option == &config_.chooseModifier) {
+                updateSelectionKeys();
+            } else if (&option == &config_.blocklistApplicationForLongPress) {
+                updateLongPressBlocklist();
+            }
+        });
     reloadConfig();
 
+    // Load the spell dictionary and emoji of the language, so the first hint
+    // after switching is not delayed.
+    setPrewarmCallback([this](const InputMethodEntry &entry) {
+        if (!*config_.enableHintByDefault ||
+            !supportHint(entry.languageCode())) {
+            return;
+        }
+        if (auto *spell = this->spell()) {
+            spell->call<ISpell::hintForDisplay>(
+                entry.languageCode(), SpellProvider::Default, "a", 1);
+        }
+    });
+
     deferEvent_ = instance_->eventLoop().addDeferEvent([this](EventSource *) {
         initQuickPhrase();
         deferEvent_.reset();
@@ -210,11 +278,48 @@ KeyboardEngine::KeyboardEngine(Instance *instance) : instance_(instance) {
 
 KeyboardEngine::~KeyboardEngine() {}
 
+InputMethodEntry KeyboardEngine::SnapshotInputMethod::toEntry() const {
+    return std::move(
+        InputMethodEntry(uniqueName, name, languageCode, "keyboard")
+            .setLabel(label)
+            .setIcon("input-keyboard")
+            .setConfigurable(true));
+}
+
+std::optional<InputMethodEntry>
+KeyboardEngine::lookupInputMethodImpl(const std::string &uniqueName) {
+    if (!stringutils::startsWith(uniqueName, imNamePrefix)) {
+        return std::nullopt;
+    }
+    // Without a snapshot, building the full list also saves one.
+    if (snapshotInputMethods_.empty()) {
+        for (auto &entry : listInputMethods()) {
+            if (entry.uniqueName() == uniqueName) {
+                return std::move(entry);
+            }
+        }
+        return std::nullopt;
+    }
+    for (const auto &item : snapshotInputMethods_) {
+        if (item.uniqueName == uniqueName) {
+            return item.toEntry();
+        }
+    }
+    return std::nullopt;
+}
+
 std::vector<InputMethodEntry> KeyboardEngine::listInputMethods() {
+    std::vector<InputMethodEntry> result;
+    if (!snapshotInputMethods_.empty()) {
+        for (const auto &item : snapshotInputMethods_) {
+            result.push_back(item.toEntry());
+        }
+        return result;
+    }
+
     IsoCodes isoCodes;
     isoCodes.read(ISOCODES_ISO639_JSON, ISOCODES_ISO3166_JSON);
 
-    std::vector<InputMethodEntry> result;
     bool usExists = false;
     for (const auto &p : xkbRules_.layoutInfos()) {
         const auto &layoutInfo = p.second;
@@ -265,7 +370,8 @@ std::vector<InputMethodEntry> KeyboardEngine::listInputMethods() {
         }
     }
 
-    if (result.empty()) {
+    const bool hasLayouts = !result.empty();
+    if (!hasLayouts) {
         RawConfig config;
         readAsIni(config, "conf/cached_layouts");
         for (auto &uniqueName : config.subItems()) {
@@ -310,11 +416,37 @@ std::vector<InputMethodEntry> KeyboardEngine::listInputMethods() {
                 .setIcon("input-keyboard")
                 .setConfigurable(true)));
     }
+    if (!hasLayouts) {
+        return result;
+    }
+
+    for (const auto &entry : result) {
+        snapshotInputMethods_.push_back({entry.uniqueName(), entry.name(),
+                                         entry.languageCode(), entry.label()});
+    }
+    snapshot_->save([this](MetadataSnapshot::Writer &writer) {
+        xkbRules_.save(writer);
+        writer.write(snapshotInputMethods_.size());
+        for (const auto &item : snapshotInputMethods_) {
+            writer.write(item.uniqueName);
+            writer.write(item.name);
+            writer.write(item.languageCode);
+            writer.write(item.label);
+        }
+    });
     return result;
 }
 
 void KeyboardEngine::reloadConfig() {
     readAsIni(config_, "conf/keyboard.conf");
+    updateSelectionKeys();
+    updateLongPressBlocklist();
+
+    readAsIni(longPressConfig_, "conf/keyboard-longpress.conf");
+    longPressData_ = LongPressData(longPressConfig_);
+}
+
+void KeyboardEngine::updateSelectionKeys() {
     selectionKeys_.clear();
     KeySym syms[] = {
         FcitxKey_1, FcitxKey_2, FcitxKey_3, FcitxKey_4, FcitxKey_5,
@@ -339,12 +471,12 @@ void KeyboardEngine::reloadConfig() {
     for (auto sym : syms) {
         selectionKeys_.emplace_back(sym, selectionModifier_);
     }
+}
+
+void KeyboardEngine::updateLongPressBlocklist() {
     longPressBlocklistSet_ = decltype(longPressBlocklistSet_)(
         config_.blocklistApplicationForLongPress->begin(),
         config_.blocklistApplicationForLongPress->end());
-
-    readAsIni(longPressConfig_, "conf/keyboard-longpress.conf");
-    longPressData_ = loadLongPressData(longPressConfig_);
 }
 
 static inline bool isValidSym(const Key &key) {
@@ -428,6 +560,9 @@ void KeyboardEngine::keyEvent(const InputMethodEntry &entry, KeyEvent &event) {
     // Shift/Alt are ignored because of normalize does not always remove shift.
     if (event.key().states().testAny(
             KeyStates{KeyState::Ctrl, KeyState::Super})) {
+        if (state->buffer_.empty()) {
+            inputContext->setKeyRepeatPassThrough(true);
+        }
         return;
     }
 
@@ -460,6 +595,12 @@ void KeyboardEngine::keyEvent(const InputMethodEntry &entry, KeyEvent &event) {
         return event.filterAndAccept();
     }
 
+    // Nothing is changed if there is no buffer, and the repeat of the key
+    // would end up here as well.
+    if (compose.empty() && state->buffer_.empty()) {
+        inputContext->setKeyRepeatPassThrough(true);
+    }
+
     // if we reach here, just commit and discard buffer.
     state->commitBuffer();
     inputContext->inputPanel().reset();
@@ -497,16 +638,57 @@ void KeyboardEngineState::setPreedit() {
 }
 
 void KeyboardEngineState::updateCandidate(const InputMethodEntry &entry) {
+    candidatePending_ = true;
+    candidateLanguage_ = entry.languageCode();
+    // Candidates on screen are stale until the lookup is done, make sure the
+    // preedit does not follow them.
+    if (auto candidateList = inputContext_->inputPanel().candidateList()) {
+        if (auto *bulkCursor = candidateList->toBulkCursor()) {
+            bulkCursor->setGlobalCursorIndex(-1);
+        }
+    }
+    if (candidateEvent_) {
+        candidateEvent_->setNextInterval(HintLookupDelay);
+        candidateEvent_->setOneShot();
+        return;
+    }
+    candidateEvent_ = engine_->instance()->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + HintLookupDelay, 0,
+        [this](EventSourceTime *, uint64_t) {
+            if (candidatePending_) {
+                flushCandidate();
+                setPreedit();
+            }
+            return true;
+        });
+}
+
+void KeyboardEngineState::flushCandidate() {
+    if (!candidatePending_) {
+        return;
+    }
+    candidatePending_ = false;
+    if (candidateEvent_) {
+        candidateEvent_->setEnabled(false);
+    }
+    // The buffer may be committed or reset since the lookup is scheduled.
+    if (buffer_.empty() || mode_ != CandidateMode::Hint) {
+        return;
+    }
+    lookupCandidate(candidateLanguage_);
+}
+
+void KeyboardEngineState::lookupCandidate(const std::string &language) {
     inputContext_->inputPanel().reset();
     std::vector<std::pair<std::string, std::string>> results;
     if (auto spell = engine_->spell()) {
         results = spell->call<ISpell::hintForDisplay>(
-            entry.languageCode(), SpellProvider::Default, buffer_.userInput(),
+            language, SpellProvider::Default, buffer_.userInput(),
             engine_->config().pageSize.value());
     }
     if (engine_->config().enableEmoji.value() && engine_->emoji()) {
         auto emojiResults = engine_->emoji()->call<IEmoji::query>(
-            entry.languageCode(), buffer_.userInput(), true);
+            language, buffer_.userInput(), true);
         // If we have emoji result and spell result is full, pop one from the
         // original result, because emoji matching is always exact. Which means
         // the spell is right.
@@ -572,6 +754,21 @@ void KeyboardEngine::invokeActionImpl(const InputMethodEntry &,
     state->commitBuffer();
 }
 
+void KeyboardEngine::virtualKeyboardEventImpl(const InputMethodEntry &entry,
+                                              VirtualKeyboardEvent &event) {
+    // Same as the engines without virtual keyboard support.
+    auto keyEvent = event.toKeyEvent();
+    if (!keyEvent) {
+        return;
+    }
+    this->keyEvent(entry, *keyEvent);
+    if (keyEvent->accepted()) {
+        event.accept();
+    } else if (!event.text().empty()) {
+        event.inputContext()->commitString(event.text());
+    }
+}
+
 bool KeyboardEngine::foreachLayout(
     const std::function<
         bool(const std::string &variant, const std::string &description,
@@ -613,13 +810,15 @@ void KeyboardEngine::initQuickPhrase() {
                 return true;
             }
             std::set<std::string> result;
-            emoji()->call<IEmoji::prefix>(
-                im->languageCode(), input, true,
+            // Results come with the shortest annotation first, so it is safe
+            // to stop at the first one that is too long.
+            emoji()->call<IEmoji::search>(
+                im->languageCode(), input, true, QuickPhraseEmojiLimit, false,
                 [&result, inputSize = input.size()](
                     const std::string &key,
                     const std::vector<std::string> &values) {
                     if (inputSize + 1 < key.size()) {
-                        return true;
+                        return false;
                     }
                     result.insert(values.begin(), values.end());
                     return true;
@@ -645,7 +844,7 @@ void KeyboardEngine::setSubConfig(const std::string &path,
     if (path == "longpress") {
         longPressConfig_.load(config, true);
         safeSaveAsIni(longPressConfig_, "conf/keyboard-longpress.conf");
-        reloadConfig();
+        longPressData_ = LongPressData(longPressConfig_);
     }
 }
 
@@ -680,19 +879,21 @@ void KeyboardEngineState::showHintNotification(
 
 bool KeyboardEngineState::handleLongPress(const KeyEvent &event) {
     auto *inputContext = event.inputContext();
-    auto keystr = Key::keySymToUTF8(event.key().sym());
     if (!event.key().states() &&
         event.rawKey().states().test(KeyState::Repeat) &&
         *engine_->config().enableLongPress &&
         !engine_->isBlockedForLongPress(inputContext->program())) {
-        if (auto results = findValue(engine_->longPressData(), keystr)) {
+        const auto &data = engine_->longPressData();
+        auto chr = Key::keySymToUnicode(event.key().sym());
+        auto [begin, end] = data.find(chr);
+        if (utf8::UCS4IsValid(chr) && begin != end) {
             if (repeatStarted_) {
                 return true;
             }
             repeatStarted_ = true;
 
             mode_ = CandidateMode::LongPress;
-            origKeyString_ = std::move(keystr);
+            origKeyString_ = utf8::UCS4ToUTF8(chr);
             if (buffer_.empty()) {
                 if (inputContext->capabilityFlags().test(
                         CapabilityFlag::SurroundingText)) {
@@ -706,12 +907,11 @@ bool KeyboardEngineState::handleLongPress(const KeyEvent &event) {
 
             inputContext->inputPanel().reset();
             auto candidateList = std::make_unique<CommonCandidateList>();
-            int i = 1;
-            for (const auto &result : *results) {
-                candidateList->append<LongPressCandidateWord>(engine_, result,
-                                                              i++);
+            for (auto i = begin; i < end; i++) {
+                candidateList->append<LongPressCandidateWord>(
+                    engine_, std::string(data.candidate(i)), i - begin + 1);
             }
-            candidateList->setPageSize(results->size());
+            candidateList->setPageSize(end - begin);
             candidateList->setCursorIncludeUnselected(true);
             inputContext->inputPanel().setCandidateList(
                 std::move(candidateList));
@@ -753,6 +953,12 @@ bool KeyboardEngineState::handleSpellModeTrigger(const InputMethodEntry &entry,
 }
 
 bool KeyboardEngineState::handleCandidateSelection(const KeyEvent &event) {
+    if (candidatePending_ &&
+        (event.key().digitSelection(engine_->selectionModifier()) >= 0 ||
+         event.key().checkKeyList(*engine_->config().nextCandidate) ||
+         event.key().checkKeyList(*engine_->config().prevCandidate))) {
+        flushCandidate();
+    }
     // check if we can select candidate.
     auto candList = inputContext_->inputPanel().candidateList();
     if (!candList) {
@@ -793,6 +999,10 @@ void KeyboardEngineState::reset(bool resetCompose) {
     mode_ = CandidateMode::Hint;
     repeatStarted_ = false;
     oneTimeEnableWordHint_ = false;
+    candidatePending_ = false;
+    if (candidateEvent_) {
+        candidateEvent_->setEnabled(false);
+    }
     if (resetCompose) {
         compose_.reset();
         engine_->instance()->resetCompose(inputContext_);
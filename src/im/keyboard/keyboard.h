@@ -17,6 +17,7 @@
 #include "fcitx/inputcontextproperty.h"
 #include "fcitx/inputmethodengine.h"
 #include "fcitx/instance.h"
+#include "fcitx/metadatasnapshot_p.h"
 #include "compose.h"
 #include "isocodes.h"
 #include "keyboard_public.h"
@@ -102,6 +103,9 @@ struct KeyboardEngineState : public InputContextProperty {
     std::string origKeyString_;
     bool repeatStarted_ = false;
     ComposeState compose_;
+    std::unique_ptr<EventSourceTime> candidateEvent_;
+    bool candidatePending_ = false;
+    std::string candidateLanguage_;
 
     bool hintEnabled() const {
         return enableWordHint_ || oneTimeEnableWordHint_;
@@ -123,7 +127,12 @@ struct KeyboardEngineState : public InputContextProperty {
     std::string currentSelection() const;
     void showHintNotification(const InputMethodEntry &entry) const;
 
+    // Schedule a hint lookup for the current buffer, consecutive keys within
+    // a short delay only cause one lookup.
     void updateCandidate(const InputMethodEntry &entry);
+    // Run the scheduled hint lookup now, if there is one.
+    void flushCandidate();
+    void lookupCandidate(const std::string &language);
     // Update preedit and send ui update.
     void setPreedit();
 
@@ -133,13 +142,15 @@ struct KeyboardEngineState : public InputContextProperty {
     bool updateBuffer(std::string_view chr);
 };
 
-class KeyboardEngine final : public InputMethodEngineV3 {
+class KeyboardEngine final : public InputMethodEngineV5 {
 public:
     KeyboardEngine(Instance *instance);
     ~KeyboardEngine();
     Instance *instance() { return instance_; }
     void keyEvent(const InputMethodEntry &entry, KeyEvent &keyEvent) override;
     std::vector<InputMethodEntry> listInputMethods() override;
+    std::optional<InputMethodEntry>
+    lookupInputMethodImpl(const std::string &uniqueName) override;
     void reloadConfig() override;
 
     const KeyboardEngineConfig &config() { return config_; }
@@ -147,7 +158,6 @@ public:
     void setConfig(const RawConfig &config) override {
         config_.load(config, true);
         safeSaveAsIni(config_, "conf/keyboard.conf");
-        reloadConfig();
     }
 
     const Configuration *getSubConfig(const std::string &path) const override;
@@ -161,6 +171,8 @@ public:
 
     void invokeActionImpl(const fcitx::InputMethodEntry &entry,
                           fcitx::InvokeActionEvent &event) override;
+    void virtualKeyboardEventImpl(const InputMethodEntry &entry,
+                                  VirtualKeyboardEvent &event) override;
 
     void resetState(InputContext *inputContext);
 
@@ -194,12 +206,27 @@ private:
     FCITX_ADDON_EXPORT_FUNCTION(KeyboardEngine, foreachVariant);
 
     void initQuickPhrase();
+    // Update the state derived from config_.
+    void updateSelectionKeys();
+    void updateLongPressBlocklist();
 
     Instance *instance_;
     KeyboardEngineConfig config_;
+    std::unique_ptr<HandlerTableEntry<OptionChangedCallback>> configWatcher_;
     LongPressConfig longPressConfig_;
-    std::unordered_map<std::string, std::vector<std::string>> longPressData_;
+    LongPressData longPressData_;
     XkbRules xkbRules_;
+    struct SnapshotInputMethod {
+        std::string uniqueName;
+        std::string name;
+        std::string languageCode;
+        std::string label;
+
+        InputMethodEntry toEntry() const;
+    };
+    std::unique_ptr<MetadataSnapshot> snapshot_;
+    // Input method list from snapshot, empty if not available.
+    std::vector<SnapshotInputMethod> snapshotInputMethods_;
     KeyStates selectionModifier_;
     KeyList selectionKeys_;
     std::unique_ptr<EventSource> deferEvent_;
@@ -6,6 +6,9 @@
  *
  */
 #include "longpress.h"
+#include <algorithm>
+#include <iterator>
+#include "fcitx-utils/utf8.h"
 
 namespace fcitx {
 
@@ -143,16 +146,58 @@ void setupDefaultLongPressConfig(LongPressConfig &config) {
     config.syncDefaultValueToCurrent();
 }
 
-std::unordered_map<std::string, std::vector<std::string>>
-loadLongPressData(const LongPressConfig &config) {
-    std::unordered_map<std::string, std::vector<std::string>> result;
+LongPressData::LongPressData(const LongPressConfig &config) {
+    // Later entry of the same key replace the former one.
+    std::vector<std::pair<uint32_t, const LongPressEntryConfig *>> keys;
     for (const auto &entry : *config.entries) {
         if (!*entry.enable || entry.candidates->empty()) {
             continue;
         }
-        result[*entry.key] = *entry.candidates;
+        // Long press is triggered by a single key, so the key can only be
+        // one character.
+        if (utf8::lengthValidated(*entry.key) != 1) {
+            continue;
+        }
+        keys.emplace_back(utf8::getChar(*entry.key), &entry);
+    }
+    std::stable_sort(keys.begin(), keys.end(),
+                     [](const auto &lhs, const auto &rhs) {
+                         return lhs.first < rhs.first;
+                     });
+
+    offsets_.push_back(0);
+    for (auto iter = keys.begin(); iter != keys.end(); ++iter) {
+        auto next = std::next(iter);
+        if (next != keys.end() && next->first == iter->first) {
+            continue;
+        }
+        Entry entry{iter->first, static_cast<uint32_t>(offsets_.size() - 1),
+                    0};
+        for (const auto &candidate : *iter->second->candidates) {
+            pool_.append(candidate);
+            offsets_.push_back(pool_.size());
+        }
+        entry.end = offsets_.size() - 1;
+        entries_.push_back(entry);
+    }
+    entries_.shrink_to_fit();
+    offsets_.shrink_to_fit();
+    pool_.shrink_to_fit();
+}
+
+std::pair<size_t, size_t> LongPressData::find(uint32_t chr) const {
+    auto iter = std::lower_bound(
+        entries_.begin(), entries_.end(), chr,
+        [](const Entry &entry, uint32_t chr) { return entry.chr < chr; });
+    if (iter == entries_.end() || iter->chr != chr) {
+        return {0, 0};
     }
-    return result;
+    return {iter->begin, iter->end};
+}
+
+std::string_view LongPressData::candidate(size_t index) const {
+    return std::string_view(pool_).substr(
+        offsets_[index], offsets_[index + 1] - offsets_[index]);
 }
 
 } // namespace fcitx
@@ -7,6 +7,12 @@
 #ifndef _FCITX5_IM_KEYBOARD_LONGPRESSDATA_H_
 #define _FCITX5_IM_KEYBOARD_LONGPRESSDATA_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "fcitx-config/configuration.h"
 #include "fcitx-utils/i18n.h"
 
@@ -29,8 +35,32 @@ FCITX_CONFIGURATION(LongPressConfig,
                                 {},
                                 ListDisplayOptionAnnotation("Key")};);
 
-std::unordered_map<std::string, std::vector<std::string>>
-loadLongPressData(const LongPressConfig &config);
+/**
+ * Long press candidates compiled from LongPressConfig.
+ *
+ * Keys are stored as unicode characters in a sorted table, candidates of all
+ * keys share a single string pool.
+ */
+class LongPressData {
+public:
+    LongPressData() = default;
+    explicit LongPressData(const LongPressConfig &config);
+
+    // Return the range of candidates of chr, empty if there is none.
+    std::pair<size_t, size_t> find(uint32_t chr) const;
+    std::string_view candidate(size_t index) const;
+
+private:
+    struct Entry {
+        uint32_t chr;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Entry> entries_;
+    // Candidate i is pool_[offsets_[i], offsets_[i + 1]).
+    std::vector<uint32_t> offsets_;
+    std::string pool_;
+};
 
 void setupDefaultLongPressConfig(LongPressConfig &config);
 
@@ -8,6 +8,8 @@
 #include "xkbrules.h"
 #include <cstring>
 #include <list>
+#include <string>
+#include <vector>
 #include "fcitx-utils/stringutils.h"
 #include "xmlparser.h"
 
@@ -189,6 +191,132 @@ bool XkbRules::read(const std::vector<std::string> &directories,
     return true;
 }
 
+namespace {
+
+void writeList(MetadataSnapshot::Writer &writer,
+               const std::vector<std::string> &list) {
+    writer.write(list.size());
+    for (const auto &item : list) {
+        writer.write(item);
+    }
+}
+
+bool readList(MetadataSnapshot::Reader &reader,
+              std::vector<std::string> &list) {
+    uint32_t size;
+    if (!reader.readSize(size)) {
+        return false;
+    }
+    list.resize(size);
+    for (auto &item : list) {
+        if (!reader.read(item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void XkbRules::save(MetadataSnapshot::Writer &writer) const {
+    writer.write(version_);
+    writer.write(layoutInfos_.size());
+    for (const auto &[name, layoutInfo] : layoutInfos_) {
+        writer.write(layoutInfo.name);
+        writer.write(layoutInfo.description);
+        writer.write(layoutInfo.shortDescription);
+        writeList(writer, layoutInfo.languages);
+        writer.write(layoutInfo.variantInfos.size());
+        for (const auto &variantInfo : layoutInfo.variantInfos) {
+            writer.write(variantInfo.name);
+            writer.write(variantInfo.description);
+            writer.write(variantInfo.shortDescription);
+            writeList(writer, variantInfo.languages);
+        }
+    }
+    writer.write(modelInfos_.size());
+    for (const auto &modelInfo : modelInfos_) {
+        writer.write(modelInfo.name);
+        writer.write(modelInfo.description);
+        writer.write(modelInfo.vendor);
+    }
+    writer.write(optionGroupInfos_.size());
+    for (const auto &groupInfo : optionGroupInfos_) {
+        writer.write(groupInfo.name);
+        writer.write(groupInfo.description);
+        writer.write(groupInfo.exclusive);
+        writer.write(groupInfo.optionInfos.size());
+        for (const auto &optionInfo : groupInfo.optionInfos) {
+            writer.write(optionInfo.name);
+            writer.write(optionInfo.description);
+        }
+    }
+}
+
+bool XkbRules::load(MetadataSnapshot::Reader &reader) {
+    clear();
+    uint32_t size;
+    if (!reader.read(version_) || !reader.readSize(size)) {
+        return false;
+    }
+    layoutInfos_.reserve(size);
+    for (uint32_t i = 0; i < size; i++) {
+        XkbLayoutInfo layoutInfo;
+        uint32_t variantSize;
+        if (!reader.read(layoutInfo.name) ||
+            !reader.read(layoutInfo.description) ||
+            !reader.read(layoutInfo.shortDescription) ||
+            !readList(reader, layoutInfo.languages) ||
+            !reader.readSize(variantSize)) {
+            return false;
+        }
+        layoutInfo.variantInfos.resize(variantSize);
+        for (auto &variantInfo : layoutInfo.variantInfos) {
+            if (!reader.read(variantInfo.name) ||
+                !reader.read(variantInfo.description) ||
+                !reader.read(variantInfo.shortDescription) ||
+                !readList(reader, variantInfo.languages)) {
+                return false;
+            }
+        }
+        auto name = layoutInfo.name;
+        layoutInfos_.emplace(std::move(name), std::move(layoutInfo));
+    }
+    if (!reader.readSize(size)) {
+        return false;
+    }
+    modelInfos_.resize(size);
+    for (auto &modelInfo : modelInfos_) {
+        if (!reader.read(modelInfo.name) ||
+            !reader.read(modelInfo.description) ||
+            !reader.read(modelInfo.vendor)) {
+            return false;
+        }
+    }
+    if (!reader.readSize(size)) {
+        return false;
+    }
+    optionGroupInfos_.resize(size);
+    for (auto &groupInfo : optionGroupInfos_) {
+        uint32_t exclusive;
+        uint32_t optionSize;
+        if (!reader.read(groupInfo.name) ||
+            !reader.read(groupInfo.description) || !reader.read(exclusive) ||
+            !reader.readSize(optionSize)) {
+            return false;
+        }
+        groupInfo.exclusive = exclusive;
+        groupInfo.optionInfos.resize(optionSize);
+        for (auto &optionInfo : groupInfo.optionInfos) {
+            if (!reader.read(optionInfo.name) ||
+                !reader.read(optionInfo.description)) {
+                return false;
+            }
+        }
+    }
+    return !layoutInfos_.empty();
+}
+
 #ifdef _TEST_XKBRULES
 void XkbRules::dump() {
     std::cout << "Version: " << version_ << std::endl;
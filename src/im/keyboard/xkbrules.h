@@ -10,6 +10,7 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "fcitx/metadatasnapshot_p.h"
 #include "fcitx/misc_p.h"
 
 namespace fcitx {
@@ -52,6 +53,9 @@ public:
     friend struct XkbRulesParseState;
     bool read(const std::vector<std::string> &directories,
               const std::string &name, const std::string &extraFile);
+    // Store and restore the parsed rules in a MetadataSnapshot.
+    void save(MetadataSnapshot::Writer &writer) const;
+    bool load(MetadataSnapshot::Reader &reader);
 #ifdef _TEST_XKBRULES
     void dump();
 #endif
@@ -11,14 +11,50 @@
 #include <list>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 #include <unordered_map>
 #include "fcitx-utils/stringutils.h"
 
 namespace fcitx {
 class ConfigurationPrivate {
 public:
+    // Call loadOption for every option, and notify the changed ones.
+    template <typename LoadOption>
+    void load(LoadOption loadOption) {
+        if (optionChangedCallbacks_.empty()) {
+            for (const auto &path : optionsOrder_) {
+                loadOption(path, *options_[path]);
+            }
+            return;
+        }
+
+        // Compare the marshalled value, since it is available for every
+        // option. Option is marshalled under a parent, because it may write
+        // to its siblings, e.g. I18NString.
+        std::vector<OptionBase *> changed;
+        for (const auto &path : optionsOrder_) {
+            auto *option = options_[path];
+            RawConfig oldValue;
+            option->marshall(oldValue[option->path()]);
+            loadOption(path, *option);
+            RawConfig newValue;
+            option->marshall(newValue[option->path()]);
+            if (oldValue != newValue) {
+                changed.push_back(option);
+            }
+        }
+        for (auto *option : changed) {
+            for (const auto &callback : optionChangedCallbacks_.view()) {
+                if (callback) {
+                    callback(*option);
+                }
+            }
+        }
+    }
+
     std::list<std::string> optionsOrder_;
     std::unordered_map<std::string, OptionBase *> options_;
+    HandlerTable<OptionChangedCallback> optionChangedCallbacks_;
 };
 
 Configuration::Configuration()
@@ -104,19 +140,53 @@ void Configuration::copyHelper(const Configuration &other) {
 
 void Configuration::load(const RawConfig &config, bool partial) {
     FCITX_D();
-    for (const auto &path : d->optionsOrder_) {
+    d->load([&config, partial](const std::string &path, OptionBase &option) {
         auto subConfigPtr = config.get(path);
-        auto *option = d->options_[path];
         if (!subConfigPtr) {
             if (!partial) {
-                option->reset();
+                option.reset();
             }
-            continue;
+            return;
         }
-        if (!option->unmarshall(*subConfigPtr, partial)) {
-            option->reset();
+        if (!option.unmarshall(*subConfigPtr, partial)) {
+            option.reset();
         }
-    }
+    });
+}
+
+void Configuration::load(const FlatRawConfig &config, bool partial) {
+    FCITX_D();
+    // Option may look at its parent, e.g. I18NString reads "Name[locale]", so
+    // the option is placed under a parent that has its localized siblings.
+    RawConfig parent;
+    d->load([&config, &parent, partial](const std::string &path,
+                                        OptionBase &option) {
+        auto node = config.find(path);
+        if (node == FlatRawConfig::npos) {
+            if (!partial) {
+                option.reset();
+            }
+            return;
+        }
+        parent.removeAll();
+        const auto name = config.name(node);
+        const auto parentNode = config.parent(node);
+        for (size_t i = 0, e = config.childCount(parentNode); i < e; i++) {
+            const auto sibling = config.child(parentNode, i);
+            const auto siblingName = config.name(sibling);
+            if (siblingName.size() > name.size() + 1 &&
+                stringutils::startsWith(siblingName, name) &&
+                siblingName[name.size()] == '[' &&
+                stringutils::endsWith(siblingName, "]")) {
+                config.toRawConfig(parent[std::string(siblingName)], sibling);
+            }
+        }
+        auto &subConfig = parent[std::string(name)];
+        config.toRawConfig(subConfig, node);
+        if (!option.unmarshall(subConfig, partial)) {
+            option.reset();
+        }
+    });
 }
 
 void Configuration::save(RawConfig &config) const {
@@ -143,6 +213,12 @@ void Configuration::addOption(OptionBase *option) {
     d->options_[option->path()] = option;
 }
 
+std::unique_ptr<HandlerTableEntry<OptionChangedCallback>>
+Configuration::watchOptionChanged(OptionChangedCallback callback) {
+    FCITX_D();
+    return d->optionChangedCallbacks_.add(std::move(callback));
+}
+
 void Configuration::syncDefaultValueToCurrent() {
     FCITX_D();
     for (const auto &path : d->optionsOrder_) {
@@ -7,12 +7,15 @@
 #ifndef _FCITX_CONFIG_CONFIGURATION_H_
 #define _FCITX_CONFIG_CONFIGURATION_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
+#include <fcitx-config/flatrawconfig.h>
 #include <fcitx-config/option.h>
 #include <fcitx-config/optiontypename.h>
 #include <fcitx-config/rawconfig.h>
+#include <fcitx-utils/handlertable.h>
 #include <fcitx-utils/macros.h>
 #include "fcitxconfig_export.h"
 
@@ -49,6 +52,9 @@ namespace fcitx {
 
 class ConfigurationPrivate;
 
+/// @since 5.1.12
+using OptionChangedCallback = std::function<void(const OptionBase &option)>;
+
 class FCITXCONFIG_EXPORT Configuration {
     friend class OptionBase;
 
@@ -59,6 +65,15 @@ public:
     /// Load configuration from RawConfig. If partial is true, non-exist option
     /// will be reset to default value, otherwise it will be untouched.
     void load(const RawConfig &config, bool partial = false);
+    /**
+     * Load configuration from FlatRawConfig, same as load(RawConfig).
+     *
+     * Options are still unmarshalled from RawConfig, so the value of each
+     * option is converted on its own, together with its localized siblings.
+     *
+     * @since 5.1.12
+     */
+    void load(const FlatRawConfig &config, bool partial = false);
     void save(RawConfig &config) const;
     void dumpDescription(RawConfig &config) const;
     FCITX_NODISCARD virtual const char *typeName() const = 0;
@@ -71,6 +86,18 @@ public:
      */
     void syncDefaultValueToCurrent();
 
+    /**
+     * Watch the options that are changed by load.
+     *
+     * After load, the callback is called once for each option whose value is
+     * different from the value before load, in the order of options. The old
+     * and new values are only compared when there is a watcher.
+     *
+     * @since 5.1.12
+     */
+    FCITX_NODISCARD std::unique_ptr<HandlerTableEntry<OptionChangedCallback>>
+    watchOptionChanged(OptionChangedCallback callback);
+
 protected:
     bool compareHelper(const Configuration &other) const;
     void copyHelper(const Configuration &other);
@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include "flatrawconfig.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fcitx {
+
+namespace {
+
+struct FlatNode {
+    FlatRawConfig::Index name = 0;
+    FlatRawConfig::Index parent = FlatRawConfig::npos;
+    FlatRawConfig::Index firstChild = 0;
+    FlatRawConfig::Index childCount = 0;
+    FlatRawConfig::Index value = 0;
+    FlatRawConfig::Index valueLength = 0;
+    FlatRawConfig::Index comment = 0;
+    FlatRawConfig::Index commentLength = 0;
+    unsigned int lineNumber = 0;
+};
+
+struct Span {
+    FlatRawConfig::Index offset;
+    FlatRawConfig::Index length;
+};
+
+} // namespace
+
+class FlatRawConfigPrivate {
+public:
+    FlatRawConfigPrivate() : nodes_(1), names_{{0, 0}} {}
+
+    Span addString(std::string_view str) {
+        Span span{static_cast<FlatRawConfig::Index>(pool_.size()),
+                  static_cast<FlatRawConfig::Index>(str.size())};
+        pool_.append(str);
+        return span;
+    }
+
+    std::string_view string(FlatRawConfig::Index offset,
+                            FlatRawConfig::Index length) const {
+        return std::string_view(pool_).substr(offset, length);
+    }
+
+    std::string_view name(const FlatNode &node) const {
+        const auto &span = names_[node.name];
+        return string(span.offset, span.length);
+    }
+
+    // Children are contiguous in the original order, so nodes are added
+    // breadth first.
+    void build(const RawConfig &config) {
+        std::unordered_map<std::string, FlatRawConfig::Index> nameIds{{"", 0}};
+        std::vector<const RawConfig *> queue{&config};
+        nodes_.clear();
+        nodes_.emplace_back();
+        for (size_t i = 0; i < queue.size(); i++) {
+            const auto *current = queue[i];
+            auto value = addString(current->value());
+            auto comment = addString(current->comment());
+            auto &node = nodes_[i];
+            node.value = value.offset;
+            node.valueLength = value.length;
+            node.comment = comment.offset;
+            node.commentLength = comment.length;
+            node.lineNumber = current->lineNumber();
+            node.firstChild = nodes_.size();
+            node.childCount = current->subItemsSize();
+
+            const auto parent = static_cast<FlatRawConfig::Index>(i);
+            current->visitSubItems([this, parent, &queue, &nameIds](
+                                       const RawConfig &subConfig,
+                                       const std::string &path) {
+                auto [iter, inserted] = nameIds.emplace(path, names_.size());
+                if (inserted) {
+                    names_.push_back(addString(path));
+                }
+                auto &child = nodes_.emplace_back();
+                child.name = iter->second;
+                child.parent = parent;
+                queue.push_back(&subConfig);
+                return true;
+            });
+        }
+    }
+
+    std::vector<FlatNode> nodes_;
+    std::vector<Span> names_;
+    std::string pool_;
+};
+
+FlatRawConfig::FlatRawConfig()
+    : d_ptr(std::make_unique<FlatRawConfigPrivate>()) {}
+
+FlatRawConfig::FlatRawConfig(const RawConfig &config) : FlatRawConfig() {
+    FCITX_D();
+    d->build(config);
+}
+
+FCITX_DEFINE_DPTR_COPY_AND_DEFAULT_DTOR_AND_MOVE(FlatRawConfig);
+
+size_t FlatRawConfig::size() const {
+    FCITX_D();
+    return d->nodes_.size();
+}
+
+FlatRawConfig::Index FlatRawConfig::find(std::string_view path,
+                                         Index node) const {
+    if (node >= size()) {
+        return npos;
+    }
+    while (node != npos) {
+        auto pos = path.find('/');
+        node = findChild(node, path.substr(0, pos));
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        path.remove_prefix(pos + 1);
+    }
+    return node;
+}
+
+FlatRawConfig::Index FlatRawConfig::findChild(Index node,
+                                              std::string_view name) const {
+    FCITX_D();
+    if (node >= d->nodes_.size()) {
+        return npos;
+    }
+    const auto &parent = d->nodes_[node];
+    for (Index i = 0; i < parent.childCount; i++) {
+        const auto index = parent.firstChild + i;
+        if (d->name(d->nodes_[index]) == name) {
+            return index;
+        }
+    }
+    return npos;
+}
+
+std::string_view FlatRawConfig::name(Index node) const {
+    FCITX_D();
+    return d->name(d->nodes_.at(node));
+}
+
+std::string_view FlatRawConfig::value(Index node) const {
+    FCITX_D();
+    const auto &n = d->nodes_.at(node);
+    return d->string(n.value, n.valueLength);
+}
+
+std::string_view FlatRawConfig::comment(Index node) const {
+    FCITX_D();
+    const auto &n = d->nodes_.at(node);
+    return d->string(n.comment, n.commentLength);
+}
+
+unsigned int FlatRawConfig::lineNumber(Index node) const {
+    FCITX_D();
+    return d->nodes_.at(node).lineNumber;
+}
+
+FlatRawConfig::Index FlatRawConfig::parent(Index node) const {
+    FCITX_D();
+    return d->nodes_.at(node).parent;
+}
+
+size_t FlatRawConfig::childCount(Index node) const {
+    FCITX_D();
+    return d->nodes_.at(node).childCount;
+}
+
+FlatRawConfig::Index FlatRawConfig::child(Index node, size_t i) const {
+    FCITX_D();
+    const auto &n = d->nodes_.at(node);
+    if (i >= n.childCount) {
+        return npos;
+    }
+    return n.firstChild + i;
+}
+
+void FlatRawConfig::toRawConfig(RawConfig &config, Index node) const {
+    config.removeAll();
+    config.setValue(std::string(value(node)));
+    config.setComment(std::string(comment(node)));
+    config.setLineNumber(lineNumber(node));
+    for (size_t i = 0, e = childCount(node); i < e; i++) {
+        const auto index = child(node, i);
+        toRawConfig(*config.get(std::string(name(index)), true), index);
+    }
+}
+
+RawConfig FlatRawConfig::toRawConfig(Index node) const {
+    RawConfig config;
+    toRawConfig(config, node);
+    return config;
+}
+
+} // namespace fcitx
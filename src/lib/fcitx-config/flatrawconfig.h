@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_CONFIG_FLATRAWCONFIG_H_
+#define _FCITX_CONFIG_FLATRAWCONFIG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <fcitx-config/rawconfig.h>
+#include <fcitx-utils/macros.h>
+#include "fcitxconfig_export.h"
+
+namespace fcitx {
+
+class FlatRawConfigPrivate;
+
+/**
+ * A read-only RawConfig stored in a flat layout.
+ *
+ * All the nodes are kept in a single array, and the children of a node are
+ * stored next to each other in their original order. Names are interned, and
+ * values and comments share one string pool. Building, copying and walking a
+ * FlatRawConfig only touches a few contiguous allocations, instead of one
+ * shared node per item.
+ *
+ * Nodes are addressed by index, and the root node is always at index 0.
+ *
+ * @since 5.1.12
+ */
+class FCITXCONFIG_EXPORT FlatRawConfig {
+public:
+    using Index = uint32_t;
+    static constexpr Index root = 0;
+    static constexpr Index npos = static_cast<Index>(-1);
+
+    /// Create a config with only an empty root.
+    FlatRawConfig();
+    explicit FlatRawConfig(const RawConfig &config);
+    FCITX_DECLARE_VIRTUAL_DTOR_COPY_AND_MOVE(FlatRawConfig);
+
+    /// Number of nodes, including the root.
+    size_t size() const;
+
+    /// Find the node by a "/" separated path relative to node, same as
+    /// RawConfig::get. Return npos if it does not exist.
+    Index find(std::string_view path, Index node = root) const;
+    /// Find a direct child by name, return npos if it does not exist.
+    Index findChild(Index node, std::string_view name) const;
+
+    std::string_view name(Index node) const;
+    std::string_view value(Index node) const;
+    std::string_view comment(Index node) const;
+    unsigned int lineNumber(Index node) const;
+    /// Return npos for root.
+    Index parent(Index node) const;
+    size_t childCount(Index node) const;
+    Index child(Index node, size_t i) const;
+
+    /// Replace the content of config with the sub tree of node.
+    void toRawConfig(RawConfig &config, Index node = root) const;
+    RawConfig toRawConfig(Index node = root) const;
+
+private:
+    FCITX_DECLARE_PRIVATE(FlatRawConfig);
+    std::unique_ptr<FlatRawConfigPrivate> d_ptr;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_CONFIG_FLATRAWCONFIG_H_
@@ -25,13 +25,8 @@ void readFromIni(RawConfig &config, int fd) {
     if (fd < 0) {
         return;
     }
-    // dup it
-    UnixFD unixFD(fd);
-    UniqueFilePtr fp = fs::openFD(unixFD, "rb");
-    if (!fp) {
-        return;
-    }
-    readFromIni(config, fp.get());
+    fs::FileView file(fd);
+    readFromIni(config, file.view());
 }
 
 bool writeAsIni(const RawConfig &config, int fd) {
@@ -48,58 +43,69 @@ bool writeAsIni(const RawConfig &config, int fd) {
 }
 
 void readFromIni(RawConfig &config, FILE *fin) {
-    std::string currentGroup;
+    std::string data;
+    char buffer[4096];
+    size_t readSize;
+    while ((readSize = fread(buffer, 1, sizeof(buffer), fin)) > 0) {
+        data.append(buffer, readSize);
+    }
+    readFromIni(config, std::string_view(data));
+}
 
-    UniqueCPtr<char> clineBuf;
-    size_t bufSize = 0;
+void readFromIni(RawConfig &config, std::string_view data) {
+    // Keep the node of current group, so a key does not need to be looked up
+    // from the root.
+    RawConfig *groupConfig = &config;
     unsigned int line = 0;
-    while (getline(clineBuf, &bufSize, fin) >= 0) {
+    while (!data.empty()) {
+        auto end = data.find('\n');
+        auto lineBuf = data.substr(0, end);
+        data = end == std::string_view::npos ? std::string_view()
+                                             : data.substr(end + 1);
         line++;
-        std::string_view lineBuf = stringutils::trimView(clineBuf.get());
+        // Same as reading the line as a C string.
+        lineBuf = lineBuf.substr(0, lineBuf.find('\0'));
+        lineBuf = stringutils::trimView(lineBuf);
         if (lineBuf.empty() || lineBuf.front() == '#') {
             continue;
         }
 
         if (lineBuf.front() == '[' && lineBuf.back() == ']') {
-            currentGroup = lineBuf.substr(1, lineBuf.size() - 2);
+            const std::string group(lineBuf.substr(1, lineBuf.size() - 2));
+            groupConfig = &config;
             config.visitItemsOnPath(
-                [line](RawConfig &config, const std::string &) {
+                [line, &groupConfig](RawConfig &config, const std::string &) {
                     if (!config.lineNumber()) {
                         config.setLineNumber(line);
                     }
+                    groupConfig = &config;
                 },
-                currentGroup);
+                group);
+            if (group.empty()) {
+                groupConfig = &config;
+            }
         } else if (std::string::size_type equalPos = lineBuf.find_first_of('=');
                    equalPos != std::string::npos) {
-            auto name = lineBuf.substr(0, equalPos);
-            auto valueStart = equalPos + 1;
-
-            auto value = stringutils::unescapeForValue(
-                std::string_view(lineBuf).substr(valueStart));
+            auto value =
+                stringutils::unescapeForValue(lineBuf.substr(equalPos + 1));
             if (!value) {
                 continue;
             }
 
-            RawConfigPtr subConfig;
-            if (!currentGroup.empty()) {
-                std::string s = currentGroup;
-                s += "/";
-                s += name;
-                subConfig = config.get(s, true);
-            } else {
-                subConfig = config.get(std::string(name), true);
-            }
-            subConfig->setValue(*value);
+            auto name = lineBuf.substr(0, equalPos);
+            auto subConfig = groupConfig->get(std::string(name), true);
+            subConfig->setValue(std::move(*value));
             subConfig->setLineNumber(line);
         }
     }
 }
 
-bool writeAsIni(const RawConfig &config, FILE *fout) {
+std::string writeAsIni(const RawConfig &config) {
+    std::string result;
     std::function<bool(const RawConfig &, const std::string &path)> callback;
 
-    callback = [fout, &callback](const RawConfig &config,
-                                 const std::string &path) {
+    callback = [&result, &callback](const RawConfig &config,
+                                    const std::string &path) {
         if (config.hasSubItems()) {
             std::string values;
             config.visitSubItems(
@@ -124,18 +130,25 @@ bool writeAsIni(const RawConfig &config, FILE *fout) {
                 "", false, path);
             if (!values.empty()) {
                 if (!path.empty()) {
-                    FCITX_RETURN_IF(fprintf(fout, "[%s]\n", path.c_str()) < 0,
-                                    false);
+                    result += "[";
+                    result += path;
+                    result += "]\n";
                 }
-                FCITX_RETURN_IF(fprintf(fout, "%s\n", values.c_str()) < 0,
-                                false);
+                result += values;
+                result += "\n";
             }
         }
         config.visitSubItems(callback, "", false, path);
         return true;
     };
 
-    return callback(config, "");
+    callback(config, "");
+    return result;
+}
+
+bool writeAsIni(const RawConfig &config, FILE *fout) {
+    const auto content = writeAsIni(config);
+    return fwrite(content.data(), 1, content.size(), fout) == content.size();
 }
 
 void readAsIni(RawConfig &rawConfig, const std::string &path) {
@@ -173,6 +186,10 @@ bool safeSaveAsIni(const Configuration &configuration,
 bool safeSaveAsIni(const RawConfig &config, StandardPath::Type type,
                    const std::string &path) {
     const auto &standardPath = StandardPath::global();
+    if (standardPath.isSaveDeferred()) {
+        standardPath.queueSave(type, path, writeAsIni(config));
+        return true;
+    }
     return standardPath.safeSave(
         type, path, [&config](int fd) { return writeAsIni(config, fd); });
 }
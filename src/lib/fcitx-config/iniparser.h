@@ -9,6 +9,7 @@
 
 #include <cstdio>
 #include <string>
+#include <string_view>
 #include <fcitx-config/rawconfig.h>
 #include <fcitx-utils/standardpath.h>
 #include "fcitxconfig_export.h"
@@ -19,6 +20,18 @@ FCITXCONFIG_EXPORT void readFromIni(RawConfig &config, int fd);
 FCITXCONFIG_EXPORT bool writeAsIni(const RawConfig &config, int fd);
 FCITXCONFIG_EXPORT void readFromIni(RawConfig &config, FILE *fin);
 FCITXCONFIG_EXPORT bool writeAsIni(const RawConfig &config, FILE *fout);
+/**
+ * Parse ini from a buffer that is already in memory.
+ *
+ * @since 5.1.12
+ */
+FCITXCONFIG_EXPORT void readFromIni(RawConfig &config, std::string_view data);
+/**
+ * Return the ini content of config, the same as the one written to file.
+ *
+ * @since 5.1.12
+ */
+FCITXCONFIG_EXPORT std::string writeAsIni(const RawConfig &config);
 FCITXCONFIG_EXPORT void readAsIni(Configuration &configuration,
                                   const std::string &path);
 FCITXCONFIG_EXPORT void readAsIni(RawConfig &rawConfig,
@@ -84,6 +84,33 @@ enum class CapabilityFlag : uint64_t {
      */
     CommitStringWithCursor = (1ULL << 41),
 
+    /**
+     * Whether client wants the events produced by one request, e.g. commit
+     * string, preedit update and forward key, to be sent together in one
+     * message.
+     *
+     * @since 5.1.12
+     */
+    BatchedEvents = (1ULL << 42),
+
+    /**
+     * Whether client wants the client side input panel as a packed byte
+     * array, which only contains the parts changed since the last update.
+     *
+     * @since 5.1.12
+     */
+    CompactClientSideUI = (1ULL << 43),
+
+    /**
+     * Whether client can send only the part of surrounding text around the
+     * cursor that the current input method needs, and accepts the surrounding
+     * text to be trimmed to it.
+     *
+     * @see InputMethodEntry::surroundingTextWindow
+     * @since 5.1.12
+     */
+    SurroundingTextWindow = (1ULL << 44),
+
     PasswordOrSensitive = Password | Sensitive,
 };
 
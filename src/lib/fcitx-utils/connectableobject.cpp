@@ -6,14 +6,40 @@
  */
 
 #include "connectableobject.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace fcitx {
 
+namespace {
+
+struct SignalEntry {
+    uint32_t hash;
+    std::string name;
+    std::unique_ptr<SignalBase> signal;
+};
+
+} // namespace
+
 class ConnectableObjectPrivate {
 public:
     ConnectableObjectPrivate() = default;
-    std::unordered_map<std::string, std::unique_ptr<fcitx::SignalBase>>
-        signals_;
+
+    auto find(std::string_view name, uint32_t hash) const {
+        return std::find_if(signals_.begin(), signals_.end(),
+                            [name, hash](const SignalEntry &entry) {
+                                return entry.hash == hash && entry.name == name;
+                            });
+    }
+
+    // An object only has a few signals, so a linear scan of the hash is
+    // faster than a hash table.
+    std::vector<SignalEntry> signals_;
     bool destroyed_ = false;
     std::unique_ptr<SignalAdaptor<ConnectableObject::Destroyed>> adaptor_;
 };
@@ -29,11 +55,18 @@ ConnectableObject::~ConnectableObject() { destroy(); }
 void ConnectableObject::_registerSignal(
     std::string name, std::unique_ptr<fcitx::SignalBase> signal) {
     FCITX_D();
-    d->signals_.emplace(std::move(name), std::move(signal));
+    const auto hash = details::signalHash(name);
+    if (d->find(name, hash) != d->signals_.end()) {
+        return;
+    }
+    d->signals_.push_back({hash, std::move(name), std::move(signal)});
 }
 void ConnectableObject::_unregisterSignal(const std::string &name) {
     FCITX_D();
-    d->signals_.erase(name);
+    auto iter = d->find(name, details::signalHash(name));
+    if (iter != d->signals_.end()) {
+        d->signals_.erase(iter);
+    }
 }
 
 SignalBase *ConnectableObject::findSignal(const std::string &name) {
@@ -41,10 +74,15 @@ SignalBase *ConnectableObject::findSignal(const std::string &name) {
 }
 
 SignalBase *ConnectableObject::findSignal(const std::string &name) const {
+    return findSignal(name, details::signalHash(name));
+}
+
+SignalBase *ConnectableObject::findSignal(std::string_view name,
+                                          uint32_t hash) const {
     FCITX_D();
-    auto iter = d->signals_.find(name);
+    auto iter = d->find(name, hash);
     if (iter != d->signals_.end()) {
-        return iter->second.get();
+        return iter->signal.get();
     }
     return nullptr;
 }
@@ -7,8 +7,10 @@
 #ifndef _FCITX_UTILS_CONNECTABLEOBJECT_H_
 #define _FCITX_UTILS_CONNECTABLEOBJECT_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <fcitx-utils/metastring.h>
 #include <fcitx-utils/signals.h>
@@ -38,6 +40,20 @@ namespace fcitx {
 
 class ConnectableObject;
 
+namespace details {
+
+// FNV-1a of the signal name, so the name of a signal type doesn't need to be
+// hashed on every connect or emit.
+constexpr uint32_t signalHash(std::string_view name) {
+    uint32_t hash = 2166136261U;
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    return hash;
+}
+
+} // namespace details
+
 /// \brief Helper class to register class.
 template <typename T, typename Combiner = LastValue<typename std::function<
                           typename T::signalType>::result_type>>
@@ -63,7 +79,7 @@ public:
 
     template <typename SignalType, typename F>
     Connection connect(F &&func) {
-        auto signal = findSignal(SignalType::signature::data());
+        auto signal = findSignal<SignalType>();
         if (signal) {
             return static_cast<Signal<typename SignalType::signalType> *>(
                        signal)
@@ -74,7 +90,7 @@ public:
 
     template <typename SignalType>
     void disconnectAll() {
-        auto signal = findSignal(SignalType::signature::data());
+        auto signal = findSignal<SignalType>();
         static_cast<Signal<typename SignalType::signalType> *>(signal)
             ->disconnectAll();
     }
@@ -97,7 +113,7 @@ protected:
 
     template <typename SignalType, typename... Args>
     auto emit(Args &&...args) const {
-        auto signal = findSignal(SignalType::signature::data());
+        auto signal = findSignal<SignalType>();
         return (*static_cast<Signal<typename SignalType::signalType> *>(
             signal))(std::forward<Args>(args)...);
     }
@@ -123,6 +139,16 @@ private:
     // FIXME: remove non-const variant when we can break ABI.
     SignalBase *findSignal(const std::string &name);
     SignalBase *findSignal(const std::string &name) const;
+    /// \since 5.1.12
+    SignalBase *findSignal(std::string_view name, uint32_t hash) const;
+
+    template <typename SignalType>
+    SignalBase *findSignal() const {
+        constexpr std::string_view name(SignalType::signature::data(),
+                                        SignalType::signature::size());
+        constexpr auto hash = details::signalHash(name);
+        return findSignal(name, hash);
+    }
 
     std::unique_ptr<ConnectableObjectPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(ConnectableObject);
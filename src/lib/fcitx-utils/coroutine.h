@@ -0,0 +1,293 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_COROUTINE_H_
+#define _FCITX_UTILS_COROUTINE_H_
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief C++20 coroutine support for EventLoop.
+///
+/// Fcitx itself is built as C++17, this header is only for the code that is
+/// built with C++20 coroutine support, and nothing in the library depends on
+/// it.
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "fcitx-utils/coroutine.h requires C++20 coroutine support."
+#endif
+
+#include <coroutine>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <fcitx-utils/event.h>
+
+namespace fcitx {
+
+template <typename T = void>
+class AsyncTask;
+
+namespace details {
+
+struct AsyncTaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            if (auto continuation = handle.promise().continuation_) {
+                return continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    void rethrowIfFailed() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+    bool started_ = false;
+};
+
+template <typename T>
+struct AsyncTaskPromise : public AsyncTaskPromiseBase {
+    AsyncTask<T> get_return_object();
+
+    template <typename U>
+    void return_value(U &&value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        rethrowIfFailed();
+        return std::move(*value_);
+    }
+
+    std::optional<T> value_;
+};
+
+template <>
+struct AsyncTaskPromise<void> : public AsyncTaskPromiseBase {
+    AsyncTask<void> get_return_object();
+
+    void return_void() {}
+
+    void result() { rethrowIfFailed(); }
+};
+
+} // namespace details
+
+/**
+ * A coroutine that runs on the thread of an event loop.
+ *
+ * It is lazy, and started either by co_await from another coroutine, or by
+ * start(). The coroutine frame is owned by this object: destroying it cancels
+ * the coroutine at its current suspension point, along with what it waits
+ * for, e.g. a timer or a D-Bus call. So a top level task must be kept, e.g.
+ * as a member of the addon, until done() returns true.
+ *
+ * @since 5.1.12
+ */
+template <typename T>
+class AsyncTask {
+public:
+    using promise_type = details::AsyncTaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    AsyncTask() = default;
+    explicit AsyncTask(Handle handle) : handle_(handle) {}
+    AsyncTask(AsyncTask &&other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {}
+    AsyncTask &operator=(AsyncTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~AsyncTask() { reset(); }
+
+    /**
+     * Run the coroutine until its first suspension point.
+     *
+     * Use co_await asyncDefer() to continue in the next event loop
+     * iteration instead. Does nothing if it is already started.
+     */
+    void start() {
+        if (handle_ && !std::exchange(handle_.promise().started_, true)) {
+            handle_.resume();
+        }
+    }
+
+    /// Whether the coroutine is finished, an empty task is always finished.
+    bool done() const { return !handle_ || handle_.done(); }
+
+    /// Result of a finished coroutine, rethrow its uncaught exception.
+    T result() { return handle_.promise().result(); }
+
+    /// Destroy the coroutine, it is cancelled if not finished yet.
+    void reset() {
+        if (handle_) {
+            std::exchange(handle_, nullptr).destroy();
+        }
+    }
+
+    // Await a non-empty task that is not started by start().
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            bool await_ready() noexcept { return handle_.done(); }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> continuation) noexcept {
+                handle_.promise().continuation_ = continuation;
+                handle_.promise().started_ = true;
+                return handle_;
+            }
+
+            T await_resume() { return handle_.promise().result(); }
+
+            Handle handle_;
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    Handle handle_;
+};
+
+namespace details {
+
+template <typename T>
+AsyncTask<T> AsyncTaskPromise<T>::get_return_object() {
+    return AsyncTask<T>(
+        std::coroutine_handle<AsyncTaskPromise<T>>::from_promise(*this));
+}
+
+inline AsyncTask<void> AsyncTaskPromise<void>::get_return_object() {
+    return AsyncTask<void>(
+        std::coroutine_handle<AsyncTaskPromise<void>>::from_promise(*this));
+}
+
+// Event source is owned by the awaiter, which lives in the coroutine frame,
+// so it is removed together with a cancelled coroutine. Resuming may destroy
+// the awaiter and the callback itself, so nothing is accessed after that.
+class EventAwaiterBase {
+public:
+    explicit EventAwaiterBase(EventLoop &loop) : loop_(loop) {}
+
+    bool await_ready() const noexcept { return false; }
+
+protected:
+    EventLoop &loop_;
+    std::unique_ptr<EventSource> source_;
+};
+
+class SleepAwaiter : public EventAwaiterBase {
+public:
+    SleepAwaiter(EventLoop &loop, uint64_t usec)
+        : EventAwaiterBase(loop), usec_(usec) {}
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        source_ = loop_.addTimeEvent(
+            CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + usec_, 0,
+            [handle](EventSourceTime *, uint64_t) {
+                handle.resume();
+                return true;
+            });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    uint64_t usec_;
+};
+
+class DeferAwaiter : public EventAwaiterBase {
+public:
+    using EventAwaiterBase::EventAwaiterBase;
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        source_ = loop_.addDeferEvent([handle](EventSource *) {
+            handle.resume();
+            return true;
+        });
+    }
+
+    void await_resume() const noexcept {}
+};
+
+class IOAwaiter : public EventAwaiterBase {
+public:
+    IOAwaiter(EventLoop &loop, int fd, IOEventFlags flags)
+        : EventAwaiterBase(loop), fd_(fd), flags_(flags) {}
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        source_ = loop_.addIOEvent(
+            fd_, flags_,
+            [this, handle](EventSourceIO *, int, IOEventFlags flags) {
+                // Only wait for one event.
+                source_->setEnabled(false);
+                flags_ = flags;
+                handle.resume();
+                return true;
+            });
+    }
+
+    IOEventFlags await_resume() const noexcept { return flags_; }
+
+private:
+    int fd_;
+    IOEventFlags flags_;
+};
+
+} // namespace details
+
+/**
+ * Resume the coroutine after usec microseconds.
+ *
+ * @since 5.1.12
+ */
+inline details::SleepAwaiter asyncSleep(EventLoop &loop, uint64_t usec) {
+    return {loop, usec};
+}
+
+/**
+ * Resume the coroutine in the next event loop iteration.
+ *
+ * @since 5.1.12
+ */
+inline details::DeferAwaiter asyncDefer(EventLoop &loop) {
+    return details::DeferAwaiter(loop);
+}
+
+/**
+ * Resume the coroutine when fd is ready, the result is the ready flags.
+ *
+ * @since 5.1.12
+ */
+inline details::IOAwaiter asyncWaitIO(EventLoop &loop, int fd,
+                                      IOEventFlags flags) {
+    return {loop, fd, flags};
+}
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_COROUTINE_H_
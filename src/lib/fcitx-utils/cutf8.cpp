@@ -6,6 +6,7 @@
  */
 
 #include "cutf8.h"
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include "utf8.h"
@@ -29,6 +30,68 @@
 #define UNICODE_VALID(Char)                                                    \
     ((Char) < 0x110000 && (((Char) & 0xFFFFF800) != 0xD800))
 
+namespace {
+
+/**
+ * Return the number of leading bytes of str that are non-zero ASCII, looking
+ * at most byte bytes.
+ *
+ * The string is scanned a machine word at a time. Words are only loaded from
+ * aligned addresses, so the scan never crosses a page boundary even if the
+ * buffer is shorter than byte and ends with '\0'.
+ */
+size_t asciiPrefixLength(const char *str, size_t byte) {
+    constexpr uint64_t ones = 0x0101010101010101ULL;
+    constexpr uint64_t highBits = 0x8080808080808080ULL;
+    size_t i = 0;
+    while (i < byte && (reinterpret_cast<uintptr_t>(str + i) %
+                        sizeof(uint64_t)) != 0) {
+        const auto c = static_cast<unsigned char>(str[i]);
+        if (!c || (c & 0x80)) {
+            return i;
+        }
+        i++;
+    }
+    while (byte - i >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, str + i, sizeof(word));
+        // Any byte with high bit set, or any zero byte.
+        if ((word & highBits) || ((word - ones) & ~word & highBits)) {
+            break;
+        }
+        i += sizeof(word);
+    }
+    while (i < byte) {
+        const auto c = static_cast<unsigned char>(str[i]);
+        if (!c || (c & 0x80)) {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Return the length of the well-formed 2 or 3 byte sequence at in, which
+ * covers most of the non-ASCII text, or 0 if the general decoder is needed.
+ */
+int commonSequenceLength(const unsigned char *in, size_t byte) {
+    if (in[0] >= 0xc2 && in[0] <= 0xdf) {
+        return (byte >= 2 && CONT(1)) ? 2 : 0;
+    }
+    if ((in[0] & 0xf0) == 0xe0 && byte >= 3 && CONT(1) && CONT(2)) {
+        // Reject overlong form and surrogates.
+        if ((in[0] == 0xe0 && in[1] < 0xa0) ||
+            (in[0] == 0xed && in[1] >= 0xa0)) {
+            return 0;
+        }
+        return 3;
+    }
+    return 0;
+}
+
+} // namespace
+
 size_t fcitx_utf8_strlen(const char *s) {
     size_t l = 0;
 
@@ -336,6 +399,20 @@ void fcitx_utf8_strncpy(char *str, const char *s, size_t byte) {
 size_t fcitx_utf8_strnlen_validated(const char *str, size_t byte) {
     size_t len = 0;
     while (byte && *str) {
+        if (!(*str & 0x80)) {
+            auto ascii = asciiPrefixLength(str, byte);
+            str += ascii;
+            byte -= ascii;
+            len += ascii;
+            continue;
+        }
+        if (auto charLen = commonSequenceLength(
+                reinterpret_cast<const unsigned char *>(str), byte)) {
+            str += charLen;
+            byte -= charLen;
+            len++;
+            continue;
+        }
         int charLen = 0;
         uint32_t chr = fcitx_utf8_get_char_validated(
             str, (byte > FCITX_UTF8_MAX_LENGTH ? FCITX_UTF8_MAX_LENGTH : byte),
@@ -355,6 +432,20 @@ size_t fcitx_utf8_strnlen(const char *str, size_t byte) {
     size_t len = 0;
     // if byte is zero no need to go further.
     while (byte && *str) {
+        if (!(*str & 0x80)) {
+            auto ascii = asciiPrefixLength(str, byte);
+            str += ascii;
+            byte -= ascii;
+            len += ascii;
+            continue;
+        }
+        if (auto charLen = commonSequenceLength(
+                reinterpret_cast<const unsigned char *>(str), byte)) {
+            str += charLen;
+            byte -= charLen;
+            len++;
+            continue;
+        }
         uint32_t chr;
 
         const char *next = fcitx_utf8_get_char(str, &chr);
@@ -7,6 +7,10 @@
 #ifndef _FCITX_UTILS_DBUS_BUS_H_
 #define _FCITX_UTILS_DBUS_BUS_H_
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <fcitx-utils/dbus/matchrule.h>
@@ -32,6 +36,17 @@ public:
     virtual ~Slot();
 };
 
+/**
+ * Find the object at a path below the prefix of a fallback vtable.
+ *
+ * Return nullptr if there is no such object.
+ *
+ * @see Bus::addObjectVTableFallback
+ * @since 5.1.12
+ */
+using ObjectVTableFinder =
+    std::function<ObjectVTableBase *(const std::string &path)>;
+
 enum class BusType { Default, Session, System };
 enum class RequestNameFlag {
     None = 0,
@@ -40,6 +55,28 @@ enum class RequestNameFlag {
     Queue = 1ULL << 2
 };
 
+/**
+ * Call statistics of one method exported on the bus.
+ *
+ * @see Bus::setMethodStatisticsEnabled
+ * @since 5.1.12
+ */
+struct MethodCallStatistic {
+    static constexpr size_t latencyBuckets = 16;
+
+    std::string interface;
+    std::string method;
+    uint64_t callCount = 0;
+    /// Number of calls that return a D-Bus error.
+    uint64_t errorCount = 0;
+    /// Total time spent in method handler, in microseconds.
+    uint64_t totalTime = 0;
+    uint64_t maxTime = 0;
+    /// Bucket 0 counts calls shorter than 1us, bucket i counts the ones in
+    /// [2^(i-1), 2^i) us, and the last bucket also counts anything longer.
+    std::array<uint64_t, latencyBuckets> latencyHistogram{};
+};
+
 class BusPrivate;
 
 /**
@@ -92,6 +129,39 @@ public:
     bool addObjectVTable(const std::string &path, const std::string &interface,
                          ObjectVTableBase &obj);
 
+    /**
+     * Register one vtable for interface on all the paths below prefix.
+     *
+     * Instead of registering every object on the bus, the object is looked up
+     * with finder when a message arrives, so creating and destroying objects
+     * that share one interface only costs a lookup table update. The objects
+     * returned by finder must have the same type as prototype, and be bound
+     * to their path with bindObjectVTable.
+     *
+     * @param prefix path prefix, not included itself
+     * @param interface object interface
+     * @param prototype object used to build the vtable
+     * @param finder callback to find the object of a path
+     * @return slot of the registration, or nullptr on failure
+     * @since 5.1.12
+     */
+    FCITX_NODISCARD std::unique_ptr<Slot>
+    addObjectVTableFallback(const std::string &prefix,
+                            const std::string &interface,
+                            ObjectVTableBase &prototype,
+                            ObjectVTableFinder finder);
+
+    /**
+     * Bind obj to path and interface without registering it on the bus.
+     *
+     * The object can emit signals, and receive messages from the fallback
+     * registered by addObjectVTableFallback.
+     *
+     * @since 5.1.12
+     */
+    void bindObjectVTable(const std::string &path, const std::string &interface,
+                          ObjectVTableBase &obj);
+
     /// Create a new signal message
     Message createSignal(const char *path, const char *interface,
                          const char *member);
@@ -157,6 +227,20 @@ public:
      */
     void flush();
 
+    /**
+     * Enable per method call statistics of the objects registered with
+     * addObjectVTable.
+     *
+     * @since 5.1.12
+     */
+    void setMethodStatisticsEnabled(bool enabled);
+    /// @since 5.1.12
+    bool isMethodStatisticsEnabled() const;
+    /// Return the statistics of all the methods called, @since 5.1.12
+    std::vector<MethodCallStatistic> methodStatistics() const;
+    /// @since 5.1.12
+    void resetMethodStatistics();
+
 private:
     std::unique_ptr<BusPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(Bus);
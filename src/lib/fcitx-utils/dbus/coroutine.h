@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_DBUS_COROUTINE_H_
+#define _FCITX_UTILS_DBUS_COROUTINE_H_
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief C++20 coroutine support for D-Bus method call.
+
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <fcitx-utils/coroutine.h>
+#include <fcitx-utils/dbus/bus.h>
+#include <fcitx-utils/dbus/message.h>
+
+namespace fcitx::dbus {
+
+namespace details {
+
+class CallAwaiter {
+public:
+    CallAwaiter(Message &message, uint64_t usec)
+        : message_(message), usec_(usec) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        slot_ = message_.callAsync(usec_, [this, handle](Message &reply) {
+            reply_ = std::move(reply);
+            handle.resume();
+            return true;
+        });
+        // Not able to send, resume immediately with an empty reply.
+        return slot_ != nullptr;
+    }
+
+    Message await_resume() { return std::move(reply_); }
+
+private:
+    Message &message_;
+    uint64_t usec_;
+    Message reply_;
+    // Owned by the coroutine frame, so a cancelled coroutine also drops the
+    // pending call.
+    std::unique_ptr<Slot> slot_;
+};
+
+} // namespace details
+
+/**
+ * Call a D-Bus method, the result is the reply message.
+ *
+ * The reply may be an error message, or an empty message if the call can not
+ * be sent at all.
+ *
+ * @param message method call message
+ * @param usec timeout in microseconds
+ * @since 5.1.12
+ */
+inline details::CallAwaiter asyncCall(Message &message, uint64_t usec) {
+    return {message, usec};
+}
+
+} // namespace fcitx::dbus
+
+#endif // _FCITX_UTILS_DBUS_COROUTINE_H_
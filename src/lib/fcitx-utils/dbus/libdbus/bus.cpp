@@ -68,7 +68,8 @@ public:
 
         if (!ioEvent_) {
             ioEvent_ = bus_.get()->loop_->addIOEvent(
-                fd, flags, [this](EventSourceIO *, int, IOEventFlags flags) {
+                fd, flags,
+                [this](EventSourceIO *, int, IOEventFlags flags) {
                     // Ensure this is valid.
                     // At this point, callback is always valid, so no need to
                     // keep "this".
@@ -117,7 +118,11 @@ public:
                         }
                     }
                     return true;
-                });
+                },
+                "DBus/Watch");
+            // Input from frontends goes through the bus.
+            bus_.get()->loop_->setPriority(ioEvent_.get(),
+                                           EventPriority::High);
         } else {
             ioEvent_->setEvents(flags);
         }
@@ -151,6 +156,15 @@ DBusHandlerResult DBusMessageCallback(DBusConnection *, DBusMessage *message,
             msg.rewind();
         }
 
+        // Objects under a fallback are not registered on the connection, so
+        // their method calls need to be dispatched here.
+        if (msg.type() == MessageType::MethodCall &&
+            !bus->fallbacks_.empty() &&
+            !bus->objectRegistration_.hasKey(msg.path()) &&
+            bus->objectVTableCallback(msg)) {
+            return DBUS_HANDLER_RESULT_HANDLED;
+        }
+
         if (msg.type() == MessageType::Signal) {
             if (auto *bus = ref.get()) {
                 for (auto &pair : bus->matchHandlers_.view()) {
@@ -288,11 +302,61 @@ DBusObjectVTableSlot *BusPrivate::findSlot(const std::string &path,
             }
         }
     }
+    if (!fallbacks_.empty() && !objectRegistration_.hasKey(path)) {
+        return findFallbackSlot(path, interface);
+    }
+    return nullptr;
+}
+
+namespace {
+
+// Same as sd-bus, a fallback covers all the paths below prefix, and "/" covers
+// every path except itself.
+bool isPathBelow(const std::string &path, const std::string &prefix) {
+    if (prefix == "/") {
+        return path.size() > 1;
+    }
+    return path.size() > prefix.size() &&
+           stringutils::startsWith(path, prefix) &&
+           path[prefix.size()] == '/';
+}
+
+} // namespace
+
+bool BusPrivate::hasFallback(const std::string &path) const {
+    for (const auto &fallback : fallbacks_.view()) {
+        if (isPathBelow(path, fallback.prefix_)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DBusObjectVTableSlot *
+BusPrivate::findFallbackSlot(const std::string &path,
+                             const std::string &interface) {
+    for (const auto &fallback : fallbacks_.view()) {
+        if (fallback.interface_ != interface ||
+            !isPathBelow(path, fallback.prefix_) || !fallback.finder_) {
+            continue;
+        }
+        auto *obj = fallback.finder_(path);
+        if (!obj) {
+            continue;
+        }
+        for (auto &item : boundObjects_.view(path)) {
+            auto *slot = item.get();
+            if (slot && slot->obj_ == obj && slot->interface_ == interface) {
+                return slot;
+            }
+        }
+    }
     return nullptr;
 }
 
 bool BusPrivate::objectVTableCallback(Message &message) {
-    if (!objectRegistration_.hasKey(message.path())) {
+    const bool isFallback = !objectRegistration_.hasKey(message.path());
+    if (isFallback && !hasFallback(message.path())) {
         return false;
     }
     if (message.interface() == "org.freedesktop.DBus.Introspectable") {
@@ -301,11 +365,23 @@ bool BusPrivate::objectVTableCallback(Message &message) {
         }
         std::string xml = xmlHeader;
         bool hasProperties = false;
-        for (auto &item : objectRegistration_.view(message.path())) {
-            if (auto *slot = item.get()) {
-                hasProperties =
-                    hasProperties || !slot->objPriv_->properties_.empty();
-                xml += slot->xml_;
+        auto appendSlot = [&xml, &hasProperties](DBusObjectVTableSlot *slot) {
+            hasProperties =
+                hasProperties || !slot->objPriv_->properties_.empty();
+            xml += slot->xml_;
+        };
+        if (isFallback) {
+            for (const auto &fallback : fallbacks_.view()) {
+                if (auto *slot = findFallbackSlot(message.path(),
+                                                  fallback.interface_)) {
+                    appendSlot(slot);
+                }
+            }
+        } else {
+            for (auto &item : objectRegistration_.view(message.path())) {
+                if (auto *slot = item.get()) {
+                    appendSlot(slot);
+                }
             }
         }
         if (hasProperties) {
@@ -397,7 +473,10 @@ bool BusPrivate::objectVTableCallback(Message &message) {
             if (method->signature() != message.signature()) {
                 return false;
             }
-            return method->handler()(std::move(message));
+            return methodStatistics_.call(
+                slot->obj_, method, [method, &message]() {
+                    return method->handler()(std::move(message));
+                });
         }
         return false;
     }
@@ -595,7 +674,8 @@ dbus_bool_t DBusAddTimeout(DBusTimeout *timeout, void *data) {
                         bus->dispatch();
                     }
                     return true;
-                }));
+                },
+                "DBus/Timeout"));
     } catch (const EventLoopException &) {
         return false;
     }
@@ -637,10 +717,13 @@ void Bus::attachEventLoop(EventLoop *loop) {
             break;
         }
         if (!d->deferEvent_) {
-            d->deferEvent_ = d->loop_->addDeferEvent([d](EventSource *) {
-                d->dispatch();
-                return true;
-            });
+            d->deferEvent_ = d->loop_->addDeferEvent(
+                [d](EventSource *) {
+                    d->dispatch();
+                    return true;
+                },
+                "DBus/Dispatch");
+            d->loop_->setPriority(d->deferEvent_.get(), EventPriority::High);
             d->deferEvent_->setOneShot();
         }
         dbus_connection_set_dispatch_status_function(
@@ -769,6 +852,27 @@ bool Bus::addObjectVTable(const std::string &path, const std::string &interface,
     return true;
 }
 
+std::unique_ptr<Slot> Bus::addObjectVTableFallback(
+    const std::string &prefix, const std::string &interface,
+    ObjectVTableBase & /*prototype*/, ObjectVTableFinder finder) {
+    FCITX_D();
+    auto slot = std::make_unique<DBusFallbackSlot>();
+    slot->handler_ = d->fallbacks_.add(
+        DBusObjectVTableFallback{prefix, interface, std::move(finder)});
+    return slot;
+}
+
+void Bus::bindObjectVTable(const std::string &path,
+                           const std::string &interface,
+                           ObjectVTableBase &obj) {
+    FCITX_D();
+    auto slot = std::make_unique<DBusObjectVTableSlot>(path, interface, &obj,
+                                                       obj.d_func());
+    slot->handler_ = d->boundObjects_.add(path, slot->watch());
+    slot->bus_ = d->watch();
+    obj.setSlot(slot.release());
+}
+
 const char *Bus::impl() { return "libdbus"; }
 
 void *Bus::nativeHandle() const {
@@ -844,4 +948,24 @@ void Bus::flush() {
     FCITX_D();
     dbus_connection_flush(d->conn_.get());
 }
+
+void Bus::setMethodStatisticsEnabled(bool enabled) {
+    FCITX_D();
+    d->methodStatistics_.setEnabled(enabled);
+}
+
+bool Bus::isMethodStatisticsEnabled() const {
+    FCITX_D();
+    return d->methodStatistics_.isEnabled();
+}
+
+std::vector<MethodCallStatistic> Bus::methodStatistics() const {
+    FCITX_D();
+    return d->methodStatistics_.statistics();
+}
+
+void Bus::resetMethodStatistics() {
+    FCITX_D();
+    d->methodStatistics_.reset();
+}
 } // namespace fcitx::dbus
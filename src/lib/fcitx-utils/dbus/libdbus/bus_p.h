@@ -11,6 +11,7 @@
 #include "fcitx-utils/event.h"
 #include "../../log.h"
 #include "../bus.h"
+#include "../methodstatistics_p.h"
 #include "servicenamecache.h"
 
 namespace fcitx {
@@ -58,6 +59,12 @@ public:
     std::string xml_;
 };
 
+struct DBusObjectVTableFallback {
+    std::string prefix_;
+    std::string interface_;
+    ObjectVTableFinder finder_;
+};
+
 class BusWatches;
 
 class BusPrivate : public TrackableObject<BusPrivate> {
@@ -92,6 +99,9 @@ public:
 
     DBusObjectVTableSlot *findSlot(const std::string &path,
                                    const std::string &interface);
+    bool hasFallback(const std::string &path) const;
+    DBusObjectVTableSlot *findFallbackSlot(const std::string &path,
+                                           const std::string &interface);
     bool objectVTableCallback(Message &message);
 
     static void DBusConnectionCloser(DBusConnection *conn) {
@@ -115,8 +125,14 @@ public:
     MultiHandlerTable<std::string,
                       TrackableObjectReference<DBusObjectVTableSlot>>
         objectRegistration_;
+    // Objects bound with bindObjectVTable, only reachable from fallbacks_.
+    MultiHandlerTable<std::string,
+                      TrackableObjectReference<DBusObjectVTableSlot>>
+        boundObjects_;
+    HandlerTable<DBusObjectVTableFallback> fallbacks_;
     std::unique_ptr<EventSource> deferEvent_;
     std::unique_ptr<ServiceNameCache> nameCache_;
+    MethodCallStatistics methodStatistics_;
 };
 
 class DBusObjectSlot : public Slot {
@@ -153,6 +169,11 @@ public:
     std::unique_ptr<HandlerTableEntryBase> handler_;
 };
 
+class DBusFallbackSlot : public Slot {
+public:
+    std::unique_ptr<HandlerTableEntryBase> handler_;
+};
+
 class DBusAsyncCallSlot : public Slot {
 public:
     DBusAsyncCallSlot(MessageCallback callback)
@@ -12,6 +12,7 @@
 #include <stdexcept>
 #include "../../misc_p.h"
 #include "../../unixfd.h"
+#include "../methodstatistics_p.h"
 #include "../variant.h"
 #include "bus_p.h"
 #include "message_p.h"
@@ -58,6 +59,7 @@ Message Message::createError(const char *name, const char *message) const {
     if (!dmsg) {
         return {};
     }
+    errorReplyCount() += 1;
     return MessagePrivate::fromDBusMessage(d->bus_, dmsg, false, false);
 }
 
@@ -347,6 +349,23 @@ Message &Message::operator>>(std::string &s) {
     return *this;
 }
 
+Message &Message::operator>>(std::string_view &s) {
+    if (!(*this)) {
+        return *this;
+    }
+    FCITX_D();
+    char *p = nullptr;
+
+    if (dbus_message_iter_get_arg_type(d->iterator()) == DBUS_TYPE_STRING) {
+        dbus_message_iter_get_basic(d->iterator(), &p);
+        s = p;
+        dbus_message_iter_next(d->iterator());
+    } else {
+        d->lastError_ = -EINVAL;
+    }
+    return *this;
+}
+
 Message &Message::operator<<(const ObjectPath &o) {
     if (!(*this)) {
         return *this;
@@ -12,8 +12,10 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 #include <fcitx-utils/dbus/message_details.h> // IWYU pragma: export
 #include <fcitx-utils/log.h>
@@ -191,30 +193,28 @@ class FCITXUTILS_EXPORT ContainerEnd {};
 
 class MessagePrivate;
 
+// Read and write all the elements with one fold expression, instead of
+// recursing once per element.
 template <typename Tuple, std::size_t N>
 struct TupleMarshaller {
     static void marshall(Message &msg, const Tuple &t) {
-        TupleMarshaller<Tuple, N - 1>::marshall(msg, t);
-        msg << std::get<N - 1>(t);
+        marshall(msg, t, std::make_index_sequence<N>());
     }
     static void unmarshall(Message &msg, Tuple &t) {
-        TupleMarshaller<Tuple, N - 1>::unmarshall(msg, t);
-        msg >> std::get<N - 1>(t);
+        unmarshall(msg, t, std::make_index_sequence<N>());
     }
-};
 
-template <typename Tuple>
-struct TupleMarshaller<Tuple, 1> {
-    static void marshall(Message &msg, const Tuple &t) {
-        msg << std::get<0>(t);
+private:
+    template <std::size_t... I>
+    static void marshall(Message &msg, [[maybe_unused]] const Tuple &t,
+                         std::index_sequence<I...>) {
+        static_cast<void>((msg << ... << std::get<I>(t)));
+    }
+    template <std::size_t... I>
+    static void unmarshall(Message &msg, [[maybe_unused]] Tuple &t,
+                           std::index_sequence<I...>) {
+        static_cast<void>((msg >> ... >> std::get<I>(t)));
     }
-    static void unmarshall(Message &msg, Tuple &t) { msg >> std::get<0>(t); }
-};
-
-template <typename Tuple>
-struct TupleMarshaller<Tuple, 0> {
-    static void marshall(Message &, const Tuple &) {}
-    static void unmarshall(Message &, Tuple &) {}
 };
 
 /**
@@ -425,6 +425,15 @@ public:
     Message &operator>>(uint64_t &v);
     Message &operator>>(double &v);
     Message &operator>>(std::string &s);
+    /**
+     * Read a string without copying it.
+     *
+     * The view points into the message buffer, and is only valid while the
+     * message is alive.
+     *
+     * @since 5.1.12
+     */
+    Message &operator>>(std::string_view &s);
     Message &operator>>(ObjectPath &o);
     Message &operator>>(Signature &s);
     Message &operator>>(UnixFD &fd);
@@ -501,7 +510,7 @@ public:
             while (!end()) {
                 T temp;
                 if (*this >> temp) {
-                    t.push_back(temp);
+                    t.push_back(std::move(temp));
                 } else {
                     break;
                 }
@@ -8,6 +8,8 @@
 #define _FCITX_UTILS_DBUS_MESSAGE_DETAILS_H_
 
 #include <cstdint>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 #include <fcitx-utils/metastring.h>
@@ -84,6 +86,12 @@ DBUS_SIGNATURE_TRAITS(UnixFD, 'h');
 DBUS_SIGNATURE_TRAITS(ObjectPath, 'o');
 DBUS_SIGNATURE_TRAITS(Variant, 'v');
 
+// Borrowed string, "s" is still read as std::string by default.
+template <>
+struct DBusSignatureTraits<std::string_view> {
+    typedef MetaString<'s'> signature;
+};
+
 template <typename K, typename V>
 struct DBusSignatureTraits<std::pair<K, V>> {
     typedef ConcatMetaStringType<typename DBusSignatureTraits<K>::signature,
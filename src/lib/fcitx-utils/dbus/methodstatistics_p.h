@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_DBUS_METHODSTATISTICS_P_H_
+#define _FCITX_UTILS_DBUS_METHODSTATISTICS_P_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../event.h"
+#include "bus.h"
+#include "objectvtable.h"
+
+namespace fcitx::dbus {
+
+// Number of error replies created by current thread, used to tell whether a
+// method call fails.
+inline uint64_t &errorReplyCount() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+/**
+ * Per method call statistics of a Bus.
+ *
+ * Nothing is measured unless the statistics is enabled.
+ */
+class MethodCallStatistics {
+public:
+    bool isEnabled() const { return enabled_; }
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+
+    template <typename Callback>
+    auto call(ObjectVTableBase *vtable, ObjectVTableMethod *method,
+              const Callback &callback) {
+        if (!enabled_) {
+            return callback();
+        }
+        // Method may destroy the object or reset the statistics.
+        std::pair<std::string, std::string> key{vtable->interface(),
+                                                method->name()};
+        const auto errors = errorReplyCount();
+        const auto start = now(CLOCK_MONOTONIC);
+        auto result = callback();
+        const auto time = now(CLOCK_MONOTONIC) - start;
+        auto &record = records_[std::move(key)];
+        record.callCount += 1;
+        if (errorReplyCount() != errors) {
+            record.errorCount += 1;
+        }
+        record.totalTime += time;
+        record.maxTime = std::max(record.maxTime, time);
+        size_t bucket = 0;
+        while (bucket + 1 < MethodCallStatistic::latencyBuckets &&
+               (time >> bucket) != 0) {
+            bucket++;
+        }
+        record.latencyHistogram[bucket] += 1;
+        return result;
+    }
+
+    std::vector<MethodCallStatistic> statistics() const {
+        std::vector<MethodCallStatistic> result;
+        for (const auto &[key, record] : records_) {
+            auto &stat = result.emplace_back(record);
+            stat.interface = key.first;
+            stat.method = key.second;
+        }
+        return result;
+    }
+
+    void reset() { records_.clear(); }
+
+private:
+    bool enabled_ = false;
+    std::map<std::pair<std::string, std::string>, MethodCallStatistic>
+        records_;
+};
+
+} // namespace fcitx::dbus
+
+#endif // _FCITX_UTILS_DBUS_METHODSTATISTICS_P_H_
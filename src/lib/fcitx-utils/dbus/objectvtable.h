@@ -12,6 +12,8 @@
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <fcitx-utils/dbus/message.h>
 #include <fcitx-utils/flags.h>
@@ -120,6 +122,22 @@ struct ReturnValueHelper<void> {
     }
 };
 
+/**
+ * Fail to compile if the arguments of a member function do not match the DBus
+ * signature. Overloaded function can not be checked and is skipped.
+ *
+ * @since 5.1.12
+ */
+#define FCITX_OBJECT_VTABLE_CHECK_SIGNATURE(FUNCTION, SIGNATURE)               \
+    auto FUNCTION##Probe = [](auto *self)                                      \
+        -> decltype(&std::remove_pointer_t<decltype(self)>::FUNCTION) {        \
+        return nullptr;                                                        \
+    };                                                                         \
+    static_assert(::fcitx::dbus::methodMatchesSignature<                       \
+                      fcitxMakeMetaString(SIGNATURE),                          \
+                      decltype(FUNCTION##Probe), decltype(this)>(),            \
+                  "Arguments of " #FUNCTION " do not match " SIGNATURE)
+
 /**
  * Register a class member function as a DBus method.
  *
@@ -139,6 +157,29 @@ struct ReturnValueHelper<void> {
                 FCITX_STRING_TO_DBUS_TYPE(RET),                                \
                 FCITX_STRING_TO_DBUS_TUPLE(SIGNATURE)>(                        \
                 this, [this](auto &&...args) {                                 \
+                    FCITX_OBJECT_VTABLE_CHECK_SIGNATURE(FUNCTION, SIGNATURE);  \
+                    return this->FUNCTION(                                     \
+                        std::forward<decltype(args)>(args)...);                \
+                })                                                             \
+    }
+
+/**
+ * Same as FCITX_OBJECT_VTABLE_METHOD, but string arguments are passed as
+ * std::string_view that points into the message, to avoid a copy. The view is
+ * only valid during the call.
+ *
+ * @since 5.1.12
+ */
+#define FCITX_OBJECT_VTABLE_METHOD_BORROWED(FUNCTION, FUNCTION_NAME,          \
+                                            SIGNATURE, RET)                    \
+    ::fcitx::dbus::ObjectVTableMethod FUNCTION##Method {                       \
+        this, FUNCTION_NAME, SIGNATURE, RET,                                   \
+            ::fcitx::dbus::makeObjectVTablePropertyObjectMethodAdaptor<        \
+                FCITX_STRING_TO_DBUS_TYPE(RET),                                \
+                ::fcitx::dbus::BorrowedArgsType<                               \
+                    FCITX_STRING_TO_DBUS_TUPLE(SIGNATURE)>>(                   \
+                this, [this](auto &&...args) {                                 \
+                    FCITX_OBJECT_VTABLE_CHECK_SIGNATURE(FUNCTION, SIGNATURE);  \
                     return this->FUNCTION(                                     \
                         std::forward<decltype(args)>(args)...);                \
                 })                                                             \
@@ -392,6 +433,57 @@ public:
     }
 };
 
+template <typename... Args>
+using MethodArgsSignature = typename DBusSignatureTraits<
+    std::tuple<std::remove_cv_t<std::remove_reference_t<Args>>...>>::signature;
+
+template <typename Signature, typename Class, typename Ret, typename... Args>
+constexpr bool matchesSignature(Ret (Class::*)(Args...)) {
+    return std::is_same_v<MethodArgsSignature<Args...>, Signature>;
+}
+
+template <typename Signature, typename Class, typename Ret, typename... Args>
+constexpr bool matchesSignature(Ret (Class::*)(Args...) const) {
+    return std::is_same_v<MethodArgsSignature<Args...>, Signature>;
+}
+
+template <typename Signature, typename Ret, typename... Args>
+constexpr bool matchesSignature(Ret (*)(Args...)) {
+    return std::is_same_v<MethodArgsSignature<Args...>, Signature>;
+}
+
+// Probe returns the pointer to the function, and is not invocable if the
+// function is overloaded.
+template <typename Signature, typename Probe, typename Self>
+constexpr bool methodMatchesSignature() {
+    if constexpr (std::is_invocable_v<Probe, Self>) {
+        return matchesSignature<Signature>(std::invoke_result_t<Probe, Self>{});
+    } else {
+        return true;
+    }
+}
+
+template <typename T>
+struct BorrowedArg {
+    typedef T type;
+};
+
+template <>
+struct BorrowedArg<std::string> {
+    typedef std::string_view type;
+};
+
+template <typename T>
+struct BorrowedArgs;
+
+template <typename... Args>
+struct BorrowedArgs<std::tuple<Args...>> {
+    typedef std::tuple<typename BorrowedArg<Args>::type...> type;
+};
+
+template <typename T>
+using BorrowedArgsType = typename BorrowedArgs<T>::type;
+
 template <typename Ret, typename Args, typename Callback>
 class ObjectVTablePropertyObjectMethodAdaptor {
 public:
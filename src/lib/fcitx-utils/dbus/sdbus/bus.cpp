@@ -5,7 +5,10 @@
  *
  */
 
+#include <poll.h>
+#include <cstdint>
 #include <stdexcept>
+#include "../../event.h"
 #include "../../log.h"
 #include "bus_p.h"
 #include "message_p.h"
@@ -15,16 +18,81 @@ namespace fcitx::dbus {
 
 Slot::~Slot() {}
 
+namespace {
+
+// Upper bound of the time spent on draining queued messages in one wakeup, so
+// a flood of messages does not starve the other event sources.
+constexpr uint64_t dispatchBudget = 5000;
+
+} // namespace
+
 class BusPrivate {
 public:
     BusPrivate() : bus_(nullptr) {}
 
     ~BusPrivate() { sd_bus_flush_close_unref(bus_); }
 
+    // Process all the messages that are already available, instead of one
+    // message per event loop iteration, and flush the output once after that.
+    void dispatch() {
+        const auto deadline = now(CLOCK_MONOTONIC) + dispatchBudget;
+        dispatching_ = true;
+        int r;
+        do {
+            r = sd_bus_process(bus_, nullptr);
+        } while (r > 0 && now(CLOCK_MONOTONIC) < deadline);
+        dispatching_ = false;
+        if (needFlush_) {
+            needFlush_ = false;
+            sd_bus_flush(bus_);
+        }
+        updateEvents();
+    }
+
+    void updateEvents() {
+        int events = sd_bus_get_events(bus_);
+        if (events < 0) {
+            ioEvent_->setEnabled(false);
+        } else {
+            IOEventFlags flags;
+            if (events & POLLIN) {
+                flags |= IOEventFlag::In;
+            }
+            if (events & POLLOUT) {
+                flags |= IOEventFlag::Out;
+            }
+            ioEvent_->setEvents(flags);
+            ioEvent_->setEnabled(true);
+        }
+
+        uint64_t usec;
+        if (sd_bus_get_timeout(bus_, &usec) < 0 || usec == UINT64_MAX) {
+            timeEvent_->setEnabled(false);
+        } else {
+            timeEvent_->setTime(usec);
+            timeEvent_->setOneShot();
+        }
+    }
+
+    static MethodCallStatistics &methodStatistics(Bus *bus) {
+        return bus->d_func()->methodStatistics_;
+    }
+
     sd_bus *bus_;
     EventLoop *eventLoop_ = nullptr;
+    MethodCallStatistics methodStatistics_;
+    std::unique_ptr<EventSourceIO> ioEvent_;
+    std::unique_ptr<EventSourceTime> timeEvent_;
+    std::unique_ptr<EventSource> postEvent_;
+    std::unique_ptr<EventSource> exitEvent_;
+    bool dispatching_ = false;
+    bool needFlush_ = false;
 };
 
+MethodCallStatistics &methodCallStatistics(Bus *bus) {
+    return BusPrivate::methodStatistics(bus);
+}
+
 Bus::Bus(BusType type) : d_ptr(std::make_unique<BusPrivate>()) {
     decltype(&sd_bus_open) func;
     switch (type) {
@@ -117,16 +185,44 @@ void Bus::attachEventLoop(EventLoop *loop) {
     if (d->eventLoop_) {
         return;
     }
-    sd_event *event = static_cast<sd_event *>(loop->nativeHandle());
-    if (sd_bus_attach_event(d->bus_, event, 0) >= 0) {
-        d->eventLoop_ = loop;
+    int fd = sd_bus_get_fd(d->bus_);
+    if (fd < 0) {
+        return;
     }
+    d->ioEvent_ = loop->addIOEvent(
+        fd, IOEventFlag::In, [d](EventSourceIO *, int, IOEventFlags) {
+            d->dispatch();
+            return true;
+        });
+    d->timeEvent_ = loop->addTimeEvent(CLOCK_MONOTONIC, 0, 0,
+                                       [d](EventSourceTime *, uint64_t) {
+                                           d->dispatch();
+                                           return true;
+                                       });
+    // Input from frontends goes through the bus.
+    loop->setPriority(d->ioEvent_.get(), EventPriority::High);
+    loop->setPriority(d->timeEvent_.get(), EventPriority::High);
+    // Messages may be queued by any other event source, e.g. a timer that
+    // sends a signal, or a blocking call that reads ahead.
+    d->postEvent_ = loop->addPostEvent([d](EventSource *) {
+        d->updateEvents();
+        return true;
+    });
+    d->exitEvent_ = loop->addExitEvent([d](EventSource *) {
+        sd_bus_flush(d->bus_);
+        return true;
+    });
+    d->eventLoop_ = loop;
+    d->updateEvents();
 }
 
 void Bus::detachEventLoop() {
     FCITX_D();
     if (d->eventLoop_) {
-        sd_bus_detach_event(d->bus_);
+        d->ioEvent_.reset();
+        d->timeEvent_.reset();
+        d->postEvent_.reset();
+        d->exitEvent_.reset();
         d->eventLoop_ = nullptr;
     }
 }
@@ -217,6 +313,45 @@ bool Bus::addObjectVTable(const std::string &path, const std::string &interface,
     return true;
 }
 
+int SDFallbackFindCallback(sd_bus *, const char *path, const char *,
+                           void *userdata, void **found, sd_bus_error *) {
+    auto *slot = static_cast<SDFallbackSlot *>(userdata);
+    if (!slot || !slot->finder_) {
+        return 0;
+    }
+    auto *obj = slot->finder_(path);
+    if (!obj) {
+        return 0;
+    }
+    *found = obj;
+    return 1;
+}
+
+std::unique_ptr<Slot> Bus::addObjectVTableFallback(
+    const std::string &prefix, const std::string &interface,
+    ObjectVTableBase &prototype, ObjectVTableFinder finder) {
+    FCITX_D();
+    auto slot = std::make_unique<SDFallbackSlot>(std::move(finder));
+    sd_bus_slot *sdSlot;
+    int r = sd_bus_add_fallback_vtable(
+        d->bus_, &sdSlot, prefix.c_str(), interface.c_str(),
+        prototype.d_func()->toSDBusVTable(&prototype), SDFallbackFindCallback,
+        slot.get());
+    if (r < 0) {
+        return nullptr;
+    }
+
+    slot->slot_ = sdSlot;
+
+    return slot;
+}
+
+void Bus::bindObjectVTable(const std::string &path,
+                           const std::string &interface,
+                           ObjectVTableBase &obj) {
+    obj.setSlot(new SDVTableSlot(this, path, interface));
+}
+
 const char *Bus::impl() { return "sdbus"; }
 
 void *Bus::nativeHandle() const {
@@ -285,6 +420,31 @@ std::string Bus::address() {
 
 void Bus::flush() {
     FCITX_D();
+    // Output is flushed once after all the queued messages are processed.
+    if (d->dispatching_) {
+        d->needFlush_ = true;
+        return;
+    }
     sd_bus_flush(d->bus_);
 }
+
+void Bus::setMethodStatisticsEnabled(bool enabled) {
+    FCITX_D();
+    d->methodStatistics_.setEnabled(enabled);
+}
+
+bool Bus::isMethodStatisticsEnabled() const {
+    FCITX_D();
+    return d->methodStatistics_.isEnabled();
+}
+
+std::vector<MethodCallStatistic> Bus::methodStatistics() const {
+    FCITX_D();
+    return d->methodStatistics_.statistics();
+}
+
+void Bus::resetMethodStatistics() {
+    FCITX_D();
+    d->methodStatistics_.reset();
+}
 } // namespace fcitx::dbus
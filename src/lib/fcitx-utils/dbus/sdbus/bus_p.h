@@ -8,6 +8,7 @@
 #define _FCITX_UTILS_DBUS_BUS_P_H_
 
 #include "../bus.h"
+#include "../methodstatistics_p.h"
 #include "sd-bus-wrap.h"
 
 namespace fcitx {
@@ -16,6 +17,8 @@ namespace dbus {
 
 int SDMessageCallback(sd_bus_message *m, void *userdata, sd_bus_error *);
 
+MethodCallStatistics &methodCallStatistics(Bus *bus);
+
 class ScopedSDBusError {
 public:
     ScopedSDBusError() { error_ = SD_BUS_ERROR_NULL; }
@@ -61,6 +64,22 @@ public:
     MessageCallback callback_;
     sd_bus_slot *slot_;
 };
+
+class SDFallbackSlot : public Slot {
+public:
+    SDFallbackSlot(ObjectVTableFinder finder)
+        : finder_(std::move(finder)), slot_(nullptr) {}
+
+    ~SDFallbackSlot() {
+        if (slot_) {
+            sd_bus_slot_set_userdata(slot_, nullptr);
+            sd_bus_slot_unref(slot_);
+        }
+    }
+
+    ObjectVTableFinder finder_;
+    sd_bus_slot *slot_;
+};
 } // namespace dbus
 } // namespace fcitx
 
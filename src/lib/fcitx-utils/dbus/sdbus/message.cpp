@@ -14,6 +14,7 @@
 #include <asm-generic/errno-base.h>
 #include "../../misc_p.h"
 #include "../../unixfd.h"
+#include "../methodstatistics_p.h"
 #include "../variant.h"
 #include "bus_p.h"
 #include "message_p.h"
@@ -63,6 +64,7 @@ Message Message::createError(const char *name, const char *message) const {
     sd_bus_error error = SD_BUS_ERROR_MAKE_CONST(name, message);
     auto *msgD = msg.d_func();
     int r = sd_bus_message_new_method_error(d->msg_, &msgD->msg_, &error);
+    errorReplyCount() += 1;
     if (r < 0) {
         msgD->type_ = MessageType::Invalid;
     } else {
@@ -298,6 +300,20 @@ Message &Message::operator>>(std::string &s) {
     return *this;
 }
 
+Message &Message::operator>>(std::string_view &s) {
+    if (!(*this)) {
+        return *this;
+    }
+    FCITX_D();
+    char *p = nullptr;
+    int r = d->lastError_ =
+        sd_bus_message_read_basic(d->msg_, SD_BUS_TYPE_STRING, &p);
+    if (r >= 0) {
+        s = p;
+    }
+    return *this;
+}
+
 Message &Message::operator<<(const ObjectPath &o) {
     if (!(*this)) {
         return *this;
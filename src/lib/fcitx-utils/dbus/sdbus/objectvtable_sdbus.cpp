@@ -38,7 +38,10 @@ int SDMethodCallback(sd_bus_message *m, void *userdata, sd_bus_error *) {
         return 0;
     }
     try {
-        method->handler()(MessagePrivate::fromSDBusMessage(m));
+        methodCallStatistics(vtable->bus())
+            .call(vtable, method, [method, m]() {
+                return method->handler()(MessagePrivate::fromSDBusMessage(m));
+            });
         return 1;
     } catch (const std::exception &e) {
         // some abnormal things threw
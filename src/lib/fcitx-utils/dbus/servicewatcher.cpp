@@ -6,76 +6,261 @@
  */
 
 #include "servicewatcher.h"
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include "../event.h"
 #include "../trackableobject.h"
 
 namespace fcitx::dbus {
 
+namespace {
+
+bool isUniqueName(const std::string &name) {
+    return !name.empty() && name[0] == ':';
+}
+
+// Called with (name, oldOwner, newOwner, initial), initial is true for the
+// result of GetNameOwner.
+using NameOwnerCallback =
+    std::function<void(const std::string &, const std::string &,
+                       const std::string &, bool)>;
+
+/**
+ * Owners of the names on one bus, shared by all the ServiceWatcher on it.
+ *
+ * A single match rule receives all the NameOwnerChanged signals. Unique names
+ * that show up after that are always known, so a new client does not need a
+ * GetNameOwner roundtrip. Other names are only tracked while watched.
+ */
+class NameOwnerCache : public TrackableObject<NameOwnerCache> {
+public:
+    explicit NameOwnerCache(Bus &bus) : bus_(&bus) {
+        slot_ = bus_->addMatch(
+            MatchRule("org.freedesktop.DBus", "/org/freedesktop/DBus",
+                      "org.freedesktop.DBus", "NameOwnerChanged"),
+            [this](Message &msg) {
+                std::string name, oldOwner, newOwner;
+                msg >> name >> oldOwner >> newOwner;
+                if (name.empty()) {
+                    return false;
+                }
+                querySlots_.erase(name);
+                if (!newOwner.empty() &&
+                    (isUniqueName(name) || watched_.count(name))) {
+                    owners_[name] = newOwner;
+                } else if (newOwner.empty() && watched_.count(name)) {
+                    owners_[name] = "";
+                } else {
+                    owners_.erase(name);
+                }
+                notify(name, oldOwner, newOwner, false);
+                return false;
+            });
+    }
+
+    ~NameOwnerCache() {
+        std::lock_guard<std::mutex> lock(cacheMutex());
+        auto &caches = cacheMap();
+        auto iter = caches.find(bus_);
+        if (iter != caches.end() && iter->second.expired()) {
+            caches.erase(iter);
+        }
+    }
+
+    static std::shared_ptr<NameOwnerCache> get(Bus &bus) {
+        std::lock_guard<std::mutex> lock(cacheMutex());
+        auto &cache = cacheMap()[&bus];
+        auto result = cache.lock();
+        if (!result) {
+            result = std::make_shared<NameOwnerCache>(bus);
+            cache = result;
+        }
+        return result;
+    }
+
+    bool isValid() const { return slot_ != nullptr; }
+    Bus *bus() const { return bus_; }
+
+    // Return nullptr if the owner is not known yet, empty string if the name
+    // has no owner.
+    const std::string *owner(const std::string &name) const {
+        auto iter = owners_.find(name);
+        if (iter == owners_.end()) {
+            return nullptr;
+        }
+        return &iter->second;
+    }
+
+    bool addWatch(const std::string &name) {
+        auto &count = watched_[name];
+        if (++count > 1 || owners_.count(name) || querySlots_.count(name)) {
+            return true;
+        }
+        auto querySlot = bus_->serviceOwnerAsync(
+            name, 0, [this, name](Message &msg) {
+                // Name itself may be gone later, put it on the stack.
+                std::string pivotName = name;
+                auto protector = watch();
+                std::string newName;
+                if (msg.type() != dbus::MessageType::Error) {
+                    msg >> newName;
+                } else if (msg.errorName() !=
+                           "org.freedesktop.DBus.Error.NameHasNoOwner") {
+                    querySlots_.erase(pivotName);
+                    return false;
+                }
+                if (watched_.count(pivotName)) {
+                    owners_[pivotName] = newName;
+                }
+                notify(pivotName, "", newName, true);
+                // "this" maybe deleted as well because it's a member
+                // in lambda.
+                if (auto *that = protector.get()) {
+                    that->querySlots_.erase(pivotName);
+                }
+                return false;
+            });
+        if (!querySlot) {
+            removeWatch(name);
+            return false;
+        }
+        querySlots_.emplace(name, std::move(querySlot));
+        return true;
+    }
+
+    void removeWatch(const std::string &name) {
+        auto iter = watched_.find(name);
+        if (iter == watched_.end() || --iter->second > 0) {
+            return;
+        }
+        watched_.erase(iter);
+        querySlots_.erase(name);
+        // A live unique name is still tracked by NameOwnerChanged.
+        auto ownerIter = owners_.find(name);
+        if (ownerIter != owners_.end() &&
+            (!isUniqueName(name) || ownerIter->second.empty())) {
+            owners_.erase(ownerIter);
+        }
+    }
+
+    FCITX_NODISCARD std::unique_ptr<HandlerTableEntry<NameOwnerCallback>>
+    watchOwner(NameOwnerCallback callback) {
+        return handlers_.add(std::move(callback));
+    }
+
+private:
+    static std::mutex &cacheMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::unordered_map<Bus *, std::weak_ptr<NameOwnerCache>> &
+    cacheMap() {
+        static std::unordered_map<Bus *, std::weak_ptr<NameOwnerCache>> map;
+        return map;
+    }
+
+    void notify(const std::string &name, const std::string &oldOwner,
+                const std::string &newOwner, bool initial) {
+        for (auto &handler : handlers_.view()) {
+            if (handler) {
+                handler(name, oldOwner, newOwner, initial);
+            }
+        }
+    }
+
+    Bus *bus_;
+    std::unique_ptr<Slot> slot_;
+    std::unordered_map<std::string, std::string> owners_;
+    std::unordered_map<std::string, int> watched_;
+    std::unordered_map<std::string, std::unique_ptr<Slot>> querySlots_;
+    HandlerTable<NameOwnerCallback> handlers_;
+};
+
+} // namespace
+
 class ServiceWatcherPrivate : public TrackableObject<ServiceWatcherPrivate> {
 public:
     ServiceWatcherPrivate(Bus &bus)
         : bus_(&bus),
           watcherMap_(
               [this](const std::string &key) {
-                  auto slot = bus_->addMatch(
-                      MatchRule("org.freedesktop.DBus", "/org/freedesktop/DBus",
-                                "org.freedesktop.DBus", "NameOwnerChanged",
-                                {key}),
-                      [this](Message &msg) {
-                          std::string name, oldOwner, newOwner;
-                          msg >> name >> oldOwner >> newOwner;
-                          querySlots_.erase(name);
-
-                          auto view = watcherMap_.view(name);
-                          for (auto &entry : view) {
-                              entry(name, oldOwner, newOwner);
-                          }
-                          return false;
-                      });
-                  auto querySlot = bus_->serviceOwnerAsync(
-                      key, 0, [this, key](Message &msg) {
-                          // Key itself may be gone later, put it on the stack.
-                          std::string pivotKey = key;
-                          auto protector = watch();
-                          std::string newName;
-                          if (msg.type() != dbus::MessageType::Error) {
-                              msg >> newName;
-                          } else {
-                              if (msg.errorName() !=
-                                  "org.freedesktop.DBus.Error.NameHasNoOwner") {
-                                  return false;
-                              }
-                          }
-                          for (auto &entry : watcherMap_.view(pivotKey)) {
-                              entry(pivotKey, "", newName);
-                          }
-                          // "this" maybe deleted as well because it's a member
-                          // in lambda.
-                          if (auto *that = protector.get()) {
-                              that->querySlots_.erase(pivotKey);
-                          }
-                          return false;
-                      });
-                  if (!slot || !querySlot) {
+                  if (!ensureCache() || !cache_->addWatch(key)) {
                       return false;
                   }
-                  slots_.emplace(std::piecewise_construct,
-                                 std::forward_as_tuple(key),
-                                 std::forward_as_tuple(std::move(slot)));
-                  querySlots_.emplace(
-                      std::piecewise_construct, std::forward_as_tuple(key),
-                      std::forward_as_tuple(std::move(querySlot)));
+                  pendingKeys_.insert(key);
+                  if (cache_->owner(key)) {
+                      resolveLater(key);
+                  }
                   return true;
               },
               [this](const std::string &key) {
-                  slots_.erase(key);
-                  querySlots_.erase(key);
+                  pendingKeys_.erase(key);
+                  deferEvents_.erase(key);
+                  cache_->removeWatch(key);
               }) {}
 
+    ~ServiceWatcherPrivate() {
+        if (!cache_) {
+            return;
+        }
+        for (const auto &key : watcherMap_.keys()) {
+            cache_->removeWatch(key);
+        }
+    }
+
+    bool ensureCache() {
+        if (!cache_) {
+            cache_ = NameOwnerCache::get(*bus_);
+            cacheHandler_ = cache_->watchOwner(
+                [this](const std::string &name, const std::string &oldOwner,
+                       const std::string &newOwner, bool initial) {
+                    if (!watcherMap_.hasKey(name)) {
+                        return;
+                    }
+                    if (pendingKeys_.erase(name) == 0 && initial) {
+                        return;
+                    }
+                    deferEvents_.erase(name);
+                    for (auto &entry : watcherMap_.view(name)) {
+                        entry(name, initial ? "" : oldOwner, newOwner);
+                    }
+                });
+        }
+        return cache_->isValid();
+    }
+
+    // The owner is already known, but the callback should still be called
+    // after watchService returns.
+    void resolveLater(const std::string &key) {
+        auto *loop = bus_->eventLoop();
+        if (!loop) {
+            return;
+        }
+        deferEvents_[key] = loop->addDeferEvent([this, key](EventSource *) {
+            std::string pivotKey = key;
+            auto protector = watch();
+            const auto *owner = cache_->owner(pivotKey);
+            if (owner && pendingKeys_.erase(pivotKey)) {
+                std::string newName = *owner;
+                for (auto &entry : watcherMap_.view(pivotKey)) {
+                    entry(pivotKey, "", newName);
+                }
+            }
+            if (auto *that = protector.get()) {
+                that->deferEvents_.erase(pivotKey);
+            }
+            return true;
+        });
+    }
+
     Bus *bus_;
+    std::shared_ptr<NameOwnerCache> cache_;
+    std::unique_ptr<HandlerTableEntry<NameOwnerCallback>> cacheHandler_;
     MultiHandlerTable<std::string, ServiceWatcherCallback> watcherMap_;
-    std::unordered_map<std::string, std::unique_ptr<Slot>> slots_;
-    std::unordered_map<std::string, std::unique_ptr<Slot>> querySlots_;
+    std::unordered_set<std::string> pendingKeys_;
+    std::unordered_map<std::string, std::unique_ptr<EventSource>> deferEvents_;
 };
 
 ServiceWatcher::ServiceWatcher(Bus &bus)
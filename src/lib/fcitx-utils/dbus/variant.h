@@ -21,6 +21,17 @@ namespace dbus {
 
 class VariantTypeRegistryPrivate;
 
+namespace details {
+
+// Helper is stateless, so all the variants of the same type share one.
+template <typename TypeName>
+const std::shared_ptr<VariantHelper<TypeName>> &variantHelper() {
+    static const auto helper = std::make_shared<VariantHelper<TypeName>>();
+    return helper;
+}
+
+} // namespace details
+
 /// We need to "predefine some of the variant type that we want to handle".
 class FCITXUTILS_EXPORT VariantTypeRegistry {
 public:
@@ -34,7 +45,7 @@ public:
             std::is_same<TypeName, PureType>::value,
             "Type is not pure enough, remove the redundant tuple from it");
         registerTypeImpl(DBusSignatureTraits<TypeName>::signature::data(),
-                         std::make_shared<VariantHelper<TypeName>>());
+                         details::variantHelper<TypeName>());
     }
 
     std::shared_ptr<VariantHelperBase>
@@ -73,26 +84,17 @@ public:
         setData(std::forward<Value>(value));
     }
 
-    /// Copy Construct a variant from another variant.
-    Variant(const Variant &v) : signature_(v.signature_), helper_(v.helper_) {
-        if (helper_) {
-            data_ = helper_->copy(v.data_.get());
-        }
-    }
+    /**
+     * Copy Construct a variant from another variant.
+     *
+     * The data is never modified once it is set, so the copy shares the data
+     * with v instead of copying it.
+     */
+    Variant(const Variant &v) = default;
 
     /// Copy another variant data to current.
     Variant(Variant &&v) = default;
-    Variant &operator=(const Variant &v) {
-        if (&v == this) {
-            return *this;
-        }
-        signature_ = v.signature_;
-        helper_ = v.helper_;
-        if (helper_) {
-            data_ = helper_->copy(v.data_.get());
-        }
-        return *this;
-    }
+    Variant &operator=(const Variant &v) = default;
     Variant &operator=(Variant &&v) = default;
 
     /// Set variant data from some existing data.
@@ -151,7 +153,7 @@ void Variant::setData(Value &&value) {
     typedef std::remove_cv_t<std::remove_reference_t<Value>> value_type;
     signature_ = DBusSignatureTraits<value_type>::signature::data();
     data_ = std::make_shared<value_type>(std::forward<Value>(value));
-    helper_ = std::make_shared<VariantHelper<value_type>>();
+    helper_ = details::variantHelper<value_type>();
 }
 
 static inline LogMessageBuilder &operator<<(LogMessageBuilder &builder,
@@ -11,6 +11,8 @@
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include <fcitx-utils/flags.h>
 #include <fcitx-utils/macros.h>
 #include "fcitxutils_export.h"
@@ -23,6 +25,8 @@ enum class IOEventFlag {
     Err = (1 << 2),
     Hup = (1 << 3),
     EdgeTrigger = (1 << 4),
+    /// Urgent data, e.g. pressure stall notification, @since 5.1.12
+    Priority = (1 << 5),
 };
 
 using IOEventFlags = Flags<IOEventFlag>;
@@ -69,6 +73,38 @@ using EventCallback = std::function<bool(EventSource *)>;
 
 FCITXUTILS_EXPORT uint64_t now(clockid_t clock);
 
+/**
+ * Dispatch priority of an event source.
+ *
+ * When more than one source is ready at the same time, the one with higher
+ * priority is dispatched first. The values match the sd-event priorities.
+ *
+ * @see EventLoop::setPriority
+ * @since 5.1.12
+ */
+enum class EventPriority : int {
+    /// Input and display connections, that someone is waiting for.
+    High = -100,
+    Default = 0,
+    /// Housekeeping that can be done after everything else.
+    Low = 100,
+};
+
+/**
+ * Dispatch statistics of event sources sharing the same tag.
+ *
+ * @see EventLoop::setStatisticsEnabled
+ * @since 5.1.12
+ */
+struct EventSourceStatistic {
+    std::string tag;
+    uint64_t dispatchCount = 0;
+    /// Total time spent in callback, in microseconds.
+    uint64_t totalTime = 0;
+    /// Time of last dispatch in CLOCK_MONOTONIC, in microseconds.
+    uint64_t lastDispatchTime = 0;
+};
+
 class EventLoopPrivate;
 class FCITXUTILS_EXPORT EventLoop {
 public:
@@ -92,6 +128,59 @@ public:
     FCITX_NODISCARD std::unique_ptr<EventSource>
     addPostEvent(EventCallback callback);
 
+    /**
+     * Variants of add*Event that set a human readable tag for statistics.
+     *
+     * Sources created without a tag use the type of source as tag.
+     * Statistics of sources with same tag are merged, so the tag should
+     * identify the call site rather than the source, e.g. not contain a fd.
+     *
+     * @since 5.1.12
+     */
+    FCITX_NODISCARD std::unique_ptr<EventSourceIO>
+    addIOEvent(int fd, IOEventFlags flags, IOCallback callback,
+               std::string tag);
+    FCITX_NODISCARD std::unique_ptr<EventSourceTime>
+    addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
+                 TimeCallback callback, std::string tag);
+    FCITX_NODISCARD std::unique_ptr<EventSource>
+    addExitEvent(EventCallback callback, std::string tag);
+    FCITX_NODISCARD std::unique_ptr<EventSource>
+    addDeferEvent(EventCallback callback, std::string tag);
+    FCITX_NODISCARD std::unique_ptr<EventSource>
+    addPostEvent(EventCallback callback, std::string tag);
+
+    /**
+     * Enable per source dispatch statistics.
+     *
+     * When enabled, the dispatch count, callback time and last dispatch time
+     * are recorded for all sources, including those created before it is
+     * enabled. While disabled, dispatch only costs a flag check. Set
+     * environment variable FCITX_EVENT_STATISTICS to enable it from the
+     * start.
+     *
+     * @since 5.1.12
+     */
+    void setStatisticsEnabled(bool enabled);
+    /// @since 5.1.12
+    bool isStatisticsEnabled() const;
+    /// Return the statistics of all tags that are dispatched, @since 5.1.12
+    std::vector<EventSourceStatistic> statistics() const;
+    /// @since 5.1.12
+    void resetStatistics();
+
+    /**
+     * Set the dispatch priority of a source created by this event loop.
+     *
+     * With sd-event, this is sd_event_source_set_priority(). Other backends
+     * only order the IO and time sources that are ready in the same loop
+     * iteration, and libuv can only postpone Low sources until the other
+     * ones of the iteration are dispatched.
+     *
+     * @since 5.1.12
+     */
+    void setPriority(EventSource *source, EventPriority priority);
+
 private:
     const std::unique_ptr<EventLoopPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(EventLoop);
@@ -6,8 +6,14 @@
  *
  */
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <memory>
+#include <utility>
 #include "event.h"
+#include "event_p.h"
+#include "timerwheel_p.h"
 
 #define USEC_INFINITY ((uint64_t)-1)
 #define USEC_PER_SEC ((uint64_t)1000000ULL)
@@ -45,4 +51,324 @@ void EventSourceTime::setNextInterval(uint64_t time) {
 }
 
 EventSource::~EventSource() = default;
+
+std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
+                                                     IOCallback callback,
+                                                     std::string tag) {
+    FCITX_D();
+    eventLoopStatistics(d).setPendingTag(std::move(tag));
+    return addIOEvent(fd, flags, std::move(callback));
+}
+
+std::unique_ptr<EventSourceTime>
+EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
+                        TimeCallback callback, std::string tag) {
+    FCITX_D();
+    eventLoopStatistics(d).setPendingTag(std::move(tag));
+    return addTimeEvent(clock, usec, accuracy, std::move(callback));
+}
+
+std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback,
+                                                     std::string tag) {
+    FCITX_D();
+    eventLoopStatistics(d).setPendingTag(std::move(tag));
+    return addExitEvent(std::move(callback));
+}
+
+std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback,
+                                                      std::string tag) {
+    FCITX_D();
+    eventLoopStatistics(d).setPendingTag(std::move(tag));
+    return addDeferEvent(std::move(callback));
+}
+
+std::unique_ptr<EventSource> EventLoop::addPostEvent(EventCallback callback,
+                                                     std::string tag) {
+    FCITX_D();
+    eventLoopStatistics(d).setPendingTag(std::move(tag));
+    return addPostEvent(std::move(callback));
+}
+
+void EventLoop::setStatisticsEnabled(bool enabled) {
+    FCITX_D();
+    eventLoopStatistics(d).setEnabled(enabled);
+}
+
+bool EventLoop::isStatisticsEnabled() const {
+    FCITX_D();
+    return eventLoopStatistics(d).isEnabled();
+}
+
+std::vector<EventSourceStatistic> EventLoop::statistics() const {
+    FCITX_D();
+    return eventLoopStatistics(d).statistics();
+}
+
+void EventLoop::resetStatistics() {
+    FCITX_D();
+    eventLoopStatistics(d).reset();
+}
+
+TimerWheelSource::TimerWheelSource(TimerWheel *wheel, uint64_t time,
+                                   uint64_t accuracy, TimeCallback callback)
+    : wheel_(wheel), time_(time), accuracy_(accuracy),
+      callback_(std::make_shared<TimeCallback>(std::move(callback))) {
+    setOneShot();
+}
+
+TimerWheelSource::~TimerWheelSource() {
+    if (wheel_) {
+        wheel_->unlink(this);
+    }
+}
+
+void TimerWheelSource::setTime(uint64_t time) {
+    time_ = time;
+    if (wheel_) {
+        wheel_->schedule(this);
+    }
+}
+
+void TimerWheelSource::setState(TimerWheelSourceState state) {
+    if (state_ != state) {
+        state_ = state;
+        if (wheel_) {
+            wheel_->schedule(this);
+        }
+    }
+}
+
+void TimerWheelSource::setWheel(TimerWheel *wheel) {
+    if (wheel_ == wheel) {
+        return;
+    }
+    if (wheel_) {
+        wheel_->unlink(this);
+    }
+    wheel_ = wheel;
+    if (wheel_) {
+        wheel_->schedule(this);
+    }
+}
+
+void TimerWheelSource::dispatch() {
+    auto ref = watch();
+    if (isOneShot()) {
+        setEnabled(false);
+    }
+    auto callback = callback_;
+    bool ret = (*callback)(this, time_);
+    if (ref.isValid()) {
+        if (!ret) {
+            setEnabled(false);
+        }
+        if (isEnabled() && wheel_) {
+            wheel_->schedule(this);
+        }
+    }
+}
+
+TimerWheel::TimerWheel(NativeTimerFactory factory)
+    : current_(now(CLOCK_MONOTONIC) / tickUsec), factory_(std::move(factory)) {}
+
+TimerWheel::~TimerWheel() {
+    auto detach = [](SlotList &list) {
+        while (!list.empty()) {
+            auto &source = list.front();
+            list.pop_front();
+            source.wheel_ = nullptr;
+        }
+    };
+    for (auto &level : slots_) {
+        for (auto &slot : level) {
+            detach(slot);
+        }
+    }
+    detach(expired_);
+}
+
+std::unique_ptr<EventSourceTime>
+TimerWheel::addTimer(uint64_t usec, uint64_t accuracy, TimeCallback callback) {
+    return std::make_unique<TimerWheelSource>(this, usec, accuracy,
+                                              std::move(callback));
+}
+
+void TimerWheel::schedule(TimerWheelSource *source) {
+    unlink(source);
+    if (!source->isEnabled()) {
+        return;
+    }
+    source->expiry_ =
+        source->time_ / tickUsec + (source->time_ % tickUsec ? 1 : 0);
+    if (!size_) {
+        // Nothing depends on the old position, skip the ticks since last
+        // process().
+        current_ = std::max(current_, now(CLOCK_MONOTONIC) / tickUsec);
+    }
+    insert(source);
+    rearm();
+}
+
+void TimerWheel::insert(TimerWheelSource *source) {
+    auto expiry = std::max(source->expiry_, current_);
+    auto delta = expiry - current_;
+    uint32_t level = 0;
+    while (level + 1 < levels && delta >> (slotBits * (level + 1))) {
+        ++level;
+    }
+    // Park the timers that are too far away in the last slot of top level,
+    // they are re-inserted when the wheel reaches it.
+    const auto range = uint64_t(1) << (slotBits * levels);
+    if (delta >= range) {
+        expiry = current_ + range - 1;
+    }
+    const uint32_t slot = (expiry >> (slotBits * level)) & slotMask;
+    source->level_ = level;
+    source->slot_ = slot;
+    slots_[level][slot].push_back(*source);
+    occupied_[level] |= uint64_t(1) << slot;
+    ++size_;
+}
+
+void TimerWheel::unlink(TimerWheelSource *source) {
+    if (source->isInList(&expired_)) {
+        expired_.erase(expired_.iterator_to(*source));
+        return;
+    }
+    auto &list = slots_[source->level_][source->slot_];
+    if (!source->isInList(&list)) {
+        return;
+    }
+    list.erase(list.iterator_to(*source));
+    if (list.empty()) {
+        occupied_[source->level_] &= ~(uint64_t(1) << source->slot_);
+    }
+    --size_;
+}
+
+void TimerWheel::cascade(uint32_t level, uint32_t slot) {
+    if (!(occupied_[level] & (uint64_t(1) << slot))) {
+        return;
+    }
+    SlotList list(std::move(slots_[level][slot]));
+    occupied_[level] &= ~(uint64_t(1) << slot);
+    size_ -= list.size();
+    while (!list.empty()) {
+        insert(&list.front());
+    }
+}
+
+uint64_t TimerWheel::nextTick() const {
+    uint64_t result = noTick;
+    for (uint32_t level = 0; level < levels; level++) {
+        const auto occupied = occupied_[level];
+        if (!occupied) {
+            continue;
+        }
+        const auto shift = slotBits * level;
+        const auto base = current_ >> shift;
+        // Slot of base is still pending only if current_ is at the beginning
+        // of it, otherwise it is already cascaded in this round.
+        const bool aligned = (current_ & ((uint64_t(1) << shift) - 1)) == 0;
+        const uint32_t start = (base + (aligned ? 0 : 1)) & slotMask;
+        const auto rotated =
+            (occupied >> start) | (occupied << ((slotsPerLevel - start) & 63));
+        const uint64_t diff = __builtin_ctzll(rotated) + (aligned ? 0 : 1);
+        result = std::min(result, (base + diff) << shift);
+    }
+    return result;
+}
+
+void TimerWheel::process(uint64_t usec) {
+    const auto target = usec / tickUsec;
+    processing_ = true;
+    uint64_t tick;
+    while ((tick = nextTick()) <= target) {
+        current_ = tick;
+        for (uint32_t level = levels - 1; level > 0; level--) {
+            const auto shift = slotBits * level;
+            if ((tick & ((uint64_t(1) << shift) - 1)) == 0) {
+                cascade(level, (tick >> shift) & slotMask);
+            }
+        }
+        const uint32_t slot = tick & slotMask;
+        auto &list = slots_[0][slot];
+        size_ -= list.size();
+        while (!list.empty()) {
+            expired_.push_back(list.front());
+        }
+        occupied_[0] &= ~(uint64_t(1) << slot);
+        current_ = tick + 1;
+    }
+    current_ = std::max(current_, target + 1);
+
+    // Timers re-armed from callback always land after target, so this
+    // terminates even if they are already due.
+    while (!expired_.empty()) {
+        auto &source = expired_.front();
+        expired_.pop_front();
+        source.dispatch();
+    }
+    processing_ = false;
+    rearm();
+}
+
+void TimerWheel::rearm() {
+    if (processing_) {
+        return;
+    }
+    // If the backend timer fires earlier than needed, process() is a no-op
+    // and arms it again, which is cheaper than rearming on every removal.
+    const auto tick = nextTick();
+    if (tick >= armedTick_) {
+        return;
+    }
+    armedTick_ = tick;
+    if (native_) {
+        native_->setTime(tick * tickUsec);
+        native_->setOneShot();
+        return;
+    }
+    native_ = factory_(tick * tickUsec, [this](EventSourceTime *, uint64_t) {
+        armedTick_ = noTick;
+        process(now(CLOCK_MONOTONIC));
+        return true;
+    });
+}
+
+TimerWheel &TimerWheelSet::wheel(EventPriority priority) {
+    size_t index = 1;
+    if (priority == EventPriority::High) {
+        index = 0;
+    } else if (priority == EventPriority::Low) {
+        index = 2;
+    }
+    auto &wheel = wheels_[index];
+    if (!wheel) {
+        wheel = std::make_unique<TimerWheel>(
+            [this, priority](uint64_t usec, TimeCallback callback) {
+                return factory_(priority, usec, std::move(callback));
+            });
+    }
+    return *wheel;
+}
+
+bool TimerWheelSet::setPriority(EventSource *source, EventPriority priority) {
+    auto *timer = dynamic_cast<TimerWheelSource *>(source);
+    if (!timer) {
+        return false;
+    }
+    // A timer that outlives the event loop is detached.
+    if (timer->wheel_) {
+        timer->setWheel(&wheel(priority));
+    }
+    return true;
+}
+
+void TimerWheelSet::clear() {
+    for (auto &wheel : wheels_) {
+        wheel.reset();
+    }
+}
+
 } // namespace fcitx
@@ -0,0 +1,777 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <endian.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <linux/io_uring.h>
+#include "event.h"
+#include "event_p.h"
+#include "intrusivelist.h"
+#include "log.h"
+#include "timerwheel_p.h"
+#include "trackableobject.h"
+
+#define FCITX_IOURING_DEBUG() FCITX_LOGC(::fcitx::iouring_logcategory, Debug)
+
+namespace fcitx {
+
+FCITX_DEFINE_LOG_CATEGORY(iouring_logcategory, "io_uring");
+
+namespace {
+
+constexpr unsigned int ringEntries = 256;
+constexpr uint64_t noDeadline = UINT64_MAX;
+
+uint32_t IOEventFlagsToPollFlags(IOEventFlags flags) {
+    uint32_t result = 0;
+    if (flags & IOEventFlag::In) {
+        result |= POLLIN;
+    }
+    if (flags & IOEventFlag::Out) {
+        result |= POLLOUT;
+    }
+    if (flags & IOEventFlag::Err) {
+        result |= POLLERR;
+    }
+    if (flags & IOEventFlag::Hup) {
+        result |= POLLHUP;
+    }
+    if (flags & IOEventFlag::EdgeTrigger) {
+        result |= EPOLLET;
+    }
+    if (flags & IOEventFlag::Priority) {
+        result |= POLLPRI;
+    }
+    return result;
+}
+
+IOEventFlags PollFlagsToIOEventFlags(uint32_t flags) {
+    return ((flags & POLLIN) ? IOEventFlag::In : IOEventFlags()) |
+           ((flags & POLLOUT) ? IOEventFlag::Out : IOEventFlags()) |
+           ((flags & POLLERR) ? IOEventFlag::Err : IOEventFlags()) |
+           ((flags & POLLHUP) ? IOEventFlag::Hup : IOEventFlags()) |
+           ((flags & POLLPRI) ? IOEventFlag::Priority : IOEventFlags());
+}
+
+struct Completion {
+    uint64_t userData;
+    int32_t res;
+    uint32_t flags;
+};
+
+// Minimal wrapper around the raw io_uring kernel interface.
+class IOUring {
+public:
+    explicit IOUring(unsigned int entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd_ = syscall(__NR_io_uring_setup, entries, &params);
+        if (fd_ < 0) {
+            throw EventLoopException(errno);
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(__u32);
+        cqRingSize_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = map(sqRingSize_, IORING_OFF_SQ_RING);
+        if (singleMmap) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = map(cqRingSize_, IORING_OFF_CQ_RING);
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe *>(map(sqesSize_, IORING_OFF_SQES));
+
+        auto *sq = static_cast<char *>(sqRing_);
+        sqHead_ = reinterpret_cast<__u32 *>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<__u32 *>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<__u32 *>(sq + params.sq_off.ring_mask);
+        sqEntries_ = params.sq_entries;
+        // Use an identity mapping, so the array never need to be updated.
+        auto *array = reinterpret_cast<__u32 *>(sq + params.sq_off.array);
+        for (__u32 i = 0; i < sqEntries_; i++) {
+            array[i] = i;
+        }
+        sqeTail_ = *sqTail_;
+        submitted_ = sqeTail_;
+
+        auto *cq = static_cast<char *>(cqRing_);
+        cqHead_ = reinterpret_cast<__u32 *>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<__u32 *>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<__u32 *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    ~IOUring() { cleanup(); }
+
+    int fd() const { return fd_; }
+
+    // Return a zeroed submission entry, it is submitted by the next submit().
+    io_uring_sqe *getSqe() {
+        if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >=
+            sqEntries_) {
+            submit(false);
+            if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >=
+                sqEntries_) {
+                throw EventLoopException(EBUSY);
+            }
+        }
+        auto *sqe = &sqes_[sqeTail_ & sqMask_];
+        ++sqeTail_;
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Submit all queued entries with a single syscall, and optionally wait
+    // for at least one completion.
+    void submit(bool wait) {
+        const unsigned int toSubmit = sqeTail_ - submitted_;
+        if (!toSubmit && !wait) {
+            return;
+        }
+        __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+        int ret = syscall(__NR_io_uring_enter, fd_, toSubmit, wait ? 1 : 0,
+                          wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                return;
+            }
+            throw EventLoopException(errno);
+        }
+        submitted_ += ret;
+    }
+
+    void reap(std::vector<Completion> &completions) {
+        __u32 head = *cqHead_;
+        const __u32 tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const auto &cqe = cqes_[head & cqMask_];
+            completions.push_back({cqe.user_data, cqe.res, cqe.flags});
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void *map(size_t size, off_t offset) {
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (ptr == MAP_FAILED) {
+            int error = errno;
+            cleanup();
+            throw EventLoopException(error);
+        }
+        return ptr;
+    }
+
+    void cleanup() {
+        if (sqes_) {
+            munmap(sqes_, sqesSize_);
+            sqes_ = nullptr;
+        }
+        if (cqRing_ && cqRing_ != sqRing_) {
+            munmap(cqRing_, cqRingSize_);
+        }
+        cqRing_ = nullptr;
+        if (sqRing_) {
+            munmap(sqRing_, sqRingSize_);
+            sqRing_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    void *sqRing_ = nullptr;
+    void *cqRing_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    __u32 *sqHead_ = nullptr;
+    __u32 *sqTail_ = nullptr;
+    __u32 sqMask_ = 0;
+    __u32 sqEntries_ = 0;
+    __u32 sqeTail_ = 0;
+    __u32 submitted_ = 0;
+    __u32 *cqHead_ = nullptr;
+    __u32 *cqTail_ = nullptr;
+    __u32 cqMask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+};
+
+} // namespace
+
+enum class IOUringSourceEnableState { Disabled = 0, Oneshot = 1, Enabled = 2 };
+
+struct IOUringLoop;
+
+template <typename Interface>
+struct IOUringSource : public Interface {
+public:
+    IOUringSource(std::shared_ptr<IOUringLoop> loop) : loop_(std::move(loop)) {}
+
+    bool isEnabled() const override {
+        return state_ != IOUringSourceEnableState::Disabled;
+    }
+    void setEnabled(bool enabled) override {
+        setState(enabled ? IOUringSourceEnableState::Enabled
+                         : IOUringSourceEnableState::Disabled);
+    }
+
+    void setOneShot() override { setState(IOUringSourceEnableState::Oneshot); }
+
+    bool isOneShot() const override {
+        return state_ == IOUringSourceEnableState::Oneshot;
+    }
+
+    EventPriority priority_ = EventPriority::Default;
+
+protected:
+    void setState(IOUringSourceEnableState state) {
+        if (state_ != state) {
+            state_ = state;
+            update();
+        }
+    }
+
+    virtual void update() {}
+
+    std::weak_ptr<IOUringLoop> loop_;
+    IOUringSourceEnableState state_ = IOUringSourceEnableState::Disabled;
+};
+
+struct IOUringSourceIO final : public IOUringSource<EventSourceIO>,
+                               public TrackableObject<IOUringSourceIO> {
+    IOUringSourceIO(IOCallback callback, std::shared_ptr<IOUringLoop> loop,
+                    int fd, IOEventFlags flags)
+        : IOUringSource(std::move(loop)), fd_(fd), flags_(flags),
+          callback_(std::make_shared<IOCallback>(std::move(callback))) {
+        setEnabled(true);
+    }
+
+    ~IOUringSourceIO() override { disarm(); }
+
+    int fd() const override { return fd_; }
+
+    void setFd(int fd) override {
+        if (fd_ != fd) {
+            fd_ = fd;
+            update();
+        }
+    }
+
+    IOEventFlags events() const override { return flags_; }
+
+    void setEvents(IOEventFlags flags) override {
+        if (flags_ != flags) {
+            flags_ = flags;
+            update();
+        }
+    }
+
+    IOEventFlags revents() const override { return revents_; }
+
+    void update() override {
+        disarm();
+        arm();
+    }
+
+    void arm();
+
+    void disarm();
+
+    void dispatch(IOEventFlags flags) {
+        auto ref = watch();
+        revents_ = flags;
+        if (isOneShot()) {
+            setEnabled(false);
+        }
+        auto callback = callback_;
+        bool ret = (*callback)(this, fd_, flags);
+        if (ref.isValid()) {
+            if (!ret) {
+                setEnabled(false);
+            }
+            arm();
+        }
+    }
+
+    int fd_;
+    IOEventFlags flags_;
+    IOEventFlags revents_;
+    uint64_t pollId_ = 0;
+    bool multishot_ = false;
+    std::shared_ptr<IOCallback> callback_;
+};
+
+struct IOUringSourceTime final : public IOUringSource<EventSourceTime>,
+                                 public IntrusiveListNode,
+                                 public TrackableObject<IOUringSourceTime> {
+    IOUringSourceTime(TimeCallback callback, std::shared_ptr<IOUringLoop> loop,
+                      uint64_t time, clockid_t clockid, uint64_t accuracy)
+        : IOUringSource(std::move(loop)), time_(time), clock_(clockid),
+          accuracy_(accuracy),
+          callback_(std::make_shared<TimeCallback>(std::move(callback))) {
+        setOneShot();
+    }
+
+    uint64_t time() const override { return time_; }
+
+    void setTime(uint64_t time) override { time_ = time; }
+
+    uint64_t accuracy() const override { return accuracy_; }
+
+    void setAccuracy(uint64_t time) override { accuracy_ = time; }
+
+    clockid_t clock() const override { return clock_; }
+
+    void update() override;
+
+    // Deadline converted to CLOCK_MONOTONIC.
+    uint64_t deadline(uint64_t monotonicNow) const {
+        if (clock_ == CLOCK_MONOTONIC) {
+            return time_;
+        }
+        const auto current = now(clock_);
+        if (time_ <= current) {
+            return monotonicNow;
+        }
+        return monotonicNow + (time_ - current);
+    }
+
+    void dispatch() {
+        auto ref = watch();
+        if (isOneShot()) {
+            setEnabled(false);
+        }
+        auto callback = callback_;
+        bool ret = (*callback)(this, time_);
+        if (ref.isValid() && !ret) {
+            setEnabled(false);
+        }
+    }
+
+    uint64_t time_;
+    clockid_t clock_;
+    uint64_t accuracy_;
+    std::shared_ptr<TimeCallback> callback_;
+};
+
+struct IOUringSourceEvent final : public IOUringSource<EventSource>,
+                                  public TrackableObject<IOUringSourceEvent> {
+    IOUringSourceEvent(EventCallback callback, IOUringSourceEnableState state)
+        : IOUringSource(nullptr),
+          callback_(std::make_shared<EventCallback>(std::move(callback))) {
+        state_ = state;
+    }
+
+    void dispatch() {
+        auto ref = watch();
+        if (isOneShot()) {
+            setEnabled(false);
+        }
+        auto callback = callback_;
+        bool ret = (*callback)(this);
+        if (ref.isValid() && !ret) {
+            setEnabled(false);
+        }
+    }
+
+    std::shared_ptr<EventCallback> callback_;
+};
+
+struct IOUringLoop {
+    IOUringLoop() : ring_(ringEntries) {}
+
+    uint64_t addPoll(IOUringSourceIO *source, int fd, IOEventFlags flags,
+                     bool multishot) {
+        auto mask = IOEventFlagsToPollFlags(flags);
+#if __BYTE_ORDER == __BIG_ENDIAN
+        mask = (mask << 16) | (mask >> 16);
+#endif
+        const auto id = ++lastId_;
+        auto *sqe = ring_.getSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = mask;
+        sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+        sqe->user_data = id;
+        polls_[id] = source;
+        return id;
+    }
+
+    void removePoll(uint64_t id) {
+        polls_.erase(id);
+        auto *sqe = ring_.getSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = id;
+    }
+
+    // Make sure the wait is interrupted at deadline, in CLOCK_MONOTONIC.
+    void armTimeout(uint64_t deadline) {
+        if (deadline == timeoutDeadline_) {
+            return;
+        }
+        if (timeoutId_) {
+            auto *sqe = ring_.getSqe();
+            sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = timeoutId_;
+            timeoutId_ = 0;
+        }
+        timeoutDeadline_ = deadline;
+        if (deadline == noDeadline) {
+            return;
+        }
+        timeoutId_ = ++lastId_;
+        timeoutSpec_.tv_sec = deadline / 1000000;
+        timeoutSpec_.tv_nsec = (deadline % 1000000) * 1000;
+        auto *sqe = ring_.getSqe();
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uintptr_t>(&timeoutSpec_);
+        sqe->len = 1;
+        sqe->timeout_flags = IORING_TIMEOUT_ABS;
+        sqe->user_data = timeoutId_;
+    }
+
+    IOUring ring_;
+    // User data 0 is used for entries that we don't care about the result.
+    uint64_t lastId_ = 0;
+    std::unordered_map<uint64_t, IOUringSourceIO *> polls_;
+    IntrusiveList<IOUringSourceTime> timers_;
+    uint64_t timeoutId_ = 0;
+    uint64_t timeoutDeadline_ = noDeadline;
+    __kernel_timespec timeoutSpec_;
+    bool multishot_ = true;
+};
+
+void IOUringSourceIO::arm() {
+    if (pollId_ || state_ == IOUringSourceEnableState::Disabled) {
+        return;
+    }
+    auto loop = loop_.lock();
+    if (!loop) {
+        return;
+    }
+    // Multishot poll only report new readiness, which is edge triggered.
+    // Level triggered sources use a single shot poll that is re-armed
+    // after dispatch, the re-arm is submitted together with next wait.
+    const bool multishot = loop->multishot_ &&
+                           state_ == IOUringSourceEnableState::Enabled &&
+                           flags_.test(IOEventFlag::EdgeTrigger);
+    pollId_ = loop->addPoll(this, fd_, flags_, multishot);
+    multishot_ = multishot;
+}
+
+void IOUringSourceIO::disarm() {
+    if (!pollId_) {
+        return;
+    }
+    if (auto loop = loop_.lock()) {
+        loop->removePoll(pollId_);
+    }
+    pollId_ = 0;
+}
+
+void IOUringSourceTime::update() {
+    if (state_ == IOUringSourceEnableState::Disabled) {
+        remove();
+        return;
+    }
+    if (isInList()) {
+        return;
+    }
+    if (auto loop = loop_.lock()) {
+        loop->timers_.push_back(*this);
+    }
+}
+
+using IOUringSourceEventList =
+    std::vector<TrackableObjectReference<IOUringSourceEvent>>;
+
+struct ReadySource {
+    EventPriority priority;
+    TrackableObjectReference<IOUringSourceIO> io;
+    TrackableObjectReference<IOUringSourceTime> timer;
+    IOEventFlags flags;
+};
+
+class EventLoopPrivate {
+public:
+    EventLoopPrivate() : loop_(std::make_shared<IOUringLoop>()) {}
+
+    // Dispatch all enabled events in list, return whether any of them is
+    // still enabled afterwards.
+    static bool dispatchEvents(IOUringSourceEventList &events) {
+        bool enabled = false;
+        // Callback may add new event into the list.
+        for (size_t i = 0; i < events.size(); i++) {
+            if (auto *event = events[i].get(); event && event->isEnabled()) {
+                event->dispatch();
+            }
+        }
+        events.erase(std::remove_if(events.begin(), events.end(),
+                                    [&enabled](const auto &ref) {
+                                        if (!ref.isValid()) {
+                                            return true;
+                                        }
+                                        enabled = enabled ||
+                                                  ref.get()->isEnabled();
+                                        return false;
+                                    }),
+                     events.end());
+        return enabled;
+    }
+
+    // Collect the ready IO sources, they are dispatched together with the
+    // expired timers in the order of priority.
+    void reapCompletions() {
+        completions_.clear();
+        loop_->ring_.reap(completions_);
+        for (const auto &completion : completions_) {
+            if (!completion.userData) {
+                continue;
+            }
+            if (completion.userData == loop_->timeoutId_) {
+                loop_->timeoutId_ = 0;
+                loop_->timeoutDeadline_ = noDeadline;
+                continue;
+            }
+            auto iter = loop_->polls_.find(completion.userData);
+            if (iter == loop_->polls_.end()) {
+                continue;
+            }
+            auto *source = iter->second;
+            if (!(completion.flags & IORING_CQE_F_MORE)) {
+                loop_->polls_.erase(iter);
+                source->pollId_ = 0;
+            }
+            if (completion.res == -EINVAL && source->multishot_) {
+                FCITX_IOURING_DEBUG() << "Multishot poll is not supported.";
+                loop_->multishot_ = false;
+                source->arm();
+                continue;
+            }
+            if (completion.res == -ECANCELED) {
+                // Multishot poll may be terminated by kernel.
+                source->arm();
+                continue;
+            }
+            IOEventFlags flags;
+            if (completion.res < 0) {
+                flags = IOEventFlag::Err;
+            } else {
+                flags = PollFlagsToIOEventFlags(completion.res);
+            }
+            ready_.push_back({source->priority_, source->watch(), {}, flags});
+        }
+    }
+
+    uint64_t nextDeadline() {
+        uint64_t result = noDeadline;
+        const auto current = now(CLOCK_MONOTONIC);
+        for (const auto &timer : loop_->timers_) {
+            result = std::min(result, timer.deadline(current));
+        }
+        return result;
+    }
+
+    void reapTimers() {
+        if (loop_->timers_.empty()) {
+            return;
+        }
+        const auto current = now(CLOCK_MONOTONIC);
+        for (auto &timer : loop_->timers_) {
+            if (timer.deadline(current) <= current) {
+                ready_.push_back(
+                    {timer.priority_, {}, timer.watch(), IOEventFlags()});
+            }
+        }
+    }
+
+    void dispatchReady() {
+        std::stable_sort(ready_.begin(), ready_.end(),
+                         [](const ReadySource &lhs, const ReadySource &rhs) {
+                             return lhs.priority < rhs.priority;
+                         });
+        // Callback may remove any source, so only references are kept.
+        for (auto &ready : ready_) {
+            if (auto *io = ready.io.get(); io && io->isEnabled()) {
+                io->dispatch(ready.flags);
+            } else if (auto *timer = ready.timer.get();
+                       timer && timer->isEnabled()) {
+                timer->dispatch();
+            }
+        }
+        ready_.clear();
+    }
+
+    std::shared_ptr<IOUringLoop> loop_;
+    std::vector<Completion> completions_;
+    std::vector<ReadySource> ready_;
+    IOUringSourceEventList deferEvents_;
+    IOUringSourceEventList postEvents_;
+    IOUringSourceEventList exitEvents_;
+    EventLoopStatistics statistics_;
+    bool exit_ = false;
+    // Destroy it first, since its native timer refers to loop_.
+    TimerWheelSet timerWheels_{[this](EventPriority priority, uint64_t usec,
+                                      TimeCallback callback) {
+        auto source = std::make_unique<IOUringSourceTime>(
+            std::move(callback), loop_, usec, CLOCK_MONOTONIC,
+            TimerWheel::tickUsec);
+        source->priority_ = priority;
+        return source;
+    }};
+};
+
+EventLoopStatistics &eventLoopStatistics(EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
+const EventLoopStatistics &eventLoopStatistics(const EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
+EventLoop::EventLoop() : d_ptr(std::make_unique<EventLoopPrivate>()) {}
+
+EventLoop::~EventLoop() {}
+
+const char *EventLoop::impl() { return "io_uring"; }
+
+void *EventLoop::nativeHandle() {
+    FCITX_D();
+    return d->loop_.get();
+}
+
+bool EventLoop::exec() {
+    FCITX_D();
+    d->exit_ = false;
+    try {
+        while (!d->exit_) {
+            const bool pendingDefer = d->dispatchEvents(d->deferEvents_);
+            if (d->exit_) {
+                break;
+            }
+            bool wait = !pendingDefer;
+            if (wait) {
+                const auto deadline = d->nextDeadline();
+                if (deadline != noDeadline &&
+                    deadline <= now(CLOCK_MONOTONIC)) {
+                    wait = false;
+                } else {
+                    d->loop_->armTimeout(deadline);
+                }
+            }
+            d->loop_->ring_.submit(wait);
+            d->reapCompletions();
+            d->reapTimers();
+            d->dispatchReady();
+            d->dispatchEvents(d->postEvents_);
+        }
+    } catch (const EventLoopException &e) {
+        FCITX_ERROR() << "io_uring event loop failed: " << e.what();
+        return false;
+    } catch (const std::exception &e) {
+        // some abnormal things threw
+        FCITX_FATAL() << e.what();
+    }
+    d->dispatchEvents(d->exitEvents_);
+    return true;
+}
+
+void EventLoop::exit() {
+    FCITX_D();
+    d->exit_ = true;
+}
+
+std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
+                                                     IOCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "io");
+    auto source = std::make_unique<IOUringSourceIO>(std::move(callback),
+                                                    d->loop_, fd, flags);
+    return source;
+}
+
+std::unique_ptr<EventSourceTime>
+EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
+                        TimeCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "time");
+    if (TimerWheel::isCompatible(clock, accuracy)) {
+        return d->timerWheels_.wheel().addTimer(usec, accuracy,
+                                                std::move(callback));
+    }
+    auto source = std::make_unique<IOUringSourceTime>(
+        std::move(callback), d->loop_, usec, clock, accuracy);
+    return source;
+}
+
+void EventLoop::setPriority(EventSource *source, EventPriority priority) {
+    FCITX_D();
+    if (d->timerWheels_.setPriority(source, priority)) {
+        return;
+    }
+    if (auto *io = dynamic_cast<IOUringSourceIO *>(source)) {
+        io->priority_ = priority;
+    } else if (auto *timer = dynamic_cast<IOUringSourceTime *>(source)) {
+        timer->priority_ = priority;
+    }
+}
+
+std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "exit");
+    auto source = std::make_unique<IOUringSourceEvent>(
+        std::move(callback), IOUringSourceEnableState::Oneshot);
+    d->exitEvents_.push_back(source->watch());
+    return source;
+}
+
+std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "defer");
+    auto source = std::make_unique<IOUringSourceEvent>(
+        std::move(callback), IOUringSourceEnableState::Oneshot);
+    d->deferEvents_.push_back(source->watch());
+    return source;
+}
+
+std::unique_ptr<EventSource> EventLoop::addPostEvent(EventCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "post");
+    auto source = std::make_unique<IOUringSourceEvent>(
+        std::move(callback), IOUringSourceEnableState::Enabled);
+    d->postEvents_.push_back(source->watch());
+    return source;
+}
+
+} // namespace fcitx
@@ -10,10 +10,13 @@
 #include <exception>
 #include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <uv.h>
 #include "event.h"
+#include "event_p.h"
 #include "log.h"
+#include "timerwheel_p.h"
 #include "trackableobject.h"
 
 #define FCITX_LIBUV_DEBUG() FCITX_LOGC(::fcitx::libuv_logcategory, Debug)
@@ -33,13 +36,17 @@ static int IOEventFlagsToLibUVFlags(IOEventFlags flags) {
     if (flags & IOEventFlag::Hup) {
         result |= UV_DISCONNECT;
     }
+    if (flags & IOEventFlag::Priority) {
+        result |= UV_PRIORITIZED;
+    }
     return result;
 }
 
 static IOEventFlags LibUVFlagsToIOEventFlags(int flags) {
     return ((flags & UV_READABLE) ? IOEventFlag::In : IOEventFlags()) |
            ((flags & UV_WRITABLE) ? IOEventFlag::Out : IOEventFlags()) |
-           ((flags & UV_DISCONNECT) ? IOEventFlag::Hup : IOEventFlags());
+           ((flags & UV_DISCONNECT) ? IOEventFlag::Hup : IOEventFlags()) |
+           ((flags & UV_PRIORITIZED) ? IOEventFlag::Priority : IOEventFlags());
 }
 
 void IOEventCallback(uv_poll_t *handle, int status, int events);
@@ -49,13 +56,45 @@ void PostEventCallback(uv_prepare_t *handle);
 enum class LibUVSourceEnableState { Disabled = 0, Oneshot = 1, Enabled = 2 };
 
 struct UVLoop {
-    UVLoop() { uv_loop_init(&loop_); }
+    UVLoop() {
+        uv_loop_init(&loop_);
+        loop_.data = this;
+        uv_check_init(&loop_, &check_);
+        uv_idle_init(&loop_, &idle_);
+    }
 
     ~UVLoop();
 
     operator uv_loop_t *() { return &loop_; }
 
+    // libuv has no priority, Low sources are queued and dispatched in the
+    // check phase, which is after the timers and IO of the same iteration.
+    void postpone(std::function<void()> dispatch) {
+        if (postponed_.empty()) {
+            uv_check_start(&check_, [](uv_check_t *check) {
+                static_cast<UVLoop *>(check->loop->data)->dispatchPostponed();
+            });
+            // An active idle handle makes the poll not to block, otherwise
+            // the ones queued by timers need to wait for the next IO.
+            uv_idle_start(&idle_, [](uv_idle_t *) {});
+        }
+        postponed_.push_back(std::move(dispatch));
+    }
+
+    void dispatchPostponed() {
+        auto postponed = std::move(postponed_);
+        postponed_.clear();
+        uv_check_stop(&check_);
+        uv_idle_stop(&idle_);
+        for (auto &dispatch : postponed) {
+            dispatch();
+        }
+    }
+
     uv_loop_t loop_;
+    uv_check_t check_;
+    uv_idle_t idle_;
+    std::vector<std::function<void()>> postponed_;
 };
 
 struct LibUVSourceBase {
@@ -87,6 +126,21 @@ public:
         init(*loop);
     }
 
+    // Return true if the dispatch is postponed because of low priority.
+    bool postpone(std::function<void()> dispatch) {
+        if (priority_ != EventPriority::Low) {
+            return false;
+        }
+        auto loop = loop_.lock();
+        if (!loop) {
+            return false;
+        }
+        loop->postpone(std::move(dispatch));
+        return true;
+    }
+
+    EventPriority priority_ = EventPriority::Default;
+
 protected:
     void setState(LibUVSourceEnableState state) {
         if (state_ != state) {
@@ -101,6 +155,9 @@ protected:
 };
 
 UVLoop::~UVLoop() {
+    postponed_.clear();
+    uv_close(reinterpret_cast<uv_handle_t *>(&check_), nullptr);
+    uv_close(reinterpret_cast<uv_handle_t *>(&idle_), nullptr);
     // Close and detach all handle.
     uv_walk(
         &loop_,
@@ -312,10 +369,39 @@ class EventLoopPrivate {
 public:
     EventLoopPrivate() : loop_(std::make_shared<UVLoop>()) {}
 
+    std::unique_ptr<EventSourceTime> addTimeEvent(clockid_t clock,
+                                                  uint64_t usec,
+                                                  uint64_t accuracy,
+                                                  TimeCallback callback) {
+        if (TimerWheel::isCompatible(clock, accuracy)) {
+            return timerWheels_.wheel().addTimer(usec, accuracy,
+                                                 std::move(callback));
+        }
+        return std::make_unique<LibUVSourceTime>(std::move(callback), loop_,
+                                                 usec, clock, accuracy);
+    }
+
     std::shared_ptr<UVLoop> loop_;
     std::vector<TrackableObjectReference<LibUVSourceExit>> exitEvents_;
+    EventLoopStatistics statistics_;
+    TimerWheelSet timerWheels_{[this](EventPriority priority, uint64_t usec,
+                                      TimeCallback callback) {
+        auto source = std::make_unique<LibUVSourceTime>(
+            std::move(callback), loop_, usec, CLOCK_MONOTONIC,
+            TimerWheel::tickUsec);
+        source->priority_ = priority;
+        return source;
+    }};
 };
 
+EventLoopStatistics &eventLoopStatistics(EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
+const EventLoopStatistics &eventLoopStatistics(const EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
 EventLoop::EventLoop() : d_ptr(std::make_unique<EventLoopPrivate>()) {}
 
 EventLoop::~EventLoop() {}
@@ -358,9 +444,7 @@ void EventLoop::exit() {
     uv_stop(*d->loop_);
 }
 
-void IOEventCallback(uv_poll_t *handle, int status, int events) {
-    auto *source = static_cast<LibUVSourceIO *>(
-        static_cast<LibUVSourceBase *>(handle->data));
+static void dispatchIOEvent(LibUVSourceIO *source, int status, int events) {
     auto sourceRef = source->watch();
     try {
         if (source->isOneShot()) {
@@ -383,18 +467,33 @@ void IOEventCallback(uv_poll_t *handle, int status, int events) {
     }
 }
 
+void IOEventCallback(uv_poll_t *handle, int status, int events) {
+    auto *source = static_cast<LibUVSourceIO *>(
+        static_cast<LibUVSourceBase *>(handle->data));
+    // The handle is not freed before the postponed dispatch, it is replaced
+    // if the source is disabled or changed in between.
+    if (source->postpone([sourceRef = source->watch(), handle, status,
+                          events]() {
+            if (auto *source = sourceRef.get();
+                source && source->handle() == handle) {
+                dispatchIOEvent(source, status, events);
+            }
+        })) {
+        return;
+    }
+    dispatchIOEvent(source, status, events);
+}
+
 std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
                                                      IOCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "io");
     auto source = std::make_unique<LibUVSourceIO>(std::move(callback), d->loop_,
                                                   fd, flags);
     return source;
 }
 
-void TimeEventCallback(uv_timer_t *handle) {
-    auto *source = static_cast<LibUVSourceTime *>(
-        static_cast<LibUVSourceBase *>(handle->data));
-
+static void dispatchTimeEvent(LibUVSourceTime *source) {
     try {
         auto sourceRef = source->watch();
         if (source->isOneShot()) {
@@ -416,24 +515,50 @@ void TimeEventCallback(uv_timer_t *handle) {
     }
 }
 
+void TimeEventCallback(uv_timer_t *handle) {
+    auto *source = static_cast<LibUVSourceTime *>(
+        static_cast<LibUVSourceBase *>(handle->data));
+    if (source->postpone([sourceRef = source->watch(), handle]() {
+            if (auto *source = sourceRef.get();
+                source && source->handle() == handle) {
+                dispatchTimeEvent(source);
+            }
+        })) {
+        return;
+    }
+    dispatchTimeEvent(source);
+}
+
 std::unique_ptr<EventSourceTime>
 EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
                         TimeCallback callback) {
     FCITX_D();
-    auto source = std::make_unique<LibUVSourceTime>(
-        std::move(callback), d->loop_, usec, clock, accuracy);
-    return source;
+    callback = d->statistics_.wrap(std::move(callback), "time");
+    return d->addTimeEvent(clock, usec, accuracy, std::move(callback));
+}
+
+void EventLoop::setPriority(EventSource *source, EventPriority priority) {
+    FCITX_D();
+    if (d->timerWheels_.setPriority(source, priority)) {
+        return;
+    }
+    if (auto *base = dynamic_cast<LibUVSourceBase *>(source)) {
+        base->priority_ = priority;
+    }
 }
 
 std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "exit");
     auto source = std::make_unique<LibUVSourceExit>(std::move(callback));
     d->exitEvents_.push_back(source->watch());
     return source;
 }
 
 std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
-    return addTimeEvent(
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "defer");
+    return d->addTimeEvent(
         CLOCK_MONOTONIC, 0, 0,
         [callback = std::move(callback)](EventSourceTime *source, uint64_t) {
             return callback(source);
@@ -459,6 +584,7 @@ void PostEventCallback(uv_prepare_t *handle) {
 
 std::unique_ptr<EventSource> EventLoop::addPostEvent(EventCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "post");
     auto source =
         std::make_unique<LibUVSourcePost>(std::move(callback), d->loop_);
     return source;
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_EVENT_P_H_
+#define _FCITX_UTILS_EVENT_P_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "event.h"
+
+namespace fcitx {
+
+/**
+ * Per tag dispatch statistics of an EventLoop.
+ *
+ * Callbacks passed to EventLoop while statistics is enabled are wrapped to
+ * count the dispatches and the time spent. Records are keyed by the tag of
+ * the call site, so the number of records does not grow with the sources.
+ */
+class EventLoopStatistics {
+    struct Record {
+        uint64_t dispatchCount = 0;
+        uint64_t totalTime = 0;
+        uint64_t lastDispatchTime = 0;
+    };
+
+    struct State {
+        // Allows to record the sources created during startup.
+        bool enabled_ = std::getenv("FCITX_EVENT_STATISTICS") != nullptr;
+        std::unordered_map<std::string, std::shared_ptr<Record>> records_;
+    };
+
+public:
+    bool isEnabled() const { return state_->enabled_; }
+    void setEnabled(bool enabled) { state_->enabled_ = enabled; }
+
+    // Use tag instead of the default one for the next wrapped callback.
+    void setPendingTag(std::string tag) {
+        if (!tag.empty()) {
+            pendingTag_ = std::move(tag);
+        }
+    }
+
+    // Always wrap, so sources created while disabled are still recorded once
+    // statistics is enabled at runtime.
+    template <typename Callback>
+    Callback wrap(Callback callback, const char *kind) {
+        auto tag = std::exchange(pendingTag_, std::nullopt);
+        if (!callback) {
+            return callback;
+        }
+        auto &record =
+            tag ? state_->records_[std::move(*tag)] : state_->records_[kind];
+        if (!record) {
+            record = std::make_shared<Record>();
+        }
+        return [state = state_, record,
+                callback = std::move(callback)](auto... args) {
+            if (!state->enabled_) {
+                return callback(args...);
+            }
+            // Callback may destroy the source together with this functor.
+            auto current = record;
+            const auto start = now(CLOCK_MONOTONIC);
+            current->dispatchCount += 1;
+            current->lastDispatchTime = start;
+            auto result = callback(args...);
+            current->totalTime += now(CLOCK_MONOTONIC) - start;
+            return result;
+        };
+    }
+
+    std::vector<EventSourceStatistic> statistics() const {
+        std::vector<EventSourceStatistic> result;
+        for (const auto &[tag, record] : state_->records_) {
+            if (!record->dispatchCount) {
+                continue;
+            }
+            result.push_back({tag, record->dispatchCount, record->totalTime,
+                              record->lastDispatchTime});
+        }
+        return result;
+    }
+
+    void reset() {
+        for (auto iter = state_->records_.begin();
+             iter != state_->records_.end();) {
+            // Nothing refers to it any more.
+            if (iter->second.use_count() == 1) {
+                iter = state_->records_.erase(iter);
+            } else {
+                *iter->second = Record();
+                ++iter;
+            }
+        }
+    }
+
+private:
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+    std::optional<std::string> pendingTag_;
+};
+
+// Implemented by each event loop backend.
+EventLoopStatistics &eventLoopStatistics(EventLoopPrivate *d);
+const EventLoopStatistics &eventLoopStatistics(const EventLoopPrivate *d);
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_EVENT_P_H_
@@ -20,9 +20,11 @@
 #endif
 #include <systemd/sd-event.h>
 #include "event.h"
+#include "event_p.h"
 #include "log.h"
 #include "macros.h"
 #include "stringutils.h"
+#include "timerwheel_p.h"
 
 namespace fcitx {
 
@@ -44,6 +46,9 @@ uint32_t IOEventFlagsToEpollFlags(IOEventFlags flags) {
     if (flags & IOEventFlag::EdgeTrigger) {
         result |= EPOLLET;
     }
+    if (flags & IOEventFlag::Priority) {
+        result |= EPOLLPRI;
+    }
     return result;
 }
 
@@ -52,13 +57,19 @@ IOEventFlags EpollFlagsToIOEventFlags(uint32_t flags) {
            ((flags & EPOLLOUT) ? IOEventFlag::Out : IOEventFlags()) |
            ((flags & EPOLLERR) ? IOEventFlag::Err : IOEventFlags()) |
            ((flags & EPOLLHUP) ? IOEventFlag::Hup : IOEventFlags()) |
-           ((flags & EPOLLET) ? IOEventFlag::EdgeTrigger : IOEventFlags());
+           ((flags & EPOLLET) ? IOEventFlag::EdgeTrigger : IOEventFlags()) |
+           ((flags & EPOLLPRI) ? IOEventFlag::Priority : IOEventFlags());
 }
 
 } // namespace
 
+// Non template base, to find the native source from EventSource.
+struct SDEventSourceHandle {
+    sd_event_source *eventSource_ = nullptr;
+};
+
 template <typename Interface>
-struct SDEventSourceBase : public Interface {
+struct SDEventSourceBase : public Interface, public SDEventSourceHandle {
 public:
     ~SDEventSourceBase() override {
         if (eventSource_) {
@@ -96,9 +107,6 @@ public:
     void setOneShot() override {
         sd_event_source_set_enabled(eventSource_, SD_EVENT_ONESHOT);
     }
-
-protected:
-    sd_event_source *eventSource_;
 };
 
 struct SDEventSource : public SDEventSourceBase<EventSource> {
@@ -213,12 +221,48 @@ public:
         }
     }
 
-    ~EventLoopPrivate() { sd_event_unref(event_); }
+    ~EventLoopPrivate() {
+        timerWheels_.clear();
+        sd_event_unref(event_);
+    }
+
+    std::unique_ptr<EventSourceTime> addTimeEvent(clockid_t clock,
+                                                  uint64_t usec,
+                                                  uint64_t accuracy,
+                                                  TimeCallback callback);
+
+    static void setPriority(EventSource *source, EventPriority priority) {
+        auto *handle = dynamic_cast<SDEventSourceHandle *>(source);
+        if (!handle) {
+            return;
+        }
+        if (int err = sd_event_source_set_priority(
+                handle->eventSource_, static_cast<int64_t>(priority));
+            err < 0) {
+            throw EventLoopException(err);
+        }
+    }
 
     std::mutex mutex_;
     sd_event *event_ = nullptr;
+    EventLoopStatistics statistics_;
+    TimerWheelSet timerWheels_{[this](EventPriority priority, uint64_t usec,
+                                      TimeCallback callback) {
+        auto source = addTimeEvent(CLOCK_MONOTONIC, usec, TimerWheel::tickUsec,
+                                   std::move(callback));
+        setPriority(source.get(), priority);
+        return source;
+    }};
 };
 
+EventLoopStatistics &eventLoopStatistics(EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
+const EventLoopStatistics &eventLoopStatistics(const EventLoopPrivate *d) {
+    return d->statistics_;
+}
+
 EventLoop::EventLoop() : d_ptr(std::make_unique<EventLoopPrivate>()) {}
 
 EventLoop::~EventLoop() = default;
@@ -261,6 +305,7 @@ int IOEventCallback(sd_event_source * /*unused*/, int fd, uint32_t revents,
 std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
                                                      IOCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "io");
     auto source = std::make_unique<SDEventSourceIO>(std::move(callback));
     sd_event_source *sdEventSource;
     if (int err = sd_event_add_io(d->event_, &sdEventSource, fd,
@@ -292,12 +337,11 @@ int TimeEventCallback(sd_event_source * /*unused*/, uint64_t usec,
 }
 
 std::unique_ptr<EventSourceTime>
-EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
-                        TimeCallback callback) {
-    FCITX_D();
+EventLoopPrivate::addTimeEvent(clockid_t clock, uint64_t usec,
+                               uint64_t accuracy, TimeCallback callback) {
     auto source = std::make_unique<SDEventSourceTime>(std::move(callback));
     sd_event_source *sdEventSource;
-    if (int err = sd_event_add_time(d->event_, &sdEventSource, clock, usec,
+    if (int err = sd_event_add_time(event_, &sdEventSource, clock, usec,
                                     accuracy, TimeEventCallback, source.get());
         err < 0) {
         throw EventLoopException(err);
@@ -306,6 +350,25 @@ EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
     return source;
 }
 
+std::unique_ptr<EventSourceTime>
+EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
+                        TimeCallback callback) {
+    FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "time");
+    if (TimerWheel::isCompatible(clock, accuracy)) {
+        return d->timerWheels_.wheel().addTimer(usec, accuracy,
+                                                std::move(callback));
+    }
+    return d->addTimeEvent(clock, usec, accuracy, std::move(callback));
+}
+
+void EventLoop::setPriority(EventSource *source, EventPriority priority) {
+    FCITX_D();
+    if (!d->timerWheels_.setPriority(source, priority)) {
+        d->setPriority(source, priority);
+    }
+}
+
 int StaticEventCallback(sd_event_source * /*unused*/, void *userdata) {
     auto *source = static_cast<SDEventSource *>(userdata);
     if (!source) {
@@ -325,6 +388,7 @@ int StaticEventCallback(sd_event_source * /*unused*/, void *userdata) {
 
 std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "exit");
     auto source = std::make_unique<SDEventSource>(std::move(callback));
     sd_event_source *sdEventSource;
     if (int err = sd_event_add_exit(d->event_, &sdEventSource,
@@ -338,6 +402,7 @@ std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback) {
 
 std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "defer");
     auto source = std::make_unique<SDEventSource>(std::move(callback));
     sd_event_source *sdEventSource;
     if (int err = sd_event_add_defer(d->event_, &sdEventSource,
@@ -351,6 +416,7 @@ std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
 
 std::unique_ptr<EventSource> EventLoop::addPostEvent(EventCallback callback) {
     FCITX_D();
+    callback = d->statistics_.wrap(std::move(callback), "post");
     auto source = std::make_unique<SDEventSource>(std::move(callback));
     sd_event_source *sdEventSource;
     if (int err = sd_event_add_post(d->event_, &sdEventSource,
@@ -5,36 +5,246 @@
  *
  */
 #include "eventdispatcher.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
+#include <vector>
 #include "event.h"
 #include "misc_p.h"
 #include "unixfd.h"
 
+#ifdef HAVE_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
 namespace fcitx {
+
+namespace {
+
+struct DispatchNode {
+    std::atomic<DispatchNode *> next{nullptr};
+    Task task;
+};
+
+// Process wide pool of queue nodes.
+//
+// Nodes are only returned by the consuming thread, and producers always take
+// the whole shared free list at once into a thread local cache. Since no
+// thread ever pops a single node from the shared list, it is free from ABA.
+class DispatchNodePool {
+public:
+    static DispatchNode *acquire() {
+        auto &cache = localCache();
+        if (!cache.head_) {
+            cache.head_ =
+                freeList_.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (auto *node = cache.head_) {
+            cache.head_ = node->next.load(std::memory_order_relaxed);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            return node;
+        }
+        return new DispatchNode;
+    }
+
+    static void release(DispatchNode *node) {
+        node->task.reset();
+        if (size_.fetch_add(1, std::memory_order_relaxed) >= maxSize) {
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            delete node;
+            return;
+        }
+        auto *head = freeList_.load(std::memory_order_relaxed);
+        do {
+            node->next.store(head, std::memory_order_relaxed);
+        } while (!freeList_.compare_exchange_weak(head, node,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    }
+
+private:
+    static constexpr size_t maxSize = 1024;
+
+    struct LocalCache {
+        ~LocalCache() {
+            while (head_) {
+                auto *next = head_->next.load(std::memory_order_relaxed);
+                delete head_;
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                head_ = next;
+            }
+        }
+        DispatchNode *head_ = nullptr;
+    };
+
+    static LocalCache &localCache() {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    static inline std::atomic<DispatchNode *> freeList_{nullptr};
+    static inline std::atomic<size_t> size_{0};
+};
+
+// Intrusive multi-producer single-consumer queue, based on the algorithm by
+// Dmitry Vyukov. push() may be called from any thread, pop() only from the
+// thread of the event loop.
+class DispatchQueue {
+public:
+    DispatchQueue() : head_(&stub_), tail_(&stub_) {}
+
+    ~DispatchQueue() {
+        while (auto *node = pop()) {
+            DispatchNodePool::release(node);
+        }
+    }
+
+    void push(DispatchNode *node) { push(node, node); }
+
+    // Push an already linked chain of nodes with a single exchange.
+    void push(DispatchNode *first, DispatchNode *last) {
+        last->next.store(nullptr, std::memory_order_relaxed);
+        auto *prev = head_.exchange(last, std::memory_order_acq_rel);
+        prev->next.store(first, std::memory_order_release);
+    }
+
+    // Return nullptr if the queue is empty, or the next node is still being
+    // linked by a producer.
+    DispatchNode *pop() {
+        auto *tail = tail_;
+        auto *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+private:
+    std::atomic<DispatchNode *> head_;
+    DispatchNode *tail_;
+    DispatchNode stub_;
+};
+
+} // namespace
+
 class EventDispatcherPrivate {
 public:
     void dispatchEvent() {
-        uint8_t dummy;
-        while (fs::safeRead(fd_[0].fd(), &dummy, sizeof(dummy)) > 0) {
+        clearWakeUp();
+        // Only run what is already there, functors scheduled from the
+        // callback will be handled in next iteration.
+        const size_t pending = pending_.load(std::memory_order_acquire);
+        size_t processed = 0;
+        while (processed < pending) {
+            auto *node = queue_.pop();
+            if (!node) {
+                break;
+            }
+            auto task = std::move(node->task);
+            DispatchNodePool::release(node);
+            ++processed;
+            task();
         }
-        std::queue<std::function<void()>> eventList;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            using std::swap;
-            std::swap(eventList, eventList_);
+        // Something is scheduled in the mean time, or a producer has not
+        // finished linking the node yet. Wake up again so it is not lost.
+        if (pending_.fetch_sub(processed, std::memory_order_acq_rel) >
+            processed) {
+            wakeUp();
         }
-        while (!eventList.empty()) {
-            auto functor = std::move(eventList.front());
-            eventList.pop();
-            functor();
+    }
+
+    void enqueue(Task task) {
+        auto *node = DispatchNodePool::acquire();
+        node->task = std::move(task);
+        queue_.push(node);
+        // Only the first one after the queue becomes non-empty need to wake
+        // up the event loop.
+        if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            wakeUp();
         }
     }
 
-    // Mutex to be used to protect eventList_.
+    void enqueue(std::vector<Task> tasks) {
+        DispatchNode *first = nullptr;
+        DispatchNode *last = nullptr;
+        size_t count = 0;
+        for (auto &task : tasks) {
+            if (!task) {
+                continue;
+            }
+            auto *node = DispatchNodePool::acquire();
+            node->task = std::move(task);
+            if (last) {
+                last->next.store(node, std::memory_order_relaxed);
+            } else {
+                first = node;
+            }
+            last = node;
+            ++count;
+        }
+        if (!count) {
+            return;
+        }
+        queue_.push(first, last);
+        if (pending_.fetch_add(count, std::memory_order_acq_rel) == 0) {
+            wakeUp();
+        }
+    }
+
+    void wakeUp() {
+#ifdef HAVE_EVENTFD
+        uint64_t value = 1;
+#else
+        uint8_t value = 0;
+#endif
+        fs::safeWrite(writeFd(), &value, sizeof(value));
+    }
+
+    void clearWakeUp() {
+#ifdef HAVE_EVENTFD
+        uint64_t value;
+        fs::safeRead(fd_[0].fd(), &value, sizeof(value));
+#else
+        uint8_t dummy;
+        while (fs::safeRead(fd_[0].fd(), &dummy, sizeof(dummy)) > 0) {
+        }
+#endif
+    }
+
+    int writeFd() const {
+#ifdef HAVE_EVENTFD
+        return fd_[0].fd();
+#else
+        return fd_[1].fd();
+#endif
+    }
+
+    // Mutex to be used to protect ioEvent_ and loop_.
     mutable std::mutex mutex_;
-    std::queue<std::function<void()>> eventList_;
+    std::atomic<bool> attached_{false};
+    std::atomic<size_t> pending_{0};
+    DispatchQueue queue_;
     std::unique_ptr<EventSourceIO> ioEvent_;
     EventLoop *loop_ = nullptr;
     UnixFD fd_[2];
@@ -43,12 +253,20 @@ public:
 EventDispatcher::EventDispatcher()
     : d_ptr(std::make_unique<EventDispatcherPrivate>()) {
     FCITX_D();
+#ifdef HAVE_EVENTFD
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create eventfd");
+    }
+    d->fd_[0].give(fd);
+#else
     int selfpipe[2];
     if (safePipe(selfpipe)) {
         throw std::runtime_error("Failed to create pipe");
     }
     d->fd_[0].give(selfpipe[0]);
     d->fd_[1].give(selfpipe[1]);
+#endif
 }
 
 EventDispatcher::~EventDispatcher() = default;
@@ -60,28 +278,45 @@ void EventDispatcher::attach(EventLoop *event) {
                                     [d](EventSource *, int, IOEventFlags) {
                                         d->dispatchEvent();
                                         return true;
-                                    });
+                                    },
+                                    "EventDispatcher");
+    // Work scheduled from other threads, e.g. the events read from display
+    // connections, usually has someone waiting for it.
+    event->setPriority(d->ioEvent_.get(), EventPriority::High);
     d->loop_ = event;
+    d->attached_.store(true, std::memory_order_release);
 }
 
 void EventDispatcher::detach() {
     FCITX_D();
     std::lock_guard<std::mutex> lock(d->mutex_);
+    d->attached_.store(false, std::memory_order_release);
     d->ioEvent_.reset();
     d->loop_ = nullptr;
 }
 
 void EventDispatcher::schedule(std::function<void()> functor) {
+    schedule(Task(std::move(functor)));
+}
+
+void EventDispatcher::schedule(Task task) {
     FCITX_D();
-    if (functor) {
-        std::lock_guard<std::mutex> lock(d->mutex_);
-        if (!d->ioEvent_) {
-            return;
-        }
-        d->eventList_.push(std::move(functor));
+    if (!task) {
+        d->wakeUp();
+        return;
+    }
+    if (!d->attached_.load(std::memory_order_acquire)) {
+        return;
+    }
+    d->enqueue(std::move(task));
+}
+
+void EventDispatcher::scheduleBatch(std::vector<Task> tasks) {
+    FCITX_D();
+    if (!d->attached_.load(std::memory_order_acquire)) {
+        return;
     }
-    uint8_t dummy = 0;
-    fs::safeWrite(d->fd_[1].fd(), &dummy, 1);
+    d->enqueue(std::move(tasks));
 }
 
 EventLoop *EventDispatcher::eventLoop() const {
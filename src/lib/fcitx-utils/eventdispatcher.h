@@ -10,7 +10,11 @@
 
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <fcitx-utils/macros.h>
+#include <fcitx-utils/task.h>
 #include <fcitx-utils/trackableobject.h>
 #include "fcitxutils_export.h"
 
@@ -56,6 +60,46 @@ public:
      */
     void schedule(std::function<void()> functor);
 
+    /**
+     * Schedule a task to be called from event loop.
+     *
+     * Same as schedule(std::function<void()>), but the task is only moved
+     * into the queue, so it is not allocated if its callable fits into the
+     * inline storage of Task.
+     *
+     * @param task task to be called.
+     * @since 5.1.12
+     */
+    void schedule(Task task);
+
+    /**
+     * Schedule a callable without wrapping it into std::function.
+     *
+     * @since 5.1.12
+     */
+    template <typename F,
+              typename = std::enable_if_t<
+                  std::is_invocable_r_v<void, std::decay_t<F> &> &&
+                  !std::is_same_v<std::decay_t<F>, std::function<void()>> &&
+                  !std::is_same_v<std::decay_t<F>, Task> &&
+                  !std::is_null_pointer_v<std::decay_t<F>>>>
+    void schedule(F &&functor) {
+        schedule(Task(std::forward<F>(functor)));
+    }
+
+    /**
+     * Schedule multiple tasks at once.
+     *
+     * All tasks are enqueued with a single synchronization point and will
+     * wake up the event loop at most once. They are called in the same order
+     * as in the vector, within the same event loop iteration. Empty tasks are
+     * ignored.
+     *
+     * @param tasks tasks to be called.
+     * @since 5.1.12
+     */
+    void scheduleBatch(std::vector<Task> tasks);
+
     /**
      * A helper function that allows to only invoke certain function if the
      * reference is still valid.
@@ -68,19 +112,19 @@ public:
      *
      * @since 5.1.8
      */
-    template <typename T>
+    template <typename T, typename F>
     void scheduleWithContext(TrackableObjectReference<T> context,
-                             std::function<void()> functor) {
+                             F &&functor) {
         if (!context.isValid()) {
             return;
         }
 
-        schedule(
-            [context = std::move(context), functor = std::move(functor)]() {
-                if (context.isValid()) {
-                    functor();
-                }
-            });
+        schedule(Task([context = std::move(context),
+                       functor = std::forward<F>(functor)]() mutable {
+            if (context.isValid()) {
+                functor();
+            }
+        }));
     }
 
     /**
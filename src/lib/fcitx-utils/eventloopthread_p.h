@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_EVENTLOOPTHREAD_P_H_
+#define _FCITX_UTILS_EVENTLOOPTHREAD_P_H_
+
+#include <functional>
+#include <future>
+#include <thread>
+#include <utility>
+#include "event.h"
+#include "eventdispatcher.h"
+
+namespace fcitx {
+
+/**
+ * A worker thread running its own event loop.
+ *
+ * It is meant to be shared by multiple connections that need to watch their
+ * file descriptors outside of the main thread, so the number of threads does
+ * not grow with the number of connections. Event sources on eventLoop() must
+ * only be created, modified and destroyed on the worker thread.
+ */
+class EventLoopThread {
+public:
+    EventLoopThread() {
+        std::promise<void> ready;
+        auto future = ready.get_future();
+        thread_ = std::thread([this, &ready]() { run(ready); });
+        // Make sure the dispatcher is attached before anything is scheduled.
+        future.wait();
+    }
+
+    ~EventLoopThread() {
+        dispatcher_.schedule([this]() { loop_->exit(); });
+        thread_.join();
+    }
+
+    EventLoopThread(const EventLoopThread &) = delete;
+    EventLoopThread &operator=(const EventLoopThread &) = delete;
+
+    bool isCurrentThread() const {
+        return std::this_thread::get_id() == thread_.get_id();
+    }
+
+    EventLoop &eventLoop() { return *loop_; }
+
+    void schedule(std::function<void()> functor) {
+        dispatcher_.schedule(std::move(functor));
+    }
+
+    // Run functor on the worker thread and wait for it to finish. Since
+    // scheduled functions run in order, everything scheduled before is also
+    // done when this returns.
+    void call(const std::function<void()> &functor) {
+        if (isCurrentThread()) {
+            functor();
+            return;
+        }
+        std::promise<void> done;
+        auto future = done.get_future();
+        dispatcher_.schedule([&functor, &done]() {
+            functor();
+            done.set_value();
+        });
+        future.wait();
+    }
+
+private:
+    void run(std::promise<void> &ready) {
+        EventLoop loop;
+        loop_ = &loop;
+        dispatcher_.attach(&loop);
+        ready.set_value();
+        loop.exec();
+        dispatcher_.detach();
+        loop_ = nullptr;
+    }
+
+    EventDispatcher dispatcher_;
+    EventLoop *loop_ = nullptr;
+    std::thread thread_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_EVENTLOOPTHREAD_P_H_
@@ -6,10 +6,17 @@
  */
 
 #include "fs.h"
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "macros.h"
 #include "mtime_p.h"
 #include "standardpath.h"
 #include "stringutils.h"
@@ -49,8 +56,72 @@ bool makePathHelper(const std::string &name) {
     return errno == EEXIST && isdir(name);
 }
 
+// Block size used when the file can not be mapped.
+constexpr size_t readBlockSize = 64 * 1024;
+
 } // namespace
 
+class FileViewPrivate {
+public:
+    FileViewPrivate() = default;
+    FileViewPrivate(const FileViewPrivate &) = delete;
+    ~FileViewPrivate() {
+        if (mapped_) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    bool map(int fd, size_t size) {
+        void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        mapped_ = true;
+        data_ = static_cast<const char *>(data);
+        size_ = size;
+        return true;
+    }
+
+    // Read regular file from the beginning with pread, or other file from
+    // the current offset.
+    bool read(int fd, bool regular, size_t sizeHint) {
+        if (regular) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        buffer_.reserve(sizeHint);
+        size_t offset = 0;
+        while (true) {
+            const size_t remaining = sizeHint > offset ? sizeHint - offset : 0;
+            buffer_.resize(offset + std::max(readBlockSize, remaining));
+            const auto length = buffer_.size() - offset;
+            ssize_t ret;
+            do {
+                ret = regular ? pread(fd, buffer_.data() + offset, length,
+                                      static_cast<off_t>(offset))
+                              : ::read(fd, buffer_.data() + offset, length);
+            } while (ret == -1 && errno == EINTR);
+            if (ret < 0) {
+                buffer_.clear();
+                return false;
+            }
+            if (ret == 0) {
+                break;
+            }
+            offset += ret;
+        }
+        buffer_.resize(offset);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+
+    bool valid_ = false;
+    bool mapped_ = false;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    std::string buffer_;
+};
+
 bool isdir(const std::string &path) {
     struct stat stats;
     return (stat(path.c_str(), &stats) == 0 && S_ISDIR(stats.st_mode) &&
@@ -269,4 +340,48 @@ UniqueFilePtr openFD(StandardPathFile &file, const char *modes) {
     return openFDImpl(file, modes);
 }
 
+FileView::FileView() = default;
+
+FileView::FileView(int fd) {
+    struct stat stats;
+    if (fd < 0 || fstat(fd, &stats) != 0) {
+        return;
+    }
+    d_ptr = std::make_unique<FileViewPrivate>();
+    FCITX_D();
+    const bool regular = S_ISREG(stats.st_mode);
+    const size_t size = regular ? stats.st_size : 0;
+    if (regular && size > 0 && d->map(fd, size)) {
+        d->valid_ = true;
+        return;
+    }
+    d->valid_ = d->read(fd, regular, size);
+}
+
+FCITX_DEFINE_DEFAULT_DTOR_AND_MOVE(FileView)
+
+bool FileView::isValid() const {
+    FCITX_D();
+    return d && d->valid_;
+}
+
+bool FileView::isMapped() const {
+    FCITX_D();
+    return d && d->mapped_;
+}
+
+const char *FileView::data() const {
+    FCITX_D();
+    return d ? d->data_ : nullptr;
+}
+
+size_t FileView::size() const {
+    FCITX_D();
+    return d ? d->size_ : 0;
+}
+
+std::string_view FileView::view() const {
+    return {data(), size()};
+}
+
 } // namespace fcitx::fs
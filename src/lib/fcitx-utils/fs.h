@@ -7,9 +7,13 @@
 #ifndef _FCITX_UTILS_FS_H_
 #define _FCITX_UTILS_FS_H_
 
+#include <cstddef>
 #include <cstdio>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <fcitx-utils/macros.h>
 #include <fcitx-utils/misc.h>
 #include "fcitxutils_export.h"
 
@@ -86,6 +90,48 @@ FCITXUTILS_EXPORT UniqueFilePtr openFD(UnixFD &fd, const char *modes);
  */
 FCITXUTILS_EXPORT UniqueFilePtr openFD(StandardPathFile &file,
                                        const char *modes);
+
+class FileViewPrivate;
+
+/**
+ * \brief Read only view of the whole content of a file.
+ *
+ * Regular file is mapped into memory if possible. Otherwise the content is
+ * read into a buffer with large blocks, e.g. for a pipe. The view does not
+ * need the file descriptor after it is created.
+ *
+ * The mapped content must not be truncated while the view is alive.
+ *
+ * \since 5.1.12
+ */
+class FCITXUTILS_EXPORT FileView {
+public:
+    /// Create an invalid view.
+    FileView();
+    /**
+     * Create a view of the file.
+     *
+     * Regular file is always viewed from the beginning, other files are read
+     * from the current offset until the end.
+     *
+     * \param fd file descriptor, it is not owned by the view.
+     */
+    explicit FileView(int fd);
+    ~FileView();
+    FCITX_DECLARE_MOVE(FileView);
+
+    /// Whether the whole content is available.
+    bool isValid() const;
+    /// Whether the content is mapped from the file.
+    bool isMapped() const;
+    const char *data() const;
+    size_t size() const;
+    std::string_view view() const;
+
+private:
+    std::unique_ptr<FileViewPrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(FileView);
+};
 } // namespace fs
 } // namespace fcitx
 
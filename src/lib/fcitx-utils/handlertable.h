@@ -8,7 +8,10 @@
 #define _FCITX_UTILS_HANDLERTABLE_H_
 
 #include <functional>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <fcitx-utils/handlertable_details.h> // IWYU pragma: export
 #include <fcitx-utils/intrusivelist.h>
 
@@ -38,6 +41,11 @@ public:
         return {handlers_.begin(), handlers_.end()};
     }
 
+    /// Access the live entries without taking a snapshot.
+    const IntrusiveListFor<ListHandlerTableEntry<T>> &entries() const {
+        return handlers_;
+    }
+
     size_t size() const { return handlers_.size(); }
     bool empty() const { return size() == 0; }
 
@@ -45,6 +53,92 @@ private:
     IntrusiveListFor<ListHandlerTableEntry<T>> handlers_;
 };
 
+/**
+ * HandlerTable that stores handlers in a shared HandlerPool.
+ *
+ * Adding a handler only allocates the returned entry, and the entry refers
+ * to the handler with a weak generational handle. Multiple tables may share
+ * the same pool to keep related handlers close in memory.
+ *
+ * Entries returned by this table return null from
+ * HandlerTableEntry::handler(), use pool() and the handle instead.
+ *
+ * @since 5.1.12
+ */
+template <typename T>
+class PooledHandlerTable {
+public:
+    using pool_type = HandlerPool<T>;
+    using slot_type = typename pool_type::slot_type;
+
+    explicit PooledHandlerTable(
+        std::shared_ptr<pool_type> pool = std::make_shared<pool_type>())
+        : pool_(std::move(pool)) {}
+    FCITX_INLINE_DEFINE_DEFAULT_DTOR_AND_MOVE(PooledHandlerTable)
+
+    template <typename... Args>
+    FCITX_NODISCARD std::unique_ptr<HandlerTableEntry<T>> add(Args &&...args) {
+        auto handle = pool_->acquire(std::forward<Args>(args)...);
+        std::unique_ptr<HandlerTableEntry<T>> result;
+        try {
+            result =
+                std::make_unique<PooledHandlerTableEntry<T>>(pool_, handle);
+        } catch (...) {
+            pool_->release(handle);
+            throw;
+        }
+        handlers_.push_back(pool_->slot(handle.index));
+        return result;
+    }
+
+    /**
+     * Invoke callback on every handler without taking a snapshot.
+     *
+     * Handlers added by callback are not visited, and removed ones are
+     * skipped. If callback returns bool, returning false stops the iteration.
+     */
+    template <typename Callback>
+    void forEach(Callback &&callback) const {
+        if (handlers_.empty()) {
+            return;
+        }
+        typename pool_type::IterationGuard guard(pool_.get());
+        // Removal is deferred by guard, so both the current and the last
+        // slot stay in the list.
+        const auto *last = &handlers_.back();
+        for (auto iter = handlers_.begin(); iter != handlers_.end(); ++iter) {
+            auto &slot = *iter;
+            if (slot.isAlive()) {
+                using Result = std::invoke_result_t<Callback, T &>;
+                if constexpr (std::is_same_v<Result, bool>) {
+                    if (!callback(slot.handler())) {
+                        break;
+                    }
+                } else {
+                    callback(slot.handler());
+                }
+            }
+            if (&slot == last) {
+                break;
+            }
+        }
+    }
+
+    /// Access the live slots without taking a snapshot.
+    const IntrusiveListFor<slot_type> &entries() const { return handlers_; }
+
+    const std::shared_ptr<pool_type> &pool() const { return pool_; }
+
+    size_t size() const { return handlers_.size(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    std::shared_ptr<pool_type> pool_;
+    // Slots are owned by the pool, mutable since forEach hands out non
+    // const handlers.
+    mutable IntrusiveListFor<slot_type> handlers_;
+};
+
 template <typename Key, typename T>
 class MultiHandlerTable {
     friend class MultiHandlerTableEntry<Key, T>;
@@ -7,8 +7,12 @@
 #ifndef _FCITX_UTILS_HANDLERTABLE_DETAILS_H_
 #define _FCITX_UTILS_HANDLERTABLE_DETAILS_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <list>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 #include <fcitx-utils/intrusivelist.h>
 #include "fcitxutils_export.h"
@@ -34,11 +38,20 @@ public:
     HandlerTableEntry(Args &&...args)
         : handler_(std::make_shared<std::unique_ptr<T>>(
               std::make_unique<T>(std::forward<Args>(args)...))) {}
-    ~HandlerTableEntry() override { handler_->reset(); }
+    ~HandlerTableEntry() override {
+        if (handler_) {
+            handler_->reset();
+        }
+    }
 
+    /// Return null if the handler is not owned by this entry, e.g. it is
+    /// created by PooledHandlerTable.
     HandlerTableData<T> handler() const { return handler_; }
 
 protected:
+    struct NoHandler {};
+    explicit HandlerTableEntry(NoHandler) {}
+
     HandlerTableData<T> handler_;
 };
 
@@ -91,6 +104,156 @@ MultiHandlerTableEntry<Key, T>::~MultiHandlerTableEntry() {
     }
 }
 
+/// Weak reference to a handler stored in HandlerPool.
+struct HandlerPoolHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+template <typename T>
+class HandlerPool;
+
+template <typename T>
+struct HandlerPoolSlot {
+    IntrusiveListNode node_;
+
+    using node_getter_type =
+        struct IntrusiveListMemberNodeGetter<HandlerPoolSlot,
+                                             &HandlerPoolSlot::node_>;
+
+    bool isAlive() const { return alive_; }
+    HandlerPoolHandle handle() const { return {index_, generation_}; }
+    T &handler() { return *handler_; }
+
+    std::optional<T> handler_;
+    uint32_t index_ = 0;
+    uint32_t generation_ = 0;
+    uint32_t nextFree_ = 0;
+    bool alive_ = false;
+};
+
+// Slab of handlers, addressed by generational handles. Slots never move, and
+// a released slot is only reused after all ongoing iterations are finished,
+// so handlers can be removed from within a handler safely.
+template <typename T>
+class HandlerPool {
+public:
+    using slot_type = HandlerPoolSlot<T>;
+
+    HandlerPool() = default;
+    HandlerPool(const HandlerPool &) = delete;
+    HandlerPool &operator=(const HandlerPool &) = delete;
+
+    template <typename... Args>
+    HandlerPoolHandle acquire(Args &&...args) {
+        uint32_t index;
+        if (freeHead_ != npos) {
+            index = freeHead_;
+            freeHead_ = slot(index).nextFree_;
+        } else {
+            if (size_ % chunkSize == 0) {
+                chunks_.push_back(std::make_unique<slot_type[]>(chunkSize));
+            }
+            index = size_++;
+        }
+        auto &slot = this->slot(index);
+        try {
+            slot.handler_.emplace(std::forward<Args>(args)...);
+        } catch (...) {
+            slot.nextFree_ = std::exchange(freeHead_, index);
+            throw;
+        }
+        slot.index_ = index;
+        slot.alive_ = true;
+        return slot.handle();
+    }
+
+    void release(HandlerPoolHandle handle) {
+        if (!get(handle)) {
+            return;
+        }
+        auto &slot = this->slot(handle.index);
+        // Invalidate all the handles right away.
+        slot.alive_ = false;
+        ++slot.generation_;
+        if (iterating_) {
+            pending_.push_back(handle.index);
+        } else {
+            free(handle.index);
+        }
+    }
+
+    T *get(HandlerPoolHandle handle) {
+        if (handle.index >= size_) {
+            return nullptr;
+        }
+        auto &slot = this->slot(handle.index);
+        if (!slot.alive_ || slot.generation_ != handle.generation) {
+            return nullptr;
+        }
+        return &*slot.handler_;
+    }
+
+    slot_type &slot(uint32_t index) {
+        return chunks_[index / chunkSize][index % chunkSize];
+    }
+
+    /// Defer reusing released slots until the guard is destroyed.
+    class IterationGuard {
+    public:
+        explicit IterationGuard(HandlerPool *pool) : pool_(pool) {
+            ++pool_->iterating_;
+        }
+        IterationGuard(const IterationGuard &) = delete;
+        ~IterationGuard() {
+            if (--pool_->iterating_ == 0 && !pool_->pending_.empty()) {
+                auto pending = std::move(pool_->pending_);
+                for (auto index : pending) {
+                    pool_->free(index);
+                }
+            }
+        }
+
+    private:
+        HandlerPool *pool_;
+    };
+
+private:
+    static constexpr uint32_t chunkSize = 64;
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    void free(uint32_t index) {
+        auto &slot = this->slot(index);
+        slot.node_.remove();
+        // Handler may add or release other handlers when being destructed, so
+        // only make the slot available afterwards.
+        slot.handler_.reset();
+        slot.nextFree_ = std::exchange(freeHead_, index);
+    }
+
+    std::vector<std::unique_ptr<slot_type[]>> chunks_;
+    std::vector<uint32_t> pending_;
+    uint32_t size_ = 0;
+    uint32_t freeHead_ = npos;
+    uint32_t iterating_ = 0;
+};
+
+template <typename T>
+class PooledHandlerTableEntry final : public HandlerTableEntry<T> {
+public:
+    PooledHandlerTableEntry(std::shared_ptr<HandlerPool<T>> pool,
+                            HandlerPoolHandle handle)
+        : HandlerTableEntry<T>(typename HandlerTableEntry<T>::NoHandler()),
+          pool_(std::move(pool)), handle_(handle) {}
+    ~PooledHandlerTableEntry() override { pool_->release(handle_); }
+
+    HandlerPoolHandle handle() const { return handle_; }
+
+private:
+    std::shared_ptr<HandlerPool<T>> pool_;
+    HandlerPoolHandle handle_;
+};
+
 template <typename T>
 class HandlerTableView {
     using container_type = std::vector<HandlerTableData<T>>;
@@ -116,7 +279,7 @@ public:
         iterator(typename container_type::const_iterator iter,
                  typename container_type::const_iterator end)
             : parentIter_(iter), endIter_(end) {
-            while (parentIter_ != endIter_ && !*parentIter_ && !**parentIter_) {
+            while (parentIter_ != endIter_ && !**parentIter_) {
                 parentIter_++;
             }
         }
@@ -17,18 +17,23 @@ namespace fcitx {
 class GettextManager {
 public:
     void addDomain(const char *domain, const char *dir = nullptr) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (domains_.count(domain)) {
+        // Translation of a domain usually comes in a row, e.g. when building
+        // a menu, so skip the lock if it is the same as last time.
+        thread_local std::string lastDomain;
+        if (!dir && lastDomain == domain) {
             return;
         }
-        const auto *localedir = StandardPath::fcitxPath("localedir");
-        if (!dir) {
-            dir = localedir;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!domains_.count(domain)) {
+            const auto *localedir = StandardPath::fcitxPath("localedir");
+            const auto *domainDir = dir ? dir : localedir;
+            bindtextdomain(domain, domainDir);
+            bind_textdomain_codeset(domain, "UTF-8");
+            domains_.insert(domain);
+            FCITX_DEBUG() << "Add gettext domain " << domain << " at "
+                          << domainDir;
         }
-        bindtextdomain(domain, dir);
-        bind_textdomain_codeset(domain, "UTF-8");
-        domains_.insert(domain);
-        FCITX_DEBUG() << "Add gettext domain " << domain << " at " << dir;
+        lastDomain = domain;
     }
 
 private:
@@ -38,6 +43,15 @@ private:
 
 static GettextManager gettextManager;
 
+// The message id with context is only needed during the lookup, so the buffer
+// is reused to avoid an allocation for every translation.
+static const char *contextMessageId(const char *ctx, const char *s) {
+    thread_local std::string buffer;
+    buffer.clear();
+    buffer.append(ctx).append(1, '\004').append(s);
+    return buffer.c_str();
+}
+
 std::string translate(const std::string &s) { return translate(s.c_str()); }
 
 const char *translate(const char *s) { return ::gettext(s); }
@@ -47,9 +61,8 @@ std::string translateCtx(const char *ctx, const std::string &s) {
 }
 
 const char *translateCtx(const char *ctx, const char *s) {
-    auto str = stringutils::concat(ctx, "\004", s);
-    const auto *p = str.c_str();
-    const auto *result = ::gettext(str.c_str());
+    const auto *p = contextMessageId(ctx, s);
+    const auto *result = ::gettext(p);
     if (p == result) {
         return s;
     }
@@ -73,8 +86,7 @@ std::string translateDomainCtx(const char *domain, const char *ctx,
 const char *translateDomainCtx(const char *domain, const char *ctx,
                                const char *s) {
     gettextManager.addDomain(domain);
-    auto str = stringutils::concat(ctx, "\004", s);
-    const auto *p = str.c_str();
+    const auto *p = contextMessageId(ctx, s);
     const auto *result = ::dgettext(domain, p);
     if (p == result) {
         return s;
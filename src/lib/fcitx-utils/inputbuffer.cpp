@@ -5,6 +5,8 @@
  *
  */
 #include "inputbuffer.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <string_view>
 #include <vector>
@@ -12,6 +14,122 @@
 
 namespace fcitx {
 
+namespace {
+
+/**
+ * UTF-8 text with a gap at the last editing position.
+ *
+ * Bytes are stored in buffer_, the gap is [gapBegin_, gapEnd_). The end
+ * offset of characters before the gap is counted from the beginning, and the
+ * start offset of characters after the gap is counted from the end, so none of
+ * them need to be updated when the text at the gap is changed.
+ */
+class InputGapBuffer {
+public:
+    size_t size() const { return before_.size() + after_.size(); }
+
+    size_t bytes() const { return gapBegin_ + buffer_.size() - gapEnd_; }
+
+    // Byte offset of character i, i \in [0, size()]
+    size_t start(size_t i) const {
+        if (i <= before_.size()) {
+            return i ? before_[i - 1] : 0;
+        }
+        if (i == size()) {
+            return bytes();
+        }
+        return bytes() - after_[size() - 1 - i];
+    }
+
+    std::string_view view(size_t i) const {
+        auto begin = start(i);
+        auto end = start(i + 1);
+        auto physical = begin < gapBegin_ ? begin : begin + gapEnd_ - gapBegin_;
+        return {buffer_.data() + physical, end - begin};
+    }
+
+    std::string str() const {
+        std::string result;
+        result.reserve(bytes());
+        result.append(buffer_.data(), gapBegin_);
+        result.append(buffer_.data() + gapEnd_, buffer_.size() - gapEnd_);
+        return result;
+    }
+
+    void insert(size_t i, std::string_view text) {
+        moveGap(i);
+        if (gapEnd_ - gapBegin_ < text.size()) {
+            grow(text.size());
+        }
+        auto offset = gapBegin_;
+        for (auto chrView : utf8::MakeUTF8StringViewRange(text)) {
+            offset += chrView.size();
+            before_.push_back(offset);
+        }
+        std::memcpy(buffer_.data() + gapBegin_, text.data(), text.size());
+        gapBegin_ += text.size();
+    }
+
+    void erase(size_t from, size_t to) {
+        moveGap(to);
+        before_.resize(from);
+        gapBegin_ = before_.empty() ? 0 : before_.back();
+    }
+
+    void shrinkToFit() {
+        buffer_ = str();
+        gapEnd_ = gapBegin_;
+        before_.shrink_to_fit();
+        after_.shrink_to_fit();
+    }
+
+private:
+    void moveGap(size_t i) {
+        while (before_.size() > i) {
+            auto len = before_.back() -
+                       (before_.size() > 1 ? before_[before_.size() - 2] : 0);
+            gapBegin_ -= len;
+            gapEnd_ -= len;
+            std::memmove(buffer_.data() + gapEnd_, buffer_.data() + gapBegin_,
+                         len);
+            before_.pop_back();
+            after_.push_back((after_.empty() ? 0 : after_.back()) + len);
+        }
+        while (before_.size() < i) {
+            auto len = after_.back() -
+                       (after_.size() > 1 ? after_[after_.size() - 2] : 0);
+            std::memmove(buffer_.data() + gapBegin_, buffer_.data() + gapEnd_,
+                         len);
+            gapBegin_ += len;
+            gapEnd_ += len;
+            after_.pop_back();
+            before_.push_back(gapBegin_);
+        }
+    }
+
+    void grow(size_t needed) {
+        auto afterBytes = buffer_.size() - gapEnd_;
+        auto gapSize = std::max(needed, std::max<size_t>(buffer_.size(), 16));
+        std::string newBuffer(gapBegin_ + gapSize + afterBytes, '\0');
+        std::memcpy(newBuffer.data(), buffer_.data(), gapBegin_);
+        std::memcpy(newBuffer.data() + gapBegin_ + gapSize,
+                    buffer_.data() + gapEnd_, afterBytes);
+        buffer_ = std::move(newBuffer);
+        gapEnd_ = gapBegin_ + gapSize;
+    }
+
+    std::string buffer_;
+    size_t gapBegin_ = 0;
+    size_t gapEnd_ = 0;
+    // before_[i] is the end offset of character i.
+    std::vector<size_t> before_;
+    // after_[j] is the offset from the start of j-th character from the end to
+    // the end.
+    std::vector<size_t> after_;
+};
+
+} // namespace
+
 class InputBufferPrivate {
 public:
     InputBufferPrivate(InputBufferOptions options) : options_(options) {}
@@ -41,8 +159,15 @@ public:
         return options_.test(InputBufferOption::FixedCursor);
     }
 
+    inline bool isGapBuffer() const {
+        return options_.test(InputBufferOption::GapBuffer);
+    }
+
     const InputBufferOptions options_;
-    std::string input_;
+    // With GapBuffer, this is only joined from gap_ when needed.
+    mutable std::string input_;
+    mutable bool inputDirty_ = false;
+    InputGapBuffer gap_;
     size_t cursor_ = 0;
     std::vector<size_t> sz_; // utf8 lengthindex helper
     size_t maxSize_ = 0;
@@ -66,6 +191,10 @@ bool InputBuffer::type(uint32_t unicode) {
 
 const std::string &InputBuffer::userInput() const {
     FCITX_D();
+    if (d->inputDirty_) {
+        d->input_ = d->gap_.str();
+        d->inputDirty_ = false;
+    }
     return d->input_;
 }
 
@@ -83,6 +212,12 @@ bool InputBuffer::typeImpl(const char *s, size_t length) {
     if (d->maxSize_ && (utf8Length + size() > d->maxSize_)) {
         return false;
     }
+    if (d->isGapBuffer()) {
+        d->gap_.insert(d->cursor_, view);
+        d->inputDirty_ = true;
+        d->cursor_ += utf8Length;
+        return true;
+    }
     d->input_.insert(std::next(d->input_.begin(), cursorByChar()), view.begin(),
                      view.end());
     if (!d->isAsciiOnly()) {
@@ -104,6 +239,9 @@ bool InputBuffer::typeImpl(const char *s, size_t length) {
 
 size_t InputBuffer::cursorByChar() const {
     FCITX_D();
+    if (d->isGapBuffer()) {
+        return d->gap_.start(d->cursor_);
+    }
     if (d->isAsciiOnly()) {
         return d->cursor_;
     }
@@ -121,6 +259,9 @@ size_t InputBuffer::cursor() const {
 
 size_t InputBuffer::size() const {
     FCITX_D();
+    if (d->isGapBuffer()) {
+        return d->gap_.size();
+    }
     return d->isAsciiOnly() ? d->input_.size() : d->sz_.size();
 }
 
@@ -157,8 +298,11 @@ void InputBuffer::erase(size_t from, size_t to) {
             return;
         }
 
-        size_t fromByChar, lengthByChar;
-        if (d->isAsciiOnly()) {
+        size_t fromByChar = 0, lengthByChar = 0;
+        if (d->isGapBuffer()) {
+            d->gap_.erase(from, to);
+            d->inputDirty_ = true;
+        } else if (d->isAsciiOnly()) {
             fromByChar = from;
             lengthByChar = to - from;
         } else {
@@ -177,7 +321,9 @@ void InputBuffer::erase(size_t from, size_t to) {
                 d->cursor_ -= to - from;
             }
         }
-        d->input_.erase(fromByChar, lengthByChar);
+        if (!d->isGapBuffer()) {
+            d->input_.erase(fromByChar, lengthByChar);
+        }
     }
 }
 
@@ -186,6 +332,9 @@ std::pair<size_t, size_t> InputBuffer::rangeAt(size_t i) const {
     if (i >= size()) {
         throw std::out_of_range("out of range");
     }
+    if (d->isGapBuffer()) {
+        return {d->gap_.start(i), d->gap_.start(i + 1)};
+    }
     if (d->isAsciiOnly()) {
         return {i, i + 1};
     }
@@ -194,6 +343,13 @@ std::pair<size_t, size_t> InputBuffer::rangeAt(size_t i) const {
 }
 
 std::string_view InputBuffer::viewAt(size_t i) const {
+    FCITX_D();
+    if (d->isGapBuffer()) {
+        if (i >= size()) {
+            throw std::out_of_range("out of range");
+        }
+        return d->gap_.view(i);
+    }
     auto [start, end] = rangeAt(i);
     return std::string_view(userInput()).substr(start, end - start);
 }
@@ -203,6 +359,10 @@ uint32_t InputBuffer::charAt(size_t i) const {
     if (i >= size()) {
         throw std::out_of_range("out of range");
     }
+    if (d->isGapBuffer()) {
+        auto view = d->gap_.view(i);
+        return utf8::getChar(view.begin(), view.end());
+    }
     if (d->isAsciiOnly()) {
         return d->input_[i];
     }
@@ -213,6 +373,9 @@ uint32_t InputBuffer::charAt(size_t i) const {
 
 size_t InputBuffer::sizeAt(size_t i) const {
     FCITX_D();
+    if (d->isGapBuffer()) {
+        return d->gap_.start(i + 1) - d->gap_.start(i);
+    }
     if (d->isAsciiOnly()) {
         return 1;
     }
@@ -221,6 +384,7 @@ size_t InputBuffer::sizeAt(size_t i) const {
 
 void InputBuffer::shrinkToFit() {
     FCITX_D();
+    d->gap_.shrinkToFit();
     d->input_.shrink_to_fit();
     d->sz_.shrink_to_fit();
     d->acc_.shrink_to_fit();
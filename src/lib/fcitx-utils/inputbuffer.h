@@ -30,7 +30,18 @@ enum class InputBufferOption {
     /// exception.
     AsciiOnly = 1,
     /// Whether the input buffer only supports cursor at the end of buffer.
-    FixedCursor = 1 << 1
+    FixedCursor = 1 << 1,
+    /**
+     * Keep the buffer split at the editing position.
+     *
+     * Typing and erasing next to the previous edit does not need to move the
+     * rest of the buffer, and character lookup does not need to scan the
+     * buffer. userInput() needs to join the buffer after each change. This is
+     * useful for long buffer that is edited in the middle.
+     *
+     * @since 5.1.12
+     */
+    GapBuffer = 1 << 2
 };
 
 using InputBufferOptions = Flags<InputBufferOption>;
@@ -6,12 +6,16 @@
  */
 
 #include "key.h"
+#include <cstdint>
 #include <cstring>
+#include <stdexcept>
+#include <string_view>
 #include <unordered_map>
 #include "charutils.h"
 #include "i18n.h"
 #include "keydata.h"
 #include "keynametable-compat.h"
+#include "keynametable-hash.h"
 #include "keynametable.h"
 #include "misc_p.h"
 #include "stringutils.h"
@@ -275,6 +279,44 @@ std::unordered_map<KeySym, const char *, EnumHash> makeLookupKeyNameMap() {
     return result;
 }
 
+// Hash functions of the perfect hash tables generated by update-keydata.py,
+// they need to be kept in sync with the script.
+constexpr uint32_t fnv1a(const unsigned char *data, size_t size,
+                         uint32_t seed) {
+    uint32_t hash = 2166136261U ^ seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+uint32_t keyNameHash(std::string_view name, uint32_t seed) {
+    return fnv1a(reinterpret_cast<const unsigned char *>(name.data()),
+                 name.size(), seed);
+}
+
+uint32_t keySymHash(uint32_t sym, uint32_t seed) {
+    const unsigned char data[] = {
+        static_cast<unsigned char>(sym & 0xff),
+        static_cast<unsigned char>((sym >> 8) & 0xff),
+        static_cast<unsigned char>((sym >> 16) & 0xff),
+        static_cast<unsigned char>((sym >> 24) & 0xff)};
+    return fnv1a(data, sizeof(data), seed);
+}
+
+// Return the slot of key. A key not in the table still maps to some slot, so
+// the caller needs to compare the key with the entry in the slot.
+template <typename T, typename Hash>
+size_t perfectHashSlot(const T &key, Hash hash, const int32_t *displacement,
+                       size_t size) {
+    const auto d = displacement[hash(key, 0) % size];
+    if (d < 0) {
+        return -d - 1;
+    }
+    return hash(key, d) % size;
+}
+
 const char *lookupName(KeySym sym) {
     static const std::unordered_map<KeySym, const char *, EnumHash> map =
         makeLookupKeyNameMap();
@@ -596,17 +638,13 @@ KeyStates Key::keySymToStates(KeySym sym) {
 }
 
 KeySym Key::keySymFromString(const std::string &keyString) {
-    const auto *value = std::lower_bound(
-        keyValueByNameOffset,
-        keyValueByNameOffset + FCITX_ARRAY_SIZE(keyValueByNameOffset),
-        keyString, [](const uint32_t &idx, const std::string &str) {
-            return keyNameList[&idx - keyValueByNameOffset] < str;
-        });
-
-    if (value !=
-            keyValueByNameOffset + FCITX_ARRAY_SIZE(keyValueByNameOffset) &&
-        keyString == keyNameList[value - keyValueByNameOffset]) {
-        return static_cast<KeySym>(*value);
+    static_assert(FCITX_ARRAY_SIZE(keyNameHashSlot) ==
+                  FCITX_ARRAY_SIZE(keyNameList));
+    const auto nameIndex = keyNameHashSlot[perfectHashSlot(
+        std::string_view(keyString), keyNameHash, keyNameHashDisplacement,
+        FCITX_ARRAY_SIZE(keyNameHashSlot))];
+    if (keyString == keyNameList[nameIndex]) {
+        return static_cast<KeySym>(keyValueByNameOffset[nameIndex]);
     }
 
     const auto *compat = std::lower_bound(
@@ -648,26 +686,18 @@ std::string Key::keySymToString(KeySym sym, KeyStringFormat format) {
         }
     }
 
-    const KeyNameOffsetByValue *result = std::lower_bound(
-        keyNameOffsetByValue,
-        keyNameOffsetByValue + FCITX_ARRAY_SIZE(keyNameOffsetByValue), sym,
-        [](const KeyNameOffsetByValue &item, KeySym key) {
-            return item.sym < key;
-        });
-    if (result !=
-            keyNameOffsetByValue + FCITX_ARRAY_SIZE(keyNameOffsetByValue) &&
-        result->sym == sym) {
-        return keyNameList[result->offset];
+    static_assert(FCITX_ARRAY_SIZE(keySymHashSlot) ==
+                  FCITX_ARRAY_SIZE(keyNameOffsetByValue));
+    const auto &result = keyNameOffsetByValue[keySymHashSlot[perfectHashSlot(
+        static_cast<uint32_t>(sym), keySymHash, keySymHashDisplacement,
+        FCITX_ARRAY_SIZE(keySymHashSlot))]];
+    if (result.sym == static_cast<uint32_t>(sym)) {
+        return keyNameList[result.offset];
     }
     return std::string();
 }
 
 KeySym Key::keySymFromUnicode(uint32_t unicode) {
-    const auto &tab = unicode_to_keysym_tab();
-    int min = 0;
-    int max = tab.size() - 1;
-    int mid;
-
     /* first check for Latin-1 characters (1:1 mapping) */
     if ((unicode >= 0x0020 && unicode <= 0x007e) ||
         (unicode >= 0x00a0 && unicode <= 0x00ff))
@@ -688,17 +718,8 @@ KeySym Key::keySymFromUnicode(uint32_t unicode) {
         (unicode & 0xfffe) == 0xfffe)
         return FcitxKey_None;
 
-    /* Binary search in table */
-    while (max >= min) {
-        mid = (min + max) / 2;
-        if (tab[mid].ucs < unicode) {
-            min = mid + 1;
-        } else if (tab[mid].ucs > unicode) {
-            max = mid - 1;
-        } else {
-            /* found it */
-            return static_cast<KeySym>(tab[mid].keysym);
-        }
+    if (auto keysym = unicode_to_keysym_map().lookup(unicode)) {
+        return static_cast<KeySym>(keysym);
     }
 
     /*
@@ -709,11 +730,6 @@ KeySym Key::keySymFromUnicode(uint32_t unicode) {
 }
 
 uint32_t Key::keySymToUnicode(KeySym sym) {
-    int min = 0;
-    int max =
-        sizeof(keysym_to_unicode_tab) / sizeof(keysym_to_unicode_tab[0]) - 1;
-    int mid;
-
     /* first check for Latin-1 characters (1:1 mapping) */
     if ((sym >= 0x0020 && sym <= 0x007e) || (sym >= 0x00a0 && sym <= 0x00ff)) {
         return sym;
@@ -756,21 +772,8 @@ uint32_t Key::keySymToUnicode(KeySym sym) {
         return 0;
     }
 
-    /* binary search in table */
-    while (max >= min) {
-        mid = (min + max) / 2;
-        if (keysym_to_unicode_tab[mid].keysym < sym) {
-            min = mid + 1;
-        } else if (keysym_to_unicode_tab[mid].keysym > sym) {
-            max = mid - 1;
-        } else {
-            /* found it */
-            return keysym_to_unicode_tab[mid].ucs;
-        }
-    }
-
-    /* No matching Unicode value found */
-    return 0;
+    /* No matching Unicode value found is 0 */
+    return keysym_to_unicode_map().lookup(sym);
 }
 
 std::string Key::keySymToUTF8(KeySym sym) {
@@ -799,4 +802,81 @@ std::vector<Key> Key::keyListFromString(const std::string &str) {
 
     return keyList;
 }
+class KeyMatcherPrivate {
+public:
+    static uint64_t indexKey(uint32_t symOrCode, KeyStates states) {
+        return (static_cast<uint64_t>(symOrCode) << 32) | states.toInteger();
+    }
+
+    static uint64_t lookup(const std::unordered_map<uint64_t, uint64_t> &index,
+                           uint32_t symOrCode, KeyStates states) {
+        if (const auto *groups = findValue(index, indexKey(symOrCode, states))) {
+            return *groups;
+        }
+        return 0;
+    }
+
+    // Keys with key code, indexed by code and states.
+    std::unordered_map<uint64_t, uint64_t> codeIndex_;
+    // Keys with key sym, indexed by sym and states.
+    std::unordered_map<uint64_t, uint64_t> symIndex_;
+};
+
+KeyMatcher::KeyMatcher() : d_ptr(std::make_unique<KeyMatcherPrivate>()) {}
+
+FCITX_DEFINE_DPTR_COPY_AND_DEFAULT_DTOR_AND_MOVE(KeyMatcher);
+
+void KeyMatcher::addKeys(size_t group, const KeyList &keys) {
+    FCITX_D();
+    if (group >= maxGroups) {
+        throw std::invalid_argument("Invalid key matcher group");
+    }
+    const uint64_t mask = static_cast<uint64_t>(1) << group;
+    for (const auto &key : keys) {
+        // Follow the order of checks in Key::check.
+        if (key.code()) {
+            d->codeIndex_[KeyMatcherPrivate::indexKey(key.code(),
+                                                      key.states())] |= mask;
+        } else if (key.sym() != FcitxKey_None &&
+                   key.sym() != FcitxKey_VoidSymbol) {
+            d->symIndex_[KeyMatcherPrivate::indexKey(key.sym(),
+                                                     key.states())] |= mask;
+        }
+    }
+}
+
+void KeyMatcher::clear() {
+    FCITX_D();
+    d->codeIndex_.clear();
+    d->symIndex_.clear();
+}
+
+uint64_t KeyMatcher::match(const Key &key) const {
+    FCITX_D();
+    // Same as the states used by Key::check.
+    auto states = key.states() & KeyStates({KeyState::Ctrl_Alt_Shift,
+                                            KeyState::Super, KeyState::Mod3});
+    if (key.states().test(KeyState::Super2)) {
+        states |= KeyState::Super;
+    }
+
+    uint64_t result = 0;
+    if (key.code() && !d->codeIndex_.empty()) {
+        result |= KeyMatcherPrivate::lookup(d->codeIndex_, key.code(), states);
+    }
+    if (d->symIndex_.empty()) {
+        return result;
+    }
+    if (key.isModifier()) {
+        auto modifierStates = Key::keySymToStates(key.sym());
+        result |= KeyMatcherPrivate::lookup(d->symIndex_, key.sym(),
+                                            key.states() & (~modifierStates));
+        result |= KeyMatcherPrivate::lookup(d->symIndex_, key.sym(),
+                                            key.states() | modifierStates);
+    } else {
+        result |= KeyMatcherPrivate::lookup(d->symIndex_, key.sym(), states);
+    }
+    return result;
+}
+
 } // namespace fcitx
@@ -16,10 +16,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <fcitx-utils/flags.h>
 #include <fcitx-utils/keysym.h>
+#include <fcitx-utils/macros.h>
 #include "fcitxutils_export.h"
 
 namespace fcitx {
@@ -247,6 +249,50 @@ private:
     KeyStates states_;
     int code_;
 };
+
+class KeyMatcherPrivate;
+
+/**
+ * Index of key lists to check a key against all of them at once.
+ *
+ * Each key list is added to a group, and match() returns the groups that have
+ * a key accepted by Key::check. This only needs a few hash lookups no matter
+ * how many keys are added, so it is useful for hotkeys checked on every key
+ * event.
+ *
+ * @since 5.1.12
+ */
+class FCITXUTILS_EXPORT KeyMatcher {
+public:
+    /// Max number of groups.
+    static constexpr size_t maxGroups = 64;
+
+    KeyMatcher();
+    FCITX_DECLARE_VIRTUAL_DTOR_COPY_AND_MOVE(KeyMatcher);
+
+    /// Add keys to group, group need to be less than maxGroups.
+    void addKeys(size_t group, const KeyList &keys);
+
+    /// Remove all keys.
+    void clear();
+
+    /**
+     * Check key against all groups.
+     *
+     * @return bit mask of groups, bit i is set if key.checkKeyList(keys) is
+     * true for the keys added to group i.
+     */
+    uint64_t match(const Key &key) const;
+
+    /// Check key against keys in group.
+    bool match(const Key &key, size_t group) const {
+        return match(key) & (static_cast<uint64_t>(1) << group);
+    }
+
+private:
+    std::unique_ptr<KeyMatcherPrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(KeyMatcher);
+};
 } // namespace fcitx
 
 #endif //  _FCITX_UTILS_KEY_H_
@@ -7,6 +7,8 @@
 #include "keydata.h"
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 
 namespace fcitx {
 const UnicodeToKeySymTab &unicode_to_keysym_tab() {
@@ -23,4 +25,55 @@ const UnicodeToKeySymTab &unicode_to_keysym_tab() {
 
     return tab;
 }
+
+void KeySymUnicodeMap::insert(uint16_t key, uint16_t value) {
+    auto &page = pages_[key >> 8];
+    if (!page) {
+        page = std::make_unique<Page>();
+    }
+    auto &entry = (*page)[key & 0xff];
+    if (!entry) {
+        entry = value;
+    }
+}
+
+const KeySymUnicodeMap &keysym_to_unicode_map() {
+    static const KeySymUnicodeMap map = []() {
+        KeySymUnicodeMap map;
+        for (const auto &item : keysym_to_unicode_tab) {
+            map.insert(item.keysym, item.ucs);
+        }
+        return map;
+    }();
+    return map;
+}
+
+const KeySymUnicodeMap &unicode_to_keysym_map() {
+    static const KeySymUnicodeMap map = []() {
+        // Some characters have more than one keysym, keep the one that used
+        // to be found by binary search.
+        const auto &tab = unicode_to_keysym_tab();
+        KeySymUnicodeMap map;
+        for (const auto &item : tab) {
+            if (map.lookup(item.ucs)) {
+                continue;
+            }
+            size_t min = 0;
+            size_t max = tab.size();
+            while (min < max) {
+                const size_t mid = (min + max - 1) / 2;
+                if (tab[mid].ucs < item.ucs) {
+                    min = mid + 1;
+                } else if (tab[mid].ucs > item.ucs) {
+                    max = mid;
+                } else {
+                    map.insert(item.ucs, tab[mid].keysym);
+                    break;
+                }
+            }
+        }
+        return map;
+    }();
+    return map;
+}
 } // namespace fcitx
\ No newline at end of file
@@ -25,6 +25,7 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include "fcitx-utils/macros.h"
 
 namespace fcitx {
@@ -878,6 +879,30 @@ using UnicodeToKeySymTab =
     std::array<KeySymUnicode, FCITX_ARRAY_SIZE(keysym_to_unicode_tab)>;
 const UnicodeToKeySymTab &unicode_to_keysym_tab();
 
+// Direct lookup of the 16 bit values in keysym_to_unicode_tab. It is a two
+// level table indexed by the high and low byte, pages without any entry are
+// not allocated. 0 means no value.
+class KeySymUnicodeMap {
+public:
+    uint16_t lookup(uint32_t key) const {
+        if (key > 0xffff) {
+            return 0;
+        }
+        const auto &page = pages_[key >> 8];
+        return page ? (*page)[key & 0xff] : 0;
+    }
+
+    // Keep the first value if key exists.
+    void insert(uint16_t key, uint16_t value);
+
+private:
+    using Page = std::array<uint16_t, 256>;
+    std::array<std::unique_ptr<Page>, 256> pages_;
+};
+
+const KeySymUnicodeMap &keysym_to_unicode_map();
+const KeySymUnicodeMap &unicode_to_keysym_map();
+
 } // namespace fcitx
 
 #endif // _FCITX_UTILS_KEYDATA_H_
@@ -0,0 +1,8943 @@
+/*
+ * SPDX-FileCopyrightText: 2015~2015 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#ifndef _FCITX_UTILS_KEYNAMETABLE_HASH_H_
+#define _FCITX_UTILS_KEYNAMETABLE_HASH_H_
+
+#include <cstdint>
+#include <fcitx-utils/macros.h>
+
+// Generated by update-keydata.py, see keyNameHash and keySymHash in key.cpp.
+
+FCITX_C_DECL_BEGIN
+
+// Displacement of keyNameList hash buckets.
+static const int32_t keyNameHashDisplacement[] _FCITX_UNUSED_ =
+{
+-2273,
+-2269,
+0,
+0,
+3,
+0,
+2,
+1,
+0,
+-2264,
+2,
+0,
+3,
+1,
+-2259,
+-2257,
+0,
+1,
+0,
+-2256,
+-2255,
+0,
+-2250,
+0,
+2,
+0,
+-2245,
+-2243,
+0,
+0,
+-2241,
+-2238,
+-2237,
+0,
+0,
+0,
+0,
+0,
+0,
+0,
+-2232,
+-2231,
+0,
+0,
+5,
+1,
+0,
+0,
+0,
+-2230,
+-2225,
+-2222,
+-2221,
+0,
+-2219,
+0,
+-2218,
+-2213,
+1,
+1,
+1,
+0,
+1,
+0,
+1,
+-2212,
+1,
+0,
+0,
+-2210,
+-2204,
+0,
+0,
+-2202,
+0,
+-2199,
+-2198,
+0,
+-2197,
+0,
+0,
+-2194,
+0,
+0,
+-2192,
+-2191,
+-2186,
+3,
+0,
+1,
+0,
+-2182,
+0,
+0,
+1,
+0,
+-2179,
+-2176,
+0,
+0,
+0,
+1,
+0,
+0,
+-2174,
+-2173,
+0,
+0,
+0,
+-2171,
+0,
+0,
+0,
+0,
+0,
+-2168,
+1,
+-2167,
+-2163,
+-2159,
+0,
+-2151,
+-2150,
+0,
+-2148,
+1,
+0,
+-2142,
+-2137,
+0,
+0,
+2,
+1,
+-2136,
+-2126,
+-2118,
+-2116,
+1,
+-2113,
+-2112,
+-2111,
+-2110,
+-2108,
+3,
+-2107,
+0,
+-2103,
+-2097,
+0,
+0,
+0,
+0,
+1,
+0,
+-2095,
+2,
+0,
+1,
+1,
+-2091,
+1,
+1,
+-2090,
+-2085,
+4,
+0,
+-2075,
+0,
+0,
+0,
+-2070,
+-2068,
+1,
+0,
+-2064,
+-2063,
+-2062,
+0,
+0,
+1,
+-2058,
+0,
+0,
+-2056,
+-2047,
+0,
+-2045,
+2,
+-2043,
+-2042,
+-2041,
+-2036,
+-2035,
+0,
+0,
+-2031,
+0,
+-2030,
+0,
+1,
+0,
+0,
+1,
+-2029,
+0,
+-2028,
+0,
+0,
+-2024,
+0,
+0,
+0,
+-2023,
+0,
+0,
+-2021,
+-2018,
+3,
+-2017,
+3,
+0,
+2,
+-2015,
+7,
+-2008,
+0,
+2,
+-2005,
+1,
+0,
+0,
+-2004,
+-2000,
+-1998,
+2,
+2,
+-1997,
+-1995,
+0,
+-1992,
+-1991,
+0,
+-1987,
+-1981,
+0,
+0,
+1,
+0,
+-1973,
+-1970,
+0,
+-1969,
+1,
+0,
+0,
+-1966,
+0,
+1,
+-1964,
+-1960,
+-1956,
+-1954,
+0,
+-1950,
+2,
+4,
+-1949,
+5,
+6,
+1,
+0,
+-1942,
+-1937,
+-1936,
+-1934,
+1,
+-1932,
+1,
+0,
+2,
+0,
+1,
+-1931,
+1,
+0,
+1,
+-1930,
+0,
+0,
+-1928,
+0,
+0,
+0,
+1,
+-1927,
+1,
+0,
+-1926,
+-1925,
+0,
+1,
+-1922,
+0,
+-1919,
+-1912,
+0,
+-1908,
+0,
+0,
+0,
+-1907,
+1,
+0,
+3,
+4,
+0,
+1,
+2,
+2,
+-1904,
+3,
+0,
+-1898,
+0,
+2,
+0,
+1,
+-1897,
+-1896,
+4,
+0,
+2,
+0,
+0,
+2,
+-1893,
+0,
+1,
+0,
+-1890,
+-1888,
+-1887,
+1,
+0,
+0,
+0,
+0,
+-1886,
+2,
+0,
+1,
+1,
+0,
+-1885,
+-1884,
+1,
+0,
+-1882,
+-1881,
+2,
+2,
+3,
+1,
+0,
+-1876,
+3,
+-1873,
+3,
+1,
+-1866,
+-1865,
+-1864,
+2,
+-1861,
+0,
+-1860,
+1,
+0,
+-1856,
+0,
+0,
+-1854,
+0,
+0,
+2,
+2,
+1,
+0,
+0,
+2,
+0,
+0,
+1,
+0,
+-1852,
+0,
+0,
+1,
+3,
+-1850,
+0,
+1,
+2,
+1,
+-1849,
+0,
+-1841,
+-1835,
+1,
+0,
+0,
+-1833,
+0,
+-1832,
+-1826,
+3,
+0,
+-1825,
+0,
+0,
+0,
+-1823,
+-1821,
+0,
+-1819,
+5,
+-1818,
+0,
+3,
+0,
+-1817,
+0,
+1,
+3,
+-1810,
+-1809,
+0,
+-1805,
+-1802,
+2,
+-1800,
+-1799,
+0,
+0,
+-1798,
+0,
+1,
+0,
+-1794,
+-1791,
+-1785,
+0,
+1,
+0,
+1,
+-1784,
+2,
+0,
+0,
+0,
+5,
+0,
+0,
+-1779,
+1,
+0,
+0,
+-1778,
+0,
+-1777,
+-1774,
+-1773,
+-1767,
+3,
+0,
+-1765,
+1,
+0,
+1,
+0,
+-1764,
+0,
+2,
+-1763,
+0,
+-1762,
+6,
+-1758,
+2,
+0,
+1,
+-1754,
+-1750,
+1,
+0,
+0,
+1,
+0,
+0,
+3,
+0,
+0,
+0,
+1,
+0,
+0,
+0,
+-1745,
+6,
+0,
+2,
+-1743,
+0,
+0,
+-1742,
+0,
+0,
+-1740,
+0,
+0,
+-1739,
+0,
+0,
+3,
+1,
+-1738,
+3,
+-1737,
+0,
+-1733,
+0,
+0,
+-1731,
+0,
+0,
+-1727,
+0,
+0,
+4,
+0,
+0,
+0,
+0,
+0,
+0,
+3,
+-1725,
+-1723,
+1,
+-1721,
+0,
+0,
+0,
+-1718,
+-1717,
+0,
+0,
+0,
+0,
+-1716,
+5,
+-1712,
+0,
+0,
+0,
+1,
+0,
+-1711,
+-1709,
+0,
+1,
+0,
+1,
+-1707,
+-1703,
+0,
+3,
+-1700,
+4,
+-1692,
+-1689,
+-1686,
+-1685,
+-1683,
+0,
+0,
+0,
+3,
+4,
+-1679,
+-1677,
+1,
+-1672,
+-1670,
+0,
+0,
+3,
+-1668,
+1,
+0,
+1,
+2,
+0,
+0,
+-1664,
+1,
+2,
+-1661,
+-1658,
+1,
+1,
+-1640,
+0,
+-1637,
+2,
+-1633,
+0,
+0,
+-1630,
+0,
+-1623,
+-1621,
+-1619,
+-1615,
+-1611,
+0,
+-1610,
+-1607,
+0,
+-1605,
+4,
+1,
+0,
+1,
+0,
+-1600,
+0,
+0,
+0,
+-1597,
+0,
+1,
+1,
+1,
+-1596,
+5,
+-1594,
+0,
+-1593,
+0,
+-1588,
+1,
+-1580,
+-1576,
+0,
+0,
+1,
+2,
+-1574,
+0,
+-1572,
+2,
+0,
+3,
+0,
+1,
+0,
+-1570,
+-1568,
+0,
+0,
+0,
+1,
+1,
+0,
+11,
+0,
+0,
+0,
+-1565,
+1,
+2,
+0,
+-1560,
+0,
+0,
+1,
+0,
+-1559,
+0,
+-1554,
+0,
+1,
+1,
+1,
+-1551,
+0,
+0,
+2,
+1,
+1,
+0,
+0,
+0,
+-1550,
+0,
+2,
+6,
+0,
+0,
+2,
+0,
+0,
+-1547,
+0,
+-1537,
+-1536,
+3,
+-1535,
+0,
+2,
+3,
+-1533,
+0,
+2,
+-1532,
+-1530,
+-1527,
+0,
+-1525,
+7,
+0,
+6,
+-1523,
+1,
+-1522,
+-1518,
+1,
+-1515,
+-1510,
+0,
+1,
+2,
+0,
+4,
+-1509,
+0,
+-1505,
+1,
+2,
+-1498,
+0,
+0,
+0,
+3,
+-1497,
+0,
+-1481,
+0,
+0,
+0,
+2,
+-1477,
+-1472,
+0,
+0,
+-1466,
+-1464,
+-1460,
+-1459,
+6,
+-1458,
+2,
+0,
+-1455,
+0,
+-1454,
+-1453,
+0,
+0,
+0,
+0,
+0,
+-1449,
+2,
+-1445,
+-1440,
+0,
+-1439,
+2,
+-1436,
+0,
+0,
+0,
+0,
+-1434,
+-1432,
+0,
+0,
+2,
+-1427,
+0,
+-1423,
+4,
+-1421,
+0,
+-1412,
+0,
+-1410,
+2,
+0,
+-1408,
+0,
+-1407,
+2,
+1,
+1,
+-1402,
+1,
+5,
+3,
+-1399,
+-1394,
+1,
+-1392,
+1,
+1,
+5,
+-1391,
+-1389,
+0,
+0,
+-1388,
+-1386,
+0,
+0,
+0,
+0,
+0,
+-1385,
+2,
+-1383,
+0,
+0,
+-1381,
+0,
+-1380,
+-1377,
+0,
+1,
+2,
+0,
+-1376,
+4,
+1,
+0,
+0,
+2,
+-1375,
+4,
+-1374,
+3,
+-1368,
+1,
+1,
+6,
+4,
+0,
+1,
+1,
+0,
+1,
+2,
+-1367,
+1,
+-1364,
+1,
+5,
+-1363,
+-1357,
+-1356,
+1,
+0,
+0,
+-1352,
+-1348,
+3,
+-1347,
+0,
+2,
+0,
+-1343,
+7,
+2,
+-1342,
+0,
+0,
+0,
+1,
+0,
+-1338,
+-1333,
+2,
+0,
+-1330,
+0,
+0,
+0,
+0,
+4,
+-1328,
+0,
+0,
+2,
+-1322,
+-1320,
+4,
+-1319,
+0,
+0,
+1,
+0,
+-1309,
+-1306,
+3,
+0,
+-1304,
+0,
+-1300,
+0,
+-1297,
+0,
+-1296,
+-1295,
+-1294,
+-1290,
+2,
+0,
+1,
+0,
+0,
+-1289,
+-1287,
+0,
+-1281,
+0,
+-1276,
+-1274,
+-1272,
+-1271,
+0,
+0,
+0,
+0,
+0,
+1,
+1,
+0,
+0,
+-1262,
+2,
+-1256,
+4,
+2,
+0,
+-1253,
+0,
+0,
+0,
+0,
+2,
+4,
+-1244,
+1,
+-1241,
+-1239,
+-1237,
+1,
+1,
+0,
+-1233,
+0,
+10,
+0,
+-1232,
+0,
+2,
+3,
+-1229,
+0,
+1,
+0,
+1,
+0,
+0,
+0,
+6,
+0,
+0,
+-1227,
+-1226,
+1,
+2,
+0,
+0,
+0,
+3,
+-1224,
+0,
+0,
+-1222,
+-1221,
+-1217,
+0,
+2,
+-1216,
+-1212,
+0,
+0,
+0,
+-1211,
+8,
+0,
+3,
+0,
+0,
+0,
+0,
+0,
+-1210,
+0,
+6,
+-1209,
+0,
+1,
+-1205,
+3,
+5,
+2,
+1,
+0,
+-1201,
+-1198,
+-1197,
+-1194,
+0,
+-1193,
+2,
+1,
+0,
+0,
+0,
+-1191,
+1,
+-1189,
+1,
+0,
+0,
+7,
+0,
+-1180,
+-1177,
+-1175,
+0,
+0,
+-1171,
+-1170,
+-1169,
+0,
+12,
+3,
+1,
+-1165,
+0,
+9,
+-1160,
+-1159,
+3,
+-1158,
+-1154,
+-1151,
+-1150,
+-1146,
+1,
+0,
+-1145,
+0,
+-1142,
+0,
+0,
+0,
+-1139,
+-1137,
+0,
+9,
+8,
+0,
+-1136,
+3,
+5,
+1,
+0,
+-1132,
+-1130,
+0,
+5,
+0,
+0,
+0,
+-1129,
+-1126,
+11,
+-1124,
+3,
+3,
+0,
+1,
+-1123,
+-1119,
+5,
+0,
+-1118,
+-1117,
+0,
+0,
+-1116,
+3,
+2,
+-1115,
+0,
+0,
+-1113,
+0,
+-1112,
+-1106,
+0,
+-1105,
+0,
+0,
+0,
+1,
+0,
+0,
+0,
+-1102,
+0,
+0,
+7,
+0,
+0,
+-1098,
+4,
+-1097,
+-1095,
+3,
+-1093,
+0,
+-1092,
+-1090,
+4,
+3,
+-1089,
+1,
+-1083,
+0,
+2,
+-1080,
+-1079,
+-1074,
+0,
+0,
+0,
+-1072,
+1,
+0,
+0,
+-1071,
+3,
+0,
+2,
+0,
+3,
+-1070,
+-1069,
+0,
+-1065,
+-1064,
+6,
+-1063,
+-1062,
+0,
+-1061,
+-1058,
+3,
+-1057,
+-1055,
+0,
+-1054,
+-1051,
+0,
+0,
+-1049,
+0,
+-1044,
+-1041,
+-1038,
+-1031,
+0,
+0,
+-1030,
+-1021,
+0,
+0,
+-1020,
+-1019,
+0,
+0,
+0,
+-1018,
+5,
+0,
+2,
+0,
+-1014,
+0,
+-1012,
+0,
+4,
+-1003,
+0,
+-1001,
+0,
+-998,
+0,
+-995,
+0,
+1,
+1,
+0,
+4,
+0,
+-994,
+-992,
+0,
+-990,
+-988,
+-987,
+-986,
+0,
+1,
+0,
+1,
+0,
+0,
+1,
+0,
+-981,
+6,
+1,
+1,
+-980,
+0,
+-975,
+-974,
+7,
+1,
+1,
+1,
+0,
+2,
+0,
+-973,
+-966,
+1,
+-964,
+-963,
+-961,
+-959,
+-953,
+-952,
+0,
+-947,
+0,
+0,
+0,
+1,
+0,
+-943,
+1,
+0,
+0,
+1,
+0,
+0,
+4,
+14,
+-942,
+0,
+0,
+-940,
+0,
+4,
+-939,
+-936,
+0,
+0,
+0,
+0,
+0,
+1,
+4,
+1,
+0,
+-934,
+1,
+-930,
+0,
+0,
+1,
+6,
+0,
+1,
+-928,
+-927,
+-923,
+5,
+0,
+-922,
+0,
+0,
+4,
+1,
+4,
+1,
+5,
+-920,
+5,
+0,
+-919,
+0,
+-915,
+4,
+0,
+0,
+-912,
+0,
+1,
+0,
+2,
+0,
+0,
+-911,
+-909,
+1,
+0,
+2,
+0,
+-908,
+-904,
+-898,
+0,
+0,
+-892,
+1,
+-889,
+0,
+-872,
+1,
+0,
+-870,
+0,
+-869,
+5,
+-864,
+-863,
+-860,
+0,
+-858,
+-853,
+0,
+-852,
+-851,
+-848,
+1,
+-844,
+-843,
+0,
+-842,
+0,
+-840,
+1,
+-838,
+-834,
+4,
+-830,
+1,
+0,
+-829,
+-827,
+1,
+2,
+-825,
+-818,
+4,
+1,
+-817,
+0,
+1,
+-815,
+0,
+-813,
+-806,
+7,
+-805,
+-803,
+0,
+0,
+-801,
+0,
+0,
+2,
+-788,
+-787,
+-786,
+3,
+0,
+0,
+0,
+0,
+2,
+-784,
+4,
+6,
+-783,
+-781,
+-779,
+-771,
+0,
+0,
+0,
+-770,
+-768,
+0,
+0,
+0,
+1,
+-766,
+2,
+-763,
+-761,
+0,
+1,
+0,
+1,
+1,
+4,
+0,
+0,
+-760,
+2,
+0,
+-755,
+-753,
+6,
+2,
+-745,
+3,
+0,
+0,
+2,
+0,
+0,
+0,
+7,
+-744,
+8,
+0,
+0,
+1,
+-743,
+-739,
+2,
+5,
+1,
+1,
+1,
+-735,
+5,
+0,
+-734,
+0,
+-731,
+0,
+-727,
+0,
+-725,
+4,
+0,
+1,
+0,
+-724,
+0,
+3,
+-720,
+-719,
+9,
+0,
+2,
+-717,
+0,
+0,
+0,
+8,
+-715,
+4,
+-714,
+-711,
+1,
+0,
+11,
+-710,
+-709,
+0,
+-706,
+-705,
+-704,
+1,
+0,
+4,
+-701,
+-700,
+-697,
+-695,
+-692,
+-690,
+0,
+0,
+1,
+-688,
+-685,
+7,
+-684,
+0,
+0,
+0,
+0,
+0,
+-683,
+0,
+5,
+2,
+0,
+1,
+0,
+-681,
+-680,
+0,
+0,
+4,
+0,
+4,
+0,
+-679,
+0,
+0,
+0,
+0,
+0,
+3,
+3,
+-675,
+2,
+2,
+-671,
+-668,
+1,
+1,
+0,
+0,
+0,
+-666,
+3,
+0,
+0,
+-665,
+-662,
+0,
+-660,
+0,
+0,
+0,
+0,
+-658,
+0,
+-656,
+-650,
+-645,
+-644,
+-641,
+0,
+0,
+-637,
+0,
+-636,
+3,
+1,
+7,
+0,
+-635,
+7,
+-632,
+1,
+2,
+2,
+0,
+-626,
+0,
+-621,
+0,
+-614,
+-613,
+-607,
+-606,
+0,
+0,
+0,
+1,
+-601,
+3,
+0,
+-599,
+0,
+0,
+0,
+-598,
+5,
+-593,
+-589,
+3,
+1,
+-585,
+0,
+1,
+-582,
+0,
+1,
+3,
+-581,
+10,
+-568,
+-566,
+-565,
+-560,
+-559,
+-558,
+-557,
+0,
+-556,
+0,
+0,
+0,
+0,
+0,
+-552,
+0,
+-547,
+-546,
+-541,
+0,
+0,
+0,
+1,
+4,
+-540,
+3,
+0,
+3,
+1,
+0,
+1,
+4,
+10,
+1,
+-532,
+0,
+-530,
+0,
+3,
+-529,
+2,
+-525,
+1,
+-523,
+12,
+0,
+0,
+-517,
+0,
+0,
+0,
+2,
+0,
+2,
+0,
+0,
+-513,
+-512,
+0,
+2,
+0,
+8,
+0,
+-508,
+1,
+0,
+-504,
+0,
+0,
+-499,
+-495,
+0,
+1,
+0,
+0,
+1,
+7,
+-492,
+3,
+0,
+0,
+0,
+-491,
+-487,
+3,
+2,
+0,
+0,
+0,
+-486,
+-478,
+0,
+3,
+2,
+-477,
+0,
+0,
+-475,
+0,
+8,
+-466,
+0,
+0,
+0,
+2,
+0,
+0,
+6,
+0,
+0,
+0,
+2,
+-465,
+-462,
+-461,
+1,
+0,
+0,
+0,
+8,
+0,
+0,
+1,
+0,
+0,
+1,
+1,
+0,
+0,
+0,
+-458,
+-454,
+-452,
+-451,
+4,
+0,
+-446,
+2,
+0,
+1,
+3,
+9,
+1,
+-444,
+0,
+0,
+-442,
+11,
+0,
+0,
+1,
+-438,
+-436,
+0,
+1,
+2,
+5,
+5,
+0,
+0,
+-434,
+-433,
+2,
+3,
+0,
+0,
+0,
+0,
+-430,
+0,
+0,
+0,
+0,
+-427,
+-426,
+-424,
+0,
+-423,
+8,
+3,
+0,
+2,
+0,
+-421,
+11,
+0,
+6,
+0,
+0,
+-418,
+-413,
+0,
+-411,
+-410,
+6,
+1,
+14,
+10,
+0,
+-404,
+-403,
+0,
+5,
+0,
+1,
+0,
+3,
+-402,
+1,
+9,
+3,
+-401,
+-397,
+0,
+-396,
+-393,
+-391,
+11,
+0,
+3,
+0,
+21,
+0,
+-388,
+0,
+-387,
+9,
+7,
+-385,
+1,
+1,
+3,
+0,
+7,
+-379,
+-376,
+2,
+0,
+-374,
+2,
+-372,
+0,
+0,
+0,
+-369,
+-366,
+0,
+0,
+-356,
+0,
+-355,
+-353,
+0,
+2,
+0,
+-351,
+-350,
+0,
+-349,
+-346,
+-344,
+-342,
+0,
+-340,
+0,
+-338,
+-334,
+0,
+4,
+-329,
+-328,
+0,
+0,
+0,
+0,
+-327,
+-317,
+-316,
+-314,
+0,
+9,
+0,
+0,
+-311,
+0,
+0,
+-310,
+-305,
+0,
+0,
+1,
+0,
+1,
+-304,
+2,
+1,
+-302,
+3,
+-300,
+0,
+0,
+-299,
+0,
+-297,
+0,
+1,
+4,
+3,
+0,
+0,
+-296,
+0,
+0,
+2,
+1,
+-294,
+-292,
+12,
+9,
+-291,
+0,
+0,
+-290,
+6,
+-285,
+16,
+-282,
+0,
+0,
+0,
+0,
+0,
+8,
+-279,
+4,
+-269,
+1,
+5,
+0,
+0,
+0,
+6,
+-267,
+2,
+-262,
+-257,
+1,
+5,
+0,
+-255,
+-254,
+-252,
+-250,
+-244,
+-243,
+12,
+0,
+2,
+1,
+-241,
+25,
+2,
+-237,
+0,
+0,
+1,
+0,
+-235,
+11,
+0,
+0,
+0,
+-234,
+0,
+11,
+-232,
+-230,
+1,
+2,
+-226,
+-224,
+0,
+0,
+0,
+-223,
+0,
+4,
+2,
+0,
+0,
+1,
+-222,
+0,
+0,
+-221,
+1,
+0,
+0,
+1,
+2,
+0,
+-220,
+5,
+0,
+5,
+0,
+0,
+0,
+0,
+9,
+-219,
+3,
+-213,
+0,
+0,
+1,
+-211,
+1,
+-209,
+1,
+-207,
+-204,
+0,
+4,
+-198,
+0,
+2,
+6,
+0,
+-197,
+0,
+2,
+-195,
+4,
+11,
+0,
+-189,
+0,
+-186,
+0,
+0,
+2,
+-182,
+-177,
+-173,
+2,
+-166,
+0,
+-163,
+-162,
+-161,
+0,
+-155,
+0,
+-149,
+4,
+6,
+0,
+2,
+8,
+0,
+-147,
+0,
+-145,
+1,
+0,
+0,
+7,
+3,
+1,
+0,
+-144,
+-143,
+0,
+0,
+0,
+-138,
+2,
+-137,
+-136,
+-135,
+0,
+-133,
+1,
+-131,
+19,
+5,
+0,
+0,
+6,
+0,
+-130,
+0,
+-128,
+0,
+7,
+0,
+3,
+-126,
+0,
+7,
+0,
+0,
+-115,
+-112,
+-110,
+0,
+-107,
+0,
+-103,
+2,
+-101,
+0,
+-100,
+4,
+0,
+2,
+5,
+0,
+2,
+-96,
+0,
+-94,
+4,
+0,
+-93,
+0,
+-89,
+1,
+-86,
+4,
+0,
+-85,
+-84,
+-79,
+0,
+-78,
+-76,
+-75,
+-74,
+-73,
+-71,
+-68,
+0,
+2,
+0,
+3,
+0,
+0,
+0,
+0,
+14,
+-64,
+19,
+0,
+-58,
+4,
+1,
+10,
+0,
+7,
+-57,
+11,
+0,
+19,
+14,
+0,
+0,
+3,
+2,
+5,
+2,
+-42,
+-41,
+3,
+-40,
+24,
+0,
+-39,
+11,
+6,
+0,
+-38,
+-37,
+-36,
+0,
+0,
+-34,
+4,
+22,
+-31,
+0,
+0,
+17,
+3,
+1,
+-30,
+5,
+0,
+-29,
+0,
+1,
+-27,
+-25,
+-23,
+-21,
+-20,
+0,
+3,
+-19,
+1,
+-18,
+-13,
+0,
+2,
+-10,
+-9,
+-6,
+-4,
+0,
+9,
+0,
+-1,
+0
+};
+
+// Index in keyNameList of each hash slot.
+static const uint16_t keyNameHashSlot[] _FCITX_UNUSED_ =
+{
+1810,
+2115,
+253,
+1561,
+1004,
+186,
+1971,
+1036,
+1563,
+433,
+201,
+2227,
+2118,
+1081,
+336,
+205,
+2093,
+1546,
+2140,
+2190,
+2143,
+620,
+1616,
+825,
+1147,
+1912,
+1181,
+2095,
+969,
+518,
+1417,
+65,
+603,
+695,
+2239,
+742,
+611,
+114,
+49,
+1911,
+271,
+1557,
+1775,
+1378,
+1675,
+1683,
+45,
+1244,
+1159,
+999,
+980,
+1435,
+1250,
+1117,
+766,
+2246,
+366,
+1280,
+231,
+636,
+1725,
+507,
+1183,
+1670,
+529,
+1131,
+516,
+2229,
+1609,
+1606,
+210,
+2271,
+1584,
+1241,
+1267,
+113,
+471,
+667,
+421,
+1720,
+924,
+1002,
+466,
+2092,
+358,
+1246,
+722,
+966,
+1069,
+1248,
+635,
+2149,
+492,
+2038,
+1050,
+51,
+1358,
+1741,
+957,
+1275,
+1627,
+671,
+1625,
+995,
+986,
+1188,
+502,
+1910,
+616,
+533,
+1218,
+1316,
+1455,
+419,
+498,
+2058,
+28,
+1798,
+643,
+1550,
+1340,
+1847,
+327,
+1262,
+557,
+1215,
+1608,
+1086,
+923,
+1078,
+625,
+989,
+788,
+1552,
+1227,
+330,
+1045,
+269,
+262,
+1898,
+398,
+1955,
+1448,
+909,
+1200,
+476,
+2101,
+1756,
+78,
+1638,
+748,
+1388,
+1366,
+510,
+1071,
+73,
+426,
+1673,
+801,
+1397,
+501,
+915,
+1191,
+1883,
+610,
+1796,
+1564,
+761,
+1317,
+2068,
+132,
+1688,
+1942,
+450,
+1524,
+2003,
+37,
+780,
+1961,
+1554,
+1984,
+2057,
+682,
+2207,
+59,
+1386,
+182,
+1700,
+827,
+190,
+764,
+311,
+1705,
+2206,
+2010,
+1431,
+1057,
+887,
+1785,
+809,
+1307,
+565,
+319,
+1601,
+2079,
+218,
+1633,
+70,
+520,
+954,
+1704,
+2108,
+314,
+1187,
+1500,
+1843,
+1434,
+2100,
+1682,
+548,
+403,
+1249,
+1171,
+1192,
+1346,
+1995,
+964,
+499,
+1598,
+1224,
+2210,
+1357,
+1180,
+1764,
+279,
+141,
+1727,
+1804,
+2231,
+2117,
+1019,
+843,
+1349,
+591,
+1768,
+2044,
+206,
+1061,
+866,
+823,
+83,
+1303,
+178,
+1242,
+214,
+707,
+1499,
+342,
+1392,
+365,
+849,
+1167,
+1318,
+1264,
+604,
+442,
+1511,
+1887,
+972,
+793,
+854,
+646,
+1235,
+1373,
+615,
+1868,
+1586,
+1356,
+294,
+624,
+1419,
+694,
+1426,
+219,
+1464,
+1195,
+376,
+200,
+1874,
+974,
+702,
+1918,
+1427,
+568,
+1772,
+1402,
+1605,
+333,
+2125,
+841,
+1510,
+536,
+1504,
+2054,
+465,
+632,
+69,
+1909,
+1441,
+2082,
+1993,
+286,
+411,
+583,
+1238,
+2027,
+1390,
+1284,
+1120,
+1293,
+904,
+1893,
+1311,
+1347,
+1542,
+1996,
+447,
+781,
+2237,
+1894,
+1946,
+1037,
+2128,
+1824,
+2013,
+515,
+1271,
+369,
+1930,
+1424,
+232,
+361,
+1671,
+845,
+456,
+1115,
+296,
+660,
+1239,
+1927,
+2172,
+183,
+872,
+2026,
+1197,
+430,
+268,
+1332,
+1017,
+2016,
+1166,
+1926,
+1689,
+1603,
+1514,
+278,
+955,
+56,
+642,
+2056,
+576,
+109,
+732,
+1964,
+1662,
+810,
+1823,
+1384,
+160,
+129,
+237,
+1251,
+805,
+1576,
+2024,
+716,
+331,
+1679,
+1229,
+876,
+1013,
+1642,
+1658,
+2094,
+1644,
+1938,
+443,
+673,
+949,
+1398,
+1726,
+1974,
+1873,
+2052,
+792,
+1060,
+1430,
+1161,
+1575,
+558,
+33,
+2051,
+551,
+1767,
+1261,
+1943,
+858,
+29,
+651,
+762,
+1780,
+799,
+881,
+1612,
+168,
+896,
+1610,
+2144,
+1375,
+1450,
+874,
+778,
+209,
+1842,
+2077,
+826,
+868,
+136,
+1074,
+1032,
+1300,
+850,
+1743,
+181,
+323,
+461,
+1657,
+1981,
+1858,
+595,
+563,
+2179,
+2154,
+2261,
+295,
+2217,
+834,
+619,
+674,
+1072,
+1875,
+530,
+482,
+697,
+309,
+1428,
+1959,
+164,
+970,
+1042,
+2064,
+58,
+1915,
+417,
+94,
+157,
+587,
+1829,
+100,
+580,
+1963,
+402,
+1409,
+102,
+175,
+2019,
+1667,
+1814,
+1839,
+1163,
+968,
+2188,
+1452,
+544,
+489,
+669,
+816,
+131,
+1989,
+1394,
+1540,
+1865,
+509,
+1998,
+1322,
+596,
+629,
+1125,
+920,
+1928,
+1706,
+2185,
+1973,
+1436,
+2147,
+256,
+2156,
+693,
+1360,
+1535,
+500,
+1533,
+621,
+1065,
+280,
+739,
+1740,
+1006,
+1782,
+2065,
+895,
+470,
+684,
+1298,
+807,
+696,
+1292,
+819,
+553,
+2171,
+18,
+1818,
+1867,
+1277,
+1757,
+790,
+1895,
+1361,
+1854,
+734,
+1245,
+145,
+2017,
+235,
+1416,
+1885,
+1870,
+1106,
+1747,
+744,
+1620,
+149,
+592,
+284,
+1362,
+148,
+423,
+1556,
+1138,
+187,
+953,
+2194,
+513,
+353,
+1656,
+2028,
+1698,
+1528,
+508,
+135,
+1600,
+335,
+1282,
+273,
+1838,
+1139,
+677,
+2116,
+0,
+647,
+1742,
+340,
+440,
+339,
+1221,
+2060,
+1852,
+978,
+2103,
+910,
+523,
+1073,
+173,
+2180,
+228,
+455,
+1474,
+53,
+1952,
+718,
+2025,
+541,
+454,
+1478,
+1977,
+838,
+1929,
+321,
+708,
+1471,
+1314,
+1352,
+1806,
+1882,
+873,
+1553,
+1269,
+959,
+451,
+123,
+2023,
+1283,
+1010,
+146,
+829,
+1881,
+833,
+1579,
+1925,
+43,
+864,
+1425,
+1460,
+559,
+172,
+1641,
+310,
+1879,
+1026,
+422,
+1990,
+1640,
+1220,
+1364,
+918,
+2070,
+1370,
+1204,
+1737,
+1753,
+1031,
+933,
+987,
+1555,
+855,
+811,
+1975,
+1900,
+1184,
+23,
+1774,
+1080,
+62,
+1639,
+1134,
+2211,
+1752,
+911,
+1477,
+645,
+594,
+2181,
+2088,
+1136,
+2042,
+703,
+1709,
+2221,
+2177,
+337,
+723,
+255,
+1739,
+774,
+474,
+1393,
+690,
+92,
+119,
+570,
+307,
+1243,
+622,
+41,
+990,
+401,
+281,
+189,
+2119,
+2029,
+1363,
+1075,
+664,
+2031,
+1043,
+1807,
+1931,
+2091,
+1272,
+42,
+1128,
+1488,
+393,
+898,
+597,
+82,
+404,
+397,
+765,
+1711,
+1295,
+1228,
+891,
+1365,
+34,
+961,
+1872,
+554,
+1329,
+306,
+1070,
+124,
+900,
+79,
+1880,
+1813,
+399,
+134,
+2112,
+1099,
+1674,
+1461,
+612,
+1286,
+735,
+1988,
+985,
+922,
+2253,
+1665,
+2247,
+72,
+772,
+348,
+1708,
+1922,
+1052,
+623,
+601,
+118,
+921,
+1878,
+1536,
+914,
+241,
+1077,
+444,
+903,
+2225,
+1987,
+410,
+276,
+5,
+60,
+899,
+1888,
+2236,
+1162,
+1766,
+1405,
+2258,
+865,
+1151,
+462,
+128,
+712,
+299,
+130,
+1507,
+1305,
+1877,
+1432,
+1717,
+390,
+721,
+1786,
+1947,
+983,
+847,
+1811,
+1001,
+1391,
+1223,
+1024,
+50,
+1837,
+1157,
+1018,
+1326,
+1506,
+880,
+1703,
+763,
+1342,
+1672,
+717,
+61,
+1027,
+537,
+628,
+1237,
+791,
+1395,
+31,
+657,
+1054,
+346,
+1937,
+1179,
+1841,
+1056,
+1773,
+373,
+223,
+2030,
+2046,
+144,
+197,
+1469,
+2150,
+538,
+84,
+320,
+1258,
+649,
+120,
+1597,
+794,
+1702,
+686,
+2006,
+371,
+1901,
+158,
+93,
+1403,
+2037,
+2084,
+1713,
+225,
+1160,
+1475,
+1222,
+372,
+1541,
+1809,
+853,
+379,
+1124,
+2255,
+1143,
+1921,
+2192,
+2238,
+688,
+438,
+1076,
+577,
+185,
+1348,
+1992,
+1132,
+169,
+947,
+1185,
+731,
+1493,
+1659,
+965,
+1336,
+946,
+1549,
+698,
+549,
+2164,
+1444,
+1834,
+1684,
+1920,
+835,
+2219,
+1178,
+582,
+1560,
+747,
+1406,
+95,
+485,
+1538,
+350,
+984,
+1335,
+948,
+779,
+1724,
+363,
+2096,
+2134,
+733,
+493,
+251,
+1950,
+711,
+1615,
+469,
+1201,
+1440,
+2220,
+2131,
+517,
+1066,
+221,
+1980,
+161,
+877,
+176,
+2123,
+1646,
+345,
+2059,
+240,
+749,
+803,
+1897,
+545,
+547,
+806,
+139,
+894,
+1939,
+1374,
+786,
+301,
+1274,
+1028,
+1265,
+115,
+634,
+1084,
+675,
+2045,
+1590,
+1199,
+1082,
+137,
+428,
+2242,
+907,
+796,
+140,
+1498,
+1954,
+1808,
+851,
+154,
+1666,
+2087,
+1497,
+1291,
+2262,
+588,
+1105,
+121,
+1459,
+2203,
+875,
+2063,
+257,
+1205,
+2163,
+1817,
+1196,
+1784,
+1660,
+170,
+2158,
+282,
+929,
+658,
+1907,
+15,
+277,
+1655,
+1836,
+1848,
+2254,
+938,
+913,
+1949,
+1522,
+1494,
+110,
+88,
+66,
+1799,
+1840,
+1290,
+857,
+303,
+14,
+2230,
+2,
+2250,
+2218,
+1722,
+1924,
+654,
+2076,
+1396,
+247,
+1884,
+1055,
+869,
+1923,
+560,
+171,
+226,
+2053,
+1113,
+2173,
+2235,
+1972,
+1697,
+374,
+928,
+468,
+1710,
+1568,
+1458,
+1257,
+117,
+890,
+1935,
+246,
+1696,
+349,
+291,
+1122,
+2113,
+68,
+1618,
+407,
+383,
+112,
+2161,
+360,
+1917,
+133,
+1231,
+1482,
+1559,
+2139,
+125,
+432,
+639,
+2008,
+572,
+1421,
+1699,
+2252,
+1414,
+648,
+1876,
+2241,
+1512,
+252,
+771,
+503,
+1489,
+126,
+1007,
+292,
+1835,
+1778,
+1355,
+1219,
+1732,
+1279,
+2151,
+2081,
+16,
+2167,
+859,
+1573,
+152,
+1761,
+783,
+759,
+480,
+1338,
+901,
+2251,
+1152,
+2114,
+263,
+1089,
+418,
+820,
+1048,
+2222,
+1751,
+569,
+151,
+1182,
+1053,
+598,
+2039,
+1862,
+1085,
+2141,
+1407,
+2152,
+391,
+787,
+996,
+227,
+392,
+1035,
+932,
+57,
+162,
+424,
+289,
+202,
+1776,
+2186,
+1890,
+1745,
+1193,
+1387,
+434,
+1904,
+475,
+304,
+1849,
+395,
+1591,
+754,
+837,
+1822,
+575,
+32,
+1142,
+1812,
+2256,
+352,
+521,
+1718,
+1735,
+1276,
+1116,
+1787,
+2272,
+2155,
+1260,
+1408,
+1715,
+758,
+2106,
+260,
+882,
+590,
+429,
+567,
+889,
+930,
+2260,
+1189,
+614,
+2033,
+1628,
+737,
+2035,
+1400,
+156,
+1385,
+478,
+705,
+2183,
+47,
+2009,
+261,
+522,
+885,
+76,
+2174,
+1589,
+64,
+725,
+627,
+1914,
+1462,
+902,
+2160,
+504,
+1532,
+666,
+1312,
+925,
+617,
+1906,
+380,
+606,
+524,
+1869,
+1058,
+420,
+2199,
+1582,
+234,
+812,
+1323,
+726,
+1302,
+844,
+1130,
+1337,
+166,
+1892,
+861,
+300,
+1686,
+457,
+1315,
+77,
+1966,
+1899,
+441,
+1067,
+2004,
+1547,
+108,
+2205,
+709,
+356,
+942,
+1259,
+846,
+449,
+1439,
+325,
+2182,
+1211,
+1021,
+531,
+385,
+1423,
+437,
+1891,
+638,
+2104,
+1121,
+1828,
+728,
+1513,
+332,
+927,
+1486,
+1580,
+1401,
+1707,
+1306,
+207,
+1000,
+213,
+1137,
+613,
+2240,
+427,
+1094,
+842,
+1630,
+1678,
+473,
+1399,
+2268,
+1574,
+1095,
+981,
+564,
+2089,
+1569,
+751,
+1327,
+1412,
+550,
+2097,
+1651,
+1437,
+1247,
+571,
+1165,
+1827,
+1324,
+1146,
+839,
+2138,
+2136,
+1518,
+81,
+926,
+2259,
+1649,
+38,
+1470,
+1254,
+1831,
+2170,
+1225,
+935,
+802,
+2043,
+2196,
+1994,
+359,
+1803,
+414,
+800,
+1794,
+1164,
+2069,
+101,
+1023,
+2014,
+1217,
+35,
+2257,
+534,
+1572,
+2191,
+25,
+1296,
+1701,
+467,
+1543,
+142,
+1173,
+1285,
+1465,
+1527,
+1301,
+1449,
+1793,
+1916,
+1613,
+1669,
+1530,
+952,
+730,
+944,
+2078,
+4,
+867,
+1578,
+26,
+243,
+958,
+347,
+245,
+1090,
+1816,
+196,
+883,
+159,
+514,
+1046,
+1208,
+248,
+387,
+540,
+939,
+756,
+556,
+1520,
+1100,
+710,
+1693,
+1691,
+1481,
+1149,
+1681,
+259,
+1109,
+1103,
+1721,
+2148,
+1003,
+1623,
+1005,
+1025,
+1712,
+224,
+2080,
+405,
+1534,
+44,
+293,
+103,
+691,
+355,
+1629,
+326,
+2074,
+1664,
+767,
+2099,
+1333,
+288,
+2083,
+672,
+1544,
+743,
+1369,
+561,
+98,
+1310,
+483,
+2195,
+1566,
+1652,
+2005,
+1800,
+1777,
+30,
+1226,
+1833,
+1059,
+195,
+1491,
+1331,
+1009,
+19,
+322,
+1030,
+912,
+1433,
+2162,
+1472,
+798,
+351,
+1940,
+21,
+86,
+1140,
+1760,
+1982,
+266,
+856,
+1476,
+769,
+2178,
+906,
+1771,
+90,
+1372,
+2090,
+2197,
+2015,
+2198,
+1093,
+656,
+1334,
+1129,
+1866,
+341,
+1209,
+2036,
+1844,
+2248,
+659,
+96,
+585,
+138,
+1150,
+495,
+2110,
+552,
+511,
+1190,
+1539,
+1983,
+897,
+381,
+1466,
+1186,
+2270,
+1779,
+1252,
+795,
+689,
+1970,
+950,
+1153,
+971,
+2189,
+375,
+75,
+1958,
+519,
+290,
+1733,
+539,
+1750,
+630,
+230,
+641,
+1595,
+2032,
+527,
+824,
+602,
+828,
+600,
+1158,
+2120,
+1288,
+180,
+1102,
+574,
+1685,
+1577,
+532,
+1126,
+328,
+998,
+1273,
+1905,
+1144,
+993,
+394,
+298,
+1716,
+1936,
+1410,
+1451,
+97,
+1156,
+275,
+1256,
+1783,
+1029,
+1631,
+452,
+487,
+367,
+1068,
+789,
+1123,
+1087,
+1731,
+46,
+1297,
+24,
+1593,
+2232,
+1951,
+1558,
+775,
+204,
+1377,
+1480,
+1769,
+1729,
+1661,
+665,
+2135,
+1501,
+992,
+463,
+1463,
+1108,
+1728,
+936,
+1999,
+2165,
+916,
+188,
+1762,
+55,
+2018,
+1382,
+389,
+814,
+2124,
+1213,
+479,
+415,
+680,
+1321,
+1755,
+724,
+1198,
+715,
+283,
+287,
+934,
+1263,
+840,
+99,
+584,
+1770,
+12,
+1744,
+1177,
+2129,
+1594,
+7,
+3,
+2244,
+1860,
+1857,
+815,
+254,
+2121,
+2228,
+720,
+776,
+2012,
+870,
+1614,
+2209,
+436,
+408,
+818,
+1864,
+1049,
+512,
+2022,
+238,
+48,
+1526,
+1119,
+1908,
+1490,
+431,
+1389,
+941,
+785,
+943,
+413,
+1457,
+1723,
+1515,
+784,
+1176,
+2127,
+1230,
+893,
+1467,
+1548,
+1371,
+782,
+258,
+1850,
+67,
+1051,
+203,
+416,
+270,
+453,
+831,
+1111,
+945,
+1083,
+752,
+494,
+249,
+931,
+967,
+2130,
+2007,
+1621,
+1154,
+1690,
+908,
+1320,
+459,
+1830,
+2159,
+1886,
+738,
+852,
+991,
+741,
+1861,
+1654,
+1581,
+830,
+1611,
+1255,
+1404,
+685,
+439,
+448,
+116,
+344,
+607,
+1487,
+1636,
+357,
+1202,
+1913,
+1967,
+581,
+1525,
+1289,
+2265,
+860,
+1619,
+274,
+1011,
+150,
+312,
+308,
+491,
+409,
+1738,
+1853,
+285,
+2166,
+1856,
+976,
+297,
+177,
+618,
+1456,
+1174,
+354,
+1034,
+892,
+1588,
+755,
+1141,
+1957,
+1253,
+1038,
+215,
+1505,
+773,
+305,
+378,
+768,
+472,
+1411,
+1496,
+2234,
+1299,
+191,
+888,
+1617,
+871,
+727,
+963,
+20,
+1635,
+506,
+1758,
+1148,
+1596,
+147,
+1484,
+1734,
+746,
+1797,
+1789,
+1270,
+679,
+2226,
+599,
+302,
+1851,
+1420,
+1079,
+1626,
+22,
+1941,
+1788,
+1415,
+1624,
+1047,
+199,
+676,
+1985,
+1344,
+960,
+250,
+1339,
+2215,
+2266,
+1763,
+364,
+750,
+1714,
+1446,
+2040,
+236,
+1345,
+528,
+973,
+1531,
+586,
+670,
+10,
+1233,
+2145,
+1194,
+683,
+797,
+1570,
+198,
+1587,
+655,
+264,
+184,
+165,
+1801,
+2201,
+1422,
+13,
+1978,
+1313,
+2269,
+384,
+836,
+1234,
+1968,
+2169,
+1903,
+1266,
+317,
+1962,
+1637,
+464,
+163,
+633,
+2072,
+497,
+505,
+1863,
+2122,
+1033,
+1944,
+1096,
+2187,
+71,
+1815,
+1976,
+1997,
+217,
+105,
+377,
+1418,
+1592,
+1118,
+2212,
+80,
+1020,
+951,
+1960,
+609,
+324,
+1268,
+1765,
+1571,
+2085,
+1287,
+343,
+1919,
+1736,
+2055,
+650,
+220,
+2102,
+714,
+6,
+1039,
+1622,
+1650,
+2264,
+1172,
+740,
+9,
+681,
+2066,
+1328,
+608,
+1516,
+179,
+1791,
+1343,
+1668,
+1135,
+17,
+1632,
+1175,
+1107,
+1719,
+435,
+52,
+1236,
+2245,
+194,
+315,
+700,
+1565,
+1359,
+2263,
+1746,
+1826,
+39,
+729,
+543,
+1945,
+982,
+1353,
+2267,
+940,
+63,
+1309,
+2050,
+713,
+2214,
+1607,
+89,
+1445,
+193,
+2086,
+1214,
+1022,
+104,
+1062,
+1127,
+208,
+1634,
+2133,
+1502,
+425,
+1643,
+1647,
+1325,
+1091,
+1953,
+1979,
+668,
+1485,
+370,
+2021,
+1599,
+386,
+2000,
+362,
+2168,
+1145,
+736,
+486,
+704,
+318,
+496,
+216,
+2049,
+661,
+631,
+329,
+2126,
+2002,
+589,
+1519,
+878,
+1965,
+1210,
+1169,
+2233,
+653,
+2048,
+1969,
+1492,
+1367,
+1859,
+107,
+652,
+1350,
+566,
+388,
+222,
+1381,
+879,
+1330,
+338,
+1986,
+1521,
+562,
+1064,
+1889,
+988,
+1379,
+1278,
+1663,
+1687,
+484,
+640,
+2176,
+1112,
+886,
+905,
+1041,
+1207,
+1438,
+1376,
+1585,
+1240,
+1692,
+1012,
+706,
+2067,
+2109,
+2216,
+1473,
+244,
+917,
+804,
+2098,
+127,
+994,
+458,
+2200,
+701,
+956,
+153,
+1956,
+1676,
+1354,
+1781,
+1896,
+155,
+192,
+663,
+863,
+1092,
+699,
+1170,
+2142,
+122,
+1368,
+662,
+1846,
+1508,
+1820,
+2011,
+1341,
+2193,
+1749,
+1133,
+1216,
+2223,
+1821,
+382,
+1155,
+884,
+85,
+977,
+54,
+1583,
+1,
+2071,
+143,
+368,
+2243,
+1016,
+27,
+445,
+813,
+1453,
+757,
+1680,
+1351,
+1932,
+975,
+1447,
+265,
+91,
+1754,
+174,
+1008,
+1537,
+745,
+1442,
+1934,
+400,
+579,
+1694,
+334,
+11,
+1604,
+272,
+316,
+2213,
+1602,
+678,
+832,
+106,
+8,
+1790,
+87,
+267,
+1168,
+1855,
+937,
+1792,
+1759,
+1695,
+2204,
+1517,
+212,
+2047,
+1212,
+242,
+1933,
+2041,
+1104,
+2137,
+74,
+687,
+2075,
+1380,
+979,
+822,
+406,
+821,
+573,
+1454,
+578,
+313,
+460,
+1802,
+1991,
+2157,
+1495,
+2020,
+1503,
+760,
+233,
+490,
+1232,
+2061,
+1304,
+1098,
+2208,
+2034,
+1468,
+546,
+1645,
+1825,
+535,
+1545,
+817,
+1529,
+1308,
+2132,
+1114,
+919,
+1748,
+211,
+526,
+2146,
+1281,
+770,
+412,
+2107,
+1044,
+2153,
+808,
+1443,
+239,
+1383,
+862,
+626,
+1562,
+997,
+1677,
+525,
+396,
+1795,
+2001,
+2224,
+111,
+593,
+1294,
+1819,
+1567,
+1730,
+488,
+2202,
+1097,
+477,
+1871,
+1101,
+1653,
+1805,
+1832,
+692,
+962,
+2111,
+753,
+1523,
+1479,
+2105,
+1063,
+2249,
+2184,
+555,
+1110,
+1648,
+1319,
+36,
+1413,
+1040,
+777,
+1014,
+1015,
+644,
+40,
+167,
+1845,
+481,
+1088,
+2175,
+1483,
+1948,
+848,
+2073,
+542,
+637,
+1206,
+1429,
+1902,
+1509,
+1551,
+446,
+1203,
+229,
+719,
+605,
+2062
+};
+
+// Displacement of keyNameOffsetByValue hash buckets.
+static const int32_t keySymHashDisplacement[] _FCITX_UNUSED_ =
+{
+0,
+1,
+-2178,
+1,
+0,
+0,
+1,
+-2176,
+-2174,
+5,
+-2168,
+2,
+1,
+3,
+1,
+-2163,
+1,
+0,
+-2162,
+-2161,
+-2160,
+1,
+5,
+2,
+-2159,
+-2158,
+3,
+1,
+-2157,
+-2156,
+1,
+3,
+-2153,
+0,
+-2152,
+-2148,
+1,
+-2145,
+0,
+1,
+2,
+1,
+0,
+0,
+0,
+-2141,
+-2133,
+-2131,
+0,
+1,
+5,
+5,
+1,
+0,
+1,
+0,
+0,
+3,
+0,
+-2130,
+0,
+-2126,
+0,
+-2125,
+0,
+1,
+0,
+2,
+-2124,
+3,
+0,
+-2119,
+0,
+0,
+0,
+1,
+0,
+-2118,
+1,
+-2112,
+1,
+0,
+1,
+0,
+0,
+1,
+1,
+0,
+3,
+-2110,
+0,
+0,
+0,
+-2106,
+4,
+-2105,
+0,
+-2104,
+1,
+-2101,
+0,
+-2098,
+-2096,
+-2094,
+0,
+9,
+1,
+0,
+0,
+3,
+0,
+2,
+0,
+1,
+-2090,
+0,
+1,
+-2089,
+-2085,
+1,
+-2084,
+-2083,
+-2082,
+-2078,
+-2076,
+0,
+-2070,
+-2068,
+-2067,
+-2061,
+-2060,
+-2058,
+5,
+1,
+0,
+0,
+0,
+0,
+0,
+5,
+-2055,
+7,
+-2051,
+1,
+1,
+0,
+-2047,
+1,
+0,
+0,
+0,
+3,
+0,
+-2045,
+0,
+3,
+0,
+1,
+-2041,
+-2040,
+0,
+0,
+-2039,
+-2037,
+0,
+0,
+-2033,
+11,
+0,
+5,
+1,
+0,
+0,
+0,
+-2028,
+-2025,
+0,
+6,
+-2022,
+-2018,
+0,
+-2015,
+0,
+-2014,
+0,
+2,
+-2013,
+0,
+0,
+-2010,
+0,
+0,
+-2006,
+0,
+-2003,
+1,
+1,
+1,
+0,
+1,
+0,
+-2002,
+-1997,
+-1996,
+0,
+-1994,
+1,
+0,
+1,
+0,
+-1993,
+3,
+0,
+-1992,
+0,
+1,
+0,
+0,
+-1991,
+-1990,
+0,
+1,
+0,
+-1985,
+0,
+2,
+0,
+1,
+0,
+6,
+-1981,
+-1977,
+0,
+-1976,
+-1975,
+-1974,
+0,
+0,
+0,
+0,
+0,
+-1972,
+-1969,
+-1967,
+0,
+-1961,
+0,
+1,
+-1960,
+8,
+-1959,
+-1958,
+1,
+0,
+1,
+0,
+-1949,
+0,
+0,
+1,
+0,
+1,
+-1939,
+-1938,
+-1936,
+-1933,
+-1928,
+0,
+-1927,
+-1922,
+5,
+0,
+-1915,
+0,
+-1914,
+-1912,
+0,
+1,
+0,
+-1910,
+0,
+-1906,
+-1905,
+0,
+-1901,
+-1900,
+-1898,
+0,
+1,
+0,
+0,
+0,
+-1897,
+-1893,
+-1889,
+2,
+0,
+-1888,
+0,
+-1883,
+-1882,
+0,
+0,
+-1881,
+0,
+0,
+0,
+1,
+-1877,
+-1875,
+12,
+4,
+0,
+1,
+0,
+-1867,
+-1866,
+-1864,
+2,
+0,
+0,
+-1861,
+-1859,
+0,
+0,
+1,
+0,
+0,
+-1851,
+1,
+-1848,
+0,
+-1847,
+2,
+7,
+1,
+0,
+3,
+0,
+0,
+9,
+-1846,
+0,
+0,
+0,
+-1844,
+-1842,
+-1841,
+0,
+0,
+0,
+-1833,
+-1829,
+-1827,
+-1826,
+0,
+1,
+-1825,
+3,
+17,
+3,
+1,
+-1822,
+-1820,
+-1818,
+0,
+0,
+3,
+-1817,
+-1809,
+5,
+1,
+-1808,
+-1806,
+3,
+5,
+-1804,
+-1803,
+-1800,
+0,
+4,
+-1793,
+-1791,
+0,
+-1790,
+-1788,
+6,
+-1786,
+0,
+10,
+-1785,
+0,
+-1783,
+-1777,
+1,
+-1775,
+-1773,
+-1772,
+0,
+-1771,
+0,
+-1765,
+0,
+0,
+0,
+10,
+-1764,
+0,
+0,
+3,
+1,
+-1761,
+0,
+-1756,
+1,
+-1754,
+-1752,
+1,
+0,
+0,
+1,
+-1750,
+4,
+0,
+-1748,
+1,
+7,
+12,
+0,
+0,
+0,
+-1745,
+-1744,
+1,
+0,
+-1742,
+0,
+-1741,
+-1739,
+18,
+0,
+0,
+1,
+-1738,
+-1735,
+-1734,
+0,
+-1730,
+0,
+-1726,
+-1724,
+-1722,
+3,
+1,
+3,
+0,
+2,
+-1716,
+1,
+0,
+-1714,
+0,
+-1711,
+-1708,
+0,
+-1702,
+5,
+-1701,
+-1698,
+-1693,
+-1692,
+0,
+-1691,
+4,
+-1689,
+-1685,
+7,
+-1684,
+1,
+0,
+-1683,
+-1682,
+-1681,
+0,
+0,
+1,
+2,
+-1679,
+0,
+-1678,
+-1677,
+7,
+3,
+0,
+0,
+-1675,
+1,
+0,
+0,
+0,
+0,
+1,
+-1674,
+-1673,
+0,
+-1671,
+6,
+1,
+-1669,
+0,
+0,
+0,
+1,
+0,
+-1666,
+-1665,
+0,
+1,
+11,
+7,
+0,
+0,
+-1664,
+1,
+-1662,
+-1658,
+1,
+4,
+-1657,
+1,
+1,
+-1653,
+-1652,
+0,
+-1650,
+-1648,
+0,
+0,
+-1646,
+9,
+0,
+0,
+-1645,
+0,
+-1644,
+-1637,
+1,
+0,
+0,
+2,
+0,
+-1636,
+-1635,
+-1634,
+7,
+-1632,
+-1628,
+0,
+5,
+3,
+1,
+0,
+0,
+-1627,
+5,
+-1625,
+-1624,
+0,
+-1622,
+-1620,
+1,
+-1618,
+-1617,
+0,
+0,
+0,
+1,
+-1613,
+1,
+0,
+-1611,
+1,
+-1607,
+5,
+-1606,
+-1605,
+0,
+-1602,
+-1601,
+-1599,
+0,
+0,
+-1596,
+-1594,
+0,
+-1593,
+-1590,
+-1589,
+-1588,
+2,
+-1578,
+0,
+0,
+-1577,
+0,
+-1573,
+-1572,
+0,
+-1568,
+1,
+-1566,
+-1562,
+0,
+0,
+-1560,
+-1558,
+-1555,
+0,
+4,
+0,
+-1552,
+1,
+-1546,
+-1545,
+0,
+-1542,
+0,
+0,
+0,
+2,
+0,
+0,
+-1541,
+-1540,
+-1537,
+0,
+-1536,
+-1532,
+-1530,
+-1529,
+-1528,
+0,
+4,
+0,
+7,
+1,
+-1525,
+-1524,
+-1522,
+-1521,
+0,
+11,
+-1520,
+0,
+0,
+0,
+-1519,
+-1518,
+-1517,
+0,
+0,
+5,
+0,
+3,
+0,
+0,
+0,
+0,
+-1515,
+-1510,
+1,
+0,
+0,
+1,
+2,
+-1507,
+-1506,
+-1502,
+-1501,
+2,
+0,
+-1498,
+0,
+-1496,
+0,
+2,
+-1491,
+-1481,
+0,
+0,
+0,
+10,
+-1480,
+1,
+-1476,
+-1473,
+4,
+-1472,
+0,
+0,
+-1471,
+-1468,
+0,
+1,
+0,
+-1466,
+0,
+11,
+-1464,
+-1461,
+-1460,
+1,
+-1458,
+-1456,
+-1453,
+-1451,
+0,
+-1450,
+0,
+-1446,
+0,
+-1439,
+0,
+0,
+-1438,
+1,
+16,
+-1434,
+-1430,
+0,
+-1428,
+0,
+-1426,
+3,
+5,
+-1424,
+-1421,
+13,
+18,
+-1419,
+0,
+-1418,
+1,
+0,
+0,
+0,
+7,
+0,
+-1417,
+-1415,
+-1409,
+0,
+-1404,
+6,
+0,
+13,
+-1403,
+-1401,
+2,
+-1399,
+-1397,
+-1392,
+5,
+-1390,
+0,
+1,
+0,
+4,
+-1387,
+-1386,
+-1384,
+2,
+-1382,
+8,
+0,
+0,
+0,
+1,
+-1379,
+-1377,
+-1375,
+0,
+-1374,
+-1372,
+0,
+-1369,
+0,
+2,
+9,
+-1367,
+-1362,
+0,
+0,
+-1361,
+11,
+2,
+-1358,
+0,
+-1354,
+-1353,
+-1351,
+-1348,
+8,
+2,
+0,
+0,
+0,
+0,
+0,
+-1346,
+0,
+-1344,
+0,
+-1342,
+-1341,
+0,
+0,
+4,
+3,
+-1336,
+0,
+0,
+6,
+0,
+-1335,
+-1334,
+1,
+1,
+-1333,
+-1329,
+-1328,
+0,
+-1326,
+34,
+1,
+0,
+1,
+0,
+0,
+1,
+-1325,
+0,
+-1324,
+-1323,
+-1317,
+-1312,
+14,
+4,
+-1311,
+-1310,
+1,
+0,
+2,
+8,
+-1306,
+-1305,
+0,
+-1304,
+0,
+1,
+0,
+-1303,
+0,
+-1298,
+-1297,
+-1294,
+1,
+-1292,
+-1289,
+0,
+0,
+0,
+0,
+13,
+-1287,
+-1284,
+-1283,
+-1282,
+0,
+1,
+-1278,
+0,
+1,
+0,
+-1276,
+0,
+9,
+-1274,
+0,
+2,
+-1269,
+0,
+-1262,
+7,
+-1261,
+-1260,
+0,
+-1259,
+-1257,
+0,
+-1256,
+0,
+0,
+0,
+0,
+-1249,
+-1247,
+0,
+0,
+-1241,
+-1239,
+-1237,
+-1233,
+2,
+-1231,
+0,
+-1229,
+-1226,
+1,
+-1219,
+6,
+0,
+1,
+0,
+0,
+-1217,
+-1215,
+0,
+-1211,
+-1210,
+6,
+-1208,
+0,
+0,
+1,
+-1207,
+-1197,
+0,
+-1195,
+6,
+0,
+-1192,
+-1188,
+-1182,
+1,
+-1181,
+1,
+8,
+0,
+0,
+1,
+-1180,
+0,
+-1177,
+-1175,
+0,
+-1170,
+2,
+4,
+-1169,
+0,
+-1168,
+0,
+-1167,
+-1165,
+1,
+11,
+0,
+2,
+6,
+-1164,
+0,
+-1160,
+-1157,
+21,
+-1155,
+0,
+-1154,
+-1153,
+-1150,
+-1149,
+2,
+0,
+-1148,
+3,
+-1147,
+-1144,
+0,
+0,
+0,
+5,
+0,
+0,
+0,
+-1139,
+0,
+7,
+0,
+0,
+0,
+0,
+0,
+-1137,
+0,
+2,
+-1136,
+6,
+0,
+39,
+0,
+0,
+1,
+0,
+0,
+22,
+-1134,
+1,
+4,
+19,
+0,
+-1133,
+0,
+4,
+0,
+0,
+0,
+-1130,
+-1129,
+-1124,
+-1123,
+-1117,
+0,
+-1114,
+-1110,
+-1108,
+0,
+1,
+-1106,
+-1105,
+4,
+0,
+0,
+20,
+-1094,
+0,
+24,
+0,
+3,
+-1093,
+1,
+0,
+2,
+0,
+-1091,
+0,
+0,
+0,
+0,
+0,
+-1090,
+2,
+-1085,
+-1084,
+-1081,
+1,
+-1080,
+0,
+0,
+6,
+-1077,
+2,
+0,
+-1072,
+1,
+-1065,
+-1064,
+0,
+6,
+1,
+0,
+0,
+-1063,
+-1060,
+0,
+-1059,
+-1058,
+14,
+0,
+-1057,
+0,
+0,
+-1056,
+0,
+0,
+0,
+-1055,
+-1054,
+-1053,
+-1051,
+-1047,
+-1044,
+0,
+-1042,
+-1041,
+-1039,
+0,
+20,
+0,
+0,
+0,
+1,
+-1038,
+0,
+0,
+6,
+-1036,
+0,
+1,
+-1035,
+0,
+-1032,
+-1031,
+0,
+-1028,
+-1026,
+-1025,
+1,
+-1024,
+-1020,
+-1013,
+0,
+18,
+0,
+-1011,
+7,
+0,
+0,
+1,
+0,
+-1010,
+-1009,
+-1008,
+0,
+0,
+-1006,
+11,
+0,
+0,
+0,
+0,
+-1002,
+1,
+-1001,
+-1000,
+-999,
+-998,
+0,
+-996,
+31,
+0,
+-994,
+-993,
+-992,
+-989,
+0,
+-988,
+-986,
+-983,
+0,
+0,
+9,
+-976,
+-972,
+-971,
+-968,
+-965,
+-964,
+-963,
+-961,
+0,
+0,
+0,
+-960,
+-956,
+-953,
+-950,
+7,
+-949,
+-947,
+12,
+27,
+0,
+-943,
+13,
+-941,
+2,
+0,
+-939,
+22,
+-934,
+1,
+-932,
+-928,
+0,
+-925,
+-924,
+0,
+-922,
+3,
+0,
+0,
+-918,
+-916,
+0,
+0,
+1,
+-909,
+4,
+-908,
+-906,
+16,
+-905,
+-903,
+-902,
+8,
+0,
+-900,
+9,
+0,
+70,
+0,
+23,
+0,
+5,
+-897,
+-892,
+0,
+-889,
+0,
+1,
+0,
+-886,
+9,
+18,
+-884,
+-882,
+0,
+-879,
+0,
+-871,
+-870,
+-864,
+0,
+20,
+15,
+0,
+-863,
+3,
+-859,
+0,
+0,
+0,
+4,
+0,
+-857,
+0,
+-845,
+-839,
+-838,
+1,
+6,
+-836,
+1,
+0,
+-832,
+0,
+0,
+0,
+2,
+-826,
+2,
+0,
+0,
+-824,
+-822,
+1,
+0,
+6,
+0,
+-821,
+1,
+0,
+-820,
+0,
+2,
+0,
+1,
+0,
+45,
+0,
+0,
+16,
+0,
+-816,
+0,
+-813,
+-812,
+5,
+-811,
+0,
+-808,
+0,
+0,
+-807,
+0,
+5,
+0,
+-806,
+-805,
+5,
+0,
+-800,
+-799,
+0,
+0,
+0,
+45,
+-797,
+0,
+50,
+-793,
+-782,
+0,
+-777,
+0,
+0,
+-776,
+1,
+-775,
+2,
+0,
+5,
+-774,
+0,
+-773,
+-772,
+-767,
+0,
+6,
+9,
+0,
+-765,
+0,
+-756,
+5,
+-755,
+-753,
+0,
+-752,
+0,
+-748,
+0,
+1,
+0,
+-746,
+-745,
+0,
+-744,
+0,
+-742,
+-741,
+0,
+2,
+0,
+0,
+1,
+-737,
+8,
+0,
+9,
+-736,
+0,
+38,
+0,
+-732,
+-730,
+0,
+2,
+0,
+-724,
+-720,
+-719,
+1,
+0,
+-718,
+-717,
+0,
+-714,
+0,
+0,
+0,
+5,
+0,
+0,
+8,
+1,
+-710,
+1,
+0,
+-709,
+3,
+-705,
+-703,
+9,
+0,
+-701,
+0,
+0,
+-700,
+21,
+0,
+0,
+-699,
+0,
+-693,
+0,
+5,
+0,
+3,
+-691,
+-690,
+-689,
+-688,
+0,
+-685,
+-683,
+15,
+0,
+0,
+-681,
+-673,
+-668,
+-667,
+8,
+0,
+0,
+2,
+-663,
+1,
+0,
+0,
+0,
+-661,
+13,
+-660,
+0,
+-656,
+0,
+-655,
+-654,
+0,
+0,
+1,
+0,
+8,
+0,
+-651,
+0,
+13,
+6,
+-644,
+0,
+0,
+0,
+-641,
+0,
+-636,
+9,
+-632,
+0,
+0,
+0,
+9,
+-631,
+0,
+0,
+5,
+3,
+11,
+2,
+0,
+20,
+-629,
+1,
+60,
+-628,
+3,
+0,
+2,
+11,
+0,
+0,
+0,
+-627,
+-625,
+-617,
+0,
+6,
+-616,
+0,
+-613,
+1,
+12,
+0,
+0,
+-605,
+9,
+0,
+0,
+-603,
+0,
+-595,
+-589,
+0,
+-588,
+-587,
+5,
+0,
+9,
+0,
+17,
+0,
+-585,
+-580,
+1,
+0,
+0,
+-576,
+5,
+0,
+0,
+-575,
+-574,
+-569,
+0,
+0,
+1,
+-568,
+-563,
+-562,
+2,
+0,
+-560,
+-558,
+0,
+-557,
+21,
+0,
+-556,
+0,
+1,
+-551,
+-549,
+1,
+-544,
+0,
+-542,
+0,
+6,
+0,
+-541,
+0,
+0,
+-537,
+-534,
+4,
+0,
+-525,
+0,
+6,
+-522,
+0,
+-521,
+-518,
+-517,
+-516,
+4,
+0,
+0,
+0,
+-512,
+0,
+0,
+0,
+-510,
+-509,
+10,
+20,
+-505,
+-503,
+-501,
+0,
+25,
+1,
+0,
+-500,
+0,
+-499,
+0,
+-498,
+0,
+5,
+7,
+1,
+-496,
+0,
+0,
+0,
+-495,
+0,
+-494,
+0,
+9,
+1,
+0,
+1,
+-491,
+0,
+-484,
+0,
+55,
+0,
+-483,
+0,
+-481,
+-480,
+1,
+-478,
+24,
+22,
+2,
+4,
+-475,
+0,
+0,
+0,
+-470,
+0,
+1,
+0,
+1,
+0,
+0,
+0,
+-469,
+14,
+-465,
+0,
+-461,
+34,
+-460,
+0,
+-456,
+0,
+0,
+0,
+8,
+-449,
+0,
+-447,
+0,
+9,
+-442,
+0,
+0,
+-441,
+0,
+-439,
+-437,
+19,
+-436,
+0,
+0,
+0,
+0,
+-435,
+-431,
+-430,
+0,
+10,
+-429,
+0,
+0,
+-425,
+-424,
+18,
+46,
+0,
+-420,
+-419,
+-413,
+0,
+22,
+2,
+-412,
+4,
+21,
+0,
+-408,
+10,
+0,
+-404,
+-403,
+0,
+-401,
+-400,
+-396,
+-394,
+31,
+75,
+2,
+0,
+1,
+-389,
+22,
+0,
+-384,
+-383,
+72,
+0,
+5,
+0,
+40,
+0,
+0,
+18,
+13,
+0,
+0,
+-380,
+-377,
+0,
+25,
+-373,
+0,
+-371,
+-367,
+0,
+0,
+-366,
+9,
+0,
+-358,
+0,
+-356,
+0,
+-351,
+-350,
+-349,
+-344,
+0,
+0,
+25,
+3,
+0,
+3,
+52,
+1,
+-343,
+-340,
+0,
+0,
+0,
+-339,
+0,
+49,
+0,
+6,
+4,
+13,
+9,
+-337,
+0,
+0,
+12,
+0,
+0,
+0,
+9,
+0,
+0,
+15,
+-333,
+-332,
+-331,
+22,
+8,
+3,
+1,
+0,
+0,
+-328,
+0,
+0,
+100,
+0,
+1,
+0,
+-327,
+12,
+2,
+1,
+0,
+5,
+12,
+-325,
+-321,
+0,
+61,
+0,
+-315,
+-313,
+1,
+0,
+-310,
+-307,
+0,
+54,
+0,
+-306,
+0,
+34,
+0,
+-305,
+-303,
+-302,
+-299,
+33,
+34,
+0,
+0,
+0,
+-297,
+0,
+33,
+0,
+0,
+0,
+-295,
+1,
+0,
+1,
+-291,
+-288,
+-287,
+23,
+0,
+6,
+-286,
+1,
+27,
+21,
+8,
+0,
+-285,
+-284,
+0,
+-279,
+-277,
+1,
+-274,
+-266,
+144,
+-264,
+0,
+1,
+0,
+-263,
+-261,
+0,
+-259,
+0,
+0,
+-258,
+-257,
+0,
+46,
+0,
+-256,
+1,
+81,
+-252,
+0,
+-251,
+28,
+-247,
+-246,
+-245,
+2,
+0,
+0,
+0,
+-241,
+0,
+0,
+0,
+-240,
+-238,
+3,
+0,
+-237,
+0,
+40,
+0,
+-233,
+-229,
+0,
+3,
+9,
+-227,
+-225,
+0,
+17,
+34,
+-223,
+0,
+0,
+0,
+-221,
+1,
+2,
+1,
+0,
+1,
+1,
+0,
+41,
+0,
+0,
+-218,
+0,
+0,
+-217,
+23,
+15,
+0,
+-215,
+33,
+-213,
+-210,
+-207,
+2,
+-205,
+36,
+2,
+-201,
+16,
+0,
+0,
+0,
+0,
+1,
+19,
+2,
+-199,
+0,
+-195,
+60,
+0,
+-194,
+19,
+-192,
+9,
+-191,
+-189,
+0,
+-188,
+-187,
+0,
+-185,
+-182,
+34,
+-181,
+-179,
+-177,
+0,
+1,
+-174,
+-173,
+0,
+0,
+0,
+0,
+0,
+-172,
+-169,
+0,
+-165,
+7,
+-164,
+2,
+0,
+0,
+-163,
+3,
+0,
+-162,
+-161,
+-157,
+-155,
+4,
+33,
+0,
+-153,
+0,
+-151,
+83,
+0,
+-150,
+-149,
+-146,
+-139,
+51,
+-137,
+0,
+-136,
+58,
+0,
+7,
+0,
+86,
+23,
+0,
+0,
+22,
+65,
+0,
+18,
+-135,
+0,
+-128,
+1,
+0,
+-121,
+0,
+43,
+-116,
+-113,
+0,
+13,
+0,
+1,
+0,
+24,
+0,
+-111,
+2,
+0,
+3,
+0,
+-108,
+-105,
+109,
+29,
+-104,
+57,
+0,
+0,
+15,
+-102,
+-101,
+136,
+19,
+-100,
+1,
+-98,
+87,
+0,
+1,
+39,
+4,
+0,
+0,
+0,
+-97,
+7,
+-96,
+2,
+0,
+-95,
+81,
+31,
+-93,
+-91,
+14,
+0,
+37,
+0,
+19,
+72,
+-88,
+16,
+33,
+0,
+1,
+0,
+0,
+10,
+51,
+0,
+-84,
+0,
+-82,
+1,
+0,
+-77,
+-75,
+-74,
+0,
+0,
+2,
+4,
+120,
+-73,
+-71,
+-67,
+4,
+-63,
+0,
+-61,
+0,
+-60,
+0,
+-59,
+-57,
+2,
+41,
+-54,
+-49,
+-47,
+-46,
+-45,
+-44,
+1,
+0,
+-43,
+-39,
+-34,
+49,
+0,
+-29,
+-19,
+0,
+-11,
+64,
+2,
+-9,
+0,
+0,
+0,
+-6,
+0,
+0,
+138,
+80,
+-5,
+3,
+0,
+-3,
+68,
+25,
+0,
+142,
+0,
+105,
+0,
+0,
+-1
+};
+
+// Index in keyNameOffsetByValue of each hash slot.
+static const uint16_t keySymHashSlot[] _FCITX_UNUSED_ =
+{
+1954,
+1166,
+1831,
+1869,
+1672,
+313,
+706,
+787,
+878,
+1778,
+1278,
+992,
+189,
+1490,
+441,
+227,
+1240,
+757,
+735,
+1516,
+1287,
+92,
+1335,
+1582,
+406,
+1350,
+528,
+580,
+702,
+23,
+348,
+195,
+1113,
+1610,
+903,
+761,
+473,
+2070,
+1257,
+1149,
+1472,
+962,
+1850,
+1178,
+1083,
+743,
+383,
+1496,
+843,
+79,
+237,
+993,
+1814,
+2115,
+1839,
+1324,
+1683,
+1637,
+1508,
+1173,
+318,
+1259,
+35,
+344,
+691,
+1859,
+499,
+1755,
+1551,
+772,
+1132,
+898,
+1766,
+203,
+355,
+1029,
+1021,
+1476,
+1565,
+220,
+672,
+1206,
+1676,
+1855,
+1091,
+1665,
+1945,
+1574,
+1846,
+1356,
+1737,
+1586,
+1488,
+933,
+1758,
+912,
+2015,
+385,
+1549,
+233,
+1378,
+877,
+685,
+894,
+1620,
+1473,
+510,
+1283,
+494,
+442,
+2145,
+1499,
+2113,
+1291,
+1327,
+856,
+395,
+1353,
+518,
+1577,
+1385,
+16,
+193,
+2099,
+1638,
+1137,
+483,
+1352,
+464,
+504,
+2008,
+470,
+1147,
+1437,
+1095,
+1752,
+1976,
+966,
+1614,
+680,
+1657,
+2075,
+222,
+326,
+1938,
+2123,
+1823,
+1556,
+1207,
+1871,
+1402,
+807,
+1571,
+1648,
+234,
+529,
+1691,
+1962,
+211,
+260,
+73,
+1364,
+1123,
+911,
+2089,
+1092,
+1042,
+958,
+615,
+1513,
+1117,
+928,
+204,
+17,
+535,
+570,
+2020,
+1175,
+2160,
+1568,
+850,
+1599,
+1315,
+1628,
+2031,
+815,
+893,
+755,
+1200,
+2059,
+328,
+266,
+597,
+1804,
+732,
+1039,
+998,
+1550,
+705,
+1262,
+410,
+426,
+1567,
+1486,
+1969,
+60,
+1611,
+247,
+379,
+2102,
+530,
+555,
+1032,
+2069,
+386,
+814,
+1524,
+433,
+1539,
+1336,
+1328,
+1852,
+2157,
+471,
+2028,
+765,
+842,
+673,
+89,
+1797,
+1413,
+1308,
+1380,
+42,
+2067,
+334,
+1689,
+927,
+2058,
+169,
+944,
+93,
+246,
+238,
+213,
+1877,
+1236,
+2082,
+1733,
+817,
+1668,
+412,
+1046,
+1726,
+955,
+1212,
+1152,
+2083,
+1303,
+936,
+1525,
+116,
+1141,
+621,
+1897,
+453,
+1909,
+548,
+2078,
+74,
+1292,
+223,
+375,
+149,
+1219,
+1554,
+2116,
+1937,
+1994,
+1813,
+1603,
+1618,
+262,
+1286,
+1773,
+1267,
+1955,
+239,
+953,
+137,
+2173,
+1740,
+500,
+1811,
+2044,
+1307,
+163,
+72,
+1082,
+2035,
+1920,
+1723,
+2054,
+2154,
+208,
+2136,
+1652,
+864,
+1270,
+1460,
+450,
+1606,
+1553,
+1838,
+557,
+1213,
+1542,
+915,
+1781,
+351,
+1572,
+619,
+1393,
+1500,
+943,
+1422,
+1314,
+1107,
+756,
+892,
+1421,
+1583,
+874,
+416,
+1163,
+1915,
+310,
+522,
+2095,
+197,
+2120,
+797,
+214,
+1383,
+1482,
+182,
+941,
+361,
+109,
+435,
+970,
+906,
+255,
+101,
+1661,
+430,
+1880,
+367,
+1557,
+546,
+1209,
+94,
+245,
+1016,
+1926,
+1339,
+728,
+1221,
+1001,
+1912,
+620,
+1589,
+1455,
+1362,
+1873,
+1332,
+1887,
+1829,
+346,
+1632,
+949,
+1548,
+377,
+1613,
+488,
+1795,
+1392,
+1495,
+959,
+97,
+219,
+990,
+983,
+1906,
+581,
+1184,
+1717,
+86,
+243,
+1133,
+159,
+272,
+803,
+1634,
+1722,
+480,
+2130,
+1643,
+1533,
+176,
+1768,
+1995,
+890,
+2032,
+768,
+1494,
+899,
+105,
+391,
+1026,
+1027,
+902,
+1902,
+103,
+541,
+1699,
+31,
+1167,
+663,
+485,
+181,
+1234,
+989,
+1900,
+507,
+1645,
+795,
+183,
+209,
+343,
+567,
+1320,
+1250,
+910,
+250,
+1526,
+1674,
+2104,
+1394,
+1008,
+604,
+659,
+1660,
+1080,
+221,
+446,
+2041,
+1415,
+1115,
+872,
+2013,
+749,
+802,
+2060,
+307,
+1607,
+1440,
+724,
+696,
+1009,
+973,
+1561,
+932,
+1527,
+1881,
+1122,
+1233,
+1585,
+595,
+393,
+1281,
+107,
+683,
+337,
+605,
+1397,
+565,
+1256,
+1469,
+413,
+496,
+224,
+2108,
+688,
+514,
+789,
+808,
+1942,
+402,
+2156,
+1220,
+1453,
+1836,
+352,
+677,
+1754,
+1367,
+1530,
+501,
+2133,
+1086,
+914,
+2002,
+1156,
+599,
+1319,
+1905,
+583,
+15,
+863,
+1106,
+640,
+1636,
+1687,
+1129,
+1903,
+2169,
+1579,
+1193,
+1348,
+1867,
+741,
+1264,
+46,
+342,
+1601,
+1070,
+1545,
+1650,
+1111,
+1669,
+1372,
+593,
+323,
+392,
+122,
+419,
+1744,
+711,
+305,
+628,
+1649,
+753,
+2148,
+1323,
+161,
+1359,
+2049,
+1154,
+1703,
+811,
+206,
+553,
+1311,
+916,
+187,
+475,
+25,
+404,
+1235,
+1368,
+329,
+251,
+1625,
+1282,
+1195,
+585,
+1382,
+1666,
+1540,
+1258,
+62,
+225,
+216,
+2027,
+2096,
+1000,
+2018,
+805,
+1913,
+1747,
+1093,
+1593,
+147,
+1040,
+684,
+1127,
+1864,
+2177,
+316,
+1782,
+1429,
+302,
+1162,
+1715,
+445,
+609,
+1306,
+2040,
+123,
+1215,
+869,
+40,
+1459,
+1581,
+1077,
+487,
+847,
+1242,
+2140,
+282,
+280,
+1851,
+921,
+784,
+1276,
+1155,
+371,
+1921,
+1728,
+19,
+2076,
+1964,
+730,
+1918,
+835,
+373,
+111,
+0,
+2064,
+99,
+1389,
+1559,
+726,
+1139,
+2001,
+229,
+1967,
+520,
+1684,
+177,
+1160,
+800,
+794,
+1150,
+562,
+2077,
+129,
+459,
+76,
+638,
+1874,
+879,
+1444,
+2176,
+167,
+896,
+1826,
+1981,
+1366,
+538,
+306,
+770,
+394,
+12,
+820,
+1698,
+1136,
+1048,
+1344,
+270,
+1895,
+1066,
+1576,
+707,
+527,
+777,
+1265,
+461,
+1927,
+788,
+709,
+650,
+184,
+1800,
+357,
+1298,
+439,
+1014,
+56,
+979,
+119,
+679,
+839,
+1592,
+568,
+1619,
+1655,
+427,
+946,
+230,
+1239,
+277,
+2004,
+2087,
+918,
+647,
+1907,
+299,
+78,
+267,
+175,
+1448,
+2019,
+1952,
+719,
+1960,
+736,
+421,
+1431,
+70,
+848,
+1997,
+1400,
+1420,
+1189,
+1226,
+1988,
+8,
+1951,
+472,
+1211,
+1930,
+810,
+1151,
+578,
+2048,
+652,
+469,
+141,
+786,
+1977,
+317,
+1423,
+895,
+1031,
+1794,
+179,
+1809,
+1056,
+1168,
+675,
+589,
+1847,
+1854,
+378,
+1289,
+837,
+1296,
+301,
+1560,
+253,
+734,
+723,
+1815,
+1931,
+1990,
+1466,
+766,
+703,
+2110,
+635,
+1273,
+694,
+957,
+71,
+1203,
+338,
+630,
+1020,
+1966,
+1302,
+654,
+1228,
+2033,
+681,
+559,
+536,
+2022,
+1481,
+408,
+1982,
+14,
+1883,
+117,
+443,
+699,
+1120,
+1720,
+1935,
+2036,
+1061,
+1451,
+133,
+1770,
+796,
+1179,
+2074,
+1522,
+319,
+1131,
+984,
+498,
+1227,
+1986,
+1177,
+649,
+1791,
+2100,
+823,
+51,
+1817,
+2050,
+1398,
+576,
+1678,
+2135,
+382,
+1727,
+1564,
+1316,
+276,
+775,
+2165,
+1993,
+1439,
+1130,
+924,
+1779,
+171,
+1098,
+256,
+2092,
+1171,
+1375,
+1511,
+333,
+1224,
+432,
+2107,
+296,
+1807,
+1143,
+773,
+865,
+1452,
+2091,
+526,
+1252,
+738,
+463,
+715,
+1293,
+2097,
+1426,
+1005,
+947,
+2170,
+493,
+1085,
+1064,
+919,
+629,
+994,
+1109,
+1878,
+2153,
+660,
+1104,
+2052,
+1615,
+575,
+397,
+2167,
+862,
+1985,
+88,
+1410,
+1882,
+38,
+2079,
+603,
+2062,
+1701,
+714,
+1096,
+1761,
+1853,
+1841,
+1194,
+423,
+701,
+1780,
+1734,
+49,
+1204,
+324,
+812,
+1371,
+1786,
+1288,
+1351,
+828,
+641,
+831,
+1387,
+554,
+1987,
+1465,
+411,
+29,
+1246,
+1140,
+977,
+2073,
+1705,
+1089,
+1433,
+1183,
+905,
+657,
+142,
+1484,
+1216,
+1501,
+2084,
+466,
+315,
+767,
+1052,
+67,
+1943,
+1639,
+292,
+1191,
+2081,
+826,
+1450,
+6,
+1833,
+1435,
+1612,
+2000,
+398,
+643,
+1118,
+2119,
+748,
+1810,
+128,
+1363,
+2056,
+1598,
+512,
+1504,
+1948,
+669,
+87,
+63,
+2142,
+1300,
+1520,
+1201,
+1789,
+381,
+448,
+834,
+1491,
+1144,
+1391,
+1914,
+127,
+158,
+1749,
+30,
+479,
+533,
+509,
+965,
+935,
+271,
+18,
+1480,
+689,
+1760,
+1629,
+33,
+637,
+825,
+1788,
+1738,
+1519,
+729,
+1011,
+83,
+1949,
+1688,
+1374,
+549,
+1595,
+861,
+1317,
+13,
+2039,
+781,
+1857,
+1957,
+362,
+364,
+1939,
+1924,
+349,
+2006,
+140,
+1827,
+1272,
+1487,
+645,
+1045,
+1756,
+1502,
+671,
+84,
+1497,
+721,
+2172,
+1078,
+1049,
+1033,
+656,
+113,
+1275,
+144,
+482,
+783,
+1709,
+516,
+1888,
+409,
+968,
+278,
+956,
+1379,
+1774,
+1663,
+996,
+584,
+1312,
+269,
+191,
+47,
+2161,
+2162,
+1512,
+1664,
+1861,
+174,
+1158,
+840,
+495,
+2012,
+298,
+969,
+1863,
+951,
+1891,
+531,
+1700,
+517,
+356,
+577,
+1708,
+841,
+1735,
+613,
+779,
+481,
+145,
+120,
+1044,
+1493,
+1430,
+670,
+308,
+882,
+1424,
+2026,
+259,
+547,
+138,
+1467,
+1199,
+1461,
+2007,
+1693,
+1290,
+614,
+1641,
+1828,
+1434,
+353,
+1923,
+1940,
+365,
+1858,
+782,
+1870,
+2038,
+1442,
+1843,
+600,
+1865,
+860,
+1950,
+53,
+160,
+1478,
+1249,
+28,
+1776,
+819,
+639,
+1,
+852,
+1627,
+560,
+653,
+1790,
+1301,
+2143,
+4,
+341,
+64,
+190,
+1313,
+506,
+511,
+477,
+1474,
+624,
+1772,
+153,
+126,
+1751,
+1712,
+1489,
+2017,
+1074,
+513,
+854,
+303,
+1971,
+2053,
+291,
+1187,
+636,
+290,
+1999,
+1438,
+1944,
+2085,
+1217,
+1842,
+2105,
+1640,
+1071,
+1176,
+261,
+465,
+130,
+2103,
+154,
+1479,
+606,
+1425,
+1518,
+1088,
+1182,
+44,
+986,
+1658,
+1248,
+1979,
+1718,
+830,
+644,
+1711,
+285,
+1284,
+414,
+1468,
+858,
+1205,
+1454,
+1552,
+1028,
+1386,
+2138,
+1784,
+268,
+2121,
+717,
+2063,
+601,
+2164,
+873,
+52,
+440,
+325,
+1483,
+50,
+1659,
+1775,
+1041,
+68,
+537,
+697,
+552,
+424,
+648,
+687,
+1890,
+10,
+2068,
+991,
+923,
+1753,
+491,
+134,
+457,
+740,
+774,
+264,
+143,
+2098,
+2080,
+1929,
+608,
+1406,
+1996,
+866,
+396,
+37,
+1006,
+1299,
+297,
+1893,
+1729,
+1695,
+2159,
+1622,
+1677,
+1126,
+667,
+1818,
+1110,
+1018,
+1067,
+1536,
+1165,
+1840,
+156,
+948,
+1004,
+985,
+2122,
+1427,
+1845,
+1251,
+1116,
+39,
+524,
+321,
+400,
+1247,
+1721,
+868,
+747,
+1656,
+304,
+286,
+997,
+1808,
+1225,
+332,
+1376,
+1062,
+1463,
+2037,
+170,
+1777,
+1436,
+1604,
+708,
+960,
+588,
+1741,
+444,
+125,
+422,
+1743,
+1503,
+2166,
+776,
+458,
+1456,
+66,
+2011,
+832,
+1653,
+655,
+634,
+390,
+889,
+1973,
+712,
+1035,
+2010,
+1816,
+478,
+1769,
+150,
+661,
+1102,
+737,
+1936,
+1294,
+1984,
+1305,
+596,
+407,
+1860,
+539,
+1084,
+1054,
+289,
+314,
+1295,
+1978,
+1719,
+1229,
+1965,
+91,
+1506,
+579,
+1146,
+1017,
+809,
+172,
+1210,
+1531,
+693,
+937,
+1269,
+2109,
+980,
+695,
+940,
+762,
+590,
+1190,
+746,
+114,
+1562,
+857,
+300,
+1297,
+1241,
+1321,
+1802,
+77,
+674,
+294,
+293,
+370,
+646,
+1164,
+2003,
+1058,
+519,
+186,
+816,
+1793,
+1742,
+1535,
+1099,
+950,
+1819,
+1763,
+428,
+1079,
+438,
+682,
+594,
+136,
+976,
+474,
+1416,
+1998,
+550,
+401,
+1345,
+999,
+1662,
+651,
+1989,
+2147,
+82,
+1916,
+418,
+1928,
+455,
+1268,
+727,
+1447,
+1065,
+1830,
+1947,
+166,
+1023,
+771,
+1825,
+885,
+1837,
+1060,
+1646,
+1412,
+880,
+2144,
+1824,
+913,
+417,
+2090,
+2072,
+75,
+273,
+564,
+275,
+2016,
+26,
+859,
+1521,
+279,
+963,
+920,
+569,
+178,
+110,
+1547,
+907,
+1218,
+431,
+368,
+254,
+98,
+1799,
+836,
+1271,
+2128,
+1787,
+710,
+759,
+58,
+295,
+287,
+1696,
+1892,
+2131,
+1333,
+1462,
+778,
+1354,
+1917,
+813,
+1934,
+1575,
+1121,
+1894,
+922,
+1534,
+1051,
+1135,
+115,
+1161,
+666,
+1667,
+851,
+1866,
+1076,
+1365,
+34,
+1401,
+1692,
+1341,
+1983,
+415,
+460,
+152,
+490,
+799,
+1680,
+1623,
+806,
+1886,
+20,
+1002,
+1532,
+745,
+2065,
+1340,
+1050,
+96,
+2034,
+692,
+503,
+434,
+1975,
+1197,
+104,
+731,
+1963,
+1274,
+1624,
+376,
+929,
+1849,
+61,
+32,
+556,
+201,
+1896,
+281,
+1331,
+2046,
+1746,
+1361,
+818,
+563,
+165,
+1580,
+340,
+853,
+718,
+1932,
+322,
+1214,
+1597,
+2042,
+887,
+591,
+1670,
+592,
+447,
+1068,
+48,
+1407,
+1169,
+1803,
+633,
+1449,
+642,
+1470,
+1105,
+582,
+1901,
+1318,
+1806,
+2150,
+1862,
+1128,
+283,
+631,
+725,
+146,
+2132,
+1069,
+1153,
+1546,
+1910,
+1835,
+793,
+1013,
+118,
+1418,
+2126,
+274,
+22,
+399,
+1012,
+1941,
+1253,
+1059,
+1381,
+199,
+790,
+1731,
+252,
+330,
+515,
+489,
+690,
+454,
+1602,
+476,
+168,
+1528,
+967,
+1445,
+336,
+1087,
+1196,
+1555,
+1310,
+2149,
+752,
+1694,
+112,
+1584,
+41,
+2,
+551,
+1019,
+1933,
+388,
+586,
+1647,
+1007,
+1072,
+2071,
+345,
+1805,
+1263,
+945,
+2021,
+698,
+339,
+1192,
+1904,
+2014,
+2114,
+876,
+1230,
+437,
+1631,
+1309,
+1885,
+124,
+1396,
+884,
+1704,
+1750,
+845,
+350,
+263,
+964,
+573,
+235,
+69,
+1254,
+1732,
+1342,
+106,
+257,
+505,
+1119,
+1334,
+185,
+1710,
+492,
+456,
+934,
+972,
+372,
+540,
+100,
+1373,
+2051,
+626,
+1025,
+389,
+722,
+1608,
+1725,
+24,
+232,
+1170,
+1765,
+2061,
+1644,
+1654,
+801,
+2112,
+804,
+1714,
+157,
+1414,
+1185,
+1908,
+974,
+1872,
+1245,
+658,
+2141,
+602,
+665,
+1010,
+1626,
+1279,
+561,
+2106,
+121,
+27,
+2024,
+1541,
+764,
+744,
+1325,
+909,
+926,
+1633,
+164,
+1820,
+1792,
+988,
+1231,
+616,
+713,
+1097,
+331,
+883,
+1596,
+900,
+359,
+1543,
+429,
+2043,
+971,
+751,
+108,
+1384,
+366,
+1186,
+1972,
+2129,
+1280,
+1266,
+2086,
+1675,
+215,
+871,
+1573,
+85,
+1716,
+2093,
+1347,
+1884,
+1408,
+1785,
+1594,
+1034,
+733,
+311,
+982,
+678,
+1180,
+875,
+151,
+1796,
+1587,
+486,
+508,
+1148,
+1537,
+1578,
+1417,
+3,
+1980,
+1037,
+1992,
+347,
+566,
+1108,
+1844,
+627,
+791,
+1357,
+139,
+1134,
+1922,
+1889,
+452,
+1898,
+312,
+1244,
+131,
+961,
+1003,
+1925,
+1036,
+1015,
+558,
+226,
+1464,
+11,
+662,
+1679,
+102,
+1024,
+780,
+2139,
+1724,
+1101,
+925,
+207,
+2023,
+1730,
+1081,
+525,
+2175,
+1145,
+360,
+942,
+162,
+180,
+1517,
+798,
+2005,
+1570,
+2045,
+420,
+758,
+1369,
+2174,
+236,
+1956,
+827,
+1343,
+572,
+1395,
+545,
+618,
+1053,
+1762,
+917,
+1757,
+1544,
+1202,
+611,
+2117,
+1322,
+148,
+1443,
+720,
+622,
+1713,
+664,
+1277,
+1138,
+1509,
+2137,
+2155,
+1919,
+2029,
+1047,
+1159,
+754,
+1404,
+43,
+1409,
+855,
+867,
+403,
+1812,
+1671,
+975,
+1232,
+502,
+363,
+1783,
+1238,
+1441,
+617,
+939,
+625,
+1538,
+1616,
+173,
+952,
+1515,
+1822,
+1690,
+1563,
+543,
+1358,
+384,
+90,
+1458,
+1090,
+1057,
+838,
+2025,
+65,
+1112,
+1419,
+870,
+194,
+2125,
+1911,
+1329,
+574,
+1446,
+1991,
+676,
+1767,
+981,
+1899,
+954,
+1142,
+249,
+436,
+1188,
+760,
+1523,
+886,
+1237,
+228,
+387,
+1043,
+1103,
+2101,
+1609,
+1261,
+1968,
+846,
+2094,
+742,
+1759,
+1125,
+198,
+1736,
+534,
+449,
+132,
+1739,
+704,
+309,
+792,
+1879,
+244,
+1798,
+1510,
+95,
+1558,
+320,
+2066,
+45,
+668,
+891,
+1390,
+2030,
+1411,
+821,
+849,
+2152,
+451,
+523,
+1030,
+7,
+205,
+1337,
+468,
+2055,
+1360,
+59,
+930,
+1485,
+1566,
+2088,
+987,
+1073,
+739,
+425,
+1591,
+1124,
+1038,
+1243,
+1405,
+1505,
+1686,
+2057,
+1946,
+824,
+200,
+1630,
+284,
+1403,
+1970,
+1569,
+1876,
+1208,
+2124,
+242,
+1157,
+1974,
+571,
+1771,
+1223,
+1588,
+938,
+623,
+610,
+2146,
+1075,
+1605,
+188,
+54,
+881,
+335,
+1801,
+1868,
+210,
+544,
+1063,
+1388,
+1682,
+829,
+1821,
+2118,
+1685,
+1330,
+231,
+9,
+212,
+1529,
+1651,
+2158,
+532,
+467,
+716,
+2009,
+497,
+1617,
+155,
+1706,
+888,
+2127,
+462,
+2151,
+327,
+484,
+1399,
+81,
+241,
+240,
+1959,
+1635,
+2163,
+1832,
+1642,
+1697,
+192,
+196,
+5,
+1457,
+1346,
+1961,
+908,
+1875,
+1745,
+1326,
+1428,
+995,
+2111,
+1304,
+607,
+686,
+978,
+1764,
+901,
+1498,
+769,
+1198,
+374,
+1600,
+202,
+931,
+288,
+1377,
+844,
+1355,
+1856,
+217,
+1222,
+1338,
+1432,
+1022,
+354,
+55,
+897,
+1094,
+1475,
+612,
+587,
+135,
+358,
+1260,
+2168,
+36,
+258,
+1834,
+1492,
+1174,
+1172,
+1507,
+1681,
+1370,
+248,
+2134,
+833,
+380,
+632,
+1590,
+1181,
+1953,
+2047,
+1848,
+1255,
+763,
+521,
+1748,
+1707,
+904,
+1114,
+265,
+1477,
+21,
+1055,
+1349,
+405,
+1285,
+1514,
+750,
+218,
+80,
+1621,
+1673,
+822,
+700,
+542,
+2171,
+1471,
+57,
+1958,
+598,
+1702,
+785,
+1100,
+369
+};
+
+FCITX_C_DECL_END
+
+
+#endif
@@ -6,12 +6,23 @@
  */
 
 #include "log.h"
+#include <syslog.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
 #include <mutex>
+#include <sstream>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
 #include <fmt/format.h>
+#include "config.h"
 #include "stringutils.h"
 
+#ifdef SYSTEMD_FOUND
+#include <systemd/sd-journal.h>
+#endif
+
 #if FMT_VERSION >= 50300
 #include <fmt/chrono.h>
 #endif
@@ -78,6 +89,286 @@ private:
     std::vector<LogRule> rules_;
     std::mutex mutex_;
 };
+
+struct LogRecord {
+    LogLevel level = LogLevel::NoLog;
+    std::string message;
+};
+
+// Bounded multi producer queue, each cell carries a sequence number to tell
+// whether it is ready to be written or read at given position.
+class LogRingBuffer {
+public:
+    explicit LogRingBuffer(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(LogRecord &record) {
+        Cell *cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record = std::move(record);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(LogRecord &record) {
+        Cell *cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        record = std::move(cell->record);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return dequeuePos_.load() == enqueuePos_.load();
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    std::atomic<size_t> enqueuePos_{0};
+    std::atomic<size_t> dequeuePos_{0};
+};
+
+std::atomic<bool> asyncLogEnabled{false};
+
+class AsyncLogWriter {
+public:
+    static AsyncLogWriter &instance() {
+        static AsyncLogWriter instance_;
+        return instance_;
+    }
+
+    ~AsyncLogWriter() { stop(); }
+
+    bool start(LogSink sink, const std::string &path, size_t capacity) {
+        stop();
+        if (sink == LogSink::File) {
+            file_.open(path, std::ios::out | std::ios::app);
+            if (!file_.is_open()) {
+                return false;
+            }
+        }
+        sink_ = sink;
+        buffer_ = std::make_unique<LogRingBuffer>(capacity);
+        reportedDropped_ = dropped_.load();
+        stop_ = false;
+        thread_ = std::thread(&AsyncLogWriter::run, this);
+        asyncLogEnabled = true;
+        return true;
+    }
+
+    void stop() {
+        if (!thread_.joinable()) {
+            return;
+        }
+        asyncLogEnabled = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+        // Catch anything pushed after the writer has gone. The buffer itself
+        // is kept, in case other thread is still about to push.
+        drain();
+        if (file_.is_open()) {
+            file_.close();
+        }
+    }
+
+    void push(LogRecord record) {
+        if (!buffer_->push(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Pairs with the store to sleeping_ before writer checks the buffer.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_.notify_one();
+        }
+    }
+
+    // Write record before return, along with everything queued before it.
+    void pushAndFlush(const LogRecord &record) {
+        drain();
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        write(record);
+        flushSink();
+    }
+
+    uint64_t dropped() const { return dropped_.load(); }
+
+private:
+    void run() {
+        while (true) {
+            drain();
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_) {
+                break;
+            }
+            sleeping_ = true;
+            condition_.wait(lock,
+                            [this]() { return stop_ || !buffer_->empty(); });
+            sleeping_ = false;
+        }
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        LogRecord record;
+        bool written = false;
+        while (buffer_->pop(record)) {
+            write(record);
+            written = true;
+        }
+        auto dropped = dropped_.load();
+        if (dropped != reportedDropped_) {
+            // Format it like any other message, but write it directly since
+            // the buffer may still be full.
+            std::ostringstream stream;
+            LogMessageBuilder(stream, LogLevel::Warn, FCITX_LOG_FILENAME_WRAP,
+                              __LINE__)
+                    .self()
+                << "Log buffer is full, " << (dropped - reportedDropped_)
+                << " messages are dropped.";
+            LogRecord report;
+            report.level = LogLevel::Warn;
+            report.message = stream.str();
+            // Sinks add their own line break.
+            if (!report.message.empty() && report.message.back() == '\n') {
+                report.message.pop_back();
+            }
+            reportedDropped_ = dropped;
+            write(report);
+            written = true;
+        }
+        if (written) {
+            flushSink();
+        }
+    }
+
+    void write(const LogRecord &record) {
+        switch (sink_) {
+        case LogSink::Stderr:
+            std::cerr << record.message << '\n';
+            break;
+        case LogSink::File:
+            file_ << record.message << '\n';
+            break;
+        case LogSink::Journal: {
+            int priority;
+            switch (record.level) {
+            case LogLevel::Fatal:
+                priority = LOG_CRIT;
+                break;
+            case LogLevel::Error:
+                priority = LOG_ERR;
+                break;
+            case LogLevel::Warn:
+                priority = LOG_WARNING;
+                break;
+            case LogLevel::Debug:
+                priority = LOG_DEBUG;
+                break;
+            default:
+                priority = LOG_INFO;
+                break;
+            }
+#ifdef SYSTEMD_FOUND
+            sd_journal_print(priority, "%s", record.message.data());
+#else
+            syslog(priority, "%s", record.message.data());
+#endif
+        } break;
+        }
+    }
+
+    void flushSink() {
+        switch (sink_) {
+        case LogSink::Stderr:
+            std::cerr.flush();
+            break;
+        case LogSink::File:
+            file_.flush();
+            break;
+        case LogSink::Journal:
+            break;
+        }
+    }
+
+    LogSink sink_ = LogSink::Stderr;
+    std::ofstream file_;
+    std::unique_ptr<LogRingBuffer> buffer_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_ = false;
+    std::atomic<bool> sleeping_{false};
+    // Serialize the access to sink between writer thread and fatal message.
+    std::mutex writeMutex_;
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t reportedDropped_ = 0;
+};
+
+// A log message may be nested within another one on the same thread, e.g.
+// when operator<< calls a function that logs, so keep a stack of buffers.
+struct AsyncLogBuffer {
+    std::ostringstream stream;
+    LogLevel level = LogLevel::NoLog;
+};
+
+thread_local size_t asyncLogDepth = 0;
+
+std::vector<std::unique_ptr<AsyncLogBuffer>> &asyncLogBuffers() {
+    thread_local std::vector<std::unique_ptr<AsyncLogBuffer>> buffers;
+    return buffers;
+}
+
 } // namespace
 
 class LogCategoryPrivate {
@@ -109,6 +400,7 @@ bool LogCategory::checkLogLevel(LogLevel l) const {
 void LogCategory::resetLogLevel() {
     FCITX_D();
     d->level_ = d->defaultLevel_;
+    LogCallSite::invalidate();
 }
 
 void LogCategory::setLogLevel(std::underlying_type_t<LogLevel> l) {
@@ -120,6 +412,7 @@ void LogCategory::setLogLevel(std::underlying_type_t<LogLevel> l) {
 void LogCategory::setLogLevel(LogLevel l) {
     FCITX_D();
     d->level_ = l;
+    LogCallSite::invalidate();
 }
 
 LogLevel LogCategory::logLevel() const {
@@ -148,6 +441,28 @@ bool LogCategory::fatalWrapper2(LogLevel level) {
     return false;
 }
 
+std::atomic<uint32_t> LogCallSite::generation_{1};
+
+void LogCallSite::invalidate() {
+    auto generation = generation_.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+        // Keep it within 31 bits and never 0, which marks an empty cache.
+        next = (generation % 0x7fffffffU) + 1;
+    } while (!generation_.compare_exchange_weak(generation, next,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+}
+
+bool LogCallSite::update(const LogCategory &category, LogLevel level) {
+    // Read generation before level, so a concurrent change is never cached.
+    const auto generation = generation_.load(std::memory_order_acquire);
+    const bool result = category.checkLogLevel(level);
+    state_.store((generation << 1) | (result ? 1 : 0),
+                 std::memory_order_relaxed);
+    return result;
+}
+
 const LogCategory &Log::defaultCategory() { return fcitx::defaultCategory(); }
 
 void Log::setLogRule(const std::string &ruleString) {
@@ -180,11 +495,41 @@ void Log::setLogStream(std::ostream &stream) {
     globalLogConfig.defaultLogStream = &stream;
 }
 
-std::ostream &Log::logStream() { return *globalLogConfig.defaultLogStream; }
+std::ostream &Log::logStream() {
+    if (asyncLogEnabled.load(std::memory_order_relaxed)) {
+        auto &buffers = asyncLogBuffers();
+        if (buffers.size() <= asyncLogDepth) {
+            buffers.push_back(std::make_unique<AsyncLogBuffer>());
+        }
+        return buffers[asyncLogDepth]->stream;
+    }
+    return *globalLogConfig.defaultLogStream;
+}
+
+bool Log::startAsyncLog(LogSink sink, const std::string &path,
+                        size_t capacity) {
+    return AsyncLogWriter::instance().start(sink, path, capacity);
+}
+
+void Log::stopAsyncLog() { AsyncLogWriter::instance().stop(); }
+
+bool Log::isAsyncLog() { return asyncLogEnabled.load(); }
+
+uint64_t Log::droppedLogMessages() {
+    return AsyncLogWriter::instance().dropped();
+}
 
 LogMessageBuilder::LogMessageBuilder(std::ostream &out, LogLevel l,
                                      const char *filename, int lineNumber)
     : out_(out) {
+    if (asyncLogEnabled.load(std::memory_order_relaxed)) {
+        auto &buffers = asyncLogBuffers();
+        if (asyncLogDepth < buffers.size() &&
+            &out == &buffers[asyncLogDepth]->stream) {
+            buffers[asyncLogDepth]->level = l;
+            ++asyncLogDepth;
+        }
+    }
     switch (l) {
     case LogLevel::Fatal:
         out_ << "F";
@@ -222,5 +567,30 @@ LogMessageBuilder::LogMessageBuilder(std::ostream &out, LogLevel l,
     out_ << filename << ":" << lineNumber << "] ";
 }
 
-LogMessageBuilder::~LogMessageBuilder() { out_ << std::endl; }
+LogMessageBuilder::~LogMessageBuilder() {
+    if (asyncLogDepth == 0) {
+        out_ << std::endl;
+        return;
+    }
+    auto &buffer = *asyncLogBuffers()[asyncLogDepth - 1];
+    if (&out_ != &buffer.stream) {
+        out_ << std::endl;
+        return;
+    }
+    --asyncLogDepth;
+    LogRecord record;
+    record.level = buffer.level;
+    record.message = buffer.stream.str();
+    buffer.stream.str(std::string());
+    buffer.stream.clear();
+
+    if (!asyncLogEnabled.load(std::memory_order_relaxed)) {
+        // Writer is stopped while we are formatting.
+        *globalLogConfig.defaultLogStream << record.message << std::endl;
+    } else if (record.level == LogLevel::Fatal) {
+        AsyncLogWriter::instance().pushAndFlush(record);
+    } else {
+        AsyncLogWriter::instance().push(std::move(record));
+    }
+}
 } // namespace fcitx
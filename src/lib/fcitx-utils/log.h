@@ -12,6 +12,8 @@
 /// \file
 /// \brief Log utilities.
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <map>
@@ -49,6 +51,20 @@ enum LogLevel : int {
         return *this;                                                          \
     }
 
+/**
+ * Destination of the asynchronous log writer.
+ *
+ * @see Log::startAsyncLog
+ * @since 5.1.12
+ */
+enum class LogSink {
+    Stderr,
+    /// Append to a file.
+    File,
+    /// Send to systemd journal, or syslog if built without systemd.
+    Journal,
+};
+
 class LogCategoryPrivate;
 class FCITXUTILS_EXPORT LogCategory {
 public:
@@ -71,6 +87,44 @@ private:
     std::unique_ptr<LogCategoryPrivate> d_ptr;
 };
 
+/**
+ * Cached result of log level check for a single log call site.
+ *
+ * Used by FCITX_LOGC so a disabled log statement only costs a load and a
+ * compare. The cache is invalidated whenever the level of any category
+ * changes.
+ *
+ * @since 5.1.12
+ */
+class FCITXUTILS_EXPORT LogCallSite {
+public:
+    constexpr LogCallSite() = default;
+
+    template <LogLevel level, typename Category>
+    bool enabled(const Category &category) {
+        if constexpr (level == LogLevel::Fatal) {
+            // Need to abort if it is not logged.
+            return category().fatalWrapper(level);
+        } else {
+            const auto state = state_.load(std::memory_order_relaxed);
+            if ((state >> 1) == generation_.load(std::memory_order_relaxed)) {
+                return state & 1;
+            }
+            return update(category(), level);
+        }
+    }
+
+    /// Invalidate all the cached call sites.
+    static void invalidate();
+
+private:
+    bool update(const LogCategory &category, LogLevel level);
+
+    static std::atomic<uint32_t> generation_;
+    // generation << 1 | enabled, 0 means not computed yet.
+    std::atomic<uint32_t> state_{0};
+};
+
 class FCITXUTILS_EXPORT Log {
 public:
     static const LogCategory &defaultCategory();
@@ -95,6 +149,51 @@ public:
      * @since 5.0.6
      */
     static std::ostream &logStream();
+    /**
+     * @brief Move log output to a background writer thread.
+     *
+     * Once started, each message is formatted on the calling thread into a
+     * thread local buffer and handed over to a bounded ring buffer, which is
+     * drained by a writer thread. If the ring buffer is full, the message is
+     * dropped instead of blocking the caller, and the writer will report the
+     * number of dropped messages. Fatal messages are always written before
+     * returning.
+     *
+     * The stream set by setLogStream is not used while asynchronous log is
+     * active. Calling it again will restart the writer with the new sink.
+     *
+     * This function is not thread safe.
+     *
+     * @param sink destination of the log.
+     * @param path file path, only used when sink is LogSink::File.
+     * @param capacity number of messages that can be queued.
+     * @return whether the sink is opened successfully.
+     * @since 5.1.12
+     */
+    static bool startAsyncLog(LogSink sink, const std::string &path = {},
+                              size_t capacity = 8192);
+    /**
+     * @brief Flush the pending messages and stop the writer thread.
+     *
+     * Log goes back to the stream set by setLogStream.
+     *
+     * This function is not thread safe.
+     *
+     * @since 5.1.12
+     */
+    static void stopAsyncLog();
+    /**
+     * @brief Whether asynchronous log is active.
+     *
+     * @since 5.1.12
+     */
+    static bool isAsyncLog();
+    /**
+     * @brief Total number of messages dropped due to a full ring buffer.
+     *
+     * @since 5.1.12
+     */
+    static uint64_t droppedLogMessages();
 };
 
 class FCITXUTILS_EXPORT LogMessageBuilder {
@@ -283,9 +382,32 @@ private:
     fcitx::MetaStringBasenameType<fcitxMakeMetaString(__FILE__)>::data()
 #endif
 
+/**
+ * Log with a level greater than this value is removed at compile time.
+ *
+ * Fatal log is never removed since it need to abort.
+ *
+ * @since 5.1.12
+ */
+#ifndef FCITX_LOG_COMPILE_LEVEL
+#define FCITX_LOG_COMPILE_LEVEL 5
+#endif
+
+#define FCITX_LOG_COMPILE_ENABLED(LEVEL)                                       \
+    (::fcitx::LogLevel::LEVEL == ::fcitx::LogLevel::Fatal ||                   \
+     static_cast<int>(::fcitx::LogLevel::LEVEL) <= (FCITX_LOG_COMPILE_LEVEL))
+
+#define FCITX_LOG_SITE_ENABLED(CATEGORY, LEVEL)                                \
+    ([]() -> ::fcitx::LogCallSite & {                                          \
+        static ::fcitx::LogCallSite fcitxLogCallSite;                          \
+        return fcitxLogCallSite;                                               \
+    }()                                                                        \
+                 .template enabled<::fcitx::LogLevel::LEVEL>(CATEGORY))
+
 #define FCITX_LOGC_IF(CATEGORY, LEVEL, CONDITION)                              \
-    for (bool fcitxLogEnabled =                                                \
-             (CONDITION) && CATEGORY().fatalWrapper(::fcitx::LogLevel::LEVEL); \
+    for (bool fcitxLogEnabled = FCITX_LOG_COMPILE_ENABLED(LEVEL) &&            \
+                                (CONDITION) &&                                 \
+                                FCITX_LOG_SITE_ENABLED(CATEGORY, LEVEL);       \
          fcitxLogEnabled;                                                      \
          fcitxLogEnabled = CATEGORY().fatalWrapper2(::fcitx::LogLevel::LEVEL)) \
     ::fcitx::LogMessageBuilder(::fcitx::Log::logStream(),                      \
@@ -294,8 +416,8 @@ private:
         .self()
 
 #define FCITX_LOGC(CATEGORY, LEVEL)                                            \
-    for (bool fcitxLogEnabled =                                                \
-             CATEGORY().fatalWrapper(::fcitx::LogLevel::LEVEL);                \
+    for (bool fcitxLogEnabled = FCITX_LOG_COMPILE_ENABLED(LEVEL) &&            \
+                                FCITX_LOG_SITE_ENABLED(CATEGORY, LEVEL);       \
          fcitxLogEnabled;                                                      \
          fcitxLogEnabled = CATEGORY().fatalWrapper2(::fcitx::LogLevel::LEVEL)) \
     ::fcitx::LogMessageBuilder(::fcitx::Log::logStream(),                      \
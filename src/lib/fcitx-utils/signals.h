@@ -12,7 +12,9 @@
 /// \file
 /// \brief A signal-slot implemention.
 
+#include <memory>
 #include <tuple>
+#include <vector>
 #include <fcitx-utils/handlertable.h>
 #include <fcitx-utils/intrusivelist.h>
 #include <fcitx-utils/macros.h>
@@ -125,12 +127,35 @@ class Signal;
 
 template <typename Ret, typename Combiner, typename... Args>
 class Signal<Ret(Args...), Combiner> : public SignalBase {
+    using handler_type = std::function<Ret(Args...)>;
+    using snapshot_type = std::vector<HandlerTableData<handler_type>>;
+
     struct SignalData {
         SignalData(Combiner combiner) : combiner_(std::move(combiner)) {}
 
-        HandlerTable<std::function<Ret(Args...)>> table_;
+        // Return the handlers to invoke. The snapshot is only rebuilt after
+        // the set of connections is changed, so emission in the common case
+        // neither allocates nor copies any handler.
+        std::shared_ptr<const snapshot_type> snapshot() {
+            // connect() always drops the snapshot, so a size mismatch means
+            // something is disconnected since it is built.
+            if (!snapshot_ || snapshot_->size() != connections_.size()) {
+                auto snapshot = std::make_shared<snapshot_type>();
+                snapshot->reserve(table_.size());
+                for (const auto &entry : table_.entries()) {
+                    snapshot->push_back(entry.handler());
+                }
+                snapshot_ = std::move(snapshot);
+            }
+            return snapshot_;
+        }
+
+        HandlerTable<handler_type> table_;
         IntrusiveList<ConnectionBody> connections_;
         Combiner combiner_;
+        // Shared with ongoing emissions, which keeps handler added or removed
+        // by a slot from affecting them.
+        std::shared_ptr<const snapshot_type> snapshot_;
     };
 
 public:
@@ -151,10 +176,13 @@ public:
     }
 
     Ret operator()(Args... args) {
-        auto view = d_ptr->table_.view();
+        using view_iterator = typename HandlerTableView<handler_type>::iterator;
+        auto snapshot = d_ptr->snapshot();
         Invoker<Ret, Args...> invoker(args...);
-        auto iter = MakeSlotInvokeIterator(invoker, view.begin());
-        auto end = MakeSlotInvokeIterator(invoker, view.end());
+        auto iter = MakeSlotInvokeIterator(
+            invoker, view_iterator(snapshot->cbegin(), snapshot->cend()));
+        auto end = MakeSlotInvokeIterator(
+            invoker, view_iterator(snapshot->cend(), snapshot->cend()));
         return d_ptr->combiner_(iter, end);
     }
 
@@ -163,6 +191,7 @@ public:
         auto *body =
             new ConnectionBody(d_ptr->table_.add(std::forward<Func>(func)));
         d_ptr->connections_.push_back(*body);
+        d_ptr->snapshot_.reset();
         return Connection{body->watch()};
     }
 
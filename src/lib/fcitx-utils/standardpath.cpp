@@ -13,17 +13,24 @@
 #include <unistd.h>
 #include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -31,6 +38,7 @@
 #include <vector>
 #include "config.h"
 #include "fs.h"
+#include "log.h"
 #include "macros.h"
 #include "misc.h"
 #include "misc_p.h"
@@ -40,6 +48,11 @@
 #include <paths.h>
 #endif
 
+#if __has_include(<sys/inotify.h>)
+#include <sys/inotify.h>
+#define FCITX_HAS_INOTIFY
+#endif
+
 #ifndef O_ACCMODE
 #define O_ACCMODE (O_RDONLY | O_WRONLY | O_RDWR)
 #endif
@@ -59,6 +72,308 @@ std::string constructPath(const std::string &basepath,
     return fs::cleanPath(stringutils::joinPath(basepath, subpath));
 }
 
+enum class DirEntryType : uint8_t { Missing, Regular, Directory, Other };
+
+struct DirectoryListing {
+    // False if directory does not exist, or can not be read.
+    bool readable = false;
+    // Directory exists but can not be listed, file may still be accessible.
+    bool unlistable = false;
+    // Directory is watched by inotify (or its parent if it does not exist),
+    // so the listing stays valid until an event is received.
+    bool watched = false;
+    // The modification time is too close to the time of listing, a change
+    // within the same time stamp would go unnoticed.
+    bool racy = false;
+    // The inotify watch descriptor this listing is registered with.
+    int watch = -1;
+    int64_t mtime = 0;
+    // Keep the order of readdir.
+    std::vector<std::string> names;
+    std::unordered_map<std::string, DirEntryType> entries;
+};
+
+int64_t statTime(const struct stat &st) {
+#if defined(__APPLE__)
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 +
+           st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+           st.st_mtim.tv_nsec;
+#endif
+}
+
+// Cache of directory listings, so looking up the same directories for many
+// different files does not need to hit the file system each time. A listing
+// is invalidated by inotify if available, otherwise by the modification time
+// of the directory.
+class DirectoryCache {
+public:
+    DirectoryCache() {
+#ifdef FCITX_HAS_INOTIFY
+        inotify_.give(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+#endif
+    }
+
+    std::shared_ptr<const DirectoryListing> listing(const std::string &dir) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        processEvents();
+        if (auto iter = listings_.find(dir); iter != listings_.end()) {
+            if (isValid(dir, *iter->second)) {
+                return iter->second;
+            }
+            eraseListing(iter);
+        }
+        if (listings_.size() >= maxListings) {
+            clear();
+        }
+        auto listing = readDirectory(dir);
+        listings_.emplace(dir, listing);
+        return listing;
+    }
+
+    // Return the type of a file, or nullopt if the cache can not tell.
+    std::optional<DirEntryType> lookup(const std::string &path) {
+        auto pos = path.rfind('/');
+        if (pos == std::string::npos || pos + 1 == path.size()) {
+            return std::nullopt;
+        }
+        auto dirListing = listing(pos == 0 ? "/" : path.substr(0, pos));
+        if (dirListing->unlistable) {
+            return std::nullopt;
+        }
+        if (const auto *type =
+                findValue(dirListing->entries, path.substr(pos + 1))) {
+            return *type;
+        }
+        return DirEntryType::Missing;
+    }
+
+    bool isRegularFile(const std::string &path) {
+        if (auto type = lookup(path)) {
+            return *type == DirEntryType::Regular;
+        }
+        return fs::isreg(path);
+    }
+
+    // Return false if the file surely does not exist.
+    bool mayExist(const std::string &path) {
+        return lookup(path) != DirEntryType::Missing;
+    }
+
+private:
+    static constexpr size_t maxListings = 4096;
+
+    bool isValid(const std::string &dir, const DirectoryListing &listing) {
+        if (listing.watched) {
+            return true;
+        }
+        struct stat st;
+        if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            return !listing.readable && !listing.unlistable;
+        }
+        return listing.readable && !listing.racy &&
+               statTime(st) == listing.mtime;
+    }
+
+    std::shared_ptr<DirectoryListing> readDirectory(const std::string &dir) {
+        auto listing = std::make_shared<DirectoryListing>();
+        // Watch before reading, so a change in between will invalidate it.
+        const int watch = addWatch(dir);
+        struct stat st;
+        if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            // Let the parent tell us when the directory is created.
+            if (watch < 0) {
+                auto parent = fs::dirName(dir);
+                if (parent != dir) {
+                    listing->watch = addWatch(parent, dir);
+                    listing->watched = listing->watch >= 0;
+                }
+            } else {
+                // Raced with creation, don't trust it.
+                listing->watched = false;
+                removeUnusedWatch(watch);
+            }
+            return listing;
+        }
+        listing->mtime = statTime(st);
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        listing->racy =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() -
+                listing->mtime <
+            2000000000LL;
+
+        UniqueCPtr<DIR, closedir> scopedDir{opendir(dir.c_str())};
+        if (!scopedDir) {
+            listing->unlistable = true;
+            removeUnusedWatch(watch);
+            return listing;
+        }
+        listing->readable = true;
+        auto *dirp = scopedDir.get();
+        const int fd = dirfd(dirp);
+        struct dirent *drt;
+        while ((drt = readdir(dirp)) != nullptr) {
+            if (strcmp(drt->d_name, ".") == 0 ||
+                strcmp(drt->d_name, "..") == 0) {
+                continue;
+            }
+            DirEntryType type = DirEntryType::Other;
+#ifdef _DIRENT_HAVE_D_TYPE
+            if (drt->d_type == DT_REG) {
+                type = DirEntryType::Regular;
+            } else if (drt->d_type == DT_DIR) {
+                type = DirEntryType::Directory;
+            } else if (drt->d_type == DT_LNK || drt->d_type == DT_UNKNOWN)
+#endif
+            {
+                // Follow symlink, like stat.
+                struct stat entryStat;
+                if (fstatat(fd, drt->d_name, &entryStat, 0) == 0) {
+                    if (S_ISREG(entryStat.st_mode)) {
+                        type = DirEntryType::Regular;
+                    } else if (S_ISDIR(entryStat.st_mode)) {
+                        type = DirEntryType::Directory;
+                    }
+                }
+            }
+            listing->names.emplace_back(drt->d_name);
+            listing->entries.emplace(listing->names.back(), type);
+        }
+        listing->watched = watch >= 0;
+        if (listing->watched) {
+            listing->watch = watch;
+            watches_[watch].push_back(dir);
+        }
+        return listing;
+    }
+
+    using ListingMap =
+        std::unordered_map<std::string, std::shared_ptr<DirectoryListing>>;
+
+    ListingMap::iterator eraseListing(ListingMap::iterator iter) {
+        releaseWatch(iter->second->watch, iter->first);
+        return listings_.erase(iter);
+    }
+
+    void eraseListing(const std::string &dir) {
+        if (auto iter = listings_.find(dir); iter != listings_.end()) {
+            eraseListing(iter);
+        }
+    }
+
+    // Drop every listing, together with all the inotify watches.
+    void clear() {
+#ifdef FCITX_HAS_INOTIFY
+        for (const auto &watch : watches_) {
+            inotify_rm_watch(inotify_.fd(), watch.first);
+        }
+#endif
+        watches_.clear();
+        listings_.clear();
+    }
+
+    // Unregister dir from the watch, and remove the watch from inotify once
+    // no listing depends on it. Otherwise every evicted listing would keep a
+    // watch descriptor until the inotify instance runs out of them.
+    void releaseWatch(int wd, const std::string &dir) {
+        auto iter = watches_.find(wd);
+        if (iter == watches_.end()) {
+            return;
+        }
+        auto &dirs = iter->second;
+        dirs.erase(std::remove(dirs.begin(), dirs.end(), dir), dirs.end());
+        if (dirs.empty()) {
+            watches_.erase(iter);
+            removeUnusedWatch(wd);
+        }
+    }
+
+    // Remove a watch that ended up not being registered by any listing.
+    void removeUnusedWatch([[maybe_unused]] int wd) {
+#ifdef FCITX_HAS_INOTIFY
+        if (wd >= 0 && !watches_.count(wd)) {
+            inotify_rm_watch(inotify_.fd(), wd);
+        }
+#endif
+    }
+
+    int addWatch([[maybe_unused]] const std::string &path,
+                 [[maybe_unused]] const std::string &dependent = {}) {
+#ifdef FCITX_HAS_INOTIFY
+        if (inotify_.fd() < 0) {
+            return -1;
+        }
+        int wd = inotify_add_watch(inotify_.fd(), path.c_str(),
+                                   IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                       IN_MOVED_TO | IN_ATTRIB |
+                                       IN_DELETE_SELF | IN_MOVE_SELF |
+                                       IN_ONLYDIR);
+        if (wd >= 0 && !dependent.empty()) {
+            watches_[wd].push_back(dependent);
+        }
+        return wd;
+#else
+        return -1;
+#endif
+    }
+
+    void processEvents() {
+#ifdef FCITX_HAS_INOTIFY
+        if (inotify_.fd() < 0) {
+            return;
+        }
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t len;
+        while ((len = read(inotify_.fd(), buffer, sizeof(buffer))) > 0) {
+            for (char *ptr = buffer; ptr < buffer + len;) {
+                const auto *event =
+                    reinterpret_cast<const struct inotify_event *>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    clear();
+                    continue;
+                }
+                auto iter = watches_.find(event->wd);
+                if (iter == watches_.end()) {
+                    continue;
+                }
+                // The dependent listings will register again when re-read.
+                auto dirs = std::move(iter->second);
+                watches_.erase(iter);
+                if (!(event->mask & IN_IGNORED)) {
+                    removeUnusedWatch(event->wd);
+                }
+                for (const auto &dir : dirs) {
+                    eraseListing(dir);
+                    // Subdirectory may be gone together with it.
+                    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        eraseChildren(dir);
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    void eraseChildren(const std::string &dir) {
+        for (auto iter = listings_.begin(); iter != listings_.end();) {
+            if (stringutils::startsWith(iter->first, dir) &&
+                iter->first.size() > dir.size() &&
+                iter->first[dir.size()] == '/') {
+                iter = eraseListing(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    UnixFD inotify_;
+    ListingMap listings_;
+    std::unordered_map<int, std::vector<std::string>> watches_;
+};
+
 } // namespace
 
 StandardPathFile::~StandardPathFile() = default;
@@ -88,6 +403,109 @@ void StandardPathTempFile::close() {
     }
 }
 
+// Writes the files queued by StandardPath::queueSave in a single background
+// thread.
+class SaveQueue {
+    struct Save {
+        StandardPath::Type type;
+        std::string path;
+        std::string content;
+    };
+
+public:
+    ~SaveQueue() { stop(); }
+
+    void queue(const StandardPath *standardPath, StandardPath::Type type,
+               const std::string &path, std::string content) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The one being written is already out of the list, so it is still
+        // written again with the new content.
+        auto iter = std::find_if(
+            pending_.begin(), pending_.end(), [type, &path](const Save &save) {
+                return save.type == type && save.path == path;
+            });
+        if (iter != pending_.end()) {
+            iter->content = std::move(content);
+            return;
+        }
+        pending_.push_back({type, path, std::move(content)});
+        busy_.store(true, std::memory_order_release);
+        if (!thread_.joinable()) {
+            thread_ =
+                std::thread([this, standardPath]() { run(standardPath); });
+        }
+        condition_.notify_all();
+    }
+
+    // Wait until path is written, or all files if path is null.
+    void wait(StandardPath::Type type, const std::string *path) {
+        if (!busy_.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Worker thread calls safeSave to write the file.
+        if (std::this_thread::get_id() == thread_.get_id()) {
+            return;
+        }
+        condition_.wait(lock, [this, type, path]() {
+            auto match = [type, path](const Save &save) {
+                return !path || (save.type == type && save.path == *path);
+            };
+            return !(writing_ && match(*writing_)) &&
+                   std::none_of(pending_.begin(), pending_.end(), match);
+        });
+    }
+
+    // Write everything that is queued, and stop the thread.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        condition_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run(const StandardPath *standardPath) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait(
+                lock, [this]() { return exit_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break;
+            }
+            writing_ = std::move(pending_.front());
+            pending_.pop_front();
+            lock.unlock();
+            const auto &save = *writing_;
+            if (!standardPath->safeSave(
+                    save.type, save.path, [&save](int fd) {
+                        return fs::safeWrite(fd, save.content.data(),
+                                             save.content.size()) ==
+                               static_cast<ssize_t>(save.content.size());
+                    })) {
+                FCITX_WARN() << "Failed to save file: " << save.path;
+            }
+            lock.lock();
+            writing_.reset();
+            busy_.store(!pending_.empty(), std::memory_order_release);
+            condition_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Save> pending_;
+    std::optional<Save> writing_;
+    // Whether anything is queued or being written, checked without lock.
+    std::atomic<bool> busy_{false};
+    bool exit_ = false;
+    std::thread thread_;
+};
+
 class StandardPathPrivate {
 public:
     StandardPathPrivate(
@@ -128,6 +546,15 @@ public:
             stringutils::join(pkgdataDirFallback, ":").c_str(), builtInPathMap,
             skipBuiltInPath_ ? nullptr : "pkgdatadir");
         cacheHome_ = defaultPath("XDG_CACHE_HOME", ".cache");
+        // Read only caches prepared for all users, e.g. on a multi-user host,
+        // there is no such directory by default.
+        if (isFcitx) {
+            cacheDirs_ = defaultPaths("FCITX_CACHE_DIRS", "", builtInPathMap,
+                                      nullptr);
+            cacheDirs_.erase(std::remove(cacheDirs_.begin(), cacheDirs_.end(),
+                                         std::string()),
+                             cacheDirs_.end());
+        }
         const char *tmpdir = getenv("TMPDIR");
         runtimeDir_ = defaultPath("XDG_RUNTIME_DIR",
                                   !tmpdir || !tmpdir[0] ? "/tmp" : tmpdir);
@@ -171,6 +598,8 @@ public:
             return dataDirs_;
         case StandardPath::Type::PkgData:
             return pkgdataDirs_;
+        case StandardPath::Type::Cache:
+            return cacheDirs_;
         case StandardPath::Type::Addon:
             return addonDirs_;
         default:
@@ -192,6 +621,23 @@ public:
 
     mode_t umask() const { return umask_.load(std::memory_order_relaxed); }
 
+    DirectoryCache &cache() const { return cache_; }
+
+    SaveQueue &saveQueue() const { return saveQueue_; }
+
+    void setSaveDeferred(bool deferred) {
+        saveDeferred_.store(deferred, std::memory_order_relaxed);
+    }
+
+    bool isSaveDeferred() const {
+        return saveDeferred_.load(std::memory_order_relaxed);
+    }
+
+    // Skip the open call if the cache knows the file does not exist.
+    bool mayOpen(const std::string &path, int flags) const {
+        return (flags & O_CREAT) || cache_.mayExist(path);
+    }
+
 private:
     // http://standards.freedesktop.org/basedir-spec/basedir-spec-latest.html
     static std::string defaultPath(const char *env, const char *defaultPath) {
@@ -293,9 +739,13 @@ private:
     std::string pkgdataHome_;
     std::vector<std::string> pkgdataDirs_;
     std::string cacheHome_;
+    std::vector<std::string> cacheDirs_;
     std::string runtimeDir_;
     std::vector<std::string> addonDirs_;
     std::atomic<mode_t> umask_;
+    mutable DirectoryCache cache_;
+    std::atomic<bool> saveDeferred_{false};
+    mutable SaveQueue saveQueue_;
 };
 
 StandardPath::StandardPath(
@@ -311,7 +761,10 @@ StandardPath::StandardPath(bool skipFcitxPath, bool skipUserPath)
 StandardPath::StandardPath(bool skipFcitxPath)
     : StandardPath(skipFcitxPath, false) {}
 
-StandardPath::~StandardPath() = default;
+StandardPath::~StandardPath() {
+    FCITX_D();
+    d->saveQueue().stop();
+}
 
 const StandardPath &StandardPath::global() {
     bool skipFcitx = checkBoolEnvVar("SKIP_FCITX_PATH");
@@ -417,19 +870,13 @@ void StandardPath::scanFiles(
     const std::function<bool(const std::string &fileName,
                              const std::string &dir, bool user)> &scanner)
     const {
-    auto scanDir = [scanner](const std::string &fullPath, bool isUser) {
-        UniqueCPtr<DIR, closedir> scopedDir{opendir(fullPath.c_str())};
-        if (auto *dir = scopedDir.get()) {
-            struct dirent *drt;
-            while ((drt = readdir(dir)) != nullptr) {
-                if (strcmp(drt->d_name, ".") == 0 ||
-                    strcmp(drt->d_name, "..") == 0) {
-                    continue;
-                }
-
-                if (!scanner(drt->d_name, fullPath, isUser)) {
-                    return false;
-                }
+    FCITX_D();
+    auto scanDir = [d, &scanner](const std::string &fullPath, bool isUser) {
+        // Hold the listing, scanner may trigger another lookup.
+        auto listing = d->cache().listing(fullPath);
+        for (const auto &name : listing->names) {
+            if (!scanner(name, fullPath, isUser)) {
+                return false;
             }
         }
         return true;
@@ -446,6 +893,7 @@ void StandardPath::scanFiles(
 }
 
 std::string StandardPath::locate(Type type, const std::string &path) const {
+    FCITX_D();
     std::string retPath;
     if (isAbsolutePath(path)) {
         if (fs::isreg(path)) {
@@ -453,9 +901,9 @@ std::string StandardPath::locate(Type type, const std::string &path) const {
         }
     } else {
         scanDirectories(type,
-                        [&retPath, &path](const std::string &dirPath, bool) {
+                        [d, &retPath, &path](const std::string &dirPath, bool) {
                             std::string fullPath = constructPath(dirPath, path);
-                            if (!fs::isreg(fullPath)) {
+                            if (!d->cache().isRegularFile(fullPath)) {
                                 return true;
                             }
                             retPath = std::move(fullPath);
@@ -467,26 +915,29 @@ std::string StandardPath::locate(Type type, const std::string &path) const {
 
 std::vector<std::string>
 StandardPath::locateAll(Type type, const std::string &path) const {
+    FCITX_D();
     std::vector<std::string> retPaths;
     if (isAbsolutePath(path)) {
         if (fs::isreg(path)) {
             retPaths.push_back(path);
         }
     } else {
-        scanDirectories(type,
-                        [&retPaths, &path](const std::string &dirPath, bool) {
-                            auto fullPath = constructPath(dirPath, path);
-                            if (fs::isreg(fullPath)) {
-                                retPaths.push_back(fullPath);
-                            }
-                            return true;
-                        });
+        scanDirectories(
+            type, [d, &retPaths, &path](const std::string &dirPath, bool) {
+                auto fullPath = constructPath(dirPath, path);
+                if (d->cache().isRegularFile(fullPath)) {
+                    retPaths.push_back(fullPath);
+                }
+                return true;
+            });
     }
     return retPaths;
 }
 
 StandardPathFile StandardPath::open(Type type, const std::string &path,
                                     int flags) const {
+    FCITX_D();
+    d->saveQueue().wait(type, &path);
     int retFD = -1;
     std::string fdPath;
     if (isAbsolutePath(path)) {
@@ -496,9 +947,12 @@ StandardPathFile StandardPath::open(Type type, const std::string &path,
             fdPath = path;
         }
     } else {
-        scanDirectories(type, [flags, &retFD, &fdPath,
+        scanDirectories(type, [d, flags, &retFD, &fdPath,
                                &path](const std::string &dirPath, bool) {
             auto fullPath = constructPath(dirPath, path);
+            if (!d->mayOpen(fullPath, flags)) {
+                return true;
+            }
             int fd = ::open(fullPath.c_str(), flags);
             if (fd < 0) {
                 return true;
@@ -513,6 +967,8 @@ StandardPathFile StandardPath::open(Type type, const std::string &path,
 
 StandardPathFile StandardPath::openUser(Type type, const std::string &path,
                                         int flags) const {
+    FCITX_D();
+    d->saveQueue().wait(type, &path);
     std::string fullPath;
     if (isAbsolutePath(path)) {
         fullPath = path;
@@ -540,6 +996,7 @@ StandardPathFile StandardPath::openUser(Type type, const std::string &path,
 
 StandardPathFile StandardPath::openSystem(Type type, const std::string &path,
                                           int flags) const {
+    FCITX_D();
     int retFD = -1;
     std::string fdPath;
     if (isAbsolutePath(path)) {
@@ -549,12 +1006,15 @@ StandardPathFile StandardPath::openSystem(Type type, const std::string &path,
             fdPath = path;
         }
     } else {
-        scanDirectories(type, [flags, &retFD, &fdPath,
+        scanDirectories(type, [d, flags, &retFD, &fdPath,
                                &path](const std::string &dirPath, bool user) {
             if (user) {
                 return true;
             }
             auto fullPath = constructPath(dirPath, path);
+            if (!d->mayOpen(fullPath, flags)) {
+                return true;
+            }
             int fd = ::open(fullPath.c_str(), flags);
             if (fd < 0) {
                 return true;
@@ -570,6 +1030,7 @@ StandardPathFile StandardPath::openSystem(Type type, const std::string &path,
 std::vector<StandardPathFile> StandardPath::openAll(StandardPath::Type type,
                                                     const std::string &path,
                                                     int flags) const {
+    FCITX_D();
     std::vector<StandardPathFile> result;
     if (isAbsolutePath(path)) {
         int fd = ::open(path.c_str(), flags);
@@ -578,8 +1039,11 @@ std::vector<StandardPathFile> StandardPath::openAll(StandardPath::Type type,
         }
     } else {
         scanDirectories(
-            type, [flags, &result, &path](const std::string &dirPath, bool) {
+            type, [d, flags, &result, &path](const std::string &dirPath, bool) {
                 auto fullPath = constructPath(dirPath, path);
+                if (!d->mayOpen(fullPath, flags)) {
+                    return true;
+                }
                 int fd = ::open(fullPath.c_str(), flags);
                 if (fd < 0) {
                     return true;
@@ -621,6 +1085,8 @@ StandardPath::openUserTemp(Type type, const std::string &pathOrig) const {
 bool StandardPath::safeSave(Type type, const std::string &pathOrig,
                             const std::function<bool(int)> &callback) const {
     FCITX_D();
+    // Don't let a queued save overwrite it later.
+    d->saveQueue().wait(type, &pathOrig);
     auto file = openUserTemp(type, pathOrig);
     if (!file.isValid()) {
         return false;
@@ -638,18 +1104,39 @@ bool StandardPath::safeSave(Type type, const std::string &pathOrig,
     return false;
 }
 
+void StandardPath::queueSave(Type type, const std::string &pathOrig,
+                             std::string content) const {
+    FCITX_D();
+    d->saveQueue().queue(this, type, pathOrig, std::move(content));
+}
+
+void StandardPath::flushSaves() const {
+    FCITX_D();
+    d->saveQueue().wait(Type::Config, nullptr);
+}
+
+void StandardPath::setSaveDeferred(bool deferred) const {
+    d_ptr->setSaveDeferred(deferred);
+}
+
+bool StandardPath::isSaveDeferred() const {
+    FCITX_D();
+    return d->isSaveDeferred();
+}
+
 std::map<std::string, std::string> StandardPath::locateWithFilter(
     Type type, const std::string &path,
     std::function<bool(const std::string &path, const std::string &dir,
                        bool user)>
         filter) const {
+    FCITX_D();
     std::map<std::string, std::string> result;
     scanFiles(type, path,
-              [&result, &filter](const std::string &path,
-                                 const std::string &dir, bool isUser) {
+              [d, &result, &filter](const std::string &path,
+                                    const std::string &dir, bool isUser) {
                   if (!result.count(path) && filter(path, dir, isUser)) {
                       auto fullPath = constructPath(dir, path);
-                      if (fs::isreg(fullPath)) {
+                      if (d->cache().isRegularFile(fullPath)) {
                           result.emplace(path, std::move(fullPath));
                       }
                   }
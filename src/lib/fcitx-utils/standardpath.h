@@ -187,7 +187,8 @@ public:
         PkgConfig,
         /// Xdg data dir
         Data,
-        /// Xdg cache dir
+        /// Xdg cache dir, the system directories are read only caches listed
+        /// in FCITX_CACHE_DIRS, if any.
         Cache,
         /// Xdg runtime dir
         Runtime,
@@ -304,6 +305,43 @@ public:
     bool safeSave(Type type, const std::string &pathOrig,
                   const std::function<bool(int)> &callback) const;
 
+    /**
+     * \brief Save the file like safeSave, but in a background thread.
+     *
+     * Files are written one at a time by a single thread, in the order they
+     * are queued. If a file is queued again before it is written, only the
+     * latest content is written. open(), openUser() and safeSave() of a file
+     * that is queued wait for it to be written first, and all the queued
+     * files are written before this StandardPath is destroyed.
+     *
+     * The failure of the actual write is only logged.
+     *
+     * @see flushSaves
+     * @since 5.1.12
+     */
+    void queueSave(Type type, const std::string &pathOrig,
+                   std::string content) const;
+
+    /**
+     * \brief Wait until all the files queued by queueSave are written.
+     *
+     * @since 5.1.12
+     */
+    void flushSaves() const;
+
+    /**
+     * \brief Whether safeSaveAsIni should use queueSave.
+     *
+     * This is enabled by Fcitx, so saving to slow file system does not block
+     * its event loop.
+     *
+     * @since 5.1.12
+     */
+    void setSaveDeferred(bool deferred) const;
+
+    /// @since 5.1.12
+    bool isSaveDeferred() const;
+
     /**
      * \brief Locate all files match the filter under first [directory]/[path].
      *
@@ -17,8 +17,11 @@
 #include <iterator>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#include <fcitx-utils/macros.h>
 #include "fcitxutils_export.h"
 #include "stringutils_details.h"
 
@@ -75,6 +78,121 @@ enum class SplitBehavior { KeepEmpty, SkipEmpty };
 FCITXUTILS_EXPORT std::vector<std::string>
 split(std::string_view str, std::string_view delim, SplitBehavior behavior);
 
+/**
+ * \brief A lazy range of the pieces of a string split by delim.
+ *
+ * It yields the same pieces as split(), but each piece is a std::string_view
+ * to the original string and nothing is allocated. The original string must
+ * outlive the range.
+ *
+ * \see splitView
+ * \since 5.1.12
+ */
+class SplitViewRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view &;
+
+        iterator() = default;
+
+        reference operator*() const { return current_; }
+        pointer operator->() const { return &current_; }
+
+        iterator &operator++() {
+            if (behavior_ == SplitBehavior::SkipEmpty) {
+                lastPos_ = str_.find_first_not_of(delim_, pos_);
+            } else {
+                lastPos_ = pos_ == std::string_view::npos
+                               ? std::string_view::npos
+                               : pos_ + 1;
+            }
+            update();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto old = *this;
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const iterator &other) const {
+            return lastPos_ == other.lastPos_ && pos_ == other.pos_;
+        }
+        bool operator!=(const iterator &other) const {
+            return !operator==(other);
+        }
+
+    private:
+        friend class SplitViewRange;
+
+        iterator(std::string_view str, std::string_view delim,
+                 SplitBehavior behavior)
+            : str_(str), delim_(delim), behavior_(behavior),
+              lastPos_(behavior == SplitBehavior::SkipEmpty
+                           ? str.find_first_not_of(delim)
+                           : 0) {
+            update();
+        }
+
+        void update() {
+            if (lastPos_ == std::string_view::npos) {
+                pos_ = std::string_view::npos;
+                current_ = {};
+                return;
+            }
+            pos_ = str_.find_first_of(delim_, lastPos_);
+            current_ = str_.substr(lastPos_, pos_ - lastPos_);
+        }
+
+        std::string_view str_;
+        std::string_view delim_;
+        SplitBehavior behavior_ = SplitBehavior::SkipEmpty;
+        std::string_view::size_type lastPos_ = std::string_view::npos;
+        std::string_view::size_type pos_ = std::string_view::npos;
+        std::string_view current_;
+    };
+
+    SplitViewRange(std::string_view str, std::string_view delim,
+                   SplitBehavior behavior)
+        : str_(str), delim_(delim), behavior_(behavior) {}
+
+    iterator begin() const { return {str_, delim_, behavior_}; }
+    iterator end() const { return {}; }
+
+private:
+    std::string_view str_;
+    std::string_view delim_;
+    SplitBehavior behavior_;
+};
+
+/**
+ * \brief Split the string by delim without allocation.
+ *
+ * \see split
+ * \since 5.1.12
+ */
+inline SplitViewRange
+splitView(std::string_view str, std::string_view delim,
+          SplitBehavior behavior = SplitBehavior::SkipEmpty) {
+    return {str, delim, behavior};
+}
+
+/**
+ * \brief Split the string by white space, skipping empty pieces.
+ *
+ * \see splitView
+ * \since 5.1.12
+ */
+inline SplitViewRange tokenize(std::string_view str) {
+    return splitView(str, FCITX_WHITESPACE);
+}
+
 /// \brief Replace all substring appearance of before with after.
 FCITXUTILS_EXPORT std::string replaceAll(std::string str,
                                          const std::string &before,
@@ -107,6 +225,23 @@ FCITXUTILS_EXPORT size_t backwardSearch(const std::string &haystack,
 template <typename Iter, typename T>
 FCITXUTILS_EXPORT std::string join(Iter start, Iter end, T &&delim) {
     std::string result;
+    if constexpr (std::is_base_of_v<
+                      std::forward_iterator_tag,
+                      typename std::iterator_traits<Iter>::iterator_category> &&
+                  std::is_convertible_v<decltype(*start), std::string_view> &&
+                  std::is_convertible_v<T, std::string_view>) {
+        // Reserve the result up front if the size is cheap to compute.
+        size_t size = 0;
+        size_t count = 0;
+        for (auto iter = start; iter != end; ++iter) {
+            size += std::string_view(*iter).size();
+            count++;
+        }
+        if (count) {
+            size += (count - 1) * std::string_view(delim).size();
+        }
+        result.reserve(size);
+    }
     if (start != end) {
         result += (*start);
         start++;
@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_TASK_H_
+#define _FCITX_UTILS_TASK_H_
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief Move-only callable with small buffer storage.
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fcitx {
+
+/**
+ * A move-only type erased void() callable.
+ *
+ * Unlike std::function, the callable does not need to be copyable, and
+ * callables up to Task::inlineSize bytes are stored inline without heap
+ * allocation.
+ *
+ * @since 5.1.12
+ */
+class Task {
+    template <typename F>
+    using EnableIfCallable = std::enable_if_t<
+        !std::is_same_v<std::decay_t<F>, Task> &&
+        !std::is_null_pointer_v<std::decay_t<F>> &&
+        std::is_invocable_r_v<void, std::decay_t<F> &>>;
+
+public:
+    static constexpr size_t inlineSize = 56;
+
+    Task() noexcept = default;
+
+    template <typename F, typename = EnableIfCallable<F>>
+    Task(F &&callable) {
+        using Callable = std::decay_t<F>;
+        if constexpr (std::is_pointer_v<Callable> ||
+                      std::is_member_pointer_v<Callable> ||
+                      std::is_same_v<Callable, std::function<void()>>) {
+            if (!callable) {
+                return;
+            }
+        }
+        if constexpr (storedInline<Callable>()) {
+            new (storage_) Callable(std::forward<F>(callable));
+            ops_ = &inlineOps<Callable>;
+        } else {
+            *reinterpret_cast<Callable **>(storage_) =
+                new Callable(std::forward<F>(callable));
+            ops_ = &heapOps<Callable>;
+        }
+    }
+
+    Task(Task &&other) noexcept { moveFrom(other); }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() { reset(); }
+
+    /// Destroy the stored callable.
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    /// Invoke the stored callable, the Task must not be empty.
+    void operator()() { ops_->invoke(storage_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void *storage);
+        // Move construct into dst, and destroy src.
+        void (*relocate)(void *dst, void *src) noexcept;
+        void (*destroy)(void *storage) noexcept;
+    };
+
+    template <typename Callable>
+    static constexpr bool storedInline() {
+        return sizeof(Callable) <= inlineSize &&
+               alignof(Callable) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    template <typename Callable>
+    static Callable *inlineObject(void *storage) {
+        return std::launder(reinterpret_cast<Callable *>(storage));
+    }
+
+    template <typename Callable>
+    static Callable *heapObject(void *storage) {
+        return *reinterpret_cast<Callable **>(storage);
+    }
+
+    template <typename Callable>
+    static constexpr Ops inlineOps = {
+        [](void *storage) { std::invoke(*inlineObject<Callable>(storage)); },
+        [](void *dst, void *src) noexcept {
+            auto *object = inlineObject<Callable>(src);
+            new (dst) Callable(std::move(*object));
+            object->~Callable();
+        },
+        [](void *storage) noexcept {
+            inlineObject<Callable>(storage)->~Callable();
+        }};
+
+    template <typename Callable>
+    static constexpr Ops heapOps = {
+        [](void *storage) { std::invoke(*heapObject<Callable>(storage)); },
+        [](void *dst, void *src) noexcept {
+            *reinterpret_cast<Callable **>(dst) = heapObject<Callable>(src);
+        },
+        [](void *storage) noexcept { delete heapObject<Callable>(storage); }};
+
+    void moveFrom(Task &other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[inlineSize];
+    const Ops *ops_ = nullptr;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_TASK_H_
@@ -5,12 +5,34 @@
  *
  */
 #include "testing.h"
+#include <ftw.h>
+#include <unistd.h>
+#include <cstdio>
 #include <cstdlib>
+#include <string>
 #include "standardpath.h"
 #include "stringutils.h"
 
 namespace fcitx {
 
+namespace {
+
+std::string &testingCacheHome() {
+    static std::string cacheHome;
+    return cacheHome;
+}
+
+void removeTestingCacheHome() {
+    nftw(
+        testingCacheHome().c_str(),
+        [](const char *path, const struct stat *, int, struct FTW *) {
+            return ::remove(path);
+        },
+        16, FTW_DEPTH | FTW_PHYS);
+}
+
+} // namespace
+
 void setupTestingEnvironment(const std::string &testBinaryDir,
                              const std::vector<std::string> &addonDirs,
                              const std::vector<std::string> &dataDirs) {
@@ -37,6 +59,22 @@ void setupTestingEnvironment(const std::string &testBinaryDir,
     setenv("FCITX_DATA_HOME", "/Invalid/Path", 1);
     // Make sure we don't write to user data.
     setenv("FCITX_CONFIG_HOME", "/Invalid/Path", 1);
+    // Metadata snapshots are written to cache, use a temporary one so tests
+    // neither touch nor depend on the user cache.
+    if (testingCacheHome().empty()) {
+        const char *tmpdir = getenv("TMPDIR");
+        std::string cacheHome = stringutils::joinPath(
+            !tmpdir || !tmpdir[0] ? "/tmp" : tmpdir, "fcitx5-test-XXXXXX");
+        if (mkdtemp(cacheHome.data())) {
+            testingCacheHome() = std::move(cacheHome);
+            atexit(removeTestingCacheHome);
+        }
+    }
+    if (!testingCacheHome().empty()) {
+        setenv("XDG_CACHE_HOME", testingCacheHome().c_str(), 1);
+    } else {
+        setenv("XDG_CACHE_HOME", "/Invalid/Path", 1);
+    }
     // Make sure we can find addon files.
     // Path to addon library
     std::vector<std::string> fullDataDirs;
@@ -27,7 +27,8 @@ namespace fcitx {
  * hardcoded installation path.
  * 2. Setup addonDirs, which should point to all the directories of shared
  * library that need to be loaded.
- * 3. Set user path to invalid path to prevent write user data.
+ * 3. Set user path to invalid path to prevent write user data, and user cache
+ * to a temporary directory that is removed on exit.
  * 4. Set up the data dirs, in order to find necessary data files, addon's .conf
  * files, and setup the path to find the testing only addons.
  *
@@ -0,0 +1,163 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_TIMERWHEEL_P_H_
+#define _FCITX_UTILS_TIMERWHEEL_P_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <utility>
+#include "event.h"
+#include "intrusivelist.h"
+#include "trackableobject.h"
+
+namespace fcitx {
+
+class TimerWheel;
+
+enum class TimerWheelSourceState { Disabled = 0, Oneshot = 1, Enabled = 2 };
+
+class TimerWheelSource final : public EventSourceTime,
+                               public IntrusiveListNode,
+                               public TrackableObject<TimerWheelSource> {
+    friend class TimerWheel;
+    friend class TimerWheelSet;
+
+public:
+    TimerWheelSource(TimerWheel *wheel, uint64_t time, uint64_t accuracy,
+                     TimeCallback callback);
+    ~TimerWheelSource() override;
+
+    bool isEnabled() const override {
+        return state_ != TimerWheelSourceState::Disabled;
+    }
+    void setEnabled(bool enabled) override {
+        setState(enabled ? TimerWheelSourceState::Enabled
+                         : TimerWheelSourceState::Disabled);
+    }
+    bool isOneShot() const override {
+        return state_ == TimerWheelSourceState::Oneshot;
+    }
+    void setOneShot() override { setState(TimerWheelSourceState::Oneshot); }
+
+    uint64_t time() const override { return time_; }
+    void setTime(uint64_t time) override;
+    uint64_t accuracy() const override { return accuracy_; }
+    void setAccuracy(uint64_t accuracy) override { accuracy_ = accuracy; }
+    clockid_t clock() const override { return CLOCK_MONOTONIC; }
+
+private:
+    void setState(TimerWheelSourceState state);
+    void setWheel(TimerWheel *wheel);
+    void dispatch();
+
+    TimerWheel *wheel_;
+    uint64_t time_;
+    uint64_t accuracy_;
+    // Tick the timer expires at, rounded up.
+    uint64_t expiry_ = 0;
+    uint32_t level_ = 0;
+    uint32_t slot_ = 0;
+    TimerWheelSourceState state_ = TimerWheelSourceState::Disabled;
+    std::shared_ptr<TimeCallback> callback_;
+};
+
+/**
+ * Hierarchical timer wheel that multiplexes CLOCK_MONOTONIC timers onto a
+ * single backend timer.
+ *
+ * Each level has 64 slots, and slots of level n are 64^n ticks wide. Adding,
+ * removing and rescheduling a timer only relinks it into a slot. Timers in
+ * higher levels are cascaded down when the wheel reaches their slot, so they
+ * still fire with tick precision.
+ */
+class TimerWheel {
+    friend class TimerWheelSource;
+
+public:
+    using NativeTimerFactory = std::function<std::unique_ptr<EventSourceTime>(
+        uint64_t usec, TimeCallback callback)>;
+
+    static constexpr uint64_t tickUsec = 1000;
+
+    explicit TimerWheel(NativeTimerFactory factory);
+    ~TimerWheel();
+
+    // Whether a timer requested with clock and accuracy can be served by the
+    // wheel without losing precision.
+    static bool isCompatible(clockid_t clock, uint64_t accuracy) {
+        return clock == CLOCK_MONOTONIC &&
+               (accuracy == 0 || accuracy >= tickUsec);
+    }
+
+    std::unique_ptr<EventSourceTime> addTimer(uint64_t usec, uint64_t accuracy,
+                                              TimeCallback callback);
+
+private:
+    static constexpr uint32_t slotBits = 6;
+    static constexpr uint32_t slotsPerLevel = 1 << slotBits;
+    static constexpr uint32_t slotMask = slotsPerLevel - 1;
+    static constexpr uint32_t levels = 6;
+    static constexpr uint64_t noTick = UINT64_MAX;
+
+    using SlotList = IntrusiveList<TimerWheelSource>;
+
+    void schedule(TimerWheelSource *source);
+    void insert(TimerWheelSource *source);
+    void unlink(TimerWheelSource *source);
+    void cascade(uint32_t level, uint32_t slot);
+    uint64_t nextTick() const;
+    void process(uint64_t usec);
+    void rearm();
+
+    std::array<std::array<SlotList, slotsPerLevel>, levels> slots_;
+    std::array<uint64_t, levels> occupied_{};
+    // Timers due in current process(), in the order they are fired.
+    SlotList expired_;
+    // Next tick that is not processed yet.
+    uint64_t current_;
+    // Tick the backend timer is armed at.
+    uint64_t armedTick_ = noTick;
+    size_t size_ = 0;
+    bool processing_ = false;
+    NativeTimerFactory factory_;
+    std::unique_ptr<EventSourceTime> native_;
+};
+
+/**
+ * One TimerWheel for each EventPriority.
+ *
+ * The native timer of a wheel is created with the priority of the wheel, and
+ * changing the priority of a timer moves it to another wheel.
+ */
+class TimerWheelSet {
+public:
+    using NativeTimerFactory = std::function<std::unique_ptr<EventSourceTime>(
+        EventPriority priority, uint64_t usec, TimeCallback callback)>;
+
+    explicit TimerWheelSet(NativeTimerFactory factory)
+        : factory_(std::move(factory)) {}
+
+    TimerWheel &wheel(EventPriority priority = EventPriority::Default);
+
+    // Return false if source is not a timer of the wheels.
+    bool setPriority(EventSource *source, EventPriority priority);
+
+    // Destroy all the wheels, along with their native timers.
+    void clear();
+
+private:
+    NativeTimerFactory factory_;
+    std::array<std::unique_ptr<TimerWheel>, 3> wheels_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_TIMERWHEEL_P_H_
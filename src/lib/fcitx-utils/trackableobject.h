@@ -12,7 +12,9 @@
 /// \file
 /// \brief Utitliy classes for statically tracking the life of a object.
 
+#include <cstddef>
 #include <memory>
+#include <utility>
 #include <fcitx-utils/handlertable.h>
 #include <fcitx-utils/macros.h>
 
@@ -85,6 +87,129 @@ public:
 private:
     std::unique_ptr<std::shared_ptr<bool>> self_;
 };
+
+template <typename T>
+class LocalTrackableObject;
+
+namespace details {
+
+// Shared by a LocalTrackableObject and its references, freed by whichever
+// goes last.
+struct LocalTrackableState {
+    size_t refs = 1;
+    bool alive = true;
+};
+
+} // namespace details
+
+/// \brief Weak reference to a LocalTrackableObject.
+///
+/// Same as TrackableObjectReference, but copying it does not involve any
+/// atomic operation. It must only be used on the thread that owns the object.
+///
+/// \since 5.1.12
+template <typename T>
+class LocalTrackableObjectReference final {
+    friend class LocalTrackableObject<std::remove_const_t<T>>;
+
+public:
+    LocalTrackableObjectReference() = default;
+    LocalTrackableObjectReference(const LocalTrackableObjectReference &other)
+        : state_(other.state_), rawThat_(other.rawThat_) {
+        ref();
+    }
+    LocalTrackableObjectReference(LocalTrackableObjectReference &&other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          rawThat_(std::exchange(other.rawThat_, nullptr)) {}
+    ~LocalTrackableObjectReference() { unref(); }
+
+    LocalTrackableObjectReference &
+    operator=(const LocalTrackableObjectReference &other) {
+        if (this != &other) {
+            LocalTrackableObjectReference copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+    LocalTrackableObjectReference &
+    operator=(LocalTrackableObjectReference &&other) noexcept {
+        if (this != &other) {
+            unref();
+            state_ = std::exchange(other.state_, nullptr);
+            rawThat_ = std::exchange(other.rawThat_, nullptr);
+        }
+        return *this;
+    }
+
+    /// \brief Check if the reference is still valid.
+    bool isValid() const { return state_ && state_->alive; }
+
+    /// \brief Check if the reference is not tracking anything.
+    bool isNull() const { return rawThat_ == nullptr; }
+
+    /// \brief Get the referenced object. Return nullptr if it is not available.
+    T *get() const { return isValid() ? rawThat_ : nullptr; }
+
+    /// \brief Reset reference to empty state.
+    void unwatch() {
+        unref();
+        state_ = nullptr;
+        rawThat_ = nullptr;
+    }
+
+private:
+    LocalTrackableObjectReference(details::LocalTrackableState *state,
+                                  T *rawThat)
+        : state_(state), rawThat_(rawThat) {
+        ref();
+    }
+
+    void ref() {
+        if (state_) {
+            ++state_->refs;
+        }
+    }
+    void unref() {
+        if (state_ && --state_->refs == 0) {
+            delete state_;
+        }
+    }
+
+    details::LocalTrackableState *state_ = nullptr;
+    T *rawThat_ = nullptr;
+};
+
+/// \brief Single thread variant of TrackableObject.
+///
+/// Use it for the objects only accessed from one thread, e.g. the ones
+/// living on the main event loop. TrackableObject is still needed if the
+/// reference is passed to another thread.
+/// \see LocalTrackableObjectReference
+/// \since 5.1.12
+template <typename T>
+class LocalTrackableObject {
+public:
+    LocalTrackableObject() : state_(new details::LocalTrackableState) {}
+    LocalTrackableObject(const LocalTrackableObject &) = delete;
+    virtual ~LocalTrackableObject() {
+        state_->alive = false;
+        if (--state_->refs == 0) {
+            delete state_;
+        }
+    }
+
+    LocalTrackableObjectReference<T> watch() {
+        return LocalTrackableObjectReference<T>(state_, static_cast<T *>(this));
+    }
+
+    LocalTrackableObjectReference<const T> watch() const {
+        return LocalTrackableObjectReference<const T>(
+            state_, static_cast<const T *>(this));
+    }
+
+private:
+    details::LocalTrackableState *state_;
+};
 } // namespace fcitx
 
 #endif // _FCITX_UTILS_TRACKABLEOBJECT_H_
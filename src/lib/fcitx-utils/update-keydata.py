@@ -6,8 +6,8 @@ license = """/*
  * SPDX-FileCopyrightText: 2015~2015 CSSlayer <wengxt@gmail.com>
  *
  * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
  */
-
 """
 
 def header(content, guard_var):
@@ -15,13 +15,12 @@ def header(content, guard_var):
 
 def header_guard(content, guard_var):
     return """
-
 #ifndef {0}
 #define {0}
-
 {1}
 
-#endif""".format(guard_var, content)
+#endif
+""".format(guard_var, content)
 
 keysymdef = ""
 keynametable = ""
@@ -48,11 +47,12 @@ for (i, (name, value, comment)) in enumerate(sorted(data, key=lambda n: n[0] )):
         valueToOffset[value] = i
 
 keysymdef = """
+
 #include <fcitx-utils/macros.h>
 
 FCITX_C_DECL_BEGIN
 
-typedef enum _FcitxKeySym
+typedef enum _FcitxKeySym // NOLINT(modernize-use-using)
 {{
 {0}
 }} FcitxKeySym;
@@ -64,6 +64,7 @@ f.write(header(keysymdef, "_FCITX_UTILS_KEYSYMGEN_H_"))
 f.close()
 
 keynametable = """
+#include <cstdint>
 #include <fcitx-utils/macros.h>
 
 FCITX_C_DECL_BEGIN
@@ -93,3 +94,98 @@ FCITX_C_DECL_END
 f = open("keynametable.h" ,"w")
 f.write(header(keynametable, "_FCITX_UTILS_KEYNAMETABLE_H_"))
 f.close()
+
+# Minimal perfect hash of both directions, using hash and displace.
+# Must be kept in sync with keyNameHash and keySymHash in key.cpp.
+def fnv1a(data, seed):
+    h = (2166136261 ^ seed) & 0xffffffff
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+def name_hash(name, seed):
+    return fnv1a(name.encode("utf-8"), seed)
+
+def sym_hash(sym, seed):
+    return fnv1a(sym.to_bytes(4, "little"), seed)
+
+def perfect_hash(keys, hash_func):
+    size = len(keys)
+    buckets = [[] for _ in range(size)]
+    for (i, key) in enumerate(keys):
+        buckets[hash_func(key, 0) % size].append(i)
+
+    displacement = [0] * size
+    slots = [None] * size
+    for b in sorted(range(size), key=lambda b: -len(buckets[b])):
+        bucket = buckets[b]
+        if len(bucket) <= 1:
+            break
+        d = 1
+        while True:
+            candidate = [hash_func(keys[i], d) % size for i in bucket]
+            if (len(set(candidate)) == len(candidate) and
+                    all(slots[s] is None for s in candidate)):
+                break
+            d += 1
+        displacement[b] = d
+        for (i, s) in zip(bucket, candidate):
+            slots[s] = i
+
+    # Buckets with a single key take a free slot directly.
+    free = [s for s in range(size) if slots[s] is None]
+    for b in range(size):
+        if len(buckets[b]) == 1:
+            s = free.pop()
+            displacement[b] = -s - 1
+            slots[s] = buckets[b][0]
+    return displacement, [s if s is not None else 0 for s in slots]
+
+nameDisplacement, nameSlots = perfect_hash(nameList, name_hash)
+symList = sorted(valueToOffset.keys(), key=lambda n: int(n, 16))
+symDisplacement, symSlots = perfect_hash([int(s, 16) for s in symList],
+                                         sym_hash)
+
+def format_list(items):
+    return ",\n".join(str(s) for s in items)
+
+keynametablehash = """
+#include <cstdint>
+#include <fcitx-utils/macros.h>
+
+// Generated by update-keydata.py, see keyNameHash and keySymHash in key.cpp.
+
+FCITX_C_DECL_BEGIN
+
+// Displacement of keyNameList hash buckets.
+static const int32_t keyNameHashDisplacement[] _FCITX_UNUSED_ =
+{{
+{0}
+}};
+
+// Index in keyNameList of each hash slot.
+static const uint16_t keyNameHashSlot[] _FCITX_UNUSED_ =
+{{
+{1}
+}};
+
+// Displacement of keyNameOffsetByValue hash buckets.
+static const int32_t keySymHashDisplacement[] _FCITX_UNUSED_ =
+{{
+{2}
+}};
+
+// Index in keyNameOffsetByValue of each hash slot.
+static const uint16_t keySymHashSlot[] _FCITX_UNUSED_ =
+{{
+{3}
+}};
+
+FCITX_C_DECL_END
+""".format(format_list(nameDisplacement), format_list(nameSlots),
+           format_list(symDisplacement), format_list(symSlots))
+
+f = open("keynametable-hash.h", "w")
+f.write(header(keynametablehash, "_FCITX_UTILS_KEYNAMETABLE_HASH_H_"))
+f.close()
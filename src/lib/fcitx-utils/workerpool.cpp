@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include "workerpool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "eventdispatcher.h"
+#include "macros.h"
+#include "task.h"
+
+namespace fcitx {
+
+namespace {
+
+// Background work rarely benefits from more threads than this.
+constexpr size_t defaultMaxThreads = 4;
+
+} // namespace
+
+class WorkerPoolPrivate {
+public:
+    WorkerPoolPrivate(EventDispatcher *dispatcher, size_t maxThreads)
+        : dispatcher_(dispatcher), maxThreads_(maxThreads) {
+        if (!maxThreads_) {
+            maxThreads_ = std::clamp<size_t>(
+                std::thread::hardware_concurrency(), 1, defaultMaxThreads);
+        }
+    }
+
+    size_t prefetchLimit() const {
+        return maxThreads_ > 1 ? maxThreads_ - 1 : 1;
+    }
+
+    // Called with mutex_ held, return an empty task if there is nothing to
+    // run right now.
+    Task takeWork(bool &prefetch) {
+        Task task;
+        if (!interactive_.empty()) {
+            task = std::move(interactive_.front());
+            interactive_.pop_front();
+            prefetch = false;
+        } else if (!prefetch_.empty() && runningPrefetch_ < prefetchLimit()) {
+            task = std::move(prefetch_.front());
+            prefetch_.pop_front();
+            runningPrefetch_++;
+            prefetch = true;
+        }
+        return task;
+    }
+
+    void worker() {
+        std::unique_lock lock(mutex_);
+        while (!exit_) {
+            bool prefetch = false;
+            auto task = takeWork(prefetch);
+            if (!task) {
+                idle_++;
+                condition_.wait(lock);
+                idle_--;
+                continue;
+            }
+            running_++;
+            lock.unlock();
+            task();
+            // Destroy captured state outside of the lock as well.
+            task = Task();
+            lock.lock();
+            running_--;
+            if (prefetch) {
+                runningPrefetch_--;
+                if (!prefetch_.empty()) {
+                    condition_.notify_one();
+                }
+            }
+        }
+    }
+
+    EventDispatcher *dispatcher_;
+    size_t maxThreads_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Task> interactive_;
+    std::deque<Task> prefetch_;
+    std::vector<std::thread> threads_;
+    size_t idle_ = 0;
+    size_t running_ = 0;
+    size_t runningPrefetch_ = 0;
+    bool exit_ = false;
+};
+
+WorkerPool::WorkerPool(EventDispatcher *dispatcher, size_t maxThreads)
+    : d_ptr(std::make_unique<WorkerPoolPrivate>(dispatcher, maxThreads)) {}
+
+WorkerPool::~WorkerPool() {
+    FCITX_D();
+    std::deque<Task> interactive;
+    std::deque<Task> prefetch;
+    {
+        std::lock_guard lock(d->mutex_);
+        d->exit_ = true;
+        interactive = std::move(d->interactive_);
+        prefetch = std::move(d->prefetch_);
+    }
+    d->condition_.notify_all();
+    for (auto &thread : d->threads_) {
+        thread.join();
+    }
+}
+
+size_t WorkerPool::maxThreads() const {
+    FCITX_D();
+    return d->maxThreads_;
+}
+
+size_t WorkerPool::pending() const {
+    FCITX_D();
+    std::lock_guard lock(d->mutex_);
+    return d->interactive_.size() + d->prefetch_.size() + d->running_;
+}
+
+void WorkerPool::run(WorkPriority priority, Task work) {
+    FCITX_D();
+    if (!work) {
+        return;
+    }
+    std::lock_guard lock(d->mutex_);
+    if (priority == WorkPriority::Interactive) {
+        d->interactive_.push_back(std::move(work));
+    } else {
+        d->prefetch_.push_back(std::move(work));
+    }
+    if (d->idle_) {
+        d->condition_.notify_one();
+    } else if (d->threads_.size() < d->maxThreads_) {
+        d->threads_.emplace_back([d]() { d->worker(); });
+    }
+}
+
+EventDispatcher *WorkerPool::dispatcher() const {
+    FCITX_D();
+    return d->dispatcher_;
+}
+
+} // namespace fcitx
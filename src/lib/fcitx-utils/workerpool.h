@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_WORKERPOOL_H_
+#define _FCITX_UTILS_WORKERPOOL_H_
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief Worker threads that return results to an event loop.
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <fcitx-utils/eventdispatcher.h>
+#include <fcitx-utils/macros.h>
+#include <fcitx-utils/task.h>
+#include <fcitx-utils/trackableobject.h>
+#include "fcitxutils_export.h"
+
+namespace fcitx {
+
+/**
+ * Priority of the work sent to WorkerPool.
+ *
+ * @since 5.1.12
+ */
+enum class WorkPriority {
+    /// Someone is waiting for the result, e.g. candidates of current input.
+    Interactive,
+    /// Result may be useful later, e.g. loading data in advance.
+    Prefetch,
+};
+
+class WorkerPoolPrivate;
+
+/**
+ * A bounded pool of worker threads.
+ *
+ * Threads are started on demand, up to maxThreads(). Interactive work is
+ * always picked before prefetch work, and prefetch work never occupies all
+ * the threads, so there is always one left for interactive work.
+ *
+ * Continuations run on the event loop that dispatcher is attached to, and
+ * only if the context object is still alive. Work that is not started yet is
+ * dropped when the pool is destroyed, and the running work is waited for.
+ *
+ * @since 5.1.12
+ */
+class FCITXUTILS_EXPORT WorkerPool {
+public:
+    /**
+     * Create a pool.
+     *
+     * @param dispatcher dispatcher to run continuations, must outlive the pool
+     * @param maxThreads max number of threads, 0 to choose from the number of
+     * CPUs.
+     */
+    explicit WorkerPool(EventDispatcher *dispatcher, size_t maxThreads = 0);
+    ~WorkerPool();
+
+    size_t maxThreads() const;
+
+    /// Number of work that is either queued or running.
+    size_t pending() const;
+
+    /// Run work on a worker thread.
+    void run(WorkPriority priority, Task work);
+
+    /**
+     * Run work on a worker thread, then call then with its result on the
+     * event loop.
+     *
+     * The work is skipped if context is already gone when it is started, and
+     * then is only called if context is still alive. work must not access
+     * context, since it may be destroyed at any time on the event loop.
+     *
+     * @param priority priority of the work
+     * @param context context object, usually the one that calls run
+     * @param work callable with no argument, run on a worker thread
+     * @param then callable that takes the result of work if it is not void
+     */
+    template <typename T, typename Work, typename Then>
+    void run(WorkPriority priority, TrackableObjectReference<T> context,
+             Work work, Then then) {
+        run(priority, [dispatcher = dispatcher(), context = std::move(context),
+                       work = std::move(work),
+                       then = std::move(then)]() mutable {
+            if (!context.isValid()) {
+                return;
+            }
+            if constexpr (std::is_void_v<std::invoke_result_t<Work &>>) {
+                work();
+                dispatcher->scheduleWithContext(std::move(context),
+                                                std::move(then));
+            } else {
+                dispatcher->scheduleWithContext(
+                    std::move(context),
+                    [then = std::move(then), result = work()]() mutable {
+                        then(std::move(result));
+                    });
+            }
+        });
+    }
+
+    EventDispatcher *dispatcher() const;
+
+private:
+    const std::unique_ptr<WorkerPoolPrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(WorkerPool);
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_WORKERPOOL_H_
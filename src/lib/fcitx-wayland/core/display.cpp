@@ -8,6 +8,7 @@
 #include "display.h"
 #include <errno.h>
 #include <poll.h>
+#include <algorithm>
 #include "wl_output.h"
 #include "wl_registry.h"
 
@@ -132,9 +133,22 @@ Display::outputInformation(wayland::WlOutput *output) const {
 void Display::addOutput(wayland::WlOutput *output) {
     outputInfo_.emplace(std::piecewise_construct, std::forward_as_tuple(output),
                         std::forward_as_tuple(output));
+    // Connected after OutputInfomation, so it sees the updated information.
+    outputDoneConns_.emplace(
+        output, output->done().connect([this]() { updateMaxOutputScale(); }));
 }
 
 void Display::removeOutput(wayland::WlOutput *output) {
+    outputDoneConns_.erase(output);
     outputInfo_.erase(output);
+    updateMaxOutputScale();
+}
+
+void Display::updateMaxOutputScale() {
+    int32_t scale = 1;
+    for (const auto &[output, info] : outputInfo_) {
+        scale = std::max(scale, info.scale());
+    }
+    maxOutputScale_ = scale;
 }
 } // namespace fcitx::wayland
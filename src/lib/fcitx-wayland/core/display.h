@@ -64,6 +64,9 @@ public:
 
     const OutputInfomation *outputInformation(WlOutput *output) const;
 
+    /// Largest scale of all outputs, updated when an output changes.
+    int32_t maxOutputScale() const { return maxOutputScale_; }
+
     template <typename T>
     std::vector<std::shared_ptr<T>> getGlobals() {
         auto iter = requestedGlobals_.find(T::interface);
@@ -130,6 +133,7 @@ private:
 
     void addOutput(wayland::WlOutput *output);
     void removeOutput(wayland::WlOutput *output);
+    void updateMaxOutputScale();
 
     fcitx::Signal<void(const std::string &, std::shared_ptr<void>)>
         globalCreatedSignal_;
@@ -144,6 +148,8 @@ private:
         globals_;
     std::list<fcitx::Connection> conns_;
     std::unordered_map<WlOutput *, OutputInfomation> outputInfo_;
+    std::unordered_map<WlOutput *, ScopedConnection> outputDoneConns_;
+    int32_t maxOutputScale_ = 1;
 };
 } // namespace wayland
 } // namespace fcitx
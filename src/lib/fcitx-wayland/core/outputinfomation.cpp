@@ -20,7 +20,7 @@ public:
     std::string make_;
     std::string model_;
     wl_output_transform transform_;
-    int32_t scale_;
+    int32_t scale_ = 1;
 };
 
 class OutputInfomationPrivate {
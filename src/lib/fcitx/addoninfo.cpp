@@ -16,9 +16,11 @@
 #include "fcitx-config/option.h"
 #include "fcitx-config/rawconfig.h"
 #include "fcitx-utils/i18nstring.h"
+#include "fcitx-utils/key.h"
 #include "fcitx-utils/macros.h"
 #include "fcitx-utils/semver.h"
 #include "fcitx-utils/stringutils.h"
+#include "stringpool_p.h"
 namespace fcitx {
 
 FCITX_CONFIGURATION(
@@ -37,7 +39,16 @@ FCITX_CONFIGURATION(
     Option<bool> onDemand{this, "OnDemand", "Load only on request", false};
     Option<int> uiPriority{this, "UIPriority", "User interface priority", 0};
     Option<UIType> uiType{this, "UIType", "User interface type",
-                          UIType::PhyscialKeyboard};)
+                          UIType::PhyscialKeyboard};
+    Option<KeyList> triggerKeys{this, "TriggerKeys", "Keys that load addon"};
+    Option<std::vector<std::string>> triggerKeysConfig{
+        this, "TriggerKeysConfig", "Options that override trigger keys"};
+    Option<std::vector<std::string>> triggerInputMethods{
+        this, "TriggerInputMethods", "Input methods that load addon"};
+    Option<std::vector<std::string>> triggerDBusNames{
+        this, "TriggerDBusNames", "DBus names that load addon"};
+    Option<bool> prewarm{this, "Prewarm", "Load when idle after startup",
+                         false};)
 
 FCITX_CONFIGURATION(AddonConfig,
                     Option<AddonConfigBase> addon{this, "Addon", "Addon"};)
@@ -69,10 +80,11 @@ void parseDependencies(const std::vector<std::string> &data,
 
 class AddonInfoPrivate : public AddonConfig {
 public:
-    AddonInfoPrivate(std::string name) : uniqueName_(std::move(name)) {}
+    AddonInfoPrivate(const std::string &name)
+        : uniqueName_(internString(name)) {}
 
     bool valid_ = false;
-    std::string uniqueName_;
+    const std::string &uniqueName_;
     OverrideEnabled overrideEnabled_ = OverrideEnabled::NotSet;
     std::vector<std::string> dependencies_;
     std::vector<std::string> optionalDependencies_;
@@ -149,6 +161,31 @@ bool AddonInfo::onDemand() const {
     return d->addon->onDemand.value();
 }
 
+const KeyList &AddonInfo::triggerKeys() const {
+    FCITX_D();
+    return *d->addon->triggerKeys;
+}
+
+const std::vector<std::string> &AddonInfo::triggerKeysConfig() const {
+    FCITX_D();
+    return *d->addon->triggerKeysConfig;
+}
+
+const std::vector<std::string> &AddonInfo::triggerInputMethods() const {
+    FCITX_D();
+    return *d->addon->triggerInputMethods;
+}
+
+const std::vector<std::string> &AddonInfo::triggerDBusNames() const {
+    FCITX_D();
+    return *d->addon->triggerDBusNames;
+}
+
+bool AddonInfo::prewarm() const {
+    FCITX_D();
+    return *d->addon->prewarm;
+}
+
 int AddonInfo::uiPriority() const {
     FCITX_D();
     return d->addon->uiPriority.value();
@@ -14,6 +14,7 @@
 #include <fcitx-config/enum.h>
 #include <fcitx-config/rawconfig.h>
 #include <fcitx-utils/i18nstring.h>
+#include <fcitx-utils/key.h>
 #include <fcitx-utils/macros.h>
 #include <fcitx-utils/semver.h>
 #include "fcitxcore_export.h"
@@ -47,6 +48,45 @@ public:
     const std::vector<std::tuple<std::string, SemanticVersion>> &
     optionalDependenciesWithVersion() const;
     bool onDemand() const;
+    /**
+     * Keys that load an on demand addon when pressed.
+     *
+     * Used when no option listed in triggerKeysConfig is set in the user
+     * configuration or has its own default keys.
+     *
+     * @since 5.1.12
+     */
+    const KeyList &triggerKeys() const;
+    /**
+     * Key list options that override triggerKeys, in the form of
+     * "conf/addon.conf:Option/Path" or "conf/addon.conf:Option/Path=Keys".
+     *
+     * An option that is not set in the user configuration uses its own
+     * default keys if given, so each option falls back independently.
+     *
+     * @since 5.1.12
+     */
+    const std::vector<std::string> &triggerKeysConfig() const;
+    /**
+     * Input methods that load an on demand addon when activated.
+     *
+     * @since 5.1.12
+     */
+    const std::vector<std::string> &triggerInputMethods() const;
+    /**
+     * DBus names that load an on demand addon when they appear on the
+     * session bus. Handled by the dbus module.
+     *
+     * @since 5.1.12
+     */
+    const std::vector<std::string> &triggerDBusNames() const;
+    /**
+     * Whether an on demand addon should be loaded once fcitx is idle after
+     * startup.
+     *
+     * @since 5.1.12
+     */
+    bool prewarm() const;
     int uiPriority() const;
     UIType uiType() const;
     bool isEnabled() const;
@@ -6,6 +6,9 @@
  */
 
 #include "addoninstance.h"
+#include <cstddef>
+#include <functional>
+#include <utility>
 #include "addoninstance_p.h"
 
 namespace fcitx {
@@ -44,4 +47,40 @@ bool AddonInstance::canRestart() const {
     return d->canRestart_;
 }
 
+void AddonInstance::setMemoryUsageCallback(std::function<size_t()> callback) {
+    FCITX_D();
+    d->memoryUsageCallback_ = std::move(callback);
+}
+
+size_t AddonInstance::memoryUsage() const {
+    FCITX_D();
+    return d->memoryUsageCallback_ ? d->memoryUsageCallback_() : 0;
+}
+
+void AddonInstance::setTrimMemoryCallback(
+    std::function<void(MemoryTrimLevel)> callback) {
+    FCITX_D();
+    d->trimMemoryCallback_ = std::move(callback);
+}
+
+void AddonInstance::trimMemory(MemoryTrimLevel level) {
+    FCITX_D();
+    if (d->trimMemoryCallback_) {
+        d->trimMemoryCallback_(level);
+    }
+}
+
+void AddonInstance::setPrewarmCallback(
+    std::function<void(const InputMethodEntry &)> callback) {
+    FCITX_D();
+    d->prewarmCallback_ = std::move(callback);
+}
+
+void AddonInstance::prewarm(const InputMethodEntry &entry) {
+    FCITX_D();
+    if (d->prewarmCallback_) {
+        d->prewarmCallback_(entry);
+    }
+}
+
 } // namespace fcitx
@@ -7,6 +7,7 @@
 #ifndef _FCITX_ADDONINSTANCE_H_
 #define _FCITX_ADDONINSTANCE_H_
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <fcitx-config/configuration.h>
@@ -23,6 +24,22 @@
 namespace fcitx {
 
 class AddonManagerPrivate;
+class InputMethodEntry;
+
+/**
+ * How much memory an addon is asked to give back.
+ *
+ * @see AddonInstance::setTrimMemoryCallback
+ * @since 5.1.12
+ */
+enum class MemoryTrimLevel {
+    /// There is no input for a while, drop the caches that are cheap to
+    /// rebuild.
+    Idle,
+    /// The system is low on memory, drop everything that can be rebuilt on
+    /// next use.
+    Pressure,
+};
 
 /// \brief Base class for any addon in fcitx.
 /// To implement addon in fcitx, you will need to create a sub class for this
@@ -132,6 +149,39 @@ public:
      */
     bool canRestart() const;
 
+    /**
+     * Return the approximate memory used by the main data of this addon.
+     *
+     * The value is only as accurate as the addon reports, and 0 if the addon
+     * does not report it.
+     *
+     * @see AddonInstance::setMemoryUsageCallback
+     * @since 5.1.12
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * Ask this addon to release the memory of its caches.
+     *
+     * Usually called by Instance::trimMemory.
+     *
+     * @see AddonInstance::setTrimMemoryCallback
+     * @since 5.1.12
+     */
+    void trimMemory(MemoryTrimLevel level);
+
+    /**
+     * Ask this input method engine to load what the input method needs
+     * before it is activated.
+     *
+     * Usually called by Instance when fcitx is idle, for the input methods
+     * that are likely to be switched to next.
+     *
+     * @see AddonInstance::setPrewarmCallback
+     * @since 5.1.12
+     */
+    void prewarm(const InputMethodEntry &entry);
+
 protected:
     /**
      * Set if this addon can safely restart.
@@ -151,6 +201,45 @@ protected:
      */
     void setCanRestart(bool canRestart);
 
+    /**
+     * Set the function that estimates the memory used by this addon.
+     *
+     * It is only called on demand, e.g. from the DBus controller, so it may
+     * walk over the data, but should count the big structures only, e.g.
+     * history or dictionary, rather than trying to be exact.
+     *
+     * @param callback returns the memory usage in bytes
+     * @see AddonInstance::memoryUsage
+     * @since 5.1.12
+     */
+    void setMemoryUsageCallback(std::function<size_t()> callback);
+
+    /**
+     * Set the function that releases the caches of this addon.
+     *
+     * It is only called from the event loop, so no code of the addon is
+     * running at the same time. The data dropped must be rebuilt on demand.
+     *
+     * @param callback takes the level of trimming
+     * @see AddonInstance::trimMemory
+     * @since 5.1.12
+     */
+    void setTrimMemoryCallback(std::function<void(MemoryTrimLevel)> callback);
+
+    /**
+     * Set the function that loads the data of an input method ahead of its
+     * activation, e.g. its dictionary.
+     *
+     * It is only called from the event loop during idle time, and should not
+     * load anything that the trim memory callback would drop right away.
+     *
+     * @param callback takes the entry of the input method
+     * @see AddonInstance::prewarm
+     * @since 5.1.12
+     */
+    void setPrewarmCallback(
+        std::function<void(const InputMethodEntry &)> callback);
+
 private:
     AddonFunctionAdaptorBase *findCall(const std::string &name);
     std::unique_ptr<AddonInstancePrivate> d_ptr;
@@ -7,6 +7,8 @@
 #ifndef _FCITX_ADDONINSTANCE_P_H_
 #define _FCITX_ADDONINSTANCE_P_H_
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include "addoninfo.h"
@@ -19,6 +21,9 @@ public:
     std::unordered_map<std::string, AddonFunctionAdaptorBase *> callbackMap_;
     const AddonInfo *addonInfo_ = nullptr;
     bool canRestart_ = true;
+    std::function<size_t()> memoryUsageCallback_;
+    std::function<void(MemoryTrimLevel)> trimMemoryCallback_;
+    std::function<void(const InputMethodEntry &)> prewarmCallback_;
 };
 
 } // namespace fcitx
@@ -5,10 +5,16 @@
  *
  */
 
+#include <fcntl.h>
+#include <string>
+#include <vector>
 #include "fcitx-utils/library.h"
 #include "fcitx-utils/log.h"
+#include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/unixfd.h"
 #include "addonloader_p.h"
 #include "config.h"
+#include "startuptimeline_p.h"
 
 namespace fcitx {
 
@@ -16,22 +22,52 @@ AddonLoader::~AddonLoader() {}
 
 SharedLibraryLoader::~SharedLibraryLoader() {}
 
+std::vector<std::string>
+SharedLibraryLoader::libraryPaths(const AddonInfo &info,
+                                  Flags<LibraryLoadHint> *flag) const {
+    std::string libname = info.library();
+    if (stringutils::startsWith(libname, "export:")) {
+        libname = libname.substr(7);
+        if (flag) {
+            *flag |= LibraryLoadHint::ExportExternalSymbolsHint;
+        }
+    }
+    return standardPath_.locateAll(StandardPath::Type::Addon,
+                                   libname + FCITX_LIBRARY_SUFFIX);
+}
+
+void SharedLibraryLoader::prefetch(const AddonInfo &info) {
+    if (registry_.count(info.uniqueName())) {
+        return;
+    }
+    auto libs = libraryPaths(info, nullptr);
+    if (libs.empty()) {
+        return;
+    }
+    // Only the first one is likely to be used. The read ahead is done
+    // asynchronously by the kernel, so this does not block.
+    UnixFD fd = UnixFD::own(open(libs.front().c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.isValid()) {
+#ifdef POSIX_FADV_WILLNEED
+        posix_fadvise(fd.fd(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    }
+}
+
 AddonInstance *SharedLibraryLoader::load(const AddonInfo &info,
                                          AddonManager *manager) {
     auto iter = registry_.find(info.uniqueName());
     if (iter == registry_.end()) {
-        std::string libname = info.library();
         Flags<LibraryLoadHint> flag = LibraryLoadHint::DefaultHint;
-        if (stringutils::startsWith(libname, "export:")) {
-            libname = libname.substr(7);
-            flag |= LibraryLoadHint::ExportExternalSymbolsHint;
-        }
-        auto file = libname + FCITX_LIBRARY_SUFFIX;
-        auto libs = standardPath_.locateAll(StandardPath::Type::Addon, file);
+        auto libs = libraryPaths(info, &flag);
         if (libs.empty()) {
-            FCITX_ERROR() << "Could not locate library " << file
-                          << " for addon " << info.uniqueName() << ".";
+            FCITX_ERROR() << "Could not locate library " << info.library()
+                          << FCITX_LIBRARY_SUFFIX << " for addon "
+                          << info.uniqueName() << ".";
         }
+        // Separate the time of dlopen and relocation from the creation of
+        // the addon in startup timeline.
+        StartupPhase phase(stringutils::concat("Library/", info.uniqueName()));
         for (const auto &libraryPath : libs) {
             Library lib(libraryPath);
             if (!lib.load(flag)) {
@@ -45,6 +81,9 @@ AddonInstance *SharedLibraryLoader::load(const AddonInfo &info,
                     info.uniqueName(),
                     std::make_unique<SharedLibraryFactory>(std::move(lib)));
             } catch (const std::exception &e) {
+                FCITX_ERROR() << "Failed to get factory for addon "
+                              << info.uniqueName() << " on " << libraryPath
+                              << ". Error: " << e.what();
             }
             break;
         }
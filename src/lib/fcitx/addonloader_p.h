@@ -8,6 +8,8 @@
 #define _FCITX_ADDONLOADER_P_H_
 
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include "fcitx-utils/library.h"
 #include "fcitx-utils/standardpath.h"
 #include "addonfactory.h"
@@ -45,7 +47,13 @@ public:
 
     std::string type() const override { return "SharedLibrary"; }
 
+    // Start reading the library of the addon into page cache in background.
+    void prefetch(const AddonInfo &info);
+
 private:
+    std::vector<std::string> libraryPaths(const AddonInfo &info,
+                                          Flags<LibraryLoadHint> *flag) const;
+
     StandardPath standardPath_;
     std::unordered_map<std::string, std::unique_ptr<SharedLibraryFactory>>
         registry_;
@@ -7,21 +7,29 @@
 
 #include "addonmanager.h"
 #include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-config/rawconfig.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/macros.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/semver.h"
 #include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/unixfd.h"
 #include "addoninfo.h"
 #include "addoninstance.h"
@@ -30,6 +38,9 @@
 #include "addonloader_p.h"
 #include "config.h"
 #include "instance.h"
+#include "metadatasnapshot_p.h"
+#include "misc_p.h"
+#include "startuptimeline_p.h"
 
 namespace fcitx {
 
@@ -64,6 +75,54 @@ private:
     std::unique_ptr<AddonInstance> instance_;
 };
 
+namespace {
+
+// Below this number of files, spawning threads costs more than it saves.
+constexpr size_t parallelParseThreshold = 8;
+constexpr size_t maxParseWorkers = 4;
+
+void parseAddonConfig(const std::string &fullName, RawConfig &config) {
+    UnixFD fd = UnixFD::own(open(fullName.c_str(), O_RDONLY));
+    readFromIni(config, fd.fd());
+}
+
+// Parse all addon configuration files. Each file is parsed into its own
+// config so the result does not depend on the order in which the workers
+// finish.
+void parseAddonConfigs(const std::vector<std::string> &files,
+                       const std::vector<RawConfig *> &configs) {
+    size_t workers = std::min<size_t>(
+        {std::max(1U, std::thread::hardware_concurrency()), maxParseWorkers,
+         files.size() / (parallelParseThreshold / 2)});
+    if (files.size() < parallelParseThreshold || workers <= 1) {
+        for (size_t i = 0; i < files.size(); i++) {
+            parseAddonConfig(files[i], *configs[i]);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&files, &configs, &next]() {
+        size_t i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) <
+               files.size()) {
+            parseAddonConfig(files[i], *configs[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t i = 1; i < workers; i++) {
+        threads.emplace_back(worker);
+    }
+    // Main thread takes part in the work as well.
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
 enum class DependencyCheckStatus {
     Satisfied,
     Pending,
@@ -190,8 +249,15 @@ public:
             return;
         }
 
-        if (auto *loader = findValue(loaders_, addon.info().type())) {
-            addon.instance_.reset((*loader)->load(addon.info(), q_ptr));
+        StartupPhase phase(
+            stringutils::concat("Addon/", addon.info().uniqueName()));
+        const auto start = now(CLOCK_MONOTONIC);
+        // Reading RSS goes through /proc, only do it if the result is logged.
+        const bool measure =
+            Log::defaultCategory().checkLogLevel(LogLevel::Info);
+        const auto rss = measure ? residentSetSize() : 0;
+        if (auto *loader = findLoader(addon.info())) {
+            addon.instance_.reset(loader->load(addon.info(), q_ptr));
         } else {
             FCITX_ERROR() << "Failed to find addon loader for: "
                           << addon.info().type();
@@ -202,7 +268,48 @@ public:
                          << addon.info().uniqueName();
         } else {
             addon.instance_->d_func()->addonInfo_ = &(addon.info());
-            FCITX_INFO() << "Loaded addon " << addon.info().uniqueName();
+            // Includes the dependencies that are loaded by the constructor.
+            if (measure) {
+                FCITX_INFO()
+                    << "Loaded addon " << addon.info().uniqueName() << " in "
+                    << (now(CLOCK_MONOTONIC) - start) / 1000 << "ms, RSS "
+                    << (residentSetSize() - rss) / 1024 << "KiB";
+            }
+        }
+    }
+
+    // A shared library addon that is also linked into the binary is loaded
+    // from the static registry, so the bundled modules can be built into the
+    // server without changing their addon configuration.
+    AddonLoader *findLoader(const AddonInfo &info) const {
+        if (info.type() == "SharedLibrary") {
+            if (auto *loader = findValue(loaders_, "StaticLibrary")) {
+                if (auto *staticLoader =
+                        dynamic_cast<StaticLibraryLoader *>(loader->get());
+                    staticLoader &&
+                    staticLoader->registry->count(info.uniqueName())) {
+                    return staticLoader;
+                }
+            }
+        }
+        if (auto *loader = findValue(loaders_, info.type())) {
+            return loader->get();
+        }
+        return nullptr;
+    }
+
+    // Ask the kernel to start reading the libraries of the addons that are
+    // about to be loaded, so the disk IO overlaps with the dlopen and
+    // initialization of the addons loaded before them.
+    void prefetchAddons() {
+        for (const auto &[name, addon] : addons_) {
+            if (!addon->isLoadable() || addon->info().onDemand()) {
+                continue;
+            }
+            if (auto *sharedLoader = dynamic_cast<SharedLibraryLoader *>(
+                    findLoader(addon->info()))) {
+                sharedLoader->prefetch(addon->info());
+            }
         }
     }
 
@@ -266,7 +373,40 @@ void AddonManager::load(const std::unordered_set<std::string> &enabled,
                                  d->addonConfigDir_, filter::Suffix(".conf"));
     bool enableAll = enabled.count("all");
     bool disableAll = disabled.count("all");
-    for (const auto &[fileName, fullName] : fileNames) {
+
+    // Parsed files are kept in the snapshot by file name, the snapshot is
+    // valid as long as no file or directory has changed.
+    MetadataSnapshot snapshot("addon", path);
+    path.scanDirectories(
+        StandardPath::Type::PkgData,
+        [&snapshot, d](const std::string &dir, bool isUser) {
+            auto fullPath = stringutils::joinPath(dir, d->addonConfigDir_);
+            if (isUser) {
+                snapshot.addOptionalDependency(fullPath);
+            } else {
+                snapshot.addDependency(fullPath);
+            }
+            return true;
+        });
+    for (const auto &item : fileNames) {
+        snapshot.addDependency(item.second);
+    }
+    RawConfig configs;
+    if (!snapshot.load(configs)) {
+        std::vector<std::string> files;
+        std::vector<RawConfig *> targets;
+        for (const auto &[fileName, fullName] : fileNames) {
+            files.push_back(fullName);
+            targets.push_back(configs.get(fileName, true).get());
+        }
+        parseAddonConfigs(files, targets);
+        snapshot.save(configs);
+    }
+
+    // Only the file parsing runs in parallel, the addons are created in file
+    // name order here so the result is the same as a serial load.
+    for (const auto &item : fileNames) {
+        const auto &fileName = item.first;
         // remove .conf
         std::string name = fileName.substr(0, fileName.size() - 5);
         if (name == "core") {
@@ -276,13 +416,13 @@ void AddonManager::load(const std::unordered_set<std::string> &enabled,
         if (d->addons_.count(name)) {
             continue;
         }
-
-        RawConfig config;
-        UnixFD fd = UnixFD::own(open(fullName.c_str(), O_RDONLY));
-        readFromIni(config, fd.fd());
+        auto config = configs.get(fileName);
+        if (!config) {
+            continue;
+        }
 
         // override configuration
-        auto addon = std::make_unique<Addon>(name, config);
+        auto addon = std::make_unique<Addon>(name, *config);
         if (addon->isValid()) {
             if (enableAll || enabled.count(name)) {
                 addon->setOverrideEnabled(OverrideEnabled::Enabled);
@@ -293,6 +433,7 @@ void AddonManager::load(const std::unordered_set<std::string> &enabled,
         }
     }
 
+    d->prefetchAddons();
     d->loadAddons(this);
 }
 
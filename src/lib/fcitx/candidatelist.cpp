@@ -6,6 +6,8 @@
  */
 
 #include "candidatelist.h"
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <stdexcept>
 #include <unordered_set>
@@ -75,6 +77,25 @@ public:
     FCITX_FORWARD_METHOD(void, setCursorIndex, (int));
 };
 
+class BulkCursorAdaptorForLazyCandidateList
+    : public CandidateListInterfaceAdapter<LazyCandidateList,
+                                           BulkCursorCandidateList> {
+public:
+    using CandidateListInterfaceAdapter::CandidateListInterfaceAdapter;
+
+    FCITX_FORWARD_METHOD(void, setGlobalCursorIndex, (int));
+    FCITX_FORWARD_METHOD(int, globalCursorIndex, (), const);
+};
+
+class CursorModifiableAdaptorForLazyCandidateList
+    : public CandidateListInterfaceAdapter<LazyCandidateList,
+                                           CursorModifiableCandidateList> {
+public:
+    using CandidateListInterfaceAdapter::CandidateListInterfaceAdapter;
+
+    FCITX_FORWARD_METHOD(void, setCursorIndex, (int));
+};
+
 } // namespace
 
 ActionableCandidateList::~ActionableCandidateList() = default;
@@ -167,9 +188,19 @@ void CandidateList::setActionable(ActionableCandidateList *list) {
     d->actionable_ = list;
 }
 
+namespace {
+
+uint64_t nextCandidateSerial() {
+    static std::atomic<uint64_t> serial = 0;
+    return ++serial;
+}
+
+} // namespace
+
 class CandidateWordPrivate {
 public:
     CandidateWordPrivate(Text &&text) : text_(std::move(text)) {}
+    uint64_t serial_ = nextCandidateSerial();
     Text text_;
     bool isPlaceHolder_ = false;
     Text customLabel_;
@@ -189,6 +220,7 @@ const Text &CandidateWord::text() const {
 
 void CandidateWord::setText(Text text) {
     FCITX_D();
+    d->serial_ = nextCandidateSerial();
     d->text_ = std::move(text);
 }
 
@@ -199,6 +231,7 @@ const Text &CandidateWord::comment() const {
 
 void CandidateWord::setComment(Text comment) {
     FCITX_D();
+    d->serial_ = nextCandidateSerial();
     d->comment_ = std::move(comment);
 }
 
@@ -212,6 +245,11 @@ Text CandidateWord::textWithComment(std::string separator) const {
     return text;
 }
 
+uint64_t CandidateWord::serial() const {
+    FCITX_D();
+    return d->serial_;
+}
+
 bool CandidateWord::isPlaceHolder() const {
     FCITX_D();
     return d->isPlaceHolder_;
@@ -229,17 +267,20 @@ const Text &CandidateWord::customLabel() const {
 
 void CandidateWord::setPlaceHolder(bool placeHolder) {
     FCITX_D();
+    d->serial_ = nextCandidateSerial();
     d->isPlaceHolder_ = placeHolder;
 }
 
 void CandidateWord::resetCustomLabel() {
     FCITX_D();
+    d->serial_ = nextCandidateSerial();
     d->customLabel_ = Text();
     d->hasCustomLabel_ = false;
 }
 
 void CandidateWord::setCustomLabel(Text text) {
     FCITX_D();
+    d->serial_ = nextCandidateSerial();
     d->customLabel_ = std::move(text);
     d->hasCustomLabel_ = true;
 }
@@ -733,4 +774,313 @@ void CommonCandidateList::setActionableImpl(
     setActionable(d->actionable_.get());
 }
 
+class LazyCandidateListPrivate {
+public:
+    LazyCandidateListPrivate(LazyCandidateList *q,
+                             LazyCandidateList::Generator generator)
+        : bulkCursor_(q), cursorModifiable_(q),
+          generator_(std::move(generator)) {}
+
+    BulkCursorAdaptorForLazyCandidateList bulkCursor_;
+    CursorModifiableAdaptorForLazyCandidateList cursorModifiable_;
+    bool usedNextBefore_ = false;
+    int cursorIndex_ = -1;
+    int currentPage_ = 0;
+    int pageSize_ = 5;
+    int lookahead_ = 1;
+    CursorPositionAfterPaging cursorPositionAfterPaging_ =
+        CursorPositionAfterPaging::DonotChange;
+    std::vector<Text> labels_;
+    CandidateLayoutHint layoutHint_ = CandidateLayoutHint::NotSet;
+    // Candidates are created from const accessors.
+    mutable LazyCandidateList::Generator generator_;
+    mutable std::vector<std::unique_ptr<CandidateWord>> candidateWord_;
+
+    int loaded() const { return candidateWord_.size(); }
+
+    bool exhausted() const { return !generator_; }
+
+    // Create candidates until there are count of them, return false if there
+    // is not enough.
+    bool fill(int count) const {
+        while (loaded() < count && generator_) {
+            if (auto word = generator_()) {
+                candidateWord_.push_back(std::move(word));
+            } else {
+                // Release whatever the generator holds.
+                generator_ = nullptr;
+            }
+        }
+        return loaded() >= count;
+    }
+
+    // Make sure current page and the lookahead are created.
+    void fillCurrentPage() const {
+        fill((currentPage_ + 1) * pageSize_ + std::max(lookahead_, 1));
+    }
+
+    int size() const {
+        fillCurrentPage();
+        auto remain = loaded() - currentPage_ * pageSize_;
+        return std::clamp(remain, 0, pageSize_);
+    }
+
+    void checkIndex(int idx) const {
+        if (idx < 0 || idx >= size()) {
+            throw std::invalid_argument("LazyCandidateList: invalid index");
+        }
+    }
+
+    void checkGlobalIndex(int idx) const {
+        if (idx < 0 || !fill(idx + 1)) {
+            throw std::invalid_argument(
+                "LazyCandidateList: invalid global index");
+        }
+    }
+
+    void fixCursorAfterPaging(int oldIndex) {
+        if (oldIndex < 0) {
+            return;
+        }
+
+        switch (cursorPositionAfterPaging_) {
+        case CursorPositionAfterPaging::DonotChange:
+            break;
+        case CursorPositionAfterPaging::ResetToFirst:
+            cursorIndex_ = currentPage_ * pageSize_;
+            break;
+        case CursorPositionAfterPaging::SameAsLast: {
+            auto currentPageSize = size();
+            if (oldIndex >= currentPageSize) {
+                cursorIndex_ = currentPage_ * pageSize_ + currentPageSize - 1;
+            } else {
+                cursorIndex_ = currentPage_ * pageSize_ + oldIndex;
+            }
+            break;
+        }
+        }
+    }
+};
+
+LazyCandidateList::LazyCandidateList(Generator generator)
+    : d_ptr(std::make_unique<LazyCandidateListPrivate>(this,
+                                                       std::move(generator))) {
+    FCITX_D();
+    setPageable(this);
+    setBulk(this);
+    setCursorMovable(this);
+    setBulkCursor(&d->bulkCursor_);
+    setCursorModifiable(&d->cursorModifiable_);
+
+    setLabels();
+}
+
+LazyCandidateList::~LazyCandidateList() {}
+
+void LazyCandidateList::setLabels(const std::vector<std::string> &labels) {
+    FCITX_D();
+    fillLabels(
+        d->labels_, labels,
+        [](const std::string &str) -> const std::string & { return str; });
+}
+
+void LazyCandidateList::setSelectionKey(const KeyList &keyList) {
+    FCITX_D();
+    fillLabels(d->labels_, keyList,
+               [](const Key &str) -> std::string { return keyToLabel(str); });
+}
+
+void LazyCandidateList::setPageSize(int size) {
+    FCITX_D();
+    if (size < 1) {
+        throw std::invalid_argument("LazyCandidateList: invalid page size");
+    }
+    d->pageSize_ = size;
+    d->currentPage_ = 0;
+}
+
+int LazyCandidateList::pageSize() const {
+    FCITX_D();
+    return d->pageSize_;
+}
+
+void LazyCandidateList::setLookahead(int lookahead) {
+    FCITX_D();
+    d->lookahead_ = lookahead;
+}
+
+void LazyCandidateList::setLayoutHint(CandidateLayoutHint hint) {
+    FCITX_D();
+    d->layoutHint_ = hint;
+}
+
+void LazyCandidateList::setGlobalCursorIndex(int index) {
+    FCITX_D();
+    if (index < 0) {
+        d->cursorIndex_ = -1;
+    } else {
+        d->checkGlobalIndex(index);
+        d->cursorIndex_ = index;
+    }
+}
+
+int LazyCandidateList::globalCursorIndex() const {
+    FCITX_D();
+    return d->cursorIndex_;
+}
+
+void LazyCandidateList::setCursorIndex(int index) {
+    FCITX_D();
+    d->checkIndex(index);
+    setGlobalCursorIndex(index + d->currentPage_ * d->pageSize_);
+}
+
+void LazyCandidateList::setCursorPositionAfterPaging(
+    CursorPositionAfterPaging afterPaging) {
+    FCITX_D();
+    d->cursorPositionAfterPaging_ = afterPaging;
+}
+
+int LazyCandidateList::loadedSize() const {
+    FCITX_D();
+    return d->loaded();
+}
+
+const Text &LazyCandidateList::label(int idx) const {
+    FCITX_D();
+    d->checkIndex(idx);
+    if (static_cast<size_t>(idx) >= d->labels_.size()) {
+        throw std::invalid_argument("LazyCandidateList: invalid label idx");
+    }
+    return d->labels_[idx];
+}
+
+const CandidateWord &LazyCandidateList::candidate(int idx) const {
+    FCITX_D();
+    d->checkIndex(idx);
+    return *d->candidateWord_[idx + d->currentPage_ * d->pageSize_];
+}
+
+int LazyCandidateList::cursorIndex() const {
+    FCITX_D();
+    if (d->cursorIndex_ >= 0 &&
+        d->cursorIndex_ / d->pageSize_ == d->currentPage_) {
+        return d->cursorIndex_ % d->pageSize_;
+    }
+    return -1;
+}
+
+int LazyCandidateList::size() const {
+    FCITX_D();
+    return d->size();
+}
+
+CandidateLayoutHint LazyCandidateList::layoutHint() const {
+    FCITX_D();
+    return d->layoutHint_;
+}
+
+bool LazyCandidateList::hasPrev() const {
+    FCITX_D();
+    return d->currentPage_ > 0;
+}
+
+bool LazyCandidateList::hasNext() const {
+    FCITX_D();
+    return d->fill((d->currentPage_ + 1) * d->pageSize_ + 1);
+}
+
+void LazyCandidateList::prev() {
+    FCITX_D();
+    if (!hasPrev()) {
+        return;
+    }
+    setPage(d->currentPage_ - 1);
+}
+
+void LazyCandidateList::next() {
+    FCITX_D();
+    if (!hasNext()) {
+        return;
+    }
+    setPage(d->currentPage_ + 1);
+    d->usedNextBefore_ = true;
+}
+
+bool LazyCandidateList::usedNextBefore() const {
+    FCITX_D();
+    return d->usedNextBefore_;
+}
+
+int LazyCandidateList::totalPages() const {
+    FCITX_D();
+    if (!d->exhausted()) {
+        return -1;
+    }
+    return (d->loaded() + d->pageSize_ - 1) / d->pageSize_;
+}
+
+int LazyCandidateList::currentPage() const {
+    FCITX_D();
+    return d->currentPage_;
+}
+
+void LazyCandidateList::setPage(int page) {
+    FCITX_D();
+    // Page 0 is always valid, even if it's empty.
+    if (page < 0 || (page > 0 && !d->fill(page * d->pageSize_ + 1))) {
+        throw std::invalid_argument("invalid page");
+    }
+    if (d->currentPage_ != page) {
+        auto oldIndex = cursorIndex();
+        d->currentPage_ = page;
+        d->fixCursorAfterPaging(oldIndex);
+    }
+}
+
+const CandidateWord &LazyCandidateList::candidateFromAll(int idx) const {
+    FCITX_D();
+    d->checkGlobalIndex(idx);
+    return *d->candidateWord_[idx];
+}
+
+int LazyCandidateList::totalSize() const {
+    FCITX_D();
+    return d->exhausted() ? d->loaded() : -1;
+}
+
+void LazyCandidateList::prevCandidate() {
+    FCITX_D();
+    if (size() <= 0) {
+        return;
+    }
+    int index = cursorIndex() < 0 ? d->currentPage_ * d->pageSize_ + size()
+                                  : d->cursorIndex_;
+    // Skip place holders, and stay if there is nothing before it.
+    do {
+        index -= 1;
+    } while (index >= 0 && d->candidateWord_[index]->isPlaceHolder());
+    if (index >= 0) {
+        d->cursorIndex_ = index;
+        d->currentPage_ = index / d->pageSize_;
+    }
+}
+
+void LazyCandidateList::nextCandidate() {
+    FCITX_D();
+    if (size() <= 0) {
+        return;
+    }
+    int index = cursorIndex() < 0 ? d->currentPage_ * d->pageSize_ - 1
+                                  : d->cursorIndex_;
+    // Skip place holders, and stay if there is nothing after it.
+    do {
+        index += 1;
+    } while (d->fill(index + 1) && d->candidateWord_[index]->isPlaceHolder());
+    if (index < d->loaded()) {
+        d->cursorIndex_ = index;
+        d->currentPage_ = index / d->pageSize_;
+    }
+}
+
 } // namespace fcitx
@@ -7,6 +7,8 @@
 #ifndef _FCITX_CANDIDATELIST_H_
 #define _FCITX_CANDIDATELIST_H_
 
+#include <functional>
+#include <memory>
 #include <fcitx-utils/key.h>
 #include <fcitx-utils/macros.h>
 #include <fcitx/candidateaction.h>
@@ -67,6 +69,16 @@ public:
      * @since 5.1.9
      */
     Text textWithComment(std::string separator = " ") const;
+    /**
+     * Return a number that identifies the displayed content of candidate.
+     *
+     * It is unique among all candidates of the process, and changes whenever
+     * text, comment, custom label or place holder state changes. User
+     * interface can use it as a cache key of rendered candidates.
+     *
+     * @since 5.1.12
+     */
+    uint64_t serial() const;
 
 protected:
     void setText(Text text);
@@ -357,6 +369,91 @@ private:
     std::unique_ptr<CommonCandidateListPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(CommonCandidateList);
 };
+
+class LazyCandidateListPrivate;
+
+/**
+ * A candidate list that pulls candidates from a generator on demand.
+ *
+ * Only candidates of the pages that have been shown, plus a few lookahead
+ * ones, are created. This is useful when the result can be large while user
+ * usually only looks at the first few pages.
+ *
+ * While the generator is not exhausted, the total size is unknown and
+ * totalSize and totalPages return -1, even if some candidates are created.
+ * Once it returns nullptr, they return the actual number of candidates and
+ * pages. Use loadedSize for the number of candidates created so far.
+ *
+ * @since 5.1.12
+ */
+class FCITXCORE_EXPORT LazyCandidateList : public CandidateList,
+                                           public PageableCandidateList,
+                                           public BulkCandidateList,
+                                           public CursorMovableCandidateList {
+public:
+    /**
+     * Return the next candidate, or nullptr if there is no more candidate.
+     */
+    using Generator = std::function<std::unique_ptr<CandidateWord>()>;
+
+    LazyCandidateList(Generator generator);
+    ~LazyCandidateList();
+
+    /// \see CommonCandidateList::setLabels
+    void setLabels(const std::vector<std::string> &labels = {});
+    /// \see CommonCandidateList::setSelectionKey
+    void setSelectionKey(const KeyList &keyList);
+
+    void setPageSize(int size);
+    int pageSize() const;
+    /**
+     * Set the number of candidates to create beyond the current page.
+     *
+     * At least one is always created to know whether there is a next page.
+     * Default value is 1.
+     */
+    void setLookahead(int lookahead);
+    void setLayoutHint(CandidateLayoutHint hint);
+    void setGlobalCursorIndex(int index);
+    int globalCursorIndex() const;
+    void setCursorIndex(int index);
+    /// \see CommonCandidateList::setCursorPositionAfterPaging
+    void setCursorPositionAfterPaging(CursorPositionAfterPaging afterPaging);
+
+    /// Number of candidates that are created so far.
+    int loadedSize() const;
+
+    // CandidateList
+    const fcitx::Text &label(int idx) const override;
+    const CandidateWord &candidate(int idx) const override;
+    int cursorIndex() const override;
+    int size() const override;
+    CandidateLayoutHint layoutHint() const override;
+
+    // PageableCandidateList
+    bool hasPrev() const override;
+    bool hasNext() const override;
+    void prev() override;
+    void next() override;
+
+    bool usedNextBefore() const override;
+
+    int totalPages() const override;
+    int currentPage() const override;
+    void setPage(int page) override;
+
+    // BulkCandidateList
+    const CandidateWord &candidateFromAll(int idx) const override;
+    int totalSize() const override;
+
+    // CursorMovableCandidateList
+    void prevCandidate() override;
+    void nextCandidate() override;
+
+private:
+    std::unique_ptr<LazyCandidateListPrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(LazyCandidateList);
+};
 } // namespace fcitx
 
 #endif // _FCITX_CANDIDATELIST_H_
@@ -0,0 +1,400 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "composetable_p.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/misc.h"
+#include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
+#include "metadatasnapshot_p.h"
+#include "startuptimeline_p.h"
+
+namespace fcitx {
+
+namespace {
+
+#ifdef HAVE_XKB_COMPOSE_TABLE_ITERATOR
+
+// Same as the modifier check of xkb_compose_state_feed.
+bool isModifier(KeySym sym) {
+    return (sym >= FcitxKey_Shift_L && sym <= FcitxKey_Hyper_R) ||
+           (sym >= FcitxKey_ISO_Lock && sym <= FcitxKey_ISO_Level5_Lock) ||
+           sym == FcitxKey_Mode_switch || sym == FcitxKey_Num_Lock;
+}
+
+struct TrieBuilder {
+    uint32_t keysym = 0;
+    bool leaf = false;
+    std::string text;
+    std::map<uint32_t, std::unique_ptr<TrieBuilder>> children;
+};
+
+// Find the value in X11 locale files like compose.dir and locale.alias, where
+// each line is "<first>: <second>" or "<first> <second>".
+std::string lookupLocaleFile(const std::string &path, std::string_view key,
+                             bool matchSecond) {
+    std::ifstream fin(path, std::ios::in | std::ios::binary);
+    std::ostringstream buffer;
+    buffer << fin.rdbuf();
+    const auto content = buffer.str();
+    std::string_view rest = content;
+    while (!rest.empty()) {
+        auto end = rest.find('\n');
+        auto line = rest.substr(0, end);
+        rest = end == std::string_view::npos ? std::string_view()
+                                             : rest.substr(end + 1);
+        auto trimmed = stringutils::trimView(line);
+        if (trimmed.empty() || trimmed.front() == '#') {
+            continue;
+        }
+        auto pos = trimmed.find_first_of(": \t");
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+        auto first = trimmed.substr(0, pos);
+        auto second = trimmed.substr(pos + 1);
+        if (!second.empty() && second.front() == ':') {
+            second.remove_prefix(1);
+        }
+        second = stringutils::trimView(second);
+        if ((matchSecond ? second : first) == key) {
+            return std::string(matchSecond ? first : second);
+        }
+    }
+    return {};
+}
+
+// Add all the files that xkb_compose_table_new_from_locale may read, in the
+// order of the lookup.
+void addComposeDependencies(MetadataSnapshot &snapshot,
+                            const std::string &locale) {
+    snapshot.addKey(locale);
+    const char *composeFile = getenv("XCOMPOSEFILE");
+    snapshot.addKey(composeFile ? composeFile : "");
+    if (composeFile) {
+        snapshot.addDependency(composeFile);
+    }
+    // Per user files are usually missing, so the snapshot can be shared.
+    const char *home = getenv("HOME");
+    if (const char *configHome = getenv("XDG_CONFIG_HOME")) {
+        snapshot.addOptionalDependency(
+            stringutils::joinPath(configHome, "XCompose"));
+    } else if (home) {
+        snapshot.addOptionalDependency(
+            stringutils::joinPath(home, ".config/XCompose"));
+    }
+    if (home) {
+        snapshot.addOptionalDependency(
+            stringutils::joinPath(home, ".XCompose"));
+    }
+
+    const char *localeDir = getenv("XLOCALEDIR");
+    std::string dir = localeDir ? localeDir : "/usr/share/X11/locale";
+    snapshot.addKey(dir);
+    auto aliasFile = stringutils::joinPath(dir, "locale.alias");
+    auto composeDir = stringutils::joinPath(dir, "compose.dir");
+    snapshot.addDependency(aliasFile);
+    snapshot.addDependency(composeDir);
+    // locale.alias is much larger than compose.dir, only read it if the
+    // locale is not listed as is.
+    auto systemFile = lookupLocaleFile(composeDir, locale, true);
+    if (systemFile.empty()) {
+        auto resolved = lookupLocaleFile(aliasFile, locale, false);
+        if (!resolved.empty()) {
+            systemFile = lookupLocaleFile(composeDir, resolved, true);
+        }
+    }
+    if (!systemFile.empty()) {
+        snapshot.addDependency(stringutils::joinPath(dir, systemFile));
+    }
+}
+
+std::string snapshotName(const std::string &locale) {
+    auto name = stringutils::concat("compose-", locale);
+    std::replace(name.begin(), name.end(), '/', '_');
+    return name;
+}
+
+#endif
+
+} // namespace
+
+#ifdef HAVE_XKB_COMPOSE_TABLE_ITERATOR
+
+std::unique_ptr<ComposeTable> ComposeTable::create(xkb_context *context,
+                                                   const std::string &locale) {
+    MetadataSnapshot snapshot(snapshotName(locale), StandardPath::global());
+    addComposeDependencies(snapshot, locale);
+    if (auto mapping = snapshot.map(); mapping.isValid()) {
+        MetadataSnapshot::Reader reader(mapping.content());
+        std::string_view nodes;
+        std::string_view text;
+        std::unique_ptr<ComposeTable> table(new ComposeTable);
+        // The views remain valid after moving the mapping.
+        if (reader.read(nodes) && reader.read(text) && reader.atEnd() &&
+            table->setData(nodes, text)) {
+            table->mapping_ = std::move(mapping);
+            return table;
+        }
+        FCITX_WARN() << "Invalid compose table snapshot for " << locale;
+    }
+
+    StartupPhase phase("xkb_compose_table_new_from_locale");
+    UniqueCPtr<xkb_compose_table, xkb_compose_table_unref> xkbTable(
+        xkb_compose_table_new_from_locale(context, locale.c_str(),
+                                          XKB_COMPOSE_COMPILE_NO_FLAGS));
+    if (!xkbTable) {
+        return nullptr;
+    }
+    auto table = create(xkbTable.get());
+    if (table) {
+        snapshot.save([&table](MetadataSnapshot::Writer &writer) {
+            writer.write(table->nodes_);
+            writer.write(table->text_);
+        });
+    }
+    return table;
+}
+
+std::unique_ptr<ComposeTable> ComposeTable::create(xkb_compose_table *table) {
+    TrieBuilder root;
+    UniqueCPtr<xkb_compose_table_iterator, xkb_compose_table_iterator_free>
+        iter(xkb_compose_table_iterator_new(table));
+    if (!iter) {
+        return nullptr;
+    }
+    while (auto *entry = xkb_compose_table_iterator_next(iter.get())) {
+        size_t length = 0;
+        const auto *sequence = xkb_compose_table_entry_sequence(entry, &length);
+        if (!length) {
+            continue;
+        }
+        auto *node = &root;
+        // xkbcommon already resolved the conflicts, but do not trust it to
+        // keep the trie consistent.
+        for (size_t i = 0; i < length && !node->leaf; i++) {
+            auto &child = node->children[sequence[i]];
+            if (!child) {
+                child = std::make_unique<TrieBuilder>();
+                child->keysym = sequence[i];
+            }
+            node = child.get();
+        }
+        if (node->leaf || !node->children.empty()) {
+            continue;
+        }
+        node->leaf = true;
+        if (const char *utf8 = xkb_compose_table_entry_utf8(entry)) {
+            node->text = utf8;
+        }
+        // Same as xkb_compose_state_get_utf8, use the keysym if there is no
+        // string.
+        const auto keysym = xkb_compose_table_entry_keysym(entry);
+        if (node->text.empty() && keysym != XKB_KEY_NoSymbol) {
+            char buffer[8];
+            if (xkb_keysym_to_utf8(keysym, buffer, sizeof(buffer)) > 0) {
+                node->text = buffer;
+            }
+        }
+    }
+
+    std::unique_ptr<ComposeTable> result(new ComposeTable);
+    // Breadth first, so children of a node are next to each other.
+    std::vector<const TrieBuilder *> queue{&root};
+    for (size_t i = 0; i < queue.size(); i++) {
+        const auto *builder = queue[i];
+        Node node{builder->keysym, 0,
+                  static_cast<uint32_t>(builder->children.size()),
+                  static_cast<uint32_t>(result->ownedText_.size()),
+                  static_cast<uint32_t>(builder->text.size())};
+        if (!builder->children.empty()) {
+            node.firstChild = queue.size();
+        }
+        for (const auto &[_, child] : builder->children) {
+            queue.push_back(child.get());
+        }
+        result->ownedText_.append(builder->text);
+        result->ownedNodes_.append(reinterpret_cast<const char *>(&node),
+                                   sizeof(node));
+    }
+    if (!result->setData(result->ownedNodes_, result->ownedText_)) {
+        return nullptr;
+    }
+    return result;
+}
+
+bool ComposeTable::setData(std::string_view nodes, std::string_view text) {
+    if (nodes.empty() || nodes.size() % sizeof(Node) != 0) {
+        return false;
+    }
+    nodes_ = nodes;
+    text_ = text;
+    // Validate once, so lookups do not need any check.
+    const uint64_t count = size();
+    for (uint32_t i = 0; i < count; i++) {
+        auto current = node(i);
+        if ((current.childCount &&
+             (current.firstChild <= i ||
+              uint64_t(current.firstChild) + current.childCount > count)) ||
+            uint64_t(current.textOffset) + current.textLength > text.size()) {
+            nodes_ = {};
+            text_ = {};
+            return false;
+        }
+    }
+    return true;
+}
+
+ComposeTable::Node ComposeTable::node(uint32_t index) const {
+    Node result;
+    memcpy(&result, nodes_.data() + index * sizeof(Node), sizeof(Node));
+    return result;
+}
+
+uint32_t ComposeTable::child(uint32_t index, KeySym sym) const {
+    const auto parent = node(index);
+    uint32_t low = parent.firstChild;
+    uint32_t high = parent.firstChild + parent.childCount;
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2;
+        const auto keysym = node(mid).keysym;
+        if (keysym == static_cast<uint32_t>(sym)) {
+            return mid;
+        }
+        if (keysym < static_cast<uint32_t>(sym)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return noNode;
+}
+
+bool ComposeTable::isLeaf(uint32_t index) const {
+    return index != root && node(index).childCount == 0;
+}
+
+std::string_view ComposeTable::text(uint32_t index) const {
+    const auto current = node(index);
+    return text_.substr(current.textOffset, current.textLength);
+}
+
+uint32_t ComposeTable::size() const { return nodes_.size() / sizeof(Node); }
+
+ComposeTableState::ComposeTableState(const ComposeTable *table)
+    : table_(table) {}
+
+bool ComposeTableState::feed(KeySym sym) {
+    if (isModifier(sym)) {
+        return false;
+    }
+    const auto parent =
+        status_ == ComposeStatus::Composing ? node_ : ComposeTable::root;
+    const auto child = table_->child(parent, sym);
+    if (child == ComposeTable::noNode) {
+        status_ = status_ == ComposeStatus::Composing ? ComposeStatus::Cancelled
+                                                      : ComposeStatus::Nothing;
+        node_ = ComposeTable::root;
+    } else {
+        node_ = child;
+        status_ = table_->isLeaf(child) ? ComposeStatus::Composed
+                                        : ComposeStatus::Composing;
+    }
+    return true;
+}
+
+ComposeStatus ComposeTableState::status() const { return status_; }
+
+std::string ComposeTableState::text() const {
+    if (status_ != ComposeStatus::Composed) {
+        return {};
+    }
+    return std::string(table_->text(node_));
+}
+
+void ComposeTableState::reset() {
+    node_ = ComposeTable::root;
+    status_ = ComposeStatus::Nothing;
+}
+
+#else
+
+std::unique_ptr<ComposeTable> ComposeTable::create(xkb_context *context,
+                                                   const std::string &locale) {
+    StartupPhase phase("xkb_compose_table_new_from_locale");
+    UniqueCPtr<xkb_compose_table, xkb_compose_table_unref> xkbTable(
+        xkb_compose_table_new_from_locale(context, locale.c_str(),
+                                          XKB_COMPOSE_COMPILE_NO_FLAGS));
+    return create(xkbTable.get());
+}
+
+std::unique_ptr<ComposeTable> ComposeTable::create(xkb_compose_table *table) {
+    if (!table) {
+        return nullptr;
+    }
+    std::unique_ptr<ComposeTable> result(new ComposeTable);
+    result->table_.reset(xkb_compose_table_ref(table));
+    return result;
+}
+
+ComposeTableState::ComposeTableState(const ComposeTable *table)
+    : state_(xkb_compose_state_new(table->table(),
+                                   XKB_COMPOSE_STATE_NO_FLAGS)) {}
+
+bool ComposeTableState::feed(KeySym sym) {
+    return state_ && xkb_compose_state_feed(state_.get(), sym) ==
+                         XKB_COMPOSE_FEED_ACCEPTED;
+}
+
+ComposeStatus ComposeTableState::status() const {
+    if (!state_) {
+        return ComposeStatus::Nothing;
+    }
+    switch (xkb_compose_state_get_status(state_.get())) {
+    case XKB_COMPOSE_COMPOSING:
+        return ComposeStatus::Composing;
+    case XKB_COMPOSE_COMPOSED:
+        return ComposeStatus::Composed;
+    case XKB_COMPOSE_CANCELLED:
+        return ComposeStatus::Cancelled;
+    default:
+        break;
+    }
+    return ComposeStatus::Nothing;
+}
+
+std::string ComposeTableState::text() const {
+    if (status() != ComposeStatus::Composed) {
+        return {};
+    }
+    std::string result;
+    result.resize(xkb_compose_state_get_utf8(state_.get(), nullptr, 0) + 1);
+    result.resize(
+        xkb_compose_state_get_utf8(state_.get(), result.data(), result.size()));
+    return result;
+}
+
+void ComposeTableState::reset() {
+    if (state_) {
+        xkb_compose_state_reset(state_.get());
+    }
+}
+
+#endif
+
+} // namespace fcitx
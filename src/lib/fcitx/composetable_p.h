@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_COMPOSETABLE_P_H_
+#define _FCITX_COMPOSETABLE_P_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <fcitx-utils/keysym.h>
+#include <fcitx-utils/misc.h>
+#include "config.h"
+#include "metadatasnapshot_p.h"
+
+#include <xkbcommon/xkbcommon-compose.h>
+#include <xkbcommon/xkbcommon.h>
+
+namespace fcitx {
+
+enum class ComposeStatus { Nothing, Composing, Composed, Cancelled };
+
+/**
+ * Compose table compiled into a trie.
+ *
+ * Children of a node are stored next to each other and sorted by keysym, so a
+ * lookup is a binary search. The compiled table is saved as a snapshot under
+ * $XDG_CACHE_HOME/fcitx5 and mapped in place by the next process, so the
+ * Compose file is only parsed once and the pages are shared between all the
+ * instances on the host.
+ *
+ * Without xkb_compose_table_iterator_new, which is added in libxkbcommon
+ * 1.6.0, the table is not compiled, and xkb_compose_table is used instead.
+ */
+class ComposeTable {
+public:
+    // Load the compose table for the locale, from the snapshot if possible.
+    static std::unique_ptr<ComposeTable> create(xkb_context *context,
+                                                const std::string &locale);
+
+    // Compile an already parsed table, the result is not saved.
+    static std::unique_ptr<ComposeTable> create(xkb_compose_table *table);
+
+#ifdef HAVE_XKB_COMPOSE_TABLE_ITERATOR
+    static constexpr uint32_t root = 0;
+    static constexpr uint32_t noNode = static_cast<uint32_t>(-1);
+
+    // Return noNode if there is no such child.
+    uint32_t child(uint32_t node, KeySym sym) const;
+    bool isLeaf(uint32_t node) const;
+    std::string_view text(uint32_t node) const;
+    uint32_t size() const;
+#else
+    xkb_compose_table *table() const { return table_.get(); }
+#endif
+
+private:
+    ComposeTable() = default;
+
+#ifdef HAVE_XKB_COMPOSE_TABLE_ITERATOR
+    struct Node {
+        uint32_t keysym;
+        uint32_t firstChild;
+        uint32_t childCount;
+        uint32_t textOffset;
+        uint32_t textLength;
+    };
+
+    Node node(uint32_t index) const;
+    bool setData(std::string_view nodes, std::string_view text);
+
+    MetadataSnapshot::Mapping mapping_;
+    std::string ownedNodes_;
+    std::string ownedText_;
+    std::string_view nodes_;
+    std::string_view text_;
+#else
+    UniqueCPtr<xkb_compose_table, xkb_compose_table_unref> table_;
+#endif
+};
+
+/**
+ * The state of a compose sequence being typed, with the same semantics as
+ * xkb_compose_state.
+ */
+class ComposeTableState {
+public:
+    explicit ComposeTableState(const ComposeTable *table);
+
+    // Return false if the keysym is ignored, i.e. it is a modifier.
+    bool feed(KeySym sym);
+    ComposeStatus status() const;
+    // The result of a composed sequence.
+    std::string text() const;
+    void reset();
+
+private:
+#ifdef HAVE_XKB_COMPOSE_TABLE_ITERATOR
+    const ComposeTable *table_;
+    uint32_t node_ = ComposeTable::root;
+    ComposeStatus status_ = ComposeStatus::Nothing;
+#else
+    UniqueCPtr<xkb_compose_state, xkb_compose_state_unref> state_;
+#endif
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_COMPOSETABLE_P_H_
@@ -6,6 +6,7 @@
  */
 
 #include "globalconfig.h"
+#include <utility>
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/enum.h"
 #include "fcitx-config/iniparser.h"
@@ -201,7 +202,52 @@ FCITX_CONFIGURATION(
                        IntConstrain(0, 1440),
                        {},
                        {_("If value is 0, the user data may only be saved when "
-                          "fcitx quits (e.g. logout).")}};);
+                          "fcitx quits (e.g. logout).")}};
+    Option<int, IntConstrain, DefaultMarshaller<int>, ToolTipAnnotation>
+        uiUpdateInterval{
+            this,
+            "UIUpdateInterval",
+            _("Minimum interval between user interface updates in "
+              "milliseconds"),
+            0,
+            IntConstrain(0, 100),
+            {},
+            {_("Updates within the interval are merged into one, e.g. when "
+               "a key repeats. Use 16 to align with a 60Hz display. If value "
+               "is 0, user interface is updated after every key event.")}};
+    Option<int, IntConstrain, DefaultMarshaller<int>, ToolTipAnnotation>
+        cursorRectThreshold{
+            this,
+            "CursorRectThreshold",
+            _("Ignore cursor movements smaller than this in pixels"),
+            0,
+            IntConstrain(0, 100),
+            {},
+            {_("Some applications keep updating the cursor position with "
+               "almost the same value, e.g. when the caret blinks. If value "
+               "is 0, every change is applied.")}};
+    Option<int, IntConstrain, DefaultMarshaller<int>, ToolTipAnnotation>
+        cursorRectUpdateInterval{
+            this,
+            "CursorRectUpdateInterval",
+            _("Minimum interval between cursor position updates in "
+              "milliseconds"),
+            0,
+            IntConstrain(0, 100),
+            {},
+            {_("Cursor position changes within the interval are merged into "
+               "one. If value is 0, user interface follows every change.")}};
+    Option<int, IntConstrain, DefaultMarshaller<int>, ToolTipAnnotation>
+        trimMemoryAfterIdle{
+            this,
+            "TrimMemoryAfterIdle",
+            _("Release caches after no input for this many minutes"),
+            10,
+            IntConstrain(0, 1440),
+            {},
+            {_("The caches are built again on next use. If value is 0, the "
+               "caches are only released when the system is low on "
+               "memory.")}};);
 
 FCITX_CONFIGURATION(GlobalConfig,
                     Option<HotkeyConfig> hotkey{this, "Hotkey", _("Hotkey")};
@@ -209,7 +255,32 @@ FCITX_CONFIGURATION(GlobalConfig,
                                                     _("Behavior")};);
 } // namespace impl
 
-class GlobalConfigPrivate : public impl::GlobalConfig {};
+class GlobalConfigPrivate : public impl::GlobalConfig {
+public:
+    GlobalConfigPrivate() { rebuildHotkeyMatcher(); }
+
+    void rebuildHotkeyMatcher() {
+        hotkeyMatcher_.clear();
+        const std::pair<GlobalHotkey, const KeyList &> hotkeys[] = {
+            {GlobalHotkey::Trigger, *hotkey->triggerKeys},
+            {GlobalHotkey::AltTrigger, *hotkey->altTriggerKeys},
+            {GlobalHotkey::Activate, *hotkey->activateKeys},
+            {GlobalHotkey::Deactivate, *hotkey->deactivateKeys},
+            {GlobalHotkey::EnumerateForward, *hotkey->enumerateForwardKeys},
+            {GlobalHotkey::EnumerateBackward, *hotkey->enumerateBackwardKeys},
+            {GlobalHotkey::EnumerateGroupForward,
+             *hotkey->enumerateGroupForwardKeys},
+            {GlobalHotkey::EnumerateGroupBackward,
+             *hotkey->enumerateGroupBackwardKeys},
+            {GlobalHotkey::TogglePreedit, *hotkey->togglePreedit},
+        };
+        for (const auto &[group, keys] : hotkeys) {
+            hotkeyMatcher_.addKeys(static_cast<size_t>(group), keys);
+        }
+    }
+
+    KeyMatcher hotkeyMatcher_;
+};
 
 GlobalConfig::GlobalConfig() : d_ptr(std::make_unique<GlobalConfigPrivate>()) {}
 
@@ -218,6 +289,7 @@ GlobalConfig::~GlobalConfig() {}
 void GlobalConfig::load(const RawConfig &rawConfig, bool partial) {
     FCITX_D();
     d->load(rawConfig, partial);
+    d->rebuildHotkeyMatcher();
 }
 
 void GlobalConfig::save(RawConfig &config) const {
@@ -285,6 +357,11 @@ const KeyList &GlobalConfig::togglePreeditKeys() const {
     return *d->hotkey->togglePreedit;
 }
 
+const KeyMatcher &GlobalConfig::hotkeyMatcher() const {
+    FCITX_D();
+    return d->hotkeyMatcher_;
+}
+
 bool GlobalConfig::activeByDefault() const {
     FCITX_D();
     return d->behavior->activeByDefault.value();
@@ -395,6 +472,26 @@ bool GlobalConfig::showPreeditForPassword() const {
     return *d->behavior->showPreeditForPassword;
 }
 
+int GlobalConfig::uiUpdateInterval() const {
+    FCITX_D();
+    return *d->behavior->uiUpdateInterval;
+}
+
+int GlobalConfig::cursorRectThreshold() const {
+    FCITX_D();
+    return *d->behavior->cursorRectThreshold;
+}
+
+int GlobalConfig::cursorRectUpdateInterval() const {
+    FCITX_D();
+    return *d->behavior->cursorRectUpdateInterval;
+}
+
+int GlobalConfig::trimMemoryAfterIdle() const {
+    FCITX_D();
+    return *d->behavior->trimMemoryAfterIdle;
+}
+
 int GlobalConfig::autoSavePeriod() const {
     FCITX_D();
     return *d->behavior->autoSavePeriod;
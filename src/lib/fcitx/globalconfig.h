@@ -19,6 +19,25 @@ namespace fcitx {
 
 class GlobalConfigPrivate;
 
+/**
+ * Hotkeys that are handled by Instance.
+ *
+ * The value is the group of the hotkey in GlobalConfig::hotkeyMatcher.
+ *
+ * @since 5.1.12
+ */
+enum class GlobalHotkey {
+    Trigger,
+    AltTrigger,
+    Activate,
+    Deactivate,
+    EnumerateForward,
+    EnumerateBackward,
+    EnumerateGroupForward,
+    EnumerateGroupBackward,
+    TogglePreedit,
+};
+
 class FCITXCORE_EXPORT GlobalConfig {
 public:
     GlobalConfig();
@@ -35,6 +54,16 @@ public:
     const KeyList &enumerateGroupBackwardKeys() const;
     const KeyList &togglePreeditKeys() const;
 
+    /**
+     * Matcher of all the hotkeys in GlobalHotkey.
+     *
+     * It is rebuilt when the config is loaded.
+     *
+     * @see GlobalHotkey
+     * @since 5.1.12
+     */
+    const KeyMatcher &hotkeyMatcher() const;
+
     bool activeByDefault() const;
 
     /**
@@ -109,6 +138,49 @@ public:
      */
     int autoSavePeriod() const;
 
+    /**
+     * Minimum interval in milliseconds between two user interface flushes
+     * caused by key events.
+     *
+     * Updates that arrive within the interval are coalesced and flushed when
+     * it ends. Immediate updates and key events that commit text are never
+     * delayed.
+     *
+     * @return the interval, 0 means flush after every key event.
+     * @since 5.1.12
+     */
+    int uiUpdateInterval() const;
+
+    /**
+     * Cursor rect changes that keep the size and move less than the threshold
+     * in pixels from the last applied one are ignored.
+     *
+     * @return the threshold, 0 means every change is applied.
+     * @since 5.1.12
+     */
+    int cursorRectThreshold() const;
+
+    /**
+     * Minimum interval in milliseconds between two cursor rect changed
+     * events of an input context.
+     *
+     * The cursor rect itself is always updated, only the event is delayed
+     * until the interval ends.
+     *
+     * @return the interval, 0 means sending event for every change.
+     * @since 5.1.12
+     */
+    int cursorRectUpdateInterval() const;
+
+    /**
+     * Number of minutes without input before fcitx releases the caches.
+     *
+     * @return the idle time, 0 means never.
+     * @see Instance::trimMemory
+     * @since 5.1.12
+     */
+    int trimMemoryAfterIdle() const;
+
     const std::vector<std::string> &enabledAddons() const;
     const std::vector<std::string> &disabledAddons() const;
 
@@ -11,9 +11,11 @@
 #include <fstream>
 #include <limits>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-config/marshallfunction.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/mtime_p.h"
 #include "misc_p.h"
@@ -347,6 +349,10 @@ IconThemeCache::lookup(const std::string &name) const {
     return ret;
 }
 
+// Check whether the icon directories are changed at most once per interval.
+constexpr uint64_t iconCacheCheckInterval = 5000000;
+constexpr size_t maxIconCacheSize = 1024;
+
 class IconThemePrivate : QPtrHolder<IconTheme> {
 public:
     IconThemePrivate(IconTheme *q, const StandardPath &path)
@@ -385,9 +391,9 @@ public:
             if (auto subConfig = section->get(name)) {
                 std::string directories;
                 unmarshallOption(directories, *subConfig, false);
-                for (const auto &directory :
-                     stringutils::split(directories, ",")) {
-                    if (auto directoryConfig = config.get(directory)) {
+                for (auto directory : stringutils::splitView(directories, ",")) {
+                    if (auto directoryConfig =
+                            config.get(std::string(directory))) {
                         try {
                             dir.emplace_back(*directoryConfig);
                         } catch (...) {
@@ -407,12 +413,8 @@ public:
         if (auto subConfig = section->get("Inherits")) {
             std::string inherits;
             unmarshallOption(inherits, *subConfig, false);
-            for (const auto &inherit : stringutils::split(inherits, ",")) {
-                if (!parent) {
-                    addInherit(inherit);
-                } else {
-                    parent->d_ptr->addInherit(inherit);
-                }
+            for (auto inherit : stringutils::splitView(inherits, ",")) {
+                addInherit(std::string(inherit));
             }
         }
 
@@ -424,15 +426,116 @@ public:
 
     void addInherit(const std::string &inherit) {
         if (subThemeNames_.insert(inherit).second) {
+            inheritNames_.push_back(inherit);
+        }
+    }
+
+    // Inherited themes are only parsed when an icon is not found in this
+    // theme, many lookup never need them.
+    void loadInherits() {
+        if (loadedInherits_ == inheritNames_.size()) {
+            return;
+        }
+        while (loadedInherits_ < inheritNames_.size()) {
+            auto name = inheritNames_[loadedInherits_];
+            loadedInherits_ += 1;
             try {
-                inherits_.push_back(IconTheme(inherit, q_ptr, standardPath_));
+                // Parent is only used to tell it is not a top level theme.
+                IconTheme theme(name, q_ptr, standardPath_);
+                // Inherited themes of inherited themes are flattened to top
+                // level theme, right after the theme that inherits them.
+                auto *d = theme.d_func();
+                auto pos = loadedInherits_;
+                for (const auto &inherit : d->inheritNames_) {
+                    if (subThemeNames_.insert(inherit).second) {
+                        inheritNames_.insert(inheritNames_.begin() + pos,
+                                             inherit);
+                        pos += 1;
+                    }
+                }
+                d->inheritNames_.clear();
+                inherits_.push_back(std::move(theme));
             } catch (...) {
             }
         }
+        // Cached results are still valid, but the directories to check are
+        // changed.
+        if (lastIconCacheCheck_) {
+            baseDirTimes_ = baseDirTimes();
+        }
+    }
+
+    // Same as findIcon, but remember the result. Callers like tray and menu
+    // ask for the same few icons over and over again, and a theme without
+    // icon-theme.cache need to stat every directory.
+    std::string cachedFindIcon(const std::string &icon, int size, int scale,
+                               const std::vector<std::string> &extensions) {
+        if (icon.empty() || icon[0] == '/') {
+            return icon;
+        }
+        checkIconCache();
+        std::string key = icon;
+        key.push_back('\0');
+        key.append(std::to_string(size));
+        key.push_back('@');
+        key.append(std::to_string(scale));
+        for (const auto &extension : extensions) {
+            key.push_back('\0');
+            key.append(extension);
+        }
+        if (auto iter = iconCache_.find(key); iter != iconCache_.end()) {
+            // Removing a file does not change the time of base directory.
+            if (iter->second.empty() || fs::isreg(iter->second)) {
+                return iter->second;
+            }
+            iconCache_.erase(iter);
+        }
+        auto filename = findIcon(icon, size, scale, extensions);
+        if (iconCache_.size() >= maxIconCacheSize) {
+            iconCache_.clear();
+        }
+        iconCache_.emplace(std::move(key), filename);
+        return filename;
+    }
+
+    // Similar to gtk, only installing or removing a directory of the theme
+    // invalidates the cache.
+    void checkIconCache() {
+        const auto current = now(CLOCK_MONOTONIC);
+        if (lastIconCacheCheck_ &&
+            current < lastIconCacheCheck_ + iconCacheCheckInterval) {
+            return;
+        }
+        lastIconCacheCheck_ = current;
+        auto times = baseDirTimes();
+        if (times != baseDirTimes_) {
+            iconCache_.clear();
+            baseDirTimes_ = std::move(times);
+        }
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> baseDirTimes() const {
+        std::vector<std::pair<int64_t, int64_t>> times;
+        auto addTimes = [&times](const IconThemePrivate *theme) {
+            for (const auto &baseDir : theme->baseDirs_) {
+                struct stat st;
+                if (stat(baseDir.first.c_str(), &st) == 0) {
+                    auto time = modifiedTime(st);
+                    times.emplace_back(time.sec, time.nsec);
+                } else {
+                    times.emplace_back(-1, -1);
+                }
+            }
+        };
+        addTimes(this);
+        for (const auto &inherit : inherits_) {
+            addTimes(inherit.d_func());
+        }
+        return times;
     }
 
     std::string findIcon(const std::string &icon, int size, int scale,
-                         const std::vector<std::string> &extensions) const {
+                         const std::vector<std::string> &extensions) {
         // Respect absolute path.
         if (icon.empty() || icon[0] == '/') {
             return icon;
@@ -462,12 +565,13 @@ public:
 
     std::string
     findIconHelper(const std::string &icon, int size, int scale,
-                   const std::vector<std::string> &extensions) const {
+                   const std::vector<std::string> &extensions) {
         auto filename = lookupIcon(icon, size, scale, extensions);
         if (!filename.empty()) {
             return filename;
         }
 
+        loadInherits();
         for (const auto &inherit : inherits_) {
             filename =
                 inherit.d_func()->lookupIcon(icon, size, scale, extensions);
@@ -623,10 +727,15 @@ public:
     I18NString name_;
     I18NString comment_;
     std::vector<IconTheme> inherits_;
+    std::vector<std::string> inheritNames_;
+    size_t loadedInherits_ = 0;
     std::vector<IconThemeDirectory> directories_;
     std::vector<IconThemeDirectory> scaledDirectories_;
     std::unordered_set<std::string> subThemeNames_;
     std::vector<std::pair<std::string, IconThemeCache>> baseDirs_;
+    std::unordered_map<std::string, std::string> iconCache_;
+    std::vector<std::pair<int64_t, int64_t>> baseDirTimes_;
+    uint64_t lastIconCacheCheck_ = 0;
     // Not really useful for our usecase.
     // bool hidden_;
     std::string example_;
@@ -666,8 +775,13 @@ FCITX_DEFINE_DEFAULT_DTOR_AND_MOVE(IconTheme);
 FCITX_DEFINE_READ_ONLY_PROPERTY_PRIVATE(IconTheme, std::string, internalName);
 FCITX_DEFINE_READ_ONLY_PROPERTY_PRIVATE(IconTheme, I18NString, name);
 FCITX_DEFINE_READ_ONLY_PROPERTY_PRIVATE(IconTheme, I18NString, comment);
-FCITX_DEFINE_READ_ONLY_PROPERTY_PRIVATE(IconTheme, std::vector<IconTheme>,
-                                        inherits);
+
+const std::vector<IconTheme> &IconTheme::inherits() const {
+    auto *d = const_cast<IconThemePrivate *>(d_func());
+    d->loadInherits();
+    return d->inherits_;
+}
+
 FCITX_DEFINE_READ_ONLY_PROPERTY_PRIVATE(IconTheme,
                                         std::vector<IconThemeDirectory>,
                                         directories);
@@ -687,8 +801,9 @@ std::string
 IconTheme::findIcon(const std::string &iconName, unsigned int desiredSize,
                     int scale,
                     const std::vector<std::string> &extensions) const {
-    FCITX_D();
-    return d->findIcon(iconName, desiredSize, scale, extensions);
+    // The cache is not part of the observable state of the theme.
+    auto *d = const_cast<IconThemePrivate *>(d_func());
+    return d->cachedFindIcon(iconName, desiredSize, scale, extensions);
 }
 
 std::string getKdeTheme(int fd) {
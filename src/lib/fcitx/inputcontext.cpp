@@ -11,12 +11,15 @@
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include "fcitx-utils/utf8.h"
 #include "focusgroup.h"
 #include "inputcontext_p.h"
 #include "inputcontextmanager.h"
 #include "instance.h"
 #include "misc_p.h"
+#include "stringpool_p.h"
 #include "userinterfacemanager.h"
 
 namespace fcitx {
@@ -42,10 +45,21 @@ bool shouldDisablePreeditByDefault(const std::string &program) {
         return matchers;
     }();
 
-    return std::any_of(matchers.begin(), matchers.end(),
-                       [&program](const std::regex &regex) {
-                           return std::regex_match(program, regex);
-                       });
+    // Applications tend to create many input contexts, remember the result
+    // so the regular expressions only run once per program.
+    static thread_local std::unordered_map<std::string, bool> cache;
+    if (auto iter = cache.find(program); iter != cache.end()) {
+        return iter->second;
+    }
+    if (cache.size() >= 128) {
+        cache.clear();
+    }
+    bool result = std::any_of(matchers.begin(), matchers.end(),
+                              [&program](const std::regex &regex) {
+                                  return std::regex_match(program, regex);
+                              });
+    cache.emplace(program, result);
+    return result;
 }
 } // namespace
 
@@ -53,7 +67,7 @@ InputContextPrivate::InputContextPrivate(InputContext *q,
                                          InputContextManager &manager,
                                          const std::string &program)
     : QPtrHolder(q), manager_(manager), group_(nullptr), inputPanel_(q),
-      statusArea_(q), program_(program),
+      statusArea_(q), program_(internString(program)),
       isPreeditEnabled_(manager.isPreeditEnabledByDefault() &&
                         !shouldDisablePreeditByDefault(program)) {}
 
@@ -70,7 +84,10 @@ InputContext::InputContext(InputContextManager &manager,
     manager.registerInputContext(*this);
 }
 
-InputContext::~InputContext() { assert(d_ptr->destroyed_); }
+InputContext::~InputContext() {
+    assert(d_ptr->destroyed_);
+    d_ptr->manager_.recycleInputContext(*this);
+}
 
 void InputContext::created() {
     FCITX_D();
@@ -244,12 +261,13 @@ void InputContext::setCursorRect(Rect rect) { setCursorRect(rect, 1.0); }
 
 void InputContext::setCursorRect(Rect rect, double scale) {
     FCITX_D();
-    if (d->cursorRect_ == rect && d->scale_ == scale) {
+    if ((d->cursorRect_ == rect && d->scale_ == scale) ||
+        d->isCursorRectChangeIgnorable(rect, scale)) {
         return;
     }
     d->cursorRect_ = rect;
     d->scale_ = scale;
-    d->emplaceEvent<CursorRectChangedEvent>(this);
+    d->notifyCursorRectChanged();
 }
 
 void InputContext::setFocusGroup(FocusGroup *group) {
@@ -299,7 +317,9 @@ void InputContext::setHasFocus(bool hasFocus) {
     if (hasFocus == d->hasFocus_) {
         return;
     }
+    d->flushNotifications();
     d->hasFocus_ = hasFocus;
+    d->keyRepeatPassThrough_ = false;
     d->manager_.notifyFocus(*this, d->hasFocus_);
     // trigger event
     if (d->hasFocus_) {
@@ -317,7 +337,12 @@ bool InputContext::keyEvent(KeyEvent &event) {
     if (::keyTrace().checkLogLevel(LogLevel::Debug)) {
         start = std::chrono::steady_clock::now();
     }
+    d->flushNotifications();
+    d->keyRepeatPassThrough_ = false;
     auto result = d->postEvent(event);
+    if (result) {
+        d->keyRepeatPassThrough_ = false;
+    }
     FCITX_KEYTRACE() << "KeyEvent handling time: "
                      << std::chrono::duration_cast<std::chrono::milliseconds>(
                             std::chrono::steady_clock::now() - start)
@@ -326,6 +351,45 @@ bool InputContext::keyEvent(KeyEvent &event) {
     return result;
 }
 
+void InputContext::keyEventAsync(KeyEvent &event,
+                                 KeyEventResultCallback callback) {
+    FCITX_D();
+    auto ref = watch();
+    auto *oldCallback = std::exchange(d->asyncKeyEventCallback_, &callback);
+    auto result = keyEvent(event);
+    if (ref.isValid()) {
+        d->asyncKeyEventCallback_ = oldCallback;
+    }
+    if (callback) {
+        callback(result);
+    }
+}
+
+KeyEventResultCallback InputContext::deferKeyEvent() {
+    FCITX_D();
+    if (!d->asyncKeyEventCallback_) {
+        return {};
+    }
+    KeyEventResultCallback callback;
+    std::swap(callback, *d->asyncKeyEventCallback_);
+    d->asyncKeyEventCallback_ = nullptr;
+    // Events produced before the result is known are held, so the client
+    // receives them after the deferred key.
+    auto result =
+        std::make_shared<DeferredKeyEventResult>(this, d, std::move(callback));
+    return [result](bool accepted) { result->resolve(accepted); };
+}
+
+void InputContext::setKeyRepeatPassThrough(bool passThrough) {
+    FCITX_D();
+    d->keyRepeatPassThrough_ = passThrough;
+}
+
+bool InputContext::isKeyRepeatPassThrough() const {
+    FCITX_D();
+    return d->keyRepeatPassThrough_;
+}
+
 bool InputContext::virtualKeyboardEvent(VirtualKeyboardEvent &event) {
     FCITX_D();
     RETURN_IF_HAS_NO_FOCUS(false);
@@ -334,6 +398,7 @@ bool InputContext::virtualKeyboardEvent(VirtualKeyboardEvent &event) {
     if (::keyTrace().checkLogLevel(LogLevel::Debug)) {
         start = std::chrono::steady_clock::now();
     }
+    d->flushNotifications();
     auto result = d->postEvent(event);
     FCITX_KEYTRACE() << "VirtualKeyboardEvent handling time: "
                      << std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -346,6 +411,7 @@ bool InputContext::virtualKeyboardEvent(VirtualKeyboardEvent &event) {
 void InputContext::invokeAction(InvokeActionEvent &event) {
     FCITX_D();
     RETURN_IF_HAS_NO_FOCUS();
+    d->flushNotifications();
     d->postEvent(event);
 }
 
@@ -369,7 +435,7 @@ const SurroundingText &InputContext::surroundingText() const {
 
 void InputContext::updateSurroundingText() {
     FCITX_D();
-    d->emplaceEvent<SurroundingTextUpdatedEvent>(this);
+    d->queueNotification(InputContextPrivate::SurroundingTextNotification);
 }
 
 void InputContext::setBlockEventToClient(bool block) {
@@ -380,7 +446,7 @@ void InputContext::setBlockEventToClient(bool block) {
             "implementation.");
     }
     d->blockEventToClient_ = block;
-    if (!block) {
+    if (!block && !d->deferredKeyEvents_) {
         d->deliverBlockedEvents();
     }
 }
@@ -390,6 +456,11 @@ bool InputContext::hasPendingEvents() const {
     return !d->blockedEvents_.empty();
 }
 
+void InputContext::flushNotifications() {
+    FCITX_D();
+    d->flushNotifications();
+}
+
 bool InputContext::hasPendingEventsStrictOrder() const {
     FCITX_D();
     if (d->blockedEvents_.empty()) {
@@ -397,11 +468,9 @@ bool InputContext::hasPendingEventsStrictOrder() const {
     }
 
     // Check we only have update preedit.
-    if (std::any_of(d->blockedEvents_.begin(), d->blockedEvents_.end(),
-                    [](const auto &event) {
-                        return event->type() !=
-                               EventType::InputContextUpdatePreedit;
-                    })) {
+    if (d->blockedEvents_.anyOf([](const InputContextEvent &event) {
+            return event.type() != EventType::InputContextUpdatePreedit;
+        })) {
         return true;
     }
 
@@ -10,6 +10,7 @@
 
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <fcitx-utils/capabilityflags.h>
@@ -29,6 +30,13 @@
 namespace fcitx {
 using ICUUID = std::array<uint8_t, 16>;
 
+/**
+ * Receive the result of a key event sent with InputContext::keyEventAsync.
+ *
+ * @since 5.1.12
+ */
+using KeyEventResultCallback = std::function<void(bool accepted)>;
+
 class InputContextManager;
 class FocusGroup;
 class InputContextPrivate;
@@ -140,6 +148,60 @@ public:
     /// Send a key event to current input context.
     bool keyEvent(KeyEvent &event);
 
+    /**
+     * Send a key event, and allow its result to be delivered later.
+     *
+     * callback is called with the result before this function returns, unless
+     * a handler of the key event takes it over with deferKeyEvent.
+     *
+     * @see deferKeyEvent
+     * @since 5.1.12
+     */
+    void keyEventAsync(KeyEvent &event, KeyEventResultCallback callback);
+
+    /**
+     * Defer the result of the key event being handled.
+     *
+     * A handler, e.g. an engine that needs to wait for I/O, may filter the key
+     * event and call the returned callback later with the actual result. An
+     * empty callback is returned if the key event is not sent by
+     * keyEventAsync, or the result is already deferred, in which case the key
+     * event must be handled synchronously.
+     *
+     * Until the callback is called or destroyed, events to the client, e.g.
+     * commit string and preedit, are held so they are not delivered before
+     * the result.
+     *
+     * @since 5.1.12
+     */
+    KeyEventResultCallback deferKeyEvent();
+
+    /**
+     * Declare that the repeat of the key event being handled is passed
+     * through.
+     *
+     * An input method may call it with true for a key event it does not
+     * accept, if repeating the key would neither be accepted nor change any
+     * state. A frontend that emulates key repeat may then send the repeated
+     * key to the client directly, without dispatching it.
+     *
+     * It is reset before every key event, when the focus changes, and when
+     * the key event is accepted.
+     *
+     * @see isKeyRepeatPassThrough
+     * @since 5.1.12
+     */
+    void setKeyRepeatPassThrough(bool passThrough);
+
+    /**
+     * Whether the repeat of the last key event can be sent to the client
+     * directly.
+     *
+     * @see setKeyRepeatPassThrough
+     * @since 5.1.12
+     */
+    bool isKeyRepeatPassThrough() const;
+
     /**
      * Send a virtual keyboard event to current input context.
      *
@@ -233,6 +295,18 @@ public:
      */
     bool hasPendingEventsStrictOrder() const;
 
+    /**
+     * Deliver the pending surrounding text and cursor rect notifications.
+     *
+     * SurroundingTextUpdatedEvent and CursorRectChangedEvent are coalesced,
+     * and delivered once on the next event loop iteration with the latest
+     * value. They are also delivered before the next key event or focus
+     * change, so this is only needed if the events are wanted right away.
+     *
+     * @since 5.1.12
+     */
+    void flushNotifications();
+
     /// Returns the input context property by name.
     InputContextProperty *property(const std::string &name);
 
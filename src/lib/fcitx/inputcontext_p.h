@@ -7,11 +7,21 @@
 #ifndef _FCITX_INPUTCONTEXT_P_H_
 #define _FCITX_INPUTCONTEXT_P_H_
 
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <fcitx-utils/event.h>
 #include <fcitx-utils/intrusivelist.h>
 #include <fcitx-utils/uuid_p.h>
 #include <fcitx/inputcontext.h>
 #include <fcitx/inputcontextmanager.h>
+#include <fcitx/globalconfig.h>
 #include <fcitx/inputcontextproperty.h>
 #include <fcitx/inputpanel.h>
 #include <fcitx/instance.h>
@@ -20,6 +30,75 @@
 
 namespace fcitx {
 
+// Events held back while the input context blocks events to client, in the
+// order they are pushed. Commit and preedit updates, which make up most of
+// them, are stored inline, and the storage is kept after the queue is
+// drained.
+class BlockedEventQueue {
+    using Entry = std::variant<CommitStringEvent, UpdatePreeditEvent,
+                               std::unique_ptr<InputContextEvent>>;
+
+public:
+    template <typename E, typename... Args>
+    void emplace(Args &&...args) {
+        if constexpr (std::is_same_v<E, CommitStringEvent> ||
+                      std::is_same_v<E, UpdatePreeditEvent>) {
+            events_.emplace_back(std::in_place_type<E>,
+                                 std::forward<Args>(args)...);
+        } else {
+            events_.emplace_back(
+                std::in_place_type<std::unique_ptr<InputContextEvent>>,
+                std::make_unique<E>(std::forward<Args>(args)...));
+        }
+    }
+
+    bool empty() const { return events_.empty(); }
+    size_t size() const { return events_.size(); }
+
+    template <typename Pred>
+    bool anyOf(Pred pred) const {
+        for (const auto &entry : events_) {
+            if (pred(event(entry))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Deliver every queued event with callback. Events pushed by callback
+    // are kept for the next call.
+    template <typename Callback>
+    void drain(Callback callback) {
+        auto events = std::exchange(events_, {});
+        for (auto &entry : events) {
+            callback(event(entry));
+        }
+        events.clear();
+        if (events_.empty()) {
+            events_ = std::move(events);
+        }
+    }
+
+private:
+    static InputContextEvent &event(Entry &entry) {
+        return std::visit(
+            [](auto &value) -> InputContextEvent & {
+                using Type = std::decay_t<decltype(value)>;
+                if constexpr (std::is_base_of_v<InputContextEvent, Type>) {
+                    return value;
+                } else {
+                    return *value;
+                }
+            },
+            entry);
+    }
+    static const InputContextEvent &event(const Entry &entry) {
+        return event(const_cast<Entry &>(entry));
+    }
+
+    std::vector<Entry> events_;
+};
+
 class InputContextPrivate : public QPtrHolder<InputContext> {
 public:
     InputContextPrivate(InputContext *q, InputContextManager &manager,
@@ -53,9 +132,8 @@ public:
             return;
         }
 
-        if (blockEventToClient_) {
-            blockedEvents_.push_back(
-                std::make_unique<E>(std::forward<Args>(args)...));
+        if (blockEventToClient_ || deferredKeyEvents_) {
+            blockedEvents_.emplace<E>(std::forward<Args>(args)...);
         } else {
             E event(std::forward<Args>(args)...);
             deliverEvent(event, nullptr);
@@ -72,6 +150,13 @@ public:
         properties_[slot].reset(property);
     }
 
+    // Make sure every slot exists, properties are created later.
+    void reserveProperties(size_t size) {
+        if (properties_.size() < size) {
+            properties_.resize(size);
+        }
+    }
+
     void unregisterProperty(int slot) {
         properties_[slot] = std::move(properties_.back());
         properties_.pop_back();
@@ -130,18 +215,114 @@ public:
         }
     }
 
+    // Whether a cursor rect change is small enough to be ignored.
+    bool isCursorRectChangeIgnorable(const Rect &rect, double scale) const {
+        auto *instance = manager_.instance();
+        if (!instance || scale != scale_ ||
+            rect.width() != cursorRect_.width() ||
+            rect.height() != cursorRect_.height()) {
+            return false;
+        }
+        const int threshold = instance->globalConfig().cursorRectThreshold();
+        return std::abs(rect.left() - cursorRect_.left()) < threshold &&
+               std::abs(rect.top() - cursorRect_.top()) < threshold;
+    }
+
+    enum : uint8_t {
+        SurroundingTextNotification = 1,
+        CursorRectNotification = 2,
+    };
+
+    // Clients tend to send the surrounding text and cursor rect in bursts,
+    // only the latest value matters, so post the event once when the event
+    // loop is back, or before the next key event.
+    void queueNotification(uint8_t notification) {
+        auto *instance = manager_.instance();
+        if (destroyed_ || !instance) {
+            return;
+        }
+        pendingNotifications_ |= notification;
+        if (!notificationEvent_) {
+            notificationEvent_ = instance->eventLoop().addDeferEvent(
+                [this](EventSource *) {
+                    flushNotifications();
+                    return true;
+                },
+                "InputContext/Notification");
+        }
+        notificationEvent_->setOneShot();
+    }
+
+    void flushNotifications() {
+        FCITX_Q();
+        if (!pendingNotifications_) {
+            return;
+        }
+        const auto pending = std::exchange(pendingNotifications_, 0);
+        notificationEvent_->setEnabled(false);
+        if (pending & SurroundingTextNotification) {
+            emplaceEvent<SurroundingTextUpdatedEvent>(q);
+        }
+        if (pending & CursorRectNotification) {
+            emplaceEvent<CursorRectChangedEvent>(q);
+        }
+    }
+
+    // Post CursorRectChangedEvent, at most once per cursorRectUpdateInterval.
+    void notifyCursorRectChanged() {
+        auto *instance = manager_.instance();
+        const int interval =
+            instance ? instance->globalConfig().cursorRectUpdateInterval() : 0;
+        if (interval <= 0) {
+            queueNotification(CursorRectNotification);
+            return;
+        }
+        if (cursorRectEvent_ && cursorRectEvent_->isEnabled()) {
+            // The pending event will carry the latest rect.
+            return;
+        }
+        const uint64_t current = now(CLOCK_MONOTONIC);
+        const uint64_t next =
+            lastCursorRectEvent_ + static_cast<uint64_t>(interval) * 1000;
+        if (lastCursorRectEvent_ == 0 || current >= next) {
+            lastCursorRectEvent_ = current;
+            queueNotification(CursorRectNotification);
+            return;
+        }
+        if (!cursorRectEvent_) {
+            cursorRectEvent_ = instance->eventLoop().addTimeEvent(
+                CLOCK_MONOTONIC, next, 0, [this](EventSourceTime *, uint64_t) {
+                    FCITX_Q();
+                    lastCursorRectEvent_ = now(CLOCK_MONOTONIC);
+                    emplaceEvent<CursorRectChangedEvent>(q);
+                    return true;
+                });
+            cursorRectEvent_->setOneShot();
+        } else {
+            cursorRectEvent_->setTime(next);
+            cursorRectEvent_->setOneShot();
+        }
+    }
+
     void deliverBlockedEvents() {
         FCITX_Q();
         std::string commitBuffer;
-        for (const auto &event : blockedEvents_) {
-            deliverEvent(*event, &commitBuffer);
-        }
+        blockedEvents_.drain([this, &commitBuffer](InputContextEvent &event) {
+            deliverEvent(event, &commitBuffer);
+        });
         if (!commitBuffer.empty()) {
             q->commitStringImpl(commitBuffer);
         }
-        blockedEvents_.clear();
     }
 
+    void releaseDeferredKeyEvent() {
+        deferredKeyEvents_--;
+        if (!blockEventToClient_ && !deferredKeyEvents_) {
+            deliverBlockedEvents();
+        }
+    }
+
+    // Return null if the property is not created yet.
     InputContextProperty *property(int slot) { return properties_[slot].get(); }
 
     InputContextManager &manager_;
@@ -151,23 +332,73 @@ public:
     bool hasFocus_ = false;
     bool clientControlVirtualkeyboardShow_ = false;
     bool clientControlVirtualkeyboardHide_ = false;
-    std::string program_;
+    // Interned, so input contexts of the same program can be compared by
+    // address.
+    const std::string &program_;
     CapabilityFlags capabilityFlags_;
     bool isPreeditEnabled_ = true;
     SurroundingText surroundingText_;
     Rect cursorRect_;
     double scale_ = 1.0;
+    uint64_t lastCursorRectEvent_ = 0;
+    std::unique_ptr<EventSourceTime> cursorRectEvent_;
+    uint8_t pendingNotifications_ = 0;
+    std::unique_ptr<EventSource> notificationEvent_;
+    // The result callback of the key event sent by keyEventAsync.
+    KeyEventResultCallback *asyncKeyEventCallback_ = nullptr;
+    bool keyRepeatPassThrough_ = false;
 
     IntrusiveListNode listNode_;
     IntrusiveListNode focusedListNode_;
     ICUUID uuid_;
+    // Position in InputContextManager's list of input contexts of program_.
+    size_t programIndex_ = 0;
     std::vector<std::unique_ptr<InputContextProperty>> properties_;
     bool destroyed_ = false;
 
-    std::list<std::unique_ptr<InputContextEvent>> blockedEvents_;
+    BlockedEventQueue blockedEvents_;
     bool blockEventToClient_ = false;
+    // Key events deferred by deferKeyEvent that are not resolved yet. Events
+    // to client are held until all of them are resolved.
+    size_t deferredKeyEvents_ = 0;
     bool lastPreeditUpdateIsEmpty_ = true;
 };
+
+// Result of a key event taken over by deferKeyEvent. The input context stops
+// holding the events to client once it is resolved, or dropped.
+class DeferredKeyEventResult {
+public:
+    DeferredKeyEventResult(InputContext *ic, InputContextPrivate *d,
+                           KeyEventResultCallback callback)
+        : ic_(ic->watch()), d_(d), callback_(std::move(callback)) {
+        d_->deferredKeyEvents_++;
+    }
+
+    ~DeferredKeyEventResult() { release(); }
+
+    void resolve(bool accepted) {
+        if (auto callback = std::exchange(callback_, nullptr)) {
+            callback(accepted);
+        }
+        release();
+    }
+
+private:
+    void release() {
+        if (std::exchange(released_, true)) {
+            return;
+        }
+        if (ic_.isValid()) {
+            d_->releaseDeferredKeyEvent();
+        }
+    }
+
+    TrackableObjectReference<InputContext> ic_;
+    InputContextPrivate *d_;
+    KeyEventResultCallback callback_;
+    bool released_ = false;
+};
+
 } // namespace fcitx
 
 #endif // _FCITX_INPUTCONTEXT_P_H_
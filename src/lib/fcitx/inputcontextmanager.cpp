@@ -7,8 +7,14 @@
 
 #include "inputcontextmanager.h"
 #include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "fcitx-utils/intrusivelist.h"
 #include "fcitx-utils/log.h"
 #include "fcitx/misc_p.h"
@@ -38,15 +44,98 @@ public:
     void updatePreeditImpl() override {}
 };
 
-struct container_hasher {
-    template <class T>
-    std::size_t operator()(const T &c) const {
-        std::size_t seed = 0;
-        for (const auto &elem : c) {
-            hash_combine(seed, std::hash<typename T::value_type>()(elem));
+// Open addressing index of input contexts keyed by their UUID. The key is
+// not stored, it's read back from the input context. UUIDs are random, so
+// the leading bytes are already a good hash. Linear probing with backward
+// shift deletion keeps the table free of tombstones.
+class InputContextUUIDIndex {
+public:
+    InputContext *find(const ICUUID &uuid) const {
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        for (size_t i = hash(uuid) & mask();; i = (i + 1) & mask()) {
+            auto *ic = slots_[i];
+            if (!ic) {
+                return nullptr;
+            }
+            if (ic->uuid() == uuid) {
+                return ic;
+            }
         }
-        return seed;
     }
+
+    // Return false if there is already an input context with the same UUID.
+    bool insert(InputContext *ic) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            rehash(slots_.empty() ? initialCapacity : slots_.size() * 2);
+        }
+        size_t i = hash(ic->uuid()) & mask();
+        for (; slots_[i]; i = (i + 1) & mask()) {
+            if (slots_[i]->uuid() == ic->uuid()) {
+                return false;
+            }
+        }
+        slots_[i] = ic;
+        size_ += 1;
+        return true;
+    }
+
+    void erase(InputContext *ic) {
+        if (slots_.empty()) {
+            return;
+        }
+        size_t i = hash(ic->uuid()) & mask();
+        for (; slots_[i] != ic; i = (i + 1) & mask()) {
+            if (!slots_[i]) {
+                return;
+            }
+        }
+        slots_[i] = nullptr;
+        size_ -= 1;
+        // Move back the entries that were displaced past the new hole.
+        for (size_t j = (i + 1) & mask(); slots_[j]; j = (j + 1) & mask()) {
+            size_t home = hash(slots_[j]->uuid()) & mask();
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                slots_[i] = slots_[j];
+                slots_[j] = nullptr;
+                i = j;
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    static constexpr size_t initialCapacity = 64;
+
+    static size_t hash(const ICUUID &uuid) {
+        uint64_t value;
+        static_assert(sizeof(value) <= sizeof(ICUUID));
+        memcpy(&value, uuid.data(), sizeof(value));
+        return static_cast<size_t>(value ^ (value >> 32));
+    }
+
+    size_t mask() const { return slots_.size() - 1; }
+
+    void rehash(size_t capacity) {
+        std::vector<InputContext *> slots(capacity, nullptr);
+        auto old = std::exchange(slots_, std::move(slots));
+        size_ = 0;
+        for (auto *ic : old) {
+            if (ic) {
+                size_t i = hash(ic->uuid()) & mask();
+                while (slots_[i]) {
+                    i = (i + 1) & mask();
+                }
+                slots_[i] = ic;
+                size_ += 1;
+            }
+        }
+    }
+
+    std::vector<InputContext *> slots_;
+    size_t size_ = 0;
 };
 
 struct InputContextListHelper {
@@ -118,7 +207,9 @@ public:
         propertyFactoriesSlots_.push_back(factory);
         for (auto &inputContext : inputContexts_) {
             inputContext.d_func()->registerProperty(
-                factory->slot_, factory->q_func()->create(inputContext));
+                factory->slot_, factory->createOnDemand_
+                                    ? nullptr
+                                    : factory->q_func()->create(inputContext));
         }
         return true;
     }
@@ -147,48 +238,105 @@ public:
 
     inline void registerInputContext(InputContext &inputContext) {
         inputContexts_.push_back(inputContext);
+        createdInputContexts_ += 1;
+        peakInputContexts_ =
+            std::max(peakInputContexts_, inputContexts_.size());
+        if (!recycledProperties_.empty()) {
+            inputContext.d_func()->properties_ =
+                std::move(recycledProperties_.back());
+            recycledProperties_.pop_back();
+            recycledInputContexts_ += 1;
+        }
         int maxRetry = 3;
         do {
             generateUUID(inputContext.d_func()->uuid_.data());
             maxRetry -= 1;
-        } while (!uuidMap_.emplace(inputContext.uuid(), &inputContext).second &&
-                 maxRetry > 0);
+        } while (!uuidIndex_.insert(&inputContext) && maxRetry > 0);
         if (!inputContext.program().empty()) {
-            programMap_[inputContext.program()].insert(&inputContext);
+            auto &programInputContexts = programMap_[&inputContext.program()];
+            inputContext.d_func()->programIndex_ = programInputContexts.size();
+            programInputContexts.push_back(&inputContext);
+        }
+        inputContext.d_func()->reserveProperties(
+            propertyFactoriesSlots_.size());
+        for (auto *factory : propertyFactoriesSlots_) {
+            if (!factory->createOnDemand_) {
+                createProperty(inputContext, factory);
+            }
+        }
+    }
+
+    // Keep the property slots of a destroyed input context for the next one.
+    void recycleInputContext(InputContext &inputContext) {
+        auto &properties = inputContext.d_func()->properties_;
+        // Properties may still refer to the input context.
+        for (auto &property : properties) {
+            property.reset();
+        }
+        properties.clear();
+        if (finalized_ || recycledProperties_.size() >= maxRecycled ||
+            !properties.capacity()) {
+            return;
         }
-        for (auto &p : propertyFactories_) {
-            auto *property = p.second->q_func()->create(inputContext);
-            inputContext.d_func()->registerProperty(p.second->slot_, property);
-            if (property->needCopy() &&
-                (propertyPropagatePolicy_ == PropertyPropagatePolicy::All ||
-                 (!inputContext.program().empty() &&
-                  propertyPropagatePolicy_ ==
-                      PropertyPropagatePolicy::Program))) {
-                auto copyProperty = [&p, &inputContext,
-                                     &property](auto &container) {
-                    for (auto &dstInputContext : container) {
-                        if (toInputContextPointer(dstInputContext) !=
-                            &inputContext) {
-                            toInputContextPointer(dstInputContext)
-                                ->property(p.first)
-                                ->copyTo(property);
-                            break;
-                        }
+        recycledProperties_.push_back(std::move(properties));
+    }
+
+    InputContextProperty *
+    createProperty(InputContext &inputContext,
+                   InputContextPropertyFactoryPrivate *factory) {
+        auto *property = factory->q_func()->create(inputContext);
+        const auto slot = factory->slot_;
+        inputContext.d_func()->registerProperty(slot, property);
+        if (property->needCopy() &&
+            (propertyPropagatePolicy_ == PropertyPropagatePolicy::All ||
+             (!inputContext.program().empty() &&
+              propertyPropagatePolicy_ == PropertyPropagatePolicy::Program))) {
+            // Shared properties are kept in sync, so any input context that
+            // already has it created is good to copy from.
+            auto copyProperty = [slot, &inputContext,
+                                 property](auto &container) {
+                for (auto &dstInputContext : container) {
+                    auto *other = toInputContextPointer(dstInputContext);
+                    if (other == &inputContext) {
+                        continue;
                     }
-                };
-                if (propertyPropagatePolicy_ == PropertyPropagatePolicy::All) {
-                    copyProperty(inputContexts_);
-                } else {
-                    auto iter = programMap_.find(inputContext.program());
-                    if (iter != programMap_.end()) {
-                        copyProperty(iter->second);
+                    if (auto *source = other->d_func()->property(slot)) {
+                        source->copyTo(property);
+                        break;
                     }
                 }
+            };
+            if (propertyPropagatePolicy_ == PropertyPropagatePolicy::All) {
+                copyProperty(inputContexts_);
+            } else {
+                auto iter = programMap_.find(&inputContext.program());
+                if (iter != programMap_.end()) {
+                    copyProperty(iter->second);
+                }
             }
         }
+        return property;
     }
 
-    std::unordered_map<ICUUID, InputContext *, container_hasher> uuidMap_;
+    void unregisterProgram(InputContext &inputContext) {
+        auto iter = programMap_.find(&inputContext.program());
+        if (iter == programMap_.end()) {
+            return;
+        }
+        auto &programInputContexts = iter->second;
+        const auto index = inputContext.d_func()->programIndex_;
+        assert(index < programInputContexts.size() &&
+               programInputContexts[index] == &inputContext);
+        // Swap with the last one, order within a program doesn't matter.
+        programInputContexts[index] = programInputContexts.back();
+        programInputContexts[index]->d_func()->programIndex_ = index;
+        programInputContexts.pop_back();
+        if (programInputContexts.empty()) {
+            programMap_.erase(iter);
+        }
+    }
+
+    InputContextUUIDIndex uuidIndex_;
     IntrusiveList<InputContext, InputContextListHelper> inputContexts_;
     IntrusiveList<InputContext, InputContextFocusedListHelper>
         focusedInputContexts_;
@@ -199,12 +347,24 @@ public:
     std::unordered_map<std::string, InputContextPropertyFactoryPrivate *>
         propertyFactories_;
     std::vector<InputContextPropertyFactoryPrivate *> propertyFactoriesSlots_;
-    std::unordered_map<std::string, std::unordered_set<InputContext *>>
+    // Input contexts of each program, InputContextPrivate::programIndex_ is
+    // the position in the vector.
+    // Keyed by the interned program name.
+    std::unordered_map<const std::string *, std::vector<InputContext *>>
         programMap_;
     PropertyPropagatePolicy propertyPropagatePolicy_ =
         PropertyPropagatePolicy::No;
     bool finalized_ = false;
     bool preeditEnabledByDefault_ = true;
+
+    static constexpr size_t maxRecycled = 32;
+    // Cleared property slot vectors, with capacity kept.
+    std::vector<std::vector<std::unique_ptr<InputContextProperty>>>
+        recycledProperties_;
+    size_t peakInputContexts_ = 0;
+    uint64_t createdInputContexts_ = 0;
+    uint64_t recycledInputContexts_ = 0;
+
     std::unique_ptr<InputContext> dummyInputContext_;
 };
 
@@ -242,8 +402,7 @@ InputContextManager::~InputContextManager() {
 
 InputContext *InputContextManager::findByUUID(ICUUID uuid) {
     FCITX_D();
-    auto iter = d->uuidMap_.find(uuid);
-    return (iter == d->uuidMap_.end()) ? nullptr : iter->second;
+    return d->uuidIndex_.find(uuid);
 }
 
 bool InputContextManager::foreach(const InputContextVisitor &visitor) {
@@ -324,15 +483,9 @@ void InputContextManager::registerInputContext(InputContext &inputContext) {
 void InputContextManager::unregisterInputContext(InputContext &inputContext) {
     FCITX_D();
     if (!inputContext.program().empty()) {
-        auto iter = d->programMap_.find(inputContext.program());
-        if (iter != d->programMap_.end()) {
-            iter->second.erase(&inputContext);
-            if (iter->second.empty()) {
-                d->programMap_.erase(iter);
-            }
-        }
+        d->unregisterProgram(inputContext);
     }
-    d->uuidMap_.erase(inputContext.uuid());
+    d->uuidIndex_.erase(&inputContext);
     d->inputContexts_.erase(d->inputContexts_.iterator_to(inputContext));
 
     if (d->focusedInputContexts_.isInList(inputContext)) {
@@ -341,6 +494,11 @@ void InputContextManager::unregisterInputContext(InputContext &inputContext) {
     }
 }
 
+void InputContextManager::recycleInputContext(InputContext &inputContext) {
+    FCITX_D();
+    d->recycleInputContext(inputContext);
+}
+
 void InputContextManager::registerFocusGroup(FocusGroup &group) {
     FCITX_D();
     FCITX_DEBUG() << "Register focus group for display: " << group.display();
@@ -370,9 +528,18 @@ InputContextManager::factoryForName(const std::string &name) {
 InputContextProperty *
 InputContextManager::property(InputContext &inputContext,
                               const InputContextPropertyFactory *factory) {
+    FCITX_D();
     assert(factory->d_func()->manager_ == this);
-    return InputContextManagerPrivate::toInputContextPrivate(inputContext)
-        ->property(factory->d_func()->slot_);
+    if (auto *property =
+            InputContextManagerPrivate::toInputContextPrivate(inputContext)
+                ->property(factory->d_func()->slot_)) {
+        return property;
+    }
+    // Factory is only const to the caller, registration already requires a
+    // mutable one.
+    return d->createProperty(
+        inputContext,
+        const_cast<InputContextPropertyFactoryPrivate *>(factory->d_func()));
 }
 
 void InputContextManager::propagateProperty(
@@ -387,13 +554,21 @@ void InputContextManager::propagateProperty(
 
     auto *property = this->property(inputContext, factory);
     auto factoryRef = factory->watch();
-    auto copyProperty = [this, &factoryRef, &inputContext,
+    auto copyProperty = [&factoryRef, &inputContext,
                          &property](auto &container) {
         for (auto &dstInputContext_ : container) {
             if (const auto *factory = factoryRef.get()) {
                 auto dstInputContext = toInputContextPointer(dstInputContext_);
-                if (dstInputContext != &inputContext) {
-                    property->copyTo(this->property(*dstInputContext, factory));
+                if (dstInputContext == &inputContext) {
+                    continue;
+                }
+                // Don't create on demand properties here, they copy the
+                // value from their peers when they are created.
+                if (auto *dstProperty =
+                        InputContextManagerPrivate::toInputContextPrivate(
+                            *dstInputContext)
+                            ->property(factory->d_func()->slot_)) {
+                    property->copyTo(dstProperty);
                 }
             }
         }
@@ -402,7 +577,7 @@ void InputContextManager::propagateProperty(
     if (d->propertyPropagatePolicy_ == PropertyPropagatePolicy::All) {
         copyProperty(d->inputContexts_);
     } else {
-        auto iter = d->programMap_.find(inputContext.program());
+        auto iter = d->programMap_.find(&inputContext.program());
         if (iter != d->programMap_.end()) {
             copyProperty(iter->second);
         }
@@ -468,4 +643,67 @@ bool InputContextManager::isPreeditEnabledByDefault() const {
     FCITX_D();
     return d->preeditEnabledByDefault_;
 }
+
+size_t InputContextManager::inputContextCount() const {
+    FCITX_D();
+    return d->inputContexts_.size();
+}
+
+size_t InputContextManager::peakInputContextCount() const {
+    FCITX_D();
+    return d->peakInputContexts_;
+}
+
+uint64_t InputContextManager::createdInputContextCount() const {
+    FCITX_D();
+    return d->createdInputContexts_;
+}
+
+uint64_t InputContextManager::recycledInputContextCount() const {
+    FCITX_D();
+    return d->recycledInputContexts_;
+}
+
+std::vector<InputContextPropertyUsage>
+InputContextManager::propertyUsage() const {
+    FCITX_D();
+    std::vector<InputContextPropertyUsage> result;
+    result.reserve(d->propertyFactoriesSlots_.size());
+    for (const auto *factory : d->propertyFactoriesSlots_) {
+        auto &usage = result.emplace_back();
+        usage.name = factory->name_;
+    }
+    for (const auto &inputContext : d->inputContexts_) {
+        const auto &properties =
+            InputContextManagerPrivate::toInputContextPrivate(inputContext)
+                ->properties_;
+        for (size_t slot = 0; slot < properties.size(); slot++) {
+            if (properties[slot]) {
+                result[slot].count += 1;
+            }
+        }
+    }
+    for (size_t slot = 0; slot < result.size(); slot++) {
+        result[slot].bytes =
+            result[slot].count *
+            d->propertyFactoriesSlots_[slot]->q_func()->propertySize();
+    }
+    return result;
+}
+
+size_t InputContextManager::propertyMemoryUsage(
+    const InputContext &inputContext) const {
+    FCITX_D();
+    const auto &properties =
+        InputContextManagerPrivate::toInputContextPrivate(inputContext)
+            ->properties_;
+    size_t result = properties.capacity() * sizeof(properties[0]);
+    for (size_t slot = 0; slot < properties.size(); slot++) {
+        if (properties[slot]) {
+            result +=
+                d->propertyFactoriesSlots_[slot]->q_func()->propertySize();
+        }
+    }
+    return result;
+}
 } // namespace fcitx
@@ -7,7 +7,11 @@
 #ifndef _FCITX_INPUTCONTEXTMANAGER_H_
 #define _FCITX_INPUTCONTEXTMANAGER_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include <fcitx-config/enum.h>
 #include <fcitx-utils/macros.h>
 #include <fcitx/inputcontext.h>
@@ -23,6 +27,21 @@ typedef std::function<bool(FocusGroup *ic)> FocusGroupVisitor;
 
 FCITX_CONFIG_ENUM(PropertyPropagatePolicy, All, Program, No);
 
+/**
+ * Memory usage of the properties from one InputContextPropertyFactory.
+ *
+ * @see InputContextManager::propertyUsage
+ * @since 5.1.12
+ */
+struct InputContextPropertyUsage {
+    /// Name used to register the property.
+    std::string name;
+    /// Number of created properties.
+    size_t count = 0;
+    /// Approximate memory used in bytes, based on the property size.
+    size_t bytes = 0;
+};
+
 class FCITXCORE_EXPORT InputContextManager {
     friend class InputContext;
     friend class FocusGroup;
@@ -114,12 +133,60 @@ public:
     void setPreeditEnabledByDefault(bool enable);
     bool isPreeditEnabledByDefault() const;
 
+    /**
+     * Return the number of live input contexts, including the dummy one.
+     *
+     * @since 5.1.12
+     */
+    size_t inputContextCount() const;
+
+    /**
+     * Return the highest number of live input contexts seen.
+     *
+     * @since 5.1.12
+     */
+    size_t peakInputContextCount() const;
+
+    /**
+     * Return the number of input contexts created so far.
+     *
+     * @since 5.1.12
+     */
+    uint64_t createdInputContextCount() const;
+
+    /**
+     * Return the number of input contexts that reused the storage left by a
+     * destroyed one.
+     *
+     * @since 5.1.12
+     */
+    uint64_t recycledInputContextCount() const;
+
+    /**
+     * Return the memory usage of each registered property.
+     *
+     * @see InputContextPropertyFactory::setPropertySize
+     * @since 5.1.12
+     */
+    std::vector<InputContextPropertyUsage> propertyUsage() const;
+
+    /**
+     * Return the approximate memory used by the properties of inputContext.
+     *
+     * This includes the property slots, and the properties that are created
+     * from a factory with property size.
+     *
+     * @since 5.1.12
+     */
+    size_t propertyMemoryUsage(const InputContext &inputContext) const;
+
 private:
     void finalize();
 
     void setInstance(Instance *instance);
     void registerInputContext(InputContext &inputContext);
     void unregisterInputContext(InputContext &inputContext);
+    void recycleInputContext(InputContext &inputContext);
 
     void registerFocusGroup(FocusGroup &group);
     void unregisterFocusGroup(FocusGroup &group);
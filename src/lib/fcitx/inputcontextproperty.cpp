@@ -25,4 +25,24 @@ void InputContextPropertyFactory::unregister() {
         d->manager_->unregisterProperty(d->name_);
     }
 }
+
+void InputContextPropertyFactory::setCreateOnDemand(bool onDemand) {
+    FCITX_D();
+    d->createOnDemand_ = onDemand;
+}
+
+bool InputContextPropertyFactory::createOnDemand() const {
+    FCITX_D();
+    return d->createOnDemand_;
+}
+
+void InputContextPropertyFactory::setPropertySize(size_t size) {
+    FCITX_D();
+    d->propertySize_ = size;
+}
+
+size_t InputContextPropertyFactory::propertySize() const {
+    FCITX_D();
+    return d->propertySize_;
+}
 } // namespace fcitx
@@ -7,6 +7,7 @@
 #ifndef _FCITX_INPUTCONTEXTPROPERTY_H_
 #define _FCITX_INPUTCONTEXTPROPERTY_H_
 
+#include <cstddef>
 #include <memory>
 #include <fcitx-utils/macros.h>
 #include <fcitx-utils/trackableobject.h>
@@ -77,6 +78,39 @@ public:
     /// Unregister the factory from current InputContextManager.
     void unregister();
 
+    /**
+     * Only create the property when it is accessed for the first time.
+     *
+     * By default the property is created together with every input context.
+     * Factories whose property does not need to exist before being used may
+     * set this to make creating input context cheaper. If the property needs
+     * copy, the state is copied from another input context when the property
+     * is created.
+     *
+     * @since 5.1.12
+     */
+    void setCreateOnDemand(bool onDemand);
+
+    /// @see setCreateOnDemand
+    /// @since 5.1.12
+    bool createOnDemand() const;
+
+    /**
+     * Set the approximate memory used by one property, in bytes.
+     *
+     * It is only used for memory usage accounting, and set to the size of
+     * property type by SimpleInputContextPropertyFactory and
+     * LambdaInputContextPropertyFactory.
+     *
+     * @see InputContextManager::propertyUsage
+     * @since 5.1.12
+     */
+    void setPropertySize(size_t size);
+
+    /// @see setPropertySize
+    /// @since 5.1.12
+    size_t propertySize() const;
+
 private:
     std::unique_ptr<InputContextPropertyFactoryPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(InputContextPropertyFactory);
@@ -86,6 +120,7 @@ template <typename T>
 class SimpleInputContextPropertyFactory : public InputContextPropertyFactory {
 public:
     typedef T PropertyType;
+    SimpleInputContextPropertyFactory() { setPropertySize(sizeof(T)); }
     InputContextProperty *create(InputContext &) override { return new T; }
 };
 
@@ -94,7 +129,9 @@ class LambdaInputContextPropertyFactory : public InputContextPropertyFactory {
 public:
     typedef Ret PropertyType;
     LambdaInputContextPropertyFactory(std::function<Ret *(InputContext &)> f)
-        : func_(std::move(f)) {}
+        : func_(std::move(f)) {
+        setPropertySize(sizeof(Ret));
+    }
 
     InputContextProperty *create(InputContext &ic) override {
         return func_(ic);
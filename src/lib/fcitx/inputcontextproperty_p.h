@@ -7,6 +7,7 @@
 #ifndef _FCITX_INPUTCONTEXTPROPERTY_P_H_
 #define _FCITX_INPUTCONTEXTPROPERTY_P_H_
 
+#include <cstddef>
 #include <string>
 #include "inputcontextproperty.h"
 
@@ -20,6 +21,8 @@ public:
     InputContextManager *manager_ = nullptr;
     int slot_ = -1;
     std::string name_;
+    bool createOnDemand_ = false;
+    size_t propertySize_ = 0;
 };
 } // namespace fcitx
 
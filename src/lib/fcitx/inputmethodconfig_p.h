@@ -39,6 +39,9 @@ FCITX_CONFIGURATION(
     Option<std::string> languageCode{this, "LangCode", "Language Code"};
     Option<std::string> addon{this, "Addon", "Addon"};
     Option<bool> configurable{this, "Configurable", "Configurable", false};
+    Option<int, IntConstrain> surroundingTextWindow{
+        this, "SurroundingTextWindow", "Surrounding Text Window", 0,
+        IntConstrain(0)};
     Option<bool> enable{this, "Enable", "Enable", true};)
 
 FCITX_CONFIGURATION(InputMethodInfo, Option<InputMethodInfoBase> im{
@@ -58,7 +61,8 @@ inline InputMethodEntry toInputMethodEntry(const std::string &uniqueName,
     }
     result.setIcon(*config.im->icon)
         .setLabel(*config.im->label)
-        .setConfigurable(*config.im->configurable);
+        .setConfigurable(*config.im->configurable)
+        .setSurroundingTextWindow(*config.im->surroundingTextWindow);
     return result;
 }
 } // namespace fcitx
@@ -5,7 +5,10 @@
  *
  */
 #include "inputmethodengine.h"
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include "inputcontext.h"
 #include "inputpanel.h"
 
@@ -43,6 +46,19 @@ void InputMethodEngine::virtualKeyboardEvent(
     }
 }
 
+std::optional<InputMethodEntry>
+InputMethodEngine::lookupInputMethod(const std::string &uniqueName) {
+    if (auto *this5 = dynamic_cast<InputMethodEngineV5 *>(this)) {
+        return this5->lookupInputMethodImpl(uniqueName);
+    }
+    for (auto &entry : listInputMethods()) {
+        if (entry.uniqueName() == uniqueName) {
+            return std::move(entry);
+        }
+    }
+    return std::nullopt;
+}
+
 void defaultInvokeActionBehavior(InvokeActionEvent &event) {
     auto ic = event.inputContext();
     auto commit = ic->inputPanel().clientPreedit().toStringForCommit();
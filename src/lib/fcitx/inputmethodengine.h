@@ -7,6 +7,9 @@
 #ifndef _FCITX_INPUTMETHODENGINE_H_
 #define _FCITX_INPUTMETHODENGINE_H_
 
+#include <optional>
+#include <string>
+#include <vector>
 #include <fcitx/addoninstance.h>
 #include <fcitx/event.h>
 #include <fcitx/inputmethodentry.h>
@@ -29,6 +32,10 @@ public:
     /**
      * Main function where the input method handles a key event.
      *
+     * An engine that can't decide without waiting, e.g. for a large
+     * dictionary or a remote predictor, may filter the key and take over its
+     * result with InputContext::deferKeyEvent.
+     *
      * @param entry input method entry
      * @param event key event
      */
@@ -182,6 +189,17 @@ public:
      */
     void virtualKeyboardEvent(const InputMethodEntry &entry,
                               VirtualKeyboardEvent &VirtualKeyboardEvent);
+
+    /**
+     * Create the entry of a single input method by its unique name.
+     *
+     * @param uniqueName unique name of input method
+     * @return the entry, or std::nullopt if this engine does not provide it
+     * @see InputMethodEngineV5::lookupInputMethodImpl
+     * @since 5.1.12
+     */
+    std::optional<InputMethodEntry>
+    lookupInputMethod(const std::string &uniqueName);
 };
 
 class FCITXCORE_EXPORT InputMethodEngineV2 : public InputMethodEngine {
@@ -205,6 +223,22 @@ public:
                              VirtualKeyboardEvent &VirtualKeyboardEvent) = 0;
 };
 
+/**
+ * Engine that creates its input method entries on demand.
+ *
+ * InputMethodManager does not call listInputMethods of such an engine on
+ * load. An entry is created by lookupInputMethodImpl when the input method is
+ * looked up by name for the first time, and listInputMethods is only called
+ * when all the entries are enumerated.
+ *
+ * @since 5.1.12
+ */
+class FCITXCORE_EXPORT InputMethodEngineV5 : public InputMethodEngineV4 {
+public:
+    virtual std::optional<InputMethodEntry>
+    lookupInputMethodImpl(const std::string &uniqueName) = 0;
+};
+
 } // namespace fcitx
 
 #endif // _FCITX_INPUTMETHODENGINE_H_
@@ -7,6 +7,7 @@
 
 #include "inputmethodentry.h"
 #include <fcitx-utils/stringutils.h>
+#include "stringpool_p.h"
 
 namespace fcitx {
 
@@ -16,17 +17,20 @@ public:
                             const std::string &name,
                             const std::string &languageCode,
                             const std::string &addon)
-        : uniqueName_(uniqueName), name_(name), languageCode_(languageCode),
-          addon_(addon) {}
+        : uniqueName_(internString(uniqueName)), name_(name),
+          languageCode_(internString(languageCode)),
+          addon_(internString(addon)) {}
 
-    std::string uniqueName_;
+    // Identifiers shared by many entries are interned.
+    const std::string &uniqueName_;
     std::string name_;
     std::string nativeName_;
     std::string icon_;
     std::string label_;
-    std::string languageCode_;
-    std::string addon_;
+    const std::string &languageCode_;
+    const std::string &addon_;
     bool configurable_ = false;
+    unsigned int surroundingTextWindow_ = 0;
     std::unique_ptr<InputMethodEntryUserData> userData_;
 };
 
@@ -64,6 +68,13 @@ InputMethodEntry &InputMethodEntry::setConfigurable(bool configurable) {
     return *this;
 }
 
+InputMethodEntry &
+InputMethodEntry::setSurroundingTextWindow(unsigned int window) {
+    FCITX_D();
+    d->surroundingTextWindow_ = window;
+    return *this;
+}
+
 void InputMethodEntry::setUserData(
     std::unique_ptr<InputMethodEntryUserData> userData) {
     FCITX_D();
@@ -107,9 +118,14 @@ bool InputMethodEntry::isConfigurable() const {
     FCITX_D();
     return d->configurable_;
 }
+unsigned int InputMethodEntry::surroundingTextWindow() const {
+    FCITX_D();
+    return d->surroundingTextWindow_;
+}
 bool InputMethodEntry::isKeyboard() const {
     FCITX_D();
+    static const std::string &keyboardAddon = internString("keyboard");
     return stringutils::startsWith(d->uniqueName_, "keyboard-") &&
-           d->addon_ == "keyboard";
+           &d->addon_ == &keyboardAddon;
 }
 } // namespace fcitx
@@ -31,6 +31,18 @@ public:
     InputMethodEntry &setIcon(const std::string &icon);
     InputMethodEntry &setLabel(const std::string &label);
     InputMethodEntry &setConfigurable(bool configurable);
+    /**
+     * Set the number of characters around the cursor that the input method
+     * needs from the surrounding text.
+     *
+     * Frontends may trim the surrounding text sent by the client to this
+     * window, and advertise it to the clients that support it. 0 means the
+     * whole text is wanted, which is the default.
+     *
+     * @param window number of characters before and after the cursor.
+     * @since 5.1.12
+     */
+    InputMethodEntry &setSurroundingTextWindow(unsigned int window);
     void setUserData(std::unique_ptr<InputMethodEntryUserData> userData);
 
     const InputMethodEntryUserData *userData() const;
@@ -56,6 +68,13 @@ public:
      */
     const std::string &label() const;
     bool isConfigurable() const;
+    /**
+     * Return the surrounding text window of this input method.
+     *
+     * @see setSurroundingTextWindow
+     * @since 5.1.12
+     */
+    unsigned int surroundingTextWindow() const;
 
     /**
      * Helper function to check if this is a keyboard input method.
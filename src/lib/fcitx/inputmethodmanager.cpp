@@ -9,11 +9,14 @@
 #include <fcntl.h>
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <functional>
 #include <iterator>
 #include <list>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -23,12 +26,14 @@
 #include "fcitx-config/iniparser.h"
 #include "fcitx-config/rawconfig.h"
 #include "fcitx-utils/connectableobject.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/handlertable.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/macros.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/unixfd.h"
 #include "addoninfo.h"
 #include "addonmanager.h"
@@ -36,6 +41,8 @@
 #include "inputmethodengine.h"
 #include "inputmethodgroup.h"
 #include "instance.h"
+#include "metadatasnapshot_p.h"
+#include "startuptimeline_p.h"
 
 namespace fcitx {
 
@@ -55,6 +62,16 @@ public:
     void loadStaticEntries(const std::unordered_set<std::string> &addonNames);
     // Read entries from addon->listInputMethods();
     void loadDynamicEntries(const std::unordered_set<std::string> &addonNames);
+    bool addDynamicEntry(const std::string &addonName,
+                         InputMethodEntry entry) const;
+    // Find an entry, ask the lazy engines if it is not created yet.
+    const InputMethodEntry *lookupEntry(const std::string &name) const;
+    // Create all the entries of lazy engines.
+    void loadLazyEntries();
+
+    RawConfig profileConfig() const;
+    // Write profile if the content is different from the one on disk.
+    void writeProfile();
 
     FCITX_DEFINE_SIGNAL_PRIVATE(InputMethodManager, CurrentGroupAboutToChange);
     FCITX_DEFINE_SIGNAL_PRIVATE(InputMethodManager, CurrentGroupChanged);
@@ -65,12 +82,32 @@ public:
     std::list<std::string> groupOrder_;
     bool buildingGroup_ = false;
     std::unordered_map<std::string, InputMethodGroup> groups_;
-    std::unordered_map<std::string, InputMethodEntry> entries_;
+    // Entries of lazy engines are added when they are looked up.
+    mutable std::unordered_map<std::string, InputMethodEntry> entries_;
+    // Addon names of InputMethodEngineV5, whose entries are created on demand.
+    std::vector<std::string> lazyEngines_;
+    bool lazyEntriesLoaded_ = false;
     Instance *instance_ = nullptr;
     std::unique_ptr<HandlerTableEntry<EventHandler>> eventWatcher_;
     int64_t timestamp_ = 0;
+    // Hash of the profile content on disk, to skip the save of same content.
+    std::optional<size_t> profileHash_;
+    uint64_t lastProfileSave_ = 0;
+    std::unique_ptr<EventSourceTime> profileSaveEvent_;
 };
 
+namespace {
+
+// Changes within this interval are written together, e.g. when groups are
+// recreated one by one.
+constexpr uint64_t ProfileSaveInterval = 1000000;
+
+size_t profileHash(const RawConfig &config) {
+    return std::hash<std::string>()(writeAsIni(config));
+}
+
+} // namespace
+
 bool checkEntry(const InputMethodEntry &entry,
                 const std::unordered_set<std::string> &inputMethods) {
     return !(entry.name().empty() || entry.uniqueName().empty() ||
@@ -88,6 +125,12 @@ void InputMethodManagerPrivate::loadConfig(
     }
     InputMethodConfig imConfig;
     imConfig.load(config);
+    profileHash_.reset();
+    if (file.isValid()) {
+        RawConfig loaded;
+        imConfig.save(loaded);
+        profileHash_ = profileHash(loaded);
+    }
 
     groups_.clear();
     std::vector<std::string> tempOrder;
@@ -107,7 +150,7 @@ void InputMethodManagerPrivate::loadConfig(
             group.setDefaultLayout(groupConfig.defaultLayout.value());
             const auto &items = groupConfig.items.value();
             for (const auto &item : items) {
-                if (!entries_.count(item.name.value())) {
+                if (!lookupEntry(item.name.value())) {
                     FCITX_WARN() << "Group Item " << item.name.value()
                                  << " in group " << groupConfig.name.value()
                                  << " is not valid. Removed.";
@@ -169,17 +212,42 @@ void InputMethodManagerPrivate::loadStaticEntries(
     timestamp_ = path.timestamp(StandardPath::Type::PkgData, "inputmethod");
     auto filesMap = path.locate(StandardPath::Type::PkgData, "inputmethod",
                                 filter::Suffix(".conf"));
-    for (const auto &[fileName, fullName] : filesMap) {
+    MetadataSnapshot snapshot("inputmethod", path);
+    path.scanDirectories(StandardPath::Type::PkgData,
+                         [&snapshot](const std::string &dir, bool isUser) {
+                             auto fullPath =
+                                 stringutils::joinPath(dir, "inputmethod");
+                             if (isUser) {
+                                 snapshot.addOptionalDependency(fullPath);
+                             } else {
+                                 snapshot.addDependency(fullPath);
+                             }
+                             return true;
+                         });
+    for (const auto &item : filesMap) {
+        snapshot.addDependency(item.second);
+    }
+    RawConfig configs;
+    if (!snapshot.load(configs)) {
+        for (const auto &[fileName, fullName] : filesMap) {
+            UnixFD fd = UnixFD::own(open(fullName.c_str(), O_RDONLY));
+            readFromIni(*configs.get(fileName, true), fd.fd());
+        }
+        snapshot.save(configs);
+    }
+    for (const auto &item : filesMap) {
+        const auto &fileName = item.first;
         std::string name = fileName.substr(0, fileName.size() - 5);
         if (entries_.count(name) != 0) {
             continue;
         }
-        RawConfig config;
-        UnixFD fd = UnixFD::own(open(fullName.c_str(), O_RDONLY));
-        readFromIni(config, fd.fd());
+        auto config = configs.get(fileName);
+        if (!config) {
+            continue;
+        }
 
         InputMethodInfo imInfo;
-        imInfo.load(config);
+        imInfo.load(*config);
         if (!*imInfo.im->enable) {
             continue;
         }
@@ -193,6 +261,8 @@ void InputMethodManagerPrivate::loadStaticEntries(
 
 void InputMethodManagerPrivate::loadDynamicEntries(
     const std::unordered_set<std::string> &addonNames) {
+    lazyEngines_.clear();
+    lazyEntriesLoaded_ = false;
     for (const auto &addonName : addonNames) {
         const auto *addonInfo = addonManager_->addonInfo(addonName);
         // on request input method should always provides entry with config file
@@ -205,17 +275,63 @@ void InputMethodManagerPrivate::loadDynamicEntries(
             FCITX_WARN() << "Failed to load input method addon: " << addonName;
             continue;
         }
+        if (dynamic_cast<InputMethodEngineV5 *>(engine)) {
+            lazyEngines_.push_back(addonName);
+            continue;
+        }
         auto newEntries = engine->listInputMethods();
         FCITX_INFO() << "Found " << newEntries.size() << " input method(s) "
                      << "in addon " << addonName;
         for (auto &newEntry : newEntries) {
-            // ok we can't let you register something werid.
-            if (checkEntry(newEntry, addonNames) &&
-                newEntry.addon() == addonName &&
-                entries_.count(newEntry.uniqueName()) == 0) {
-                entries_.emplace(std::string(newEntry.uniqueName()),
-                                 std::move(newEntry));
-            }
+            addDynamicEntry(addonName, std::move(newEntry));
+        }
+    }
+}
+
+bool InputMethodManagerPrivate::addDynamicEntry(const std::string &addonName,
+                                                InputMethodEntry entry) const {
+    // ok we can't let you register something werid.
+    if (entry.name().empty() || entry.uniqueName().empty() ||
+        entry.addon() != addonName || entries_.count(entry.uniqueName())) {
+        return false;
+    }
+    entries_.emplace(std::string(entry.uniqueName()), std::move(entry));
+    return true;
+}
+
+const InputMethodEntry *
+InputMethodManagerPrivate::lookupEntry(const std::string &name) const {
+    if (const auto *entry = findValue(entries_, name)) {
+        return entry;
+    }
+    for (const auto &addonName : lazyEngines_) {
+        auto *engine =
+            static_cast<InputMethodEngine *>(addonManager_->addon(addonName));
+        if (!engine) {
+            continue;
+        }
+        auto entry = engine->lookupInputMethod(name);
+        if (entry && entry->uniqueName() == name &&
+            addDynamicEntry(addonName, std::move(*entry))) {
+            return findValue(entries_, name);
+        }
+    }
+    return nullptr;
+}
+
+void InputMethodManagerPrivate::loadLazyEntries() {
+    if (lazyEntriesLoaded_) {
+        return;
+    }
+    lazyEntriesLoaded_ = true;
+    for (const auto &addonName : lazyEngines_) {
+        auto *engine =
+            static_cast<InputMethodEngine *>(addonManager_->addon(addonName));
+        if (!engine) {
+            continue;
+        }
+        for (auto &newEntry : engine->listInputMethods()) {
+            addDynamicEntry(addonName, std::move(newEntry));
         }
     }
 }
@@ -232,9 +348,16 @@ void InputMethodManager::load(const std::function<void(InputMethodManager &)>
         d->groupOrder_.empty() ? "" : d->groupOrder_.front());
 
     auto addonNames = d->addonManager_->addonNames(AddonCategory::InputMethod);
-    d->loadStaticEntries(addonNames);
-    d->loadDynamicEntries(addonNames);
+    {
+        StartupPhase phase("InputMethodManager/StaticEntries");
+        d->loadStaticEntries(addonNames);
+    }
+    {
+        StartupPhase phase("InputMethodManager/DynamicEntries");
+        d->loadDynamicEntries(addonNames);
+    }
 
+    StartupPhase phase("InputMethodManager/LoadConfig");
     d->loadConfig(buildDefaultGroupCallback);
     // groupOrder guarantee to be non-empty at this point.
     emit<InputMethodManager::CurrentGroupChanged>(d->groupOrder_.front());
@@ -348,7 +471,7 @@ void InputMethodManager::setGroup(InputMethodGroup newGroupInfo) {
     auto &list = newGroupInfo.inputMethodList();
     auto iter = std::remove_if(list.begin(), list.end(),
                                [d](const InputMethodGroupItem &item) {
-                                   return !d->entries_.count(item.name());
+                                   return !d->lookupEntry(item.name());
                                });
     list.erase(iter, list.end());
     newGroupInfo.setDefaultInputMethod(newGroupInfo.defaultInputMethod());
@@ -420,22 +543,21 @@ void InputMethodManager::removeGroup(const std::string &name) {
     }
 }
 
-void InputMethodManager::save() {
-    FCITX_D();
+RawConfig InputMethodManagerPrivate::profileConfig() const {
     InputMethodConfig config;
     std::vector<InputMethodGroupConfig> groups;
     config.groupOrder.setValue(
-        std::vector<std::string>{d->groupOrder_.begin(), d->groupOrder_.end()});
+        std::vector<std::string>{groupOrder_.begin(), groupOrder_.end()});
 
-    for (auto &p : d->groups_) {
-        auto &group = p.second;
+    for (const auto &p : groups_) {
+        const auto &group = p.second;
         groups.emplace_back();
         auto &groupConfig = groups.back();
         groupConfig.name.setValue(group.name());
         groupConfig.defaultLayout.setValue(group.defaultLayout());
         groupConfig.defaultInputMethod.setValue(group.defaultInputMethod());
         std::vector<InputMethodGroupItemConfig> itemsConfig;
-        for (auto &item : group.inputMethodList()) {
+        for (const auto &item : group.inputMethodList()) {
             itemsConfig.emplace_back();
             auto &itemConfig = itemsConfig.back();
             itemConfig.name.setValue(item.name());
@@ -446,17 +568,66 @@ void InputMethodManager::save() {
     }
     config.groups.setValue(std::move(groups));
 
-    safeSaveAsIni(config, "profile");
+    RawConfig rawConfig;
+    config.save(rawConfig);
+    return rawConfig;
+}
+
+void InputMethodManagerPrivate::writeProfile() {
+    const auto config = profileConfig();
+    const auto hash = profileHash(config);
+    if (profileHash_ == hash) {
+        return;
+    }
+    if (safeSaveAsIni(config, "profile")) {
+        profileHash_ = hash;
+    }
+    lastProfileSave_ = now(CLOCK_MONOTONIC);
+}
+
+void InputMethodManager::save() {
+    FCITX_D();
+    auto *instance = d->addonManager_->instance();
+    const auto current = now(CLOCK_MONOTONIC);
+    // Always write immediately on exit, since there is no event loop to
+    // delay it.
+    if (!instance || instance->exiting() ||
+        current >= d->lastProfileSave_ + ProfileSaveInterval) {
+        if (d->profileSaveEvent_) {
+            d->profileSaveEvent_->setEnabled(false);
+        }
+        d->writeProfile();
+        return;
+    }
+    if (d->profileHash_ == profileHash(d->profileConfig())) {
+        return;
+    }
+    const auto time = d->lastProfileSave_ + ProfileSaveInterval;
+    if (d->profileSaveEvent_) {
+        if (!d->profileSaveEvent_->isEnabled()) {
+            d->profileSaveEvent_->setTime(time);
+            d->profileSaveEvent_->setOneShot();
+        }
+        return;
+    }
+    d->profileSaveEvent_ = instance->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, time, 0,
+        [d](EventSourceTime *, uint64_t) {
+            d->writeProfile();
+            return true;
+        },
+        "InputMethodManager/SaveProfile");
 }
 
 const InputMethodEntry *
 InputMethodManager::entry(const std::string &name) const {
     FCITX_D();
-    return findValue(d->entries_, name);
+    return d->lookupEntry(name);
 }
 bool InputMethodManager::foreachEntries(
     const std::function<bool(const InputMethodEntry &entry)> &callback) {
     FCITX_D();
+    d->loadLazyEntries();
     for (auto &p : d->entries_) {
         if (!callback(p.second)) {
             return false;
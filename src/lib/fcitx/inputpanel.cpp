@@ -6,11 +6,60 @@
  */
 
 #include "inputpanel.h"
+#include <cstdint>
+#include <functional>
+#include <string>
 
 namespace fcitx {
 
 class InputPanelPrivate {
 public:
+    void setText(Text &member, const Text &text,
+                 InputPanelComponent component) {
+        if (member != text) {
+            dirty_ |= component;
+        }
+        member = text;
+    }
+
+    void clearText(Text &member, InputPanelComponent component) {
+        if (!member.empty()) {
+            dirty_ |= component;
+        }
+        member.clear();
+    }
+
+    // Identifies what the current page displays, besides the cursor. The
+    // serial of a candidate word changes with its content, so in place
+    // modification of the list is also caught.
+    uint64_t contentHash() const {
+        if (!candidate_) {
+            return 0;
+        }
+        uint64_t hash = candidate_->size();
+        auto combine = [&hash](uint64_t value) {
+            hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        };
+        combine(static_cast<uint64_t>(candidate_->layoutHint()));
+        for (int i = 0, e = candidate_->size(); i < e; i++) {
+            combine(candidate_->candidate(i).serial());
+            combine(std::hash<std::string>()(candidate_->label(i).toString()));
+        }
+        if (auto *pageable = candidate_->toPageable()) {
+            combine(pageable->hasPrev());
+            combine(pageable->hasNext());
+        }
+        return hash;
+    }
+
+    void saveCandidateState() {
+        lastCandidate_ = candidate_.get();
+        lastCursorIndex_ = candidate_ ? candidate_->cursorIndex() : -1;
+        lastContentHash_ = contentHash();
+        auto *pageable = candidate_ ? candidate_->toPageable() : nullptr;
+        lastPage_ = pageable ? pageable->currentPage() : -1;
+    }
+
     Text auxDown_;
     Text auxUp_;
     Text preedit_;
@@ -19,6 +68,13 @@ public:
     InputContext *ic_;
     CustomInputPanelCallback customCallback_ = nullptr;
     CustomInputPanelCallback customVirtualKeyboardCallback_ = nullptr;
+
+    InputPanelComponents dirty_;
+    // Candidate list state seen by the last user interface update.
+    const CandidateList *lastCandidate_ = nullptr;
+    uint64_t lastContentHash_ = 0;
+    int lastCursorIndex_ = -1;
+    int lastPage_ = -1;
 };
 
 InputPanel::InputPanel(InputContext *ic)
@@ -31,32 +87,37 @@ InputPanel::~InputPanel() {}
 
 void InputPanel::setAuxDown(const Text &text) {
     FCITX_D();
-    d->auxDown_ = text;
+    d->setText(d->auxDown_, text, InputPanelComponent::AuxDown);
 }
 
 void InputPanel::setAuxUp(const Text &text) {
     FCITX_D();
-    d->auxUp_ = text;
+    d->setText(d->auxUp_, text, InputPanelComponent::AuxUp);
 }
 
 void InputPanel::setCandidateList(std::unique_ptr<CandidateList> candidate) {
     FCITX_D();
+    if (d->candidate_ || candidate) {
+        d->dirty_ |= InputPanelComponent::CandidateList;
+    }
     d->candidate_ = std::move(candidate);
 }
 
 void InputPanel::setClientPreedit(const Text &clientPreedit) {
     FCITX_D();
-    d->clientPreedit_ = clientPreedit.normalize();
+    auto normalized = clientPreedit.normalize();
     // If it is empty preedit, always set cursor to 0.
     // An empty preedit with hidden cursor would only cause issues.
-    if (d->clientPreedit_.empty()) {
-        d->clientPreedit_.setCursor(0);
+    if (normalized.empty()) {
+        normalized.setCursor(0);
     }
+    d->setText(d->clientPreedit_, normalized,
+               InputPanelComponent::ClientPreedit);
 }
 
 void InputPanel::setPreedit(const Text &text) {
     FCITX_D();
-    d->preedit_ = text;
+    d->setText(d->preedit_, text, InputPanelComponent::Preedit);
 }
 
 const Text &InputPanel::auxDown() const {
@@ -104,12 +165,15 @@ void InputPanel::setCustomVirtualKeyboardCallback(
 
 void InputPanel::reset() {
     FCITX_D();
-    d->preedit_.clear();
-    d->clientPreedit_.clear();
+    d->clearText(d->preedit_, InputPanelComponent::Preedit);
+    d->clearText(d->clientPreedit_, InputPanelComponent::ClientPreedit);
     d->clientPreedit_.setCursor(0);
+    if (d->candidate_) {
+        d->dirty_ |= InputPanelComponent::CandidateList;
+    }
     d->candidate_.reset();
-    d->auxUp_.clear();
-    d->auxDown_.clear();
+    d->clearText(d->auxUp_, InputPanelComponent::AuxUp);
+    d->clearText(d->auxDown_, InputPanelComponent::AuxDown);
     d->customCallback_ = nullptr;
     d->customVirtualKeyboardCallback_ = nullptr;
 }
@@ -125,4 +189,34 @@ std::shared_ptr<CandidateList> InputPanel::candidateList() const {
     FCITX_D();
     return d->candidate_;
 }
+
+InputPanelComponents InputPanel::dirtyComponents() const {
+    FCITX_D();
+    auto dirty = d->dirty_;
+    if (d->candidate_.get() != d->lastCandidate_) {
+        // The old list may be gone and the address reused.
+        dirty |= InputPanelComponent::CandidateList;
+    } else if (d->candidate_ && !dirty.test(InputPanelComponent::CandidateList)) {
+        auto *pageable = d->candidate_->toPageable();
+        if ((pageable ? pageable->currentPage() : -1) != d->lastPage_ ||
+            d->contentHash() != d->lastContentHash_) {
+            dirty |= InputPanelComponent::CandidatePage;
+        }
+        if (d->candidate_->cursorIndex() != d->lastCursorIndex_) {
+            dirty |= InputPanelComponent::CandidateCursor;
+        }
+    }
+    return dirty;
+}
+
+void InputPanel::markDirty(InputPanelComponents components) {
+    FCITX_D();
+    d->dirty_ |= components;
+}
+
+void InputPanel::clearDirtyComponents() {
+    FCITX_D();
+    d->dirty_ = 0;
+    d->saveCandidateState();
+}
 } // namespace fcitx
@@ -8,6 +8,7 @@
 #define _FCITX_INPUTPANEL_H_
 
 #include <functional>
+#include <fcitx-utils/flags.h>
 #include <fcitx/candidatelist.h>
 #include "fcitxcore_export.h"
 
@@ -23,6 +24,27 @@ class InputContext;
 
 using CustomInputPanelCallback = std::function<void(InputContext *)>;
 
+/**
+ * Parts of the input panel that may change between two user interface updates.
+ *
+ * @since 5.1.12
+ */
+enum class InputPanelComponent {
+    Preedit = (1 << 0),
+    ClientPreedit = (1 << 1),
+    AuxUp = (1 << 2),
+    AuxDown = (1 << 3),
+    /// A different candidate list is set.
+    CandidateList = (1 << 4),
+    /// Same candidate list, but showing a different page, or the candidates,
+    /// labels or layout on the page are changed.
+    CandidatePage = (1 << 5),
+    /// Same candidate list, but cursor index is changed.
+    CandidateCursor = (1 << 6),
+};
+
+using InputPanelComponents = Flags<InputPanelComponent>;
+
 /**
  * Input Panel is usually a floating window that is display at the cursor of
  * input.
@@ -105,6 +127,35 @@ public:
     /// Whether input panel is totally empty.
     bool empty() const;
 
+    /**
+     * Components changed since the last user interface update.
+     *
+     * Setting a value equal to the current one does not mark the component.
+     * Empty flags means the change is unknown, e.g. the output filter is
+     * changed, and user interface should update everything.
+     *
+     * @since 5.1.12
+     */
+    InputPanelComponents dirtyComponents() const;
+
+    /**
+     * Mark components as changed.
+     *
+     * Changes to the candidate list object, its page, cursor, and the
+     * displayed candidates and labels are detected automatically. Only other
+     * state that affects the user interface needs to be marked.
+     *
+     * @since 5.1.12
+     */
+    void markDirty(InputPanelComponents components);
+
+    /**
+     * Reset the changed components, called after user interface is updated.
+     *
+     * @since 5.1.12
+     */
+    void clearDirtyComponents();
+
 private:
     std::unique_ptr<InputPanelPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(InputPanel);
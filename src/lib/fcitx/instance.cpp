@@ -8,31 +8,44 @@
 
 #include <fcntl.h>
 #include <signal.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <fmt/format.h>
 #include <getopt.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include "fcitx-config/iniparser.h"
+#include "fcitx-config/marshallfunction.h"
+#include "fcitx-config/rawconfig.h"
 #include "fcitx-utils/capabilityflags.h"
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/fs.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/macros.h"
 #include "fcitx-utils/misc.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/unixfd.h"
 #include "fcitx-utils/utf8.h"
 #include "fcitx/event.h"
 #include "fcitx/inputmethodgroup.h"
 #include "../../modules/notifications/notifications_public.h"
+#include "addoninfo.h"
 #include "addonmanager.h"
 #include "focusgroup.h"
 #include "globalconfig.h"
@@ -44,6 +57,7 @@
 #include "instance.h"
 #include "instance_p.h"
 #include "misc_p.h"
+#include "startuptimeline_p.h"
 #include "userinterfacemanager.h"
 
 #ifdef ENABLE_X11
@@ -64,6 +78,10 @@ namespace {
 
 constexpr uint64_t AutoSaveMinInUsecs = 60ull * 1000000ull; // 30 minutes
 constexpr uint64_t AutoSaveIdleTime = 60ull * 1000000ull;   // 1 minutes
+// Pressure notification may repeat every window, which is 2s by default.
+constexpr uint64_t PressureTrimInterval = 10ull * 1000000ull;
+// Input methods are prewarmed after no input for this long.
+constexpr uint64_t PrewarmIdleTime = 500000;
 
 FCITX_CONFIGURATION(DefaultInputMethod,
                     Option<std::vector<std::string>> defaultInputMethods{
@@ -71,6 +89,62 @@ FCITX_CONFIGURATION(DefaultInputMethod,
                     Option<std::vector<std::string>> extraLayouts{
                         this, "ExtraLayout", "ExtraLayout"};);
 
+std::string decodeBase64(std::string_view data) {
+    std::string result;
+    uint32_t value = 0;
+    int bits = 0;
+    for (char c : data) {
+        int digit;
+        if (c >= 'A' && c <= 'Z') {
+            digit = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            digit = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            digit = c - '0' + 52;
+        } else if (c == '+') {
+            digit = 62;
+        } else if (c == '/') {
+            digit = 63;
+        } else {
+            // Padding or whitespace.
+            continue;
+        }
+        value = (value << 6) | digit;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            result.push_back(static_cast<char>((value >> bits) & 0xff));
+        }
+    }
+    return result;
+}
+
+// Follow the memory pressure protocol of systemd, the service manager tells
+// which file to watch and what to write to it, e.g. a PSI trigger for
+// memory.pressure of the cgroup.
+UnixFD openMemoryPressureWatch() {
+    const char *path = getenv("MEMORY_PRESSURE_WATCH");
+    if (!path || !path[0] || std::string_view(path) == "/dev/null") {
+        return {};
+    }
+    const char *trigger = getenv("MEMORY_PRESSURE_WRITE");
+    UnixFD fd = UnixFD::own(
+        open(path, (trigger ? O_RDWR : O_RDONLY) | O_NONBLOCK | O_CLOEXEC));
+    if (!fd.isValid()) {
+        FCITX_WARN() << "Failed to open memory pressure watch: " << path;
+        return {};
+    }
+    if (trigger) {
+        const auto data = decodeBase64(trigger);
+        if (fs::safeWrite(fd.fd(), data.data(), data.size()) !=
+            static_cast<ssize_t>(data.size())) {
+            FCITX_WARN() << "Failed to set up memory pressure trigger.";
+            return {};
+        }
+    }
+    return fd;
+}
+
 void initAsDaemon() {
     pid_t pid;
     if ((pid = fork()) > 0) {
@@ -139,6 +213,16 @@ void InstanceArgument::printUsage() const {
         << "\t\t\t\t\tkey_trace - print the key event received by fcitx.\n"
         << "\t\t\t\t\t\"*\" may be used to represent all logging "
            "category.\n"
+        << "  --log <backend>\t\tWrite the log from a background thread.\n"
+        << "\t\t\t\tBackend can be one of:\n"
+        << "\t\t\t\t\tstderr - standard error.\n"
+        << "\t\t\t\t\tjournal - systemd journal.\n"
+        << "\t\t\t\t\tfile:<path> - append to the file.\n"
+        << "  --startup-timeline\t\tPrint the time spent in each phase of "
+           "the startup.\n"
+        << "  --benchmark-startup\t\tPrint the startup time and peak memory "
+           "as JSON\n"
+        << "\t\t\t\tonce the first input method is ready, then exit.\n"
         << "  -u, --ui <addon name>\t\tSet the UI addon to be used.\n"
         << "  -d\t\t\t\tRun as a daemon.\n"
         << "  -D\t\t\t\tDo not run as a daemon (default).\n"
@@ -166,19 +250,21 @@ InstancePrivate::InstancePrivate(Instance *q) : QPtrHolder<Instance>(q) {
         locale = "C";
     }
 #ifdef ENABLE_KEYBOARD
-    xkbContext_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+    {
+        StartupPhase phase("xkb_context_new");
+        xkbContext_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+    }
     if (xkbContext_) {
         xkb_context_set_log_level(xkbContext_.get(), XKB_LOG_LEVEL_CRITICAL);
-        xkbComposeTable_.reset(xkb_compose_table_new_from_locale(
-            xkbContext_.get(), locale, XKB_COMPOSE_COMPILE_NO_FLAGS));
-        if (!xkbComposeTable_) {
+        StartupPhase phase("ComposeTable");
+        composeTable_ = ComposeTable::create(xkbContext_.get(), locale);
+        if (!composeTable_) {
             FCITX_INFO()
                 << "Trying to fallback to compose table for en_US.UTF-8";
-            xkbComposeTable_.reset(xkb_compose_table_new_from_locale(
-                xkbContext_.get(), "en_US.UTF-8",
-                XKB_COMPOSE_COMPILE_NO_FLAGS));
+            composeTable_ =
+                ComposeTable::create(xkbContext_.get(), "en_US.UTF-8");
         }
-        if (!xkbComposeTable_) {
+        if (!composeTable_) {
             FCITX_WARN()
                 << "No compose table is loaded, you may want to check your "
                    "locale settings.";
@@ -190,20 +276,268 @@ InstancePrivate::InstancePrivate(Instance *q) : QPtrHolder<Instance>(q) {
 std::unique_ptr<HandlerTableEntry<EventHandler>>
 InstancePrivate::watchEvent(EventType type, EventWatcherPhase phase,
                             EventHandler callback) {
-    return eventHandlers_[type][phase].add(std::move(callback));
+    auto &tables = eventHandlers_[type];
+    auto iter = tables.try_emplace(phase, eventHandlerPool_).first;
+    auto result = iter->second.add(std::move(callback));
+    invalidateEventDispatchList(type);
+    return result;
+}
+
+namespace {
+
+constexpr EventWatcherPhase eventWatcherPhaseOrder[] = {
+    EventWatcherPhase::ReservedFirst, EventWatcherPhase::PreInputMethod,
+    EventWatcherPhase::InputMethod, EventWatcherPhase::PostInputMethod,
+    EventWatcherPhase::ReservedLast};
+
+std::shared_ptr<const EventDispatchList> *
+eventDispatchSlot(const InstancePrivate *d, EventType type) {
+    auto value = static_cast<uint32_t>(type);
+    auto category =
+        (value & static_cast<uint32_t>(EventType::EventTypeFlag)) >> 12;
+    auto index = value & ~static_cast<uint32_t>(EventType::EventTypeFlag);
+    constexpr auto categorySize = InstancePrivate::eventDispatchCategorySize;
+    if (category >= 1 && category <= 3 && index < categorySize) {
+        return &d->eventDispatchSlots_[(category - 1) * categorySize + index];
+    }
+    return &d->eventDispatchFallback_[type];
+}
+
+const char *eventWatcherPhaseName(EventWatcherPhase phase) {
+    switch (phase) {
+    case EventWatcherPhase::ReservedFirst:
+        return "ReservedFirst";
+    case EventWatcherPhase::PreInputMethod:
+        return "PreInputMethod";
+    case EventWatcherPhase::InputMethod:
+        return "InputMethod";
+    case EventWatcherPhase::PostInputMethod:
+        return "PostInputMethod";
+    case EventWatcherPhase::ReservedLast:
+        return "ReservedLast";
+    }
+    return "";
+}
+
+} // namespace
+
+void LatencyHistogram::add(uint64_t usec) {
+    size_t bucket = 0;
+    while (usec > 1 && bucket + 1 < buckets_.size()) {
+        usec >>= 1;
+        ++bucket;
+    }
+    if (count_ >= maxSamples) {
+        count_ = 0;
+        for (auto &value : buckets_) {
+            value /= 2;
+            count_ += value;
+        }
+    }
+    ++buckets_[bucket];
+    ++count_;
+}
+
+uint64_t LatencyHistogram::percentile(uint32_t percent) const {
+    if (!count_) {
+        return 0;
+    }
+    const uint64_t target =
+        (static_cast<uint64_t>(count_) * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= target) {
+            // Return the upper bound of the bucket.
+            return (static_cast<uint64_t>(1) << (i + 1)) - 1;
+        }
+    }
+    return (static_cast<uint64_t>(1) << buckets_.size()) - 1;
+}
+
+uint16_t KeyEventRecorder::intern(std::string_view name, uint16_t &hint) {
+    if (name.empty()) {
+        return 0;
+    }
+    // Usually the same as the previous key event.
+    if (names_[hint] == name) {
+        return hint;
+    }
+    if (auto iter = nameIndex_.find(std::string(name));
+        iter != nameIndex_.end()) {
+        hint = iter->second;
+        return hint;
+    }
+    if (names_.size() > std::numeric_limits<uint16_t>::max()) {
+        return 0;
+    }
+    hint = static_cast<uint16_t>(names_.size());
+    names_.emplace_back(name);
+    nameIndex_.emplace(names_.back(), hint);
+    return hint;
+}
+
+void KeyEventRecorder::record(const KeyEvent &event, uint64_t start,
+                              uint64_t end,
+                              const EventDispatchEntry *filteredBy,
+                              const InputMethodEntry *entry) {
+    auto &record = records_[total_ % capacity];
+    ++total_;
+    record.timestamp = start;
+    record.duration = static_cast<uint32_t>(
+        std::min<uint64_t>(end - start, std::numeric_limits<uint32_t>::max()));
+    record.sym = event.rawKey().sym();
+    record.states = event.rawKey().states();
+    record.ic = event.inputContext()->uuid();
+    record.frontend =
+        intern(event.inputContext()->frontendName(), lastFrontend_);
+    record.flags = 0;
+    if (event.isRelease()) {
+        record.flags |= Release;
+    }
+    if (filteredBy) {
+        record.flags |= Filtered;
+        record.phase = static_cast<uint8_t>(filteredBy->phase);
+        if (event.accepted()) {
+            record.flags |= Accepted;
+        }
+    }
+    record.inputMethod =
+        entry ? intern(entry->uniqueName(), lastInputMethod_) : 0;
+}
+
+std::string KeyEventRecorder::dump(uint64_t currentTime) const {
+    std::string result;
+    const size_t size = std::min<uint64_t>(total_, capacity);
+    for (size_t i = total_ - size; i < total_; ++i) {
+        const auto &record = records_[i % capacity];
+        std::string ic;
+        for (auto v : record.ic) {
+            ic.append(fmt::format("{:02x}", static_cast<int>(v)));
+        }
+        std::string handler = "none";
+        if (record.flags & Filtered) {
+            handler = eventWatcherPhaseName(
+                static_cast<EventWatcherPhase>(record.phase));
+            if (record.inputMethod) {
+                handler = stringutils::concat(handler, "/",
+                                              names_[record.inputMethod]);
+            }
+            if (record.flags & Accepted) {
+                handler += " accepted";
+            }
+        }
+        result.append(fmt::format(
+            "-{}ms IC [{}] frontend:{} key:{}{} handler:{} time:{}us\n",
+            (currentTime - record.timestamp) / 1000, ic,
+            names_[record.frontend],
+            Key(static_cast<KeySym>(record.sym), KeyStates(record.states))
+                .toString(),
+            (record.flags & Release) ? " release" : "", handler,
+            record.duration));
+    }
+    return result;
+}
+
+const EventDispatchEntry *
+InstancePrivate::dispatchTraced(const EventDispatchList &handlers,
+                                Event &event, bool &hasRemovedHandler) {
+    const auto start = now(CLOCK_MONOTONIC);
+    auto phaseStart = start;
+    auto phase = handlers.front().phase;
+    auto endPhase = [this, &phase, &phaseStart](uint64_t timestamp) {
+        phaseLatency_[phase].add(timestamp - phaseStart);
+        phaseStart = timestamp;
+    };
+    const EventDispatchEntry *filteredBy = nullptr;
+    for (const auto &entry : handlers) {
+        if (entry.phase != phase) {
+            endPhase(now(CLOCK_MONOTONIC));
+            phase = entry.phase;
+        }
+        auto *handler = eventHandlerPool_->get(entry.handler);
+        if (!handler) {
+            hasRemovedHandler = true;
+            continue;
+        }
+        (*handler)(event);
+        if (event.filtered()) {
+            filteredBy = &entry;
+            break;
+        }
+    }
+    const auto end = now(CLOCK_MONOTONIC);
+    endPhase(end);
+    totalLatency_.add(end - start);
+    return filteredBy;
+}
+
+std::shared_ptr<const EventDispatchList>
+InstancePrivate::eventDispatchList(EventType type) const {
+    auto *slot = eventDispatchSlot(this, type);
+    if (*slot) {
+        return *slot;
+    }
+
+    auto list = std::make_shared<EventDispatchList>();
+    if (auto iter = eventHandlers_.find(type); iter != eventHandlers_.end()) {
+        for (auto phase : eventWatcherPhaseOrder) {
+            auto iter2 = iter->second.find(phase);
+            if (iter2 == iter->second.end()) {
+                continue;
+            }
+            for (const auto &slot : iter2->second.entries()) {
+                if (slot.isAlive()) {
+                    list->push_back({phase, slot.handle()});
+                }
+            }
+        }
+    }
+    *slot = list;
+    return list;
+}
+
+void InstancePrivate::invalidateEventDispatchList(EventType type) const {
+    eventDispatchSlot(this, type)->reset();
+}
+
+void InstancePrivate::flushUI() {
+    uiManager_.flush();
+    lastUIFlush_ = now(CLOCK_MONOTONIC);
+    uiFlushUrgent_ = false;
+    if (uiFlushTimer_) {
+        uiFlushTimer_->setEnabled(false);
+    }
+}
+
+void InstancePrivate::flushUICoalesced() {
+    const uint64_t interval = globalConfig_.uiUpdateInterval() * 1000ULL;
+    const auto current = now(CLOCK_MONOTONIC);
+    if (!interval || uiFlushUrgent_ || current >= lastUIFlush_ + interval) {
+        flushUI();
+        return;
+    }
+    if (uiFlushTimer_ && uiFlushTimer_->isEnabled()) {
+        return;
+    }
+    const auto deadline = lastUIFlush_ + interval;
+    if (uiFlushTimer_) {
+        uiFlushTimer_->setTime(deadline);
+        uiFlushTimer_->setOneShot();
+    } else {
+        uiFlushTimer_ = eventLoop_.addTimeEvent(
+            CLOCK_MONOTONIC, deadline, 0,
+            [this](EventSourceTime *, uint64_t) {
+                flushUI();
+                return true;
+            });
+    }
 }
 
 #ifdef ENABLE_KEYBOARD
 xkb_keymap *InstancePrivate::keymap(const std::string &display,
                                     const std::string &layout,
                                     const std::string &variant) {
-    auto layoutAndVariant = stringutils::concat(layout, "-", variant);
-    if (auto *keymapPtr = findValue(keymapCache_[display], layoutAndVariant)) {
-        return (*keymapPtr).get();
-    }
-    struct xkb_rule_names names;
-    names.layout = layout.c_str();
-    names.variant = variant.c_str();
     std::tuple<std::string, std::string, std::string> xkbParam;
     if (auto *param = findValue(xkbParams_, display)) {
         xkbParam = *param;
@@ -217,15 +551,11 @@ xkb_keymap *InstancePrivate::keymap(const std::string &display,
     if (globalConfig_.overrideXkbOption()) {
         std::get<2>(xkbParam) = globalConfig_.customXkbOption();
     }
-    names.rules = std::get<0>(xkbParam).c_str();
-    names.model = std::get<1>(xkbParam).c_str();
-    names.options = std::get<2>(xkbParam).c_str();
-    UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap(xkb_keymap_new_from_names(
-        xkbContext_.get(), &names, XKB_KEYMAP_COMPILE_NO_FLAGS));
-    auto result =
-        keymapCache_[display].emplace(layoutAndVariant, std::move(keymap));
-    assert(result.second);
-    return result.first->second.get();
+    StartupPhase phase(stringutils::concat("xkb_keymap_new_from_names/",
+                                           layout, "-", variant));
+    return keymapCache_.fromNames(
+        std::get<0>(xkbParam).c_str(), std::get<1>(xkbParam).c_str(),
+        layout.c_str(), variant.c_str(), std::get<2>(xkbParam).c_str());
 }
 #endif
 
@@ -251,7 +581,97 @@ InstancePrivate::overrideAddons() {
     return {enabled, disabled};
 }
 
+void InstancePrivate::preloadInputMethods() {
+    StartupPhase phase("Instance/PreloadInputMethod");
+    // Preload first input method.
+    if (!imManager_.currentGroup().inputMethodList().empty()) {
+        if (const auto *entry = imManager_.entry(
+                imManager_.currentGroup().inputMethodList()[0].name())) {
+            addonManager_.addon(entry->addon(), true);
+        }
+    }
+    // Preload default input method.
+    if (!imManager_.currentGroup().defaultInputMethod().empty()) {
+        if (const auto *entry = imManager_.entry(
+                imManager_.currentGroup().defaultInputMethod())) {
+            addonManager_.addon(entry->addon(), true);
+        }
+    }
+}
+
+void InstancePrivate::schedulePrewarm(InputContext *ic) {
+    if (!prewarmInputMethodEvent_ || !globalConfig_.preloadInputMethod()) {
+        return;
+    }
+    prewarmFrom_ = q_func()->inputMethod(ic);
+    prewarmInputMethodEvent_->setTime(
+        std::max(now(CLOCK_MONOTONIC), idleStartTimestamp_) + PrewarmIdleTime);
+    prewarmInputMethodEvent_->setOneShot();
+}
+
+void InstancePrivate::prewarmInputMethods() {
+    // Anything loaded now would be dropped by the trim again.
+    const auto currentTime = now(CLOCK_MONOTONIC);
+    if (lastIdleTrimTimestamp_ >= idleStartTimestamp_ ||
+        (lastPressureTrimTimestamp_ &&
+         currentTime - lastPressureTrimTimestamp_ < PressureTrimInterval)) {
+        return;
+    }
+    const auto &imList = imManager_.currentGroup().inputMethodList();
+    auto iter = std::find_if(imList.begin(), imList.end(),
+                             [this](const InputMethodGroupItem &item) {
+                                 return item.name() == prewarmFrom_;
+                             });
+    if (iter == imList.end() || imList.size() < 2) {
+        return;
+    }
+    const size_t size = imList.size();
+    const size_t idx = std::distance(imList.begin(), iter);
+    // The ones that enumerate forward and backward would switch to.
+    std::vector<std::string> names;
+    for (const size_t step : {size_t(1), size - 1}) {
+        size_t next = (idx + step) % size;
+        if (globalConfig_.enumerateSkipFirst() && next == 0) {
+            next = (next + step) % size;
+        }
+        const auto &name = imList[next].name();
+        if (next != idx &&
+            std::find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(name);
+        }
+    }
+    for (const auto &name : names) {
+        const auto *entry = imManager_.entry(name);
+        if (!entry) {
+            continue;
+        }
+        FCITX_DEBUG() << "Prewarm input method " << name;
+        if (auto *engine = addonManager_.addon(entry->addon(), true)) {
+            engine->prewarm(*entry);
+        }
+    }
+}
+
+void InstancePrivate::finishStartupTimeline() {
+    auto &timeline = StartupTimeline::global();
+    if (!timeline.recording()) {
+        return;
+    }
+    timeline.finish();
+    if (arg_.printStartupTimeline) {
+        FCITX_INFO() << timeline.report();
+    }
+    if (arg_.benchmarkStartup) {
+        struct rusage usage;
+        long maxRss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+        std::cout << timeline.reportJson(maxRss) << std::endl;
+        FCITX_Q();
+        q->exit();
+    }
+}
+
 void InstancePrivate::buildDefaultGroup() {
+    StartupPhase phase("Instance/BuildDefaultGroup");
     /// Figure out XKB layout information from system.
     auto *defaultGroup = q_func()->defaultFocusGroup();
     bool infoFound = false;
@@ -426,6 +846,118 @@ void InstancePrivate::showInputMethodInformation(InputContext *ic) {
     inputState->showInputMethodInformation(display);
 }
 
+void InstancePrivate::buildAddonTriggers() {
+    addonKeyTriggers_.clear();
+    addonInputMethodTriggers_.clear();
+    prewarmAddons_.clear();
+    std::vector<std::string> names;
+    for (auto category :
+         {AddonCategory::InputMethod, AddonCategory::Frontend,
+          AddonCategory::Loader, AddonCategory::Module, AddonCategory::UI}) {
+        for (const auto &name : addonManager_.addonNames(category)) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    std::unordered_map<std::string, RawConfig> configs;
+    for (const auto &name : names) {
+        const auto *info = addonManager_.addonInfo(name);
+        if (!info || !info->isEnabled() || !info->onDemand() ||
+            addonManager_.lookupAddon(name)) {
+            continue;
+        }
+        // Each option uses the keys from user configuration if set, and its
+        // own default otherwise.
+        KeyList keys;
+        bool resolved = false;
+        for (const auto &item : info->triggerKeysConfig()) {
+            auto pos = item.find(':');
+            if (pos == std::string::npos) {
+                continue;
+            }
+            auto file = item.substr(0, pos);
+            auto path = item.substr(pos + 1);
+            std::optional<KeyList> defaultKeys;
+            if (auto eq = path.find('='); eq != std::string::npos) {
+                defaultKeys = Key::keyListFromString(path.substr(eq + 1));
+                path.erase(eq);
+                resolved = true;
+            }
+            auto iter = configs.find(file);
+            if (iter == configs.end()) {
+                iter = configs.emplace(file, RawConfig()).first;
+                readAsIni(iter->second, file);
+            }
+            KeyList optionKeys;
+            if (auto option = iter->second.get(path);
+                option && unmarshallOption(optionKeys, *option, false)) {
+                resolved = true;
+            } else if (defaultKeys) {
+                optionKeys = std::move(*defaultKeys);
+            }
+            keys.insert(keys.end(), optionKeys.begin(), optionKeys.end());
+        }
+        // Without any per option keys, fall back to TriggerKeys.
+        if (!resolved) {
+            keys = info->triggerKeys();
+        }
+        if (!keys.empty()) {
+            addonKeyTriggers_.emplace_back(name, std::move(keys));
+        }
+        for (const auto &im : info->triggerInputMethods()) {
+            addonInputMethodTriggers_[im].push_back(name);
+        }
+        if (info->prewarm()) {
+            prewarmAddons_.push_back(name);
+        }
+    }
+}
+
+void InstancePrivate::triggerAddons(const Event &event) {
+    FCITX_Q();
+    if (event.type() == EventType::InputContextKeyEvent) {
+        if (addonKeyTriggers_.empty()) {
+            return;
+        }
+        const auto &keyEvent = static_cast<const KeyEvent &>(event);
+        if (keyEvent.isRelease()) {
+            return;
+        }
+        for (const auto &[name, keys] : addonKeyTriggers_) {
+            if (keyEvent.key().checkKeyList(keys)) {
+                loadTriggeredAddon(name);
+                break;
+            }
+        }
+    } else if (event.type() == EventType::InputContextSwitchInputMethod ||
+               event.type() == EventType::InputContextFocusIn) {
+        if (addonInputMethodTriggers_.empty()) {
+            return;
+        }
+        const auto &icEvent = static_cast<const InputContextEvent &>(event);
+        const auto *entry = q->inputMethodEntry(icEvent.inputContext());
+        if (!entry) {
+            return;
+        }
+        auto iter = addonInputMethodTriggers_.find(entry->uniqueName());
+        if (iter == addonInputMethodTriggers_.end()) {
+            return;
+        }
+        // Loading the addon rebuilds the triggers.
+        auto names = iter->second;
+        for (const auto &name : names) {
+            loadTriggeredAddon(name);
+        }
+    }
+}
+
+void InstancePrivate::loadTriggeredAddon(const std::string &name) {
+    FCITX_DEBUG() << "Load addon " << name << " on trigger.";
+    addonManager_.addon(name, true);
+    buildAddonTriggers();
+}
+
 bool InstancePrivate::canActivate(InputContext *ic) {
     FCITX_Q();
     if (!q->canTrigger()) {
@@ -484,11 +1016,10 @@ void InstancePrivate::acceptGroupChange(const Key &key, InputContext *ic) {
 
 InputState::InputState(InstancePrivate *d, InputContext *ic)
     : d_ptr(d), ic_(ic) {
-    active_ = d->globalConfig_.activeByDefault();
 #ifdef ENABLE_KEYBOARD
-    if (d->xkbComposeTable_) {
-        xkbComposeState_.reset(xkb_compose_state_new(
-            d->xkbComposeTable_.get(), XKB_COMPOSE_STATE_NO_FLAGS));
+    if (d->composeTable_) {
+        composeState_ =
+            std::make_unique<ComposeTableState>(d->composeTable_.get());
     }
 #endif
 }
@@ -502,17 +1033,28 @@ void InputState::showInputMethodInformation(const std::string &name) {
         [this](EventSourceTime *, uint64_t) {
             hideInputMethodInfo();
             return true;
-        });
+        },
+        "Instance/InputMethodInfo");
 }
 
 #ifdef ENABLE_KEYBOARD
-xkb_state *InputState::customXkbState(bool refresh) {
+xkb_state *InputState::customXkbState() {
     auto *instance = d_ptr->q_func();
+    auto im = instance->inputMethod(ic_);
+    // Layout only depends on the input method and the group, so there is
+    // nothing to resolve for most of the key events.
+    if (!xkbStateStale_ && xkbEpoch_ == d_ptr->inputMethodEpoch_ &&
+        im == xkbIM_) {
+        return xkbState_.get();
+    }
+    const bool refresh = std::exchange(xkbStateStale_, false);
+    xkbEpoch_ = d_ptr->inputMethodEpoch_;
+    xkbIM_ = std::move(im);
+
     const InputMethodGroup &group = d_ptr->imManager_.currentGroup();
-    const auto im = instance->inputMethod(ic_);
-    auto layout = group.layoutFor(im);
-    if (layout.empty() && stringutils::startsWith(im, "keyboard-")) {
-        layout = im.substr(9);
+    auto layout = group.layoutFor(xkbIM_);
+    if (layout.empty() && stringutils::startsWith(xkbIM_, "keyboard-")) {
+        layout = xkbIM_.substr(9);
     }
     if (layout.empty() || layout == group.defaultLayout()) {
         // Use system one.
@@ -535,46 +1077,132 @@ xkb_state *InputState::customXkbState(bool refresh) {
         xkbState_.reset();
     }
     modsAllReleased_ = false;
+    if (!xkbState_) {
+        return nullptr;
+    }
+
+    // Start from the current modifiers of the display.
+    if (auto *mods = findValue(d_ptr->stateMask_, ic_->display())) {
+        FCITX_KEYTRACE() << "Update mask to customXkbState";
+        auto depressed = std::get<0>(*mods);
+        auto latched = std::get<1>(*mods);
+        auto locked = std::get<2>(*mods);
+
+        // set modifiers in depressed if they don't appear in any of the
+        // final masks
+        // depressed |= ~(depressed | latched | locked);
+        FCITX_KEYTRACE() << depressed << " " << latched << " " << locked;
+        if (depressed == 0) {
+            setModsAllReleased();
+        }
+        xkb_state_update_mask(xkbState_.get(), depressed, latched, locked, 0,
+                              0, 0);
+    }
     return xkbState_.get();
 }
 #endif
 
-void InputState::setActive(bool active) {
-    if (active_ != active) {
-        active_ = active;
-        ic_->updateProperty(&d_ptr->inputStateFactory_);
+InputState::~InputState() {
+    if (!sharedState_ || !sharedState_->key || sharedState_.use_count() != 1) {
+        return;
+    }
+    auto iter = d_ptr->sharedInputStates_.find(*sharedState_->key);
+    if (iter != d_ptr->sharedInputStates_.end() &&
+        iter->second.lock() == sharedState_) {
+        d_ptr->sharedInputStates_.erase(iter);
     }
 }
 
-void InputState::setLocalIM(const std::string &localIM) {
-    if (localIM_ != localIM) {
-        localIM_ = localIM;
-        ic_->updateProperty(&d_ptr->inputStateFactory_);
+SharedInputState &InputState::shared() {
+    if (!sharedState_ || shareEpoch_ != d_ptr->shareInputStateEpoch_) {
+        attachSharedState();
     }
+    return *sharedState_;
 }
 
-void InputState::copyTo(InputContextProperty *other) {
-    auto *otherState = static_cast<InputState *>(other);
-    if (otherState->active_ == active_ && otherState->localIM_ == localIM_) {
-        return;
+void InputState::attachSharedState() {
+    std::optional<std::string> key;
+    switch (d_ptr->globalConfig_.shareInputState()) {
+    case PropertyPropagatePolicy::All:
+        key.emplace();
+        break;
+    case PropertyPropagatePolicy::Program:
+        if (!ic_->program().empty()) {
+            key = ic_->program();
+        }
+        break;
+    case PropertyPropagatePolicy::No:
+        break;
     }
+    shareEpoch_ = d_ptr->shareInputStateEpoch_;
 
-    if (otherState->ic_->hasFocus()) {
-        FCITX_DEBUG() << "Sync state to focused ic: "
-                      << otherState->ic_->program();
-        CheckInputMethodChanged imChangedRAII(otherState->ic_, d_ptr);
-        otherState->active_ = active_;
-        otherState->localIM_ = localIM_;
+    if (key) {
+        auto iter = d_ptr->sharedInputStates_.find(*key);
+        if (iter != d_ptr->sharedInputStates_.end()) {
+            if (auto state = iter->second.lock()) {
+                sharedState_ = std::move(state);
+                return;
+            }
+        }
+    }
+
+    // Keep the current state, only stop sharing it.
+    auto state = std::make_shared<SharedInputState>();
+    if (sharedState_) {
+        state->active = sharedState_->active;
+        state->localIM = sharedState_->localIM;
     } else {
-        otherState->active_ = active_;
-        otherState->localIM_ = localIM_;
+        state->active = d_ptr->globalConfig_.activeByDefault();
+    }
+    if (key) {
+        d_ptr->sharedInputStates_[*key] = state;
+        state->key = std::move(key);
+    }
+    sharedState_ = std::move(state);
+}
+
+std::vector<std::unique_ptr<CheckInputMethodChanged>>
+InputState::checkSharingInputContexts() {
+    std::vector<std::unique_ptr<CheckInputMethodChanged>> result;
+    if (sharedState_.use_count() <= 1) {
+        return result;
+    }
+    // Only focused input context need to know the input method is changed.
+    d_ptr->icManager_.foreachFocused([this, &result](InputContext *ic) {
+        if (ic == ic_) {
+            return true;
+        }
+        auto *inputState = ic->propertyFor(&d_ptr->inputStateFactory_);
+        if (&inputState->shared() == sharedState_.get()) {
+            FCITX_DEBUG() << "Sync state to focused ic: " << ic->program();
+            result.push_back(
+                std::make_unique<CheckInputMethodChanged>(ic, d_ptr));
+        }
+        return true;
+    });
+    return result;
+}
+
+void InputState::setActive(bool active) {
+    auto &state = shared();
+    if (state.active != active) {
+        auto imChanged = checkSharingInputContexts();
+        state.active = active;
+    }
+}
+
+void InputState::setLocalIM(const std::string &localIM) {
+    auto &state = shared();
+    if (state.localIM != localIM) {
+        auto imChanged = checkSharingInputContexts();
+        state.localIM = localIM;
     }
 }
 
 void InputState::reset() {
 #ifdef ENABLE_KEYBOARD
-    if (xkbComposeState_) {
-        xkb_compose_state_reset(xkbComposeState_.get());
+    if (composeState_) {
+        composeState_->reset();
     }
 #endif
     pendingGroupIndex_ = 0;
@@ -602,6 +1230,7 @@ void InputState::hideInputMethodInfo() {
 void InputState::resetXkbState() {
     lastXkbLayout_.clear();
     xkbState_.reset();
+    xkbStateStale_ = true;
 }
 #endif
 
@@ -642,14 +1271,22 @@ Instance::Instance(int argc, char **argv) {
         initAsDaemon();
     }
 
+    // Threads do not survive fork, so only start the log writer now.
+    if (arg.logSink && !Log::startAsyncLog(*arg.logSink, arg.logPath)) {
+        FCITX_WARN() << "Failed to open log file: " << arg.logPath;
+    }
+
     if (arg.overrideDelay > 0) {
         sleep(arg.overrideDelay);
     }
 
+    StartupTimeline::global().start();
     // we need fork before this
     d_ptr = std::make_unique<InstancePrivate>(this);
     FCITX_D();
     d->arg_ = arg;
+    // Write configs in background, file system may be slow, e.g. NFS.
+    StandardPath::global().setSaveDeferred(true);
     d->eventDispatcher_.attach(&d->eventLoop_);
     d->addonManager_.setInstance(this);
     d->addonManager_.setAddonOptions(arg.addonOptions_);
@@ -657,6 +1294,7 @@ Instance::Instance(int argc, char **argv) {
     d->connections_.emplace_back(
         d->imManager_.connect<InputMethodManager::CurrentGroupAboutToChange>(
             [this, d](const std::string &lastGroup) {
+                d->inputMethodEpoch_++;
                 d->icManager_.foreachFocused([this](InputContext *ic) {
                     assert(ic->hasFocus());
                     InputContextSwitchInputMethodEvent event(
@@ -671,6 +1309,7 @@ Instance::Instance(int argc, char **argv) {
     d->connections_.emplace_back(
         d->imManager_.connect<InputMethodManager::CurrentGroupChanged>(
             [this, d](const std::string &newGroup) {
+                d->inputMethodEpoch_++;
                 d->icManager_.foreachFocused([this](InputContext *ic) {
                     assert(ic->hasFocus());
                     InputContextSwitchInputMethodEvent event(
@@ -737,38 +1376,30 @@ Instance::Instance(int argc, char **argv) {
             CheckInputMethodChanged imChangedRAII(ic, d);
             auto origKey = keyEvent.origKey().normalize();
 
+            // Ordered by GlobalHotkey.
             struct {
-                const KeyList &list;
                 std::function<bool()> check;
                 std::function<void(bool)> trigger;
             } keyHandlers[] = {
-                {d->globalConfig_.triggerKeys(),
-                 [this]() { return canTrigger(); },
+                {[this]() { return canTrigger(); },
                  [this, ic](bool totallyReleased) {
                      return trigger(ic, totallyReleased);
                  }},
-                {d->globalConfig_.altTriggerKeys(),
-                 [this, ic]() { return canAltTrigger(ic); },
+                {[this, ic]() { return canAltTrigger(ic); },
                  [this, ic](bool) { return altTrigger(ic); }},
-                {d->globalConfig_.activateKeys(),
-                 [ic, d]() { return d->canActivate(ic); },
+                {[ic, d]() { return d->canActivate(ic); },
                  [this, ic](bool) { return activate(ic); }},
-                {d->globalConfig_.deactivateKeys(),
-                 [ic, d]() { return d->canDeactivate(ic); },
+                {[ic, d]() { return d->canDeactivate(ic); },
                  [this, ic](bool) { return deactivate(ic); }},
-                {d->globalConfig_.enumerateForwardKeys(),
-                 [this, ic]() { return canEnumerate(ic); },
+                {[this, ic]() { return canEnumerate(ic); },
                  [this, ic](bool) { return enumerate(ic, true); }},
-                {d->globalConfig_.enumerateBackwardKeys(),
-                 [this, ic]() { return canEnumerate(ic); },
+                {[this, ic]() { return canEnumerate(ic); },
                  [this, ic](bool) { return enumerate(ic, false); }},
-                {d->globalConfig_.enumerateGroupForwardKeys(),
-                 [this]() { return canChangeGroup(); },
+                {[this]() { return canChangeGroup(); },
                  [ic, d, origKey](bool) {
                      return d->navigateGroup(ic, origKey, true);
                  }},
-                {d->globalConfig_.enumerateGroupBackwardKeys(),
-                 [this]() { return canChangeGroup(); },
+                {[this]() { return canChangeGroup(); },
                  [ic, d, origKey](bool) {
                      return d->navigateGroup(ic, origKey, false);
                  }},
@@ -813,10 +1444,12 @@ Instance::Instance(int argc, char **argv) {
             }
 
             if (!keyEvent.filtered() && !keyEvent.isRelease()) {
+                const auto matched =
+                    d->globalConfig_.hotkeyMatcher().match(origKey);
                 int idx = 0;
                 for (auto &keyHandler : keyHandlers) {
-                    auto keyIdx = origKey.keyListIndex(keyHandler.list);
-                    if (keyIdx >= 0 && keyHandler.check()) {
+                    if ((matched & (static_cast<uint64_t>(1) << idx)) &&
+                        keyHandler.check()) {
                         inputState->keyReleased_ = idx;
                         inputState->lastKeyPressed_ = origKey;
                         if (isModifier) {
@@ -840,8 +1473,9 @@ Instance::Instance(int argc, char **argv) {
             auto &keyEvent = static_cast<KeyEvent &>(event);
             auto *ic = keyEvent.inputContext();
             if (!keyEvent.isRelease() &&
-                keyEvent.key().checkKeyList(
-                    d->globalConfig_.togglePreeditKeys())) {
+                d->globalConfig_.hotkeyMatcher().match(
+                    keyEvent.key(),
+                    static_cast<size_t>(GlobalHotkey::TogglePreedit))) {
                 ic->setEnablePreedit(!ic->isPreeditEnabled());
                 if (d->notifications_) {
                     d->notifications_->call<INotifications::showTip>(
@@ -929,7 +1563,7 @@ Instance::Instance(int argc, char **argv) {
         }));
     d->eventWatchers_.emplace_back(
         watchEvent(EventType::InputContextKeyEvent,
-                   EventWatcherPhase::InputMethod, [this](Event &event) {
+                   EventWatcherPhase::InputMethod, [this, d](Event &event) {
                        auto &keyEvent = static_cast<KeyEvent &>(event);
                        auto *ic = keyEvent.inputContext();
                        auto *engine = inputMethodEngine(ic);
@@ -937,7 +1571,14 @@ Instance::Instance(int argc, char **argv) {
                        if (!engine || !entry) {
                            return;
                        }
+                       if (!d->eventTracing_) {
+                           engine->keyEvent(*entry, keyEvent);
+                           return;
+                       }
+                       const auto start = now(CLOCK_MONOTONIC);
                        engine->keyEvent(*entry, keyEvent);
+                       d->addonLatency_[entry->addon()].add(
+                           now(CLOCK_MONOTONIC) - start);
                    }));
     d->eventWatchers_.emplace_back(watchEvent(
         EventType::InputContextVirtualKeyboardEvent,
@@ -1024,7 +1665,7 @@ Instance::Instance(int argc, char **argv) {
                 // Check if they are same IC, or they are same program.
                 return (icEvent.inputContext() == d->lastUnFocusedIc_.get()) ||
                        (!icEvent.inputContext()->program().empty() &&
-                        (icEvent.inputContext()->program() ==
+                        (&icEvent.inputContext()->program() ==
                          d->lastUnFocusedProgram_));
             };
 
@@ -1088,7 +1729,7 @@ Instance::Instance(int argc, char **argv) {
         EventType::InputContextFocusOut, EventWatcherPhase::InputMethod,
         [this, d](Event &event) {
             auto &icEvent = static_cast<InputContextEvent &>(event);
-            d->lastUnFocusedProgram_ = icEvent.inputContext()->program();
+            d->lastUnFocusedProgram_ = &icEvent.inputContext()->program();
             d->lastUnFocusedIc_ = icEvent.inputContext()->watch();
             deactivateInputMethod(icEvent);
             if (virtualKeyboardAutoHide()) {
@@ -1143,6 +1784,7 @@ Instance::Instance(int argc, char **argv) {
                 return;
             }
 
+            d->schedulePrewarm(ic);
             auto *inputState = ic->propertyFor(&d->inputStateFactory_);
             inputState->lastIMChangeIsAltTrigger_ =
                 icEvent.reason() == InputMethodSwitchedReason::AltTrigger;
@@ -1182,7 +1824,7 @@ Instance::Instance(int argc, char **argv) {
             if (icEvent.immediate()) {
                 d->uiManager_.update(icEvent.component(),
                                      icEvent.inputContext());
-                d->uiManager_.flush();
+                d->flushUI();
             } else {
                 d->uiManager_.update(icEvent.component(),
                                      icEvent.inputContext());
@@ -1198,10 +1840,18 @@ Instance::Instance(int argc, char **argv) {
     d->eventWatchers_.emplace_back(d->watchEvent(
         EventType::InputMethodModeChanged, EventWatcherPhase::ReservedFirst,
         [d](Event &) { d->uiManager_.updateAvailability(); }));
-    d->uiUpdateEvent_ = d->eventLoop_.addDeferEvent([d](EventSource *) {
-        d->uiManager_.flush();
-        return true;
-    });
+    for (auto type : {EventType::InputContextCommitString,
+                      EventType::InputContextCommitStringWithCursor}) {
+        d->eventWatchers_.emplace_back(
+            d->watchEvent(type, EventWatcherPhase::ReservedFirst,
+                          [d](Event &) { d->uiFlushUrgent_ = true; }));
+    }
+    d->uiUpdateEvent_ = d->eventLoop_.addDeferEvent(
+        [d](EventSource *) {
+            d->flushUICoalesced();
+            return true;
+        },
+        "Instance/UIUpdate");
     d->uiUpdateEvent_->setEnabled(false);
     d->periodicalSave_ = d->eventLoop_.addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 1000000, AutoSaveIdleTime,
@@ -1229,16 +1879,48 @@ Instance::Instance(int argc, char **argv) {
                 time->setOneShot();
             }
             return true;
-        });
+        },
+        "Instance/PeriodicalSave");
+    d->eventLoop_.setPriority(d->periodicalSave_.get(), EventPriority::Low);
     d->periodicalSave_->setEnabled(false);
+    d->idleTrimEvent_ = d->eventLoop_.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC), 0,
+        [this, d](EventSourceTime *time, uint64_t) {
+            const uint64_t idleTime =
+                d->globalConfig_.trimMemoryAfterIdle() * AutoSaveMinInUsecs;
+            if (exiting() || !idleTime) {
+                return true;
+            }
+            auto currentTime = now(CLOCK_MONOTONIC);
+            // Only trim once until there is new input.
+            if (d->idleStartTimestamp_ <= d->lastIdleTrimTimestamp_) {
+                time->setTime(currentTime + idleTime);
+            } else if (currentTime - d->idleStartTimestamp_ < idleTime) {
+                time->setTime(d->idleStartTimestamp_ + idleTime);
+            } else {
+                trimMemory(MemoryTrimLevel::Idle);
+                d->lastIdleTrimTimestamp_ = currentTime;
+                time->setTime(currentTime + idleTime);
+            }
+            time->setOneShot();
+            return true;
+        },
+        "Instance/IdleTrim");
+    d->eventLoop_.setPriority(d->idleTrimEvent_.get(), EventPriority::Low);
+    d->idleTrimEvent_->setEnabled(false);
 }
 
 Instance::~Instance() {
     FCITX_D();
     d->icManager_.finalize();
+    // Wait for the work of addons, before their code is unloaded.
+    d->workerPool_.reset();
     d->addonManager_.unload();
     d->notifications_ = nullptr;
     d->icManager_.setInstance(nullptr);
+    // Addons may save when they are unloaded.
+    StandardPath::global().flushSaves();
+    StandardPath::global().setSaveDeferred(false);
 }
 
 void InstanceArgument::parseOption(int argc, char **argv) {
@@ -1250,6 +1932,11 @@ void InstanceArgument::parseOption(int argc, char **argv) {
     struct option longOptions[] = {{"enable", required_argument, nullptr, 0},
                                    {"disable", required_argument, nullptr, 0},
                                    {"verbose", required_argument, nullptr, 0},
+                                   {"log", required_argument, nullptr, 0},
+                                   {"startup-timeline", no_argument, nullptr,
+                                    0},
+                                   {"benchmark-startup", no_argument, nullptr,
+                                    0},
                                    {"keep", no_argument, nullptr, 'k'},
                                    {"ui", required_argument, nullptr, 'u'},
                                    {"replace", no_argument, nullptr, 'r'},
@@ -1275,6 +1962,27 @@ void InstanceArgument::parseOption(int argc, char **argv) {
             case 2:
                 Log::setLogRule(optarg);
                 break;
+            case 3: {
+                // The writer thread is started by Instance, after forking
+                // into a daemon.
+                std::string_view backend = optarg;
+                if (backend == "stderr") {
+                    logSink = LogSink::Stderr;
+                } else if (backend == "journal") {
+                    logSink = LogSink::Journal;
+                } else if (stringutils::startsWith(backend, "file:")) {
+                    logSink = LogSink::File;
+                    logPath = std::string(backend.substr(5));
+                } else {
+                    FCITX_WARN() << "Invalid log backend: " << optarg;
+                }
+            } break;
+            case 4:
+                printStartupTimeline = true;
+                break;
+            case 5:
+                benchmarkStartup = true;
+                break;
             default:
                 quietQuit = true;
                 printUsage();
@@ -1335,10 +2043,12 @@ void Instance::setSignalPipe(int fd) {
     FCITX_D();
     d->signalPipe_ = fd;
     d->signalPipeEvent_ = d->eventLoop_.addIOEvent(
-        fd, IOEventFlag::In, [this](EventSource *, int, IOEventFlags) {
+        fd, IOEventFlag::In,
+        [this](EventSource *, int, IOEventFlags) {
             handleSignal();
             return true;
-        });
+        },
+        "Instance/SignalPipe");
 }
 
 bool Instance::willTryReplace() const {
@@ -1365,6 +2075,8 @@ void Instance::handleSignal() {
             exit();
         } else if (signo == SIGUSR1) {
             reloadConfig();
+        } else if (signo == SIGUSR2) {
+            FCITX_INFO() << "Recent key events:\n" << recentKeyEvents();
         } else if (signo == SIGCHLD) {
             d->zombieReaper_->setNextInterval(2000000);
             d->zombieReaper_->setOneShot();
@@ -1377,47 +2089,99 @@ void Instance::initialize() {
     if (!d->arg_.uiName.empty()) {
         d->arg_.enableList.push_back(d->arg_.uiName);
     }
-    reloadConfig();
+    {
+        StartupPhase phase("Instance/ReloadConfig");
+        reloadConfig();
+    }
+    d->inputStateFactory_.setCreateOnDemand(true);
     d->icManager_.registerProperty("inputState", &d->inputStateFactory_);
     std::unordered_set<std::string> enabled;
     std::unordered_set<std::string> disabled;
     std::tie(enabled, disabled) = d->overrideAddons();
     FCITX_INFO() << "Override Enabled Addons: " << enabled;
     FCITX_INFO() << "Override Disabled Addons: " << disabled;
-    d->addonManager_.load(enabled, disabled);
+    {
+        StartupPhase phase("AddonManager/Load");
+        d->addonManager_.load(enabled, disabled);
+    }
     if (d->exit_) {
         return;
     }
-    d->imManager_.load([d](InputMethodManager &) { d->buildDefaultGroup(); });
-    d->uiManager_.load(d->arg_.uiName);
+    {
+        StartupPhase phase("InputMethodManager/Load");
+        d->imManager_.load(
+            [d](InputMethodManager &) { d->buildDefaultGroup(); });
+    }
+    {
+        StartupPhase phase("UserInterfaceManager/Load");
+        d->uiManager_.load(d->arg_.uiName);
+    }
 
     const auto *entry = d->imManager_.entry("keyboard-us");
     FCITX_LOG_IF(Error, !entry) << "Couldn't find keyboard-us";
+    // Benchmark measures the time until the first key can be handled, so do
+    // not wait for the rest of the session to settle down.
+    const uint64_t preloadDelay = d->arg_.benchmarkStartup ? 0 : 1000000;
     d->preloadInputMethodEvent_ = d->eventLoop_.addTimeEvent(
-        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 1000000, 0,
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + preloadDelay, 0,
         [this](EventSourceTime *, uint64_t) {
             FCITX_D();
-            if (d->exit_ || !d->globalConfig_.preloadInputMethod()) {
+            if (d->exit_ || (!d->globalConfig_.preloadInputMethod() &&
+                             !d->arg_.benchmarkStartup)) {
+                d->finishStartupTimeline();
                 return false;
             }
-            // Preload first input method.
-            if (!d->imManager_.currentGroup().inputMethodList().empty()) {
-                if (auto entry =
-                        d->imManager_.entry(d->imManager_.currentGroup()
-                                                .inputMethodList()[0]
-                                                .name())) {
-                    d->addonManager_.addon(entry->addon(), true);
-                }
+            d->preloadInputMethods();
+            d->finishStartupTimeline();
+            return false;
+        },
+        "Instance/PreloadInputMethod");
+    d->buildAddonTriggers();
+    // Load one addon at a time, so the event loop is never blocked for the
+    // duration of all of them.
+    d->prewarmAddonEvent_ = d->eventLoop_.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 5000000, 0,
+        [this](EventSourceTime *time, uint64_t) {
+            FCITX_D();
+            if (d->exit_ || d->prewarmAddons_.empty()) {
+                return false;
             }
-            // Preload default input method.
-            if (!d->imManager_.currentGroup().defaultInputMethod().empty()) {
-                if (auto entry = d->imManager_.entry(
-                        d->imManager_.currentGroup().defaultInputMethod())) {
-                    d->addonManager_.addon(entry->addon(), true);
-                }
+            auto name = d->prewarmAddons_.front();
+            FCITX_DEBUG() << "Prewarm addon " << name;
+            d->loadTriggeredAddon(name);
+            // The list is rebuilt after the addon is loaded, erase it in case
+            // it failed to load.
+            d->prewarmAddons_.erase(std::remove(d->prewarmAddons_.begin(),
+                                                d->prewarmAddons_.end(), name),
+                                    d->prewarmAddons_.end());
+            if (!d->prewarmAddons_.empty()) {
+                time->setNextInterval(200000);
+                time->setOneShot();
             }
             return false;
-        });
+        },
+        "Instance/PrewarmAddon");
+    d->eventLoop_.setPriority(d->prewarmAddonEvent_.get(), EventPriority::Low);
+    d->prewarmInputMethodEvent_ = d->eventLoop_.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC), 0,
+        [d](EventSourceTime *time, uint64_t) {
+            if (d->exit_) {
+                return false;
+            }
+            // Wait until the input stops.
+            const auto idleTime = d->idleStartTimestamp_ + PrewarmIdleTime;
+            if (now(CLOCK_MONOTONIC) < idleTime) {
+                time->setTime(idleTime);
+                time->setOneShot();
+                return false;
+            }
+            d->prewarmInputMethods();
+            return false;
+        },
+        "Instance/PrewarmInputMethod");
+    d->eventLoop_.setPriority(d->prewarmInputMethodEvent_.get(),
+                              EventPriority::Low);
+    d->prewarmInputMethodEvent_->setEnabled(false);
     d->zombieReaper_ = d->eventLoop_.addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC), 0,
         [](EventSourceTime *, uint64_t) {
@@ -1425,15 +2189,46 @@ void Instance::initialize() {
             while ((res = waitpid(-1, nullptr, WNOHANG)) > 0) {
             }
             return false;
-        });
+        },
+        "Instance/ZombieReaper");
+    d->eventLoop_.setPriority(d->zombieReaper_.get(), EventPriority::Low);
     d->zombieReaper_->setEnabled(false);
 
-    d->exitEvent_ = d->eventLoop_.addExitEvent([this](EventSource *) {
-        FCITX_DEBUG() << "Running save...";
-        save();
-        return false;
-    });
+    d->exitEvent_ = d->eventLoop_.addExitEvent(
+        [this](EventSource *) {
+            FCITX_DEBUG() << "Running save...";
+            save();
+            StandardPath::global().flushSaves();
+            return false;
+        },
+        "Instance/Exit");
     d->notifications_ = d->addonManager_.addon("notifications", true);
+
+    d->memoryPressureFD_ = openMemoryPressureWatch();
+    if (d->memoryPressureFD_.isValid()) {
+        try {
+            d->memoryPressureEvent_ = d->eventLoop_.addIOEvent(
+                d->memoryPressureFD_.fd(), IOEventFlag::Priority,
+                [this, d](EventSourceIO *source, int, IOEventFlags flags) {
+                    // e.g. the cgroup is gone.
+                    if (flags & IOEventFlag::Err) {
+                        source->setEnabled(false);
+                        return true;
+                    }
+                    auto currentTime = now(CLOCK_MONOTONIC);
+                    if (currentTime - d->lastPressureTrimTimestamp_ >=
+                        PressureTrimInterval) {
+                        d->lastPressureTrimTimestamp_ = currentTime;
+                        trimMemory(MemoryTrimLevel::Pressure);
+                    }
+                    return true;
+                },
+                "Instance/MemoryPressure");
+        } catch (const EventLoopException &) {
+            FCITX_WARN() << "Failed to watch memory pressure.";
+            d->memoryPressureFD_.reset();
+        }
+    }
 }
 
 int Instance::exec() {
@@ -1548,6 +2343,14 @@ EventDispatcher &Instance::eventDispatcher() {
     return d->eventDispatcher_;
 }
 
+WorkerPool &Instance::workerPool() {
+    FCITX_D();
+    if (!d->workerPool_) {
+        d->workerPool_ = std::make_unique<WorkerPool>(&d->eventDispatcher_);
+    }
+    return *d->workerPool_;
+}
+
 InputContextManager &Instance::inputContextManager() {
     FCITX_D();
     return d->icManager_;
@@ -1587,26 +2390,54 @@ bool Instance::postEvent(Event &event) const {
     if (d->exit_) {
         return false;
     }
-    auto iter = d->eventHandlers_.find(event.type());
-    if (iter != d->eventHandlers_.end()) {
-        auto &handlers = iter->second;
-        EventWatcherPhase phaseOrder[] = {
-            EventWatcherPhase::ReservedFirst, EventWatcherPhase::PreInputMethod,
-            EventWatcherPhase::InputMethod, EventWatcherPhase::PostInputMethod,
-            EventWatcherPhase::ReservedLast};
-
-        for (auto phase : phaseOrder) {
-            if (auto iter2 = handlers.find(phase); iter2 != handlers.end()) {
-                for (auto &handler : iter2->second.view()) {
-                    handler(event);
-                    if (event.filtered()) {
-                        break;
-                    }
+    d_ptr->triggerAddons(event);
+    // Hold a reference, so the list stays valid even if a handler adds or
+    // removes watchers while we are iterating.
+    auto handlers = d->eventDispatchList(event.type());
+    if (!handlers->empty()) {
+        const bool isKeyEvent = event.type() == EventType::InputContextKeyEvent;
+        const uint64_t start = isKeyEvent ? now(CLOCK_MONOTONIC) : 0;
+        const EventDispatchEntry *filteredBy = nullptr;
+        bool hasRemovedHandler = false;
+        // Handlers removed during dispatch are destructed afterwards.
+        HandlerPool<EventHandler>::IterationGuard guard(
+            d->eventHandlerPool_.get());
+        if (d->eventTracing_ && isKeyEvent) {
+            filteredBy =
+                d_ptr->dispatchTraced(*handlers, event, hasRemovedHandler);
+        } else {
+            for (const auto &entry : *handlers) {
+                // Handler entry is already deleted, compact the list next
+                // time.
+                auto *handler = d->eventHandlerPool_->get(entry.handler);
+                if (!handler) {
+                    hasRemovedHandler = true;
+                    continue;
+                }
+                (*handler)(event);
+                if (event.filtered()) {
+                    filteredBy = &entry;
+                    break;
                 }
             }
-            if (event.filtered()) {
-                break;
+        }
+        if (isKeyEvent) {
+            auto &keyEvent = static_cast<KeyEvent &>(event);
+            const InputMethodEntry *entry = nullptr;
+            if (filteredBy &&
+                filteredBy->phase == EventWatcherPhase::InputMethod) {
+                entry =
+                    d_ptr->q_func()->inputMethodEntry(keyEvent.inputContext());
             }
+            d_ptr->keyEventRecorder_.record(keyEvent, start,
+                                            now(CLOCK_MONOTONIC), filteredBy,
+                                            entry);
+            if (d_ptr->keyTrace_) {
+                d_ptr->keyTrace_->write(keyEvent, start);
+            }
+        }
+        if (hasRemovedHandler) {
+            d->invalidateEventDispatchList(event.type());
         }
 
         // Make sure this part of fix is always executed regardless of the
@@ -1640,7 +2471,7 @@ bool Instance::postEvent(Event &event) const {
                 ic->forwardKey(keyEvent.origKey(), keyEvent.isRelease(),
                                keyEvent.time());
             }
-            d_ptr->uiManager_.flush();
+            d_ptr->flushUICoalesced();
         }
     }
     return event.accepted();
@@ -1657,6 +2488,133 @@ Instance::watchEvent(EventType type, EventWatcherPhase phase,
     return d->watchEvent(type, phase, std::move(callback));
 }
 
+void Instance::setEventTracingEnabled(bool enable) {
+    FCITX_D();
+    d->eventTracing_ = enable;
+}
+
+bool Instance::isEventTracingEnabled() const {
+    FCITX_D();
+    return d->eventTracing_;
+}
+
+std::vector<EventLatencyStatistic> Instance::eventLatencyStatistics() const {
+    FCITX_D();
+    std::vector<EventLatencyStatistic> result;
+    auto append = [&result](std::string name,
+                            const LatencyHistogram &histogram) {
+        if (!histogram.count()) {
+            return;
+        }
+        result.push_back({std::move(name), histogram.count(),
+                          histogram.percentile(50), histogram.percentile(99)});
+    };
+    append("Total", d->totalLatency_);
+    for (auto phase : eventWatcherPhaseOrder) {
+        if (auto iter = d->phaseLatency_.find(phase);
+            iter != d->phaseLatency_.end()) {
+            append(stringutils::concat("Phase/", eventWatcherPhaseName(phase)),
+                   iter->second);
+        }
+    }
+    for (const auto &[addon, histogram] : d->addonLatency_) {
+        append(stringutils::concat("Addon/", addon), histogram);
+    }
+    return result;
+}
+
+std::string Instance::recentKeyEvents() const {
+    FCITX_D();
+    return d->keyEventRecorder_.dump(now(CLOCK_MONOTONIC));
+}
+
+bool Instance::startKeyTrace(const std::string &path) {
+    FCITX_D();
+    UnixFD fd = UnixFD::own(
+        open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+    if (!fd.isValid()) {
+        FCITX_ERROR() << "Failed to open key trace file: " << path;
+        return false;
+    }
+    d->keyTrace_ = std::make_unique<KeyTraceWriter>(std::move(fd));
+    return true;
+}
+
+void Instance::stopKeyTrace() {
+    FCITX_D();
+    d->keyTrace_.reset();
+}
+
+std::string Instance::startupTimeline() const {
+    return StartupTimeline::global().report();
+}
+
+xkb_keymap *Instance::xkbKeymapFromString(std::string_view keymap) {
+#ifdef ENABLE_KEYBOARD
+    FCITX_D();
+    return d->keymapCache_.fromString(keymap);
+#else
+    FCITX_UNUSED(keymap);
+    return nullptr;
+#endif
+}
+
+xkb_keymap *Instance::xkbKeymapFromNames(const std::string &rules,
+                                         const std::string &model,
+                                         const std::string &layout,
+                                         const std::string &variant,
+                                         const std::string &options) {
+#ifdef ENABLE_KEYBOARD
+    FCITX_D();
+    return d->keymapCache_.fromNames(rules.c_str(), model.c_str(),
+                                     layout.c_str(), variant.c_str(),
+                                     options.c_str());
+#else
+    FCITX_UNUSED(rules);
+    FCITX_UNUSED(model);
+    FCITX_UNUSED(layout);
+    FCITX_UNUSED(variant);
+    FCITX_UNUSED(options);
+    return nullptr;
+#endif
+}
+
+std::pair<size_t, size_t> Instance::xkbKeymapCacheUsage() const {
+#ifdef ENABLE_KEYBOARD
+    FCITX_D();
+    return {d->keymapCache_.size(), d->keymapCache_.memoryUsage()};
+#else
+    return {0, 0};
+#endif
+}
+
+void Instance::trimMemory(MemoryTrimLevel level) {
+    FCITX_D();
+    FCITX_DEBUG() << "Trim memory, level: " << static_cast<int>(level);
+    for (const auto &name : d->addonManager_.loadedAddonNames()) {
+        if (auto *addon = d->addonManager_.lookupAddon(name)) {
+            addon->trimMemory(level);
+        }
+    }
+#ifdef ENABLE_KEYBOARD
+    // Keymaps are expensive to compile, and the ones in use are still kept
+    // by their users.
+    if (level == MemoryTrimLevel::Pressure) {
+        d->keymapCache_.clear();
+    }
+#endif
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+void Instance::resetEventLatencyStatistics() {
+    FCITX_D();
+    d->totalLatency_ = LatencyHistogram();
+    d->phaseLatency_.clear();
+    d->addonLatency_.clear();
+}
+
 bool groupContains(const InputMethodGroup &group, const std::string &name) {
     const auto &list = group.inputMethodList();
     auto iter = std::find_if(list.begin(), list.end(),
@@ -1692,9 +2650,9 @@ std::string Instance::inputMethod(InputContext *ic) {
         return "";
     }
     if (inputState->isActive()) {
-        if (!inputState->localIM_.empty() &&
-            groupContains(group, inputState->localIM_)) {
-            return inputState->localIM_;
+        const auto &localIM = inputState->localIM();
+        if (!localIM.empty() && groupContains(group, localIM)) {
+            return localIM;
         }
         return group.defaultInputMethod();
     }
@@ -1708,7 +2666,20 @@ const InputMethodEntry *Instance::inputMethodEntry(InputContext *ic) {
     if (imName.empty()) {
         return nullptr;
     }
-    return d->imManager_.entry(imName);
+    auto *inputState = ic->propertyFor(&d->inputStateFactory_);
+    if (inputState->cachedEpoch_ == d->inputMethodEpoch_ &&
+        inputState->cachedIM_ == imName) {
+        return inputState->cachedEntry_;
+    }
+    const auto *entry = d->imManager_.entry(imName);
+    // Entries are never removed, but a missing one may be added later.
+    if (entry) {
+        inputState->cachedIM_ = std::move(imName);
+        inputState->cachedEntry_ = entry;
+        inputState->cachedEngine_ = nullptr;
+        inputState->cachedEpoch_ = d->inputMethodEpoch_;
+    }
+    return entry;
 }
 
 InputMethodEngine *Instance::inputMethodEngine(InputContext *ic) {
@@ -1717,8 +2688,13 @@ InputMethodEngine *Instance::inputMethodEngine(InputContext *ic) {
     if (!entry) {
         return nullptr;
     }
-    return static_cast<InputMethodEngine *>(
-        d->addonManager_.addon(entry->addon(), true));
+    // inputMethodEntry always updates the cache for a valid entry.
+    auto *inputState = ic->propertyFor(&d->inputStateFactory_);
+    if (!inputState->cachedEngine_) {
+        inputState->cachedEngine_ = static_cast<InputMethodEngine *>(
+            d->addonManager_.addon(entry->addon(), true));
+    }
+    return inputState->cachedEngine_;
 }
 
 InputMethodEngine *Instance::inputMethodEngine(const std::string &name) {
@@ -1768,40 +2744,28 @@ uint32_t Instance::processCompose(InputContext *ic, KeySym keysym) {
     FCITX_D();
     auto *state = ic->propertyFor(&d->inputStateFactory_);
 
-    auto *xkbComposeState = state->xkbComposeState();
-    if (!xkbComposeState) {
+    auto *composeState = state->composeState();
+    if (!composeState || !composeState->feed(keysym)) {
         return 0;
     }
 
-    auto keyval = static_cast<xkb_keysym_t>(keysym);
-
-    enum xkb_compose_feed_result result =
-        xkb_compose_state_feed(xkbComposeState, keyval);
-    if (result == XKB_COMPOSE_FEED_IGNORED) {
+    const auto status = composeState->status();
+    if (status == ComposeStatus::Nothing) {
         return 0;
     }
-
-    enum xkb_compose_status status =
-        xkb_compose_state_get_status(xkbComposeState);
-    if (status == XKB_COMPOSE_NOTHING) {
-        return 0;
-    }
-    if (status == XKB_COMPOSE_COMPOSED) {
-        char buffer[FCITX_UTF8_MAX_LENGTH + 1] = {'\0', '\0', '\0', '\0',
-                                                  '\0', '\0', '\0'};
-        int length =
-            xkb_compose_state_get_utf8(xkbComposeState, buffer, sizeof(buffer));
-        xkb_compose_state_reset(xkbComposeState);
-        if (length == 0) {
+    if (status == ComposeStatus::Composed) {
+        const auto text = composeState->text();
+        composeState->reset();
+        if (text.empty()) {
             return FCITX_INVALID_COMPOSE_RESULT;
         }
 
         uint32_t c = 0;
-        fcitx_utf8_get_char(buffer, &c);
+        fcitx_utf8_get_char(text.data(), &c);
         return c;
     }
-    if (status == XKB_COMPOSE_CANCELLED) {
-        xkb_compose_state_reset(xkbComposeState);
+    if (status == ComposeStatus::Cancelled) {
+        composeState->reset();
     }
 
     return FCITX_INVALID_COMPOSE_RESULT;
@@ -1818,43 +2782,25 @@ std::optional<std::string> Instance::processComposeString(InputContext *ic,
     FCITX_D();
     auto *state = ic->propertyFor(&d->inputStateFactory_);
 
-    auto *xkbComposeState = state->xkbComposeState();
-    if (!xkbComposeState) {
+    auto *composeState = state->composeState();
+    if (!composeState || !composeState->feed(keysym)) {
         return std::string();
     }
 
-    auto keyval = static_cast<xkb_keysym_t>(keysym);
-    enum xkb_compose_feed_result result =
-        xkb_compose_state_feed(xkbComposeState, keyval);
-
-    if (result == XKB_COMPOSE_FEED_IGNORED) {
+    const auto status = composeState->status();
+    if (status == ComposeStatus::Nothing) {
         return std::string();
     }
-
-    enum xkb_compose_status status =
-        xkb_compose_state_get_status(xkbComposeState);
-    if (status == XKB_COMPOSE_NOTHING) {
-        return std::string();
-    }
-    if (status == XKB_COMPOSE_COMPOSED) {
-        // This may not be NUL-terminiated.
-        std::array<char, 256> buffer;
-        auto length = xkb_compose_state_get_utf8(xkbComposeState, buffer.data(),
-                                                 buffer.size());
-        xkb_compose_state_reset(xkbComposeState);
-        if (length == 0) {
+    if (status == ComposeStatus::Composed) {
+        auto text = composeState->text();
+        composeState->reset();
+        if (text.empty() || !utf8::validate(text)) {
             return std::nullopt;
         }
-
-        const auto bufferBegin = buffer.begin();
-        const auto bufferEnd = std::next(bufferBegin, length);
-        if (utf8::validate(bufferBegin, bufferEnd)) {
-            return std::string(bufferBegin, bufferEnd);
-        }
-        return std::nullopt;
+        return text;
     }
-    if (status == XKB_COMPOSE_CANCELLED) {
-        xkb_compose_state_reset(xkbComposeState);
+    if (status == ComposeStatus::Cancelled) {
+        composeState->reset();
     }
     return std::nullopt;
 #else
@@ -1869,13 +2815,12 @@ bool Instance::isComposing(InputContext *inputContext) {
     FCITX_D();
     auto *state = inputContext->propertyFor(&d->inputStateFactory_);
 
-    auto *xkbComposeState = state->xkbComposeState();
-    if (!xkbComposeState) {
+    auto *composeState = state->composeState();
+    if (!composeState) {
         return false;
     }
 
-    return xkb_compose_state_get_status(xkbComposeState) ==
-           XKB_COMPOSE_COMPOSING;
+    return composeState->status() == ComposeStatus::Composing;
 #else
     FCITX_UNUSED(inputContext);
     return false;
@@ -1886,11 +2831,11 @@ void Instance::resetCompose(InputContext *inputContext) {
 #ifdef ENABLE_KEYBOARD
     FCITX_D();
     auto *state = inputContext->propertyFor(&d->inputStateFactory_);
-    auto *xkbComposeState = state->xkbComposeState();
-    if (!xkbComposeState) {
+    auto *composeState = state->composeState();
+    if (!composeState) {
         return;
     }
-    xkb_compose_state_reset(xkbComposeState);
+    composeState->reset();
 #else
     FCITX_UNUSED(inputContext);
 #endif
@@ -1972,6 +2917,7 @@ void Instance::refresh() {
     FCITX_D();
     auto [enabled, disabled] = d->overrideAddons();
     d->addonManager_.load(enabled, disabled);
+    d->buildAddonTriggers();
     d->imManager_.refresh();
 }
 
@@ -1982,7 +2928,12 @@ void Instance::reloadConfig() {
         standardPath.open(StandardPath::Type::PkgConfig, "config", O_RDONLY);
     RawConfig config;
     readFromIni(config, file.fd());
+    const auto shareInputState = d->globalConfig_.shareInputState();
     d->globalConfig_.load(config);
+    if (shareInputState != d->globalConfig_.shareInputState()) {
+        d->shareInputStateEpoch_++;
+        d->sharedInputStates_.clear();
+    }
     FCITX_DEBUG() << "Trigger Key: "
                   << Key::keyListToString(d->globalConfig_.triggerKeys());
     d->icManager_.setPropertyPropagatePolicy(
@@ -1997,7 +2948,6 @@ void Instance::reloadConfig() {
         });
     }
 #ifdef ENABLE_KEYBOARD
-    d->keymapCache_.clear();
     if (d->inputStateFactory_.registered()) {
         d->icManager_.foreach([d](InputContext *ic) {
             auto *inputState = ic->propertyFor(&d->inputStateFactory_);
@@ -2006,6 +2956,8 @@ void Instance::reloadConfig() {
         });
     }
 #endif
+    // Trigger keys may come from the configuration of the addons.
+    d->buildAddonTriggers();
     if (d->running_) {
         postEvent(GlobalConfigReloadedEvent());
     }
@@ -2017,6 +2969,15 @@ void Instance::reloadConfig() {
                                             d->globalConfig_.autoSavePeriod());
         d->periodicalSave_->setOneShot();
     }
+
+    if (d->globalConfig_.trimMemoryAfterIdle() <= 0) {
+        d->idleTrimEvent_->setEnabled(false);
+    } else {
+        d->idleTrimEvent_->setTime(now(CLOCK_MONOTONIC) +
+                                   AutoSaveMinInUsecs *
+                                       d->globalConfig_.trimMemoryAfterIdle());
+        d->idleTrimEvent_->setOneShot();
+    }
 }
 
 void Instance::resetInputMethodList() {
@@ -2342,7 +3303,7 @@ InputContext *Instance::mostRecentInputContext() {
 
 void Instance::flushUI() {
     FCITX_D();
-    d->uiManager_.flush();
+    d->flushUI();
 }
 
 int scoreForGroup(FocusGroup *group, const std::string &displayHint) {
@@ -2407,24 +3368,8 @@ void Instance::activateInputMethod(InputContextEvent &event) {
         return;
     }
 #ifdef ENABLE_KEYBOARD
-    if (auto *xkbState = inputState->customXkbState(true)) {
-        if (auto *mods = findValue(d->stateMask_, ic->display())) {
-            FCITX_KEYTRACE() << "Update mask to customXkbState";
-            auto depressed = std::get<0>(*mods);
-            auto latched = std::get<1>(*mods);
-            auto locked = std::get<2>(*mods);
-
-            // set modifiers in depressed if they don't appear in any of the
-            // final masks
-            // depressed |= ~(depressed | latched | locked);
-            FCITX_KEYTRACE() << depressed << " " << latched << " " << locked;
-            if (depressed == 0) {
-                inputState->setModsAllReleased();
-            }
-            xkb_state_update_mask(xkbState, depressed, latched, locked, 0, 0,
-                                  0);
-        }
-    }
+    // Rebuilt with the current modifiers by the next key event.
+    inputState->refreshXkbState();
 #endif
     ic->statusArea().clearGroup(StatusGroup::InputMethod);
     engine->activate(*entry, event);
@@ -2526,7 +3471,6 @@ void Instance::setXkbParameters(const std::string &display,
     }
 
     if (resetState) {
-        d->keymapCache_[display].clear();
         d->icManager_.foreach([d, &display](InputContext *ic) {
             if (ic->display() == display ||
                 d->xkbParams_.count(ic->display()) == 0) {
@@ -7,18 +7,27 @@
 #ifndef _FCITX_INSTANCE_H_
 #define _FCITX_INSTANCE_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include <fcitx-utils/connectableobject.h>
 #include <fcitx-utils/macros.h>
+#include <fcitx/addoninstance.h>
 #include <fcitx/event.h>
 #include <fcitx/globalconfig.h>
 #include <fcitx/text.h>
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/workerpool.h"
 #include "fcitxcore_export.h"
 
 #define FCITX_INVALID_COMPOSE_RESULT 0xffffffff
 
+struct xkb_keymap;
+
 namespace fcitx {
 
 class InputContext;
@@ -35,6 +44,23 @@ class FocusGroup;
 
 using EventHandler = std::function<void(Event &event)>;
 
+/**
+ * Latency statistics of one traced stage of key event handling.
+ *
+ * All durations are in microseconds.
+ *
+ * @see Instance::setEventTracingEnabled
+ * @since 5.1.12
+ */
+struct EventLatencyStatistic {
+    /// Name of stage, e.g. "Total", "Phase/InputMethod" or "Addon/pinyin".
+    std::string name;
+    /// Number of samples, older samples are decayed over time.
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+};
+
 /**
  * The function mode of virtual keyboard.
  */
@@ -165,6 +191,18 @@ public:
      */
     EventDispatcher &eventDispatcher();
 
+    /**
+     * Return the worker pool shared by all addons.
+     *
+     * Continuations of the pool run on the event loop of instance. The pool
+     * is destroyed before addons are unloaded, so running work is finished
+     * while the code of the addon is still loaded.
+     *
+     * @return shared worker pool.
+     * @since 5.1.12
+     */
+    WorkerPool &workerPool();
+
     /// Get the addon manager.
     AddonManager &addonManager();
 
@@ -571,6 +609,133 @@ public:
      */
     bool canRestart() const;
 
+    /**
+     * Enable latency tracing of key events.
+     *
+     * When enabled, time spent in each event watcher phase, and in each input
+     * method addon is recorded. Tracing is disabled by default.
+     *
+     * @see Instance::eventLatencyStatistics
+     * @since 5.1.12
+     */
+    void setEventTracingEnabled(bool enable);
+
+    /**
+     * Whether key event latency tracing is enabled.
+     *
+     * @since 5.1.12
+     */
+    bool isEventTracingEnabled() const;
+
+    /**
+     * Return the collected key event latency statistics.
+     *
+     * @since 5.1.12
+     */
+    std::vector<EventLatencyStatistic> eventLatencyStatistics() const;
+
+    /**
+     * Clear all collected key event latency statistics.
+     *
+     * @since 5.1.12
+     */
+    void resetEventLatencyStatistics();
+
+    /**
+     * Return a human readable dump of the most recent key events.
+     *
+     * The last few hundred key events are always recorded with the input
+     * context, frontend, key, the phase and input method that filtered it, and
+     * the time spent on dispatching. It is also written to the log when fcitx
+     * receives SIGUSR2.
+     *
+     * @since 5.1.12
+     */
+    std::string recentKeyEvents() const;
+
+    /**
+     * Start writing all key events to a binary trace file.
+     *
+     * Only the key, the time between keys, the program and the frontend are
+     * written, input contexts are replaced by a small number. The trace can be
+     * replayed with fcitx5-bench. A running trace is replaced.
+     *
+     * @param path file to write, it is truncated.
+     * @return whether the file is opened.
+     * @since 5.1.12
+     */
+    bool startKeyTrace(const std::string &path);
+
+    /**
+     * Stop the key trace and flush it to the file.
+     *
+     * @since 5.1.12
+     */
+    void stopKeyTrace();
+
+    /**
+     * Return the time spent in each phase of the startup.
+     *
+     * It covers loading the config, each addon and input method, building the
+     * default group, and the XKB compose table and keymaps, until the first
+     * input method is preloaded. It can also be printed to the log with the
+     * command line option --startup-timeline.
+     *
+     * @since 5.1.12
+     */
+    std::string startupTimeline() const;
+
+    /**
+     * Return a compiled xkb keymap for the keymap in text format.
+     *
+     * Keymaps are cached for the whole process by their content, so the same
+     * keymap is never compiled twice, e.g. when multiple seats or virtual
+     * keyboards use the same keymap. The keymap is owned by the cache, caller
+     * need to use xkb_keymap_ref if it needs to keep the keymap.
+     *
+     * @param keymap keymap text, may be null terminated.
+     * @return keymap, or nullptr if the keymap can not be compiled or the
+     * keyboard support is disabled.
+     * @since 5.1.12
+     */
+    struct xkb_keymap *xkbKeymapFromString(std::string_view keymap);
+
+    /**
+     * Return a compiled xkb keymap for the RMLVO names.
+     *
+     * It shares the same cache with xkbKeymapFromString.
+     *
+     * @see Instance::xkbKeymapFromString
+     * @since 5.1.12
+     */
+    struct xkb_keymap *xkbKeymapFromNames(const std::string &rules,
+                                          const std::string &model,
+                                          const std::string &layout,
+                                          const std::string &variant,
+                                          const std::string &options);
+
+    /**
+     * Return the number of cached keymaps and their approximate memory usage
+     * in bytes.
+     *
+     * @since 5.1.12
+     */
+    std::pair<size_t, size_t> xkbKeymapCacheUsage() const;
+
+    /**
+     * Ask all the loaded addons to release their caches, then give the free
+     * memory back to the system.
+     *
+     * It is called after no input for GlobalConfig::trimMemoryAfterIdle
+     * minutes with MemoryTrimLevel::Idle. When fcitx runs as a systemd
+     * service with memory pressure watch, it is also called with
+     * MemoryTrimLevel::Pressure when the pressure is high.
+     *
+     * @see AddonInstance::setTrimMemoryCallback
+     * @since 5.1.12
+     */
+    void trimMemory(MemoryTrimLevel level);
+
 protected:
     // For testing purpose
     InstancePrivate *privateData();
@@ -7,50 +7,74 @@
 #ifndef _FCITX_INSTANCE_P_H_
 #define _FCITX_INSTANCE_P_H_
 
+#include <array>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/eventdispatcher.h"
 #include "fcitx-utils/handlertable.h"
+#include "fcitx-utils/log.h"
 #include "fcitx-utils/misc.h"
 #include "fcitx-utils/trackableobject.h"
+#include "fcitx-utils/unixfd.h"
+#include "fcitx-utils/workerpool.h"
 #include "config.h"
+#include "inputcontext.h"
 #include "inputcontextproperty.h"
 #include "inputmethodmanager.h"
 #include "instance.h"
+#include "keytrace_p.h"
 #include "userinterfacemanager.h"
 
 #ifdef ENABLE_KEYBOARD
 #include <xkbcommon/xkbcommon-compose.h>
 #include <xkbcommon/xkbcommon.h>
+#include "composetable_p.h"
+#include "keymapcache_p.h"
 #endif
 
 namespace fcitx {
 
 class CheckInputMethodChanged;
 
+// State that is shared by all the input contexts in the same share set of
+// ShareInputState. key is only set if it is registered to InstancePrivate.
+struct SharedInputState {
+    std::optional<std::string> key;
+    bool active = false;
+    std::string localIM;
+};
+
 struct InputState : public InputContextProperty {
     InputState(InstancePrivate *d, InputContext *ic);
+    ~InputState();
 
-    bool needCopy() const override { return true; }
-    void copyTo(InputContextProperty *other) override;
     void reset();
     void showInputMethodInformation(const std::string &name);
     void hideInputMethodInfo();
 
 #ifdef ENABLE_KEYBOARD
-    xkb_state *customXkbState(bool refresh = false);
+    // Custom xkb state of the current input method, nullptr if the system
+    // layout is used. It is created lazily from the current modifiers.
+    xkb_state *customXkbState();
     void resetXkbState();
+    // Recreate the custom state on next use, even if layout is not changed.
+    void refreshXkbState() { xkbStateStale_ = true; }
 
-    auto xkbComposeState() { return xkbComposeState_.get(); }
+    auto composeState() { return composeState_.get(); }
     void setModsAllReleased() { modsAllReleased_ = true; }
     bool isModsAllReleased() const { return modsAllReleased_; }
 #endif
 
-    bool isActive() const { return active_; }
+    bool isActive() { return shared().active; }
     void setActive(bool active);
+    const std::string &localIM() { return shared().localIM; }
     void setLocalIM(const std::string &localIM);
 
     CheckInputMethodChanged *imChanged_ = nullptr;
@@ -66,23 +90,40 @@ struct InputState : public InputContextProperty {
 
     std::string overrideDeactivateIM_;
 
-    std::string localIM_;
+    // Entry and engine of cachedIM_, only valid if cachedEpoch_ equals to
+    // InstancePrivate::inputMethodEpoch_. Engine is resolved on demand.
+    std::string cachedIM_;
+    const InputMethodEntry *cachedEntry_ = nullptr;
+    InputMethodEngine *cachedEngine_ = nullptr;
+    uint64_t cachedEpoch_ = 0;
 
 private:
+    SharedInputState &shared();
+    void attachSharedState();
+    std::vector<std::unique_ptr<CheckInputMethodChanged>>
+    checkSharingInputContexts();
+
     InstancePrivate *d_ptr;
     InputContext *ic_;
 
 #ifdef ENABLE_KEYBOARD
-    UniqueCPtr<xkb_compose_state, xkb_compose_state_unref> xkbComposeState_;
+    std::unique_ptr<ComposeTableState> composeState_;
     UniqueCPtr<xkb_state, xkb_state_unref> xkbState_;
     bool modsAllReleased_ = false;
     std::string lastXkbLayout_;
+    // Input method that customXkbState is resolved for.
+    std::string xkbIM_;
+    uint64_t xkbEpoch_ = 0;
+    bool xkbStateStale_ = false;
 #endif
 
     std::unique_ptr<EventSourceTime> imInfoTimer_;
     std::string lastInfo_;
 
-    bool active_;
+    // Shared with other input contexts, detached into a copy when the share
+    // policy is changed.
+    std::shared_ptr<SharedInputState> sharedState_;
+    uint64_t shareEpoch_ = 0;
 };
 
 class CheckInputMethodChanged {
@@ -117,6 +158,11 @@ struct InstanceArgument {
     bool quietQuit = false;
     bool runAsDaemon = false;
     bool exitWhenMainDisplayDisconnected = true;
+    bool printStartupTimeline = false;
+    bool benchmarkStartup = false;
+    // Requested by --log, started after daemonizing.
+    std::optional<LogSink> logSink;
+    std::string logPath;
     std::string uiName;
     std::vector<std::string> enableList;
     std::vector<std::string> disableList;
@@ -124,6 +170,69 @@ struct InstanceArgument {
     std::string argv0;
 };
 
+struct EventDispatchEntry {
+    EventWatcherPhase phase;
+    HandlerPoolHandle handler;
+};
+
+// All handlers of a single event type, with phases already merged in the
+// order of dispatch.
+using EventDispatchList = std::vector<EventDispatchEntry>;
+
+// Log2 bucketed latency histogram, values are in microseconds. Counts are
+// halved when there are too many samples so percentiles follow recent
+// behavior.
+class LatencyHistogram {
+public:
+    void add(uint64_t usec);
+    uint64_t count() const { return count_; }
+    uint64_t percentile(uint32_t percent) const;
+
+private:
+    static constexpr uint32_t maxSamples = 8192;
+    std::array<uint32_t, 32> buckets_{};
+    uint32_t count_ = 0;
+};
+
+// Fixed size record of a dispatched key event.
+struct KeyEventRecord {
+    // CLOCK_MONOTONIC in microseconds, when dispatch starts.
+    uint64_t timestamp = 0;
+    uint32_t duration = 0;
+    uint32_t sym = 0;
+    uint32_t states = 0;
+    // Index of interned name in KeyEventRecorder, 0 means empty.
+    uint16_t frontend = 0;
+    uint16_t inputMethod = 0;
+    // EventWatcherPhase of the handler that filtered the event.
+    uint8_t phase = 0;
+    uint8_t flags = 0;
+    ICUUID ic{};
+};
+
+// Always-on ring buffer of the most recent key events, so a latency spike can
+// be inspected after it happens.
+class KeyEventRecorder {
+public:
+    enum : uint8_t { Release = 1, Filtered = 1 << 1, Accepted = 1 << 2 };
+    static constexpr size_t capacity = 256;
+
+    void record(const KeyEvent &event, uint64_t start, uint64_t end,
+                const EventDispatchEntry *filteredBy,
+                const InputMethodEntry *entry);
+    std::string dump(uint64_t currentTime) const;
+
+private:
+    uint16_t intern(std::string_view name, uint16_t &hint);
+
+    std::array<KeyEventRecord, capacity> records_{};
+    uint64_t total_ = 0;
+    std::vector<std::string> names_{std::string()};
+    std::unordered_map<std::string, uint16_t> nameIndex_;
+    uint16_t lastFrontend_ = 0;
+    uint16_t lastInputMethod_ = 0;
+};
+
 class InstancePrivate : public QPtrHolder<Instance> {
 public:
     InstancePrivate(Instance *q);
@@ -131,6 +240,11 @@ public:
     std::unique_ptr<HandlerTableEntry<EventHandler>>
     watchEvent(EventType type, EventWatcherPhase phase, EventHandler callback);
 
+    // Return the compiled dispatch list for type, rebuild it if necessary.
+    std::shared_ptr<const EventDispatchList>
+    eventDispatchList(EventType type) const;
+    void invalidateEventDispatchList(EventType type) const;
+
 #ifdef ENABLE_KEYBOARD
     xkb_keymap *keymap(const std::string &display, const std::string &layout,
                        const std::string &variant);
@@ -140,6 +254,12 @@ public:
     overrideAddons();
 
     void buildDefaultGroup();
+    void preloadInputMethods();
+    // Prewarm the neighbours of the current input method when idle.
+    void schedulePrewarm(InputContext *ic);
+    void prewarmInputMethods();
+    // Stop recording the startup timeline, and print it if requested.
+    void finishStartupTimeline();
 
     void showInputMethodInformation(InputContext *ic);
 
@@ -151,6 +271,24 @@ public:
 
     void acceptGroupChange(const Key &key, InputContext *ic);
 
+    // Return the entry that filtered the event, or nullptr.
+    const EventDispatchEntry *dispatchTraced(const EventDispatchList &handlers,
+                                             Event &event,
+                                             bool &hasRemovedHandler);
+
+    // Collect the triggers of on demand addons that are not loaded yet.
+    void buildAddonTriggers();
+    // Load the on demand addons triggered by the key or the input method of
+    // the event. Need to be called before the dispatch list is taken, so the
+    // loaded addons receive the event as well.
+    void triggerAddons(const Event &event);
+    void loadTriggeredAddon(const std::string &name);
+
+    void flushUI();
+    // Flush or, if the last flush is within UIUpdateInterval, delay the
+    // flush till the end of the interval.
+    void flushUICoalesced();
+
     InstanceArgument arg_;
 
     int signalPipe_ = -1;
@@ -163,26 +301,77 @@ public:
 
     EventLoop eventLoop_;
     EventDispatcher eventDispatcher_;
+    // Created on first use, continuations are sent with eventDispatcher_.
+    std::unique_ptr<WorkerPool> workerPool_;
     std::unique_ptr<EventSourceIO> signalPipeEvent_;
     std::unique_ptr<EventSourceTime> preloadInputMethodEvent_;
+    std::unique_ptr<EventSourceTime> prewarmAddonEvent_;
+    std::vector<std::pair<std::string, KeyList>> addonKeyTriggers_;
+    std::unordered_map<std::string, std::vector<std::string>>
+        addonInputMethodTriggers_;
+    std::vector<std::string> prewarmAddons_;
+    std::unique_ptr<EventSourceTime> prewarmInputMethodEvent_;
+    std::string prewarmFrom_;
     std::unique_ptr<EventSourceTime> zombieReaper_;
     std::unique_ptr<EventSource> exitEvent_;
+    // Shared input states by the share key, the key is empty for
+    // ShareInputState::All. Declared before icManager_, input states may
+    // still refer to it when they are destroyed.
+    std::unordered_map<std::string, std::weak_ptr<SharedInputState>>
+        sharedInputStates_;
+    // Bumped when ShareInputState is changed.
+    uint64_t shareInputStateEpoch_ = 1;
     InputContextManager icManager_;
     AddonManager addonManager_;
     InputMethodManager imManager_{&this->addonManager_};
     UserInterfaceManager uiManager_{&this->addonManager_};
     GlobalConfig globalConfig_;
-    std::unordered_map<EventType,
-                       std::unordered_map<EventWatcherPhase,
-                                          HandlerTable<EventHandler>, EnumHash>,
-                       EnumHash>
+    // Handlers of all event types share the pool, so dispatching an event
+    // walks a few contiguous chunks.
+    std::shared_ptr<HandlerPool<EventHandler>> eventHandlerPool_ =
+        std::make_shared<HandlerPool<EventHandler>>();
+    std::unordered_map<
+        EventType,
+        std::unordered_map<EventWatcherPhase, PooledHandlerTable<EventHandler>,
+                           EnumHash>,
+        EnumHash>
         eventHandlers_;
+    // Built-in event types are addressed directly, user defined types fall
+    // back to the hash map. A null entry means the list needs to be rebuilt.
+    static constexpr size_t eventDispatchCategorySize = 0x20;
+    mutable std::array<std::shared_ptr<const EventDispatchList>,
+                       3 * eventDispatchCategorySize>
+        eventDispatchSlots_;
+    mutable std::unordered_map<EventType,
+                               std::shared_ptr<const EventDispatchList>,
+                               EnumHash>
+        eventDispatchFallback_;
     std::vector<std::unique_ptr<HandlerTableEntry<EventHandler>>>
         eventWatchers_;
+
+    bool eventTracing_ = false;
+    LatencyHistogram totalLatency_;
+    std::unordered_map<EventWatcherPhase, LatencyHistogram, EnumHash>
+        phaseLatency_;
+    std::unordered_map<std::string, LatencyHistogram> addonLatency_;
+    KeyEventRecorder keyEventRecorder_;
+    std::unique_ptr<KeyTraceWriter> keyTrace_;
     std::unique_ptr<EventSource> uiUpdateEvent_;
+    std::unique_ptr<EventSourceTime> uiFlushTimer_;
+    uint64_t lastUIFlush_ = 0;
+    // Bumped when input method group is changed, to invalidate the entry
+    // cached in InputState.
+    uint64_t inputMethodEpoch_ = 1;
+    // Text is committed since last flush, the ui need to catch up with it.
+    bool uiFlushUrgent_ = false;
 
     uint64_t idleStartTimestamp_ = now(CLOCK_MONOTONIC);
     std::unique_ptr<EventSourceTime> periodicalSave_;
+    std::unique_ptr<EventSourceTime> idleTrimEvent_;
+    uint64_t lastIdleTrimTimestamp_ = 0;
+    UnixFD memoryPressureFD_;
+    std::unique_ptr<EventSourceIO> memoryPressureEvent_;
+    uint64_t lastPressureTrimTimestamp_ = 0;
 
     FCITX_DEFINE_SIGNAL_PRIVATE(Instance, CommitFilter);
     FCITX_DEFINE_SIGNAL_PRIVATE(Instance, OutputFilter);
@@ -194,7 +383,7 @@ public:
 
 #ifdef ENABLE_KEYBOARD
     UniqueCPtr<xkb_context, xkb_context_unref> xkbContext_;
-    UniqueCPtr<xkb_compose_table, xkb_compose_table_unref> xkbComposeTable_;
+    std::unique_ptr<ComposeTable> composeTable_;
 #endif
 
     std::vector<ScopedConnection> connections_;
@@ -202,10 +391,7 @@ public:
     std::unique_ptr<EventSourceTime> focusInImInfoTimer_;
 
 #ifdef ENABLE_KEYBOARD
-    std::unordered_map<
-        std::string, std::unordered_map<
-                         std::string, UniqueCPtr<xkb_keymap, xkb_keymap_unref>>>
-        keymapCache_;
+    KeymapCache keymapCache_;
 #endif
     std::unordered_map<std::string, std::tuple<uint32_t, uint32_t, uint32_t>>
         stateMask_;
@@ -228,7 +414,8 @@ public:
 
     bool binaryMode_ = false;
 
-    std::string lastUnFocusedProgram_;
+    // Interned program name of the last unfocused input context.
+    const std::string *lastUnFocusedProgram_ = nullptr;
     TrackableObjectReference<InputContext> lastUnFocusedIc_;
 };
 
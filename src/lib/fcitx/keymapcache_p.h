@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_KEYMAPCACHE_P_H_
+#define _FCITX_KEYMAPCACHE_P_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <xkbcommon/xkbcommon.h>
+#include "fcitx-utils/misc.h"
+#include "misc_p.h"
+
+namespace fcitx {
+
+/**
+ * A cache of compiled xkb keymaps, shared by everything in the process that
+ * needs a keymap.
+ *
+ * Keymaps are looked up by their content, either the keymap text or the
+ * RMLVO names, so the same keymap received from different seats or virtual
+ * keyboards is only compiled once. The least recently used keymap is dropped
+ * when the cache is full; the users that still hold a reference to it are
+ * not affected.
+ */
+class KeymapCache {
+public:
+    static constexpr size_t maxSize = 16;
+
+    // The keymap is owned by the cache, and only valid until the next lookup.
+    xkb_keymap *fromString(std::string_view keymap) {
+        // Keymap sent by compositor is usually null terminated.
+        while (!keymap.empty() && keymap.back() == '\0') {
+            keymap.remove_suffix(1);
+        }
+        if (keymap.empty()) {
+            return nullptr;
+        }
+        return lookup(std::string(keymap), [this](const std::string &key) {
+            return xkb_keymap_new_from_string(context(), key.c_str(),
+                                              XKB_KEYMAP_FORMAT_TEXT_V1,
+                                              XKB_KEYMAP_COMPILE_NO_FLAGS);
+        });
+    }
+
+    xkb_keymap *fromNames(const char *rules, const char *model,
+                          const char *layout, const char *variant,
+                          const char *options) {
+        // Keymap text never starts with \0, so names can not clash with it.
+        std::string key(1, '\0');
+        for (const auto *value : {rules, model, layout, variant, options}) {
+            key.append(value ? value : "");
+            key.push_back('\0');
+        }
+        return lookup(std::move(key), [=](const std::string &) {
+            struct xkb_rule_names names;
+            names.rules = rules;
+            names.model = model;
+            names.layout = layout;
+            names.variant = variant;
+            names.options = options;
+            return xkb_keymap_new_from_names(context(), &names,
+                                             XKB_KEYMAP_COMPILE_NO_FLAGS);
+        });
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    // Approximate memory used by the cached keymaps in bytes, which is the
+    // growth of RSS during compilation and the size of the key.
+    size_t memoryUsage() const {
+        size_t total = 0;
+        for (const auto &entry : entries_) {
+            total += entry.memory;
+        }
+        return total;
+    }
+
+    void clear() {
+        index_.clear();
+        entries_.clear();
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap;
+        size_t memory = 0;
+    };
+    using EntryList = std::list<Entry>;
+
+    xkb_context *context() {
+        if (!context_) {
+            context_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+            if (context_) {
+                xkb_context_set_log_level(context_.get(),
+                                          XKB_LOG_LEVEL_CRITICAL);
+            }
+        }
+        return context_.get();
+    }
+
+    template <typename Compile>
+    xkb_keymap *lookup(std::string key, Compile compile) {
+        if (auto iter = index_.find(key); iter != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            return iter->second->keymap.get();
+        }
+        if (!context()) {
+            return nullptr;
+        }
+        const auto rss = residentSetSize();
+        UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap(compile(key));
+        if (!keymap) {
+            return nullptr;
+        }
+        const auto memory =
+            std::max<int64_t>(residentSetSize() - rss, 0) + key.size();
+        if (entries_.size() >= maxSize) {
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+        }
+        entries_.push_front(Entry{std::move(key), std::move(keymap), memory});
+        index_.emplace(entries_.front().key, entries_.begin());
+        return entries_.front().keymap.get();
+    }
+
+    UniqueCPtr<xkb_context, xkb_context_unref> context_;
+    EntryList entries_;
+    // Keys point to the strings in entries_.
+    std::unordered_map<std::string_view, EntryList::iterator> index_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_KEYMAPCACHE_P_H_
@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_KEYTRACE_P_H_
+#define _FCITX_KEYTRACE_P_H_
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcitx-utils/fs.h>
+#include <fcitx-utils/key.h>
+#include <fcitx-utils/unixfd.h>
+#include "event.h"
+#include "inputcontext.h"
+
+namespace fcitx {
+
+/**
+ * Binary trace of key events, to replay production input offline.
+ *
+ * The file starts with the magic, followed by a list of entries, in native
+ * byte order. Each entry starts with a type byte:
+ *  - Name: u16 index, u16 length and the bytes, defines a program or frontend
+ *    name that later keys refer to.
+ *  - Key: u32 microseconds since the previous key, u32 sym, u32 states, u16
+ *    input context, u16 program, u16 frontend and u8 flags.
+ *
+ * Input contexts are numbered in the order they are seen, so nothing but the
+ * key itself, the program and the frontend is kept.
+ */
+class KeyTraceWriter {
+public:
+    explicit KeyTraceWriter(UnixFD fd) : fd_(std::move(fd)) {
+        if (fd_.isValid()) {
+            buffer_.append(magic);
+        }
+    }
+
+    ~KeyTraceWriter() { flush(); }
+
+    bool isValid() const { return fd_.isValid(); }
+
+    void write(const KeyEvent &event, uint64_t timestamp) {
+        auto *ic = event.inputContext();
+        if (!fd_.isValid() || !ic) {
+            return;
+        }
+        auto [iter, inserted] = inputContexts_.emplace(
+            ic->uuid(), static_cast<uint16_t>(inputContexts_.size()));
+        const auto program = intern(ic->program());
+        const auto frontend = intern(ic->frontendName());
+        buffer_.push_back(static_cast<char>(EntryType::Key));
+        append(static_cast<uint32_t>(
+            lastTimestamp_ && timestamp > lastTimestamp_
+                ? timestamp - lastTimestamp_
+                : 0));
+        append(static_cast<uint32_t>(event.rawKey().sym()));
+        append(static_cast<uint32_t>(event.rawKey().states()));
+        append(iter->second);
+        append(program);
+        append(frontend);
+        buffer_.push_back(static_cast<char>(event.isRelease() ? Release : 0));
+        lastTimestamp_ = timestamp;
+        // Keep the write off most of the key events.
+        if (buffer_.size() >= flushSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (!fd_.isValid() || buffer_.empty()) {
+            return;
+        }
+        if (fs::safeWrite(fd_.fd(), buffer_.data(), buffer_.size()) !=
+            static_cast<ssize_t>(buffer_.size())) {
+            fd_.reset();
+        }
+        buffer_.clear();
+    }
+
+    static constexpr std::string_view magic{"FCITXKEYTRACE1", 15};
+    enum class EntryType : uint8_t { Name = 0, Key = 1 };
+    enum : uint8_t { Release = 1 };
+
+private:
+    static constexpr size_t flushSize = 4096;
+
+    template <typename T>
+    void append(T value) {
+        buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    uint16_t intern(std::string_view name) {
+        if (auto iter = names_.find(std::string(name)); iter != names_.end()) {
+            return iter->second;
+        }
+        const auto index = static_cast<uint16_t>(names_.size());
+        names_.emplace(name, index);
+        const auto length =
+            static_cast<uint16_t>(std::min<size_t>(name.size(), UINT16_MAX));
+        buffer_.push_back(static_cast<char>(EntryType::Name));
+        append(index);
+        append(length);
+        buffer_.append(name.substr(0, length));
+        return index;
+    }
+
+    UnixFD fd_;
+    std::string buffer_;
+    uint64_t lastTimestamp_ = 0;
+    std::map<ICUUID, uint16_t> inputContexts_;
+    std::unordered_map<std::string, uint16_t> names_;
+};
+
+struct KeyTraceEvent {
+    uint32_t delay = 0;
+    Key key;
+    bool isRelease = false;
+    uint16_t inputContext = 0;
+    std::string_view program;
+    std::string_view frontend;
+};
+
+// Read a trace written by KeyTraceWriter, views point into data.
+class KeyTraceReader {
+public:
+    explicit KeyTraceReader(std::string_view data)
+        : cur_(data.data()), end_(data.data() + data.size()) {
+        valid_ = data.substr(0, KeyTraceWriter::magic.size()) ==
+                 KeyTraceWriter::magic;
+        if (valid_) {
+            cur_ += KeyTraceWriter::magic.size();
+        }
+    }
+
+    bool isValid() const { return valid_; }
+
+    // Return false at the end of trace, or if the trace is corrupted.
+    bool next(KeyTraceEvent &event) {
+        while (valid_ && cur_ != end_) {
+            const auto type = static_cast<KeyTraceWriter::EntryType>(*cur_++);
+            if (type == KeyTraceWriter::EntryType::Name) {
+                uint16_t index;
+                uint16_t length;
+                if (!read(index) || !read(length) ||
+                    static_cast<size_t>(end_ - cur_) < length) {
+                    break;
+                }
+                if (names_.size() <= index) {
+                    names_.resize(index + 1);
+                }
+                names_[index] = std::string_view(cur_, length);
+                cur_ += length;
+                continue;
+            }
+            uint32_t sym;
+            uint32_t states;
+            uint16_t program;
+            uint16_t frontend;
+            uint8_t flags;
+            if (type != KeyTraceWriter::EntryType::Key || !read(event.delay) ||
+                !read(sym) || !read(states) || !read(event.inputContext) ||
+                !read(program) || !read(frontend) || !read(flags) ||
+                program >= names_.size() || frontend >= names_.size()) {
+                break;
+            }
+            event.key = Key(static_cast<KeySym>(sym), KeyStates(states));
+            event.isRelease = flags & KeyTraceWriter::Release;
+            event.program = names_[program];
+            event.frontend = names_[frontend];
+            return true;
+        }
+        valid_ = valid_ && cur_ == end_;
+        return false;
+    }
+
+private:
+    template <typename T>
+    bool read(T &value) {
+        if (static_cast<size_t>(end_ - cur_) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, cur_, sizeof(value));
+        cur_ += sizeof(value);
+        return true;
+    }
+
+    const char *cur_;
+    const char *end_;
+    bool valid_ = false;
+    std::vector<std::string_view> names_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_KEYTRACE_P_H_
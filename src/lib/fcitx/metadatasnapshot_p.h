@@ -0,0 +1,318 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_METADATASNAPSHOT_P_H_
+#define _FCITX_METADATASNAPSHOT_P_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <fcitx-config/rawconfig.h>
+#include <fcitx-utils/fs.h>
+#include <fcitx-utils/mtime_p.h>
+#include <fcitx-utils/standardpath.h>
+#include <fcitx-utils/stringutils.h>
+#include <fcitx-utils/unixfd.h>
+#include "config.h"
+
+namespace fcitx {
+
+/**
+ * A binary snapshot of parsed metadata, stored under $XDG_CACHE_HOME/fcitx5.
+ *
+ * An administrator may also prepare snapshots for all users with
+ * fcitx5-cache-gen, and list the output directory in FCITX_CACHE_DIRS.
+ *
+ * The content is either a RawConfig tree, which can be fed to
+ * Configuration::load directly, or a custom format written with Writer, for
+ * data where building a RawConfig would be slower than parsing the source.
+ *
+ * The snapshot is only used if its validation key matches. The key is built
+ * from the fcitx version, the format version and the modification time and
+ * size of all the files and directories the metadata is read from.
+ */
+class MetadataSnapshot {
+public:
+    // Bump when the layout of snapshot content changes.
+    static constexpr uint32_t formatVersion = 1;
+
+    // The snapshot is read from and saved to the cache directories of
+    // standardPath, which should be the one the metadata is located with.
+    MetadataSnapshot(const std::string &name, const StandardPath &standardPath)
+        : standardPath_(standardPath),
+          path_(stringutils::joinPath("fcitx5", name + ".snapshot")) {
+        addKey(FCITX_VERSION_STRING);
+        addKey(std::to_string(formatVersion));
+    }
+
+    void addKey(std::string_view value) {
+        key_.append(value);
+        key_.push_back('\0');
+    }
+
+    // Add a file or directory that the metadata depends on. Directory mtime
+    // covers added, removed and renamed files.
+    void addDependency(const std::string &path) {
+        struct stat stats;
+        Timespec mtime{0, 0};
+        int64_t size = -1;
+        if (stat(path.c_str(), &stats) == 0) {
+            mtime = modifiedTime(stats);
+            size = stats.st_size;
+        }
+        addKey(path);
+        addKey(std::to_string(mtime.sec));
+        addKey(std::to_string(mtime.nsec));
+        addKey(std::to_string(size));
+    }
+
+    // Add a file or directory that only some users have, e.g. under $HOME.
+    // It is left out of the key if missing, so a shared snapshot still
+    // matches for the users without it.
+    void addOptionalDependency(const std::string &path) {
+        struct stat stats;
+        if (stat(path.c_str(), &stats) == 0) {
+            addDependency(path);
+        }
+    }
+
+    class Reader {
+    public:
+        explicit Reader(std::string_view data)
+            : cur_(data.data()), end_(data.data() + data.size()) {}
+
+        bool read(uint32_t &value) {
+            if (static_cast<size_t>(end_ - cur_) < sizeof(value)) {
+                return false;
+            }
+            memcpy(&value, cur_, sizeof(value));
+            cur_ += sizeof(value);
+            return true;
+        }
+
+        // The returned view points into the mapped file, and is only valid
+        // during the load callback.
+        bool read(std::string_view &value) {
+            uint32_t length;
+            if (!read(length) || static_cast<size_t>(end_ - cur_) < length) {
+                return false;
+            }
+            value = std::string_view(cur_, length);
+            cur_ += length;
+            return true;
+        }
+
+        bool read(std::string &value) {
+            std::string_view view;
+            if (!read(view)) {
+                return false;
+            }
+            value = view;
+            return true;
+        }
+
+        // Read the size of a list, every item takes at least 4 bytes, so a
+        // corrupted size can not cause a huge allocation.
+        bool readSize(uint32_t &value) {
+            return read(value) &&
+                   value <= static_cast<size_t>(end_ - cur_) / sizeof(value);
+        }
+
+        bool atEnd() const { return cur_ == end_; }
+
+        std::string_view remaining() const {
+            return std::string_view(cur_, end_ - cur_);
+        }
+
+    private:
+        const char *cur_;
+        const char *end_;
+    };
+
+    class Writer {
+    public:
+        void write(uint32_t value) {
+            buffer_.append(reinterpret_cast<const char *>(&value),
+                           sizeof(value));
+        }
+
+        void write(std::string_view value) {
+            write(static_cast<uint32_t>(value.size()));
+            buffer_.append(value);
+        }
+
+        const std::string &data() const { return buffer_; }
+
+    private:
+        std::string buffer_;
+    };
+
+    // A mapped snapshot with a matching key. The content can be used in place
+    // as long as the mapping is alive, and the pages are shared with the other
+    // processes that map the same snapshot.
+    class Mapping {
+    public:
+        Mapping() = default;
+        Mapping(Mapping &&other) noexcept { *this = std::move(other); }
+        Mapping &operator=(Mapping &&other) noexcept {
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(content_, other.content_);
+            return *this;
+        }
+        ~Mapping() {
+            if (data_) {
+                munmap(data_, size_);
+            }
+        }
+
+        bool isValid() const { return data_ != nullptr; }
+        // The data after the header.
+        std::string_view content() const { return content_; }
+
+    private:
+        friend class MetadataSnapshot;
+        void *data_ = nullptr;
+        size_t size_ = 0;
+        std::string_view content_;
+    };
+
+    // The user snapshot is preferred, then the read only ones shared by all
+    // users from StandardPath's system cache directories. A shared snapshot
+    // only matches if it is built from the same files, so one that depends on
+    // per-user files is always rebuilt into the user cache.
+    Mapping map() const {
+        auto mapping = map(
+            standardPath_.openUser(StandardPath::Type::Cache, path_, O_RDONLY)
+                .fd());
+        if (mapping.isValid()) {
+            return mapping;
+        }
+        for (const auto &dir :
+             standardPath_.directories(StandardPath::Type::Cache)) {
+            UnixFD file = UnixFD::own(
+                open(stringutils::joinPath(dir, path_).c_str(), O_RDONLY));
+            mapping = map(file.fd());
+            if (mapping.isValid()) {
+                return mapping;
+            }
+        }
+        return mapping;
+    }
+
+    // Callback shall return false if the content is not valid.
+    template <typename Callback>
+    bool load(Callback callback) const {
+        auto mapping = map();
+        if (!mapping.isValid()) {
+            return false;
+        }
+        Reader reader(mapping.content());
+        return callback(reader) && reader.atEnd();
+    }
+
+    template <typename Callback>
+    bool save(Callback callback) const {
+        Writer writer;
+        writer.write(magic_);
+        writer.write(key_);
+        callback(writer);
+        const auto &buffer = writer.data();
+        return standardPath_.safeSave(
+            StandardPath::Type::Cache, path_, [&buffer](int fd) {
+                return fs::safeWrite(fd, buffer.data(), buffer.size()) ==
+                       static_cast<ssize_t>(buffer.size());
+            });
+    }
+
+    bool load(RawConfig &config) const {
+        config.removeAll();
+        if (load([&config](Reader &reader) {
+                return readNode(reader, config, 0);
+            })) {
+            return true;
+        }
+        config.removeAll();
+        config.setValue("");
+        return false;
+    }
+
+    bool save(const RawConfig &config) const {
+        return save([&config](Writer &writer) { writeNode(writer, config); });
+    }
+
+private:
+    Mapping map(int fd) const {
+        Mapping mapping;
+        struct stat stats;
+        if (fd < 0 || fstat(fd, &stats) != 0 || stats.st_size <= 0) {
+            return mapping;
+        }
+        const size_t size = stats.st_size;
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            return mapping;
+        }
+        mapping.data_ = data;
+        mapping.size_ = size;
+        Reader reader(std::string_view(static_cast<const char *>(data), size));
+        std::string_view magic;
+        std::string_view key;
+        if (!reader.read(magic) || magic != magic_ || !reader.read(key) ||
+            key != key_) {
+            return {};
+        }
+        mapping.content_ = reader.remaining();
+        return mapping;
+    }
+
+    static constexpr std::string_view magic_ = "FCITXSNAPSHOT";
+    // RawConfig from ini is at most a few levels deep, anything deeper is a
+    // corrupted file.
+    static constexpr int maxDepth = 32;
+
+    static bool readNode(Reader &reader, RawConfig &config, int depth) {
+        std::string value;
+        uint32_t count;
+        if (depth > maxDepth || !reader.read(value) ||
+            !reader.readSize(count)) {
+            return false;
+        }
+        config.setValue(std::move(value));
+        for (uint32_t i = 0; i < count; i++) {
+            std::string name;
+            if (!reader.read(name) || name.empty() ||
+                !readNode(reader, *config.get(name, true), depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void writeNode(Writer &writer, const RawConfig &config) {
+        writer.write(config.value());
+        writer.write(static_cast<uint32_t>(config.subItemsSize()));
+        config.visitSubItems(
+            [&writer](const RawConfig &subConfig, const std::string &path) {
+                writer.write(path);
+                writeNode(writer, subConfig);
+                return true;
+            });
+    }
+
+    const StandardPath &standardPath_;
+    std::string path_;
+    std::string key_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_METADATASNAPSHOT_P_H_
@@ -7,6 +7,10 @@
 #ifndef _FCITX_MISC_P_H_
 #define _FCITX_MISC_P_H_
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <functional>
@@ -16,6 +20,7 @@
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/unixfd.h"
 #include "fcitx/candidatelist.h"
 #include "fcitx/inputmethodentry.h"
 #include "fcitx/inputmethodmanager.h"
@@ -209,6 +214,16 @@ static inline bool hasTwoKeyboardInCurrentGroup(Instance *instance) {
     return false;
 }
 
+// Surrounding text window wanted by the current input method of ic, 0 if the
+// whole text is wanted.
+static inline unsigned int surroundingTextWindow(Instance *instance,
+                                                 InputContext *ic) {
+    if (const auto *entry = instance->inputMethodEntry(ic)) {
+        return entry->surroundingTextWindow();
+    }
+    return 0;
+}
+
 static inline std::string getCurrentLanguage() {
     for (const char *vars : {"LC_ALL", "LC_MESSAGES", "LANG"}) {
         auto *lang = getenv(vars);
@@ -239,6 +254,26 @@ static inline bool isSingleKey(const Key &key) {
     return isSingleModifier(key) || !key.hasModifier();
 }
 
+// Resident set size of current process in bytes, 0 if not available.
+static inline int64_t residentSetSize() {
+    UnixFD fd = UnixFD::own(open("/proc/self/statm", O_RDONLY | O_CLOEXEC));
+    if (!fd.isValid()) {
+        return 0;
+    }
+    char buf[128];
+    auto n = read(fd.fd(), buf, sizeof(buf) - 1);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    long long size = 0;
+    long long resident = 0;
+    if (sscanf(buf, "%lld %lld", &size, &resident) != 2) {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
 inline void hash_combine(std::size_t &seed, std::size_t value) noexcept {
     seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_STARTUPTIMELINE_P_H_
+#define _FCITX_STARTUPTIMELINE_P_H_
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcitx-utils/event.h>
+
+namespace fcitx {
+
+/**
+ * Records how long each phase of the startup takes.
+ *
+ * There is only one startup per process, so the timeline is global. It is
+ * started when Instance is created and finished once the first input method
+ * is preloaded. Phases are only recorded on the main thread, and may nest.
+ */
+class StartupTimeline {
+public:
+    static StartupTimeline &global() {
+        static StartupTimeline timeline;
+        return timeline;
+    }
+
+    void start() {
+        phases_.clear();
+        depth_ = 0;
+        start_ = now(CLOCK_MONOTONIC);
+        end_ = 0;
+        recording_ = true;
+    }
+
+    void finish() {
+        if (recording_) {
+            recording_ = false;
+            end_ = now(CLOCK_MONOTONIC);
+        }
+    }
+
+    bool recording() const { return recording_; }
+
+    size_t begin(std::string name) {
+        phases_.push_back({std::move(name), now(CLOCK_MONOTONIC), 0, depth_});
+        depth_++;
+        return phases_.size() - 1;
+    }
+
+    void end(size_t index) {
+        // The timeline may be restarted by another Instance in the meantime.
+        if (index >= phases_.size()) {
+            return;
+        }
+        phases_[index].duration = now(CLOCK_MONOTONIC) - phases_[index].start;
+        depth_ = phases_[index].depth;
+    }
+
+    // Used by --benchmark-startup, so the result can be compared by scripts.
+    std::string reportJson(long maxRssKiB) const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        const auto end = recording_ ? now(CLOCK_MONOTONIC) : end_;
+        out << "{\"total_ms\":" << toMsec(end - start_)
+            << ",\"max_rss_kib\":" << maxRssKiB << ",\"phases\":[";
+        for (size_t i = 0; i < phases_.size(); i++) {
+            const auto &phase = phases_[i];
+            if (i) {
+                out << ",";
+            }
+            out << "{\"name\":\"";
+            for (char c : phase.name) {
+                if (c == '"' || c == '\\') {
+                    out << '\\';
+                }
+                out << c;
+            }
+            out << "\",\"start_ms\":" << toMsec(phase.start - start_)
+                << ",\"duration_ms\":" << toMsec(phase.duration)
+                << ",\"depth\":" << phase.depth << "}";
+        }
+        out << "]}";
+        return out.str();
+    }
+
+    std::string report() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        const auto end = recording_ ? now(CLOCK_MONOTONIC) : end_;
+        out << "Startup timeline" << (recording_ ? " (in progress)" : "")
+            << ", total " << toMsec(end - start_) << "ms\n";
+        for (const auto &phase : phases_) {
+            out << std::setw(10) << toMsec(phase.start - start_) << "ms "
+                << std::setw(10) << toMsec(phase.duration) << "ms "
+                << std::string(phase.depth * 2, ' ') << phase.name << "\n";
+        }
+        return out.str();
+    }
+
+private:
+    struct Phase {
+        std::string name;
+        uint64_t start;
+        uint64_t duration;
+        int depth;
+    };
+
+    static double toMsec(uint64_t usec) { return usec / 1000.0; }
+
+    bool recording_ = false;
+    int depth_ = 0;
+    uint64_t start_ = 0;
+    uint64_t end_ = 0;
+    std::vector<Phase> phases_;
+};
+
+/**
+ * Record the lifetime of the object as a phase of the startup timeline.
+ */
+class StartupPhase {
+public:
+    explicit StartupPhase(std::string name) {
+        auto &timeline = StartupTimeline::global();
+        if (timeline.recording()) {
+            index_ = timeline.begin(std::move(name));
+        }
+    }
+
+    ~StartupPhase() {
+        if (index_ != noPhase) {
+            StartupTimeline::global().end(index_);
+        }
+    }
+
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+
+private:
+    static constexpr size_t noPhase = static_cast<size_t>(-1);
+    size_t index_ = noPhase;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_STARTUPTIMELINE_P_H_
@@ -6,6 +6,9 @@
  */
 
 #include "statusarea.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
 #include "action.h"
 #include "inputcontext.h"
 
@@ -17,7 +20,11 @@ public:
     SimpleAction separatorBeforeIM, separatorAfterIM;
     std::unordered_map<Action *, std::vector<ScopedConnection>> actions_;
     InputContext *ic_;
-    void update() const {
+    uint64_t revision_ = 0;
+    mutable std::optional<uint64_t> statesRevision_;
+    mutable std::vector<StatusAreaActionState> states_;
+    void update() {
+        revision_++;
         ic_->updateUserInterface(UserInterfaceComponent::StatusArea);
     }
 };
@@ -75,6 +82,7 @@ void StatusArea::clear() {
     removeAllChild();
     addChild(&d->separatorBeforeIM);
     addChild(&d->separatorAfterIM);
+    d->revision_++;
 }
 
 void StatusArea::clearGroup(StatusGroup group) {
@@ -94,6 +102,36 @@ std::vector<Action *> StatusArea::allActions() const {
     return result;
 }
 
+uint64_t StatusArea::revision() const {
+    FCITX_D();
+    return d->revision_;
+}
+
+const std::vector<StatusAreaActionState> &StatusArea::actionStates() const {
+    FCITX_D();
+    if (d->statesRevision_ == d->revision_) {
+        return d->states_;
+    }
+    d->states_.clear();
+    auto group = StatusGroup::BeforeInputMethod;
+    for (auto *ele : childs()) {
+        if (ele == &d->separatorBeforeIM) {
+            group = StatusGroup::InputMethod;
+            continue;
+        }
+        if (ele == &d->separatorAfterIM) {
+            group = StatusGroup::AfterInputMethod;
+            continue;
+        }
+        auto *action = static_cast<Action *>(ele);
+        d->states_.push_back({action, group, action->shortText(d->ic_),
+                              action->longText(d->ic_), action->icon(d->ic_),
+                              action->isChecked(d->ic_)});
+    }
+    d->statesRevision_ = d->revision_;
+    return d->states_;
+}
+
 std::vector<Action *> StatusArea::actions(StatusGroup group) const {
     FCITX_D();
     std::vector<Action *> result;
@@ -7,7 +7,9 @@
 #ifndef _FCITX_STATUSAREA_H_
 #define _FCITX_STATUSAREA_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <fcitx-utils/element.h>
 #include <fcitx-utils/macros.h>
@@ -35,6 +37,21 @@ enum class StatusGroup {
     AfterInputMethod,
 };
 
+/**
+ * State of an action in status area, resolved for the input context.
+ *
+ * @see StatusArea::actionStates
+ * @since 5.1.12
+ */
+struct StatusAreaActionState {
+    Action *action;
+    StatusGroup group;
+    std::string shortText;
+    std::string longText;
+    std::string icon;
+    bool checked;
+};
+
 /**
  * Status area represent a list of actions and action may have sub actions.
  *
@@ -65,6 +82,27 @@ public:
     /// Get all the associated actions.
     std::vector<Action *> allActions() const;
 
+    /**
+     * Revision of the status area.
+     *
+     * It changes when actions are added or removed, or an action calls
+     * Action::update with the associated input context.
+     *
+     * @since 5.1.12
+     */
+    uint64_t revision() const;
+
+    /**
+     * Get all the associated actions, with their state resolved.
+     *
+     * The state is only computed again when revision() changes, so an action
+     * need to call Action::update after its text, icon or checked state is
+     * changed.
+     *
+     * @since 5.1.12
+     */
+    const std::vector<StatusAreaActionState> &actionStates() const;
+
 private:
     std::unique_ptr<StatusAreaPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(StatusArea);
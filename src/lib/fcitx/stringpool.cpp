@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "stringpool_p.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace fcitx {
+
+const std::string &internString(std::string_view str) {
+    // Leaked on purpose, interned strings may be used by static objects.
+    static auto *pool = new std::unordered_set<std::string>();
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    // Elements of unordered_set are never moved, even on rehash.
+    return *pool->emplace(str).first;
+}
+
+} // namespace fcitx
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_STRINGPOOL_P_H_
+#define _FCITX_STRINGPOOL_P_H_
+
+#include <string>
+#include <string_view>
+
+namespace fcitx {
+
+// Return the copy of str shared by the whole process. Identifiers like input
+// method, addon and program names are repeated all over the place, so keep
+// only one copy of them. Interned strings are never freed, and two of them
+// are equal if and only if they have the same address.
+const std::string &internString(std::string_view str);
+
+} // namespace fcitx
+
+#endif // _FCITX_STRINGPOOL_P_H_
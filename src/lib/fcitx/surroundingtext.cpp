@@ -6,18 +6,90 @@
  */
 
 #include "surroundingtext.h"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "fcitx-utils/macros.h"
 #include "fcitx-utils/utf8.h"
 
 namespace fcitx {
 
+namespace {
+
+bool isContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+} // namespace
+
 class SurroundingTextPrivate {
 public:
     SurroundingTextPrivate() {}
 
+    // Byte offset of character offset, offset must be within the text.
+    size_t byteOffset(size_t offset) const {
+        const auto index = offset / checkpointInterval;
+        if (checkpoints_.empty()) {
+            checkpoints_.push_back(0);
+        }
+        while (checkpoints_.size() <= index) {
+            const auto *last = text_.data() + checkpoints_.back();
+            checkpoints_.push_back(
+                checkpoints_.back() +
+                utf8::ncharByteLength(last, checkpointInterval));
+        }
+        const auto byte = checkpoints_[index];
+        return byte + utf8::ncharByteLength(text_.data() + byte,
+                                            offset % checkpointInterval);
+    }
+
+    // Character offset of byte offset, utf8::INVALID_LENGTH if byte is not at
+    // a character boundary. The text must be valid.
+    size_t charOffset(size_t byte) const {
+        if (byte > text_.size()) {
+            return utf8::INVALID_LENGTH;
+        }
+        if (checkpoints_.empty()) {
+            checkpoints_.push_back(0);
+        }
+        // Only add checkpoints for the characters that exist.
+        while (checkpoints_.back() < byte &&
+               checkpoints_.size() * checkpointInterval <= utf8Length_) {
+            const auto *last = text_.data() + checkpoints_.back();
+            checkpoints_.push_back(
+                checkpoints_.back() +
+                utf8::ncharByteLength(last, checkpointInterval));
+        }
+        auto iter =
+            std::upper_bound(checkpoints_.begin(), checkpoints_.end(), byte);
+        const auto index = std::distance(checkpoints_.begin(), iter) - 1;
+        const auto length = utf8::lengthValidated(
+            text_.begin() + checkpoints_[index], text_.begin() + byte);
+        if (length == utf8::INVALID_LENGTH) {
+            return utf8::INVALID_LENGTH;
+        }
+        return index * checkpointInterval + length;
+    }
+
+    // Drop the checkpoints that may be affected by a change at offset.
+    void invalidateIndexFrom(size_t offset) {
+        checkpoints_.resize(
+            std::min(checkpoints_.size(), offset / checkpointInterval + 1));
+    }
+
+    void resetIndex() { checkpoints_.clear(); }
+
+    static constexpr size_t checkpointInterval = 64;
+
     unsigned int anchor_ = 0, cursor_ = 0;
     std::string text_;
     size_t utf8Length_ = 0;
+    // checkpoints_[i] is the byte offset of character i * checkpointInterval,
+    // it is extended on demand.
+    mutable std::vector<size_t> checkpoints_;
 
     bool valid_ = false;
 };
@@ -39,6 +111,7 @@ void SurroundingText::invalidate() {
     d->cursor_ = 0;
     d->text_ = std::string();
     d->utf8Length_ = 0;
+    d->resetIndex();
 }
 
 const std::string &SurroundingText::text() const {
@@ -65,14 +138,19 @@ std::string SurroundingText::selectedText() const {
         return {};
     }
 
-    auto startIter = utf8::nextNChar(d->text_.begin(), start);
-    auto endIter = utf8::nextNChar(startIter, len);
-    return std::string(startIter, endIter);
+    auto startByte = d->byteOffset(start);
+    auto endByte = d->byteOffset(end);
+    return d->text_.substr(startByte, endByte - startByte);
 }
 
 void SurroundingText::setText(const std::string &text, unsigned int cursor,
                               unsigned int anchor) {
     FCITX_D();
+    // Clients usually send the same text again when only cursor is moved.
+    if (d->valid_ && d->text_ == text) {
+        setCursor(cursor, anchor);
+        return;
+    }
     auto length = utf8::lengthValidated(text);
     if (length == utf8::INVALID_LENGTH || length < cursor || length < anchor) {
         invalidate();
@@ -84,6 +162,56 @@ void SurroundingText::setText(const std::string &text, unsigned int cursor,
     d->cursor_ = cursor;
     d->anchor_ = anchor;
     d->utf8Length_ = length;
+    d->resetIndex();
+}
+
+unsigned int SurroundingText::setTextInWindow(std::string_view text,
+                                              unsigned int cursor,
+                                              unsigned int anchor,
+                                              unsigned int window) {
+    FCITX_D();
+    if (window == 0) {
+        if (d->valid_ && d->text_ == text) {
+            setCursor(cursor, anchor);
+        } else {
+            setText(std::string(text), cursor, anchor);
+        }
+        return 0;
+    }
+    const auto selectionStart = std::min(cursor, anchor);
+    const auto selectionEnd = std::max(cursor, anchor);
+    const auto start = selectionStart > window ? selectionStart - window : 0;
+    const auto end = selectionEnd > UINT_MAX - window ? UINT_MAX
+                                                      : selectionEnd + window;
+    // Only count the lead bytes, the window itself is validated by setText.
+    size_t startByte = start == 0 ? 0 : text.size();
+    size_t endByte = text.size();
+    unsigned int chars = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (isContinuationByte(text[i])) {
+            continue;
+        }
+        if (chars == start) {
+            startByte = i;
+        }
+        if (chars == end) {
+            endByte = i;
+            break;
+        }
+        chars++;
+    }
+    if (chars < selectionEnd) {
+        invalidate();
+        return 0;
+    }
+
+    const auto windowText = text.substr(startByte, endByte - startByte);
+    if (d->valid_ && d->text_ == windowText) {
+        setCursor(cursor - start, anchor - start);
+    } else {
+        setText(std::string(windowText), cursor - start, anchor - start);
+    }
+    return start;
 }
 
 void SurroundingText::setCursor(unsigned int cursor, unsigned int anchor) {
@@ -110,24 +238,120 @@ void SurroundingText::deleteText(int offset, unsigned int size) {
      * Make their life easier.
      */
     int cursor_pos = d->cursor_ + offset;
-    size_t len = utf8::length(d->text_);
+    size_t len = d->utf8Length_;
     if (cursor_pos >= 0 && len >= size + cursor_pos) {
-        auto start = utf8::nextNChar(d->text_.begin(), cursor_pos);
-        auto end = utf8::nextNChar(start, size);
-        d->text_.erase(start, end);
+        // Removing whole characters keeps the text valid.
+        auto start = d->byteOffset(cursor_pos);
+        auto end = d->byteOffset(cursor_pos + size);
+        d->text_.erase(start, end - start);
         d->cursor_ = cursor_pos;
-        d->utf8Length_ = utf8::lengthValidated(d->text_);
-        if (d->utf8Length_ == utf8::INVALID_LENGTH) {
-            invalidate();
-        }
+        d->utf8Length_ = len - size;
+        d->invalidateIndexFrom(cursor_pos);
     } else {
         d->text_.clear();
         d->cursor_ = 0;
         d->utf8Length_ = 0;
+        d->resetIndex();
     }
     d->anchor_ = d->cursor_;
 }
 
+bool SurroundingText::replace(unsigned int start, unsigned int end,
+                              std::string_view text) {
+    FCITX_D();
+    if (!d->valid_ || start > end || end > d->utf8Length_) {
+        return false;
+    }
+    // The text is counted up to the first '\0', reject anything after it.
+    if (text.find('\0') != std::string_view::npos) {
+        return false;
+    }
+    auto length = text.empty() ? 0 : utf8::lengthValidated(text);
+    if (length == utf8::INVALID_LENGTH) {
+        return false;
+    }
+
+    auto startByte = d->byteOffset(start);
+    auto endByte = d->byteOffset(end);
+    d->text_.replace(startByte, endByte - startByte, text);
+    d->utf8Length_ = d->utf8Length_ - (end - start) + length;
+    d->invalidateIndexFrom(start);
+
+    auto adjust = [start, end, length](unsigned int offset) -> unsigned int {
+        if (offset >= end) {
+            return offset - (end - start) + length;
+        }
+        if (offset > start) {
+            return start + length;
+        }
+        return offset;
+    };
+    d->cursor_ = adjust(d->cursor_);
+    d->anchor_ = adjust(d->anchor_);
+    return true;
+}
+
+void SurroundingText::setTextWithByteOffset(std::string_view text,
+                                            size_t cursor, size_t anchor) {
+    FCITX_D();
+    if (cursor > text.size() || anchor > text.size()) {
+        invalidate();
+        return;
+    }
+    if (!d->valid_) {
+        setText(std::string(text), 0, 0);
+    } else if (d->text_ != text) {
+        // Only replace the part between the common prefix and suffix, both
+        // need to end at a character boundary.
+        const std::string_view oldText = d->text_;
+        size_t prefix = std::mismatch(oldText.begin(), oldText.end(),
+                                      text.begin(), text.end())
+                            .first -
+                        oldText.begin();
+        while (prefix > 0 && prefix < oldText.size() &&
+               isContinuationByte(oldText[prefix])) {
+            prefix--;
+        }
+        size_t suffix = 0;
+        const size_t maxSuffix =
+            std::min(oldText.size(), text.size()) - prefix;
+        while (suffix < maxSuffix && oldText[oldText.size() - suffix - 1] ==
+                                         text[text.size() - suffix - 1]) {
+            suffix++;
+        }
+        while (suffix > 0 &&
+               isContinuationByte(oldText[oldText.size() - suffix])) {
+            suffix--;
+        }
+        const auto start = d->charOffset(prefix);
+        const auto end = d->charOffset(oldText.size() - suffix);
+        if (!replace(start, end,
+                     text.substr(prefix, text.size() - suffix - prefix))) {
+            invalidate();
+            return;
+        }
+    }
+    if (!d->valid_) {
+        return;
+    }
+    const auto cursorByChar = d->charOffset(cursor);
+    const auto anchorByChar = d->charOffset(anchor);
+    if (cursorByChar == utf8::INVALID_LENGTH ||
+        anchorByChar == utf8::INVALID_LENGTH) {
+        invalidate();
+        return;
+    }
+    setCursor(cursorByChar, anchorByChar);
+}
+
+size_t SurroundingText::byteOffset(unsigned int offset) const {
+    FCITX_D();
+    if (!d->valid_ || offset > d->utf8Length_) {
+        return std::string::npos;
+    }
+    return d->byteOffset(offset);
+}
+
 LogMessageBuilder &operator<<(LogMessageBuilder &log,
                               const SurroundingText &surroundingText) {
     log << "SurroundingText(text=";
@@ -7,8 +7,10 @@
 #ifndef _FCITX_SURROUNDINGTEXT_H_
 #define _FCITX_SURROUNDINGTEXT_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <fcitx-utils/log.h>
 #include <fcitx-utils/macros.h>
 #include "fcitxcore_export.h"
@@ -64,6 +66,47 @@ public:
      */
     void setCursor(unsigned int cursor, unsigned int anchor);
 
+    /**
+     * Set current surrounding text with cursor and anchor in bytes.
+     *
+     * This is meant for the clients that send the full text on every change
+     * with byte offsets. If the text is the same, only cursor and anchor are
+     * converted. Otherwise only the range that differs from the current text
+     * is validated and replaced.
+     *
+     * If the text is not valid UTF-8, or cursor and anchor are out of range
+     * or not at character boundary, it will be reset to invalid state.
+     *
+     * @param text text
+     * @param cursor offset of cursor in bytes.
+     * @param anchor offset of anchor in bytes.
+     * @since 5.1.12
+     */
+    void setTextWithByteOffset(std::string_view text, size_t cursor,
+                               size_t anchor);
+
+    /**
+     * Set current surrounding text to a window around cursor and anchor.
+     *
+     * Only up to window characters before and after the selection are kept.
+     * The characters skipped at the beginning are counted but not validated,
+     * so a large text does not need to be copied or validated as a whole.
+     * Cursor and anchor of the surrounding text are relative to the window.
+     *
+     * If the window is not valid UTF-8, or cursor and anchor are out of range,
+     * it will be reset to invalid state.
+     *
+     * @param text text
+     * @param cursor offset of cursor in character.
+     * @param anchor offset of anchor in character.
+     * @param window number of characters to keep around the selection, 0 to
+     * keep the whole text.
+     * @return offset of the window in text, in character.
+     * @since 5.1.12
+     */
+    unsigned int setTextInWindow(std::string_view text, unsigned int cursor,
+                                 unsigned int anchor, unsigned int window);
+
     /**
      * Delete surrounding text with offset and size.
      *
@@ -74,6 +117,38 @@ public:
      */
     void deleteText(int offset, unsigned int size);
 
+    /**
+     * Replace the characters in [start, end) with text.
+     *
+     * Cursor and anchor after the replaced range are moved along with the
+     * text after it, those inside the range are moved to the end of the new
+     * text. Nothing is changed if the surrounding text is invalid, the range
+     * is out of bound, or text is not valid UTF-8.
+     *
+     * Unlike setText, this only needs to look at the changed part of the text,
+     * which is useful to keep a large surrounding text up to date.
+     *
+     * @param start offset of the first character to replace.
+     * @param end offset after the last character to replace.
+     * @param text new text.
+     * @return whether the text is replaced.
+     * @since 5.1.12
+     */
+    bool replace(unsigned int start, unsigned int end, std::string_view text);
+
+    /**
+     * Convert a character offset in the text to byte offset.
+     *
+     * The conversion is backed by an index of the text, so it does not need
+     * to scan the text from the beginning every time.
+     *
+     * @param offset offset in character.
+     * @return byte offset, or std::string::npos if offset is out of bound or
+     * the surrounding text is invalid.
+     * @since 5.1.12
+     */
+    size_t byteOffset(unsigned int offset) const;
+
 private:
     std::unique_ptr<SurroundingTextPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(SurroundingText);
@@ -6,7 +6,6 @@
  */
 
 #include "text.h"
-#include <iterator>
 #include <stdexcept>
 #include <tuple>
 #include <vector>
@@ -15,77 +14,190 @@
 
 namespace fcitx {
 
+namespace {
+
+// Fragments of a text. Most of text only has a single fragment, which is kept
+// inline. The vector is only used for the following ones.
+class TextFragments {
+public:
+    using value_type = std::tuple<std::string, TextFormatFlags>;
+
+    template <typename Container, typename Value>
+    class Iterator {
+    public:
+        Iterator(Container *container, size_t index)
+            : container_(container), index_(index) {}
+
+        Value &operator*() const { return (*container_)[index_]; }
+        Iterator &operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator!=(const Iterator &other) const {
+            return index_ != other.index_;
+        }
+
+    private:
+        Container *container_;
+        size_t index_;
+    };
+
+    size_t size() const { return hasFirst_ ? rest_.size() + 1 : 0; }
+    bool empty() const { return !hasFirst_; }
+
+    value_type &operator[](size_t idx) {
+        return idx == 0 ? first_ : rest_[idx - 1];
+    }
+    const value_type &operator[](size_t idx) const {
+        return idx == 0 ? first_ : rest_[idx - 1];
+    }
+
+    auto begin() { return Iterator<TextFragments, value_type>(this, 0); }
+    auto end() { return Iterator<TextFragments, value_type>(this, size()); }
+    auto begin() const {
+        return Iterator<const TextFragments, const value_type>(this, 0);
+    }
+    auto end() const {
+        return Iterator<const TextFragments, const value_type>(this, size());
+    }
+
+    void emplace_back(std::string str, TextFormatFlags flag) {
+        if (!hasFirst_) {
+            first_ = {std::move(str), flag};
+            hasFirst_ = true;
+        } else {
+            rest_.emplace_back(std::move(str), flag);
+        }
+    }
+
+    void clear() {
+        std::get<std::string>(first_).clear();
+        hasFirst_ = false;
+        rest_.clear();
+    }
+
+private:
+    value_type first_;
+    bool hasFirst_ = false;
+    std::vector<value_type> rest_;
+};
+
+} // namespace
+
 class TextPrivate {
 public:
     TextPrivate() = default;
     FCITX_INLINE_DEFINE_DEFAULT_DTOR_AND_COPY(TextPrivate)
 
-    std::vector<std::tuple<std::string, TextFormatFlags>> texts_;
+    TextFragments texts_;
     int cursor_ = -1;
 };
 
-Text::Text() : d_ptr(std::make_unique<TextPrivate>()) {}
+// Empty text is common, e.g. comment and custom label of candidates, so
+// TextPrivate is only created when the text is modified.
+Text::Text() = default;
 
 Text::Text(std::string text, TextFormatFlags flag) : Text() {
     append(std::move(text), flag);
 }
 
-FCITX_DEFINE_DPTR_COPY_AND_DEFAULT_DTOR_AND_MOVE(Text)
+Text::Text(const Text &other)
+    : d_ptr(other.d_ptr ? std::make_unique<TextPrivate>(*other.d_ptr)
+                        : nullptr) {}
+
+Text &Text::operator=(const Text &other) {
+    if (!other.d_ptr) {
+        d_ptr.reset();
+    } else if (d_ptr) {
+        *d_ptr = *other.d_ptr;
+    } else {
+        d_ptr = std::make_unique<TextPrivate>(*other.d_ptr);
+    }
+    return *this;
+}
+
+FCITX_DEFINE_DEFAULT_DTOR_AND_MOVE(Text)
 
 void Text::clear() {
     FCITX_D();
-    d->texts_.clear();
-    setCursor();
+    if (d) {
+        d->texts_.clear();
+        d->cursor_ = -1;
+    }
 }
 
 int Text::cursor() const {
     FCITX_D();
-    return d->cursor_;
+    return d ? d->cursor_ : -1;
 }
 
 void Text::setCursor(int pos) {
+    if (!d_ptr) {
+        if (pos == -1) {
+            return;
+        }
+        d_ptr = std::make_unique<TextPrivate>();
+    }
     FCITX_D();
     d->cursor_ = pos;
 }
 
 void Text::append(std::string str, TextFormatFlags flag) {
-    FCITX_D();
     if (!utf8::validate(str)) {
         throw std::invalid_argument("Invalid utf8 string");
     }
+    if (!d_ptr) {
+        d_ptr = std::make_unique<TextPrivate>();
+    }
+    FCITX_D();
     d->texts_.emplace_back(std::move(str), flag);
 }
 
 void Text::append(Text text) {
+    if (!text.d_ptr || text.d_ptr->texts_.empty()) {
+        return;
+    }
+    if (!d_ptr) {
+        d_ptr = std::make_unique<TextPrivate>();
+    }
     FCITX_D();
-    std::copy(std::make_move_iterator(text.d_ptr->texts_.begin()),
-              std::make_move_iterator(text.d_ptr->texts_.end()),
-              std::back_inserter(d->texts_));
+    for (auto &[str, format] : text.d_ptr->texts_) {
+        d->texts_.emplace_back(std::move(str), format);
+    }
 }
 
 const std::string &Text::stringAt(int idx) const {
     FCITX_D();
+    if (!d) {
+        throw std::out_of_range("Text: invalid index");
+    }
     return std::get<std::string>(d->texts_[idx]);
 }
 
 TextFormatFlags Text::formatAt(int idx) const {
     FCITX_D();
+    if (!d) {
+        throw std::out_of_range("Text: invalid index");
+    }
     return std::get<TextFormatFlags>(d->texts_[idx]);
 }
 
 size_t Text::size() const {
     FCITX_D();
-    return d->texts_.size();
+    return d ? d->texts_.size() : 0;
 }
 
 bool Text::empty() const {
     FCITX_D();
-    return d->texts_.empty();
+    return !d || d->texts_.empty();
 }
 
 std::string Text::toString() const {
     FCITX_D();
     std::string result;
+    if (!d) {
+        return result;
+    }
     for (const auto &p : d->texts_) {
         result += std::get<std::string>(p);
     }
@@ -96,6 +208,9 @@ std::string Text::toString() const {
 size_t Text::textLength() const {
     FCITX_D();
     size_t length = 0;
+    if (!d) {
+        return length;
+    }
     for (const auto &p : d->texts_) {
         length += std::get<std::string>(p).size();
     }
@@ -106,6 +221,9 @@ size_t Text::textLength() const {
 std::string Text::toStringForCommit() const {
     FCITX_D();
     std::string result;
+    if (!d) {
+        return result;
+    }
     for (const auto &p : d->texts_) {
         if (!(std::get<TextFormatFlags>(p) & TextFormatFlag::DontCommit)) {
             result += std::get<std::string>(p);
@@ -127,11 +245,29 @@ std::ostream &operator<<(std::ostream &os, const Text &text) {
     return os;
 }
 
+bool operator==(const Text &lhs, const Text &rhs) {
+    if (lhs.size() != rhs.size() || lhs.cursor() != rhs.cursor()) {
+        return false;
+    }
+    for (size_t i = 0, e = lhs.size(); i < e; i++) {
+        if (lhs.formatAt(i) != rhs.formatAt(i) ||
+            lhs.stringAt(i) != rhs.stringAt(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool operator!=(const Text &lhs, const Text &rhs) { return !(lhs == rhs); }
+
 std::vector<Text> Text::splitByLine() const {
     FCITX_D();
     std::vector<Text> texts;
     // Put first line.
     texts.emplace_back();
+    if (!d) {
+        return texts;
+    }
     for (const auto &p : d->texts_) {
         if (std::get<std::string>(p).empty()) {
             continue;
@@ -153,6 +289,9 @@ Text Text::normalize() const {
     FCITX_D();
 
     Text normalized;
+    if (!d) {
+        return normalized;
+    }
     std::string curStr;
     TextFormatFlags curFormat;
     for (const auto &[str, format] : d->texts_) {
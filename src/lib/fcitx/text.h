@@ -77,6 +77,14 @@ private:
 
 FCITXCORE_EXPORT std::ostream &operator<<(std::ostream &os, const Text &text);
 
+/**
+ * Compare fragments, formats and cursor of two texts.
+ *
+ * @since 5.1.12
+ */
+FCITXCORE_EXPORT bool operator==(const Text &lhs, const Text &rhs);
+FCITXCORE_EXPORT bool operator!=(const Text &lhs, const Text &rhs);
+
 } // namespace fcitx
 
 #endif // _FCITX_TEXT_H_
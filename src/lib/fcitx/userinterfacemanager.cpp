@@ -112,6 +112,7 @@ void UserInterfaceManagerPrivate::updateSingleComponent<
     } else if (ui_) {
         ui_->update(UserInterfaceComponent::InputPanel, ic);
     }
+    ic->inputPanel().clearDirtyComponents();
 }
 
 template <>
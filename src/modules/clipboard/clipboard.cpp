@@ -5,7 +5,9 @@
  *
  */
 #include "clipboard.h"
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <unordered_set>
 #include "fcitx-utils/event.h"
@@ -19,12 +21,16 @@
 #include "fcitx/inputcontextmanager.h"
 #include "fcitx/inputpanel.h"
 #include "clipboardentry.h"
+#include "clipboardstore.h"
 
 namespace fcitx {
 
 namespace {
 
 constexpr uint64_t oneSecond = 1000000ULL;
+// Compaction of the history log is delayed, so it does not happen while user
+// is copying a lot of things.
+constexpr uint64_t compactDelay = 10 * oneSecond;
 
 bool shouldClearPassword(const ClipboardEntry &entry, uint64_t life) {
     if (entry.passwordTimestamp == 0 || life == 0) {
@@ -45,10 +51,13 @@ public:
     ClipboardState(Clipboard *q) : q_(q) {}
 
     bool enabled_ = false;
+    // Text typed when the clipboard list is shown, to filter the history.
+    std::string query_;
     Clipboard *q_;
 
     void reset(InputContext *ic) {
         enabled_ = false;
+        query_.clear();
         ic->inputPanel().reset();
         ic->updatePreedit();
         ic->updateUserInterface(UserInterfaceComponent::InputPanel);
@@ -98,12 +107,16 @@ std::string ClipboardSelectionStrip(const std::string &text) {
     return result;
 }
 
+// Only the stripped text is kept in the candidate, the full text is looked up
+// from history again when it is selected, since it can be large.
 class ClipboardCandidateWord : public CandidateWord {
 public:
-    ClipboardCandidateWord(Clipboard *q, const std::string &str, bool password)
-        : q_(q), str_(str) {
+    ClipboardCandidateWord(Clipboard *q, const ClipboardEntry &entry,
+                           bool primary)
+        : q_(q), hash_(std::hash<ClipboardEntry>()(entry)), primary_(primary) {
+        const auto &str = entry.text;
         Text text;
-        if (password && !*q->config().showPassword) {
+        if (entry.passwordTimestamp && !*q->config().showPassword) {
             auto length = utf8::length(str);
             length = std::min(length, static_cast<size_t>(8));
             std::string dot;
@@ -122,19 +135,27 @@ public:
 
     void select(InputContext *inputContext) const override {
         auto *state = inputContext->propertyFor(&q_->factory());
-        inputContext->commitString(str_);
+        // The entry may be removed when the candidate is shown.
+        if (const auto *entry = q_->findEntry(hash_, primary_)) {
+            inputContext->commitString(entry->text);
+        }
         state->reset(inputContext);
     }
 
     Clipboard *q_;
-    std::string str_;
+    size_t hash_;
+    bool primary_;
 };
 
 Clipboard::Clipboard(Instance *instance)
     : instance_(instance),
       factory_([this](InputContext &) { return new ClipboardState(this); }) {
+    factory_.setCreateOnDemand(true);
     instance_->inputContextManager().registerProperty("clipboardState",
                                                       &factory_);
+    setMemoryUsageCallback([this]() {
+        return history_.memoryUsage() + primary_.text.size();
+    });
 #ifdef ENABLE_X11
     if (auto *xcb = this->xcb()) {
         xcbCreatedCallback_ =
@@ -188,9 +209,15 @@ Clipboard::Clipboard(Instance *instance)
                 keyEvent.filterAndAccept();
                 return;
             }
+            // Pending paste is dropped once user types something else.
+            pendingPaste_.unwatch();
             if (keyEvent.key().checkKeyList(config_.pastePrimaryKey.value())) {
-                keyEvent.inputContext()->commitString(
-                    primary(keyEvent.inputContext()));
+                if (fetchPrimary()) {
+                    pendingPaste_ = keyEvent.inputContext()->watch();
+                } else {
+                    keyEvent.inputContext()->commitString(
+                        primary(keyEvent.inputContext()));
+                }
                 keyEvent.filterAndAccept();
                 return;
             }
@@ -198,6 +225,9 @@ Clipboard::Clipboard(Instance *instance)
 
     auto reset = [this](Event &event) {
         auto &icEvent = static_cast<InputContextEvent &>(event);
+        if (pendingPaste_.get() == icEvent.inputContext()) {
+            pendingPaste_.unwatch();
+        }
         auto *state = icEvent.inputContext()->propertyFor(&factory_);
         if (state->enabled_) {
             state->reset(icEvent.inputContext());
@@ -302,15 +332,26 @@ Clipboard::Clipboard(Instance *instance)
                 state->reset(inputContext);
                 return;
             }
+            if (keyEvent.key().check(FcitxKey_BackSpace) &&
+                !state->query_.empty()) {
+                keyEvent.accept();
+                auto length = utf8::length(state->query_);
+                state->query_.erase(
+                    utf8::ncharByteLength(state->query_.begin(), length - 1));
+                updateUI(inputContext);
+                return;
+            }
             if (keyEvent.key().check(FcitxKey_Delete) ||
                 keyEvent.key().check(FcitxKey_BackSpace)) {
                 keyEvent.accept();
-                history_.clear();
-                primary_.clear();
+                clearHistory();
                 state->reset(inputContext);
                 return;
             }
             event.accept();
+            if (keyEvent.key().isSimple()) {
+                state->query_.append(Key::keySymToUTF8(keyEvent.key().sym()));
+            }
 
             updateUI(inputContext);
         }));
@@ -328,11 +369,82 @@ Clipboard::~Clipboard() {}
 void Clipboard::reloadConfig() {
     readAsIni(config_, configFile);
     refreshPasswordTimer();
+    reloadStore();
+}
+
+void Clipboard::reloadStore() {
+    if (!*config_.persistHistory) {
+        if (store_) {
+            store_.reset();
+            compactEvent_.reset();
+        }
+        // Do not keep the history around once persistence is turned off.
+        ClipboardStore::removeFile();
+        return;
+    }
+    if (store_) {
+        return;
+    }
+    store_ = std::make_unique<ClipboardStore>();
+    auto history = store_->load();
+    // Entries in memory are newer than the saved ones.
+    std::vector<const ClipboardEntry *> entries;
+    for (const auto &entry : history_) {
+        entries.push_back(&entry);
+    }
+    for (auto iter = entries.rbegin(); iter != entries.rend(); ++iter) {
+        history.pushFront(**iter);
+        if ((*iter)->passwordTimestamp) {
+            history.front().passwordTimestamp = (*iter)->passwordTimestamp;
+        }
+    }
+    const bool merged = !history_.empty();
+    history_ = std::move(history);
+    history_.trim(config_.numOfEntries.value(), MAX_CLIPBOARD_HISTORY_SIZE);
+    if (merged) {
+        store_->compact(history_);
+    } else {
+        scheduleCompaction();
+    }
+}
+
+void Clipboard::clearHistory() {
+    history_.clear();
+    primary_.clear();
+    if (store_) {
+        store_->clear();
+    }
+}
+
+void Clipboard::scheduleCompaction() {
+    if (!store_ || !store_->needsCompaction(history_)) {
+        return;
+    }
+    if (compactEvent_) {
+        if (!compactEvent_->isEnabled()) {
+            compactEvent_->setNextInterval(compactDelay);
+            compactEvent_->setOneShot();
+        }
+        return;
+    }
+    compactEvent_ = instance_->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + compactDelay, 0,
+        [this](EventSourceTime *, uint64_t) {
+            if (store_) {
+                store_->compact(history_);
+            }
+            return true;
+        });
+    instance_->eventLoop().setPriority(compactEvent_.get(), EventPriority::Low);
 }
 
 void Clipboard::trigger(InputContext *inputContext) {
     auto *state = inputContext->propertyFor(&factory_);
     state->enabled_ = true;
+    // Show what we have now, and update it once primary is read.
+    if (fetchPrimary()) {
+        pendingUI_ = inputContext->watch();
+    }
     updateUI(inputContext);
 }
 void Clipboard::updateUI(InputContext *inputContext) {
@@ -341,18 +453,23 @@ void Clipboard::updateUI(InputContext *inputContext) {
     auto candidateList = std::make_unique<CommonCandidateList>();
     candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
 
+    const auto &query = inputContext->propertyFor(&factory_)->query_;
+    if (!query.empty()) {
+        updateSearchUI(inputContext, query, std::move(candidateList));
+        return;
+    }
+
     // Append first item from history_.
     auto iter = history_.begin();
     if (iter != history_.end()) {
-        candidateList->append<ClipboardCandidateWord>(this, iter->text,
-                                                      iter->passwordTimestamp);
+        candidateList->append<ClipboardCandidateWord>(this, *iter, false);
         iter++;
     }
     // Append primary_, but check duplication first.
     if (!primary_.empty()) {
         if (!history_.contains(primary_)) {
-            candidateList->append<ClipboardCandidateWord>(
-                this, primary_.text, primary_.passwordTimestamp);
+            candidateList->append<ClipboardCandidateWord>(this, primary_,
+                                                          true);
         }
     }
     // If primary_ is appended, it might squeeze one space out.
@@ -360,8 +477,7 @@ void Clipboard::updateUI(InputContext *inputContext) {
         if (candidateList->totalSize() >= config_.numOfEntries.value()) {
             break;
         }
-        candidateList->append<ClipboardCandidateWord>(this, iter->text,
-                                                      iter->passwordTimestamp);
+        candidateList->append<ClipboardCandidateWord>(this, *iter, false);
     }
     candidateList->setSelectionKey(selectionKeys_);
     candidateList->setLayoutHint(CandidateLayoutHint::Vertical);
@@ -379,6 +495,39 @@ void Clipboard::updateUI(InputContext *inputContext) {
     inputContext->updateUserInterface(UserInterfaceComponent::InputPanel);
 }
 
+void Clipboard::updateSearchUI(
+    InputContext *inputContext, const std::string &query,
+    std::unique_ptr<CommonCandidateList> candidateList) {
+    // Hidden password should not be found by its content.
+    auto searchable = [this](const ClipboardEntry &entry) {
+        return !entry.passwordTimestamp || *config_.showPassword;
+    };
+    for (const auto *entry : history_.search(query)) {
+        if (searchable(*entry)) {
+            candidateList->append<ClipboardCandidateWord>(this, *entry, false);
+        }
+    }
+    if (!primary_.empty() && searchable(primary_) &&
+        !history_.contains(primary_) &&
+        ClipboardHistory::containsIgnoreCase(primary_.text, query)) {
+        candidateList->append<ClipboardCandidateWord>(this, primary_, true);
+    }
+    candidateList->setSelectionKey(selectionKeys_);
+    candidateList->setLayoutHint(CandidateLayoutHint::Vertical);
+
+    Text auxUp(_("Search clipboard: ") + query);
+    if (!candidateList->totalSize()) {
+        Text auxDown(_("No matching clipboard entry."));
+        inputContext->inputPanel().setAuxDown(auxDown);
+    } else {
+        candidateList->setGlobalCursorIndex(0);
+    }
+    inputContext->inputPanel().setCandidateList(std::move(candidateList));
+    inputContext->inputPanel().setAuxUp(auxUp);
+    inputContext->updatePreedit();
+    inputContext->updateUserInterface(UserInterfaceComponent::InputPanel);
+}
+
 void Clipboard::setPrimary(const std::string &name, const std::string &str) {
     setPrimaryV2(name, str, false);
 }
@@ -409,9 +558,35 @@ void Clipboard::setPrimaryEntry(const std::string &name, ClipboardEntry entry) {
         return;
     }
     primary_ = std::move(entry);
-    if (entry.passwordTimestamp) {
+    if (primary_.passwordTimestamp) {
         refreshPasswordTimer();
     }
+
+    if (auto *ic = pendingPaste_.get()) {
+        pendingPaste_.unwatch();
+        ic->commitString(primary_.text);
+    }
+    if (auto *ic = pendingUI_.get()) {
+        pendingUI_.unwatch();
+        if (ic->propertyFor(&factory_)->enabled_) {
+            updateUI(ic);
+        }
+    }
+}
+
+bool Clipboard::fetchPrimary() {
+    bool fetching = false;
+#ifdef ENABLE_X11
+    for (auto &[name, xcbClipboard] : xcbClipboards_) {
+        fetching = xcbClipboard->fetchPrimary() || fetching;
+    }
+#endif
+#ifdef WAYLAND_FOUND
+    for (auto &[name, waylandClipboard] : waylandClipboards_) {
+        fetching = waylandClipboard->fetchPrimary() || fetching;
+    }
+#endif
+    return fetching;
 }
 
 void Clipboard::setClipboardEntry(const std::string &name,
@@ -421,16 +596,33 @@ void Clipboard::setClipboardEntry(const std::string &name,
         return;
     }
 
-    if (!history_.pushFront(entry)) {
-        history_.moveToTop(entry);
-    }
+    // Whether the text is already saved in the log as a plain entry.
+    const auto *existing =
+        history_.findByHash(std::hash<ClipboardEntry>()(entry));
+    const bool saved = existing && existing->text == entry.text &&
+                       !existing->passwordTimestamp;
+    // Existing entry is moved to the front.
+    history_.pushFront(entry);
     if (history_.front().passwordTimestamp || entry.passwordTimestamp) {
         history_.front().passwordTimestamp = std::max(
             entry.passwordTimestamp, history_.front().passwordTimestamp);
     }
-    while (!history_.empty() &&
-           static_cast<int>(history_.size()) > config_.numOfEntries.value()) {
-        history_.pop();
+    // The text may be saved before it becomes a password, a remove record
+    // would still leave the plain text in the log, so rewrite it right away.
+    const bool scrub = store_ && saved && history_.front().passwordTimestamp;
+    if (store_ && !history_.front().passwordTimestamp) {
+        store_->add(history_.front());
+    }
+    history_.trim(config_.numOfEntries.value(), MAX_CLIPBOARD_HISTORY_SIZE,
+                  [this, scrub](const ClipboardEntry &removed) {
+                      if (store_ && !scrub && !removed.passwordTimestamp) {
+                          store_->remove(removed);
+                      }
+                  });
+    if (scrub) {
+        store_->compact(history_);
+    } else {
+        scheduleCompaction();
     }
     if (entry.passwordTimestamp) {
         refreshPasswordTimer();
@@ -450,6 +642,17 @@ std::string Clipboard::clipboard(const InputContext * /*unused*/) const {
     return history_.front().text;
 }
 
+const ClipboardEntry *Clipboard::findEntry(size_t hash, bool primary) const {
+    if (primary) {
+        if (!primary_.empty() &&
+            std::hash<ClipboardEntry>()(primary_) == hash) {
+            return &primary_;
+        }
+        return nullptr;
+    }
+    return history_.findByHash(hash);
+}
+
 void Clipboard::refreshPasswordTimer() {
     if (*config_.clearPasswordAfter == 0) {
         FCITX_CLIPBOARD_DEBUG() << "Disable Password Clearing Timer.";
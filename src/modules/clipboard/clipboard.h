@@ -8,8 +8,10 @@
 #define _FCITX_MODULES_CLIPBOARD_CLIPBOARD_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/iniparser.h"
@@ -21,12 +23,15 @@
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/misc.h"
 #include "fcitx-utils/misc_p.h"
+#include "fcitx-utils/trackableobject.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/candidatelist.h"
 #include "fcitx/inputcontextproperty.h"
 #include "fcitx/instance.h"
 #include "clipboard_public.h"
 #include "clipboardentry.h"
+#include "clipboardhistory.h"
 
 #ifdef ENABLE_X11
 #include "xcb_public.h"
@@ -40,7 +45,22 @@
 namespace fcitx {
 
 constexpr size_t MAX_CLIPBOARD_SIZE = 4096;
+// Budget for the text of all entries in history, the latest one is always
+// kept regardless of its size.
+constexpr size_t MAX_CLIPBOARD_HISTORY_SIZE = 1024 * 1024;
 constexpr char PASSWORD_MIME_TYPE[] = "x-kde-passwordManagerHint";
+// Primary selection changes all the time when selecting text, so it is only
+// read after it does not change for this long, or when it is needed.
+constexpr uint64_t PRIMARY_FETCH_DELAY = 1000000;
+
+// Maximum size of data to read for the mime type.
+inline size_t clipboardSizeLimit(std::string_view mime) {
+    if (mime == PASSWORD_MIME_TYPE) {
+        // The value is expected to be "secret".
+        return 64;
+    }
+    return MAX_CLIPBOARD_SIZE;
+}
 
 FCITX_CONFIGURATION(
     ClipboardConfig, KeyListOption triggerKey{this,
@@ -53,6 +73,14 @@ FCITX_CONFIGURATION(
     Option<int, IntConstrain> numOfEntries{this, "Number of entries",
                                            _("Number of entries"), 5,
                                            IntConstrain(3, 30)};
+    OptionWithAnnotation<bool, ToolTipAnnotation> persistHistory{
+        this,
+        "PersistHistory",
+        _("Keep clipboard history after restart"),
+        false,
+        {},
+        {},
+        {_("Entries that contain password are never saved.")}};
     ConditionalHidden<isAndroid(),
                       OptionWithAnnotation<bool, ToolTipAnnotation>>
         ignorePasswordFromPasswordManager{
@@ -80,6 +108,7 @@ FCITX_CONFIGURATION(
                            {_("0 means never clear password.")}};);
 
 class ClipboardState;
+class ClipboardStore;
 class Clipboard final : public AddonInstance {
     static constexpr char configFile[] = "conf/clipboard.conf";
 
@@ -111,6 +140,11 @@ public:
     void setClipboardV2(const std::string &name, const std::string &str,
                         bool password);
     const auto &config() const { return config_; }
+    // Find the entry in history, or primary, by the hash of the text.
+    const ClipboardEntry *findEntry(size_t hash, bool primary) const;
+    // Read the changed primary selections that are not read yet. Return
+    // true if any read is started, setPrimary is called when it is done.
+    bool fetchPrimary();
 
 #ifdef ENABLE_X11
     FCITX_ADDON_DEPENDENCY_LOADER(xcb, instance_->addonManager());
@@ -127,7 +161,12 @@ private:
     FCITX_ADDON_DEPENDENCY_LOADER(wayland, instance_->addonManager());
 #endif
 
+    void updateSearchUI(InputContext *inputContext, const std::string &query,
+                        std::unique_ptr<CommonCandidateList> candidateList);
     void refreshPasswordTimer();
+    void reloadStore();
+    void clearHistory();
+    void scheduleCompaction();
     void setPrimaryEntry(const std::string &name, ClipboardEntry entry);
     void setClipboardEntry(const std::string &name,
                            const ClipboardEntry &entry);
@@ -155,9 +194,14 @@ private:
     std::unordered_map<std::string, std::unique_ptr<WaylandClipboard>>
         waylandClipboards_;
 #endif
-    OrderedSet<ClipboardEntry> history_;
+    ClipboardHistory history_;
     ClipboardEntry primary_;
+    // Input contexts waiting for primary selection to be read.
+    TrackableObjectReference<InputContext> pendingUI_;
+    TrackableObjectReference<InputContext> pendingPaste_;
     std::unique_ptr<EventSourceTime> clearPasswordTimer_;
+    std::unique_ptr<ClipboardStore> store_;
+    std::unique_ptr<EventSourceTime> compactEvent_;
 };
 
 FCITX_DECLARE_LOG_CATEGORY(clipboard_log);
@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include "fcitx-utils/log.h"
 
 namespace fcitx {
@@ -45,7 +46,12 @@ inline LogMessageBuilder &operator<<(LogMessageBuilder &builder,
 template <>
 struct std::hash<fcitx::ClipboardEntry> {
     size_t operator()(const fcitx::ClipboardEntry &entry) const noexcept {
-        return std::hash<std::string>()(entry.text);
+        return operator()(entry.text);
+    }
+
+    // Same as the hash of an entry with the text.
+    size_t operator()(std::string_view text) const noexcept {
+        return std::hash<std::string_view>()(text);
     }
 };
 
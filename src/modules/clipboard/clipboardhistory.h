@@ -0,0 +1,211 @@
+/*
+ * SPDX-FileCopyrightText: 2024~2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX5_MODULES_CLIPBOARD_CLIPBOARDHISTORY_H_
+#define _FCITX5_MODULES_CLIPBOARD_CLIPBOARDHISTORY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "fcitx-utils/charutils.h"
+#include "clipboardentry.h"
+
+namespace fcitx {
+
+/**
+ * Clipboard history, most recent entry first.
+ *
+ * Each text is only stored once, entries are indexed by the hash of the text
+ * for deduplication. The history is trimmed by both the number of entries and
+ * the total size of text.
+ *
+ * A trigram index of the text is maintained along with insertion and removal,
+ * so search only needs to verify the entries that contain every trigram of
+ * the query.
+ */
+class ClipboardHistory {
+    using EntryList = std::list<ClipboardEntry>;
+
+public:
+    ClipboardHistory() = default;
+    // Index holds iterators to entries, which stay valid only on move.
+    ClipboardHistory(const ClipboardHistory &) = delete;
+    ClipboardHistory(ClipboardHistory &&) = default;
+    ClipboardHistory &operator=(const ClipboardHistory &) = delete;
+    ClipboardHistory &operator=(ClipboardHistory &&) = default;
+
+    auto begin() const { return entries_.begin(); }
+    auto end() const { return entries_.end(); }
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    // Total size of the text of all entries in bytes.
+    size_t bytes() const { return bytes_; }
+
+    // Rough estimation of the memory used by entries and indexes, each node is
+    // counted as its value plus two pointers.
+    size_t memoryUsage() const {
+        constexpr size_t node = 2 * sizeof(void *);
+        size_t result = bytes_;
+        result += entries_.size() * (sizeof(ClipboardEntry) + node);
+        result += index_.size() * (sizeof(Index::value_type) + node);
+        for (const auto &[_, postings] : trigrams_) {
+            result += sizeof(uint32_t) + sizeof(Postings) + node +
+                      postings.size() * (sizeof(Postings::value_type) + node);
+        }
+        return result;
+    }
+
+    const ClipboardEntry &front() const { return entries_.front(); }
+    ClipboardEntry &front() { return entries_.front(); }
+
+    void clear() {
+        index_.clear();
+        trigrams_.clear();
+        entries_.clear();
+        bytes_ = 0;
+    }
+
+    bool contains(const ClipboardEntry &entry) const {
+        return find(entry.text) != index_.end();
+    }
+
+    const ClipboardEntry *findByHash(size_t hash) const {
+        auto iter = index_.find(hash);
+        return iter == index_.end() ? nullptr : &*iter->second;
+    }
+
+    // Add the entry to the front, or move the existing one with the same text
+    // to the front. Return false if the entry already exists.
+    bool pushFront(const ClipboardEntry &entry) {
+        if (auto iter = find(entry.text); iter != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            return false;
+        }
+        entries_.push_front(entry);
+        index_.emplace(std::hash<ClipboardEntry>()(entry), entries_.begin());
+        bytes_ += entry.text.size();
+        const auto *added = &entries_.front();
+        forEachTrigram(added->text, [this, added](uint32_t trigram) {
+            trigrams_[trigram].insert(added);
+        });
+        return true;
+    }
+
+    bool remove(const ClipboardEntry &entry) {
+        auto iter = find(entry.text);
+        if (iter == index_.end()) {
+            return false;
+        }
+        bytes_ -= iter->second->text.size();
+        const auto *removed = &*iter->second;
+        forEachTrigram(removed->text, [this, removed](uint32_t trigram) {
+            auto postings = trigrams_.find(trigram);
+            if (postings == trigrams_.end()) {
+                return;
+            }
+            postings->second.erase(removed);
+            if (postings->second.empty()) {
+                trigrams_.erase(postings);
+            }
+        });
+        entries_.erase(iter->second);
+        index_.erase(iter);
+        return true;
+    }
+
+    // Drop the oldest entries until both limits are met. The most recent
+    // entry is always kept since it is the current clipboard content.
+    void trim(size_t maxSize, size_t maxBytes) {
+        trim(maxSize, maxBytes, [](const ClipboardEntry &) {});
+    }
+
+    // Same as above, onRemove is called before an entry is dropped.
+    template <typename Callback>
+    void trim(size_t maxSize, size_t maxBytes, Callback onRemove) {
+        while (entries_.size() > 1 &&
+               (entries_.size() > maxSize || bytes_ > maxBytes)) {
+            onRemove(entries_.back());
+            remove(entries_.back());
+        }
+    }
+
+    // Entries that contain query, ignoring ASCII case, most recent first.
+    std::vector<const ClipboardEntry *> search(std::string_view query) const {
+        // Only entries in the smallest posting list need to be verified.
+        const Postings *candidates = nullptr;
+        bool missing = false;
+        forEachTrigram(query, [this, &candidates, &missing](uint32_t trigram) {
+            auto postings = trigrams_.find(trigram);
+            if (postings == trigrams_.end()) {
+                missing = true;
+            } else if (!candidates ||
+                       postings->second.size() < candidates->size()) {
+                candidates = &postings->second;
+            }
+        });
+        std::vector<const ClipboardEntry *> result;
+        if (missing) {
+            return result;
+        }
+        for (const auto &entry : entries_) {
+            if (candidates && !candidates->count(&entry)) {
+                continue;
+            }
+            if (containsIgnoreCase(entry.text, query)) {
+                result.push_back(&entry);
+            }
+        }
+        return result;
+    }
+
+    static bool containsIgnoreCase(std::string_view text,
+                                   std::string_view query) {
+        return std::search(text.begin(), text.end(), query.begin(),
+                           query.end(), [](char lhs, char rhs) {
+                               return charutils::tolower(lhs) ==
+                                      charutils::tolower(rhs);
+                           }) != text.end();
+    }
+
+private:
+    using Index = std::unordered_multimap<size_t, EntryList::iterator>;
+    using Postings = std::unordered_set<const ClipboardEntry *>;
+
+    // Trigrams are taken from bytes, which also works for substring of UTF-8.
+    template <typename Callback>
+    static void forEachTrigram(std::string_view text, Callback callback) {
+        auto byte = [text](size_t i) -> uint32_t {
+            return static_cast<unsigned char>(charutils::tolower(text[i]));
+        };
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            callback((byte(i) << 16) | (byte(i + 1) << 8) | byte(i + 2));
+        }
+    }
+
+    Index::const_iterator find(std::string_view text) const {
+        auto range = index_.equal_range(std::hash<ClipboardEntry>()(text));
+        for (auto iter = range.first; iter != range.second; ++iter) {
+            if (iter->second->text == text) {
+                return iter;
+            }
+        }
+        return index_.end();
+    }
+
+    EntryList entries_;
+    Index index_;
+    std::unordered_map<uint32_t, Postings> trigrams_;
+    size_t bytes_ = 0;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX5_MODULES_CLIPBOARD_CLIPBOARDHISTORY_H_
@@ -0,0 +1,214 @@
+/*
+ * SPDX-FileCopyrightText: 2024~2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include "clipboardstore.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
+#include "clipboard.h"
+
+namespace fcitx {
+
+namespace {
+
+constexpr char storePath[] = "clipboard/history.log";
+constexpr char magic[8] = {'F', 'C', 'C', 'L', 'I', 'P', '\0', '\1'};
+// Length, checksum and operation.
+constexpr size_t headerSize = sizeof(uint32_t) * 2 + sizeof(uint8_t);
+// Do not bother to compact a log smaller than this.
+constexpr size_t minCompactSize = 64 * 1024;
+
+uint32_t checksum(uint8_t op, std::string_view text) {
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    auto feed = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 16777619U;
+    };
+    feed(op);
+    for (char c : text) {
+        feed(static_cast<uint8_t>(c));
+    }
+    return hash;
+}
+
+void encode(std::string &buffer, uint8_t op, std::string_view text) {
+    uint32_t size = text.size();
+    uint32_t sum = checksum(op, text);
+    char header[headerSize];
+    memcpy(header, &size, sizeof(size));
+    memcpy(header + sizeof(size), &sum, sizeof(sum));
+    header[sizeof(size) + sizeof(sum)] = static_cast<char>(op);
+    buffer.append(header, sizeof(header));
+    buffer.append(text);
+}
+
+bool writeAll(int fd, const std::string &buffer) {
+    return fs::safeWrite(fd, buffer.data(), buffer.size()) ==
+           static_cast<ssize_t>(buffer.size());
+}
+
+} // namespace
+
+ClipboardStore::ClipboardStore() { open(); }
+
+void ClipboardStore::open() {
+    logSize_ = 0;
+    auto file = StandardPath::global().openUser(
+        StandardPath::Type::PkgData, storePath,
+        O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC);
+    if (!file.isValid()) {
+        FCITX_CLIPBOARD_DEBUG() << "Failed to open clipboard history log.";
+        fd_.reset();
+        return;
+    }
+    fd_.give(file.release());
+    struct stat stats;
+    if (fstat(fd_.fd(), &stats) == 0) {
+        logSize_ = stats.st_size;
+    }
+}
+
+ClipboardHistory ClipboardStore::load() {
+    ClipboardHistory history;
+    if (!fd_.isValid()) {
+        return history;
+    }
+
+    size_t validSize = 0;
+    if (logSize_ >= sizeof(magic)) {
+        void *data =
+            mmap(nullptr, logSize_, PROT_READ, MAP_PRIVATE, fd_.fd(), 0);
+        if (data != MAP_FAILED) {
+            const auto *cur = static_cast<const char *>(data);
+            const auto *end = cur + logSize_;
+            if (memcmp(cur, magic, sizeof(magic)) == 0) {
+                cur += sizeof(magic);
+                while (static_cast<size_t>(end - cur) >= headerSize) {
+                    uint32_t size;
+                    uint32_t sum;
+                    memcpy(&size, cur, sizeof(size));
+                    memcpy(&sum, cur + sizeof(size), sizeof(sum));
+                    auto op = static_cast<uint8_t>(cur[sizeof(size) +
+                                                       sizeof(sum)]);
+                    if (static_cast<size_t>(end - cur - headerSize) < size) {
+                        break;
+                    }
+                    std::string_view text(cur + headerSize, size);
+                    if (checksum(op, text) != sum) {
+                        break;
+                    }
+                    ClipboardEntry entry{.text = std::string(text)};
+                    if (op == static_cast<uint8_t>(Op::Add)) {
+                        history.pushFront(entry);
+                    } else if (op == static_cast<uint8_t>(Op::Remove)) {
+                        history.remove(entry);
+                    } else {
+                        break;
+                    }
+                    cur += headerSize + size;
+                }
+                validSize = cur - static_cast<const char *>(data);
+            }
+            munmap(data, logSize_);
+        }
+    }
+
+    if (validSize < sizeof(magic)) {
+        // New file, or not even the magic is valid.
+        clear();
+    } else if (validSize != logSize_) {
+        FCITX_CLIPBOARD_DEBUG() << "Drop invalid clipboard history log after "
+                                << validSize << " bytes.";
+        if (ftruncate(fd_.fd(), validSize) == 0) {
+            logSize_ = validSize;
+        }
+    }
+    return history;
+}
+
+void ClipboardStore::append(Op op, std::string_view text) {
+    if (!fd_.isValid()) {
+        return;
+    }
+    std::string buffer;
+    encode(buffer, static_cast<uint8_t>(op), text);
+    if (writeAll(fd_.fd(), buffer)) {
+        logSize_ += buffer.size();
+    }
+}
+
+void ClipboardStore::add(const ClipboardEntry &entry) {
+    if (entry.passwordTimestamp) {
+        return;
+    }
+    append(Op::Add, entry.text);
+}
+
+void ClipboardStore::remove(const ClipboardEntry &entry) {
+    append(Op::Remove, entry.text);
+}
+
+void ClipboardStore::clear() {
+    if (!fd_.isValid()) {
+        return;
+    }
+    logSize_ = 0;
+    if (ftruncate(fd_.fd(), 0) == 0 &&
+        writeAll(fd_.fd(), std::string(magic, sizeof(magic)))) {
+        logSize_ = sizeof(magic);
+    }
+}
+
+bool ClipboardStore::needsCompaction(const ClipboardHistory &history) const {
+    return logSize_ > std::max(minCompactSize, history.bytes() * 4);
+}
+
+void ClipboardStore::compact(const ClipboardHistory &history) {
+    std::string buffer(magic, sizeof(magic));
+    // Oldest first, so replaying it puts the most recent one in front.
+    std::vector<const ClipboardEntry *> entries;
+    for (const auto &entry : history) {
+        entries.push_back(&entry);
+    }
+    for (auto iter = entries.rbegin(); iter != entries.rend(); ++iter) {
+        if (!(*iter)->passwordTimestamp) {
+            encode(buffer, static_cast<uint8_t>(Op::Add), (*iter)->text);
+        }
+    }
+
+    // Temp file is created with 0600 by mkstemp, and renamed on close.
+    auto file = StandardPath::global().openUserTemp(
+        StandardPath::Type::PkgData, storePath);
+    if (!file.isValid()) {
+        return;
+    }
+    if (!writeAll(file.fd(), buffer)) {
+        file.removeTemp();
+        return;
+    }
+    file.close();
+    open();
+}
+
+void ClipboardStore::removeFile() {
+    auto dir =
+        StandardPath::global().userDirectory(StandardPath::Type::PkgData);
+    if (!dir.empty()) {
+        unlink(stringutils::joinPath(dir, storePath).c_str());
+    }
+}
+
+} // namespace fcitx
@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2024~2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX5_MODULES_CLIPBOARD_CLIPBOARDSTORE_H_
+#define _FCITX5_MODULES_CLIPBOARD_CLIPBOARDSTORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "fcitx-utils/unixfd.h"
+#include "clipboardentry.h"
+#include "clipboardhistory.h"
+
+namespace fcitx {
+
+/**
+ * Persistent clipboard history, as an append only log under the user data
+ * directory.
+ *
+ * Each record is a length, a checksum, an operation and the text. Replaying
+ * the records in order rebuilds the history. The log is mapped when it is
+ * loaded, and a torn or corrupted tail is dropped. Compaction rewrites the log
+ * with only the live entries.
+ *
+ * Entries with a password timestamp are never written. If a saved entry
+ * becomes a password later, the caller compacts the log instead of appending a
+ * remove record, so the text does not stay on disk.
+ */
+class ClipboardStore {
+public:
+    ClipboardStore();
+
+    // Rebuild history from the log, the most recent entry comes first.
+    ClipboardHistory load();
+
+    // Add the entry, or move the existing one to the front.
+    void add(const ClipboardEntry &entry);
+    void remove(const ClipboardEntry &entry);
+    void clear();
+
+    // Whether the log is large enough compared to the live entries.
+    bool needsCompaction(const ClipboardHistory &history) const;
+    void compact(const ClipboardHistory &history);
+
+    // Remove the log file from disk.
+    static void removeFile();
+
+private:
+    enum class Op : uint8_t { Add = 1, Remove = 2 };
+
+    void open();
+    void append(Op op, std::string_view text);
+
+    UnixFD fd_;
+    size_t logSize_ = 0;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX5_MODULES_CLIPBOARD_CLIPBOARDSTORE_H_
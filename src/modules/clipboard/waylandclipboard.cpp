@@ -16,6 +16,7 @@
 namespace fcitx {
 
 uint64_t DataReaderThread::addTask(DataOffer *offer, std::shared_ptr<UnixFD> fd,
+                                   size_t sizeLimit,
                                    DataOfferDataCallback callback) {
     auto id = nextId_++;
     if (id == 0) {
@@ -24,9 +25,9 @@ uint64_t DataReaderThread::addTask(DataOffer *offer, std::shared_ptr<UnixFD> fd,
     FCITX_CLIPBOARD_DEBUG() << "Add task: " << id << " " << fd;
     dispatcherToWorker_.scheduleWithContext(
         offer->watch(),
-        [this, id, fd = std::move(fd), offerRef = offer->watch(),
+        [this, id, fd = std::move(fd), offerRef = offer->watch(), sizeLimit,
          callback = std::move(callback)]() mutable {
-            addTaskOnWorker(id, std::move(offerRef), std::move(fd),
+            addTaskOnWorker(id, std::move(offerRef), std::move(fd), sizeLimit,
                             std::move(callback));
         });
     return id;
@@ -48,12 +49,14 @@ void DataReaderThread::realRun() {
 
 void DataReaderThread::addTaskOnWorker(
     uint64_t id, TrackableObjectReference<DataOffer> offer,
-    std::shared_ptr<UnixFD> fd, DataOfferDataCallback callback) {
+    std::shared_ptr<UnixFD> fd, size_t sizeLimit,
+    DataOfferDataCallback callback) {
     // std::unordered_map's ref/pointer to element is stable.
     auto &task = tasks_[id];
     task.id_ = id;
     task.offer_ = std::move(offer);
     task.fd_ = std::move(fd);
+    task.sizeLimit_ = sizeLimit;
     task.callback_ = std::move(callback);
     try {
         task.ioEvent_ = dispatcherToWorker_.eventLoop()->addIOEvent(
@@ -92,7 +95,7 @@ void DataReaderThread::handleTaskIO(DataOfferTask *task, IOEventFlags flags) {
     } else if (n < 0) {
         tasks_.erase(task->id_);
     } else {
-        if (task->data_.size() + n > MAX_CLIPBOARD_SIZE) {
+        if (task->data_.size() + n > task->sizeLimit_) {
             tasks_.erase(task->id_);
             return;
         }
@@ -184,7 +187,7 @@ void DataOffer::receiveDataForMime(const std::string &mime,
 
     taskId_ = thread_->addTask(
         this, std::make_shared<UnixFD>(UnixFD::own(pipeFds[0])),
-        std::move(callback));
+        clipboardSizeLimit(mime), std::move(callback));
 }
 
 DataDevice::DataDevice(WaylandClipboard *clipboard,
@@ -216,18 +219,30 @@ DataDevice::DataDevice(WaylandClipboard *clipboard,
             primaryOffer_.reset(
                 offer ? static_cast<DataOffer *>(offer->userData()) : nullptr);
             if (!primaryOffer_) {
+                primaryPending_ = false;
                 clipboard_->setPrimary("", false);
                 return;
             }
-            primaryOffer_->receiveData(
-                thread_, [this](std::vector<char> data, bool password) {
-                    data.push_back('\0');
-                    clipboard_->setPrimary(data.data(), password);
-                    primaryOffer_.reset();
-                });
+            // Mime types are already known from the offer, the data is read
+            // lazily.
+            primaryPending_ = true;
+            if (primaryTimer_) {
+                primaryTimer_->setNextInterval(PRIMARY_FETCH_DELAY);
+                primaryTimer_->setOneShot();
+                return;
+            }
+            primaryTimer_ =
+                clipboard_->parent()->instance()->eventLoop().addTimeEvent(
+                    CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + PRIMARY_FETCH_DELAY,
+                    0, [this](EventSourceTime *, uint64_t) {
+                        fetchPrimary();
+                        return true;
+                    });
         }));
     conns_.emplace_back(device_->finished().connect([this]() {
         conns_.clear();
+        primaryPending_ = false;
+        primaryTimer_.reset();
         primaryOffer_.reset();
         clipboardOffer_.reset();
         device_.reset();
@@ -235,6 +250,21 @@ DataDevice::DataDevice(WaylandClipboard *clipboard,
     thread_.start();
 }
 
+bool DataDevice::fetchPrimary() {
+    if (!primaryPending_ || !primaryOffer_) {
+        return false;
+    }
+    primaryPending_ = false;
+    primaryTimer_->setEnabled(false);
+    primaryOffer_->receiveData(
+        thread_, [this](std::vector<char> data, bool password) {
+            data.push_back('\0');
+            clipboard_->setPrimary(data.data(), password);
+            primaryOffer_.reset();
+        });
+    return true;
+}
+
 WaylandClipboard::WaylandClipboard(Clipboard *clipboard, std::string name,
                                    wl_display *display)
     : parent_(clipboard), name_(std::move(name)),
@@ -299,4 +329,12 @@ void WaylandClipboard::setPrimary(const std::string &str, bool password) {
     parent_->setPrimaryV2(name_, str, password);
 }
 
+bool WaylandClipboard::fetchPrimary() {
+    bool fetching = false;
+    for (auto &[seat, device] : deviceMap_) {
+        fetching = device->fetchPrimary() || fetching;
+    }
+    return fetching;
+}
+
 } // namespace fcitx
@@ -46,6 +46,7 @@ struct DataOfferTask {
     DataOfferDataCallback callback_;
     std::shared_ptr<UnixFD> fd_;
     std::vector<char> data_;
+    size_t sizeLimit_ = 0;
     std::unique_ptr<EventSourceIO> ioEvent_;
     std::unique_ptr<EventSource> timeEvent_;
 };
@@ -73,14 +74,14 @@ public:
     static void run(DataReaderThread *self) { self->realRun(); }
 
     uint64_t addTask(DataOffer *offer, std::shared_ptr<UnixFD> fd,
-                     DataOfferDataCallback callback);
+                     size_t sizeLimit, DataOfferDataCallback callback);
     void removeTask(uint64_t token);
 
 private:
     // Function that run on reader thread
     void realRun();
     void addTaskOnWorker(uint64_t id, TrackableObjectReference<DataOffer> offer,
-                         std::shared_ptr<UnixFD> fd,
+                         std::shared_ptr<UnixFD> fd, size_t sizeLimit,
                          DataOfferDataCallback callback);
     void handleTaskIO(DataOfferTask *task, IOEventFlags flags);
     void handleTaskTimeout(DataOfferTask *task);
@@ -125,12 +126,17 @@ public:
     DataDevice(WaylandClipboard *clipboard,
                wayland::ZwlrDataControlDeviceV1 *device);
 
+    // Read primary if it changed since last read.
+    bool fetchPrimary();
+
 private:
     WaylandClipboard *clipboard_;
     std::unique_ptr<wayland::ZwlrDataControlDeviceV1> device_;
     DataReaderThread thread_;
     std::unique_ptr<DataOffer> primaryOffer_;
     std::unique_ptr<DataOffer> clipboardOffer_;
+    bool primaryPending_ = false;
+    std::unique_ptr<EventSourceTime> primaryTimer_;
     std::list<ScopedConnection> conns_;
 };
 
@@ -142,6 +148,7 @@ public:
 
     void setClipboard(const std::string &str, bool password);
     void setPrimary(const std::string &str, bool password);
+    bool fetchPrimary();
     auto display() const { return display_; }
     auto parent() const { return parent_; }
 
@@ -5,8 +5,11 @@
  *
  */
 #include "xcbclipboard.h"
+#include <cstdint>
 #include <ctime>
+#include <string>
 #include <string_view>
+#include <vector>
 #include <xcb/xproto.h>
 #include "clipboard.h"
 
@@ -105,6 +108,10 @@ void XcbClipboardData::checkPassword(xcb_atom_t /*type*/, const char *data,
 
 void XcbClipboardData::readData(xcb_atom_t type, const char *data,
                                 size_t length) {
+    // Same as wayland, drop the text that exceeds the limit.
+    if (length > clipboardSizeLimit("text/plain")) {
+        data = nullptr;
+    }
 
     switch (mode_) {
     case XcbClipboardMode::Primary:
@@ -135,9 +142,11 @@ XcbClipboard::XcbClipboard(Clipboard *clipboard, std::string name)
     // CLIPBOARD is not guaranteed to exist if fcitx5 is
     // launched at an very early stage. We should try to create
     // atom ourselves.
-    xcb_->call<IXCBModule::atom>(name_, "PRIMARY", false);
-    xcb_->call<IXCBModule::atom>(name_, "CLIPBOARD", false);
-    xcb_->call<IXCBModule::atom>(name_, "TARGETS", false);
+    xcb_->call<IXCBModule::prefetchAtoms>(
+        name_,
+        std::vector<std::string>{"PRIMARY", "CLIPBOARD", "TARGETS",
+                                 PASSWORD_MIME_TYPE, "UTF8_STRING"},
+        false);
     passwordAtom_ =
         xcb_->call<IXCBModule::atom>(name_, PASSWORD_MIME_TYPE, false);
     utf8StringAtom_ = xcb_->call<IXCBModule::atom>(name_, "UTF8_STRING", false);
@@ -149,7 +158,30 @@ XcbClipboard::XcbClipboard(Clipboard *clipboard, std::string name)
     clipboardChanged();
 }
 
-void XcbClipboard::primaryChanged() { primary_.request(); }
+void XcbClipboard::primaryChanged() {
+    primaryPending_ = true;
+    if (primaryTimer_) {
+        primaryTimer_->setNextInterval(PRIMARY_FETCH_DELAY);
+        primaryTimer_->setOneShot();
+        return;
+    }
+    primaryTimer_ = parent_->instance()->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + PRIMARY_FETCH_DELAY, 0,
+        [this](EventSourceTime *, uint64_t) {
+            fetchPrimary();
+            return true;
+        });
+}
+
+bool XcbClipboard::fetchPrimary() {
+    if (!primaryPending_) {
+        return false;
+    }
+    primaryPending_ = false;
+    primaryTimer_->setEnabled(false);
+    primary_.request();
+    return true;
+}
 
 void XcbClipboard::clipboardChanged() { clipboard_.request(); }
 
@@ -7,8 +7,10 @@
 #ifndef _FCITX5_MODULES_CLIPBOARD_XCBCLIPBOARD_H_
 #define _FCITX5_MODULES_CLIPBOARD_XCBCLIPBOARD_H_
 
+#include <memory>
 #include <string>
 #include <xcb/xproto.h>
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/handlertable.h"
 #include "fcitx/addoninstance.h"
 
@@ -56,6 +58,8 @@ public:
 
     void setClipboard(const std::string &str, bool password);
     void setPrimary(const std::string &str, bool password);
+    // Read primary if it changed since last read.
+    bool fetchPrimary();
 
     AddonInstance *xcb() const { return xcb_; }
     const std::string &name() const { return name_; }
@@ -76,6 +80,8 @@ private:
 
     XcbClipboardData primary_;
     XcbClipboardData clipboard_;
+    bool primaryPending_ = false;
+    std::unique_ptr<EventSourceTime> primaryTimer_;
 };
 
 } // namespace fcitx
@@ -8,16 +8,24 @@
 #include "config.h"
 
 #include <pwd.h>
+#include <clocale>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
+#include <optional>
 #include <set>
 #include <sstream>
+#include <tuple>
+#include <unordered_map>
 #include <fmt/format.h>
 #include "fcitx-config/dbushelper.h"
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/variant.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/stringutils.h"
+#include "fcitx/addoninfo.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/event.h"
 #include "fcitx/focusgroup.h"
 #include "fcitx/inputcontextmanager.h"
 #include "fcitx/inputmethodengine.h"
@@ -49,6 +57,14 @@ constexpr char globalConfigPath[] = "fcitx://config/global";
 constexpr char addonConfigPrefix[] = "fcitx://config/addon/";
 constexpr char imConfigPrefix[] = "fcitx://config/inputmethod/";
 
+// Bits of the change mask in StateChanged.
+enum StateChangedFlag : uint32_t {
+    StateChangedState = (1 << 0),
+    StateChangedInputMethod = (1 << 1),
+    StateChangedGroup = (1 << 2),
+    StateChangedGroups = (1 << 3),
+};
+
 #ifdef ENABLE_X11
 std::string X11GetAddress(AddonInstance *xcb, const std::string &display,
                           xcb_connection_t *conn) {
@@ -129,7 +145,16 @@ std::string X11GetAddress(AddonInstance *xcb, const std::string &display,
 class Controller1 : public ObjectVTable<Controller1> {
 public:
     Controller1(DBusModule *module, Instance *instance)
-        : module_(module), instance_(instance) {}
+        : module_(module), instance_(instance) {
+        for (auto type : {EventType::InputContextFocusIn,
+                          EventType::InputContextFocusOut,
+                          EventType::InputContextSwitchInputMethod,
+                          EventType::InputMethodGroupChanged}) {
+            events_.emplace_back(instance_->watchEvent(
+                type, EventWatcherPhase::PostInputMethod,
+                [this](Event &) { scheduleStateChanged(); }));
+        }
+    }
 
     void exit() { instance_->exit(); }
 
@@ -154,8 +179,27 @@ public:
     void toggle() { return instance_->toggle(); }
     void resetInputMethodList() { return instance_->resetInputMethodList(); }
     int state() { return instance_->state(); }
-    void reloadConfig() { return instance_->reloadConfig(); }
+
+    // State, current input method, current group and all group names.
+    using StateSnapshot =
+        std::tuple<int, std::string, std::string, std::vector<std::string>>;
+
+    StateSnapshot stateSnapshot() {
+        const auto &imManager = instance_->inputMethodManager();
+        // Group is not available until input method manager is loaded.
+        std::string group;
+        if (imManager.groupCount()) {
+            group = imManager.currentGroup().name();
+        }
+        return {instance_->state(), instance_->currentInputMethod(),
+                std::move(group), imManager.groups()};
+    }
+    void reloadConfig() {
+        descriptionCache_.clear();
+        return instance_->reloadConfig();
+    }
     void reloadAddonConfig(const std::string &addonName) {
+        descriptionCache_.clear();
         return instance_->reloadAddonConfig(addonName);
     }
     std::string currentInputMethod() { return instance_->currentInputMethod(); }
@@ -317,7 +361,8 @@ public:
             instance_->globalConfig().save(config);
             std::get<0>(result) = rawConfigToVariant(config);
             std::get<1>(result) =
-                dumpDBusConfigDescription(instance_->globalConfig().config());
+                configDescription(uri, instance_->globalConfig().config(),
+                                  FCITX_VERSION_STRING);
             return result;
         }
         if (stringutils::startsWith(uri, addonConfigPrefix)) {
@@ -328,8 +373,8 @@ public:
                 subPath = addon.substr(pos + 1);
                 addon = addon.substr(0, pos);
             }
-            if (const auto *addonInfo =
-                    instance_->addonManager().addonInfo(addon)) {
+            const auto *addonInfo = instance_->addonManager().addonInfo(addon);
+            if (addonInfo) {
                 if (!addonInfo->isConfigurable()) {
                     throw dbus::MethodCallError(
                         "org.freedesktop.DBus.Error.InvalidArgs",
@@ -353,7 +398,8 @@ public:
                 RawConfig rawConfig;
                 config->save(rawConfig);
                 std::get<0>(result) = rawConfigToVariant(rawConfig);
-                std::get<1>(result) = dumpDBusConfigDescription(*config);
+                std::get<1>(result) = configDescription(
+                    uri, *config, addonInfo->version().toString());
                 return result;
             }
             throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
@@ -382,8 +428,13 @@ public:
             if (config) {
                 RawConfig rawConfig;
                 config->save(rawConfig);
+                std::string version;
+                if (const auto *addonInfo =
+                        instance_->addonManager().addonInfo(entry->addon())) {
+                    version = addonInfo->version().toString();
+                }
                 std::get<0>(result) = rawConfigToVariant(rawConfig);
-                std::get<1>(result) = dumpDBusConfigDescription(*config);
+                std::get<1>(result) = configDescription(uri, *config, version);
                 return result;
             }
 
@@ -397,6 +448,9 @@ public:
     void setConfig(const std::string &uri, const dbus::Variant &v) {
         std::tuple<dbus::Variant, DBusConfig> result;
         RawConfig config = variantToRawConfig(v);
+        // Setting a config may change what other configs offer, e.g. the
+        // input methods listed by the global config.
+        descriptionCache_.clear();
         if (uri == globalConfigPath) {
             instance_->globalConfig().load(config, true);
             if (instance_->globalConfig().safeSave()) {
@@ -661,6 +715,9 @@ public:
                << " focus:" << ic->hasFocus() << std::endl;
             return true;
         });
+        const auto [keymaps, keymapMemory] = instance_->xkbKeymapCacheUsage();
+        ss << "Keymap cache has " << keymaps << " keymap(s), about "
+           << keymapMemory / 1024 << "KiB" << std::endl;
         return ss.str();
     }
 
@@ -681,13 +738,204 @@ public:
 
     void setLogRule(const std::string &rule) { Log::setLogRule(rule); }
 
+    void setEventTracing(bool enable) {
+        instance_->setEventTracingEnabled(enable);
+    }
+
+    std::vector<dbus::DBusStruct<std::string, uint64_t, uint64_t, uint64_t>>
+    eventLatencyStatistics() {
+        std::vector<dbus::DBusStruct<std::string, uint64_t, uint64_t, uint64_t>>
+            result;
+        for (auto &stat : instance_->eventLatencyStatistics()) {
+            result.emplace_back(std::forward_as_tuple(
+                std::move(stat.name), stat.count, stat.p50, stat.p99));
+        }
+        return result;
+    }
+
+    void resetEventLatencyStatistics() {
+        instance_->resetEventLatencyStatistics();
+    }
+
+    std::string recentKeyEvents() { return instance_->recentKeyEvents(); }
+
+    bool startKeyTrace(const std::string &path) {
+        return instance_->startKeyTrace(path);
+    }
+
+    void stopKeyTrace() { instance_->stopKeyTrace(); }
+
+    std::string startupTimeline() { return instance_->startupTimeline(); }
+
+    void setEventLoopStatistics(bool enable) {
+        instance_->eventLoop().setStatisticsEnabled(enable);
+    }
+
+    std::vector<dbus::DBusStruct<std::string, uint64_t, uint64_t, uint64_t>>
+    eventLoopStatistics() {
+        std::vector<dbus::DBusStruct<std::string, uint64_t, uint64_t, uint64_t>>
+            result;
+        for (auto &stat : instance_->eventLoop().statistics()) {
+            result.emplace_back(std::forward_as_tuple(
+                std::move(stat.tag), stat.dispatchCount, stat.totalTime,
+                stat.lastDispatchTime));
+        }
+        return result;
+    }
+
+    void resetEventLoopStatistics() {
+        instance_->eventLoop().resetStatistics();
+    }
+
+    void setDBusMethodStatistics(bool enable) {
+        bus()->setMethodStatisticsEnabled(enable);
+    }
+
+    std::vector<dbus::DBusStruct<std::string, std::string, uint64_t, uint64_t,
+                                 uint64_t, uint64_t, std::vector<uint64_t>>>
+    dbusMethodStatistics() {
+        std::vector<
+            dbus::DBusStruct<std::string, std::string, uint64_t, uint64_t,
+                             uint64_t, uint64_t, std::vector<uint64_t>>>
+            result;
+        for (auto &stat : bus()->methodStatistics()) {
+            result.emplace_back(std::forward_as_tuple(
+                std::move(stat.interface), std::move(stat.method),
+                stat.callCount, stat.errorCount, stat.totalTime, stat.maxTime,
+                std::vector<uint64_t>(stat.latencyHistogram.begin(),
+                                      stat.latencyHistogram.end())));
+        }
+        return result;
+    }
+
+    void resetDBusMethodStatistics() { bus()->resetMethodStatistics(); }
+
+    dbus::DBusStruct<uint64_t, uint64_t, uint64_t, uint64_t>
+    inputContextStatistics() {
+        const auto &manager = instance_->inputContextManager();
+        return {manager.inputContextCount(), manager.peakInputContextCount(),
+                manager.createdInputContextCount(),
+                manager.recycledInputContextCount()};
+    }
+
+    std::vector<dbus::DBusStruct<std::string, std::string, uint64_t, uint64_t>>
+    memoryUsage() {
+        std::vector<
+            dbus::DBusStruct<std::string, std::string, uint64_t, uint64_t>>
+            result;
+        auto &addonManager = instance_->addonManager();
+        for (const auto &name : addonManager.loadedAddonNames()) {
+            auto *addon = addonManager.lookupAddon(name);
+            if (!addon) {
+                continue;
+            }
+            if (auto bytes = addon->memoryUsage()) {
+                result.emplace_back(std::forward_as_tuple("addon", name, 1,
+                                                          bytes));
+            }
+        }
+        auto &manager = instance_->inputContextManager();
+        for (auto &usage : manager.propertyUsage()) {
+            result.emplace_back(std::forward_as_tuple(
+                "property", std::move(usage.name), usage.count, usage.bytes));
+        }
+        manager.foreach([&result, &manager](InputContext *ic) {
+            std::string uuid;
+            for (auto v : ic->uuid()) {
+                uuid.append(fmt::format("{:02x}", static_cast<int>(v)));
+            }
+            result.emplace_back(std::forward_as_tuple(
+                "inputcontext", std::move(uuid), 1,
+                manager.propertyMemoryUsage(*ic)));
+            return true;
+        });
+        const auto [keymaps, keymapMemory] = instance_->xkbKeymapCacheUsage();
+        result.emplace_back(
+            std::forward_as_tuple("cache", "keymap", keymaps, keymapMemory));
+        return result;
+    }
+
 private:
+    struct CachedDescription {
+        const Configuration *config;
+        std::string version;
+        std::string locale;
+        DBusConfig description;
+    };
+
+    static std::string currentLocale() {
+        const char *locale = setlocale(LC_MESSAGES, nullptr);
+        const char *language = getenv("LANGUAGE");
+        return stringutils::concat(locale ? locale : "", "\n",
+                                   language ? language : "");
+    }
+
+    // The description only depends on the translation and the addon that
+    // defines the options, so it is reused until a config is set or reloaded.
+    const DBusConfig &configDescription(const std::string &uri,
+                                        const Configuration &config,
+                                        std::string version) {
+        auto locale = currentLocale();
+        auto iter = descriptionCache_.find(uri);
+        if (iter != descriptionCache_.end() &&
+            iter->second.config == &config &&
+            iter->second.version == version && iter->second.locale == locale) {
+            return iter->second.description;
+        }
+        auto &cached = descriptionCache_[uri];
+        cached.config = &config;
+        cached.version = std::move(version);
+        cached.locale = std::move(locale);
+        cached.description = dumpDBusConfigDescription(config);
+        return cached.description;
+    }
+
+    // Events are coalesced, and only the state that differs from the last
+    // StateChanged is reported.
+    void scheduleStateChanged() {
+        if (stateChangedEvent_) {
+            return;
+        }
+        stateChangedEvent_ =
+            instance_->eventLoop().addDeferEvent([this](EventSource *) {
+                auto current = stateSnapshot();
+                uint32_t mask = StateChangedState | StateChangedInputMethod |
+                                StateChangedGroup | StateChangedGroups;
+                if (lastState_) {
+                    mask = 0;
+                    if (std::get<0>(current) != std::get<0>(*lastState_)) {
+                        mask |= StateChangedState;
+                    }
+                    if (std::get<1>(current) != std::get<1>(*lastState_)) {
+                        mask |= StateChangedInputMethod;
+                    }
+                    if (std::get<2>(current) != std::get<2>(*lastState_)) {
+                        mask |= StateChangedGroup;
+                    }
+                    if (std::get<3>(current) != std::get<3>(*lastState_)) {
+                        mask |= StateChangedGroups;
+                    }
+                }
+                lastState_ = std::move(current);
+                if (mask) {
+                    stateChanged(mask);
+                }
+                stateChangedEvent_.reset();
+                return false;
+            });
+    }
+
     DBusModule *module_;
     Instance *instance_;
     std::unique_ptr<EventSource> deferEvent_;
+    std::unique_ptr<EventSource> stateChangedEvent_;
+    std::optional<StateSnapshot> lastState_;
+    std::vector<std::unique_ptr<HandlerTableEntry<EventHandler>>> events_;
+    std::unordered_map<std::string, CachedDescription> descriptionCache_;
 
     FCITX_OBJECT_VTABLE_SIGNAL(inputMethodGroupChanged,
                                "InputMethodGroupsChanged", "");
+    FCITX_OBJECT_VTABLE_SIGNAL(stateChanged, "StateChanged", "u");
 
     FCITX_OBJECT_VTABLE_METHOD(availableKeyboardLayouts,
                                "AvailableKeyboardLayouts", "",
@@ -724,6 +972,7 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(toggle, "Toggle", "", "");
     FCITX_OBJECT_VTABLE_METHOD(resetInputMethodList, "ResetIMList", "", "");
     FCITX_OBJECT_VTABLE_METHOD(state, "State", "", "i");
+    FCITX_OBJECT_VTABLE_METHOD(stateSnapshot, "GetStateSnapshot", "", "issas");
     FCITX_OBJECT_VTABLE_METHOD(reloadConfig, "ReloadConfig", "", "");
     FCITX_OBJECT_VTABLE_METHOD(reloadAddonConfig, "ReloadAddonConfig", "s", "");
     FCITX_OBJECT_VTABLE_METHOD(currentInputMethod, "CurrentInputMethod", "",
@@ -750,6 +999,30 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(save, "Save", "", "");
     FCITX_OBJECT_VTABLE_METHOD(setLogRule, "SetLogRule", "s", "");
     FCITX_OBJECT_VTABLE_METHOD(canRestart, "CanRestart", "", "b");
+    FCITX_OBJECT_VTABLE_METHOD(setEventTracing, "SetEventTracing", "b", "");
+    FCITX_OBJECT_VTABLE_METHOD(eventLatencyStatistics,
+                               "EventLatencyStatistics", "", "a(sttt)");
+    FCITX_OBJECT_VTABLE_METHOD(resetEventLatencyStatistics,
+                               "ResetEventLatencyStatistics", "", "");
+    FCITX_OBJECT_VTABLE_METHOD(recentKeyEvents, "RecentKeyEvents", "", "s");
+    FCITX_OBJECT_VTABLE_METHOD(startKeyTrace, "StartKeyTrace", "s", "b");
+    FCITX_OBJECT_VTABLE_METHOD(stopKeyTrace, "StopKeyTrace", "", "");
+    FCITX_OBJECT_VTABLE_METHOD(startupTimeline, "StartupTimeline", "", "s");
+    FCITX_OBJECT_VTABLE_METHOD(setEventLoopStatistics,
+                               "SetEventLoopStatistics", "b", "");
+    FCITX_OBJECT_VTABLE_METHOD(eventLoopStatistics, "EventLoopStatistics", "",
+                               "a(sttt)");
+    FCITX_OBJECT_VTABLE_METHOD(resetEventLoopStatistics,
+                               "ResetEventLoopStatistics", "", "");
+    FCITX_OBJECT_VTABLE_METHOD(inputContextStatistics,
+                               "InputContextStatistics", "", "(tttt)");
+    FCITX_OBJECT_VTABLE_METHOD(memoryUsage, "MemoryUsage", "", "a(sstt)");
+    FCITX_OBJECT_VTABLE_METHOD(setDBusMethodStatistics,
+                               "SetDBusMethodStatistics", "b", "");
+    FCITX_OBJECT_VTABLE_METHOD(dbusMethodStatistics, "DBusMethodStatistics",
+                               "", "a(ssttttat)");
+    FCITX_OBJECT_VTABLE_METHOD(resetDBusMethodStatistics,
+                               "ResetDBusMethodStatistics", "", "");
 };
 
 DBusModule::DBusModule(Instance *instance)
@@ -798,6 +1071,31 @@ DBusModule::DBusModule(Instance *instance)
         GNOME_HELPER_NAME,
         [this](const std::string &, const std::string &,
                const std::string &newName) { xkbHelperName_ = newName; });
+
+    auto &addonManager = instance_->addonManager();
+    for (auto category :
+         {AddonCategory::InputMethod, AddonCategory::Frontend,
+          AddonCategory::Loader, AddonCategory::Module, AddonCategory::UI}) {
+        for (const auto &name : addonManager.addonNames(category)) {
+            const auto *info = addonManager.addonInfo(name);
+            if (!info || !info->onDemand()) {
+                continue;
+            }
+            for (const auto &service : info->triggerDBusNames()) {
+                addonTriggerWatchers_.push_back(serviceWatcher_->watchService(
+                    service, [instance, name](const std::string &service,
+                                              const std::string &,
+                                              const std::string &newName) {
+                        if (newName.empty()) {
+                            return;
+                        }
+                        FCITX_DEBUG() << "Load addon " << name
+                                      << " on DBus name " << service;
+                        instance->addonManager().addon(name, true);
+                    }));
+            }
+        }
+    }
 }
 
 DBusModule::~DBusModule() {}
@@ -7,6 +7,9 @@
 #ifndef _FCITX_MODULES_DBUS_DBUSMODULE_H_
 #define _FCITX_MODULES_DBUS_DBUSMODULE_H_
 
+#include <memory>
+#include <string>
+#include <vector>
 #include "fcitx-utils/dbus/servicewatcher.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
@@ -43,6 +46,10 @@ private:
     std::unique_ptr<HandlerTableEntry<dbus::ServiceWatcherCallback>>
         xkbWatcher_;
     std::string xkbHelperName_;
+    // Load on demand addons when their DBus names appear.
+    std::vector<
+        std::unique_ptr<HandlerTableEntry<dbus::ServiceWatcherCallback>>>
+        addonTriggerWatchers_;
     std::unique_ptr<Controller1> controller_;
 };
 } // namespace fcitx
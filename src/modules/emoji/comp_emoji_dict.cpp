@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <cstdio>
+#include <map>
+#include <string>
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/unixfd.h"
+#include "emojiindex.h"
+
+using namespace fcitx;
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <output.index> <input.dict>...\n", argv[0]);
+        return 1;
+    }
+    std::map<std::string, emoji::EmojiDict> languages;
+    for (int i = 2; i < argc; i++) {
+        // The language is named after the file, e.g. zh_Hant.dict.
+        std::string name = fs::baseName(argv[i]);
+        if (stringutils::endsWith(name, ".dict")) {
+            name.resize(name.size() - 5);
+        }
+        UnixFD ifd = UnixFD::own(open(argv[i], O_RDONLY));
+        if (!ifd.isValid()) {
+            fprintf(stderr, "Failed to open %s.\n", argv[i]);
+            return 1;
+        }
+        if (!emoji::readEmojiDict(ifd.fd(), languages[name])) {
+            fprintf(stderr, "Invalid emoji dictionary %s.\n", argv[i]);
+            return 1;
+        }
+    }
+    auto index = emoji::buildEmojiIndex(languages);
+    UnixFD ofd = UnixFD::own(open(argv[1], O_WRONLY | O_TRUNC | O_CREAT, 0644));
+    if (!ofd.isValid() ||
+        fs::safeWrite(ofd.fd(), index.data(), index.size()) !=
+            static_cast<ssize_t>(index.size())) {
+        fprintf(stderr, "Failed to write %s.\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -5,10 +5,15 @@
  *
  */
 #include "emoji.h"
-#include <sys/stat.h>
+#include <fcntl.h>
 #include <functional>
-#include <zlib.h>
+#include <map>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <vector>
 #include "fcitx-utils/charutils.h"
+#include "fcitx-utils/log.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx-utils/stringutils.h"
@@ -17,142 +22,194 @@
 
 namespace fcitx {
 
-namespace {
-
-uint32_t readInt32(const uint8_t **data, const uint8_t *end) {
-    if (*data + 4 > end) {
-        throw std::runtime_error("Unknown emoji dict data");
-    }
-    uint32_t n = FromLittleEndian32(*data);
-    *data += 4;
-    return n;
-}
-
-std::string_view readString(const uint8_t **data, const uint8_t *end) {
-    uint32_t length = readInt32(data, end);
-    if (*data + length > end) {
-        throw std::runtime_error("Unknown emoji dict data");
-    }
-    std::string_view s(reinterpret_cast<const char *>(*data), length);
-    *data += length;
-    return s;
-}
-
-} // namespace
-
-class EmojiParser {
-public:
-    EmojiParser(std::function<bool(std::string_view)> filter)
-        : filter_(std::move(filter)) {}
-
-    bool load(int fd) {
-        struct stat s;
-        if (fstat(fd, &s) < 0) {
-            return false;
-        }
-        std::vector<uint8_t> compressed;
-        std::vector<uint8_t> data;
-        auto size = s.st_size;
-        if (size < 4) {
-            return false;
-        }
-        compressed.resize(size);
-        if (size != fs::safeRead(fd, compressed.data(), size)) {
-            return false;
-        }
-        uint32_t expectedSize = FromLittleEndian32(compressed.data());
-        if (!expectedSize) {
-            return false;
-        }
-
-        data.resize(expectedSize);
-
-        unsigned long len = expectedSize;
-        if (::uncompress(data.data(), &len, compressed.data() + 4, size - 4) !=
-            Z_OK) {
-            return false;
-        }
+static const std::vector<std::string> emptyEmoji;
 
-        try {
-            const auto *cur = data.data();
-            const auto *end = data.data() + data.size();
-            uint32_t nEmoji = readInt32(&cur, end);
-            for (uint32_t i = 0; i < nEmoji; i++) {
-                std::string_view emoji = readString(&cur, end);
-                if (!utf8::validate(emoji)) {
-                    throw std::runtime_error("Corrupted emoji data");
-                }
-                uint32_t nAnnotations = readInt32(&cur, end);
-                for (uint32_t j = 0; j < nAnnotations; j++) {
-                    std::string_view annotation = readString(&cur, end);
-                    if (filter_ && filter_(annotation)) {
-                        continue;
-                    }
-                    auto &emojis = emojiMap_[std::string(annotation)];
-                    // Certain word has a very general meaning and has tons of
-                    // matches, keep only 1 or 2 for specific.
-                    if (emojis.empty() ||
-                        (emojis.size() == 1 && emojis[0] != emoji)) {
-                        emojis.push_back(std::string(emoji));
-                    }
-                }
+Emoji::Emoji() {
+    setTrimMemoryCallback([this](MemoryTrimLevel level) {
+        if (level == MemoryTrimLevel::Idle) {
+            for (auto &[_, emojiData] : langToEmojiData_) {
+                emojiData.queryCache.clear();
             }
-        } catch (const std::runtime_error &) {
-            FCITX_ERROR() << "Failed to load emoji dictionary";
-            return false;
+            return;
         }
-        return true;
-    }
-
-    EmojiMap emojiMap_;
-
-private:
-    std::function<bool(std::string_view)> filter_;
-};
-
-static const std::vector<std::string> emptyEmoji;
-
-Emoji::Emoji() {}
+        // Everything is loaded again on next use.
+        langToEmojiData_.clear();
+        sharedIndex_.reset();
+        sharedIndexLoaded_ = false;
+    });
+}
 
 Emoji::~Emoji() {}
 
 bool Emoji::check(const std::string &language, bool fallbackToEn) {
-    const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
-    return emojiMap;
+    const EmojiData *emojiData = loadEmoji(language, fallbackToEn);
+    return emojiData;
 }
 
 const std::vector<std::string> &Emoji::query(const std::string &language,
                                              const std::string &key,
                                              bool fallbackToEn) {
-    const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
+    EmojiData *emojiData = loadEmoji(language, fallbackToEn);
 
-    if (!emojiMap) {
+    if (!emojiData || (emojiData->filter && emojiData->filter(key))) {
         return emptyEmoji;
     }
 
-    if (const auto *result = findValue(*emojiMap, key)) {
+    if (const auto *result = findValue(emojiData->queryCache, key)) {
         return *result;
     }
 
-    return emptyEmoji;
+    const auto &index = emojiData->index;
+    auto pos = index.lowerBound(key);
+    if (pos == index.size() || index.key(pos) != key) {
+        return emptyEmoji;
+    }
+    auto emojis = index.emojis(pos);
+    if (emojis.empty()) {
+        return emptyEmoji;
+    }
+    return emojiData->queryCache[key] = std::move(emojis);
 }
 
 void Emoji::prefix(
     const std::string &language, const std::string &key, bool fallbackToEn,
     const std::function<bool(const std::string &,
                              const std::vector<std::string> &)> &collector) {
-    const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
+    const EmojiData *emojiData = loadEmoji(language, fallbackToEn);
 
-    if (!emojiMap) {
+    if (!emojiData) {
         return;
     }
-    auto start = emojiMap->lower_bound(key);
-    auto end = emojiMap->end();
-    for (; start != end; start++) {
-        if (!stringutils::startsWith(start->first, key)) {
+    const auto &index = emojiData->index;
+    for (auto pos = index.lowerBound(key); pos < index.size(); pos++) {
+        auto annotation = index.key(pos);
+        if (!stringutils::startsWith(annotation, key)) {
             break;
         }
-        if (!collector(start->first, start->second)) {
+        if (emojiData->filter && emojiData->filter(annotation)) {
+            continue;
+        }
+        auto emojis = index.emojis(pos);
+        if (emojis.empty()) {
+            continue;
+        }
+        if (!collector(std::string(annotation), emojis)) {
+            break;
+        }
+    }
+}
+
+namespace {
+
+// Whether all chars appear in text in order. UTF-8 is self synchronizing, so
+// a found character is always at a character boundary.
+bool fuzzyMatch(std::string_view text,
+                const std::vector<std::string_view> &chars) {
+    size_t pos = 0;
+    for (auto chr : chars) {
+        pos = text.find(chr, pos);
+        if (pos == std::string_view::npos) {
+            return false;
+        }
+        pos += chr.size();
+    }
+    return true;
+}
+
+struct SearchCandidate {
+    // 0 for exact match, 1 for prefix match and 2 for fuzzy match.
+    int tier;
+    // Extra bytes of annotation compared to the key.
+    size_t distance;
+    // Position in index, so a tie is broken by the sorted annotation.
+    size_t pos;
+
+    bool operator<(const SearchCandidate &other) const {
+        return std::tie(tier, distance, pos) <
+               std::tie(other.tier, other.distance, other.pos);
+    }
+};
+
+} // namespace
+
+void Emoji::search(
+    const std::string &language, const std::string &key, bool fallbackToEn,
+    size_t limit, bool fuzzy,
+    const std::function<bool(const std::string &,
+                             const std::vector<std::string> &)> &collector) {
+    const EmojiData *emojiData = loadEmoji(language, fallbackToEn);
+
+    if (!emojiData || limit == 0 || key.empty() || !utf8::validate(key)) {
+        return;
+    }
+    const auto &index = emojiData->index;
+
+    // Keep the best limit candidates, the worst one is on the top. Filter is
+    // only checked when a candidate can make it into the result.
+    std::priority_queue<SearchCandidate> best;
+    auto offer = [&best, &index, emojiData, limit](SearchCandidate candidate) {
+        if (best.size() == limit && !(candidate < best.top())) {
+            return;
+        }
+        if (emojiData->filter && emojiData->filter(index.key(candidate.pos))) {
+            return;
+        }
+        best.push(candidate);
+        if (best.size() > limit) {
+            best.pop();
+        }
+    };
+
+    const auto prefixBegin = index.lowerBound(key);
+    auto prefixEnd = prefixBegin;
+    for (; prefixEnd < index.size(); prefixEnd++) {
+        auto annotation = index.key(prefixEnd);
+        if (!stringutils::startsWith(annotation, key)) {
+            break;
+        }
+        auto distance = annotation.size() - key.size();
+        offer({distance == 0 ? 0 : 1, distance, prefixEnd});
+    }
+
+    if (fuzzy) {
+        std::vector<std::string_view> chars;
+        for (auto chr : utf8::MakeUTF8StringViewRange(key)) {
+            chars.push_back(chr);
+        }
+        // Only annotations that starts with the same character are matched.
+        const auto first = chars.front();
+        chars.erase(chars.begin());
+        for (auto pos = index.lowerBound(first); pos < index.size(); pos++) {
+            if (pos == prefixBegin) {
+                // Already matched as prefix.
+                pos = prefixEnd;
+                if (pos == index.size()) {
+                    break;
+                }
+            }
+            auto annotation = index.key(pos);
+            if (!stringutils::startsWith(annotation, first)) {
+                break;
+            }
+            if (annotation.size() >= key.size() &&
+                fuzzyMatch(annotation.substr(first.size()), chars)) {
+                offer({2, annotation.size() - key.size(), pos});
+            }
+        }
+    }
+
+    std::vector<SearchCandidate> result;
+    result.reserve(best.size());
+    while (!best.empty()) {
+        result.push_back(best.top());
+        best.pop();
+    }
+    for (auto iter = result.rbegin(); iter != result.rend(); ++iter) {
+        auto emojis = index.emojis(iter->pos);
+        if (emojis.empty()) {
+            continue;
+        }
+        if (!collector(std::string(index.key(iter->pos)), emojis)) {
             break;
         }
     }
@@ -164,8 +221,22 @@ bool noSpace(std::string_view str) {
 }
 } // namespace
 
-const EmojiMap *Emoji::loadEmoji(const std::string &language,
-                                 bool fallbackToEn) {
+const std::shared_ptr<const EmojiIndex> &Emoji::sharedIndex() {
+    if (!sharedIndexLoaded_) {
+        sharedIndexLoaded_ = true;
+        auto file = StandardPath::global().open(
+            StandardPath::Type::PkgData, "emoji/data/emoji.index", O_RDONLY);
+        if (file.isValid()) {
+            sharedIndex_ = EmojiIndex::map(file.fd());
+            if (!sharedIndex_) {
+                FCITX_ERROR() << "Failed to load emoji index";
+            }
+        }
+    }
+    return sharedIndex_;
+}
+
+EmojiData *Emoji::loadEmoji(const std::string &language, bool fallbackToEn) {
     // This is to match the file in CLDR.
     static const std::unordered_map<std::string, std::string> languageMap = {
         {"zh_TW", "zh_Hant"}, {"zh_CN", "zh"}, {"zh_HK", "zh_Hant_HK"}};
@@ -176,8 +247,8 @@ const EmojiMap *Emoji::loadEmoji(const std::string &language,
     } else {
         lang = language;
     }
-    auto *emojiMap = findValue(langToEmojiMap_, lang);
-    if (!emojiMap) {
+    auto *emojiData = findValue(langToEmojiData_, lang);
+    if (!emojiData) {
         // These are having aspell/hunspell/ispell available.
         static const std::unordered_map<std::string,
                                         std::function<bool(std::string_view)>>
@@ -212,27 +283,57 @@ const EmojiMap *Emoji::loadEmoji(const std::string &language,
                               return utf8::lengthValidated(str) > 2;
                           }}};
         const auto *filter = findValue(filterMap, lang);
-        const auto file = StandardPath::global().open(
-            StandardPath::Type::PkgData,
-            stringutils::concat("emoji/data/", lang, ".dict"), O_RDONLY);
-        EmojiParser parser(filter ? *filter : nullptr);
-        if (file.isValid() && parser.load(file.fd())) {
-            emojiMap = &(langToEmojiMap_[lang] = std::move(parser.emojiMap_));
-            FCITX_INFO() << "Trying to load emoji for " << lang << " from "
-                         << file << ": " << emojiMap->size()
-                         << " entry(s) loaded.";
+        // Prefer the index generated at build time, which can be mapped
+        // directly and is shared by all languages. The dictionary is still
+        // accepted, and indexed in memory.
+        std::shared_ptr<const EmojiIndex> storage;
+        std::optional<EmojiIndex::Language> index;
+        if (const auto &shared = sharedIndex()) {
+            storage = shared;
+            index = storage->language(lang);
+        }
+        if (!index) {
+            auto file = StandardPath::global().open(
+                StandardPath::Type::PkgData,
+                stringutils::concat("emoji/data/", lang, ".dict"), O_RDONLY);
+            std::map<std::string, emoji::EmojiDict> dicts;
+            if (file.isValid()) {
+                if (emoji::readEmojiDict(file.fd(), dicts[lang])) {
+                    storage =
+                        EmojiIndex::fromBuffer(emoji::buildEmojiIndex(dicts));
+                }
+                if (storage) {
+                    index = storage->language(lang);
+                } else {
+                    FCITX_ERROR() << "Failed to load emoji dictionary";
+                }
+            }
+        }
+        if (index) {
+            FCITX_INFO() << "Trying to load emoji for " << lang << ": "
+                         << index->size() << " entry(s) loaded.";
+            emojiData = &langToEmojiData_[lang];
+            emojiData->storage = std::move(storage);
+            emojiData->index = *index;
+            if (filter) {
+                emojiData->filter = *filter;
+            }
         } else {
             if (!fallbackToEn) {
                 return nullptr;
             }
-            const auto *enMap = loadEmoji("en", false);
-            if (enMap) {
-                emojiMap = &(langToEmojiMap_[lang] = *enMap);
+            // Share the index of en, with the filter of en.
+            const auto *enData = loadEmoji("en", false);
+            if (enData) {
+                emojiData = &langToEmojiData_[lang];
+                emojiData->storage = enData->storage;
+                emojiData->index = enData->index;
+                emojiData->filter = enData->filter;
             }
         }
     }
 
-    return emojiMap;
+    return emojiData;
 }
 
 class EmojiModuleFactory : public AddonFactory {
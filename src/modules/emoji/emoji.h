@@ -7,13 +7,28 @@
 #ifndef _FCITX5_MODULES_EMOJI_EMOJI_H_
 #define _FCITX5_MODULES_EMOJI_EMOJI_H_
 
-#include <map>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include "fcitx/addoninstance.h"
 #include "emoji_public.h"
+#include "emojiindex.h"
 
 namespace fcitx {
-using EmojiMap = std::map<std::string, std::vector<std::string>>;
+
+struct EmojiData {
+    // Owner of the storage that index points to, which may be shared by
+    // multiple languages.
+    std::shared_ptr<const EmojiIndex> storage;
+    EmojiIndex::Language index;
+    // Annotation that should be skipped for the language.
+    std::function<bool(std::string_view)> filter;
+    // Result of query need to stay valid, so they are kept once built.
+    std::unordered_map<std::string, std::vector<std::string>> queryCache;
+};
 
 class Emoji final : public AddonInstance {
 
@@ -29,14 +44,24 @@ public:
                 bool fallbackToEn,
                 const std::function<bool(const std::string &,
                                          const std::vector<std::string> &)> &);
+    void search(const std::string &language, const std::string &key,
+                bool fallbackToEn, size_t limit, bool fuzzy,
+                const std::function<bool(const std::string &,
+                                         const std::vector<std::string> &)> &);
 
 private:
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, query);
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, check);
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, prefix);
+    FCITX_ADDON_EXPORT_FUNCTION(Emoji, search);
+
+    EmojiData *loadEmoji(const std::string &language, bool fallbackToEn);
+    const std::shared_ptr<const EmojiIndex> &sharedIndex();
 
-    const EmojiMap *loadEmoji(const std::string &language, bool fallbackToEn);
-    std::unordered_map<std::string, EmojiMap> langToEmojiMap_;
+    // Index of all languages, loaded on first use.
+    std::shared_ptr<const EmojiIndex> sharedIndex_;
+    bool sharedIndexLoaded_ = false;
+    std::unordered_map<std::string, EmojiData> langToEmojiData_;
 };
 } // namespace fcitx
 
@@ -7,6 +7,7 @@
 #ifndef _FCITX5_MODULES_EMOJI_EMOJI_PUBLIC_H_
 #define _FCITX5_MODULES_EMOJI_EMOJI_PUBLIC_H_
 
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <vector>
@@ -27,4 +28,19 @@ FCITX_ADDON_DECLARE_FUNCTION(
          const std::function<bool(const std::string &,
                                   const std::vector<std::string> &)> &));
 
+/**
+ * Search annotations that start with key, or contain all the characters of
+ * key in order if fuzzy is true. At most limit annotations are passed to the
+ * collector, best match first: exact match, then shorter prefix matches, then
+ * fuzzy matches. Return false from the collector to stop early.
+ *
+ * @since 5.1.12
+ */
+FCITX_ADDON_DECLARE_FUNCTION(
+    Emoji, search,
+    void(const std::string &language, const std::string &key, bool fallbackToEn,
+         size_t limit, bool fuzzy,
+         const std::function<bool(const std::string &,
+                                  const std::vector<std::string> &)> &));
+
 #endif // _FCITX5_MODULES_EMOJI_EMOJI_PUBLIC_H_
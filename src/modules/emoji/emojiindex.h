@@ -0,0 +1,383 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX5_MODULES_EMOJI_EMOJIINDEX_H_
+#define _FCITX5_MODULES_EMOJI_EMOJIINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+#include "fcitx-utils/endian_p.h"
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/misc_p.h"
+#include "fcitx-utils/utf8.h"
+
+namespace fcitx {
+
+/**
+ * Uncompressed emoji index of all languages, generated from the zlib
+ * compressed emoji dictionaries at build time.
+ *
+ * All numbers are 32bit little endian. Layout:
+ *   magic, number of languages, keys, postings and values,
+ *   language table: (name offset, name length, first key, key count) sorted
+ *   by name,
+ *   key table: (key offset, key length, first posting, posting count) sorted
+ *   by key within each language,
+ *   posting table: value index,
+ *   value table: (emoji offset, emoji length),
+ *   string pool, which all offsets are relative to.
+ *
+ * Every string is stored once in the pool, and every emoji has one entry in
+ * the value table, so those are shared by all the languages. The file is
+ * mapped as is, and queried with binary search on the key table, so nothing
+ * is parsed when it is loaded and the pages are shared between processes.
+ */
+class EmojiIndex {
+public:
+    static constexpr char magic[8] = {'F', 'C', 'E', 'M', 'O', 'J', 'I', '2'};
+    static constexpr size_t headerSize = sizeof(magic) + sizeof(uint32_t) * 4;
+    static constexpr size_t languageEntrySize = sizeof(uint32_t) * 4;
+    static constexpr size_t keyEntrySize = sizeof(uint32_t) * 4;
+    static constexpr size_t postingEntrySize = sizeof(uint32_t);
+    static constexpr size_t valueEntrySize = sizeof(uint32_t) * 2;
+
+    // Keys of a single language.
+    class Language {
+    public:
+        size_t size() const { return numKeys_; }
+
+        std::string_view key(size_t i) const {
+            return index_->key(firstKey_ + i);
+        }
+
+        // Emojis of key i, invalid data is skipped.
+        std::vector<std::string> emojis(size_t i) const {
+            return index_->emojis(firstKey_ + i);
+        }
+
+        // Index of first key that is not less than the given key.
+        size_t lowerBound(std::string_view key) const {
+            size_t low = 0;
+            size_t high = numKeys_;
+            while (low < high) {
+                size_t mid = low + (high - low) / 2;
+                if (this->key(mid) < key) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low;
+        }
+
+    private:
+        friend class EmojiIndex;
+        const EmojiIndex *index_ = nullptr;
+        size_t firstKey_ = 0;
+        size_t numKeys_ = 0;
+    };
+
+    // Map the index file, return nullptr if it is not a valid index.
+    static std::unique_ptr<EmojiIndex> map(int fd) {
+        fs::FileView file(fd);
+        if (!file.isValid() || file.size() < headerSize) {
+            return nullptr;
+        }
+        std::unique_ptr<EmojiIndex> index(new EmojiIndex);
+        index->file_ = std::move(file);
+        index->data_ = index->file_.data();
+        index->size_ = index->file_.size();
+        if (!index->init()) {
+            return nullptr;
+        }
+        return index;
+    }
+
+    static std::unique_ptr<EmojiIndex> fromBuffer(std::string buffer) {
+        std::unique_ptr<EmojiIndex> index(new EmojiIndex);
+        index->buffer_ = std::move(buffer);
+        index->data_ = index->buffer_.data();
+        index->size_ = index->buffer_.size();
+        if (!index->init()) {
+            return nullptr;
+        }
+        return index;
+    }
+
+    // Keys of the given language, return nullopt if it is not in the index.
+    std::optional<Language> language(std::string_view name) const {
+        size_t low = 0;
+        size_t high = numLanguages_;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            const char *entry = languages_ + mid * languageEntrySize;
+            auto current = string(FromLittleEndian32(entry),
+                                  FromLittleEndian32(entry + 4));
+            if (current < name) {
+                low = mid + 1;
+            } else if (name < current) {
+                high = mid;
+            } else {
+                uint32_t first = FromLittleEndian32(entry + 8);
+                uint32_t count = FromLittleEndian32(entry + 12);
+                if (first > numKeys_ || count > numKeys_ - first) {
+                    return std::nullopt;
+                }
+                Language language;
+                language.index_ = this;
+                language.firstKey_ = first;
+                language.numKeys_ = count;
+                return language;
+            }
+        }
+        return std::nullopt;
+    }
+
+private:
+    EmojiIndex() = default;
+
+    bool init() {
+        if (size_ < headerSize || memcmp(data_, magic, sizeof(magic)) != 0) {
+            return false;
+        }
+        const char *header = data_ + sizeof(magic);
+        numLanguages_ = FromLittleEndian32(header);
+        numKeys_ = FromLittleEndian32(header + 4);
+        numPostings_ = FromLittleEndian32(header + 8);
+        numValues_ = FromLittleEndian32(header + 12);
+        const uint64_t tableSize =
+            static_cast<uint64_t>(numLanguages_) * languageEntrySize +
+            static_cast<uint64_t>(numKeys_) * keyEntrySize +
+            static_cast<uint64_t>(numPostings_) * postingEntrySize +
+            static_cast<uint64_t>(numValues_) * valueEntrySize;
+        if (tableSize > size_ - headerSize) {
+            return false;
+        }
+        languages_ = data_ + headerSize;
+        keys_ =
+            languages_ + static_cast<size_t>(numLanguages_) * languageEntrySize;
+        postings_ = keys_ + static_cast<size_t>(numKeys_) * keyEntrySize;
+        values_ =
+            postings_ + static_cast<size_t>(numPostings_) * postingEntrySize;
+        pool_ = values_ + static_cast<size_t>(numValues_) * valueEntrySize;
+        poolSize_ = size_ - headerSize - tableSize;
+        return true;
+    }
+
+    std::string_view key(size_t i) const {
+        const char *entry = keys_ + i * keyEntrySize;
+        return string(FromLittleEndian32(entry),
+                      FromLittleEndian32(entry + 4));
+    }
+
+    std::vector<std::string> emojis(size_t i) const {
+        const char *entry = keys_ + i * keyEntrySize;
+        uint32_t first = FromLittleEndian32(entry + 8);
+        uint32_t count = FromLittleEndian32(entry + 12);
+        std::vector<std::string> result;
+        if (first > numPostings_ || count > numPostings_ - first) {
+            return result;
+        }
+        for (uint32_t j = first; j < first + count; j++) {
+            uint32_t valueIndex =
+                FromLittleEndian32(postings_ + j * postingEntrySize);
+            if (valueIndex >= numValues_) {
+                continue;
+            }
+            const char *value = values_ + valueIndex * valueEntrySize;
+            auto emoji = string(FromLittleEndian32(value),
+                                FromLittleEndian32(value + 4));
+            if (!emoji.empty() && utf8::validate(emoji)) {
+                result.emplace_back(emoji);
+            }
+        }
+        return result;
+    }
+
+    // Out of range string is treated as empty.
+    std::string_view string(uint32_t offset, uint32_t length) const {
+        if (offset > poolSize_ || length > poolSize_ - offset) {
+            return {};
+        }
+        return {pool_ + offset, length};
+    }
+
+    fs::FileView file_;
+    std::string buffer_;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    uint32_t numLanguages_ = 0;
+    uint32_t numKeys_ = 0;
+    uint32_t numPostings_ = 0;
+    uint32_t numValues_ = 0;
+    const char *languages_ = nullptr;
+    const char *keys_ = nullptr;
+    const char *postings_ = nullptr;
+    const char *values_ = nullptr;
+    const char *pool_ = nullptr;
+    size_t poolSize_ = 0;
+};
+
+namespace emoji {
+
+inline uint32_t readInt32(const uint8_t **data, const uint8_t *end) {
+    if (*data + 4 > end) {
+        throw std::runtime_error("Unknown emoji dict data");
+    }
+    uint32_t n = FromLittleEndian32(*data);
+    *data += 4;
+    return n;
+}
+
+inline std::string_view readString(const uint8_t **data, const uint8_t *end) {
+    uint32_t length = readInt32(data, end);
+    if (*data + length > end) {
+        throw std::runtime_error("Unknown emoji dict data");
+    }
+    std::string_view s(reinterpret_cast<const char *>(*data), length);
+    *data += length;
+    return s;
+}
+
+inline void appendInt32(std::string &buffer, uint32_t value) {
+    value = htole32(value);
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Annotation to emojis of a single language.
+using EmojiDict = std::map<std::string, std::vector<std::string>>;
+
+/**
+ * Read the zlib compressed emoji dictionary.
+ *
+ * Return false if the dictionary is not valid.
+ */
+inline bool readEmojiDict(int fd, EmojiDict &emojiMap) {
+    fs::FileView file(fd);
+    const auto size = file.size();
+    if (!file.isValid() || size < 4) {
+        return false;
+    }
+    const auto *compressed = reinterpret_cast<const uint8_t *>(file.data());
+    std::vector<uint8_t> data;
+    uint32_t expectedSize = FromLittleEndian32(compressed);
+    if (!expectedSize) {
+        return false;
+    }
+
+    data.resize(expectedSize);
+
+    unsigned long len = expectedSize;
+    if (::uncompress(data.data(), &len, compressed + 4, size - 4) !=
+        Z_OK) {
+        return false;
+    }
+
+    try {
+        const auto *cur = data.data();
+        const auto *end = data.data() + data.size();
+        uint32_t nEmoji = readInt32(&cur, end);
+        for (uint32_t i = 0; i < nEmoji; i++) {
+            std::string_view emoji = readString(&cur, end);
+            if (!utf8::validate(emoji)) {
+                throw std::runtime_error("Corrupted emoji data");
+            }
+            uint32_t nAnnotations = readInt32(&cur, end);
+            for (uint32_t j = 0; j < nAnnotations; j++) {
+                std::string_view annotation = readString(&cur, end);
+                auto &emojis = emojiMap[std::string(annotation)];
+                // Certain word has a very general meaning and has tons of
+                // matches, keep only 1 or 2 for specific.
+                if (emojis.empty() ||
+                    (emojis.size() == 1 && emojis[0] != emoji)) {
+                    emojis.push_back(std::string(emoji));
+                }
+            }
+        }
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Build the index content of the given languages.
+ */
+inline std::string
+buildEmojiIndex(const std::map<std::string, EmojiDict> &languages) {
+    // Each string is only stored once in the pool, and each emoji only has
+    // one value entry.
+    std::string pool;
+    std::map<std::string_view, uint32_t> stringOffsets;
+    std::map<std::string_view, uint32_t> valueIndexes;
+    std::string languageTable;
+    std::string keyTable;
+    std::string postingTable;
+    std::string valueTable;
+    uint32_t numKeys = 0;
+    uint32_t numPostings = 0;
+    auto addString = [&pool, &stringOffsets](std::string_view str) {
+        auto iter = stringOffsets.find(str);
+        if (iter == stringOffsets.end()) {
+            uint32_t offset = pool.size();
+            pool.append(str);
+            iter = stringOffsets.emplace(str, offset).first;
+        }
+        return iter->second;
+    };
+    for (const auto &[name, emojiMap] : languages) {
+        appendInt32(languageTable, addString(name));
+        appendInt32(languageTable, name.size());
+        appendInt32(languageTable, numKeys);
+        appendInt32(languageTable, emojiMap.size());
+        for (const auto &[key, emojis] : emojiMap) {
+            appendInt32(keyTable, addString(key));
+            appendInt32(keyTable, key.size());
+            appendInt32(keyTable, numPostings);
+            appendInt32(keyTable, emojis.size());
+            for (const auto &emoji : emojis) {
+                auto iter = valueIndexes.find(emoji);
+                if (iter == valueIndexes.end()) {
+                    iter = valueIndexes.emplace(emoji, valueIndexes.size())
+                               .first;
+                    appendInt32(valueTable, addString(emoji));
+                    appendInt32(valueTable, emoji.size());
+                }
+                appendInt32(postingTable, iter->second);
+                numPostings++;
+            }
+            numKeys++;
+        }
+    }
+
+    std::string result(EmojiIndex::magic, sizeof(EmojiIndex::magic));
+    appendInt32(result, languages.size());
+    appendInt32(result, numKeys);
+    appendInt32(result, numPostings);
+    appendInt32(result, valueIndexes.size());
+    result.append(languageTable);
+    result.append(keyTable);
+    result.append(postingTable);
+    result.append(valueTable);
+    result.append(pool);
+    return result;
+}
+
+} // namespace emoji
+
+} // namespace fcitx
+
+#endif // _FCITX5_MODULES_EMOJI_EMOJIINDEX_H_
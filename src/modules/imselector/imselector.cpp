@@ -40,10 +40,10 @@ bool selectInputMethod(InputContext *ic, IMSelector *imSelector, size_t index,
 
 class IMSelectorCandidateWord : public CandidateWord {
 public:
-    IMSelectorCandidateWord(IMSelector *q, const InputMethodEntry *entry,
-                            bool local)
-        : CandidateWord(Text(entry->name())), q_(q),
-          uniqueName_(entry->uniqueName()), local_(local) {}
+    IMSelectorCandidateWord(IMSelector *q, const std::string &name,
+                            std::string uniqueName, bool local)
+        : CandidateWord(Text(name)), q_(q), uniqueName_(std::move(uniqueName)),
+          local_(local) {}
 
     void select(InputContext *ic) const override {
         selectInputMethod(ic, q_, uniqueName_, local_);
@@ -64,12 +64,16 @@ IMSelector::IMSelector(Instance *instance)
             if (keyEvent.isRelease()) {
                 return;
             }
-            if (keyEvent.key().checkKeyList(config_.triggerKey.value()) &&
+            const auto match = hotkeyMatcher_.match(keyEvent.key());
+            if (!match) {
+                return;
+            }
+            if ((match & (1ULL << HotkeyGroup::Trigger)) &&
                 trigger(keyEvent.inputContext(), false)) {
                 keyEvent.filterAndAccept();
                 return;
             }
-            if (keyEvent.key().checkKeyList(config_.triggerKeyLocal.value()) &&
+            if ((match & (1ULL << HotkeyGroup::TriggerLocal)) &&
                 trigger(keyEvent.inputContext(), true)) {
                 keyEvent.filterAndAccept();
                 return;
@@ -82,6 +86,12 @@ IMSelector::IMSelector(Instance *instance)
         [this](Event &event) {
             auto &keyEvent = static_cast<KeyEvent &>(event);
             auto *inputContext = keyEvent.inputContext();
+            // Index is only looked up if the key is known to be in the list.
+            const auto match = hotkeyMatcher_.match(keyEvent.key());
+            if (!(match & ((1ULL << HotkeyGroup::Switch) |
+                           (1ULL << HotkeyGroup::SwitchLocal)))) {
+                return;
+            }
             if (int index =
                     keyEvent.key().keyListIndex(config_.switchKey.value());
                 index >= 0 &&
@@ -105,6 +115,9 @@ IMSelector::IMSelector(Instance *instance)
             state->reset(icEvent.inputContext());
         }
     };
+    eventHandlers_.emplace_back(instance_->watchEvent(
+        EventType::InputMethodGroupChanged, EventWatcherPhase::Default,
+        [this](Event &) { inputMethods_.reset(); }));
     eventHandlers_.emplace_back(instance_->watchEvent(
         EventType::InputContextFocusOut, EventWatcherPhase::Default, reset));
     eventHandlers_.emplace_back(instance_->watchEvent(
@@ -203,6 +216,7 @@ IMSelector::IMSelector(Instance *instance)
             }
         }));
 
+    factory_.setCreateOnDemand(true);
     instance_->inputContextManager().registerProperty("imselector", &factory_);
 
     std::array<KeySym, 10> syms = {
@@ -217,11 +231,35 @@ IMSelector::IMSelector(Instance *instance)
     reloadConfig();
 }
 
-void IMSelector::reloadConfig() { readAsIni(config_, "conf/imselector.conf"); }
+void IMSelector::reloadConfig() {
+    readAsIni(config_, "conf/imselector.conf");
+    updateHotkeyMatcher();
+}
+
+void IMSelector::updateHotkeyMatcher() {
+    hotkeyMatcher_.clear();
+    hotkeyMatcher_.addKeys(HotkeyGroup::Trigger, *config_.triggerKey);
+    hotkeyMatcher_.addKeys(HotkeyGroup::TriggerLocal, *config_.triggerKeyLocal);
+    hotkeyMatcher_.addKeys(HotkeyGroup::Switch, *config_.switchKey);
+    hotkeyMatcher_.addKeys(HotkeyGroup::SwitchLocal, *config_.switchKeyLocal);
+}
+
+const std::vector<std::pair<std::string, std::string>> &
+IMSelector::inputMethods() {
+    if (!inputMethods_) {
+        auto &imManager = instance_->inputMethodManager();
+        auto &inputMethods = inputMethods_.emplace();
+        for (const auto &item : imManager.currentGroup().inputMethodList()) {
+            if (const auto *entry = imManager.entry(item.name())) {
+                inputMethods.emplace_back(entry->name(), entry->uniqueName());
+            }
+        }
+    }
+    return *inputMethods_;
+}
 
 bool IMSelector::trigger(InputContext *inputContext, bool local) {
-    const auto &list =
-        instance_->inputMethodManager().currentGroup().inputMethodList();
+    const auto &list = inputMethods();
     if (list.empty()) {
         return false;
     }
@@ -232,14 +270,12 @@ bool IMSelector::trigger(InputContext *inputContext, bool local) {
     auto candidateList = std::make_unique<CommonCandidateList>();
     candidateList->setPageSize(10);
     int idx = -1;
-    for (const auto &item : list) {
-        if (const auto *entry =
-                instance_->inputMethodManager().entry(item.name())) {
-            if (entry->uniqueName() == currentIM) {
-                idx = candidateList->totalSize();
-            }
-            candidateList->append<IMSelectorCandidateWord>(this, entry, local);
+    for (const auto &[name, uniqueName] : list) {
+        if (uniqueName == currentIM) {
+            idx = candidateList->totalSize();
         }
+        candidateList->append<IMSelectorCandidateWord>(this, name, uniqueName,
+                                                       local);
     }
     candidateList->setLayoutHint(CandidateLayoutHint::Vertical);
     candidateList->setSelectionKey(selectionKeys_);
@@ -7,10 +7,15 @@
 #ifndef _FCITX5_MODULES_IMSELECTOR_IMSELECTOR_H_
 #define _FCITX5_MODULES_IMSELECTOR_IMSELECTOR_H_
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/iniparser.h"
 #include "fcitx-config/option.h"
 #include "fcitx-utils/i18n.h"
+#include "fcitx-utils/key.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/inputpanel.h"
 #include "fcitx/instance.h"
@@ -77,6 +82,7 @@ public:
     void setConfig(const RawConfig &config) override {
         config_.load(config, true);
         safeSaveAsIni(config_, "conf/imselector.conf");
+        updateHotkeyMatcher();
     }
     auto &factory() { return factory_; }
 
@@ -84,10 +90,19 @@ public:
     bool trigger(InputContext *inputContext, bool local);
 
 private:
+    enum HotkeyGroup { Trigger, TriggerLocal, Switch, SwitchLocal };
+
+    void updateHotkeyMatcher();
+    // Name and unique name of input methods in current group.
+    const std::vector<std::pair<std::string, std::string>> &inputMethods();
+
     std::vector<std::unique_ptr<fcitx::HandlerTableEntry<fcitx::EventHandler>>>
         eventHandlers_;
     Instance *instance_;
     IMSelectorConfig config_;
+    KeyMatcher hotkeyMatcher_;
+    std::optional<std::vector<std::pair<std::string, std::string>>>
+        inputMethods_;
     KeyList selectionKeys_;
     FactoryFor<IMSelectorState> factory_;
 };
@@ -5,6 +5,7 @@
  *
  */
 #include "dbusmenu.h"
+#include <algorithm>
 #include "fcitx/action.h"
 #include "fcitx/inputcontext.h"
 #include "fcitx/inputmethodentry.h"
@@ -42,6 +43,9 @@ enum BuiltInIndex {
 
 constexpr static int builtInIds = BII_Last;
 
+// Number of different GetLayout requests to keep for one revision.
+constexpr static size_t maxLayoutCacheSize = 16;
+
 DBusMenu::DBusMenu(NotificationItem *item) : parent_(item) {}
 
 DBusMenu::~DBusMenu() = default;
@@ -226,6 +230,25 @@ void DBusMenu::fillLayoutItem(
 void DBusMenu::fillLayoutProperties(
     int32_t id, const std::unordered_set<std::string> &propertyNames,
     DBusMenuProperties &properties) {
+    for (const auto &property : cachedProperties(id)) {
+        appendProperty(properties, propertyNames, property.key(),
+                       property.value());
+    }
+}
+
+const DBusMenu::DBusMenuProperties &DBusMenu::cachedProperties(int32_t id) {
+    checkCache();
+    auto iter = propertiesCache_.find(id);
+    if (iter == propertiesCache_.end()) {
+        iter = propertiesCache_.emplace(id, DBusMenuProperties()).first;
+        computeProperties(id, iter->second);
+    }
+    return iter->second;
+}
+
+void DBusMenu::computeProperties(int32_t id, DBusMenuProperties &properties) {
+    // All properties are computed, and filtered by fillLayoutProperties.
+    const std::unordered_set<std::string> propertyNames;
     if (id < 0) {
         return;
     }
@@ -350,11 +373,31 @@ void DBusMenu::fillLayoutProperties(
     }
 }
 
-dbus::Variant DBusMenu::getProperty(int32_t, const std::string &) {
-    // TODO implement this, document said this only for debug so we ignore
-    // it for now
-    throw dbus::MethodCallError("org.freedesktop.DBus.Error.NotSupported",
-                                "NotSupported");
+dbus::Variant DBusMenu::getProperty(int32_t id, const std::string &name) {
+    for (const auto &property : cachedProperties(id)) {
+        if (property.key() == name) {
+            return property.value();
+        }
+    }
+    throw dbus::MethodCallError("org.freedesktop.DBus.Error.InvalidArgs",
+                                "Unknown property");
+}
+
+void DBusMenu::checkCache() {
+    auto *ic = lastRelevantIc();
+    if (cacheRevision_ == revision_ && cacheHasIc_ == !!ic &&
+        cacheIc_.get() == ic) {
+        return;
+    }
+    cacheRevision_ = revision_;
+    cacheHasIc_ = !!ic;
+    if (ic) {
+        cacheIc_ = ic->watch();
+    } else {
+        cacheIc_.unwatch();
+    }
+    layoutCache_.clear();
+    propertiesCache_.clear();
 }
 
 std::tuple<uint32_t, DBusMenu::DBusMenuLayout>
@@ -368,9 +411,28 @@ DBusMenu::getLayout(int parentId, int recursionDepth,
         "Type not same as signature.");
 
     std::get<0>(result) = revision_;
-    std::unordered_set<std::string> properties(propertyNames.begin(),
-                                               propertyNames.end());
-    fillLayoutItem(parentId, recursionDepth, properties, std::get<1>(result));
+    checkCache();
+    std::vector<std::string> sortedNames = propertyNames;
+    std::sort(sortedNames.begin(), sortedNames.end());
+    auto key =
+        std::make_tuple(parentId, recursionDepth, std::move(sortedNames));
+    auto iter = layoutCache_.find(key);
+    if (iter == layoutCache_.end()) {
+        if (layoutCache_.size() >= maxLayoutCacheSize) {
+            layoutCache_.clear();
+        }
+        CachedLayout cached;
+        std::unordered_set<std::string> properties(propertyNames.begin(),
+                                                   propertyNames.end());
+        // Collect the menus requested by this layout only.
+        std::swap(cached.requestedMenus, requestedMenus_);
+        fillLayoutItem(parentId, recursionDepth, properties, cached.layout);
+        std::swap(cached.requestedMenus, requestedMenus_);
+        iter = layoutCache_.emplace(std::move(key), std::move(cached)).first;
+    }
+    requestedMenus_.insert(iter->second.requestedMenus.begin(),
+                           iter->second.requestedMenus.end());
+    std::get<1>(result) = iter->second.layout;
     return result;
 }
 
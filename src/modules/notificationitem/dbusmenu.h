@@ -7,6 +7,9 @@
 #ifndef _FCITX_MODULES_NOTIFICATIONITEM_DBUSMENU_H_
 #define _FCITX_MODULES_NOTIFICATIONITEM_DBUSMENU_H_
 
+#include <map>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include "fcitx-utils/dbus/message.h"
 #include "fcitx-utils/dbus/objectvtable.h"
@@ -38,7 +41,7 @@ public:
 private:
     void event(int32_t id, const std::string &type, const dbus::Variant &,
                uint32_t);
-    static dbus::Variant getProperty(int32_t, const std::string &);
+    dbus::Variant getProperty(int32_t id, const std::string &name);
     std::tuple<uint32_t, DBusMenuLayout>
     getLayout(int parentId, int recursionDepth,
               const std::vector<std::string> &propertyNames);
@@ -57,6 +60,10 @@ private:
     fillLayoutProperties(int32_t id,
                          const std::unordered_set<std::string> &propertyNames,
                          DBusMenuProperties &properties);
+    void computeProperties(int32_t id, DBusMenuProperties &properties);
+    const DBusMenuProperties &cachedProperties(int32_t id);
+    // Drop cached layout and properties if they are out of date.
+    void checkCache();
 
     std::vector<dbus::DBusStruct<int32_t, DBusMenuProperties>>
     getGroupProperties(const std::vector<int32_t> &ids,
@@ -105,6 +112,20 @@ private:
     // behavior. KDE/GNOME ones are ok sending Event(opened/closed) to the top
     // level menu.
     bool sendEventToTopLevel_ = false;
+
+    struct CachedLayout {
+        DBusMenuLayout layout;
+        // Menus that are marked as requested when the layout is built.
+        std::unordered_set<int32_t> requestedMenus;
+    };
+    // Layout and properties built for the revision and input context, keyed
+    // by parent id, recursion depth and sorted property names.
+    uint32_t cacheRevision_ = 0;
+    TrackableObjectReference<InputContext> cacheIc_;
+    bool cacheHasIc_ = false;
+    std::map<std::tuple<int32_t, int, std::vector<std::string>>, CachedLayout>
+        layoutCache_;
+    std::unordered_map<int32_t, DBusMenuProperties> propertiesCache_;
 };
 
 } // namespace fcitx
@@ -30,6 +30,9 @@ FCITX_DEFINE_LOG_CATEGORY(notificationitem, "notificationitem");
 
 namespace fcitx {
 
+// Delay of NewIcon after icon may be changed, in microseconds.
+constexpr uint64_t newIconDelay = 50000;
+
 class StatusNotifierItem : public dbus::ObjectVTable<StatusNotifierItem> {
 public:
     StatusNotifierItem(NotificationItem *parent) : parent_(parent) {}
@@ -384,6 +387,7 @@ void NotificationItem::disable() {
 
 void NotificationItem::cleanUp() {
     pendingRegisterCall_.reset();
+    pendingNewIcon_.reset();
     sni_->reset();
     menu_->reset();
     privateBus_.reset();
@@ -401,7 +405,23 @@ void NotificationItem::newIcon() {
     if (!sni_->isRegistered()) {
         return;
     }
-    sni_->notifyNewIcon();
+    // Coalesce the changes within a short time, e.g. switching focus fast,
+    // the signal is only sent if the icon is really changed after that.
+    if (pendingNewIcon_) {
+        if (!pendingNewIcon_->isEnabled()) {
+            pendingNewIcon_->setNextInterval(newIconDelay);
+            pendingNewIcon_->setOneShot();
+        }
+        return;
+    }
+    pendingNewIcon_ = instance_->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + newIconDelay, 0,
+        [this](EventSourceTime *, uint64_t) {
+            if (sni_->isRegistered()) {
+                sni_->notifyNewIcon();
+            }
+            return true;
+        });
     // Our label now is pixmap based, so no need to notify XAyatanaNewLabel.
     // sni_->xayatanaNewLabel(sni_->label(), sni_->label());
 }
@@ -63,6 +63,7 @@ private:
     bool enabled_ = false;
     bool registered_ = false;
     std::unique_ptr<EventSourceTime> scheduleRegister_;
+    std::unique_ptr<EventSourceTime> pendingNewIcon_;
     HandlerTable<NotificationItemCallback> handlers_;
 };
 
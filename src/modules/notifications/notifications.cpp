@@ -8,6 +8,7 @@
 
 #include "notifications.h"
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addonmanager.h"
@@ -20,6 +21,15 @@
 
 namespace fcitx {
 
+namespace {
+
+// Notify calls without reply, new notifications are dropped beyond this.
+constexpr size_t maxPendingCalls = 16;
+// Same tip within this time is ignored, in microseconds.
+constexpr uint64_t tipDedupWindow = 1000000;
+
+} // namespace
+
 Notifications::Notifications(Instance *instance)
     : instance_(instance), dbus_(instance_->addonManager().addon("dbus")),
       bus_(dbus_->call<IDBusModule::bus>()), watcher_(*bus_) {
@@ -128,6 +138,10 @@ void Notifications::closeNotification(uint64_t internalId) {
             message << item->globalId_;
             message.send();
         }
+        // Do not wait for the reply to replace it anymore.
+        if (auto *next = find(item->replacedBy_)) {
+            notify(*next, 0);
+        }
         removeItem(*item);
     }
 }
@@ -138,25 +152,12 @@ uint32_t Notifications::sendNotification(
     const std::vector<std::string> &actions, int32_t timeout,
     NotificationActionCallback actionCallback,
     NotificationClosedCallback closedCallback) {
-    auto message =
-        bus_->createMethodCall(NOTIFICATIONS_SERVICE_NAME, NOTIFICATIONS_PATH,
-                               NOTIFICATIONS_INTERFACE_NAME, "Notify");
     auto *replaceItem = find(replaceId);
-    if (!replaceItem) {
-        replaceId = 0;
-    } else {
-        replaceId = replaceItem->globalId_;
-        removeItem(*replaceItem);
+    if (!replaceItem && pendingCalls() >= maxPendingCalls) {
+        FCITX_DEBUG() << "Too many pending notifications, drop: " << summary;
+        return 0;
     }
 
-    message << appName << replaceId << IconTheme::iconName(appIcon) << summary
-            << body;
-    message << actions;
-    message << dbus::Container(dbus::Container::Type::Array,
-                               dbus::Signature("{sv}"));
-    message << dbus::ContainerEnd();
-    message << timeout;
-
     internalId_++;
     auto result = items_.emplace(
         std::piecewise_construct, std::forward_as_tuple(internalId_),
@@ -165,29 +166,98 @@ uint32_t Notifications::sendNotification(
         return 0;
     }
 
-    int internalId = internalId_;
     auto &item = result.first->second;
-    item.slot_ =
-        message.callAsync(0, [this, internalId](dbus::Message &message) {
-            auto *item = find(internalId);
-            if (!item) {
-                return true;
-            }
-            if (message.isError()) {
-                removeItem(*item);
-                return true;
-            }
-            uint32_t globalId;
-            if (!(message >> globalId)) {
-                return true;
+    item.message_ = [this, appName, icon = IconTheme::iconName(appIcon),
+                     summary, body, actions, timeout](uint32_t replaceId) {
+        auto message = bus_->createMethodCall(
+            NOTIFICATIONS_SERVICE_NAME, NOTIFICATIONS_PATH,
+            NOTIFICATIONS_INTERFACE_NAME, "Notify");
+        message << appName << replaceId << icon << summary << body;
+        message << actions;
+        message << dbus::Container(dbus::Container::Type::Array,
+                                   dbus::Signature("{sv}"));
+        message << dbus::ContainerEnd();
+        message << timeout;
+        return message;
+    };
+
+    if (!replaceItem) {
+        notify(item, 0);
+    } else if (!replaceItem->globalId_) {
+        // Global id is not known yet, send after the reply. If there is
+        // already one waiting, it is never shown.
+        if (replaceItem->message_) {
+            for (auto &[id, pending] : items_) {
+                if (pending.replacedBy_ == replaceItem->internalId_) {
+                    replaceItem = &pending;
+                    break;
+                }
             }
-            item->globalId_ = globalId;
-            globalToInternalId_[globalId] = internalId;
-            item->slot_.reset();
+        }
+        if (auto *waiting = find(replaceItem->replacedBy_)) {
+            removeItem(*waiting);
+        }
+        replaceItem->replacedBy_ = internalId_;
+    } else {
+        notify(item, replaceItem->globalId_);
+        removeItem(*replaceItem);
+    }
+
+    return internalId_;
+}
+
+void Notifications::notify(NotificationItem &item, uint32_t replaceId) {
+    auto message = item.message_(replaceId);
+    item.message_ = nullptr;
+    item.slot_ = message.callAsync(
+        0, [this, internalId = item.internalId_](dbus::Message &reply) {
+            handleNotifyReply(internalId, reply);
             return true;
         });
+}
+
+void Notifications::handleNotifyReply(uint64_t internalId,
+                                      dbus::Message &message) {
+    auto *item = find(internalId);
+    if (!item) {
+        return;
+    }
+    // Keep the slot alive until the callback returns.
+    auto slot = std::move(item->slot_);
+    uint32_t globalId = 0;
+    if (message.isError() || !(message >> globalId)) {
+        globalId = 0;
+    }
+    if (item->replacedBy_) {
+        if (auto *next = find(item->replacedBy_)) {
+            notify(*next, globalId);
+        } else if (globalId) {
+            // The replacement is closed before it is sent.
+            auto close = bus_->createMethodCall(
+                NOTIFICATIONS_SERVICE_NAME, NOTIFICATIONS_PATH,
+                NOTIFICATIONS_INTERFACE_NAME, "CloseNotification");
+            close << globalId;
+            close.send();
+        }
+        removeItem(*item);
+        return;
+    }
+    if (!globalId) {
+        removeItem(*item);
+        return;
+    }
+    item->globalId_ = globalId;
+    globalToInternalId_[globalId] = internalId;
+}
 
-    return internalId;
+size_t Notifications::pendingCalls() const {
+    size_t count = 0;
+    for (const auto &[internalId, item] : items_) {
+        if (item.slot_) {
+            count++;
+        }
+    }
+    return count;
 }
 
 void Notifications::showTip(const std::string &tipId,
@@ -198,6 +268,20 @@ void Notifications::showTip(const std::string &tipId,
     if (hiddenNotifications_.count(tipId)) {
         return;
     }
+    // Same tip is still shown, no need to send it again.
+    std::string tip = tipId;
+    for (const auto *part : {&summary, &body}) {
+        tip.push_back('\0');
+        tip.append(*part);
+    }
+    auto current = now(CLOCK_MONOTONIC);
+    if (tip == lastTip_ && current < lastTipTime_ + tipDedupWindow &&
+        find(lastTipId_)) {
+        return;
+    }
+    lastTip_ = std::move(tip);
+    lastTipTime_ = current;
+
     std::vector<std::string> actions = {"dont-show", _("Do not show again")};
     if (!capabilities_.test(NotificationsCapability::Actions)) {
         actions.clear();
@@ -35,7 +35,13 @@ struct NotificationItem {
     uint64_t internalId_;
     NotificationActionCallback actionCallback_;
     NotificationClosedCallback closedCallback_;
+    // Pending Notify call.
     std::unique_ptr<dbus::Slot> slot_;
+    // Create the Notify call with the replace id.
+    std::function<dbus::Message(uint32_t)> message_;
+    // Notification that is waiting for the Notify reply of this one to
+    // replace it.
+    uint64_t replacedBy_ = 0;
 };
 
 class Notifications final : public AddonInstance {
@@ -93,6 +99,10 @@ private:
         items_.erase(item.internalId_);
     }
 
+    void notify(NotificationItem &item, uint32_t replaceId);
+    void handleNotifyReply(uint64_t internalId, dbus::Message &message);
+    size_t pendingCalls() const;
+
     NotificationsConfig config_;
     Instance *instance_;
     AddonInstance *dbus_;
@@ -107,6 +117,9 @@ private:
     std::unique_ptr<dbus::ServiceWatcherEntry> watcherEntry_;
 
     int lastTipId_ = 0;
+    // Tip id and content of the last tip, and when it is shown.
+    std::string lastTip_;
+    uint64_t lastTipTime_ = 0;
     uint64_t internalId_ = 0;
     uint64_t epoch_ = 0;
 
@@ -6,8 +6,14 @@
  */
 #include "quickphrase.h"
 
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/inputbuffer.h"
 #include "fcitx/addonfactory.h"
@@ -18,9 +24,13 @@
 
 namespace fcitx {
 
+using QuickPhraseCandidateData =
+    std::tuple<std::string, std::string, QuickPhraseAction>;
+
 class QuickPhraseState : public InputContextProperty {
 public:
     QuickPhraseState(QuickPhrase *q) : q_(q) { buffer_.setMaxSize(30); }
+    ~QuickPhraseState() { cancelQuery(); }
 
     bool enabled_ = false;
     InputBuffer buffer_;
@@ -33,7 +43,38 @@ public:
     std::string alt_;
     Key key_;
 
+    // Async query of queryInput_, a stale query has a different id.
+    uint64_t queryId_ = 0;
+    bool queryStarted_ = false;
+    std::string queryInput_;
+    size_t pendingQueries_ = 0;
+    // Candidates are not shown while waiting for async queries.
+    bool waiting_ = false;
+    std::vector<QuickPhraseCancelCallback> cancelQueries_;
+    std::vector<QuickPhraseCandidateData> asyncCandidates_;
+    std::unordered_set<std::string> asyncWords_;
+    std::unique_ptr<EventSourceTime> updateEvent_;
+
+    void cancelQuery() {
+        queryId_++;
+        queryStarted_ = false;
+        queryInput_.clear();
+        pendingQueries_ = 0;
+        waiting_ = false;
+        asyncCandidates_.clear();
+        asyncWords_.clear();
+        if (updateEvent_) {
+            updateEvent_->setEnabled(false);
+        }
+        auto cancels = std::move(cancelQueries_);
+        cancelQueries_.clear();
+        for (const auto &cancel : cancels) {
+            cancel();
+        }
+    }
+
     void reset(InputContext *ic) {
+        cancelQuery();
         enabled_ = false;
         typed_ = false;
         text_.clear();
@@ -52,6 +93,7 @@ public:
 QuickPhrase::QuickPhrase(Instance *instance)
     : instance_(instance), spellProvider_(this),
       factory_([this](InputContext &) { return new QuickPhraseState(this); }) {
+    factory_.setCreateOnDemand(true);
     instance_->inputContextManager().registerProperty("quickphraseState",
                                                       &factory_);
     eventHandlers_.emplace_back(instance_->watchEvent(
@@ -398,45 +440,56 @@ void QuickPhrase::updateUI(InputContext *inputContext) {
     auto *state = inputContext->propertyFor(&factory_);
     inputContext->inputPanel().reset();
     if (!state->buffer_.empty()) {
-        auto candidateList = std::make_unique<CommonCandidateList>();
-        candidateList->setCursorPositionAfterPaging(
-            CursorPositionAfterPaging::ResetToFirst);
-        candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
-        QuickPhraseProvider *providers[] = {&callbackProvider_,
-                                            &builtinProvider_, &spellProvider_};
+        const auto &userInput = state->buffer_.userInput();
+        if (!state->queryStarted_ || state->queryInput_ != userInput) {
+            startQuery(inputContext);
+        }
+    }
+    if (!state->buffer_.empty() && !state->waiting_) {
+        const auto &userInput = state->buffer_.userInput();
         QuickPhraseAction selectionKeyAction =
             QuickPhraseAction::DigitSelection;
         std::string autoCommit;
         bool autoCommitSet = false;
-        for (auto *provider : providers) {
-            if (!provider->populate(
-                    inputContext, state->buffer_.userInput(),
-                    [this, &candidateList, &selectionKeyAction, &autoCommit,
-                     &autoCommitSet](const std::string &word,
-                                     const std::string &aux,
-                                     QuickPhraseAction action) {
-                        if (!autoCommitSet &&
-                            action == QuickPhraseAction::AutoCommit) {
-                            autoCommit = word;
-                            autoCommitSet = true;
-                        }
+        auto collect = [&selectionKeyAction, &autoCommit, &autoCommitSet](
+                           std::vector<QuickPhraseCandidateData> &candidates) {
+            return [&candidates, &selectionKeyAction, &autoCommit,
+                    &autoCommitSet](const std::string &word,
+                                    const std::string &aux,
+                                    QuickPhraseAction action) {
+                if (!autoCommitSet && action == QuickPhraseAction::AutoCommit) {
+                    autoCommit = word;
+                    autoCommitSet = true;
+                }
 
-                        if (autoCommitSet) {
-                            return;
-                        }
-                        if (!word.empty()) {
-                            candidateList->append<QuickPhraseCandidateWord>(
-                                this, word, aux, action);
-                        } else {
-                            if (action == QuickPhraseAction::DigitSelection ||
-                                action == QuickPhraseAction::AlphaSelection ||
-                                action == QuickPhraseAction::NoneSelection) {
-                                selectionKeyAction = action;
-                            }
-                        }
-                    })) {
-                break;
-            }
+                if (autoCommitSet) {
+                    return;
+                }
+                if (!word.empty()) {
+                    candidates.emplace_back(word, aux, action);
+                } else {
+                    if (action == QuickPhraseAction::DigitSelection ||
+                        action == QuickPhraseAction::AlphaSelection ||
+                        action == QuickPhraseAction::NoneSelection) {
+                        selectionKeyAction = action;
+                    }
+                }
+            };
+        };
+
+        // Callback and spell only give a few candidates, and callback may
+        // change the selection key or auto commit, so they are collected
+        // first. Builtin phrases may have tens of thousands matches for a
+        // short input, so they are only created when shown.
+        std::vector<QuickPhraseCandidateData> callbackCandidates;
+        std::vector<QuickPhraseCandidateData> spellCandidates;
+        BuiltInQuickPhraseProvider::Matches builtinMatches;
+        if (callbackProvider_.populate(inputContext, userInput,
+                                       collect(callbackCandidates)) &&
+            !autoCommitSet) {
+            builtinMatches = builtinProvider_.matches(userInput);
+            spellProvider_.populate(inputContext, userInput,
+                                    collect(spellCandidates));
         }
 
         if (autoCommitSet) {
@@ -447,6 +500,59 @@ void QuickPhrase::updateUI(InputContext *inputContext) {
             return;
         }
 
+        // Async candidates that are already given by others are skipped.
+        std::unordered_set<std::string> words;
+        for (const auto &candidates : {&callbackCandidates, &spellCandidates}) {
+            for (const auto &candidate : *candidates) {
+                words.insert(std::get<0>(candidate));
+            }
+        }
+        std::vector<QuickPhraseCandidateData> asyncCandidates;
+        for (const auto &candidate : state->asyncCandidates_) {
+            if (!words.count(std::get<0>(candidate))) {
+                asyncCandidates.push_back(candidate);
+            }
+        }
+
+        auto candidateList = std::make_unique<LazyCandidateList>(
+            [this, callbackCandidates = std::move(callbackCandidates),
+             asyncCandidates = std::move(asyncCandidates),
+             builtinMatches = std::move(builtinMatches),
+             spellCandidates = std::move(spellCandidates),
+             callbackIndex = size_t(0), asyncIndex = size_t(0),
+             spellIndex = size_t(0)]() mutable
+            -> std::unique_ptr<CandidateWord> {
+                if (callbackIndex < callbackCandidates.size()) {
+                    auto &[word, aux, action] =
+                        callbackCandidates[callbackIndex++];
+                    return std::make_unique<QuickPhraseCandidateWord>(
+                        this, std::move(word), aux, action);
+                }
+                if (asyncIndex < asyncCandidates.size()) {
+                    auto &[word, aux, action] = asyncCandidates[asyncIndex++];
+                    return std::make_unique<QuickPhraseCandidateWord>(
+                        this, std::move(word), aux, action);
+                }
+                if (builtinMatches) {
+                    std::string word;
+                    std::string aux;
+                    if (builtinMatches(word, aux)) {
+                        return std::make_unique<QuickPhraseCandidateWord>(
+                            this, std::move(word), aux,
+                            QuickPhraseAction::Commit);
+                    }
+                    builtinMatches = nullptr;
+                }
+                if (spellIndex < spellCandidates.size()) {
+                    auto &[word, aux, action] = spellCandidates[spellIndex++];
+                    return std::make_unique<QuickPhraseCandidateWord>(
+                        this, std::move(word), aux, action);
+                }
+                return nullptr;
+            });
+        candidateList->setCursorPositionAfterPaging(
+            CursorPositionAfterPaging::ResetToFirst);
+        candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
         setSelectionKeys(selectionKeyAction);
         candidateList->setSelectionKey(selectionKeys_);
         if (!candidateList->empty()) {
@@ -490,6 +596,98 @@ QuickPhrase::addProvider(QuickPhraseProviderCallback callback) {
     return callbackProvider_.addCallback(std::move(callback));
 }
 
+std::unique_ptr<HandlerTableEntry<QuickPhraseAsyncProviderCallback>>
+QuickPhrase::addAsyncProvider(QuickPhraseAsyncProviderCallback callback) {
+    return asyncProvider_.addCallback(std::move(callback));
+}
+
+void QuickPhrase::startQuery(InputContext *inputContext) {
+    auto *state = inputContext->propertyFor(&factory_);
+    state->cancelQuery();
+    state->queryStarted_ = true;
+    state->queryInput_ = state->buffer_.userInput();
+    if (asyncProvider_.size() == 0) {
+        return;
+    }
+
+    const auto id = state->queryId_;
+    const auto latency = *config_.asyncLatency;
+    state->pendingQueries_ = asyncProvider_.size();
+    state->waiting_ = latency > 0;
+    auto addCandidate = [this, ref = inputContext->watch(),
+                         id](const std::string &word, const std::string &aux,
+                             QuickPhraseAction action) {
+        auto *ic = ref.get();
+        if (!ic) {
+            return;
+        }
+        auto *state = ic->propertyFor(&factory_);
+        // Only accept candidates that can be selected.
+        if (state->queryId_ != id || word.empty() ||
+            (action != QuickPhraseAction::Commit &&
+             action != QuickPhraseAction::TypeToBuffer &&
+             action != QuickPhraseAction::DoNothing)) {
+            return;
+        }
+        if (!state->asyncWords_.insert(word).second) {
+            return;
+        }
+        state->asyncCandidates_.emplace_back(word, aux, action);
+        if (!state->waiting_) {
+            scheduleUpdate(ic, 0);
+        }
+    };
+    auto done = [this, ref = inputContext->watch(), id]() {
+        auto *ic = ref.get();
+        if (!ic) {
+            return;
+        }
+        auto *state = ic->propertyFor(&factory_);
+        if (state->queryId_ != id || state->pendingQueries_ == 0) {
+            return;
+        }
+        state->pendingQueries_--;
+        if (state->pendingQueries_ == 0 && state->waiting_) {
+            state->waiting_ = false;
+            scheduleUpdate(ic, 0);
+        }
+    };
+    auto cancels = asyncProvider_.query(inputContext, state->queryInput_,
+                                        addCandidate, done);
+    if (state->queryId_ != id) {
+        // Already replaced by another query.
+        for (const auto &cancel : cancels) {
+            cancel();
+        }
+        return;
+    }
+    state->cancelQueries_ = std::move(cancels);
+    if (state->waiting_) {
+        scheduleUpdate(inputContext, latency * 1000ULL);
+    }
+}
+
+void QuickPhrase::scheduleUpdate(InputContext *inputContext, uint64_t usec) {
+    auto *state = inputContext->propertyFor(&factory_);
+    if (state->updateEvent_) {
+        state->updateEvent_->setNextInterval(usec);
+        state->updateEvent_->setOneShot();
+        return;
+    }
+    state->updateEvent_ = instance_->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + usec, 0,
+        [this, ref = inputContext->watch()](EventSourceTime *, uint64_t) {
+            if (auto *ic = ref.get()) {
+                auto *state = ic->propertyFor(&factory_);
+                state->waiting_ = false;
+                if (state->enabled_) {
+                    updateUI(ic);
+                }
+            }
+            return true;
+        });
+}
+
 void QuickPhrase::trigger(InputContext *ic, const std::string &text,
                           const std::string &prefix, const std::string &str,
                           const std::string &alt, const Key &key) {
@@ -40,6 +40,10 @@ FCITX_CONFIGURATION(
     Option<std::string> fallbackSpellLanguage{
         this, "FallbackSpellLanguage", _("Fallback Spell check language"),
         "en"};
+    Option<int, IntConstrain> asyncLatency{
+        this, "AsyncLatency",
+        _("Time to wait for asynchronous candidates before showing (ms)"), 50,
+        IntConstrain(0, 1000)};
     ExternalOption editor{this, "Editor", _("Editor"),
                           "fcitx://config/addon/quickphrase/editor"};);
 
@@ -75,13 +79,19 @@ public:
 
     std::unique_ptr<HandlerTableEntry<QuickPhraseProviderCallback>>
         addProvider(QuickPhraseProviderCallback);
+    std::unique_ptr<HandlerTableEntry<QuickPhraseAsyncProviderCallback>>
+        addAsyncProvider(QuickPhraseAsyncProviderCallback);
 
 private:
     FCITX_ADDON_EXPORT_FUNCTION(QuickPhrase, trigger);
     FCITX_ADDON_EXPORT_FUNCTION(QuickPhrase, addProvider);
     FCITX_ADDON_EXPORT_FUNCTION(QuickPhrase, setBuffer);
+    FCITX_ADDON_EXPORT_FUNCTION(QuickPhrase, addAsyncProvider);
 
     void setSelectionKeys(QuickPhraseAction action);
+    // Cancel the previous async query and start one for the current input.
+    void startQuery(InputContext *inputContext);
+    void scheduleUpdate(InputContext *inputContext, uint64_t usec);
 
     QuickPhraseConfig config_;
     Instance *instance_;
@@ -92,6 +102,7 @@ private:
     CallbackQuickPhraseProvider callbackProvider_;
     BuiltInQuickPhraseProvider builtinProvider_;
     SpellQuickPhraseProvider spellProvider_;
+    AsyncQuickPhraseProvider asyncProvider_;
     FactoryFor<QuickPhraseState> factory_;
 };
 } // namespace fcitx
@@ -32,6 +32,31 @@ using QuickPhraseProviderCallback =
     std::function<bool(InputContext *ic, const std::string &,
                        const QuickPhraseAddCandidateCallback &)>;
 
+/**
+ * Called when an async query is not needed anymore, e.g. the input changed.
+ *
+ * @since 5.1.12
+ */
+using QuickPhraseCancelCallback = std::function<void()>;
+
+/**
+ * Start an async query for the input.
+ *
+ * Candidates can be added with addCandidate from the main thread at any time
+ * later, and done need to be called once there will be no more candidate.
+ * Once the query is stale, calling addCandidate or done has no effect.
+ *
+ * Return a callback to cancel the query, or an empty one if it is not
+ * needed.
+ *
+ * @since 5.1.12
+ */
+using QuickPhraseAsyncProviderCallback =
+    std::function<QuickPhraseCancelCallback(
+        InputContext *ic, const std::string &input,
+        QuickPhraseAddCandidateCallback addCandidate,
+        std::function<void()> done)>;
+
 } // namespace fcitx
 
 /// Trigger quickphrase, with following format:
@@ -49,4 +74,19 @@ FCITX_ADDON_DECLARE_FUNCTION(
     std::unique_ptr<HandlerTableEntry<QuickPhraseProviderCallback>>(
         QuickPhraseProviderCallback));
 
+/**
+ * Add a provider that returns the candidates asynchronously.
+ *
+ * Async candidates are shown after the candidates of the sync providers, and
+ * the ones with the same text are only shown once. Candidates are not shown
+ * until all async providers finish, or after the latency configured in
+ * quickphrase, after which async candidates are merged as they come.
+ *
+ * @since 5.1.12
+ */
+FCITX_ADDON_DECLARE_FUNCTION(
+    QuickPhrase, addAsyncProvider,
+    std::unique_ptr<HandlerTableEntry<QuickPhraseAsyncProviderCallback>>(
+        QuickPhraseAsyncProviderCallback));
+
 #endif // _FCITX_MODULES_QUICKPHRASE_QUICKPHRASE_PUBLIC_H_
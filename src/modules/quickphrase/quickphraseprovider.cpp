@@ -6,10 +6,14 @@
  */
 #include "quickphraseprovider.h"
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <fcitx-utils/utf8.h>
 #include <fcitx/inputmethodentry.h>
 #include "fcitx-utils/fs.h"
@@ -24,48 +28,152 @@
 
 namespace fcitx {
 
+namespace {
+
+uint64_t modifiedTime(const struct stat &stats) {
+    return static_cast<uint64_t>(stats.st_mtim.tv_sec) * 1000000000ULL +
+           stats.st_mtim.tv_nsec;
+}
+
+} // namespace
+
 bool BuiltInQuickPhraseProvider::populate(
     InputContext *, const std::string &userInput,
     const QuickPhraseAddCandidateCallback &addCandidate) {
-    auto start = map_.lower_bound(userInput);
-    auto end = map_.end();
+    auto next = matches(userInput);
+    std::string word;
+    std::string aux;
+    while (next(word, aux)) {
+        addCandidate(word, aux, QuickPhraseAction::Commit);
+    }
+    return true;
+}
 
-    for (; start != end; start++) {
-        if (!stringutils::startsWith(start->first, userInput)) {
-            break;
+BuiltInQuickPhraseProvider::Matches
+BuiltInQuickPhraseProvider::matches(const std::string &userInput) const {
+    // Range of matching phrases in each file.
+    struct Range {
+        std::shared_ptr<const QuickPhraseStore> store;
+        size_t current;
+        size_t end;
+    };
+    std::vector<Range> ranges;
+    for (const auto &[path, store] : stores_) {
+        auto start = store->lowerBound(userInput);
+        auto end = start;
+        while (end < store->size() &&
+               stringutils::startsWith(store->key(end), userInput)) {
+            end++;
+        }
+        if (start != end) {
+            ranges.push_back({store, start, end});
         }
-        addCandidate(start->second,
-                     stringutils::concat(start->second, " ",
-                                         start->first.substr(userInput.size())),
-                     QuickPhraseAction::Commit);
     }
-    return true;
+
+    // Merge the matches of all files by key, for the same key, phrases from
+    // the file loaded first come first.
+    return [ranges = std::move(ranges), prefixLength = userInput.size()](
+               std::string &word, std::string &aux) mutable {
+        Range *best = nullptr;
+        for (auto &range : ranges) {
+            if (range.current == range.end) {
+                continue;
+            }
+            if (!best || range.store->key(range.current) <
+                             best->store->key(best->current)) {
+                best = &range;
+            }
+        }
+        if (!best) {
+            return false;
+        }
+        auto index = best->current++;
+        auto key = best->store->key(index);
+        auto value = best->store->value(index);
+        word = value;
+        aux = stringutils::concat(value, " ", key.substr(prefixLength));
+        return true;
+    };
 }
-void BuiltInQuickPhraseProvider::reloadConfig() {
 
-    map_.clear();
-    if (auto file = StandardPath::global().open(
-            StandardPath::Type::PkgData, "data/QuickPhrase.mb", O_RDONLY);
-        file.fd() >= 0) {
-        load(fs::openFD(file, "rb"));
+void BuiltInQuickPhraseProvider::reloadConfig() {
+    // Name of the cache and the path of the phrase file.
+    std::vector<std::pair<std::string, std::string>> files;
+    auto mainFile = StandardPath::global().locate(StandardPath::Type::PkgData,
+                                                  "data/QuickPhrase.mb");
+    if (!mainFile.empty()) {
+        files.emplace_back("QuickPhrase.mb", std::move(mainFile));
     }
 
-    auto files = StandardPath::global().locate(StandardPath::Type::PkgData,
-                                               "data/quickphrase.d/",
-                                               filter::Suffix(".mb"));
+    auto phraseFiles = StandardPath::global().locate(
+        StandardPath::Type::PkgData, "data/quickphrase.d/",
+        filter::Suffix(".mb"));
     auto disableFiles = StandardPath::global().locate(
         StandardPath::Type::PkgData, "data/quickphrase.d/",
         filter::Suffix(".mb.disable"));
-    for (auto &p : files) {
+    for (auto &p : phraseFiles) {
         if (disableFiles.count(stringutils::concat(p.first, ".disable"))) {
             continue;
         }
-        UnixFD fd = UnixFD::own(open(p.second.c_str(), O_RDONLY));
-        load(fs::openFD(fd, "rb"));
+        files.emplace_back(stringutils::concat("quickphrase.d/", p.first),
+                           std::move(p.second));
+    }
+
+    // Files that are not changed are kept as is.
+    std::unordered_map<std::string, std::shared_ptr<const QuickPhraseStore>>
+        oldStores;
+    for (auto &[path, store] : stores_) {
+        oldStores.emplace(path, std::move(store));
+    }
+    stores_.clear();
+    for (const auto &[name, path] : files) {
+        UnixFD fd = UnixFD::own(open(path.c_str(), O_RDONLY));
+        struct stat stats;
+        if (!fd.isValid() || fstat(fd.fd(), &stats) != 0) {
+            continue;
+        }
+        auto mtime = modifiedTime(stats);
+        if (auto iter = oldStores.find(path);
+            iter != oldStores.end() &&
+            iter->second->matches(mtime, stats.st_size)) {
+            stores_.emplace_back(path, std::move(iter->second));
+            continue;
+        }
+        auto store = std::make_shared<QuickPhraseStore>(
+            loadFile(name, fd, mtime, stats.st_size));
+        stores_.emplace_back(path, std::move(store));
     }
 }
 
-void BuiltInQuickPhraseProvider::load(UniqueFilePtr fp) {
+QuickPhraseStore BuiltInQuickPhraseProvider::loadFile(const std::string &name,
+                                                      UnixFD &fd,
+                                                      uint64_t mtime,
+                                                      uint64_t size) {
+    const auto cacheName =
+        stringutils::concat("fcitx5/quickphrase/", name, ".cache");
+    if (auto cache = StandardPath::global().openUser(
+            StandardPath::Type::Cache, cacheName, O_RDONLY);
+        cache.isValid()) {
+        if (auto store = QuickPhraseStore::map(cache.fd());
+            store && store->matches(mtime, size)) {
+            return std::move(*store);
+        }
+    }
+
+    QuickPhraseStore store;
+    load(fs::openFD(fd, "rb"), store);
+    store.build(mtime, size);
+    auto content = store.serialize();
+    StandardPath::global().safeSave(
+        StandardPath::Type::Cache, cacheName, [content](int fd) {
+            return fs::safeWrite(fd, content.data(), content.size()) ==
+                   static_cast<ssize_t>(content.size());
+        });
+    return store;
+}
+
+void BuiltInQuickPhraseProvider::load(UniqueFilePtr fp,
+                                      QuickPhraseStore &store) {
     if (!fp) {
         return;
     }
@@ -91,16 +199,17 @@ void BuiltInQuickPhraseProvider::load(UniqueFilePtr fp) {
             continue;
         }
 
-        std::string key(text.begin(), text.begin() + pos);
+        auto key = text.substr(0, pos);
         auto wordString = stringutils::unescapeForValue(text.substr(word));
 
         if (!wordString) {
             continue;
         }
-        map_.emplace(std::move(key), std::move(*wordString));
+        store.add(key, *wordString);
     }
 }
 
+
 SpellQuickPhraseProvider::SpellQuickPhraseProvider(QuickPhrase *parent)
     : parent_(parent), instance_(parent_->instance()) {}
 
@@ -141,4 +250,24 @@ bool CallbackQuickPhraseProvider::populate(
     return true;
 }
 
+std::vector<QuickPhraseCancelCallback> AsyncQuickPhraseProvider::query(
+    InputContext *ic, const std::string &input,
+    const QuickPhraseAddCandidateCallback &addCandidate,
+    const std::function<void()> &done) {
+    std::vector<QuickPhraseCancelCallback> cancels;
+    for (const auto &callback : callback_.view()) {
+        auto finished = std::make_shared<bool>(false);
+        auto cancel = callback(ic, input, addCandidate, [done, finished]() {
+            if (!*finished) {
+                *finished = true;
+                done();
+            }
+        });
+        if (cancel) {
+            cancels.push_back(std::move(cancel));
+        }
+    }
+    return cancels;
+}
+
 } // namespace fcitx
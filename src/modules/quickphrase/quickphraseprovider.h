@@ -7,17 +7,21 @@
 #ifndef _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASEPROVIDER_H_
 #define _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASEPROVIDER_H_
 
-#include <map>
 #include <memory>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <utility>
+#include <vector>
 #include "fcitx-utils/connectableobject.h"
 #include "fcitx-utils/handlertable.h"
 #include "fcitx-utils/misc.h"
+#include "fcitx-utils/unixfd.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
 #include "fcitx/instance.h"
 #include "quickphrase_public.h"
+#include "quickphrasestore.h"
 
 namespace fcitx {
 
@@ -33,13 +37,29 @@ public:
 
 class BuiltInQuickPhraseProvider : public QuickPhraseProvider {
 public:
+    /**
+     * Set word and aux of the next phrase and return true, or return false if
+     * there is no more phrase.
+     */
+    using Matches = std::function<bool(std::string &word, std::string &aux)>;
+
     bool populate(InputContext *ic, const std::string &userInput,
                   const QuickPhraseAddCandidateCallback &addCandidate) override;
     void reloadConfig();
 
+    // Phrases that start with userInput, created one by one. It stays valid
+    // after the phrases are reloaded.
+    Matches matches(const std::string &userInput) const;
+
 private:
-    void load(UniqueFilePtr fp);
-    std::multimap<std::string, std::string> map_;
+    void load(UniqueFilePtr fp, QuickPhraseStore &store);
+    // Load a phrase file, from the cache if it is up to date.
+    QuickPhraseStore loadFile(const std::string &name, UnixFD &fd,
+                              uint64_t mtime, uint64_t size);
+
+    // Path of each phrase file and its phrases, in the order of loading.
+    std::vector<std::pair<std::string, std::shared_ptr<const QuickPhraseStore>>>
+        stores_;
 };
 
 class SpellQuickPhraseProvider : public QuickPhraseProvider {
@@ -70,6 +90,28 @@ private:
     HandlerTable<QuickPhraseProviderCallback> callback_;
 };
 
+class AsyncQuickPhraseProvider {
+public:
+    std::unique_ptr<HandlerTableEntry<QuickPhraseAsyncProviderCallback>>
+    addCallback(QuickPhraseAsyncProviderCallback callback) {
+        return callback_.add(std::move(callback));
+    }
+
+    // Number of providers, which is also the number of done calls for a
+    // query.
+    size_t size() const { return callback_.size(); }
+
+    // Start a query on all providers, done is called at most once for each
+    // of them.
+    std::vector<QuickPhraseCancelCallback>
+    query(InputContext *ic, const std::string &input,
+          const QuickPhraseAddCandidateCallback &addCandidate,
+          const std::function<void()> &done);
+
+private:
+    HandlerTable<QuickPhraseAsyncProviderCallback> callback_;
+};
+
 } // namespace fcitx
 
 #endif // _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASEPROVIDER_H_
@@ -0,0 +1,256 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASESTORE_H_
+#define _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASESTORE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "fcitx-utils/endian_p.h"
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/misc_p.h"
+
+namespace fcitx {
+
+/**
+ * Phrases of the builtin quick phrase provider.
+ *
+ * Phrases are added to the store then sorted by build(), which lays them out
+ * as a sorted table of offsets followed by a single string pool in the order
+ * of keys, so enumerating a prefix reads memory sequentially.
+ *
+ * The layout is also the format of the cache file, so a cache can be mapped
+ * and used as is. All numbers are little endian. Layout:
+ *   magic, source mtime (64bit), source size (64bit), number of entries,
+ *   entry table: (key offset, key length, value offset, value length),
+ *   string pool, which all offsets are relative to.
+ */
+class QuickPhraseStore {
+public:
+    static constexpr char magic[8] = {'F', 'C', 'Q', 'P', 'H', 'R', '1', '\0'};
+    static constexpr size_t headerSize =
+        sizeof(magic) + sizeof(uint64_t) * 2 + sizeof(uint32_t);
+    static constexpr size_t entrySize = sizeof(uint32_t) * 4;
+
+    QuickPhraseStore() = default;
+    QuickPhraseStore(const QuickPhraseStore &) = delete;
+    QuickPhraseStore(QuickPhraseStore &&other) noexcept {
+        *this = std::move(other);
+    }
+    QuickPhraseStore &operator=(QuickPhraseStore &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            pendingBuffer_ = std::move(other.pendingBuffer_);
+            pending_ = std::move(other.pending_);
+            data_ = std::move(other.data_);
+            file_ = std::move(other.file_);
+            numEntries_ = std::exchange(other.numEntries_, 0);
+            poolSize_ = std::exchange(other.poolSize_, 0);
+            other.data_.clear();
+        }
+        return *this;
+    }
+
+    // Map a cache file, return nullopt if it is not valid.
+    static std::optional<QuickPhraseStore> map(int fd) {
+        fs::FileView file(fd);
+        if (!file.isValid() || file.size() < headerSize) {
+            return std::nullopt;
+        }
+        QuickPhraseStore store;
+        store.file_ = std::move(file);
+        if (!store.init()) {
+            return std::nullopt;
+        }
+        return store;
+    }
+
+    // Add a phrase, build() need to be called before lookup.
+    void add(std::string_view key, std::string_view value) {
+        if (pendingBuffer_.size() + key.size() + value.size() >
+            std::numeric_limits<uint32_t>::max()) {
+            return;
+        }
+        pending_.push_back({static_cast<uint32_t>(pendingBuffer_.size()),
+                            static_cast<uint32_t>(key.size()),
+                            static_cast<uint32_t>(value.size())});
+        pendingBuffer_.append(key);
+        pendingBuffer_.append(value);
+    }
+
+    // Sort the phrases by key, phrases with the same key keep the order that
+    // they are added. mtime and size identify the source of the phrases.
+    void build(uint64_t mtime = 0, uint64_t size = 0) {
+        auto pendingKey = [this](const PendingEntry &entry) {
+            return std::string_view(pendingBuffer_)
+                .substr(entry.offset, entry.keyLength);
+        };
+        std::stable_sort(pending_.begin(), pending_.end(),
+                         [&pendingKey](const PendingEntry &lhs,
+                                       const PendingEntry &rhs) {
+                             return pendingKey(lhs) < pendingKey(rhs);
+                         });
+        unmap();
+        data_.clear();
+        data_.reserve(headerSize + pending_.size() * entrySize +
+                      pendingBuffer_.size());
+        data_.append(magic, sizeof(magic));
+        appendInt64(mtime);
+        appendInt64(size);
+        appendInt32(pending_.size());
+        uint32_t offset = 0;
+        for (const auto &entry : pending_) {
+            appendInt32(offset);
+            appendInt32(entry.keyLength);
+            appendInt32(offset + entry.keyLength);
+            appendInt32(entry.valueLength);
+            offset += entry.keyLength + entry.valueLength;
+        }
+        for (const auto &entry : pending_) {
+            data_.append(pendingBuffer_, entry.offset,
+                         entry.keyLength + entry.valueLength);
+        }
+        pendingBuffer_ = std::string();
+        pending_ = std::vector<PendingEntry>();
+        init();
+    }
+
+    // Whether the phrases are built from the source with the mtime and size.
+    bool matches(uint64_t mtime, uint64_t size) const {
+        return totalSize() >= headerSize &&
+               readInt64(sizeof(magic)) == mtime &&
+               readInt64(sizeof(magic) + 8) == size;
+    }
+
+    // Content of the store that can be saved as a cache file.
+    std::string_view serialize() const { return {base(), totalSize()}; }
+
+    size_t size() const { return numEntries_; }
+
+    std::string_view key(size_t i) const {
+        const char *entry = entries() + i * entrySize;
+        return string(FromLittleEndian32(entry),
+                      FromLittleEndian32(entry + 4));
+    }
+
+    std::string_view value(size_t i) const {
+        const char *entry = entries() + i * entrySize;
+        return string(FromLittleEndian32(entry + 8),
+                      FromLittleEndian32(entry + 12));
+    }
+
+    // Index of first key that is not less than the given key.
+    size_t lowerBound(std::string_view key) const {
+        size_t low = 0;
+        size_t high = numEntries_;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (this->key(mid) < key) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Call callback(key, value) for every phrase that starts with prefix,
+    // sorted by key.
+    template <typename Callback>
+    void forEachPrefix(std::string_view prefix, Callback callback) const {
+        for (auto i = lowerBound(prefix); i < numEntries_; i++) {
+            auto current = key(i);
+            if (current.substr(0, prefix.size()) != prefix) {
+                break;
+            }
+            callback(current, value(i));
+        }
+    }
+
+private:
+    struct PendingEntry {
+        uint32_t offset;
+        uint32_t keyLength;
+        uint32_t valueLength;
+    };
+
+    const char *base() const {
+        return file_.isValid() ? file_.data() : data_.data();
+    }
+    size_t totalSize() const {
+        return file_.isValid() ? file_.size() : data_.size();
+    }
+    const char *entries() const { return base() + headerSize; }
+
+    bool init() {
+        numEntries_ = 0;
+        poolSize_ = 0;
+        if (totalSize() < headerSize ||
+            memcmp(base(), magic, sizeof(magic)) != 0) {
+            return false;
+        }
+        uint32_t numEntries = FromLittleEndian32(base() + headerSize - 4);
+        if (static_cast<uint64_t>(numEntries) * entrySize >
+            totalSize() - headerSize) {
+            return false;
+        }
+        numEntries_ = numEntries;
+        poolSize_ = totalSize() - headerSize - numEntries_ * entrySize;
+        return true;
+    }
+
+    // Out of range string is treated as empty.
+    std::string_view string(uint32_t offset, uint32_t length) const {
+        if (offset > poolSize_ || length > poolSize_ - offset) {
+            return {};
+        }
+        return {entries() + numEntries_ * entrySize + offset, length};
+    }
+
+    uint64_t readInt64(size_t offset) const {
+        return FromLittleEndian32(base() + offset) |
+               (static_cast<uint64_t>(FromLittleEndian32(base() + offset + 4))
+                << 32);
+    }
+
+    void appendInt32(uint32_t value) {
+        value = htole32(value);
+        data_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void appendInt64(uint64_t value) {
+        appendInt32(static_cast<uint32_t>(value));
+        appendInt32(static_cast<uint32_t>(value >> 32));
+    }
+
+    void unmap() {
+        file_ = fs::FileView();
+        numEntries_ = 0;
+        poolSize_ = 0;
+    }
+
+    // Phrases that are not built yet.
+    std::string pendingBuffer_;
+    std::vector<PendingEntry> pending_;
+
+    // Built phrases, either owned or from the cache file.
+    std::string data_;
+    fs::FileView file_;
+    size_t numEntries_ = 0;
+    size_t poolSize_ = 0;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX5_MODULES_QUICKPHRASE_QUICKPHRASESTORE_H_
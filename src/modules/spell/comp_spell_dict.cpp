@@ -15,18 +15,19 @@
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <string>
+#include <vector>
 #include "fcitx-utils/endian_p.h"
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/unixfd.h"
 
 using namespace fcitx;
 
-#define DICT_BIN_MAGIC "FSCD0000"
+#define DICT_BIN_MAGIC "FSCD0001"
 const char null_byte = '\0';
 
 static int compile_dict(int ifd, int ofd) {
     struct stat istat_buf;
-    uint32_t wcount = 0;
     char *p;
     char *ifend;
     if (fstat(ifd, &istat_buf) == -1) {
@@ -47,10 +48,8 @@ static int compile_dict(int ifd, int ofd) {
     }
     p = static_cast<char *>(mmapped.get());
     ifend = istat_buf.st_size + p;
-    fs::safeWrite(ofd, DICT_BIN_MAGIC, strlen(DICT_BIN_MAGIC));
-    if (lseek(ofd, sizeof(uint32_t), SEEK_CUR) == static_cast<off_t>(-1)) {
-        return 1;
-    }
+    std::string records;
+    std::vector<uint32_t> offsets;
     while (p < ifend) {
         char *start;
         long int ceff;
@@ -60,20 +59,40 @@ static int compile_dict(int ifd, int ofd) {
             return 1;
         }
         ceff_buff = htole16(ceff > UINT16_MAX ? UINT16_MAX : ceff);
-        fs::safeWrite(ofd, &ceff_buff, sizeof(uint16_t));
+        records.append(reinterpret_cast<const char *>(&ceff_buff),
+                       sizeof(uint16_t));
         start = ++p;
         p += strcspn(p, "\n");
-        fs::safeWrite(ofd, start, p - start);
-        fs::safeWrite(ofd, &null_byte, 1);
-        wcount++;
+        if (p != start) {
+            offsets.push_back(records.size());
+        }
+        records.append(start, p - start);
+        records.push_back(null_byte);
         p++;
     }
-    if (lseek(ofd, strlen(DICT_BIN_MAGIC), SEEK_SET) ==
-        static_cast<off_t>(-1)) {
+
+    /*
+     * Magic, number of words, offset of each word from the beginning of the
+     * file, and then the records. Each record is a 16bit weight followed by
+     * the nul terminated word.
+     */
+    std::string header(DICT_BIN_MAGIC);
+    const uint32_t headerSize =
+        header.size() + sizeof(uint32_t) * (offsets.size() + 1);
+    auto appendInt32 = [&header](uint32_t value) {
+        value = htole32(value);
+        header.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    appendInt32(offsets.size());
+    for (auto offset : offsets) {
+        appendInt32(headerSize + offset);
+    }
+    if (fs::safeWrite(ofd, header.data(), header.size()) !=
+            static_cast<ssize_t>(header.size()) ||
+        fs::safeWrite(ofd, records.data(), records.size()) !=
+            static_cast<ssize_t>(records.size())) {
         return 1;
     }
-    wcount = htole32(wcount);
-    fs::safeWrite(ofd, &wcount, sizeof(uint32_t));
     return 0;
 }
 
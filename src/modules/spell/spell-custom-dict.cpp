@@ -8,9 +8,9 @@
 
 #include "spell-custom-dict.h"
 #include <fcntl.h>
-#include <sys/stat.h>
 #include <cstdint>
 #include <stdexcept>
+#include <utility>
 #include "fcitx-utils/cutf8.h"
 #include "fcitx-utils/endian_p.h"
 #include "fcitx-utils/fs.h"
@@ -72,7 +72,9 @@
     case 'Y':                                                                  \
     case 'Z'
 
-#define DICT_BIN_MAGIC "FSCD0000"
+// The old format without the offset table, still readable.
+#define DICT_BIN_MAGIC_V0 "FSCD0000"
+#define DICT_BIN_MAGIC "FSCD0001"
 
 bool checkLang(const std::string &full_lang, const std::string &lang) {
     if (full_lang.empty() || lang.empty()) {
@@ -95,6 +97,15 @@ static inline uint32_t load_le32(const void *p) {
     return le32toh(*(uint32_t *)p);
 }
 
+// Dictionary words are mostly ASCII, so skip the call for them.
+static inline const char *nextChar(const char *p, unsigned int *c) {
+    if (static_cast<unsigned char>(*p) < 0x80) {
+        *c = static_cast<unsigned char>(*p);
+        return p + 1;
+    }
+    return fcitx_utf8_get_char(p, c);
+}
+
 static bool isFirstCapital(const std::string &str) {
     if (str.empty()) {
         return false;
@@ -163,22 +174,13 @@ public:
         loadDict("en");
     }
 
-    bool wordCompare(unsigned int c1, unsigned int c2) override {
-        switch (c1) {
+    unsigned int foldChar(unsigned int c) override {
+        switch (c) {
         case_A_Z:
-            c1 += 'a' - 'A';
-            break;
-        case_a_z:
-            break;
+            return c + 'a' - 'A';
         default:
-            return c1 == c2;
+            return c;
         }
-        switch (c2) {
-        case_A_Z:
-            c2 += 'a' - 'A';
-            break;
-        }
-        return c1 == c2;
     }
     int wordCheck(const std::string &str) override {
         if (isFirstCapital(str)) {
@@ -224,6 +226,8 @@ load_le16(const void* p)
 }
 #endif
 
+SpellCustomDict::~SpellCustomDict() = default;
+
 /**
 // Open the dict file, return -1 if failed.
  **/
@@ -256,52 +260,119 @@ void SpellCustomDict::loadDict(const std::string &lang) {
     }
 
     do {
-        struct stat stat_buf;
-        size_t total_len;
-        char magic_buff[sizeof(DICT_BIN_MAGIC) - 1];
-        if (fstat(fd.fd(), &stat_buf) == -1 ||
-            static_cast<size_t>(stat_buf.st_size) <=
-                sizeof(uint32_t) + sizeof(magic_buff)) {
-            break;
-        }
-        if (fs::safeRead(fd.fd(), magic_buff, sizeof(magic_buff)) !=
-            sizeof(magic_buff)) {
+        constexpr size_t magic_len = sizeof(DICT_BIN_MAGIC) - 1;
+        fs::FileView file(fd.fd());
+        if (!file.isValid() || file.size() <= sizeof(uint32_t) + magic_len) {
             break;
         }
-        if (memcmp(DICT_BIN_MAGIC, magic_buff, sizeof(magic_buff)) != 0) {
+        const size_t total_len = file.size();
+        file_ = std::move(file);
+        data_ = file_.data();
+        dataSize_ = total_len;
+        // Every word is nul terminated, so is the file.
+        if (data_[total_len - 1] != '\0') {
             break;
         }
-        total_len = stat_buf.st_size - sizeof(magic_buff);
-        data_.resize(total_len + 1);
-        if (fs::safeRead(fd.fd(), data_.data(), total_len) !=
-            static_cast<ssize_t>(total_len)) {
+
+        // A record takes at least 4 bytes.
+        auto lcount = load_le32(data_ + magic_len);
+        if (lcount > total_len / 4) {
             break;
         }
-        data_[total_len] = '\0';
-
-        auto lcount = load_le32(data_.data());
         words_.resize(lcount);
 
-        /* save words offset's. */
         size_t i, j;
-        for (i = sizeof(uint32_t), j = 0; i < total_len && j < lcount; i += 1) {
-            i += sizeof(uint16_t);
-            int l = strlen(data_.data() + i);
-            if (!l) {
-                continue;
+        if (memcmp(DICT_BIN_MAGIC, data_, magic_len) == 0) {
+            /* offsets of words are saved after the count. */
+            const size_t table_end =
+                magic_len + sizeof(uint32_t) * (lcount + 1);
+            if (table_end > total_len) {
+                break;
             }
-            words_[j++] = i;
-            i += l;
-        }
-        if (j < lcount || i < total_len) {
+            for (j = 0; j < lcount; j++) {
+                auto offset =
+                    load_le32(data_ + magic_len + sizeof(uint32_t) * (j + 1));
+                if (offset < table_end || offset >= total_len ||
+                    !data_[offset]) {
+                    break;
+                }
+                words_[j] = offset;
+            }
+            if (j < lcount) {
+                break;
+            }
+        } else if (memcmp(DICT_BIN_MAGIC_V0, data_, magic_len) == 0) {
+            /* save words offset's. */
+            for (i = magic_len + sizeof(uint32_t), j = 0;
+                 i < total_len && j < lcount; i += 1) {
+                i += sizeof(uint16_t);
+                if (i >= total_len) {
+                    break;
+                }
+                int l = strlen(data_ + i);
+                if (!l) {
+                    continue;
+                }
+                words_[j++] = i;
+                i += l;
+            }
+            if (j < lcount || i < total_len) {
+                break;
+            }
+        } else {
             break;
         }
+
+        foldedWords_.reserve(lcount);
+        lengths_.reserve(lcount);
+        signatures_.reserve(lcount);
+        for (auto offset : words_) {
+            uint32_t length;
+            uint64_t signature;
+            auto folded = foldWord(data_ + offset, &length, &signature);
+            foldedWords_.push_back(folded_.size());
+            folded_.append(folded);
+            folded_.push_back('\0');
+            lengths_.push_back(length);
+            signatures_.push_back(signature);
+            const auto wordHead = head(folded);
+            firstIndex_[wordHead >> 32].push_back(signatures_.size() - 1);
+            secondIndex_[wordHead & 0xffffffffU].push_back(
+                signatures_.size() - 1);
+        }
         return;
     } while (0);
 
     throw std::runtime_error("failed to read dict file");
 }
 
+std::string SpellCustomDict::foldWord(const char *str, uint32_t *length,
+                                      uint64_t *signature) {
+    std::string result;
+    *length = 0;
+    *signature = 0;
+    while (*str) {
+        unsigned int c;
+        str = nextChar(str, &c);
+        c = foldChar(c);
+        char buf[FCITX_UTF8_MAX_LENGTH + 1];
+        result.append(buf, fcitx_ucs4_to_utf8(c, buf));
+        ++*length;
+        *signature |= 1ULL << (c % 64);
+    }
+    return result;
+}
+
+uint64_t SpellCustomDict::head(const std::string &folded) {
+    unsigned int first;
+    unsigned int second = 0;
+    const char *str = nextChar(folded.c_str(), &first);
+    if (first) {
+        nextChar(str, &second);
+    }
+    return (static_cast<uint64_t>(first) << 32) | second;
+}
+
 SpellCustomDict *SpellCustomDict::requestDict(const std::string &lang) {
     if (checkLang(lang, "en")) {
         return new SpellCustomDictEn;
@@ -313,8 +384,11 @@ bool SpellCustomDict::checkDict(const std::string &lang) {
     return !locateDictFile(lang).empty();
 }
 
-int SpellCustomDict::getDistance(const char *word, int utf8Len,
-                                 const char *dict) {
+/*
+ * Both word and dict need to be folded by foldChar, so characters can be
+ * compared directly.
+ */
+static int getDistance(const char *word, int utf8Len, const char *dict) {
 #define REPLACE_WEIGHT 3
 #define INSERT_WEIGHT 3
 #define REMOVE_WEIGHT 3
@@ -345,8 +419,8 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
     unsigned int next_dict_c;
     maxdiff = utf8Len / 3;
     maxremove = (utf8Len - 2) / 3;
-    word = fcitx_utf8_get_char(word, &cur_word_c);
-    dict = fcitx_utf8_get_char(dict, &cur_dict_c);
+    word = nextChar(word, &cur_word_c);
+    dict = nextChar(dict, &cur_dict_c);
     while ((diff = replace + insert + remove) <= maxdiff &&
            remove <= maxremove) {
         /*
@@ -361,7 +435,7 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
                                END_WEIGHT
                          : 0));
         }
-        word = fcitx_utf8_get_char(word, &next_word_c);
+        word = nextChar(word, &next_word_c);
 
         /* check remove error */
         if (!cur_dict_c) {
@@ -375,36 +449,32 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
             }
             return -1;
         }
-        dict = fcitx_utf8_get_char(dict, &next_dict_c);
-        if (cur_word_c == cur_dict_c || (wordCompare(cur_word_c, cur_dict_c))) {
+        dict = nextChar(dict, &next_dict_c);
+        if (cur_word_c == cur_dict_c) {
             cur_word_c = next_word_c;
             cur_dict_c = next_dict_c;
             continue;
         }
-        if (next_word_c == cur_dict_c ||
-            (next_word_c && wordCompare(next_word_c, cur_dict_c))) {
-            word = fcitx_utf8_get_char(word, &cur_word_c);
+        if (next_word_c == cur_dict_c) {
+            word = nextChar(word, &cur_word_c);
             cur_dict_c = next_dict_c;
             remove++;
             continue;
         }
 
         /* check insert error */
-        if (cur_word_c == next_dict_c ||
-            (next_dict_c && wordCompare(cur_word_c, next_dict_c))) {
+        if (cur_word_c == next_dict_c) {
             cur_word_c = next_word_c;
-            dict = fcitx_utf8_get_char(dict, &cur_dict_c);
+            dict = nextChar(dict, &cur_dict_c);
             insert++;
             continue;
         }
 
         /* check replace error */
-        if (next_word_c == next_dict_c ||
-            (next_word_c && next_dict_c &&
-             wordCompare(next_word_c, next_dict_c))) {
+        if (next_word_c == next_dict_c) {
             if (next_word_c) {
-                dict = fcitx_utf8_get_char(dict, &cur_dict_c);
-                word = fcitx_utf8_get_char(word, &cur_word_c);
+                dict = nextChar(dict, &cur_dict_c);
+                word = nextChar(word, &cur_word_c);
             } else {
                 cur_word_c = 0;
                 cur_dict_c = 0;
@@ -436,20 +506,73 @@ SpellCustomDict::hint(const std::string &str, size_t limit) {
     std::string_view prefix(word);
     prefix = prefix.substr(0, real_word - word);
     auto word_type = wordCheck(real_word);
-    int word_len = fcitx_utf8_strlen(real_word);
+    uint32_t length;
+    uint64_t signature;
+    const auto folded = foldWord(real_word, &length, &signature);
+    const int word_len = length;
+    const int maxdiff = word_len / 3;
+    const int maxremove = (word_len - 2) / 3;
+    const int maxabsent = maxdiff + (maxremove > 0 ? 1 : 0);
+    const auto wordHead = head(folded);
+    const auto wordFirst = wordHead >> 32;
+    const auto wordSecond = wordHead & 0xffffffffU;
     auto compare = [](const std::pair<const char *, int> &lhs,
                       const std::pair<const char *, int> &rhs) {
         return lhs.second < rhs.second;
     };
-    for (const auto &wordOffset : words_) {
-        int dist;
-        const char *dictWord = data_.data() + wordOffset;
-        if ((dist = getDistance(real_word, word_len, dictWord)) >= 0) {
-            tops.emplace_back(dictWord, dist);
-            std::push_heap(tops.begin(), tops.end(), compare);
-            if (tops.size() > limit) {
-                std::pop_heap(tops.begin(), tops.end(), compare);
-                tops.pop_back();
+
+    /*
+     * The first step of getDistance needs one of the first two characters
+     * of word match one of the first two characters of dict, so only the
+     * words in these buckets can match. Candidates are collected in a bit
+     * set, so they are visited in the order of dict as before.
+     */
+    auto &candidates = lastCandidates_;
+    if (candidates.empty() || lastHead_ != wordHead) {
+        candidates.assign((words_.size() + 63) / 64, 0);
+        auto mark = [&candidates](const auto &index, uint32_t c) {
+            auto iter = index.find(c);
+            if (iter == index.end()) {
+                return;
+            }
+            for (auto i : iter->second) {
+                candidates[i / 64] |= 1ULL << (i % 64);
+            }
+        };
+        mark(firstIndex_, wordFirst);
+        mark(firstIndex_, wordSecond);
+        mark(secondIndex_, wordFirst);
+        mark(secondIndex_, wordSecond);
+        lastHead_ = wordHead;
+    }
+
+    for (size_t block = 0; block < candidates.size(); block++) {
+        for (auto bits = candidates[block]; bits; bits &= bits - 1) {
+            const size_t i = block * 64 + __builtin_ctzll(bits);
+            /*
+             * Cheap checks that reject most of the words before the
+             * distance.
+             *
+             * Each remove error makes the matched part of dict one character
+             * shorter than word. A character that is not in dict can only be
+             * matched with a replace or remove error, and there can be one
+             * more error than maxdiff when the last character is removed.
+             * The signature may have false positive, which is fine here.
+             */
+            if (static_cast<int>(lengths_[i]) + maxremove < word_len ||
+                __builtin_popcountll(signature & ~signatures_[i]) >
+                    maxabsent) {
+                continue;
+            }
+            int dist;
+            if ((dist = getDistance(folded.data(), word_len,
+                                    folded_.data() + foldedWords_[i])) >= 0) {
+                tops.emplace_back(data_ + words_[i], dist);
+                std::push_heap(tops.begin(), tops.end(), compare);
+                if (tops.size() > limit) {
+                    std::pop_heap(tops.begin(), tops.end(), compare);
+                    tops.pop_back();
+                }
             }
         }
     }
@@ -10,13 +10,17 @@
 
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "fcitx-utils/fs.h"
 
 namespace fcitx {
 
 class SpellCustomDict {
 public:
-    virtual ~SpellCustomDict() {}
+    SpellCustomDict() = default;
+    SpellCustomDict(const SpellCustomDict &) = delete;
+    virtual ~SpellCustomDict();
 
     static SpellCustomDict *requestDict(const std::string &language);
     static bool checkDict(const std::string &language);
@@ -27,13 +31,36 @@ public:
 
 protected:
     void loadDict(const std::string &lang);
-    int getDistance(const char *word, int utf8Len, const char *dict);
-    virtual bool wordCompare(unsigned int c1, unsigned int c2) = 0;
+    // Characters that compare equal need to be folded to the same one.
+    virtual unsigned int foldChar(unsigned int c) = 0;
     virtual int wordCheck(const std::string &word) = 0;
     virtual void hintComplete(std::vector<std::string> &hints, int type) = 0;
-    std::vector<char> data_;
+    // Dict file, words_ are offsets into it.
+    fs::FileView file_;
+    const char *data_ = nullptr;
+    size_t dataSize_ = 0;
     std::vector<uint32_t> words_;
     std::string delim_;
+
+private:
+    // Fold str, and return the number of characters and its signature.
+    std::string foldWord(const char *str, uint32_t *length,
+                         uint64_t *signature);
+    static uint64_t head(const std::string &folded);
+
+    // Words folded by foldChar, in the order of words_.
+    std::string folded_;
+    std::vector<uint32_t> foldedWords_;
+    // Length in characters, and a bit set of the characters in the word.
+    std::vector<uint32_t> lengths_;
+    std::vector<uint64_t> signatures_;
+    // Index of words by their first and second character, in order.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> firstIndex_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> secondIndex_;
+    // Candidates of the last hint, reused when the input keeps the leading
+    // characters, e.g. the user is typing the rest of the word.
+    uint64_t lastHead_ = 0;
+    std::vector<uint64_t> lastCandidates_;
 };
 } // namespace fcitx
 
@@ -10,6 +10,7 @@
 #include <time.h>
 #include <stdexcept>
 #include <enchant.h>
+#include "fcitx-utils/workerpool.h"
 #include "fcitx/misc_p.h"
 
 namespace fcitx {
@@ -99,30 +100,45 @@ auto foreachLanguage(const std::string &lang, const std::string &systemLanguage,
     return result;
 }
 
+// Safe to be called from any thread, since it uses a new broker.
+static std::shared_ptr<EnchantLoadedDict>
+requestDict(const std::string &language, const std::string &systemLanguage) {
+    auto loaded = std::make_shared<EnchantLoadedDict>();
+    loaded->broker.reset(enchant_broker_init());
+    if (!loaded->broker) {
+        return nullptr;
+    }
+    loaded->dict = foreachLanguage(
+        language, systemLanguage, [&loaded](const std::string &lang) {
+            return enchant_broker_request_dict(loaded->broker.get(),
+                                               lang.c_str());
+        });
+    if (!loaded->dict) {
+        return nullptr;
+    }
+    return loaded;
+}
+
 SpellEnchant::SpellEnchant(Spell *spell)
     : SpellBackend(spell), broker_(enchant_broker_init()),
-      dict_(nullptr,
-            [this](EnchantDict *dict) {
-                enchant_broker_free_dict(broker_.get(), dict);
-            }),
       systemLanguage_(stripLanguage(getCurrentLanguage())) {
     if (!broker_) {
         throw std::runtime_error("Init enchant failed");
     }
 }
 
-SpellEnchant::~SpellEnchant() {}
+SpellEnchant::~SpellEnchant() = default;
 
 std::vector<std::pair<std::string, std::string>>
 SpellEnchant::hint(const std::string &language, const std::string &word,
                    size_t limit) {
-    if (word.empty() || !loadDict(language)) {
+    if (word.empty() || !ready(language)) {
         return {};
     }
 
     size_t number;
     char **suggestions =
-        enchant_dict_suggest(dict_.get(), word.c_str(), word.size(), &number);
+        enchant_dict_suggest(dict_->dict, word.c_str(), word.size(), &number);
     if (!suggestions) {
         return {};
     }
@@ -137,32 +153,79 @@ SpellEnchant::hint(const std::string &language, const std::string &word,
         result.emplace_back(hintWord, hintWord);
     }
 
-    enchant_dict_free_string_list(dict_.get(), suggestions);
+    enchant_dict_free_string_list(dict_->dict, suggestions);
     return result;
 }
 
+bool SpellEnchant::ready(const std::string &language) {
+    if (dict_ && language_ == language) {
+        return true;
+    }
+    if (language != failedLanguage_) {
+        loadDictAsync(language);
+    }
+    return false;
+}
+
 bool SpellEnchant::loadDict(const std::string &language) {
-    if (language_ == language) {
+    if (dict_ && language_ == language) {
         return true;
     }
 
-    auto *dict = foreachLanguage(
-        language, systemLanguage_, [this](const std::string &lang) {
-            return enchant_broker_request_dict(broker_.get(), lang.c_str());
-        });
-    if (dict) {
+    if (auto loaded = requestDict(language, systemLanguage_)) {
         language_ = language;
-        dict_.reset(dict);
+        dict_ = std::move(loaded);
         return true;
     }
 
     return false;
 }
 
+void SpellEnchant::loadDictAsync(const std::string &language) {
+    if (loading_) {
+        // Load the latest one after the current one is done.
+        if (loadingLanguage_ != language) {
+            pendingLanguage_ = language;
+        }
+        return;
+    }
+
+    loadingLanguage_ = language;
+    pendingLanguage_.clear();
+    loading_ = true;
+    spell()->instance()->workerPool().run(
+        WorkPriority::Prefetch, watch(),
+        [language, systemLanguage = systemLanguage_]() {
+            return requestDict(language, systemLanguage);
+        },
+        [this](std::shared_ptr<EnchantLoadedDict> loaded) {
+            finishLoading(std::move(loaded));
+        });
+}
+
+void SpellEnchant::finishLoading(std::shared_ptr<EnchantLoadedDict> loaded) {
+    loading_ = false;
+    if (!loaded) {
+        failedLanguage_ = loadingLanguage_;
+    } else if (!dict_ || language_ != loadingLanguage_) {
+        language_ = loadingLanguage_;
+        dict_ = std::move(loaded);
+    }
+    loadingLanguage_.clear();
+
+    if (!pendingLanguage_.empty()) {
+        auto language = std::move(pendingLanguage_);
+        pendingLanguage_.clear();
+        if (!dict_ || language_ != language) {
+            loadDictAsync(language);
+        }
+    }
+}
+
 void SpellEnchant::addWord(const std::string &language,
                            const std::string &word) {
     if (loadDict(language)) {
-        enchant_dict_add(dict_.get(), word.c_str(), word.size());
+        enchant_dict_add(dict_->dict, word.c_str(), word.size());
     }
 }
 
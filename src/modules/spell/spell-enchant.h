@@ -8,17 +8,34 @@
 #ifndef _FCITX_MODULES_SPELL_SPELL_ENCHANT_H_
 #define _FCITX_MODULES_SPELL_SPELL_ENCHANT_H_
 
+#include <memory>
+#include <string>
 #include <enchant.h>
+#include "fcitx-utils/trackableobject.h"
 #include "spell.h"
 
 namespace fcitx {
 
-class SpellEnchant : public SpellBackend {
+// A dict, with the broker that it is requested from.
+struct EnchantLoadedDict {
+    ~EnchantLoadedDict() {
+        if (dict) {
+            enchant_broker_free_dict(broker.get(), dict);
+        }
+    }
+
+    UniqueCPtr<EnchantBroker, enchant_broker_free> broker;
+    EnchantDict *dict = nullptr;
+};
+
+class SpellEnchant : public SpellBackend,
+                     public TrackableObject<SpellEnchant> {
 public:
     SpellEnchant(Spell *spell);
     ~SpellEnchant();
 
     bool checkDict(const std::string &language) override;
+    bool ready(const std::string &language) override;
     void addWord(const std::string &language, const std::string &word) override;
     std::vector<std::pair<std::string, std::string>>
     hint(const std::string &language, const std::string &word,
@@ -26,10 +43,19 @@ public:
 
 private:
     bool loadDict(const std::string &language);
+    // Load the dict on a worker thread, since it may take a while.
+    void loadDictAsync(const std::string &language);
+    void finishLoading(std::shared_ptr<EnchantLoadedDict> loaded);
     UniqueCPtr<EnchantBroker, enchant_broker_free> broker_;
-    std::unique_ptr<EnchantDict, std::function<void(EnchantDict *)>> dict_;
+    std::shared_ptr<EnchantLoadedDict> dict_;
     std::string language_;
     std::string systemLanguage_;
+
+    // Each loading uses its own broker, so it does not race with broker_.
+    bool loading_ = false;
+    std::string loadingLanguage_;
+    std::string pendingLanguage_;
+    std::string failedLanguage_;
 };
 } // namespace fcitx
 
@@ -6,7 +6,12 @@
  */
 
 #include "spell.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx/addonmanager.h"
 #include "config.h"
 #include "spell-custom.h"
@@ -16,6 +21,14 @@
 
 namespace fcitx {
 
+namespace {
+
+// Input usually goes back and forth a few characters, and the same word is
+// also queried by different callers.
+constexpr size_t HintCacheSize = 64;
+
+} // namespace
+
 Spell::Spell(Instance *instance) : instance_(instance) {
 #ifdef ENABLE_ENCHANT
     backends_.emplace(SpellProvider::Enchant,
@@ -29,16 +42,27 @@ Spell::Spell(Instance *instance) : instance_(instance) {
 
 Spell::~Spell() {}
 
-void Spell::reloadConfig() { readAsIni(config_, "conf/spell.conf"); }
+void Spell::reloadConfig() {
+    readAsIni(config_, "conf/spell.conf");
+    hintCache_.clear();
+}
 
 Spell::BackendMap::iterator Spell::findBackend(const std::string &language) {
+    auto fallback = backends_.end();
     for (auto backend : config_.providerOrder.value()) {
         auto iter = findBackend(language, backend);
-        if (iter != backends_.end()) {
+        if (iter == backends_.end()) {
+            continue;
+        }
+        // Use the next backend until this one is ready.
+        if (iter->second->ready(language)) {
             return iter;
         }
+        if (fallback == backends_.end()) {
+            fallback = iter;
+        }
     }
-    return backends_.end();
+    return fallback;
 }
 
 Spell::BackendMap::iterator Spell::findBackend(const std::string &language,
@@ -66,6 +90,7 @@ void Spell::addWord(const std::string &language, const std::string &word) {
     }
 
     iter->second->addWord(language, word);
+    hintCache_.clear();
 }
 
 std::vector<std::string>
@@ -85,7 +110,7 @@ std::vector<std::string> Spell::hint(const std::string &language,
         return {};
     }
 
-    return takeSecond(iter->second->hint(language, word, limit));
+    return takeSecond(cachedHint(iter, language, word, limit));
 }
 
 std::vector<std::string> Spell::hintWithProvider(const std::string &language,
@@ -97,7 +122,7 @@ std::vector<std::string> Spell::hintWithProvider(const std::string &language,
         return {};
     }
 
-    return takeSecond(iter->second->hint(language, word, limit));
+    return takeSecond(cachedHint(iter, language, word, limit));
 }
 
 std::vector<std::pair<std::string, std::string>>
@@ -108,7 +133,31 @@ Spell::hintForDisplay(const std::string &language, SpellProvider provider,
         return {};
     }
 
-    return iter->second->hint(language, word, limit);
+    return cachedHint(iter, language, word, limit);
+}
+
+std::vector<std::pair<std::string, std::string>>
+Spell::cachedHint(BackendMap::iterator backend, const std::string &language,
+                  const std::string &word, size_t limit) {
+    auto key = stringutils::concat(static_cast<int>(backend->first), ":",
+                                   limit, ":", language);
+    key.push_back('\0');
+    key.append(word);
+    auto iter = hintCache_.find(key);
+    if (iter != hintCache_.end()) {
+        // Move it to the end as the most recent one.
+        auto result = std::move(iter->second);
+        hintCache_.erase(iter);
+        return hintCache_.emplace(std::move(key), std::move(result))
+            .first->second;
+    }
+
+    auto result = backend->second->hint(language, word, limit);
+    if (hintCache_.size() >= HintCacheSize) {
+        hintCache_.erase(hintCache_.begin());
+    }
+    hintCache_.emplace(std::move(key), result);
+    return result;
 }
 
 class SpellModuleFactory : public AddonFactory {
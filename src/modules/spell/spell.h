@@ -11,6 +11,7 @@
 #include "fcitx-config/enum.h"
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/i18n.h"
+#include "fcitx-utils/misc_p.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/instance.h"
@@ -84,6 +85,14 @@ private:
     BackendMap::iterator findBackend(const std::string &language);
     BackendMap::iterator findBackend(const std::string &language,
                                      SpellProvider provider);
+    // Hint with the backend, and remember the recent results.
+    std::vector<std::pair<std::string, std::string>>
+    cachedHint(BackendMap::iterator backend, const std::string &language,
+               const std::string &word, size_t limit);
+
+    // Recent hints of any backend, the most recent one is at the end.
+    OrderedMap<std::string, std::vector<std::pair<std::string, std::string>>>
+        hintCache_;
     Instance *instance_;
 };
 
@@ -93,6 +102,9 @@ public:
     virtual ~SpellBackend() {}
 
     virtual bool checkDict(const std::string &language) = 0;
+    // Whether hint is able to return result for language right now. The
+    // backend may prepare for the language in the background if not.
+    virtual bool ready(const std::string &) { return true; }
     virtual void addWord(const std::string &language,
                          const std::string &word) = 0;
     virtual std::vector<std::pair<std::string, std::string>>
@@ -100,6 +112,7 @@ public:
          size_t limit) = 0;
 
     const SpellConfig &config() { return parent_->config(); }
+    Spell *spell() { return parent_; }
 
 private:
     Spell *parent_;
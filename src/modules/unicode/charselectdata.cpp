@@ -15,16 +15,17 @@
 #include "charselectdata.h"
 #include <fcntl.h>
 #include <strings.h>
-#include <sys/stat.h>
 #include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <set>
 #include <sstream>
+#include <utility>
 #include <fmt/format.h>
 #include "fcitx-utils/charutils.h"
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/i18n.h"
+#include "fcitx-utils/log.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx-utils/stringutils.h"
@@ -64,8 +65,15 @@ uint16_t FromLittleEndian16(const char *d) {
     return le16toh(t);
 }
 
+// Search index is located by the last 8 bytes of the file.
+constexpr char indexMagic[4] = {'C', 'S', 'I', 'X'};
+constexpr size_t indexTrailerSize = 8;
+constexpr size_t indexEntrySize = 12;
+
 CharSelectData::CharSelectData() {}
 
+CharSelectData::~CharSelectData() = default;
+
 bool CharSelectData::load() {
     if (loaded_) {
         return loadResult_;
@@ -77,22 +85,53 @@ bool CharSelectData::load() {
         return false;
     }
 
-    struct stat s;
-    if (fstat(file.fd(), &s) < 0) {
+    fs::FileView view(file.fd());
+    if (!view.isValid() || view.size() < 40) {
         return false;
     }
-    auto size = s.st_size;
-    data_.resize(size);
-    if (size != fs::safeRead(file.fd(), data_.data(), size)) {
-        return false;
-    };
+    file_ = std::move(view);
+    data_ = file_.data();
+    dataSize_ = file_.size();
+    unihanOffsetEnd_ = dataSize_;
 
-    createIndex();
+    if (!loadIndex()) {
+        FCITX_WARN() << "Unicode data file has no valid search index.";
+    }
 
     loadResult_ = true;
     return true;
 }
 
+void CharSelectData::clearCache() const {
+    detailCache_.clear();
+    nameCache_.clear();
+    lastSearch_ = std::string();
+    lastMatches_ = std::set<uint32_t>();
+}
+
+bool CharSelectData::loadIndex() {
+    if (dataSize_ < 40 + indexTrailerSize + 4 ||
+        memcmp(data_ + dataSize_ - sizeof(indexMagic), indexMagic,
+               sizeof(indexMagic)) != 0) {
+        return false;
+    }
+    const uint32_t indexBegin =
+        FromLittleEndian32(data_ + dataSize_ - indexTrailerSize);
+    const size_t indexEnd = dataSize_ - indexTrailerSize;
+    if (indexBegin < FromLittleEndian32(data_ + 36) ||
+        indexBegin > indexEnd - 4 || data_[indexEnd - 1] != '\0') {
+        return false;
+    }
+    const uint32_t indexSize = FromLittleEndian32(data_ + indexBegin);
+    if (indexSize > (indexEnd - indexBegin - 4) / indexEntrySize) {
+        return false;
+    }
+    unihanOffsetEnd_ = indexBegin;
+    indexBegin_ = indexBegin;
+    indexSize_ = indexSize;
+    return true;
+}
+
 std::vector<std::string> CharSelectData::unihanInfo(uint32_t unicode) const {
     if (!loadResult_) {
         return {};
@@ -100,9 +139,9 @@ std::vector<std::string> CharSelectData::unihanInfo(uint32_t unicode) const {
 
     std::vector<std::string> res;
 
-    const char *data = data_.data();
+    const char *data = data_;
     const uint32_t offsetBegin = FromLittleEndian32(data + 36);
-    const uint32_t offsetEnd = data_.size();
+    const uint32_t offsetEnd = unihanOffsetEnd_;
 
     int min = 0;
     int mid;
@@ -136,42 +175,57 @@ std::vector<std::string> CharSelectData::unihanInfo(uint32_t unicode) const {
 }
 
 uint32_t CharSelectData::findDetailIndex(uint32_t unicode) const {
-    const char *data = data_.data();
-    // Convert from little-endian, so that this code works on PPC too.
-    // http://bugs.debian.org/cgi-bin/bugreport.cgi?bug=482286
-    const uint32_t offsetBegin = FromLittleEndian32(data + 12);
-    const uint32_t offsetEnd = FromLittleEndian32(data + 16);
-
-    int min = 0;
-    int mid;
-    int max = ((offsetEnd - offsetBegin) / 29) - 1;
-
-    static uint32_t most_recent_searched;
-    static uint32_t most_recent_result;
-
-    if (unicode == most_recent_searched) {
-        return most_recent_result;
-    }
-
-    most_recent_searched = unicode;
-
-    while (max >= min) {
-        mid = (min + max) / 2;
-        const uint32_t midUnicode =
-            FromLittleEndian16(data + offsetBegin + mid * 29);
-        if (unicode > midUnicode) {
-            min = mid + 1;
-        } else if (unicode < midUnicode) {
-            max = mid - 1;
-        } else {
-            most_recent_result = offsetBegin + mid * 29;
-
-            return most_recent_result;
+    return detailCache_.get(unicode, [this](uint32_t unicode) -> uint32_t {
+        const char *data = data_;
+        // Convert from little-endian, so that this code works on PPC too.
+        // http://bugs.debian.org/cgi-bin/bugreport.cgi?bug=482286
+        const uint32_t offsetBegin = FromLittleEndian32(data + 12);
+        const uint32_t offsetEnd = FromLittleEndian32(data + 16);
+
+        int min = 0;
+        int mid;
+        int max = ((offsetEnd - offsetBegin) / 29) - 1;
+
+        while (max >= min) {
+            mid = (min + max) / 2;
+            const uint32_t midUnicode =
+                FromLittleEndian32(data + offsetBegin + mid * 29);
+            if (unicode > midUnicode) {
+                min = mid + 1;
+            } else if (unicode < midUnicode) {
+                max = mid - 1;
+            } else {
+                return offsetBegin + mid * 29;
+            }
         }
-    }
+        return 0;
+    });
+}
 
-    most_recent_result = 0;
-    return 0;
+uint32_t CharSelectData::findNameOffset(uint32_t unicode) const {
+    return nameCache_.get(unicode, [this](uint32_t unicode) -> uint32_t {
+        const char *data = data_;
+        const uint32_t offsetBegin = FromLittleEndian32(data + 4);
+        const uint32_t offsetEnd = FromLittleEndian32(data + 8);
+
+        int min = 0;
+        int mid;
+        int max = ((offsetEnd - offsetBegin) / 8) - 1;
+
+        while (max >= min) {
+            mid = (min + max) / 2;
+            const uint32_t midUnicode =
+                FromLittleEndian32(data + offsetBegin + mid * 8);
+            if (unicode > midUnicode) {
+                min = mid + 1;
+            } else if (unicode < midUnicode) {
+                max = mid - 1;
+            } else {
+                return FromLittleEndian32(data + offsetBegin + mid * 8 + 4);
+            }
+        }
+        return 0;
+    });
 }
 
 std::string CharSelectData::name(uint32_t unicode) const {
@@ -213,31 +267,8 @@ std::string CharSelectData::name(uint32_t unicode) const {
             result = _("<Low Surrogate>");
         } else if (unicode >= 0xE000 && unicode <= 0xF8FF) {
             result = _("<Private Use>");
-        } else {
-
-            const char *data = data_.data();
-            const uint32_t offsetBegin = FromLittleEndian32(data + 4);
-            const uint32_t offsetEnd = FromLittleEndian32(data + 8);
-
-            int min = 0;
-            int mid;
-            int max = ((offsetEnd - offsetBegin) / 8) - 1;
-
-            while (max >= min) {
-                mid = (min + max) / 2;
-                const uint32_t midUnicode =
-                    FromLittleEndian32(data + offsetBegin + mid * 8);
-                if (unicode > midUnicode) {
-                    min = mid + 1;
-                } else if (unicode < midUnicode) {
-                    max = mid - 1;
-                } else {
-                    uint32_t offset =
-                        FromLittleEndian32(data + offsetBegin + mid * 8 + 4);
-                    result = (data_.data() + offset + 1);
-                    break;
-                }
-            }
+        } else if (auto offset = findNameOffset(unicode)) {
+            result = (data_ + offset + 1);
         }
     } while (0);
 
@@ -291,7 +322,8 @@ bool IsHexString(const std::string &s) {
     return 1;
 }
 
-std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
+std::vector<uint32_t> CharSelectData::find(const std::string &needle,
+                                           size_t limit) const {
     if (!loadResult_) {
         return {};
     }
@@ -332,10 +364,30 @@ std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
         }
     }
 
-    for (auto &s : searchStrings) {
-        auto partResult = matchingChars(s);
-        if (result.empty()) {
+    // Every word of the previous search except the last one is kept as is
+    // in an extended needle, and its last word can only be extended, so only
+    // the remaining words need to be matched against its result.
+    size_t matched = 0;
+    bool first = true;
+    if (simplified.size() > 1 && lastSearch_.size() > 1 &&
+        stringutils::startsWith(simplified, lastSearch_)) {
+        auto lastStrings = stringutils::split(lastSearch_, FCITX_WHITESPACE);
+        if (!lastStrings.empty()) {
+            matched =
+                std::min(lastStrings.size(), searchStrings.size()) - 1;
+            result = lastMatches_;
+            first = false;
+        }
+    }
+
+    for (size_t i = matched; i < searchStrings.size(); i++) {
+        if (!first && result.empty()) {
+            break;
+        }
+        auto partResult = matchingChars(searchStrings[i]);
+        if (first) {
             result = std::move(partResult);
+            first = false;
         } else {
             auto iter = result.begin();
             while (iter != result.end()) {
@@ -346,9 +398,14 @@ std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
                 }
             }
         }
-        if (result.empty()) {
-            break;
-        }
+    }
+
+    if (simplified.size() > 1) {
+        lastSearch_ = simplified;
+        lastMatches_ = result;
+    } else {
+        lastSearch_.clear();
+        lastMatches_.clear();
     }
 
     // remove results found by matching the code point to prevent duplicate
@@ -358,24 +415,83 @@ std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
         result.erase(c);
     }
 
-    returnRes.reserve(returnRes.size() + result.size());
-    std::copy(result.begin(), result.end(), std::back_inserter(returnRes));
+    const auto query = stringutils::join(searchStrings, " ");
+    std::vector<std::pair<int, uint32_t>> ranked;
+    ranked.reserve(result.size());
+    for (auto c : result) {
+        auto name = this->name(c);
+        int rank = 2;
+        if (strcasecmp(name.c_str(), query.c_str()) == 0) {
+            rank = 0;
+        } else if (strncasecmp(name.c_str(), query.c_str(), query.size()) ==
+                   0) {
+            rank = 1;
+        }
+        ranked.emplace_back(rank, c);
+    }
+
+    if (limit) {
+        if (returnRes.size() >= limit) {
+            returnRes.resize(limit);
+            return returnRes;
+        }
+        if (ranked.size() > limit - returnRes.size()) {
+            auto middle = ranked.begin() + (limit - returnRes.size());
+            std::partial_sort(ranked.begin(), middle, ranked.end());
+            ranked.erase(middle, ranked.end());
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    returnRes.reserve(returnRes.size() + ranked.size());
+    for (const auto &[rank, c] : ranked) {
+        returnRes.push_back(c);
+    }
     return returnRes;
 }
 
+const char *CharSelectData::indexWord(uint32_t i) const {
+    const uint32_t offset =
+        FromLittleEndian32(data_ + indexBegin_ + 4 + i * indexEntrySize);
+    if (offset < indexBegin_ || offset >= dataSize_ - indexTrailerSize) {
+        return "";
+    }
+    return data_ + offset;
+}
+
 std::set<uint32_t> CharSelectData::matchingChars(const std::string &s) const {
     std::set<uint32_t> result;
-    auto iter = std::lower_bound(
-        indexList_.begin(), indexList_.end(), s, [](auto lhs, auto rhs) {
-            return strcasecmp(lhs->first.c_str(), rhs.c_str()) < 0;
-        });
-
-    while (iter != indexList_.end() &&
-           strncasecmp(s.c_str(), (*iter)->first.c_str(), s.size()) == 0) {
-        for (auto c : (*iter)->second) {
-            result.insert(c);
+    // Words in the index are lower cased.
+    std::string needle = s;
+    for (auto &c : needle) {
+        c = charutils::tolower(c);
+    }
+
+    uint32_t low = 0;
+    uint32_t high = indexSize_;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (strcmp(indexWord(mid), needle.c_str()) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    for (uint32_t i = low; i < indexSize_; i++) {
+        if (strncmp(needle.c_str(), indexWord(i), needle.size()) != 0) {
+            break;
+        }
+        const char *entry = data_ + indexBegin_ + 4 + i * indexEntrySize;
+        const uint32_t offset = FromLittleEndian32(entry + 4);
+        const uint32_t count = FromLittleEndian32(entry + 8);
+        if (offset < indexBegin_ || offset > dataSize_ ||
+            count > (dataSize_ - offset) / 4) {
+            continue;
+        }
+        for (uint32_t j = 0; j < count; j++) {
+            result.insert(FromLittleEndian32(data_ + offset + j * 4));
         }
-        iter++;
     }
 
     return result;
@@ -390,7 +506,7 @@ CharSelectData::findStringResult(uint32_t unicode, size_t countOffset,
         return result;
     }
 
-    const char *data = data_.data();
+    const char *data = data_;
     const uint8_t count = *(uint8_t *)(data + detailIndex + countOffset);
     uint32_t offset = FromLittleEndian32(data + detailIndex + offsetOfOffset);
 
@@ -418,7 +534,7 @@ std::vector<uint32_t> CharSelectData::seeAlso(uint32_t unicode) const {
         return seeAlso;
     }
 
-    const char *data = data_.data();
+    const char *data = data_;
     const uint8_t count = *(uint8_t *)(data + detailIndex + 28);
     uint32_t offset = FromLittleEndian32(data + detailIndex + 24);
 
@@ -444,126 +560,3 @@ CharSelectData::approximateEquivalents(uint32_t unicode) const {
 std::string FormatCode(uint32_t code, int length, const char *prefix) {
     return fmt::format("{0}{1:0{2}x}", prefix, code, length);
 }
-
-void CharSelectData::appendToIndex(uint32_t unicode, const std::string &str) {
-    auto strings = stringutils::split(str, FCITX_WHITESPACE);
-    for (auto &s : strings) {
-        auto iter = index_.find(s);
-        if (iter == index_.end()) {
-            iter = index_.emplace(s, std::vector<uint32_t>()).first;
-        }
-        iter->second.push_back(unicode);
-    }
-}
-
-void CharSelectData::createIndex() {
-    // character names
-    const char *data = data_.data();
-    const uint32_t nameOffsetBegin = FromLittleEndian32(data + 4);
-    const uint32_t nameOffsetEnd = FromLittleEndian32(data + 8);
-
-    int max = ((nameOffsetEnd - nameOffsetBegin) / 8) - 1;
-
-    int pos, j;
-
-    for (pos = 0; pos <= max; pos++) {
-        const uint32_t unicode =
-            FromLittleEndian32(data + nameOffsetBegin + pos * 8);
-        uint32_t offset =
-            FromLittleEndian32(data + nameOffsetBegin + pos * 8 + 4);
-        // TODO
-        appendToIndex(unicode, (data + offset + 1));
-    }
-
-    // details
-    const uint32_t detailsOffsetBegin = FromLittleEndian32(data + 12);
-    const uint32_t detailsOffsetEnd = FromLittleEndian32(data + 16);
-
-    max = ((detailsOffsetEnd - detailsOffsetBegin) / 29) - 1;
-    for (pos = 0; pos <= max; pos++) {
-        const uint32_t unicode =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29);
-
-        // aliases
-        const uint8_t aliasCount =
-            *(uint8_t *)(data + detailsOffsetBegin + pos * 29 + 8);
-        uint32_t aliasOffset =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29 + 4);
-
-        for (j = 0; j < aliasCount; j++) {
-            appendToIndex(unicode, data + aliasOffset);
-            aliasOffset += std::strlen(data + aliasOffset) + 1;
-        }
-
-        // notes
-        const uint8_t notesCount =
-            *(uint8_t *)(data + detailsOffsetBegin + pos * 29 + 13);
-        uint32_t notesOffset =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29 + 9);
-
-        for (j = 0; j < notesCount; j++) {
-            appendToIndex(unicode, data + notesOffset);
-            notesOffset += std::strlen(data + notesOffset) + 1;
-        }
-
-        // approximate equivalents
-        const uint8_t apprCount =
-            *(uint8_t *)(data + detailsOffsetBegin + pos * 29 + 18);
-        uint32_t apprOffset =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29 + 14);
-
-        for (j = 0; j < apprCount; j++) {
-            appendToIndex(unicode, data + apprOffset);
-            apprOffset += strlen(data + apprOffset) + 1;
-        }
-
-        // equivalents
-        const uint8_t equivCount =
-            *(uint8_t *)(data + detailsOffsetBegin + pos * 29 + 23);
-        uint32_t equivOffset =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29 + 19);
-
-        for (j = 0; j < equivCount; j++) {
-            appendToIndex(unicode, data + equivOffset);
-            equivOffset += strlen(data + equivOffset) + 1;
-        }
-
-        // see also - convert to string (hex)
-        const uint8_t seeAlsoCount =
-            *(uint8_t *)(data + detailsOffsetBegin + pos * 29 + 28);
-        uint32_t seeAlsoOffset =
-            FromLittleEndian32(data + detailsOffsetBegin + pos * 29 + 24);
-
-        for (j = 0; j < seeAlsoCount; j++) {
-            uint32_t seeAlso = FromLittleEndian16(data + seeAlsoOffset);
-            auto code = FormatCode(seeAlso, 4, "");
-            appendToIndex(unicode, code);
-            equivOffset += strlen(data + equivOffset) + 1;
-        }
-    }
-
-    // unihan data
-    // temporary disabled due to the huge amount of data
-    const uint32_t unihanOffsetBegin = FromLittleEndian32(data + 36);
-    const uint32_t unihanOffsetEnd = data_.size();
-    max = ((unihanOffsetEnd - unihanOffsetBegin) / 32) - 1;
-
-    for (pos = 0; pos <= max; pos++) {
-        const uint32_t unicode =
-            FromLittleEndian32(data + unihanOffsetBegin + pos * 32);
-        for (j = 0; j < 7; j++) {
-            uint32_t offset = FromLittleEndian32(data + unihanOffsetBegin +
-                                                 pos * 32 + 4 + j * 4);
-            if (offset != 0) {
-                appendToIndex(unicode, (data + offset));
-            }
-        }
-    }
-
-    for (auto &p : index_) {
-        indexList_.push_back(&p);
-    }
-    std::sort(indexList_.begin(), indexList_.end(), [](auto lhs, auto rhs) {
-        return strcasecmp(lhs->first.c_str(), rhs->first.c_str()) < 0;
-    });
-}
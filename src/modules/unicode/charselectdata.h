@@ -7,26 +7,70 @@
 #ifndef _FCITX_MODULES_UNICODE_CHARSELECTDATA_H_
 #define _FCITX_MODULES_UNICODE_CHARSELECTDATA_H_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <set>
 #include <string>
-#include <unordered_map>
 #include <vector>
+#include <fcitx-utils/fs.h>
 
 class CharSelectData {
 public:
     CharSelectData();
+    CharSelectData(const CharSelectData &) = delete;
+    ~CharSelectData();
 
     std::string name(uint32_t unicode) const;
     std::vector<std::string> unihanInfo(uint32_t unicode) const;
-    std::vector<uint32_t> find(const std::string &needle) const;
+    // Characters whose code point is typed come first, then the characters
+    // named exactly as the needle, whose name starts with the needle, and
+    // the rest of the matches. Return at most limit results if it is not 0.
+    std::vector<uint32_t> find(const std::string &needle,
+                               size_t limit = 0) const;
 
     bool load();
 
+    // Drop the cached search result. The data file itself is mapped, so the
+    // kernel can already reclaim its pages.
+    void clearCache() const;
+
 private:
-    void createIndex();
-    void appendToIndex(uint32_t unicode, const std::string &str);
+    // Small direct mapped cache from a character to the offset of its entry,
+    // characters on a candidate page are mostly close to each other.
+    class LookupCache {
+    public:
+        LookupCache() { clear(); }
+
+        void clear() {
+            for (auto &entry : entries_) {
+                entry.unicode = invalidChar;
+            }
+        }
+
+        template <typename Lookup>
+        uint32_t get(uint32_t unicode, Lookup lookup) {
+            auto &entry = entries_[unicode % entries_.size()];
+            if (entry.unicode != unicode) {
+                entry.unicode = unicode;
+                entry.offset = lookup(unicode);
+            }
+            return entry.offset;
+        }
+
+    private:
+        static constexpr uint32_t invalidChar = 0xffffffff;
+        struct Entry {
+            uint32_t unicode;
+            uint32_t offset;
+        };
+        std::array<Entry, 64> entries_;
+    };
+
+    bool loadIndex();
+    const char *indexWord(uint32_t i) const;
     uint32_t findDetailIndex(uint32_t unicode) const;
+    uint32_t findNameOffset(uint32_t unicode) const;
 
     std::vector<std::string> findStringResult(uint32_t unicode,
                                               size_t countOffset,
@@ -42,9 +86,18 @@ private:
 
     bool loaded_ = false;
     bool loadResult_ = false;
-    std::vector<char> data_;
-    std::unordered_map<std::string, std::vector<uint32_t>> index_;
-    std::vector<const decltype(index_)::value_type *> indexList_;
+    // Data file, with the search index built by gen.py at the end.
+    fcitx::fs::FileView file_;
+    const char *data_ = nullptr;
+    size_t dataSize_ = 0;
+    uint32_t unihanOffsetEnd_ = 0;
+    uint32_t indexBegin_ = 0;
+    uint32_t indexSize_ = 0;
+    mutable LookupCache detailCache_;
+    mutable LookupCache nameCache_;
+    // Matches of the last search, reused if the needle is extended.
+    mutable std::string lastSearch_;
+    mutable std::set<uint32_t> lastMatches_;
 };
 
 #endif // _FCITX_MODULES_UNICODE_CHARSELECTDATA_H_/
@@ -81,6 +81,21 @@
 # 32bit: offset to unihan_strings for Korean
 # 32bit: offset to unihan_strings for JapaneseKun
 # 32bit: offset to unihan_strings for JapaneseOn
+#
+# search_index:
+# follows unihan_offsets, and is located by the last 8 bytes of the file
+# 32bit: search index begin
+# 32bit: magic "CSIX"
+#
+# The index contains every word of the names, details and unihan strings,
+# ASCII lower cased and sorted, so the word list can be binary searched.
+# 32bit: word count
+# then an entry of 12 bytes for each word
+# 32bit: offset to the word
+# 32bit: offset to the characters
+# 32bit: character count
+# followed by the characters of all words as sorted uint32, and the words,
+# each terminated by 0x00.
 
 from struct import *
 import sys
@@ -783,6 +798,58 @@ class Unihan:
             pos += 32
         return pos
 
+class SearchIndex:
+    def __init__(self):
+        self.index = {}
+        self.words = []
+
+    def addText(self, uni, text):
+        for word in text.encode('utf-8').lower().split():
+            if word not in self.index:
+                self.index[word] = set()
+            self.index[word].add(uni)
+
+    def addNames(self, names):
+        for entry in names.names:
+            self.addText(int(entry[0], 16), entry[1])
+
+    def addDetails(self, details):
+        for char in details.details.keys():
+            for cat in details.details[char].values():
+                for s in cat:
+                    if type(s) is str:
+                        self.addText(char, s)
+                    else:
+                        self.addText(char, "%04x" % s)
+
+    def addUnihan(self, unihan):
+        for char in unihan.unihan.keys():
+            for entry in unihan.unihan[char]:
+                if entry != None:
+                    self.addText(char, entry)
+
+    def calculateSize(self):
+        size = 4
+        for word, chars in self.index.items():
+            size += 12 + len(chars) * 4 + len(word) + 1
+        return size
+
+    def write(self, out, pos):
+        self.words = sorted(self.index.keys())
+        charsPos = pos + 4 + len(self.words) * 12
+        wordPos = charsPos + sum(len(chars) for chars in self.index.values()) * 4
+        out.write(pack("=I", len(self.words)))
+        for word in self.words:
+            out.write(pack("=III", wordPos, charsPos, len(self.index[word])))
+            charsPos += len(self.index[word]) * 4
+            wordPos += len(word) + 1
+        for word in self.words:
+            for char in sorted(self.index[word]):
+                out.write(pack("=I", char))
+        for word in self.words:
+            out.write(word + b"\0")
+        return pos + self.calculateSize()
+
 class Parser:
     def parseUnicodeData(self, inUnicodeData, names):
         regexp = re.compile(r'^([^;]+);([^;]+);([^;]+)')
@@ -925,6 +992,11 @@ parser.parseUnihan(inUnihan, unihan)
 print("\b.", end=' ')
 sys.stdout.flush()
 
+index = SearchIndex()
+index.addNames(names)
+index.addDetails(details)
+index.addUnihan(unihan)
+
 print("done.")
 
 pos = 0
@@ -970,7 +1042,8 @@ unihanOffsetBegin = unihanStringBegin + unihan.calculateStringSize()
 out.write(pack("=I", unihanOffsetBegin))
 print("unihan offsets begin", unihanOffsetBegin)
 
-end = unihanOffsetBegin + unihan.calculateOffsetSize()
+indexBegin = unihanOffsetBegin + unihan.calculateOffsetSize()
+end = indexBegin + index.calculateSize() + 8
 print("end should be", end)
 
 pos += 40
@@ -998,6 +1071,11 @@ pos = unihan.writeStrings(out, pos)
 print("unihan strings written, position", pos)
 pos = unihan.writeOffsets(out, pos)
 print("unihan offsets written, position", pos)
+pos = index.write(out, pos)
+out.write(pack("=I", indexBegin))
+out.write(b"CSIX")
+pos += 8
+print("search index written, position", pos)
 
 print("========== writing translation dummy  ======")
 translationData = [["KCharSelect section name", sectionsBlocks.getSectionList()], ["KCharselect unicode block name",sectionsBlocks.getBlockList()]]
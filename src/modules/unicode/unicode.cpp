@@ -17,6 +17,9 @@
 
 namespace fcitx {
 
+// A common word may match thousands of characters, nobody pages that far.
+constexpr size_t searchLimit = 500;
+
 enum class UnicodeMode {
     Off = 0,
     Search,
@@ -62,8 +65,10 @@ public:
 Unicode::Unicode(Instance *instance)
     : instance_(instance),
       factory_([this](InputContext &) { return new UnicodeState(this); }) {
+    factory_.setCreateOnDemand(true);
     instance_->inputContextManager().registerProperty("unicodeState",
                                                       &factory_);
+    setTrimMemoryCallback([this](MemoryTrimLevel) { data_.clearCache(); });
 
     KeySym syms[] = {
         FcitxKey_1, FcitxKey_2, FcitxKey_3, FcitxKey_4, FcitxKey_5,
@@ -362,15 +367,23 @@ void Unicode::updateUI(InputContext *inputContext, bool trigger) {
         }
     } else if (state->mode_ == UnicodeMode::Search) {
         if (!state->buffer_.empty()) {
-            auto result = data_.find(state->buffer_.userInput());
-            auto candidateList = std::make_unique<CommonCandidateList>();
+            // Common query may match thousands of characters, only create
+            // the candidates that are shown.
+            auto candidateList = std::make_unique<LazyCandidateList>(
+                [this,
+                 result = data_.find(state->buffer_.userInput(), searchLimit),
+                 iter = size_t(0)]() mutable
+                -> std::unique_ptr<CandidateWord> {
+                    for (; iter < result.size(); iter++) {
+                        if (utf8::UCS4IsValid(result[iter])) {
+                            return std::make_unique<UnicodeCandidateWord>(
+                                this, result[iter++]);
+                        }
+                    }
+                    return nullptr;
+                });
             candidateList->setPageSize(
                 instance_->globalConfig().defaultPageSize());
-            for (auto chr : result) {
-                if (utf8::UCS4IsValid(chr)) {
-                    candidateList->append<UnicodeCandidateWord>(this, chr);
-                }
-            }
             if (!candidateList->empty()) {
                 candidateList->setGlobalCursorIndex(0);
             }
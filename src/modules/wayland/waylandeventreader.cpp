@@ -14,7 +14,8 @@ namespace fcitx {
 
 WaylandEventReader::WaylandEventReader(WaylandConnection *conn)
     : module_(conn->parent()), conn_(conn), display_(*conn_->display()),
-      dispatcherToMain_(module_->instance()->eventDispatcher()) {
+      dispatcherToMain_(module_->instance()->eventDispatcher()),
+      thread_(module_->readerThread(conn->name())) {
     postEvent_ = module_->instance()->eventLoop().addPostEvent(
         [this](EventSource *source) {
             if (wl_display_get_error(display_)) {
@@ -24,61 +25,49 @@ WaylandEventReader::WaylandEventReader(WaylandConnection *conn)
             FCITX_WAYLAND_DEBUG() << "wl_display_flush";
             display_.flush();
             return true;
-        });
+        },
+        "Wayland/Flush");
     // Actively trigger an initial dispatch so we can make sure:
     // 1. depending even before this WaylandEventReader are handled.
     // 2. prepare_read is called.
     dispatcherToMain_.scheduleWithContext(watch(), [this]() { dispatch(); });
-    thread_ =
-        std::make_unique<std::thread>(&WaylandEventReader::runThread, this);
-}
-WaylandEventReader::~WaylandEventReader() {
-    if (thread_->joinable()) {
-        quit();
-        thread_->join();
-    }
+    thread_.schedule([this]() {
+        ioEvent_ = thread_.eventLoop().addIOEvent(
+            display_.fd(), IOEventFlag::In,
+            [this](EventSource *, int, IOEventFlags flags) {
+                if (!onIOEvent(flags)) {
+                    ioEvent_.reset();
+                }
+                return true;
+            });
+    });
 }
 
-void WaylandEventReader::run() {
-    EventLoop event;
-    dispatcherToWorker_.attach(&event);
-    int fd = display_.fd();
-    std::unique_ptr<EventSourceIO> ioEvent;
-    ioEvent = event.addIOEvent(
-        fd, IOEventFlag::In,
-        [this, &ioEvent](EventSource *, int, IOEventFlags flags) {
-            if (!onIOEvent(flags)) {
-                ioEvent.reset();
-            }
-            return true;
-        });
-
-    event.exec();
-    ioEvent.reset();
-    dispatcherToWorker_.detach();
+WaylandEventReader::~WaylandEventReader() {
     {
         const std::lock_guard lock(mutex_);
-        if (isReading_) {
-            wl_display_cancel_read(display_);
-        }
+        quitting_ = true;
+    }
+    // Also waits for everything scheduled by this reader on the thread.
+    thread_.call([this]() { ioEvent_.reset(); });
+    const std::lock_guard lock(mutex_);
+    if (isReading_) {
+        wl_display_cancel_read(display_);
     }
 }
 
 bool WaylandEventReader::onIOEvent(IOEventFlags flags) {
     {
-        // Make sure previous dispatch ended.
-        std::unique_lock lock(mutex_);
-        condition_.wait(lock, [this, &lock] {
-            assert(lock.owns_lock());
-            return quitting_ || isReading_;
-        });
-
-        assert(lock.owns_lock());
-
+        const std::lock_guard lock(mutex_);
         if (quitting_) {
             return false;
         }
-
+        // The reader thread is shared, so never block here. The event is
+        // enabled again once the previous dispatch ended.
+        ioEvent_->setEnabled(false);
+        if (!isReading_) {
+            return true;
+        }
         isReading_ = false;
     }
 
@@ -99,15 +88,12 @@ void WaylandEventReader::quit() {
     {
         std::lock_guard lock(mutex_);
         quitting_ = true;
-        condition_.notify_one();
     }
     // Allow quit to be called from both main thread and reader thread.
-    dispatcherToWorker_.schedule([dispatcher = &dispatcherToWorker_]() {
-        dispatcher->eventLoop()->exit();
-    });
+    thread_.schedule([this]() { ioEvent_.reset(); });
 
     // Make sure the connection will be removed.
-    // The destructor will join the reader thread so it's ok.
+    // The destructor will wait for the reader thread so it's ok.
     dispatcherToMain_.scheduleWithContext(
         watch(), [module = module_, name = conn_->name()]() {
             module->removeConnection(name);
@@ -138,8 +124,12 @@ void WaylandEventReader::dispatch() {
     {
         std::lock_guard lk(mutex_);
         isReading_ = true;
-        condition_.notify_one();
     }
+    thread_.schedule([this]() {
+        if (ioEvent_) {
+            ioEvent_->setEnabled(true);
+        }
+    });
 }
 
 } // namespace fcitx
\ No newline at end of file
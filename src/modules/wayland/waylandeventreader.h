@@ -7,11 +7,11 @@
 #ifndef _FCITX_MODULES_WAYLAND_WAYLANDEVENTREADER_H_
 #define _FCITX_MODULES_WAYLAND_WAYLANDEVENTREADER_H_
 
-#include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <thread>
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/eventloopthread_p.h"
 #include "fcitx-utils/trackableobject.h"
 #include "display.h"
 
@@ -26,8 +26,6 @@ public:
     ~WaylandEventReader();
 
 private:
-    static void runThread(WaylandEventReader *self) { self->run(); }
-    void run();
     bool onIOEvent(IOEventFlags flags);
     void dispatch();
     void quit();
@@ -36,16 +34,17 @@ private:
     WaylandConnection *conn_;
     wayland::Display &display_;
     EventDispatcher &dispatcherToMain_;
-    EventDispatcher dispatcherToWorker_;
+    // May be shared with the other connections of the module.
+    EventLoopThread &thread_;
     std::unique_ptr<EventSource> postEvent_;
+    // Only accessed on the reader thread.
+    std::unique_ptr<EventSourceIO> ioEvent_;
 
     // Protected by mutex_;
     bool quitting_ = false;
     bool isReading_ = false;
 
-    std::unique_ptr<std::thread> thread_;
     std::mutex mutex_;
-    std::condition_variable condition_;
 };
 } // namespace fcitx
 
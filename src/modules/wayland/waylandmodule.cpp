@@ -364,8 +364,12 @@ void WaylandModule::removeConnection(const std::string &name) {
     }
     auto iter = conns_.find(name);
     if (iter != conns_.end()) {
+        // name may refer to the member of the connection.
+        std::string localName = name;
         onConnectionClosed(*iter->second);
         conns_.erase(iter);
+        // The reader of the connection is gone with it.
+        displayReaderThreads_.erase(localName);
         refreshCanRestart();
     }
 }
@@ -677,6 +681,20 @@ void WaylandModule::selfDiagnose() {
     }
 }
 
+EventLoopThread &WaylandModule::readerThread(const std::string &name) {
+    if (*config_.readerThreadPerDisplay) {
+        auto &thread = displayReaderThreads_[name];
+        if (!thread) {
+            thread = std::make_unique<EventLoopThread>();
+        }
+        return *thread;
+    }
+    if (!readerThread_) {
+        readerThread_ = std::make_unique<EventLoopThread>();
+    }
+    return *readerThread_;
+}
+
 std::optional<std::tuple<int32_t, int32_t>>
 WaylandModule::repeatInfo(const std::string &name, wl_seat *seat) const {
     if (!seat) {
@@ -13,6 +13,7 @@
 #include <wayland-client-protocol.h>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/event.h"
+#include "fcitx-utils/eventloopthread_p.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/log.h"
 #include "fcitx/addoninstance.h"
@@ -32,7 +33,10 @@ FCITX_CONFIGURATION(
     WaylandConfig,
     Option<bool> allowOverrideXKB{
         this, "Allow Overriding System XKB Settings",
-        _("Allow Overriding System XKB Settings (Only support KDE 5)"), true};);
+        _("Allow Overriding System XKB Settings (Only support KDE 5)"), true};
+    Option<bool> readerThreadPerDisplay{
+        this, "ReaderThreadPerDisplay",
+        _("Read each display on its own thread"), false};);
 
 class WaylandKeyboard {
 public:
@@ -134,6 +138,10 @@ public:
 
     void selfDiagnose();
 
+    // The thread reading the events of the connection, started on demand.
+    // All connections share one thread unless ReaderThreadPerDisplay is set.
+    EventLoopThread &readerThread(const std::string &name);
+
     std::optional<std::tuple<int32_t, int32_t>>
     repeatInfo(const std::string &name, wl_seat *seat) const;
 
@@ -152,6 +160,10 @@ private:
     Instance *instance_;
     WaylandConfig config_;
     bool isWaylandSession_ = false;
+    // Must outlive the connections.
+    std::unique_ptr<EventLoopThread> readerThread_;
+    std::unordered_map<std::string, std::unique_ptr<EventLoopThread>>
+        displayReaderThreads_;
     std::unordered_map<std::string, std::unique_ptr<WaylandConnection>> conns_;
     HandlerTable<WaylandConnectionCreated> createdCallbacks_;
     HandlerTable<WaylandConnectionClosed> closedCallbacks_;
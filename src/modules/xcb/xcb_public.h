@@ -9,6 +9,7 @@
 
 #include <string>
 #include <tuple>
+#include <vector>
 #include <fcitx-utils/handlertable.h>
 #include <fcitx-utils/metastring.h>
 #include <fcitx/addoninstance.h>
@@ -54,6 +55,10 @@ FCITX_ADDON_DECLARE_FUNCTION(XCBModule, setXkbOption,
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, mainDisplay, std::string());
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, isXWayland, bool(const std::string &));
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, exists, bool(const std::string &name));
+// Flush the connection at the end of current main loop iteration, after
+// writing requests outside of an event filter.
+FCITX_ADDON_DECLARE_FUNCTION(XCBModule, scheduleFlush,
+                             void(const std::string &name));
 
 #ifndef FCITX_NO_XCB
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, addEventFilter,
@@ -74,6 +79,9 @@ FCITX_ADDON_DECLARE_FUNCTION(XCBModule, ewmh,
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, atom,
                              xcb_atom_t(const std::string &,
                                         const std::string &, bool));
+FCITX_ADDON_DECLARE_FUNCTION(XCBModule, prefetchAtoms,
+                             void(const std::string &,
+                                  const std::vector<std::string> &, bool));
 FCITX_ADDON_DECLARE_FUNCTION(
     XCBModule, addSelection,
     std::unique_ptr<HandlerTableEntry<XCBSelectionNotifyCallback>>(
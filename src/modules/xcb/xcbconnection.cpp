@@ -6,7 +6,11 @@
  */
 
 #include "xcbconnection.h"
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include <fmt/format.h>
 #include <xcb/randr.h>
 #include <xcb/xcb.h>
@@ -106,6 +110,11 @@ XCBConnection::XCBConnection(XCBModule *xcb, const std::string &name)
         throw std::runtime_error("Failed to open xcb connection");
     }
 
+    // Intern the atoms needed during setup at once, to avoid a round trip
+    // for each of them on a high latency connection.
+    prefetchAtoms({"_FCITX_SERVER", "UTF8_STRING", "_XKB_RULES_NAMES", "INCR"},
+                  false);
+
     // Create atom for ourselves
     atom_ = atom("_FCITX_SERVER", false);
     if (!atom_) {
@@ -114,9 +123,11 @@ XCBConnection::XCBConnection(XCBModule *xcb, const std::string &name)
     xcb_window_t w = xcb_generate_id(conn_.get());
     xcb_screen_t *screen = xcb_aux_get_screen(conn_.get(), screen_);
     root_ = screen->root;
+    // Property change is needed for incremental selection transfer.
+    const uint32_t eventMask = XCB_EVENT_MASK_PROPERTY_CHANGE;
     xcb_create_window(conn_.get(), XCB_COPY_FROM_PARENT, w, screen->root, 0, 0,
                       1, 1, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
-                      screen->root_visual, 0, nullptr);
+                      screen->root_visual, XCB_CW_EVENT_MASK, &eventMask);
 
     xcb_set_selection_owner(conn_.get(), w, atom_, XCB_CURRENT_TIME);
     serverWindow_ = w;
@@ -160,25 +171,29 @@ XCBConnection::XCBConnection(XCBModule *xcb, const std::string &name)
 
     keyboard_ = std::make_unique<XCBKeyboard>(this);
 
+    // Send the xfixes and ewmh requests together and wait for the replies
+    // afterwards.
+    const auto *xfixesReply =
+        xcb_get_extension_data(conn_.get(), &xcb_xfixes_id);
+    std::optional<xcb_xfixes_query_version_cookie_t> xfixesQueryCookie;
+    if (xfixesReply && xfixesReply->present) {
+        xfixesQueryCookie =
+            xcb_xfixes_query_version(conn_.get(), XCB_XFIXES_MAJOR_VERSION,
+                                     XCB_XFIXES_MINOR_VERSION);
+    }
+    memset(&ewmh_, 0, sizeof(ewmh_));
+    xcb_intern_atom_cookie_t *cookie = xcb_ewmh_init_atoms(conn_.get(), &ewmh_);
+
     // init xfixes
-    {
-        const auto *reply = xcb_get_extension_data(conn_.get(), &xcb_xfixes_id);
-        if (reply && reply->present) {
-
-            xcb_xfixes_query_version_cookie_t xfixes_query_cookie =
-                xcb_xfixes_query_version(conn_.get(), XCB_XFIXES_MAJOR_VERSION,
-                                         XCB_XFIXES_MINOR_VERSION);
-            auto xfixes_query = makeUniqueCPtr(xcb_xfixes_query_version_reply(
-                conn_.get(), xfixes_query_cookie, nullptr));
-            if (xfixes_query && xfixes_query->major_version >= 2) {
-                hasXFixes_ = true;
-                xfixesFirstEvent_ = reply->first_event;
-            }
+    if (xfixesQueryCookie) {
+        auto xfixes_query = makeUniqueCPtr(xcb_xfixes_query_version_reply(
+            conn_.get(), *xfixesQueryCookie, nullptr));
+        if (xfixes_query && xfixes_query->major_version >= 2) {
+            hasXFixes_ = true;
+            xfixesFirstEvent_ = xfixesReply->first_event;
         }
     }
     /// init ewmh
-    memset(&ewmh_, 0, sizeof(ewmh_));
-    xcb_intern_atom_cookie_t *cookie = xcb_ewmh_init_atoms(conn_.get(), &ewmh_);
     if (cookie) {
         // They will wipe for us. and cookie will be free'd anyway.
         if (!xcb_ewmh_init_atoms_replies(&ewmh_, cookie, nullptr)) {
@@ -222,6 +237,7 @@ void XCBConnection::setDoGrab(bool doGrab) {
             ungrabKey();
         }
         doGrab_ = doGrab;
+        scheduleFlush();
     }
 }
 
@@ -328,6 +344,7 @@ void XCBConnection::ungrabXKeyboard() {
     FCITX_XCB_DEBUG() << "Ungrab keyboard for display: " << name_;
     keyboardGrabbed_ = false;
     xcb_ungrab_keyboard(conn_.get(), XCB_CURRENT_TIME);
+    scheduleFlush();
 }
 
 void XCBConnection::processEvent() {
@@ -339,9 +356,19 @@ void XCBConnection::processEvent() {
             }
         }
     }
+    // Filters usually reply to the events they handle.
+    if (!events.empty()) {
+        scheduleFlush();
+    }
     reader_->wakeUp();
 }
 
+void XCBConnection::scheduleFlush() {
+    if (reader_) {
+        reader_->scheduleFlush();
+    }
+}
+
 bool XCBConnection::filterEvent(xcb_connection_t *,
                                 xcb_generic_event_t *event) {
     uint8_t response_type = event->response_type & ~0x80;
@@ -380,27 +407,20 @@ bool XCBConnection::filterEvent(xcb_connection_t *,
                 callback.selection() != selectionNotify->selection) {
                 continue;
             }
-
-            do {
-                constexpr size_t bufLimit = 256;
-                xcb_get_property_cookie_t get_prop_cookie = xcb_get_property(
-                    conn_.get(), false, serverWindow_,
-                    selectionNotify->property, XCB_ATOM_ANY, 0, bufLimit);
-
-                auto reply = makeUniqueCPtr(xcb_get_property_reply(
-                    conn_.get(), get_prop_cookie, nullptr));
-                const char *data = nullptr;
-                int length = 0;
-                xcb_atom_t type = XCB_ATOM_NONE;
-                if (reply && reply->type != XCB_NONE &&
-                    reply->bytes_after == 0) {
-                    type = reply->type;
-                    data = static_cast<const char *>(
-                        xcb_get_property_value(reply.get()));
-                    length = xcb_get_property_value_length(reply.get());
-                }
-                callback.handleReply(type, data, length);
-            } while (0);
+            callback.handleSelectionNotify(selectionNotify->property);
+        }
+    } else if (response_type == XCB_PROPERTY_NOTIFY) {
+        auto *propertyNotify =
+            reinterpret_cast<xcb_property_notify_event_t *>(event);
+        if (propertyNotify->window != serverWindow_ ||
+            propertyNotify->state != XCB_PROPERTY_NEW_VALUE) {
+            return false;
+        }
+        for (auto &callback : convertSelections_.view()) {
+            if (callback.isIncremental() &&
+                callback.property() == propertyNotify->atom) {
+                callback.handlePropertyNotify();
+            }
         }
     } else if (response_type == XCB_KEY_PRESS) {
 #define USED_MASK                                                              \
@@ -571,10 +591,12 @@ void XCBConnection::addSelectionAtom(xcb_atom_t atom) {
         XCB_XFIXES_SELECTION_EVENT_MASK_SET_SELECTION_OWNER |
             XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_WINDOW_DESTROY |
             XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_CLIENT_CLOSE);
+    scheduleFlush();
 }
 
 void XCBConnection::removeSelectionAtom(xcb_atom_t atom) {
     xcb_xfixes_select_selection_input(conn_.get(), serverWindow_, atom, 0);
+    scheduleFlush();
 }
 
 xcb_atom_t XCBConnection::atom(const std::string &atomName, bool exists) {
@@ -582,24 +604,45 @@ xcb_atom_t XCBConnection::atom(const std::string &atomName, bool exists) {
         return *atomP;
     }
 
-    xcb_intern_atom_cookie_t cookie =
-        xcb_intern_atom(conn_.get(), exists, atomName.size(), atomName.c_str());
-    auto reply =
-        makeUniqueCPtr(xcb_intern_atom_reply(conn_.get(), cookie, nullptr));
-    xcb_atom_t result = XCB_ATOM_NONE;
-    if (reply) {
-        result = reply->atom;
+    prefetchAtoms({atomName}, exists);
+    if (auto *atomP = findValue(atomCache_, atomName)) {
+        return *atomP;
+    }
+    return XCB_ATOM_NONE;
+}
+
+void XCBConnection::prefetchAtoms(const std::vector<std::string> &atomNames,
+                                  bool exists) {
+    std::vector<std::pair<const std::string *, xcb_intern_atom_cookie_t>>
+        cookies;
+    for (const auto &atomName : atomNames) {
+        if (atomCache_.count(atomName)) {
+            continue;
+        }
+        cookies.emplace_back(
+            &atomName, xcb_intern_atom(conn_.get(), exists, atomName.size(),
+                                       atomName.c_str()));
     }
-    if (result != XCB_ATOM_NONE || !exists) {
-        atomCache_.emplace(std::make_pair(atomName, result));
+
+    // All requests are sent before waiting for any reply.
+    for (const auto &[atomName, cookie] : cookies) {
+        auto reply = makeUniqueCPtr(
+            xcb_intern_atom_reply(conn_.get(), cookie, nullptr));
+        xcb_atom_t result = XCB_ATOM_NONE;
+        if (reply) {
+            result = reply->atom;
+        }
+        if (result != XCB_ATOM_NONE || !exists) {
+            atomCache_.emplace(*atomName, result);
+        }
     }
-    return result;
 }
 
 xcb_ewmh_connection_t *XCBConnection::ewmh() { return &ewmh_; }
 
 void XCBConnection::setXkbOption(const std::string &option) {
     keyboard_->setXkbOption(option);
+    scheduleFlush();
 }
 
 std::unique_ptr<HandlerTableEntry<XCBSelectionNotifyCallback>>
@@ -616,6 +659,11 @@ std::unique_ptr<HandlerTableEntryBase>
 XCBConnection::convertSelection(const std::string &selection,
                                 const std::string &type,
                                 XCBConvertSelectionCallback callback) {
+    std::vector<std::string> existingAtoms{selection};
+    if (!type.empty()) {
+        existingAtoms.push_back(type);
+    }
+    prefetchAtoms(existingAtoms, true);
     auto atomValue = atom(selection, true);
     if (atomValue == XCB_ATOM_NONE) {
         return nullptr;
@@ -636,8 +684,10 @@ XCBConnection::convertSelection(const std::string &selection,
         return nullptr;
     }
 
-    return convertSelections_.add(this, atomValue, typeAtom, propertyAtom,
-                                  std::move(callback));
+    auto request = convertSelections_.add(this, atomValue, typeAtom,
+                                          propertyAtom, std::move(callback));
+    scheduleFlush();
+    return request;
 }
 
 Instance *XCBConnection::instance() { return parent_->instance(); }
@@ -8,6 +8,7 @@
 #define _FCITX_MODULES_XCB_XCBCONNECTION_H_
 
 #include <string>
+#include <vector>
 #include <fcitx/instance.h>
 #include <xcb/xcb_keysyms.h>
 #include "fcitx-utils/handlertable.h"
@@ -49,12 +50,16 @@ public:
 
     void convertSelectionRequest(const XCBConvertSelectionRequest &request);
     xcb_atom_t atom(const std::string &atomName, bool exists);
+    // Intern all atoms that are not cached yet with a single round trip.
+    void prefetchAtoms(const std::vector<std::string> &atomNames, bool exists);
     xcb_ewmh_connection_t *ewmh();
     bool isXWayland() const { return isXWayland_; }
 
     void setXkbOption(const std::string &option);
 
     void processEvent();
+    // Flush the connection once at the end of current main loop iteration.
+    void scheduleFlush();
     void modifierUpdate(KeyStates states);
 
 private:
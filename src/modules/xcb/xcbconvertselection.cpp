@@ -5,18 +5,33 @@
  *
  */
 #include "xcbconvertselection.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include "fcitx-utils/misc.h"
 #include "xcb_public.h"
 #include "xcbconnection.h"
 #include "xcbmodule.h"
 
 namespace fcitx {
 
+namespace {
+
+// Timeout for the whole conversion, or between two chunks of an incremental
+// transfer.
+constexpr uint64_t ConvertSelectionTimeout = 5000000;
+
+} // namespace
+
 XCBConvertSelectionRequest::XCBConvertSelectionRequest(
     XCBConnection *conn, xcb_atom_t selection, xcb_atom_t type,
     xcb_atom_t property, XCBConvertSelectionCallback callback)
 
     : conn_(conn), selection_(selection), property_(property),
-      realCallback_(std::move(callback)) {
+      realCallback_(std::move(callback)),
+      sizeLimit_(
+          static_cast<size_t>(*conn->parent()->config().maxSelectionSize) *
+          1024) {
     if (type == 0) {
         fallbacks_.push_back(XCB_ATOM_STRING);
         auto utf8Atom = conn->atom("UTF8_STRING", false);
@@ -30,7 +45,7 @@ XCBConvertSelectionRequest::XCBConvertSelectionRequest(
     xcb_convert_selection(conn->connection(), conn->serverWindow(), selection_,
                           fallbacks_.back(), property_, XCB_TIME_CURRENT_TIME);
     timer_ = conn->parent()->instance()->eventLoop().addTimeEvent(
-        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 5000000, 0,
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + ConvertSelectionTimeout, 0,
         [this](EventSourceTime *, uint64_t) {
             invokeCallbackAndCleanUp(XCB_ATOM_NONE, nullptr, 0);
             return true;
@@ -40,6 +55,101 @@ XCBConvertSelectionRequest::XCBConvertSelectionRequest(
 void XCBConvertSelectionRequest::cleanUp() {
     realCallback_ = decltype(realCallback_)();
     timer_.reset();
+    incremental_ = false;
+    buffer_ = decltype(buffer_)();
+}
+
+void XCBConvertSelectionRequest::resetTimer() {
+    if (timer_) {
+        timer_->setNextInterval(ConvertSelectionTimeout);
+        timer_->setOneShot();
+    }
+}
+
+void XCBConvertSelectionRequest::handleSelectionNotify(xcb_atom_t property) {
+    if (!realCallback_) {
+        return;
+    }
+    if (property == XCB_ATOM_NONE) {
+        return handleReply(XCB_ATOM_NONE, nullptr, 0);
+    }
+
+    // Request one more unit than the limit, so bytes_after tells whether the
+    // property is too large.
+    auto cookie = xcb_get_property(conn_->connection(), false,
+                                   conn_->serverWindow(), property_,
+                                   XCB_ATOM_ANY, 0, sizeLimit_ / 4 + 1);
+    auto reply = makeUniqueCPtr(
+        xcb_get_property_reply(conn_->connection(), cookie, nullptr));
+    if (!reply || reply->type == XCB_ATOM_NONE) {
+        return handleReply(XCB_ATOM_NONE, nullptr, 0);
+    }
+
+    const auto *data =
+        static_cast<const char *>(xcb_get_property_value(reply.get()));
+    size_t length = xcb_get_property_value_length(reply.get());
+    if (reply->type == conn_->atom("INCR", false)) {
+        // The value of INCR is a lower bound of the total size.
+        uint32_t lowerBound = 0;
+        if (length >= sizeof(lowerBound)) {
+            memcpy(&lowerBound, data, sizeof(lowerBound));
+        }
+        if (lowerBound > sizeLimit_) {
+            FCITX_XCB_DEBUG() << "Selection is too large: " << lowerBound;
+            return invokeCallbackAndCleanUp(XCB_ATOM_NONE, nullptr, 0);
+        }
+        // Deleting the property asks the owner to send the first chunk, each
+        // chunk is then read from its own PropertyNotify.
+        incremental_ = true;
+        buffer_.clear();
+        resetTimer();
+        xcb_delete_property(conn_->connection(), conn_->serverWindow(),
+                            property_);
+        return;
+    }
+
+    if (reply->bytes_after != 0 || length > sizeLimit_) {
+        FCITX_XCB_DEBUG() << "Selection exceeds size limit.";
+        return handleReply(XCB_ATOM_NONE, nullptr, 0);
+    }
+    handleReply(reply->type, data, length);
+}
+
+void XCBConvertSelectionRequest::handlePropertyNotify() {
+    if (!realCallback_ || !incremental_) {
+        return;
+    }
+
+    // Never read beyond the limit, deleting the property tells the owner
+    // to send the next chunk.
+    assert(buffer_.size() <= sizeLimit_);
+    auto remain = sizeLimit_ - buffer_.size();
+    auto cookie = xcb_get_property(conn_->connection(), true,
+                                   conn_->serverWindow(), property_,
+                                   XCB_ATOM_ANY, 0, remain / 4 + 1);
+    auto reply = makeUniqueCPtr(
+        xcb_get_property_reply(conn_->connection(), cookie, nullptr));
+    if (!reply || reply->type == XCB_ATOM_NONE) {
+        // Property is not new value, e.g. deleted by ourselves.
+        return;
+    }
+
+    const auto *data =
+        static_cast<const char *>(xcb_get_property_value(reply.get()));
+    size_t length = xcb_get_property_value_length(reply.get());
+    if (length == 0) {
+        // Zero length chunk marks the end of the transfer.
+        auto buffer = std::move(buffer_);
+        incremental_ = false;
+        return handleReply(reply->type, buffer.data(), buffer.size());
+    }
+
+    if (reply->bytes_after != 0 || length > remain) {
+        FCITX_XCB_DEBUG() << "Incremental selection exceeds size limit.";
+        return invokeCallbackAndCleanUp(XCB_ATOM_NONE, nullptr, 0);
+    }
+    buffer_.insert(buffer_.end(), data, data + length);
+    resetTimer();
 }
 
 void XCBConvertSelectionRequest::invokeCallbackAndCleanUp(xcb_atom_t type,
@@ -7,6 +7,9 @@
 #ifndef _FCITX_MODULES_XCB_XCBCONVERTSELECTION_H_
 #define _FCITX_MODULES_XCB_XCBCONVERTSELECTION_H_
 
+#include <cstddef>
+#include <memory>
+#include <vector>
 #include "fcitx-utils/event.h"
 #include "xcb_public.h"
 
@@ -24,14 +27,20 @@ public:
     XCBConvertSelectionRequest(const XCBConvertSelectionRequest &) = delete;
 
     void handleReply(xcb_atom_t type, const char *data, size_t length);
+    // Read the converted property after SelectionNotify.
+    void handleSelectionNotify(xcb_atom_t property);
+    // Read the next chunk of an incremental transfer.
+    void handlePropertyNotify();
 
     xcb_atom_t property() const { return property_; }
     xcb_atom_t selection() const { return selection_; }
+    bool isIncremental() const { return incremental_; }
 
 private:
     void invokeCallbackAndCleanUp(xcb_atom_t type, const char *data,
                                   size_t length);
     void cleanUp();
+    void resetTimer();
 
     XCBConnection *conn_ = nullptr;
     xcb_atom_t selection_ = 0;
@@ -39,6 +48,9 @@ private:
     std::vector<xcb_atom_t> fallbacks_;
     XCBConvertSelectionCallback realCallback_;
     std::unique_ptr<EventSourceTime> timer_;
+    size_t sizeLimit_ = 0;
+    bool incremental_ = false;
+    std::vector<char> buffer_;
 };
 
 } // namespace fcitx
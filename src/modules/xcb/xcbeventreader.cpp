@@ -12,27 +12,39 @@
 
 namespace fcitx {
 XCBEventReader::XCBEventReader(XCBConnection *conn)
-    : conn_(conn), dispatcherToMain_(conn->instance()->eventDispatcher()) {
+    : conn_(conn), dispatcherToMain_(conn->instance()->eventDispatcher()),
+      thread_(conn->parent()->readerThread(conn->name())) {
+    // Only enabled by scheduleFlush(), so all the requests written within
+    // one iteration of the main loop are sent with a single flush.
     postEvent_ =
         conn->instance()->eventLoop().addPostEvent([this](EventSource *source) {
+            source->setEnabled(false);
             if (xcb_connection_has_error(conn_->connection())) {
-                source->setEnabled(false);
                 return true;
             }
             FCITX_XCB_DEBUG() << "xcb_flush";
             xcb_flush(conn_->connection());
             return true;
-        });
-    thread_ = std::make_unique<std::thread>(&XCBEventReader::runThread, this);
+        },
+        "XCB/Flush");
+    scheduleFlush();
+    thread_.schedule([this]() {
+        FCITX_XCB_DEBUG() << "Start reading XCB connection " << conn_->name();
+        int fd = xcb_get_file_descriptor(conn_->connection());
+        ioEvent_ = thread_.eventLoop().addIOEvent(
+            fd, IOEventFlag::In,
+            [this](EventSource *, int, IOEventFlags flags) {
+                if (!onIOEvent(flags)) {
+                    ioEvent_.reset();
+                }
+                return true;
+            });
+    });
 }
 
 XCBEventReader::~XCBEventReader() {
-    if (thread_->joinable()) {
-        dispatcherToWorker_.schedule([dispatcher = &dispatcherToWorker_]() {
-            dispatcher->eventLoop()->exit();
-        });
-        thread_->join();
-    }
+    // Also waits for everything scheduled by this reader on the thread.
+    thread_.call([this]() { ioEvent_.reset(); });
 }
 
 auto nextXCBEvent(xcb_connection_t *conn, IOEventFlags flags) {
@@ -78,30 +90,14 @@ bool XCBEventReader::onIOEvent(IOEventFlags flags) {
     return true;
 }
 
-void XCBEventReader::wakeUp() {
-    dispatcherToWorker_.schedule([this]() { onIOEvent(IOEventFlags{}); });
-}
-
-void XCBEventReader::run() {
-    EventLoop event;
-    dispatcherToWorker_.attach(&event);
+void XCBEventReader::scheduleFlush() { postEvent_->setEnabled(true); }
 
-    FCITX_XCB_DEBUG() << "Start XCBEventReader thread";
-
-    int fd = xcb_get_file_descriptor(conn_->connection());
-    auto ioEvent = event.addIOEvent(
-        fd, IOEventFlag::In,
-        [this, &event](EventSource *, int, IOEventFlags flags) {
-            if (!onIOEvent(flags)) {
-                event.exit();
-            }
-            return true;
-        });
-    event.exec();
-    ioEvent.reset();
-    dispatcherToWorker_.detach();
-
-    FCITX_XCB_DEBUG() << "End XCBEventReader thread";
+void XCBEventReader::wakeUp() {
+    thread_.schedule([this]() {
+        if (!onIOEvent(IOEventFlags{})) {
+            ioEvent_.reset();
+        }
+    });
 }
 
 } // namespace fcitx
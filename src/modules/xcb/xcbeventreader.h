@@ -8,9 +8,9 @@
 #define _FCITX5_MODULES_XCB_XCBEVENTREADER_H_
 
 #include <mutex>
-#include <thread>
 #include <fcitx-utils/event.h>
 #include <fcitx-utils/eventdispatcher.h>
+#include <fcitx-utils/eventloopthread_p.h>
 #include <fcitx-utils/trackableobject.h>
 #include <xcb/xcb.h>
 #include "xcb_public.h"
@@ -32,19 +32,20 @@ public:
         return events;
     }
     void wakeUp();
+    void scheduleFlush();
 
 private:
-    static void runThread(XCBEventReader *self) { self->run(); }
-    void run();
     bool onIOEvent(IOEventFlags flags);
     XCBConnection *conn_;
     EventDispatcher &dispatcherToMain_;
-    EventDispatcher dispatcherToWorker_;
+    // May be shared with the other connections of the module.
+    EventLoopThread &thread_;
+    // Only accessed on the reader thread.
     bool hadError_ = false;
+    std::unique_ptr<EventSourceIO> ioEvent_;
     std::unique_ptr<EventSource> deferEvent_;
     std::unique_ptr<EventSource> wakeEvent_;
     std::unique_ptr<EventSource> postEvent_;
-    std::unique_ptr<std::thread> thread_;
     std::mutex mutex_;
     std::list<UniqueCPtr<xcb_generic_event_t>> events_;
 };
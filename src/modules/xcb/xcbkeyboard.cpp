@@ -12,6 +12,8 @@
 #undef explicit
 
 #include <xcb/xcbext.h>
+#include <functional>
+#include <string_view>
 #include <xkbcommon/xkbcommon-x11.h>
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/stringutils.h"
@@ -178,50 +180,77 @@ void XCBKeyboard::updateKeymap() {
     }
     initDefaultLayout();
 
-    keymap_.reset(nullptr);
-
-    struct xkb_state *new_state = nullptr;
     if (hasXKB_) {
-        keymap_.reset(xkb_x11_keymap_new_from_device(
-            context_.get(), connection(), coreDeviceId_,
-            XKB_KEYMAP_COMPILE_NO_FLAGS));
-        if (keymap_) {
-            new_state = xkb_x11_state_new_from_device(
-                keymap_.get(), connection(), coreDeviceId_);
+        UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap(
+            xkb_x11_keymap_new_from_device(context_.get(), connection(),
+                                           coreDeviceId_,
+                                           XKB_KEYMAP_COMPILE_NO_FLAGS));
+        if (keymap) {
+            // Notifies often do not change anything, e.g. when a device is
+            // plugged again, keep the current keymap and state in that case.
+            auto text = makeUniqueCPtr(xkb_keymap_get_as_string(
+                keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1));
+            const auto hash =
+                text ? std::hash<std::string_view>()(text.get()) : 0;
+            if (text && keymap_ && state_ &&
+                deviceKeymap_ == std::make_pair(coreDeviceId_, hash)) {
+                FCITX_XCB_DEBUG() << "Keymap of device is not changed.";
+                return;
+            }
+            if (auto *newState = xkb_x11_state_new_from_device(
+                    keymap.get(), connection(), coreDeviceId_)) {
+                deviceKeymap_.reset();
+                if (text) {
+                    deviceKeymap_.emplace(coreDeviceId_, hash);
+                }
+                keymap_ = std::move(keymap);
+                state_.reset(newState);
+                return;
+            }
         }
     }
 
-    if (!keymap_) {
-
-        if (!xkbRule_.empty()) {
-            struct xkb_rule_names xkbNames;
-            auto layout = stringutils::join(defaultLayouts_, ',');
-            auto variant = stringutils::join(defaultVariants_, ',');
-            xkbNames.rules = xkbRule_.c_str();
-            xkbNames.model = xkbModel_.c_str();
-            xkbNames.layout = layout.c_str();
-            xkbNames.variant = variant.c_str();
-            xkbNames.options = xkbOptions_.c_str();
+    deviceKeymap_.reset();
+    keymap_.reset(nullptr);
 
-            keymap_.reset(xkb_keymap_new_from_names(
-                context_.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        }
+    // Keymaps compiled from names are shared with the rest of fcitx.
+    xkb_keymap *keymap = nullptr;
+    if (!xkbRule_.empty()) {
+        keymap = conn_->instance()->xkbKeymapFromNames(
+            xkbRule_, xkbModel_, stringutils::join(defaultLayouts_, ','),
+            stringutils::join(defaultVariants_, ','), xkbOptions_);
+    }
 
-        if (!keymap_) {
-            struct xkb_rule_names xkbNames;
-            memset(&xkbNames, 0, sizeof(xkbNames));
-            keymap_.reset(xkb_keymap_new_from_names(
-                context_.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        }
+    if (!keymap) {
+        keymap = conn_->instance()->xkbKeymapFromNames("", "", "", "", "");
+    }
 
-        if (keymap_) {
-            new_state = xkb_state_new(keymap_.get());
-        }
+    struct xkb_state *new_state = nullptr;
+    if (keymap) {
+        keymap_.reset(xkb_keymap_ref(keymap));
+        new_state = xkb_state_new(keymap_.get());
     }
 
     state_.reset(new_state);
 }
 
+void XCBKeyboard::scheduleUpdateKeymap() {
+    // Some devices, e.g. KVM switches and barcode scanners, send a storm of
+    // notifies. Only reload the keymap once they settle down.
+    constexpr uint64_t delay = 30000;
+    if (updateKeymapEvent_) {
+        updateKeymapEvent_->setNextInterval(delay);
+        updateKeymapEvent_->setOneShot();
+        return;
+    }
+    updateKeymapEvent_ = conn_->instance()->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + delay, 0,
+        [this](EventSourceTime *, uint64_t) {
+            updateKeymap();
+            return true;
+        });
+}
+
 xcb_atom_t XCBKeyboard::xkbRulesNamesAtom() {
     if (!xkbRulesNamesAtom_) {
         xkbRulesNamesAtom_ = conn_->atom(_XKB_RF_NAMES_PROP_ATOM, false);
@@ -494,6 +523,7 @@ void XCBKeyboard::setRMLVOToServer(const std::string &rule,
                             propData.data());
     }
     waitingForRefresh_ = true;
+    conn_->scheduleFlush();
 }
 
 bool XCBKeyboard::setLayoutByName(const std::string &layout,
@@ -513,6 +543,7 @@ bool XCBKeyboard::setLayoutByName(const std::string &layout,
 #endif
     xcb_xkb_latch_lock_state(connection(), XCB_XKB_ID_USE_CORE_KBD, 0, 0, true,
                              index, 0, false, 0);
+    conn_->scheduleFlush();
     return true;
 }
 
@@ -526,7 +557,7 @@ bool XCBKeyboard::handleEvent(xcb_generic_event_t *event) {
         auto *property = reinterpret_cast<xcb_property_notify_event_t *>(event);
         if (property->window == conn_->root() &&
             property->atom == xkbRulesNamesAtom()) {
-            updateKeymap();
+            scheduleUpdateKeymap();
         }
         return false;
     }
@@ -561,7 +592,7 @@ bool XCBKeyboard::handleEvent(xcb_generic_event_t *event) {
         }
         case XCB_XKB_MAP_NOTIFY: {
             FCITX_XCB_DEBUG() << "XCB_XKB_MAP_NOTIFY";
-            updateKeymap();
+            scheduleUpdateKeymap();
             return true;
         }
         case XCB_XKB_NEW_KEYBOARD_NOTIFY: {
@@ -569,13 +600,7 @@ bool XCBKeyboard::handleEvent(xcb_generic_event_t *event) {
                 &xkbEvent->new_keyboard_notify;
             FCITX_XCB_DEBUG() << "XCB_XKB_NEW_KEYBOARD_NOTIFY";
             if (ev->changed & XCB_XKB_NKN_DETAIL_KEYCODES) {
-                updateKeymapEvent_ =
-                    conn_->instance()->eventLoop().addTimeEvent(
-                        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 10000, 0,
-                        [this](EventSourceTime *, uint64_t) {
-                            updateKeymap();
-                            return true;
-                        });
+                scheduleUpdateKeymap();
             }
 
             if (!*conn_->parent()->config().allowOverrideXKB) {
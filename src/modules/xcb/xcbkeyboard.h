@@ -7,8 +7,11 @@
 #ifndef _FCITX_MODULES_XCB_XCBKEYBOARD_H_
 #define _FCITX_MODULES_XCB_XCBKEYBOARD_H_
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <xcb/xcb.h>
 #include <xkbcommon/xkbcommon.h>
@@ -24,6 +27,8 @@ public:
 
     xcb_connection_t *connection();
     void updateKeymap();
+    // Update keymap after a short delay, merging the requests in between.
+    void scheduleUpdateKeymap();
 
     // Layout handling
     void initDefaultLayout();
@@ -54,6 +59,8 @@ private:
     UniqueCPtr<struct xkb_context, xkb_context_unref> context_;
     UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap_;
     UniqueCPtr<struct xkb_state, xkb_state_unref> state_;
+    // Device id and hash of the keymap text, if keymap_ is from the device.
+    std::optional<std::pair<int32_t, size_t>> deviceKeymap_;
 
     std::vector<std::string> defaultLayouts_;
     std::vector<std::string> defaultVariants_;
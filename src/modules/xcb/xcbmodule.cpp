@@ -73,6 +73,8 @@ void XCBModule::removeConnection(const std::string &name) {
     std::string localName = name;
     onConnectionClosed(iter->second);
     conns_.erase(iter);
+    // The reader of the connection is gone with it.
+    displayReaderThreads_.erase(localName);
     FCITX_INFO() << "Disconnected from X11 Display " << localName;
     if (localName == mainDisplay_) {
         mainDisplay_.clear();
@@ -171,6 +173,16 @@ xcb_atom_t XCBModule::atom(const std::string &name, const std::string &atom,
     return iter->second.atom(atom, exists);
 }
 
+void XCBModule::prefetchAtoms(const std::string &name,
+                              const std::vector<std::string> &atoms,
+                              bool exists) {
+    auto iter = conns_.find(name);
+    if (iter == conns_.end()) {
+        return;
+    }
+    iter->second.prefetchAtoms(atoms, exists);
+}
+
 xcb_ewmh_connection_t *XCBModule::ewmh(const std::string &name) {
     auto iter = conns_.find(name);
     if (iter == conns_.end()) {
@@ -200,6 +212,28 @@ bool XCBModule::exists(const std::string &name) {
     return conns_.count(name) > 0;
 }
 
+void XCBModule::scheduleFlush(const std::string &name) {
+    auto iter = conns_.find(name);
+    if (iter == conns_.end()) {
+        return;
+    }
+    iter->second.scheduleFlush();
+}
+
+EventLoopThread &XCBModule::readerThread(const std::string &name) {
+    if (*config_.readerThreadPerDisplay) {
+        auto &thread = displayReaderThreads_[name];
+        if (!thread) {
+            thread = std::make_unique<EventLoopThread>();
+        }
+        return *thread;
+    }
+    if (!readerThread_) {
+        readerThread_ = std::make_unique<EventLoopThread>();
+    }
+    return *readerThread_;
+}
+
 class XCBModuleFactory : public AddonFactory {
 public:
     AddonInstance *create(AddonManager *manager) override {
@@ -8,7 +8,9 @@
 #define _FCITX_MODULES_XCB_XCBMODULE_H_
 
 #include <unordered_map>
+#include <vector>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/eventloopthread_p.h"
 #include "fcitx-utils/handlertable.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx/addonfactory.h"
@@ -26,7 +28,14 @@ FCITX_CONFIGURATION(XCBConfig,
                         _("Allow Overriding System XKB Settings"), true};
                     Option<bool> alwaysSetToGroupLayout{
                         this, "AlwaysSetToGroupLayout",
-                        _("Always set layout to be only group layout"), true};);
+                        _("Always set layout to be only group layout"), true};
+                    Option<int, IntConstrain> maxSelectionSize{
+                        this, "MaxSelectionSize",
+                        _("Maximum size of selection to read (KB)"), 64,
+                        IntConstrain(1, 16384)};
+                    Option<bool> readerThreadPerDisplay{
+                        this, "ReaderThreadPerDisplay",
+                        _("Read each display on its own thread"), false};);
 
 class XCBModule final : public AddonInstance {
 public:
@@ -64,12 +73,20 @@ public:
 
     xcb_atom_t atom(const std::string &name, const std::string &atom,
                     bool exists);
+    void prefetchAtoms(const std::string &name,
+                       const std::vector<std::string> &atoms, bool exists);
     xcb_ewmh_connection_t *ewmh(const std::string &name);
     bool isXWayland(const std::string &name);
 
     void setXkbOption(const std::string &name, const std::string &option);
 
     bool exists(const std::string &name);
+    void scheduleFlush(const std::string &name);
+
+    // The thread reading the events of the connection, started on demand.
+    // All connections share one thread unless ReaderThreadPerDisplay is set,
+    // so a slow remote display does not delay reading the others.
+    EventLoopThread &readerThread(const std::string &name);
 
     FCITX_ADDON_DEPENDENCY_LOADER(notifications, instance_->addonManager());
     FCITX_ADDON_DEPENDENCY_LOADER(waylandim, instance_->addonManager());
@@ -80,6 +97,10 @@ private:
 
     Instance *instance_;
     XCBConfig config_;
+    // Must outlive the connections.
+    std::unique_ptr<EventLoopThread> readerThread_;
+    std::unordered_map<std::string, std::unique_ptr<EventLoopThread>>
+        displayReaderThreads_;
     std::unordered_map<std::string, XCBConnection> conns_;
     HandlerTable<XCBConnectionCreated> createdCallbacks_;
     HandlerTable<XCBConnectionClosed> closedCallbacks_;
@@ -94,11 +115,13 @@ private:
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, addSelection);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, convertSelection);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, atom);
+    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, prefetchAtoms);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, ewmh);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, mainDisplay);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, setXkbOption);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, isXWayland);
-    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, exists)
+    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, exists);
+    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, scheduleFlush);
 };
 
 FCITX_DECLARE_LOG_CATEGORY(xcb_log);
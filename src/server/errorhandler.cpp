@@ -49,7 +49,6 @@ void SetMyExceptionHandler() {
             continue;
         case SIGALRM:
         case SIGPIPE:
-        case SIGUSR2:
         case SIGWINCH:
         case SIGURG:
             signal(signo, SIG_IGN);
@@ -113,7 +112,8 @@ static inline void _write_buffer(int fd, const MinimalBuffer *buffer) {
 }
 
 void OnException(int signo) {
-    if (signo == SIGCHLD) {
+    // Forward to the main loop without printing the crash banner.
+    if (signo == SIGCHLD || signo == SIGUSR2) {
         uint8_t sig = (signo & 0xff);
         fcitx::fs::safeWrite(selfpipe[1], &sig, 1);
         signal(signo, OnException);
@@ -5,9 +5,16 @@
  *
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <getopt.h>
 #include "fcitx-utils/dbus/bus.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/utf8.h"
 
 using namespace fcitx;
@@ -42,6 +49,21 @@ void usage(std::ostream &stream) {
            "\t\t\tThe check will be done before sending DBus call to Fcitx.\n"
            "\t\t\tThis can be used to send DBus call only when Fcitx is "
            "running.\n"
+           "\t--event-stats <on|off|reset|show>\n"
+           "\t\t\tControl and display the wakeup statistics of the event "
+           "sources\n"
+           "\t\t\tin fcitx.\n"
+           "\t--memory-usage\tDisplay the approximate memory usage of addons "
+           "and\n"
+           "\t\t\tinput contexts in fcitx.\n"
+           "\t--batch\t\tRead commands from standard input, one per line, "
+           "and\n"
+           "\t\t\tsend them over a single connection. A command is one of\n"
+           "\t\t\tc,o,r,t,e,n,q,x,state, or m,s,g followed by a space and "
+           "the\n"
+           "\t\t\targument. Every command prints one line, \"ok\", \"ok\"\n"
+           "\t\t\tand a tab followed by the result, or \"error\" and a tab\n"
+           "\t\t\tfollowed by the error name.\n"
            "\t[no option]\tdisplay fcitx state, 0 for close, 1 for "
            "inactive, 2 for active\n"
            "\t-h\t\tdisplay this help and exit\n";
@@ -60,8 +82,186 @@ enum {
     FCITX_DBUS_SET_CURRENT_GROUP,
     FCITX_DBUS_GET_CURRENT_GROUP,
     FCITX_DBUS_OPEN_X11_CONNECTION,
+    FCITX_DBUS_SET_EVENT_LOOP_STATISTICS,
+    FCITX_DBUS_RESET_EVENT_LOOP_STATISTICS,
+    FCITX_DBUS_GET_EVENT_LOOP_STATISTICS,
+    FCITX_DBUS_GET_MEMORY_USAGE,
 };
 
+void printEventLoopStatistics(Message &reply) {
+    std::vector<DBusStruct<std::string, uint64_t, uint64_t, uint64_t>> stats;
+    reply >> stats;
+    std::sort(stats.begin(), stats.end(), [](const auto &lhs, const auto &rhs) {
+        return std::get<1>(lhs.data()) > std::get<1>(rhs.data());
+    });
+    const auto current = now(CLOCK_MONOTONIC);
+    std::cout << std::setw(10) << "Count" << std::setw(12) << "Time(ms)"
+              << std::setw(12) << "Last(s)"
+              << "  Tag" << std::endl;
+    for (const auto &stat : stats) {
+        const auto last = std::get<3>(stat.data());
+        std::cout << std::setw(10) << std::get<1>(stat.data()) << std::setw(12)
+                  << std::get<2>(stat.data()) / 1000 << std::setw(12)
+                  << (current > last ? (current - last) / 1000000 : 0) << "  "
+                  << std::get<0>(stat.data()) << std::endl;
+    }
+}
+
+void printMemoryUsage(Message &reply) {
+    std::vector<DBusStruct<std::string, std::string, uint64_t, uint64_t>> usage;
+    reply >> usage;
+    std::stable_sort(
+        usage.begin(), usage.end(), [](const auto &lhs, const auto &rhs) {
+            return std::get<3>(lhs.data()) > std::get<3>(rhs.data());
+        });
+    uint64_t total = 0;
+    std::cout << std::setw(12) << "Size(KiB)" << std::setw(10) << "Count"
+              << "  Kind          Name" << std::endl;
+    for (const auto &item : usage) {
+        const auto bytes = std::get<3>(item.data());
+        total += bytes;
+        std::cout << std::setw(12) << bytes / 1024 << std::setw(10)
+                  << std::get<2>(item.data()) << "  " << std::left
+                  << std::setw(14) << std::get<0>(item.data()) << std::right
+                  << std::get<1>(item.data()) << std::endl;
+    }
+    std::cout << std::setw(12) << total / 1024 << "  Total" << std::endl;
+}
+
+Message createMessage(Bus &bus, const std::string &serviceName,
+                      int messageType) {
+#define CASE(ENUMNAME, MESSAGENAME)                                            \
+    case FCITX_DBUS_##ENUMNAME:                                                \
+        return bus.createMethodCall(serviceName.data(), path, interfaceName,   \
+                                    #MESSAGENAME);
+
+    switch (messageType) {
+        CASE(ACTIVATE, Activate);
+        CASE(DEACTIVATE, Deactivate);
+        CASE(RELOAD_CONFIG, ReloadConfig);
+        CASE(EXIT, Exit);
+        CASE(TOGGLE, Toggle);
+        CASE(GET_CURRENT_STATE, State);
+        CASE(GET_IM_ADDON, AddonForIM);
+        CASE(GET_CURRENT_IM, CurrentInputMethod);
+        CASE(SET_CURRENT_IM, SetCurrentIM);
+        CASE(GET_CURRENT_GROUP, CurrentInputMethodGroup);
+        CASE(SET_CURRENT_GROUP, SwitchInputMethodGroup);
+        CASE(OPEN_X11_CONNECTION, OpenX11Connection);
+        CASE(SET_EVENT_LOOP_STATISTICS, SetEventLoopStatistics);
+        CASE(RESET_EVENT_LOOP_STATISTICS, ResetEventLoopStatistics);
+        CASE(GET_EVENT_LOOP_STATISTICS, EventLoopStatistics);
+        CASE(GET_MEMORY_USAGE, MemoryUsage);
+    default:
+        break;
+    }
+#undef CASE
+    return {};
+}
+
+struct BatchCommand {
+    std::string_view name;
+    int messageType;
+    bool hasArgument;
+};
+
+constexpr BatchCommand batchCommands[] = {
+    {"c", FCITX_DBUS_DEACTIVATE, false},
+    {"o", FCITX_DBUS_ACTIVATE, false},
+    {"r", FCITX_DBUS_RELOAD_CONFIG, false},
+    {"t", FCITX_DBUS_TOGGLE, false},
+    {"e", FCITX_DBUS_EXIT, false},
+    {"n", FCITX_DBUS_GET_CURRENT_IM, false},
+    {"q", FCITX_DBUS_GET_CURRENT_GROUP, false},
+    {"x", FCITX_DBUS_OPEN_X11_CONNECTION, false},
+    {"state", FCITX_DBUS_GET_CURRENT_STATE, false},
+    {"m", FCITX_DBUS_GET_IM_ADDON, true},
+    {"s", FCITX_DBUS_SET_CURRENT_IM, true},
+    {"g", FCITX_DBUS_SET_CURRENT_GROUP, true},
+};
+
+// Run one batch command, result is printed after "ok" or "error".
+bool runBatchCommand(Bus &bus, const std::string &serviceName,
+                     std::string_view line, std::string &result) {
+    auto space = line.find(' ');
+    auto name = line.substr(0, space);
+    std::string argument;
+    if (space != std::string_view::npos) {
+        argument = line.substr(space + 1);
+    }
+    const auto *command =
+        std::find_if(std::begin(batchCommands), std::end(batchCommands),
+                     [name](const BatchCommand &command) {
+                         return command.name == name;
+                     });
+    if (command == std::end(batchCommands) ||
+        command->hasArgument == argument.empty() ||
+        !utf8::validate(argument)) {
+        result = "InvalidCommand";
+        return false;
+    }
+    if (command->messageType == FCITX_DBUS_EXIT &&
+        bus.serviceOwner(serviceName, defaultTimeout).empty()) {
+        return true;
+    }
+    auto message = createMessage(bus, serviceName, command->messageType);
+    if (command->hasArgument) {
+        message << argument;
+    } else if (command->messageType == FCITX_DBUS_OPEN_X11_CONNECTION) {
+        const char *x11Display = getenv("DISPLAY");
+        if (!x11Display) {
+            result = "NoDisplay";
+            return false;
+        }
+        message << x11Display;
+    }
+    auto reply = message.call(defaultTimeout);
+    if (!reply) {
+        result = "NoReply";
+        return false;
+    }
+    if (reply.isError()) {
+        result = reply.errorName();
+        return false;
+    }
+    switch (command->messageType) {
+    case FCITX_DBUS_GET_CURRENT_STATE: {
+        int state = 0;
+        reply >> state;
+        result = std::to_string(state);
+    } break;
+    case FCITX_DBUS_GET_IM_ADDON:
+    case FCITX_DBUS_GET_CURRENT_IM:
+    case FCITX_DBUS_GET_CURRENT_GROUP:
+        reply >> result;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+int runBatch(Bus &bus, const std::string &serviceName) {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::string result;
+        if (runBatchCommand(bus, serviceName, line, result)) {
+            std::cout << "ok";
+        } else {
+            std::cout << "error";
+        }
+        if (!result.empty()) {
+            std::cout << '\t' << result;
+        }
+        // The caller is usually waiting for the line on a pipe.
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     Bus bus(BusType::Session);
     Message message;
@@ -74,8 +274,14 @@ int main(int argc, char *argv[]) {
     int messageType = FCITX_DBUS_GET_CURRENT_STATE;
     std::string imname;
     std::string serviceName = fcitxServiceName;
+    bool enableStatistics = false;
+    bool batch = false;
     struct option longOptions[] = {{"check", no_argument, nullptr, 0},
                                    {"help", no_argument, nullptr, 'h'},
+                                   {"event-stats", required_argument, nullptr,
+                                    0},
+                                   {"memory-usage", no_argument, nullptr, 0},
+                                   {"batch", no_argument, nullptr, 0},
                                    {nullptr, 0, 0, 0}};
 
     int optionIndex = 0;
@@ -92,6 +298,26 @@ int main(int argc, char *argv[]) {
                     return 1;
                 }
             } break;
+            case 2: {
+                std::string_view action = optarg;
+                if (action == "on" || action == "off") {
+                    messageType = FCITX_DBUS_SET_EVENT_LOOP_STATISTICS;
+                    enableStatistics = action == "on";
+                } else if (action == "reset") {
+                    messageType = FCITX_DBUS_RESET_EVENT_LOOP_STATISTICS;
+                } else if (action == "show") {
+                    messageType = FCITX_DBUS_GET_EVENT_LOOP_STATISTICS;
+                } else {
+                    usage(std::cerr);
+                    return 1;
+                }
+            } break;
+            case 3:
+                messageType = FCITX_DBUS_GET_MEMORY_USAGE;
+                break;
+            case 4:
+                batch = true;
+                break;
             }
             break;
         case 'o':
@@ -153,34 +379,15 @@ int main(int argc, char *argv[]) {
             return 1;
         }
     }
+    if (batch) {
+        return runBatch(bus, serviceName);
+    }
     if (!imname.empty() && !utf8::validate(imname)) {
         std::cerr << "Input method name is invalid." << std::endl;
         return 1;
     }
 
-#define CASE(ENUMNAME, MESSAGENAME)                                            \
-    case FCITX_DBUS_##ENUMNAME:                                                \
-        message = bus.createMethodCall(serviceName.data(), path,               \
-                                       interfaceName, #MESSAGENAME);           \
-        break;
-
-    switch (messageType) {
-        CASE(ACTIVATE, Activate);
-        CASE(DEACTIVATE, Deactivate);
-        CASE(RELOAD_CONFIG, ReloadConfig);
-        CASE(EXIT, Exit);
-        CASE(TOGGLE, Toggle);
-        CASE(GET_CURRENT_STATE, State);
-        CASE(GET_IM_ADDON, AddonForIM);
-        CASE(GET_CURRENT_IM, CurrentInputMethod);
-        CASE(SET_CURRENT_IM, SetCurrentIM);
-        CASE(GET_CURRENT_GROUP, CurrentInputMethodGroup);
-        CASE(SET_CURRENT_GROUP, SwitchInputMethodGroup);
-        CASE(OPEN_X11_CONNECTION, OpenX11Connection);
-
-    default:
-        return ret;
-    };
+    message = createMessage(bus, serviceName, messageType);
     if (!message) {
         return ret;
     }
@@ -267,6 +474,31 @@ int main(int argc, char *argv[]) {
         return reply.isError() ? 1 : 0;
     }
 
+    if (messageType == FCITX_DBUS_SET_EVENT_LOOP_STATISTICS) {
+        message << enableStatistics;
+        auto reply = message.call(defaultTimeout);
+        return reply.isError() ? 1 : 0;
+    }
+    if (messageType == FCITX_DBUS_GET_EVENT_LOOP_STATISTICS) {
+        auto reply = message.call(defaultTimeout);
+        if (!reply.isError()) {
+            printEventLoopStatistics(reply);
+            return 0;
+        }
+        std::cerr << "Failed to get reply." << std::endl;
+        return 1;
+    }
+
+    if (messageType == FCITX_DBUS_GET_MEMORY_USAGE) {
+        auto reply = message.call(defaultTimeout);
+        if (!reply.isError()) {
+            printMemoryUsage(reply);
+            return 0;
+        }
+        std::cerr << "Failed to get reply." << std::endl;
+        return 1;
+    }
+
     auto reply = message.call(defaultTimeout);
     return reply.isError() ? 1 : 0;
 }
@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 #include <cairo.h>
@@ -110,45 +112,124 @@ UnixFD openShm(void) {
     return {};
 }
 
-Buffer::Buffer(WlShm *shm, uint32_t width, uint32_t height,
-               wl_shm_format format)
-    : width_(width), height_(height) {
-    uint32_t stride = width * 4;
-    uint32_t alloc = stride * height;
-    UnixFD fd = openShm();
-    if (!fd.isValid()) {
-        return;
+namespace {
+
+// Smallest block, which is able to hold a small popup.
+constexpr uint32_t minBlockSize = 64 * 1024;
+
+} // namespace
+
+ShmPool::ShmPool(WlShm *shm) : shm_(shm) {}
+
+ShmPool::~ShmPool() {
+    pool_.reset();
+    if (data_) {
+        munmap(data_, dataSize_);
     }
+}
 
-    if (posix_fallocate(fd.fd(), 0, alloc) != 0) {
-        return;
+std::optional<uint32_t> ShmPool::allocate(uint32_t size, uint32_t *blockSize) {
+    uint32_t block = minBlockSize;
+    while (block < size) {
+        if (block > std::numeric_limits<uint32_t>::max() / 2) {
+            return std::nullopt;
+        }
+        block *= 2;
     }
-    uint8_t *data = (uint8_t *)mmap(nullptr, alloc, PROT_READ | PROT_WRITE,
-                                    MAP_SHARED, fd.fd(), 0);
+    *blockSize = block;
+    if (auto iter = freeBlocks_.find(block);
+        iter != freeBlocks_.end() && !iter->second.empty()) {
+        auto offset = iter->second.back();
+        iter->second.pop_back();
+        return offset;
+    }
+    if (used_ + block > std::numeric_limits<int32_t>::max()) {
+        return std::nullopt;
+    }
+    if (used_ + block > dataSize_ && !grow(used_ + block)) {
+        return std::nullopt;
+    }
+    auto offset = used_;
+    used_ += block;
+    return offset;
+}
+
+void ShmPool::release(uint32_t offset, uint32_t blockSize) {
+    freeBlocks_[blockSize].push_back(offset);
+}
 
+bool ShmPool::grow(size_t size) {
+    // Grow at least twice of the current size, to avoid mapping again too
+    // often.
+    size = std::min<size_t>(std::max(size, dataSize_ * 2),
+                            std::numeric_limits<int32_t>::max());
+    if (!fd_.isValid()) {
+        fd_ = openShm();
+        if (!fd_.isValid()) {
+            return false;
+        }
+    }
+    if (posix_fallocate(fd_.fd(), 0, size) != 0) {
+        return false;
+    }
+    auto *data = static_cast<uint8_t *>(
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_.fd(), 0));
     if (data == static_cast<uint8_t *>(MAP_FAILED)) {
-        return;
+        return false;
+    }
+    if (data_) {
+        munmap(data_, dataSize_);
     }
-
     data_ = data;
-    dataSize_ = alloc;
+    dataSize_ = size;
+    generation_ += 1;
+    if (pool_) {
+        pool_->resize(size);
+    } else {
+        pool_.reset(shm_->createPool(fd_.fd(), size));
+    }
+    return true;
+}
 
-    pool_.reset(shm->createPool(fd.fd(), alloc));
-    buffer_.reset(pool_->createBuffer(0, width, height, stride, format));
-    buffer_->release().connect([this]() { busy_ = false; });
+Buffer::Buffer(ShmPool *pool, uint32_t width, uint32_t height,
+               wl_shm_format format)
+    : pool_(pool), width_(width), height_(height) {
+    uint64_t stride = static_cast<uint64_t>(width) * 4;
+    uint64_t alloc = stride * height;
+    if (alloc > std::numeric_limits<int32_t>::max()) {
+        return;
+    }
+    offset_ = pool_->allocate(alloc, &blockSize_);
+    if (!offset_) {
+        return;
+    }
 
-    surface_.reset(cairo_image_surface_create_for_data(
-        data, CAIRO_FORMAT_ARGB32, width, height, stride));
+    buffer_.reset(
+        pool_->pool()->createBuffer(*offset_, width, height, stride, format));
+    buffer_->release().connect([this]() { busy_ = false; });
 }
 
 Buffer::~Buffer() {
     callback_.reset();
     surface_.reset();
     buffer_.reset();
-    pool_.reset();
-    if (data_) {
-        munmap(data_, dataSize_);
+    if (offset_) {
+        pool_->release(*offset_, blockSize_);
+    }
+}
+
+cairo_surface_t *Buffer::cairoSurface() {
+    if (!buffer_) {
+        return nullptr;
+    }
+    // Memory may be moved when pool grows for other buffers.
+    if (!surface_ || generation_ != pool_->generation()) {
+        generation_ = pool_->generation();
+        surface_.reset(cairo_image_surface_create_for_data(
+            pool_->data() + *offset_, CAIRO_FORMAT_ARGB32, width_, height_,
+            width_ * 4));
     }
+    return surface_.get();
 }
 
 bool Buffer::attachToSurface(WlSurface *surface, int scale) {
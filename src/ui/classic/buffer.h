@@ -9,9 +9,13 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 #include <cairo/cairo.h>
 #include <wayland-client.h>
 #include "fcitx-utils/signals.h"
+#include "fcitx-utils/unixfd.h"
 
 namespace fcitx {
 namespace wayland {
@@ -22,15 +26,53 @@ class WlBuffer;
 class WlCallback;
 class WlSurface;
 
+/**
+ * Shared memory of a window, backed by a single file that only grows.
+ *
+ * Memory is handed out in power of two sized blocks, and released blocks are
+ * kept to be reused by the next buffer of the same size class. So resizing a
+ * window does not need to create a new file or mapping.
+ */
+class ShmPool {
+public:
+    ShmPool(WlShm *shm);
+    ~ShmPool();
+
+    // Allocate a block that is able to hold size bytes, return the offset and
+    // set the actual size of the block.
+    std::optional<uint32_t> allocate(uint32_t size, uint32_t *blockSize);
+    void release(uint32_t offset, uint32_t blockSize);
+
+    WlShmPool *pool() const { return pool_.get(); }
+    uint8_t *data() const { return data_; }
+    // Changed when the memory is mapped again and data() moves.
+    uint32_t generation() const { return generation_; }
+
+private:
+    bool grow(size_t size);
+
+    WlShm *shm_;
+    UnixFD fd_;
+    uint8_t *data_ = nullptr;
+    size_t dataSize_ = 0;
+    // End of the blocks that are ever allocated.
+    size_t used_ = 0;
+    uint32_t generation_ = 0;
+    std::unique_ptr<WlShmPool> pool_;
+    // Block size to offsets.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> freeBlocks_;
+};
+
 class Buffer {
 public:
-    Buffer(WlShm *shm, uint32_t width, uint32_t height, wl_shm_format format);
+    Buffer(ShmPool *pool, uint32_t width, uint32_t height,
+           wl_shm_format format);
     ~Buffer();
 
     bool busy() const { return busy_; }
     uint32_t width() const { return width_; }
     uint32_t height() const { return height_; }
-    cairo_surface_t *cairoSurface() const { return surface_.get(); }
+    cairo_surface_t *cairoSurface();
     WlBuffer *buffer() const { return buffer_.get(); }
 
     bool attachToSurface(WlSurface *surface, int scale);
@@ -38,10 +80,11 @@ public:
     auto &rendered() { return rendered_; }
 
 private:
-    uint8_t *data_ = nullptr;
-    size_t dataSize_ = 0;
+    ShmPool *pool_;
+    std::optional<uint32_t> offset_;
+    uint32_t blockSize_ = 0;
+    uint32_t generation_ = 0;
     Signal<void()> rendered_;
-    std::unique_ptr<WlShmPool> pool_;
     std::unique_ptr<WlBuffer> buffer_;
     std::unique_ptr<WlCallback> callback_;
     UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface_;
@@ -7,9 +7,11 @@
 
 #include "classicui.h"
 #include <fcntl.h>
+#include <algorithm>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <pango/pangocairo.h>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/dbus/message_details.h"
 #include "fcitx-utils/misc_p.h"
@@ -39,6 +41,10 @@ FCITX_DEFINE_LOG_CATEGORY(classicui_logcategory, "classicui");
 
 using AccentColorDBusType = FCITX_STRING_TO_DBUS_TYPE("(ddd)");
 
+namespace {
+constexpr char AppearanceCachePath[] = "fcitx5/classicui/appearance.conf";
+} // namespace
+
 ClassicUI::ClassicUI(Instance *instance) : instance_(instance) {
 
 #ifdef ENABLE_DBUS
@@ -47,9 +53,19 @@ ClassicUI::ClassicUI(Instance *instance) : instance_(instance) {
             .registerType<AccentColorDBusType>();
         settingMonitor_ = std::make_unique<PortalSettingMonitor>(
             *dbusAddon->call<IDBusModule::bus>());
+        loadAppearance();
     }
 #endif
 
+    configWatcher_ =
+        config_.watchOptionChanged([this](const OptionBase &option) {
+            if (&option == &config_.theme || &option == &config_.themeDark ||
+                &option == &config_.useDarkTheme ||
+                &option == &config_.useAccentColor) {
+                themeOptionChanged_ = true;
+            }
+        });
+
     reloadConfig();
 
 #ifdef ENABLE_X11
@@ -100,6 +116,18 @@ ClassicUI::ClassicUI(Instance *instance) : instance_(instance) {
             return true;
         });
     deferedReloadTheme_->setEnabled(false);
+    deferedUpdateCurrentInputMethod_ =
+        instance_->eventLoop().addDeferEvent([this](EventSource *) {
+            auto *ic = pendingCurrentInputMethod_.get();
+            pendingCurrentInputMethod_.unwatch();
+            if (ic && ic->hasFocus() && !suspended_) {
+                if (auto *ui = uiForInputContext(ic)) {
+                    ui->updateCurrentInputMethod(ic);
+                }
+            }
+            return true;
+        });
+    deferedUpdateCurrentInputMethod_->setEnabled(false);
 
     // Since kimpanel may call classicui
     persistentEventHandlers_.emplace_back(instance_->watchEvent(
@@ -130,6 +158,18 @@ void ClassicUI::reloadConfig() {
     reloadTheme();
 }
 
+void ClassicUI::setConfig(const RawConfig &config) {
+    themeOptionChanged_ = false;
+    config_.load(config, true);
+    safeSaveAsIni(config_, "conf/classicui.conf");
+    if (themeOptionChanged_) {
+        reloadTheme();
+    } else {
+        // Other options, e.g. font, still affect rendering.
+        themeSerial_ += 1;
+    }
+}
+
 void ClassicUI::reloadTheme() {
 #ifdef ENABLE_DBUS
     auto parseMessage = [this](const dbus::Variant &variant) {
@@ -141,6 +181,7 @@ void ClassicUI::reloadTheme() {
                 CLASSICUI_DEBUG() << "XDG Portal AppearanceChanged "
                                      "isDark"
                                   << isDark_;
+                saveAppearance();
                 deferedReloadTheme_->setOneShot();
             }
         }
@@ -204,6 +245,7 @@ void ClassicUI::reloadTheme() {
                 CLASSICUI_DEBUG() << "XDG Portal AccentColor changed "
                                      "color: "
                                   << accentColor_;
+                saveAppearance();
                 deferedReloadTheme_->setOneShot();
             }
         }
@@ -224,6 +266,30 @@ void ClassicUI::reloadTheme() {
 #endif
 
     theme_.populateColor(accentColor_);
+    themeSerial_ += 1;
+}
+
+void ClassicUI::loadAppearance() {
+    RawConfig config;
+    readAsIni(config, StandardPath::Type::Cache, AppearanceCachePath);
+    if (const auto *value = config.valueByPath("IsDark")) {
+        isDark_ = (*value == "True");
+    }
+    if (const auto *value = config.valueByPath("AccentColor")) {
+        try {
+            accentColor_ = Color(*value);
+        } catch (const ColorParseException &) {
+        }
+    }
+}
+
+void ClassicUI::saveAppearance() {
+    RawConfig config;
+    config.setValueByPath("IsDark", isDark_ ? "True" : "False");
+    if (accentColor_) {
+        config.setValueByPath("AccentColor", accentColor_->toString());
+    }
+    safeSaveAsIni(config, StandardPath::Type::Cache, AppearanceCachePath);
 }
 
 void ClassicUI::suspend() {
@@ -372,7 +438,8 @@ void ClassicUI::resume() {
             if (auto *ui = uiForEvent(event)) {
                 auto &icEvent = static_cast<InputContextEvent &>(event);
                 ui->updateCursor(icEvent.inputContext());
-                ui->updateCurrentInputMethod(icEvent.inputContext());
+                pendingCurrentInputMethod_ = icEvent.inputContext()->watch();
+                deferedUpdateCurrentInputMethod_->setOneShot();
             }
         }));
     eventHandlers_.emplace_back(instance_->watchEvent(
@@ -483,6 +550,9 @@ void ClassicUI::setSubConfig(const std::string &path,
         getSubConfig(path);
     }
     theme.load(name, config);
+    if (&theme == &theme_) {
+        themeSerial_ += 1;
+    }
     safeSaveAsIni(theme, StandardPath::Type::PkgData,
                   stringutils::joinPath("themes", name, "theme.conf"));
 }
@@ -506,6 +576,21 @@ bool ClassicUI::showLayoutNameInIcon() const {
     return *config_.showLayoutNameInIcon;
 }
 
+PangoFontMap *ClassicUI::fontMap(int dpi) {
+    // Unlike pango cairo context, Cairo font map does not accept negative dpi.
+    // Use the default value instead.
+    dpi = std::max(dpi, 0);
+    auto &fontMap = fontMaps_[dpi];
+    if (!fontMap) {
+        fontMap.reset(pango_cairo_font_map_new());
+        if (dpi > 0) {
+            pango_cairo_font_map_set_resolution(
+                PANGO_CAIRO_FONT_MAP(fontMap.get()), dpi);
+        }
+    }
+    return fontMap.get();
+}
+
 } // namespace fcitx::classicui
 
 FCITX_ADDON_FACTORY(fcitx::classicui::ClassicUIFactory);
@@ -8,6 +8,8 @@
 #define _FCITX_UI_CLASSIC_CLASSICUI_H_
 
 #include <memory>
+#include <unordered_map>
+#include <pango/pango.h>
 #include "config.h"
 
 #include "fcitx-config/configuration.h"
@@ -20,6 +22,7 @@
 #include "fcitx/instance.h"
 #include "fcitx/userinterface.h"
 #include "classicui_public.h"
+#include "common.h"
 #include "plasmathemewatchdog.h"
 #include "portalsettingmonitor.h"
 #include "theme.h"
@@ -201,16 +204,14 @@ public:
     FCITX_ADDON_DEPENDENCY_LOADER(dbus, instance_->addonManager());
     Instance *instance() const { return instance_; }
     const Configuration *getConfig() const override;
-    void setConfig(const RawConfig &config) override {
-        config_.load(config, true);
-        safeSaveAsIni(config_, "conf/classicui.conf");
-        reloadTheme();
-    }
+    void setConfig(const RawConfig &config) override;
     const Configuration *getSubConfig(const std::string &path) const override;
     void setSubConfig(const std::string &path,
                       const RawConfig &config) override;
     auto &config() const { return config_; }
     Theme &theme() { return theme_; }
+    // Changes whenever theme or config that affects rendering is reloaded.
+    uint64_t themeSerial() const { return themeSerial_; }
     void suspend() override;
     void resume() override;
     bool suspended() const { return suspended_; }
@@ -224,6 +225,10 @@ public:
     bool preferTextIcon() const;
     bool showLayoutNameInIcon() const;
 
+    // Font map shared by all windows that use the same dpi, non positive dpi
+    // means the default resolution.
+    PangoFontMap *fontMap(int dpi);
+
 private:
     FCITX_ADDON_DEPENDENCY_LOADER(notificationitem, instance_->addonManager());
     FCITX_ADDON_EXPORT_FUNCTION(ClassicUI, labelIcon);
@@ -234,6 +239,10 @@ private:
     UIInterface *uiForInputContext(InputContext *inputContext);
     UIInterface *uiForDisplay(const std::string &display);
     void reloadTheme();
+    // The appearance last read from the portal, so the first popup already
+    // uses it before the portal answers.
+    void loadAppearance();
+    void saveAppearance();
 
 #ifdef ENABLE_X11
     std::unique_ptr<HandlerTableEntry<XCBConnectionCreated>>
@@ -249,6 +258,10 @@ private:
 #endif
 
     std::unique_ptr<EventSource> deferedReloadTheme_;
+    // Input method status of the last focused input context is updated once
+    // after a burst of focus changes.
+    std::unique_ptr<EventSource> deferedUpdateCurrentInputMethod_;
+    TrackableObjectReference<InputContext> pendingCurrentInputMethod_;
 #ifdef ENABLE_DBUS
     std::unique_ptr<PortalSettingMonitor> settingMonitor_;
     std::unique_ptr<PortalSettingEntry> darkModeEntry_;
@@ -261,11 +274,17 @@ private:
         persistentEventHandlers_;
     std::unique_ptr<HandlerTableEntryBase> sniHandler_;
 
+    // Need to outlive the windows of uis_.
+    std::unordered_map<int, GObjectUniquePtr<PangoFontMap>> fontMaps_;
     std::unordered_map<std::string, std::unique_ptr<UIInterface>> uis_;
 
     Instance *instance_;
     ClassicUIConfig config_;
+    std::unique_ptr<HandlerTableEntry<OptionChangedCallback>> configWatcher_;
+    // Set when an option used to pick the theme is changed by load.
+    bool themeOptionChanged_ = false;
     Theme theme_;
+    uint64_t themeSerial_ = 0;
     mutable Theme subconfigTheme_;
     bool suspended_ = true;
     bool isDark_ = false;
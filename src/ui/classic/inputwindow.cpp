@@ -5,10 +5,13 @@
  *
  */
 #include "inputwindow.h"
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
+#include <string>
 #include <cairo.h>
 #include <pango/pango-context.h>
 #include <pango/pango-font.h>
@@ -24,6 +27,12 @@
 
 namespace fcitx::classicui {
 
+namespace {
+
+constexpr size_t candidateLayoutCacheSize = 128;
+
+} // namespace
+
 auto newPangoLayout(PangoContext *context) {
     GObjectUniquePtr<PangoLayout> ptr(pango_layout_new(context));
     pango_layout_set_single_paragraph_mode(ptr.get(), false);
@@ -102,12 +111,7 @@ void MultilineLayout::render(cairo_t *cr, int x, int y, int lineHeight,
 }
 
 InputWindow::InputWindow(ClassicUI *parent) : parent_(parent) {
-    fontMap_.reset(pango_cairo_font_map_new());
-    // Although documentation says it is 96 by default, try not rely on this
-    // behavior.
-    fontMapDefaultDPI_ = pango_cairo_font_map_get_resolution(
-        PANGO_CAIRO_FONT_MAP(fontMap_.get()));
-    context_.reset(pango_font_map_create_context(fontMap_.get()));
+    context_.reset(pango_font_map_create_context(parent_->fontMap(0)));
     upperLayout_ = newPangoLayout(context_.get());
     lowerLayout_ = newPangoLayout(context_.get());
 }
@@ -202,10 +206,85 @@ void InputWindow::resizeCandidates(size_t n) {
     while (candidateLayouts_.size() < n) {
         candidateLayouts_.emplace_back();
     }
+    labelKeys_.resize(std::max(labelKeys_.size(), n));
+    candidateKeys_.resize(std::max(candidateKeys_.size(), n));
 
     nCandidates_ = n;
 }
 
+std::string InputWindow::displayLanguage(InputContext *inputContext) const {
+    const auto *entry = parent_->instance()->inputMethodEntry(inputContext);
+    if (*parent_->config().useInputMethodLanguageToDisplayText && entry) {
+        return entry->languageCode();
+    }
+    return {};
+}
+
+size_t CandidateLayoutKey::hash() const {
+    size_t seed = std::hash<uint64_t>()(themeSerial);
+    auto combine = [&seed](size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine(std::hash<std::string>()(language));
+    for (size_t i = 0, e = text.size(); i < e; i++) {
+        combine(std::hash<std::string>()(text.stringAt(i)));
+        combine(text.formatAt(i).toInteger());
+    }
+    return seed;
+}
+
+void InputWindow::cacheCandidateLayouts() {
+    for (size_t i = 0; i < nCandidates_; i++) {
+        auto &layout = candidateLayouts_[i];
+        if (layout.lines_.empty()) {
+            continue;
+        }
+        auto &key = candidateKeys_[i];
+        auto hash = key.hash();
+        auto [begin, end] = candidateLayoutCacheIndex_.equal_range(hash);
+        for (auto iter = begin; iter != end; ++iter) {
+            if (iter->second->first == key) {
+                candidateLayoutCache_.erase(iter->second);
+                candidateLayoutCacheIndex_.erase(iter);
+                break;
+            }
+        }
+        candidateLayoutCache_.emplace_front(std::move(key), std::move(layout));
+        candidateLayoutCacheIndex_.emplace(hash,
+                                           candidateLayoutCache_.begin());
+        key = CandidateLayoutKey();
+        layout = MultilineLayout();
+    }
+    while (candidateLayoutCache_.size() > candidateLayoutCacheSize) {
+        auto last = std::prev(candidateLayoutCache_.end());
+        auto [begin, end] =
+            candidateLayoutCacheIndex_.equal_range(last->first.hash());
+        for (auto iter = begin; iter != end; ++iter) {
+            if (iter->second == last) {
+                candidateLayoutCacheIndex_.erase(iter);
+                break;
+            }
+        }
+        candidateLayoutCache_.erase(last);
+    }
+}
+
+bool InputWindow::takeCachedCandidateLayout(const CandidateLayoutKey &key,
+                                            MultilineLayout &layout) {
+    auto [begin, end] = candidateLayoutCacheIndex_.equal_range(key.hash());
+    for (auto iter = begin; iter != end; ++iter) {
+        if (iter->second->first == key) {
+            layout = std::move(iter->second->second);
+            candidateLayoutCache_.erase(iter->second);
+            candidateLayoutCacheIndex_.erase(iter);
+            candidateLayoutCacheHits_ += 1;
+            return true;
+        }
+    }
+    candidateLayoutCacheMisses_ += 1;
+    return false;
+}
+
 void InputWindow::setTextToMultilineLayout(InputContext *inputContext,
                                            MultilineLayout &layout,
                                            const Text &text) {
@@ -270,12 +349,28 @@ void InputWindow::setTextToLayout(
     pango_attr_list_unref(newAttrList);
 }
 
+void InputWindow::updateCandidateIndex(const CandidateList &candidateList) {
+    candidateIndex_ = -1;
+    for (int i = 0, e = candidateList.size(), localIndex = 0; i < e; i++) {
+        if (candidateList.candidate(i).isPlaceHolder()) {
+            continue;
+        }
+        if (i == candidateList.cursorIndex()) {
+            candidateIndex_ = localIndex;
+            break;
+        }
+        localIndex++;
+    }
+}
+
 std::pair<int, int> InputWindow::update(InputContext *inputContext) {
     if ((parent_->suspended() &&
          parent_->instance()->currentUI() != "kimpanel") ||
         !inputContext) {
         hoverIndex_ = -1;
         visible_ = false;
+        // Layouts are not updated, next update need to do everything.
+        inputContext_.unwatch();
         return {0, 0};
     }
     // | aux up | preedit
@@ -289,7 +384,19 @@ std::pair<int, int> InputWindow::update(InputContext *inputContext) {
     // | candidate 3
     auto *instance = parent_->instance();
     auto &inputPanel = inputContext->inputPanel();
+    if (inputContext_.get() == inputContext &&
+        inputPanel.dirtyComponents() == InputPanelComponent::CandidateCursor) {
+        // Moving the cursor within a page, layouts are still valid.
+        auto oldHighlight = highlight();
+        updateCandidateIndex(*inputPanel.candidateList());
+        if (oldHighlight != highlight()) {
+            damageHighlight(oldHighlight);
+            damageHighlight(highlight());
+        }
+        return size_;
+    }
     inputContext_ = inputContext->watch();
+    damageAll();
 
     cursor_ = -1;
     auto preedit = instance->outputFilter(inputContext, inputPanel.preedit());
@@ -306,7 +413,10 @@ std::pair<int, int> InputWindow::update(InputContext *inputContext) {
     setTextToLayout(inputContext, lowerLayout_.get(), nullptr, nullptr,
                     {auxDown});
 
+    cacheCandidateLayouts();
     if (auto candidateList = inputPanel.candidateList()) {
+        const auto themeSerial = parent_->themeSerial();
+        const auto language = displayLanguage(inputContext);
         // Count non-placeholder candidates.
         int count = 0;
 
@@ -336,15 +446,32 @@ std::pair<int, int> InputWindow::update(InputContext *inputContext) {
                                  ? candidate.customLabel()
                                  : candidateList->label(i);
 
-            labelText = instance->outputFilter(inputContext, labelText);
-            setTextToMultilineLayout(inputContext, labelLayouts_[localIndex],
-                                     labelText);
-            auto candidateText = instance->outputFilter(
-                inputContext, candidate.textWithComment());
-            setTextToMultilineLayout(
-                inputContext, candidateLayouts_[localIndex], candidateText);
+            // Labels are usually the same for every page.
+            CandidateLayoutKey labelKey{
+                themeSerial, language,
+                instance->outputFilter(inputContext, labelText)};
+            if (labelKeys_[localIndex] != labelKey) {
+                setTextToMultilineLayout(inputContext,
+                                         labelLayouts_[localIndex],
+                                         labelKey.text);
+                labelKeys_[localIndex] = std::move(labelKey);
+            }
+            CandidateLayoutKey candidateKey{
+                themeSerial, language,
+                instance->outputFilter(inputContext,
+                                       candidate.textWithComment())};
+            if (!takeCachedCandidateLayout(candidateKey,
+                                           candidateLayouts_[localIndex])) {
+                setTextToMultilineLayout(inputContext,
+                                         candidateLayouts_[localIndex],
+                                         candidateKey.text);
+            }
+            candidateKeys_[localIndex] = std::move(candidateKey);
             localIndex++;
         }
+        CLASSICUI_DEBUG() << "Candidate layout cache hits: "
+                          << candidateLayoutCacheHits_
+                          << " misses: " << candidateLayoutCacheMisses_;
 
         layoutHint_ = candidateList->layoutHint();
         if (auto *pageable = candidateList->toPageable()) {
@@ -372,7 +499,8 @@ std::pair<int, int> InputWindow::update(InputContext *inputContext) {
             visible_ = false;
         }
     }
-    return {width, height};
+    size_ = {width, height};
+    return size_;
 }
 
 std::pair<unsigned int, unsigned int> InputWindow::sizeHint() {
@@ -381,11 +509,19 @@ std::pair<unsigned int, unsigned int> InputWindow::sizeHint() {
         pango_font_description_from_string(parent_->config().font->c_str());
     pango_context_set_font_description(context_.get(), fontDesc);
     pango_font_description_free(fontDesc);
-    pango_layout_context_changed(upperLayout_.get());
-    pango_layout_context_changed(lowerLayout_.get());
-    for (size_t i = 0; i < nCandidates_; i++) {
-        labelLayouts_[i].contextChanged();
-        candidateLayouts_[i].contextChanged();
+    // Only invalidate the shaped layouts when font or resolution is changed,
+    // otherwise reused candidate layouts would be shaped again.
+    if (auto serial = pango_context_get_serial(context_.get());
+        serial != contextSerial_) {
+        contextSerial_ = serial;
+        pango_layout_context_changed(upperLayout_.get());
+        pango_layout_context_changed(lowerLayout_.get());
+        for (size_t i = 0; i < nCandidates_; i++) {
+            labelLayouts_[i].contextChanged();
+            candidateLayouts_[i].contextChanged();
+        }
+        candidateLayoutCache_.clear();
+        candidateLayoutCacheIndex_.clear();
     }
     auto *metrics = pango_context_get_metrics(
         context_.get(), pango_context_get_font_description(context_.get()),
@@ -533,6 +669,8 @@ void InputWindow::paint(cairo_t *cr, unsigned int width, unsigned int height,
 
     candidateRegions_.clear();
     candidateRegions_.reserve(nCandidates_);
+    highlightRegions_.clear();
+    highlightRegions_.reserve(nCandidates_);
     size_t wholeW = 0, wholeH = 0;
 
     // size of text = textMargin + actual text size.
@@ -590,6 +728,15 @@ void InputWindow::paint(cairo_t *cr, unsigned int width, unsigned int height,
             cairo_restore(cr);
             highlight = true;
         }
+        Rect highlightRegion;
+        highlightRegion
+            .setPosition(*margin.marginLeft + x - *highlightMargin.marginLeft,
+                         *margin.marginTop + y - *highlightMargin.marginTop)
+            .setSize(highlightWidth + *highlightMargin.marginLeft +
+                         *highlightMargin.marginRight,
+                     vheight + *highlightMargin.marginTop +
+                         *highlightMargin.marginBottom);
+        highlightRegions_.push_back(highlightRegion);
         Rect candidateRegion;
         candidateRegion
             .setPosition(*margin.marginLeft + x - *highlightMargin.marginLeft +
@@ -757,15 +904,7 @@ void InputWindow::wheel(bool up) {
 }
 
 void InputWindow::setFontDPI(int dpi) {
-    // Unlike pango cairo context, Cairo font map does not accept negative dpi.
-    // Restore to default value instead.
-    if (dpi <= 0) {
-        pango_cairo_font_map_set_resolution(
-            PANGO_CAIRO_FONT_MAP(fontMap_.get()), fontMapDefaultDPI_);
-    } else {
-        pango_cairo_font_map_set_resolution(
-            PANGO_CAIRO_FONT_MAP(fontMap_.get()), dpi);
-    }
+    pango_context_set_font_map(context_.get(), parent_->fontMap(dpi));
     pango_cairo_context_set_resolution(context_.get(), dpi);
 }
 
@@ -795,14 +934,48 @@ bool InputWindow::hover(int x, int y) {
         }
     }
 
-    needRepaint = needRepaint || prevHovered_ != prevHovered;
+    if (prevHovered_ != prevHovered || nextHovered_ != nextHovered) {
+        // Page buttons are rarely hovered, just paint everything.
+        needRepaint = true;
+        damageAll();
+    }
     prevHovered_ = prevHovered;
-
-    needRepaint = needRepaint || nextHovered_ != nextHovered;
     nextHovered_ = nextHovered;
 
-    needRepaint = needRepaint || oldHighlight != highlight();
+    if (oldHighlight != highlight()) {
+        needRepaint = true;
+        damageHighlight(oldHighlight);
+        damageHighlight(highlight());
+    }
     return needRepaint;
 }
 
+void InputWindow::damageHighlight(int idx) {
+    if (idx < 0 || static_cast<size_t>(idx) >= highlightRegions_.size()) {
+        return;
+    }
+    addDamage(highlightRegions_[idx]);
+}
+
+void InputWindow::addDamage(const Rect &rect) {
+    if (damage_.isEmpty()) {
+        damage_ = rect;
+    } else {
+        damage_ = Rect(std::min(damage_.left(), rect.left()),
+                       std::min(damage_.top(), rect.top()),
+                       std::max(damage_.right(), rect.right()),
+                       std::max(damage_.bottom(), rect.bottom()));
+    }
+}
+
+std::optional<Rect> InputWindow::takeDamage() {
+    std::optional<Rect> result;
+    if (!damageAll_) {
+        result = damage_;
+    }
+    damageAll_ = false;
+    damage_ = Rect();
+    return result;
+}
+
 } // namespace fcitx::classicui
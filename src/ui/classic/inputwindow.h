@@ -7,6 +7,11 @@
 #ifndef _FCITX_UI_CLASSIC_INPUTWINDOW_H_
 #define _FCITX_UI_CLASSIC_INPUTWINDOW_H_
 
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <cairo/cairo.h>
 #include <pango/pango.h>
@@ -49,6 +54,24 @@ public:
     std::vector<PangoAttrListUniquePtr> highlightAttrLists_;
 };
 
+// Everything that a candidate layout is created from. Font and DPI are not
+// part of it, the cache is dropped when pango context is changed.
+struct CandidateLayoutKey {
+    uint64_t themeSerial = 0;
+    std::string language;
+    Text text;
+
+    size_t hash() const;
+
+    bool operator==(const CandidateLayoutKey &other) const {
+        return themeSerial == other.themeSerial &&
+               language == other.language && text == other.text;
+    }
+    bool operator!=(const CandidateLayoutKey &other) const {
+        return !(*this == other);
+    }
+};
+
 class InputWindow {
 public:
     InputWindow(ClassicUI *parent);
@@ -66,6 +89,12 @@ protected:
     // will restore to font map default dpi.
     void setFontDPI(int dpi);
     void resizeCandidates(size_t n);
+    void updateCandidateIndex(const CandidateList &candidateList);
+    std::string displayLanguage(InputContext *inputContext) const;
+    // Move the layouts of shown candidates to the cache.
+    void cacheCandidateLayouts();
+    bool takeCachedCandidateLayout(const CandidateLayoutKey &key,
+                                   MultilineLayout &layout);
     void appendText(std::string &s, PangoAttrList *attrList,
                     PangoAttrList *highlightAttrList, const Text &text);
     void insertAttr(PangoAttrList *attrList, TextFormatFlags format, int start,
@@ -78,16 +107,38 @@ protected:
     void setTextToMultilineLayout(InputContext *inputContext,
                                   MultilineLayout &layout, const Text &text);
     int highlight() const;
+    // Mark the highlight of candidate idx as changed.
+    void damageHighlight(int idx);
+    void addDamage(const Rect &rect);
+    void damageAll() { damageAll_ = true; }
+    // Area changed since last call, nullopt if the whole window need to be
+    // painted.
+    std::optional<Rect> takeDamage();
 
     ClassicUI *parent_;
-    GObjectUniquePtr<PangoFontMap> fontMap_;
-    double fontMapDefaultDPI_ = 96.0;
     GObjectUniquePtr<PangoContext> context_;
     GObjectUniquePtr<PangoLayout> upperLayout_;
     GObjectUniquePtr<PangoLayout> lowerLayout_;
     std::vector<MultilineLayout> labelLayouts_;
     std::vector<MultilineLayout> candidateLayouts_;
+    std::vector<CandidateLayoutKey> labelKeys_;
+    std::vector<CandidateLayoutKey> candidateKeys_;
+    // Layouts of recently shown candidates, most recent first, so a text that
+    // is shown again does not need to be shaped again, even if it is from a
+    // different candidate list or input context.
+    std::list<std::pair<CandidateLayoutKey, MultilineLayout>>
+        candidateLayoutCache_;
+    // Indexed by CandidateLayoutKey::hash.
+    std::unordered_multimap<size_t, decltype(candidateLayoutCache_)::iterator>
+        candidateLayoutCacheIndex_;
+    size_t candidateLayoutCacheHits_ = 0;
+    size_t candidateLayoutCacheMisses_ = 0;
+    guint contextSerial_ = 0;
     std::vector<Rect> candidateRegions_;
+    // Area painted by the highlight of every candidate.
+    std::vector<Rect> highlightRegions_;
+    Rect damage_;
+    bool damageAll_ = true;
     TrackableObjectReference<InputContext> inputContext_;
     bool visible_ = false;
     int cursor_ = 0;
@@ -102,6 +153,8 @@ protected:
     CandidateLayoutHint layoutHint_ = CandidateLayoutHint::NotSet;
     size_t candidatesHeight_ = 0;
     int hoverIndex_ = -1;
+    // Size returned by last update.
+    std::pair<int, int> size_;
 
 private:
     std::pair<unsigned int, unsigned int> sizeHint();
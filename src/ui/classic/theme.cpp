@@ -7,8 +7,12 @@
 
 #include "theme.h"
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <cassert>
+#include <cmath>
+#include <list>
 #include <optional>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <cairo.h>
@@ -45,13 +49,14 @@ std::pair<std::string, size_t> extractTextForLabel(const std::string &label) {
 
     // We have non white space here because xkb shortDescription have things
     // like fr-tg, mon-a1.
-    auto texts = stringutils::split(label, FCITX_WHITESPACE "-_/|");
-    if (texts.empty()) {
+    auto texts = stringutils::splitView(label, FCITX_WHITESPACE "-_/|");
+    auto first = texts.begin();
+    if (first == texts.end()) {
         return {"", 0};
     }
 
     size_t currentWidth = 0;
-    for (uint32_t chr : utf8::MakeUTF8CharRange(texts[0])) {
+    for (uint32_t chr : utf8::MakeUTF8CharRange(*first)) {
         const auto width = charWidth(chr);
         if (currentWidth + width <= 3) {
             extracted.append(utf8::UCS4ToUTF8(chr));
@@ -174,10 +179,7 @@ cairo_surface_t *pixBufToCairoSurface(GdkPixbuf *image) {
     return surface;
 }
 
-cairo_surface_t *loadImage(StandardPathFile &file) {
-    if (file.fd() < 0) {
-        return nullptr;
-    }
+cairo_surface_t *decodeImage(StandardPathFile &file) {
     if (stringutils::endsWith(file.path(), ".png")) {
         int fd = file.fd();
         auto *surface =
@@ -208,6 +210,67 @@ cairo_surface_t *loadImage(StandardPathFile &file) {
     return surface;
 }
 
+// Decoded images shared by all themes, so reloading a theme, e.g. for a new
+// accent color, does not decode the same files again. Surfaces loaded from
+// files are never painted on, so they can be shared.
+class ImageCache {
+public:
+    // Return a new reference, or nullptr if the file is not cached.
+    cairo_surface_t *find(const struct stat &stats) {
+        auto key = makeKey(stats);
+        for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+            if (iter->key == key) {
+                entries_.splice(entries_.begin(), entries_, iter);
+                return cairo_surface_reference(iter->surface.get());
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(const struct stat &stats, cairo_surface_t *surface) {
+        entries_.push_front({makeKey(stats), nullptr});
+        entries_.front().surface.reset(cairo_surface_reference(surface));
+        if (entries_.size() > cacheSize) {
+            entries_.pop_back();
+        }
+    }
+
+private:
+    static constexpr size_t cacheSize = 64;
+    using Key = std::tuple<dev_t, ino_t, int64_t, int64_t, off_t>;
+
+    static Key makeKey(const struct stat &stats) {
+        return {stats.st_dev, stats.st_ino, stats.st_mtim.tv_sec,
+                stats.st_mtim.tv_nsec, stats.st_size};
+    }
+
+    struct Entry {
+        Key key;
+        UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface;
+    };
+    std::list<Entry> entries_;
+};
+
+cairo_surface_t *loadImage(StandardPathFile &file) {
+    if (file.fd() < 0) {
+        return nullptr;
+    }
+    static ImageCache cache;
+    struct stat stats;
+    const bool hasStats = fstat(file.fd(), &stats) == 0;
+    if (hasStats) {
+        if (auto *surface = cache.find(stats)) {
+            return surface;
+        }
+    }
+    auto *surface = decodeImage(file);
+    if (surface && hasStats &&
+        cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS) {
+        cache.insert(stats, surface);
+    }
+    return surface;
+}
+
 } // namespace
 
 const std::vector<std::string> &gdkPixbufSupportedFormats() {
@@ -611,19 +674,14 @@ void Theme::paint(cairo_t *c, const BackgroundImageConfig &cfg, int width,
     auto marginRight = *cfg.margin->marginRight;
 
     if (scale != 1.0) {
-        UniqueCPtr<cairo_surface_t, cairo_surface_destroy> background(
-            cairo_surface_create_similar_image(
-                cairo_get_target(c), CAIRO_FORMAT_ARGB32, width, height));
-        {
-            UniqueCPtr<cairo_t, cairo_destroy> backgroundC(
-                cairo_create(background.get()));
-            paintTile(backgroundC.get(), width, height, 1.0, image, marginLeft,
-                      marginTop, marginRight, marginBottom);
-        }
+        auto *background =
+            tiledBackground(c, cfg, image, width, height, scale);
         cairo_save(c);
         cairo_rectangle(c, 0, 0, width, height);
-        cairo_set_source_surface(c, background.get(), 0, 0);
         cairo_clip(c);
+        // Background is already in device pixels, only composite it.
+        cairo_scale(c, 1.0 / scale, 1.0 / scale);
+        cairo_set_source_surface(c, background, 0, 0);
         cairo_paint_with_alpha(c, alpha);
         cairo_restore(c);
     } else {
@@ -705,6 +763,43 @@ void Theme::paint(cairo_t *c, const BackgroundImageConfig &cfg, int width,
     cairo_restore(c);
 }
 
+cairo_surface_t *Theme::tiledBackground(cairo_t *c,
+                                        const BackgroundImageConfig &cfg,
+                                        const ThemeImage &image, int width,
+                                        int height, double scale) {
+    // Window and highlight usually keep the same size for a while, do not
+    // tile and scale the image on every paint.
+    constexpr size_t tiledBackgroundCacheSize = 16;
+    for (auto iter = tiledBackgroundCache_.begin();
+         iter != tiledBackgroundCache_.end(); ++iter) {
+        if (iter->cfg == &cfg && iter->width == width &&
+            iter->height == height && iter->scale == scale) {
+            tiledBackgroundCache_.splice(tiledBackgroundCache_.begin(),
+                                         tiledBackgroundCache_, iter);
+            return tiledBackgroundCache_.front().surface.get();
+        }
+    }
+
+    UniqueCPtr<cairo_surface_t, cairo_surface_destroy> background(
+        cairo_surface_create_similar_image(
+            cairo_get_target(c), CAIRO_FORMAT_ARGB32,
+            std::ceil(width * scale), std::ceil(height * scale)));
+    {
+        UniqueCPtr<cairo_t, cairo_destroy> backgroundC(
+            cairo_create(background.get()));
+        cairo_scale(backgroundC.get(), scale, scale);
+        paintTile(backgroundC.get(), width, height, 1.0, image,
+                  *cfg.margin->marginLeft, *cfg.margin->marginTop,
+                  *cfg.margin->marginRight, *cfg.margin->marginBottom);
+    }
+    tiledBackgroundCache_.push_front(
+        TiledBackground{&cfg, width, height, scale, std::move(background)});
+    if (tiledBackgroundCache_.size() > tiledBackgroundCacheSize) {
+        tiledBackgroundCache_.pop_back();
+    }
+    return tiledBackgroundCache_.front().surface.get();
+}
+
 void Theme::paint(cairo_t *c, const ActionImageConfig &cfg, double alpha) {
     const ThemeImage &image = loadAction(cfg);
     int height = cairo_image_surface_get_height(image);
@@ -720,6 +815,8 @@ void Theme::paint(cairo_t *c, const ActionImageConfig &cfg, double alpha) {
 
 void Theme::reset() {
     trayImageTable_.clear();
+    tiledBackgroundCache_.clear();
+    maskCache_.clear();
     backgroundImageTable_.clear();
     actionImageTable_.clear();
 }
@@ -775,8 +872,19 @@ bool Theme::setIconTheme(const std::string &name) {
     }
     return false;
 }
-std::vector<Rect> Theme::mask(const BackgroundImageConfig &cfg, int width,
-                              int height) {
+const std::vector<Rect> &Theme::mask(const BackgroundImageConfig &cfg,
+                                     int width, int height) {
+    // Popup is resized on almost every key stroke, while only a few sizes
+    // are used. Do not scan the pixels again for a known size.
+    constexpr size_t maskCacheSize = 8;
+    for (auto iter = maskCache_.begin(); iter != maskCache_.end(); ++iter) {
+        if (iter->cfg == &cfg && iter->width == width &&
+            iter->height == height) {
+            maskCache_.splice(maskCache_.begin(), maskCache_, iter);
+            return maskCache_.front().rects;
+        }
+    }
+
     UniqueCPtr<cairo_surface_t, cairo_surface_destroy> mask(
         cairo_image_surface_create(CAIRO_FORMAT_A1, width, height));
     auto c = cairo_create(mask.get());
@@ -852,13 +960,18 @@ std::vector<Rect> Theme::mask(const BackgroundImageConfig &cfg, int width,
     }
 #undef AddSpan
     std::vector<Rect> result;
+    result.reserve(cairo_region_num_rectangles(region.get()));
     for (int i = 0, e = cairo_region_num_rectangles(region.get()); i < e; i++) {
         cairo_region_get_rectangle(region.get(), i, &rect);
         result.push_back(Rect()
                              .setPosition(rect.x, rect.y)
                              .setSize(rect.width, rect.height));
     }
-    return result;
+    maskCache_.push_front({&cfg, width, height, std::move(result)});
+    if (maskCache_.size() > maskCacheSize) {
+        maskCache_.pop_back();
+    }
+    return maskCache_.front().rects;
 }
 
 void Theme::populateColor(std::optional<Color> accent) {
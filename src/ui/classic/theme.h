@@ -8,6 +8,7 @@
 #define _FCITX_UI_CLASSIC_THEME_H_
 
 #include <cstdint>
+#include <list>
 #include <string_view>
 #include <vector>
 #include <cairo/cairo.h>
@@ -280,8 +281,9 @@ public:
 
     void paint(cairo_t *c, const ActionImageConfig &cfg, double alpha = 1.0);
 
-    std::vector<Rect> mask(const BackgroundImageConfig &cfg, int width,
-                           int height);
+    // The returned region is valid until the next call.
+    const std::vector<Rect> &mask(const BackgroundImageConfig &cfg, int width,
+                                  int height);
 
     bool setIconTheme(const std::string &name);
 
@@ -321,9 +323,33 @@ public:
 
 private:
     void reset();
+    cairo_surface_t *tiledBackground(cairo_t *c,
+                                     const BackgroundImageConfig &cfg,
+                                     const ThemeImage &image, int width,
+                                     int height, double scale);
+
+    struct TiledBackground {
+        const BackgroundImageConfig *cfg;
+        int width;
+        int height;
+        double scale;
+        UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface;
+    };
+
+    struct MaskRegion {
+        const BackgroundImageConfig *cfg;
+        int width;
+        int height;
+        std::vector<Rect> rects;
+    };
 
     std::unordered_map<const BackgroundImageConfig *, ThemeImage>
         backgroundImageTable_;
+    // Backgrounds tiled in device pixels for painting with scale, most recent
+    // first.
+    std::list<TiledBackground> tiledBackgroundCache_;
+    // Input region masks, most recent first.
+    std::list<MaskRegion> maskCache_;
     std::unordered_map<const ActionImageConfig *, ThemeImage> actionImageTable_;
     std::unordered_map<std::string, ThemeImage> trayImageTable_;
     IconTheme iconTheme_;
@@ -71,20 +71,10 @@ wayland::WlSurface *WaylandCursor::getOrCreateSurface() {
 }
 
 int32_t WaylandCursor::scale() {
-    auto outputs = pointer_->ui()->display()->getGlobals<wayland::WlOutput>();
-    int32_t scale = 1;
     if (outputScale_) {
         return *outputScale_;
     }
-    for (const auto &output : outputs) {
-        const auto *info =
-            pointer_->ui()->display()->outputInformation(output.get());
-        if (!info) {
-            continue;
-        }
-        scale = std::max(scale, info->scale());
-    }
-    return scale;
+    return pointer_->ui()->display()->maxOutputScale();
 }
 
 void WaylandCursor::update() {
@@ -95,6 +85,7 @@ void WaylandCursor::update() {
         cursorShape_->setShape(pointer_->enterSerial(),
                                WP_CURSOR_SHAPE_DEVICE_V1_SHAPE_DEFAULT);
         surface_.reset();
+        theme_.reset();
         return;
     }
     auto info = pointer_->ui()->cursorTheme()->loadCursorTheme(scale());
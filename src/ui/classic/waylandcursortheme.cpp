@@ -72,8 +72,10 @@ void WaylandCursorTheme::setTheme(const std::string &theme) {
 
 WaylandCursorInfo WaylandCursorTheme::loadCursorTheme(int scale) {
     auto size = cursorSize_ * scale;
-    if (auto theme = findValue(themes_, size)) {
-        return *theme;
+    if (auto *cached = findValue(themes_, size)) {
+        if (auto theme = cached->theme.lock()) {
+            return {std::move(theme), cached->cursor};
+        }
     }
     WaylandCursorInfo info;
     info.theme = std::shared_ptr<wl_cursor_theme>(
@@ -88,8 +90,8 @@ WaylandCursorInfo WaylandCursorTheme::loadCursorTheme(int scale) {
         }
     }
 
-    auto &themePtr = themes_[size] = std::move(info);
-    return themePtr;
+    themes_[size] = {info.theme, info.cursor};
+    return info;
 }
 
 } // namespace fcitx::classicui
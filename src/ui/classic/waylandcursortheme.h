@@ -39,9 +39,15 @@ private:
 
     fcitx::Signal<void()> themeChangedSignal_;
 
+    struct CachedCursorTheme {
+        std::weak_ptr<wl_cursor_theme> theme;
+        wl_cursor *cursor = nullptr;
+    };
+
     std::shared_ptr<wayland::WlShm> shm_;
-    // Size to theme map;
-    std::unordered_map<int, WaylandCursorInfo> themes_;
+    // Size to theme map, the theme is only kept alive by the cursors using
+    // it, so the themes of the scales that are no longer used are freed.
+    std::unordered_map<int, CachedCursorTheme> themes_;
     int cursorSize_ = 24;
     std::string themeName_;
 #ifdef ENABLE_DBUS
@@ -120,8 +120,8 @@ void WaylandInputWindow::updateBlur() {
         if (ui_->parent()->theme().inputPanel->blurMask->empty()) {
             region->add(rect.left(), rect.top(), rect.width(), rect.height());
         } else {
-            auto regions = parent_->theme().mask(parent_->theme().maskConfig(),
-                                                 width, height);
+            const auto &regions = parent_->theme().mask(
+                parent_->theme().maskConfig(), width, height);
             for (const auto &rect : regions) {
                 region->add(rect.left(), rect.top(), rect.width(),
                             rect.height());
@@ -207,6 +207,9 @@ void WaylandInputWindow::update(fcitx::InputContext *ic) {
         updateBlur();
     }
 
+    // Buffers are reused in turn, so they never hold the last frame and
+    // are always painted entirely.
+    takeDamage();
     if (auto *surface = window_->prerender()) {
         cairo_t *c = cairo_create(surface);
         paint(c, width, height,
@@ -222,6 +225,7 @@ void WaylandInputWindow::repaint() {
         return;
     }
 
+    takeDamage();
     if (auto *surface = window_->prerender()) {
         cairo_t *c = cairo_create(surface);
         paint(c, window_->width(), window_->height(),
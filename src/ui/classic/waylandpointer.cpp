@@ -43,36 +43,62 @@ void WaylandPointer::initPointer() {
         pointerFocus_ = window->watch();
         pointerFocusX_ = wl_fixed_to_int(sx);
         pointerFocusY_ = wl_fixed_to_int(sy);
+        motionPending_ = false;
         window->hover()(pointerFocusX_, pointerFocusY_);
     });
     pointer_->leave().connect([this](uint32_t, wayland::WlSurface *surface) {
         if (auto *window = pointerFocus_.get()) {
             if (window->surface() == surface) {
                 pointerFocus_.unwatch();
+                motionPending_ = false;
                 window->leave()();
             }
         }
     });
+    // High rate mice may send many motions per frame, only the last position
+    // of the frame is used for hovering.
     pointer_->motion().connect([this](uint32_t, wl_fixed_t sx, wl_fixed_t sy) {
-        if (auto *window = pointerFocus_.get()) {
-            pointerFocusX_ = wl_fixed_to_int(sx);
-            pointerFocusY_ = wl_fixed_to_int(sy);
-            window->hover()(pointerFocusX_, pointerFocusY_);
+        if (!pointerFocus_.isValid()) {
+            return;
+        }
+        const int x = wl_fixed_to_int(sx);
+        const int y = wl_fixed_to_int(sy);
+        if (x == pointerFocusX_ && y == pointerFocusY_) {
+            return;
+        }
+        pointerFocusX_ = x;
+        pointerFocusY_ = y;
+        motionPending_ = true;
+        if (pointer_->actualVersion() < WL_POINTER_FRAME_SINCE_VERSION) {
+            flushMotion();
         }
     });
+    pointer_->frame().connect([this]() { flushMotion(); });
     pointer_->button().connect(
         [this](uint32_t, uint32_t, uint32_t button, uint32_t state) {
+            flushMotion();
             if (auto *window = pointerFocus_.get()) {
                 window->click()(pointerFocusX_, pointerFocusY_, button, state);
             }
         });
     pointer_->axis().connect([this](uint32_t, uint32_t axis, wl_fixed_t value) {
+        flushMotion();
         if (auto *window = pointerFocus_.get()) {
             window->axis()(pointerFocusX_, pointerFocusY_, axis, value);
         }
     });
 }
 
+void WaylandPointer::flushMotion() {
+    if (!motionPending_) {
+        return;
+    }
+    motionPending_ = false;
+    if (auto *window = pointerFocus_.get()) {
+        window->hover()(pointerFocusX_, pointerFocusY_);
+    }
+}
+
 void WaylandPointer::initTouch() {
     touch_->down().connect([this](uint32_t, uint32_t,
                                   wayland::WlSurface *surface, int,
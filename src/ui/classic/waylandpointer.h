@@ -37,13 +37,16 @@ public:
 private:
     void initPointer();
     void initTouch();
+    void flushMotion();
     WaylandUI *ui_;
     wayland::Display *display_;
     std::unique_ptr<wayland::WlPointer> pointer_;
-    TrackableObjectReference<WaylandWindow> pointerFocus_;
+    LocalTrackableObjectReference<WaylandWindow> pointerFocus_;
     int pointerFocusX_ = 0, pointerFocusY_ = 0;
+    // Whether pointer moved since the last hover.
+    bool motionPending_ = false;
     std::unique_ptr<wayland::WlTouch> touch_;
-    TrackableObjectReference<WaylandWindow> touchFocus_;
+    LocalTrackableObjectReference<WaylandWindow> touchFocus_;
     int touchFocusX_ = 0, touchFocusY_ = 0;
     ScopedConnection capConn_;
     uint32_t enterSerial_ = 0;
@@ -7,6 +7,7 @@
 
 #include "waylandshmwindow.h"
 #include "common.h"
+#include "wl_callback.h"
 
 namespace fcitx::classicui {
 
@@ -29,8 +30,10 @@ WaylandShmWindow::WaylandShmWindow(WaylandUI *ui)
 WaylandShmWindow::~WaylandShmWindow() {}
 
 void WaylandShmWindow::destroyWindow() {
+    frameCallback_.reset();
     buffers_.clear();
     buffer_ = nullptr;
+    pool_.reset();
     WaylandWindow::destroyWindow();
 }
 
@@ -38,26 +41,41 @@ void WaylandShmWindow::newBuffer(uint32_t width, uint32_t height) {
     if (!shm_) {
         return;
     }
+    if (!pool_) {
+        pool_ = std::make_unique<wayland::ShmPool>(shm_.get());
+    }
     buffers_.emplace_back(std::make_unique<wayland::Buffer>(
-        shm_.get(), width, height, WL_SHM_FORMAT_ARGB8888));
-    buffers_.back()->rendered().connect([this]() {
-        // Use defer event here, otherwise repaint may delete buffer and cause
-        // problem.
-        deferEvent_ = ui_->parent()->instance()->eventLoop().addDeferEvent(
-            [this](EventSource *) {
-                if (pending_) {
-                    pending_ = false;
-
-                    CLASSICUI_DEBUG() << "Trigger repaint";
-                    repaint_();
-                }
-                deferEvent_.reset();
-                return true;
-            });
-    });
+        pool_.get(), width, height, WL_SHM_FORMAT_ARGB8888));
+    buffers_.back()->rendered().connect(
+        [this]() { schedulePendingRepaint(); });
+}
+
+void WaylandShmWindow::schedulePendingRepaint() {
+    // Use defer event here, otherwise repaint may delete buffer and cause
+    // problem.
+    deferEvent_ = ui_->parent()->instance()->eventLoop().addDeferEvent(
+        [this](EventSource *) {
+            if (pending_ && !frameCallback_) {
+                pending_ = false;
+
+                CLASSICUI_DEBUG() << "Trigger repaint";
+                repaint_();
+            }
+            deferEvent_.reset();
+            return true;
+        });
 }
 
 cairo_surface_t *WaylandShmWindow::prerender() {
+    // The last frame is not presented yet, anything painted now would be
+    // replaced before it is shown. Paint the latest state when it is done.
+    if (frameCallback_) {
+        CLASSICUI_DEBUG() << "Wait for frame callback.";
+        pending_ = true;
+        buffer_ = nullptr;
+        return nullptr;
+    }
+
     // We use double buffer.
     decltype(buffers_)::iterator iter;
     for (iter = buffers_.begin(); iter != buffers_.end(); iter++) {
@@ -107,19 +125,26 @@ void WaylandShmWindow::render() {
         return;
     }
 
+    if (!buffer_->attachToSurface(surface_.get(),
+                                  viewport_ ? 1 : lastOutputScale_)) {
+        return;
+    }
     if (viewport_) {
-        if (buffer_->attachToSurface(surface_.get(), 1)) {
-            viewport_->setDestination(width_, height_);
-            surface_->commit();
-        }
-    } else {
-        if (buffer_->attachToSurface(surface_.get(), lastOutputScale_)) {
-            surface_->commit();
-        }
+        viewport_->setDestination(width_, height_);
     }
+    frameCallback_.reset(surface_->frame());
+    frameCallback_->done().connect([this](uint32_t) {
+        frameCallback_.reset();
+        if (pending_) {
+            schedulePendingRepaint();
+        }
+    });
+    surface_->commit();
 }
 
 void WaylandShmWindow::hide() {
+    // Hidden surface may never receive the frame callback.
+    frameCallback_.reset();
     if (!surface_) {
         return;
     }
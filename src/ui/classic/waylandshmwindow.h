@@ -26,13 +26,18 @@ public:
 
 private:
     void newBuffer(uint32_t width, uint32_t height);
+    void schedulePendingRepaint();
 
     std::shared_ptr<wayland::WlShm> shm_;
+    // Need to outlive the buffers.
+    std::unique_ptr<wayland::ShmPool> pool_;
     std::vector<std::unique_ptr<wayland::Buffer>> buffers_;
     // Pointer to the current buffer.
     wayland::Buffer *buffer_ = nullptr;
     bool pending_ = false;
     std::unique_ptr<EventSource> deferEvent_;
+    // Frame callback of the last commit, nothing is painted until it is done.
+    std::unique_ptr<wayland::WlCallback> frameCallback_;
 };
 } // namespace classicui
 } // namespace fcitx
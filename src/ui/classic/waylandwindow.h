@@ -19,7 +19,8 @@
 namespace fcitx {
 namespace classicui {
 
-class WaylandWindow : public Window, public TrackableObject<WaylandWindow> {
+class WaylandWindow : public Window,
+                      public LocalTrackableObject<WaylandWindow> {
 public:
     static inline constexpr unsigned int ScaleDominator = 120;
     static inline constexpr double ScaleDominatorF = ScaleDominator;
@@ -189,7 +189,7 @@ void XCBInputWindow::update(InputContext *inputContext) {
                                         XCB_ATOM_CARDINAL, 32, data.size(),
                                         data.data());
                 } else {
-                    auto region = parent_->theme().mask(
+                    const auto &region = parent_->theme().mask(
                         parent_->theme().maskConfig(), width, height);
                     for (const auto &rect : region) {
                         data.push_back(rect.left());
@@ -206,14 +206,11 @@ void XCBInputWindow::update(InputContext *inputContext) {
         }
     }
 
-    cairo_t *c = cairo_create(prerender());
     updatePosition(inputContext);
     if (!oldVisible) {
         xcb_map_window(ui_->connection(), wid_);
     }
-    paint(c, width, height, /*scale=*/1.0);
-    cairo_destroy(c);
-    render();
+    repaint();
 }
 
 bool XCBInputWindow::filterEvent(xcb_generic_event_t *event) {
@@ -223,6 +220,9 @@ bool XCBInputWindow::filterEvent(xcb_generic_event_t *event) {
     case XCB_EXPOSE: {
         auto *expose = reinterpret_cast<xcb_expose_event_t *>(event);
         if (expose->window == wid_) {
+            addDamage(Rect()
+                          .setPosition(expose->x, expose->y)
+                          .setSize(expose->width, expose->height));
             repaint();
             return true;
         }
@@ -266,14 +266,41 @@ bool XCBInputWindow::filterEvent(xcb_generic_event_t *event) {
     return false;
 }
 
+cairo_surface_t *XCBInputWindow::prerender() {
+    // Keep the content, so only the damaged area need to be painted.
+    if (contentSurface_ && contentWidth_ == width() &&
+        contentHeight_ == height()) {
+        return contentSurface_.get();
+    }
+    damageAll();
+    contentWidth_ = width();
+    contentHeight_ = height();
+    return XCBWindow::prerender();
+}
+
 void XCBInputWindow::repaint() {
     if (!visible()) {
         return;
     }
-    if (auto *surface = prerender()) {
-        cairo_t *c = cairo_create(surface);
-        paint(c, width(), height(), /*scale=*/1.0);
-        cairo_destroy(c);
+    auto *surface = prerender();
+    if (!surface) {
+        return;
+    }
+    auto damage = takeDamage();
+    if (damage && damage->isEmpty()) {
+        return;
+    }
+    cairo_t *c = cairo_create(surface);
+    if (damage) {
+        cairo_rectangle(c, damage->left(), damage->top(), damage->width(),
+                        damage->height());
+        cairo_clip(c);
+    }
+    paint(c, width(), height(), /*scale=*/1.0);
+    cairo_destroy(c);
+    if (damage) {
+        render(*damage);
+    } else {
         render();
     }
 }
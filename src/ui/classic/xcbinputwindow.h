@@ -25,6 +25,8 @@ public:
 
     void updateDPI(InputContext *inputContext);
 
+    cairo_surface_t *prerender() override;
+
 private:
     void repaint();
     const Rect *getClosestScreen(const Rect &cursorRect) const;
@@ -35,6 +37,9 @@ private:
 
     xcb_atom_t atomBlur_;
     int dpi_ = -1;
+    // Size of the kept content surface.
+    int contentWidth_ = 0;
+    int contentHeight_ = 0;
 };
 } // namespace classicui
 } // namespace fcitx
@@ -5,6 +5,7 @@
  *
  */
 #include "xcbmenu.h"
+#include <algorithm>
 #include <optional>
 #include <pango/pangocairo.h>
 #include <xcb/xcb.h>
@@ -21,10 +22,8 @@ namespace fcitx::classicui {
 
 XCBMenu::XCBMenu(XCBUI *ui, MenuPool *pool, Menu *menu)
     : XCBWindow(ui), pool_(pool), menu_(menu) {
-    fontMap_.reset(pango_cairo_font_map_new());
-    fontMapDefaultDPI_ = pango_cairo_font_map_get_resolution(
-        PANGO_CAIRO_FONT_MAP(fontMap_.get()));
-    context_.reset(pango_font_map_create_context(fontMap_.get()));
+    context_.reset(
+        pango_font_map_create_context(ui_->parent()->fontMap(dpi_)));
     if (auto *ic = ui_->parent()->instance()->mostRecentInputContext()) {
         lastRelevantIc_ = ic->watch();
     }
@@ -297,7 +296,7 @@ void XCBMenu::setHoveredIndex(int idx) {
     //              << " child is valid: " << child_.isValid();
 
     hoveredIndex_ = idx;
-    update();
+    updateHighlight();
     pool_->setPopupMenuTimer(
         ui_->parent()->instance()->eventLoop().addTimeEvent(
             CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 300000, 0,
@@ -340,8 +339,9 @@ void XCBMenu::setHoveredIndex(int idx) {
                         // mouse in the window.
                         hideTillMenuHasMouseOrTopLevel();
                     }
-                    update();
+                    updateHighlight();
                 } while (0);
+                ui_->scheduleFlush();
                 pool_->setPopupMenuTimer(nullptr);
                 return true;
             }));
@@ -362,17 +362,51 @@ std::pair<MenuItem *, Action *> XCBMenu::actionAt(size_t index) {
 
 void XCBMenu::updateDPI(int x, int y) {
     dpi_ = ui_->dpiByPosition(x, y);
+    pango_context_set_font_map(context_.get(), ui_->parent()->fontMap(dpi_));
+    pango_cairo_context_set_resolution(context_.get(), dpi_);
+}
 
-    // Unlike pango cairo context, Cairo font map does not accept negative dpi.
-    // Restore to default value instead.
-    if (dpi_ < 0) {
-        pango_cairo_font_map_set_resolution(
-            PANGO_CAIRO_FONT_MAP(fontMap_.get()), fontMapDefaultDPI_);
-    } else {
-        pango_cairo_font_map_set_resolution(
-            PANGO_CAIRO_FONT_MAP(fontMap_.get()), dpi_);
+bool XCBMenu::isHighlight(int index) const {
+    return hoveredIndex_ >= 0 ? (hoveredIndex_ == index)
+                              : (subMenuIndex_ == index);
+}
+
+void XCBMenu::updateHighlight() {
+    if (!contentSurface_) {
+        update();
+        return;
     }
-    pango_cairo_context_set_resolution(context_.get(), dpi_);
+
+    Rect damage;
+    for (int i = 0, e = items_.size(); i < e; i++) {
+        auto &item = items_[i];
+        if (item.isSeparator_ || item.isHighlight_ == isHighlight(i)) {
+            continue;
+        }
+        item.isHighlight_ = !item.isHighlight_;
+        // Text and icons are inside of the highlight region.
+        const auto &rect = item.region_;
+        if (damage.isEmpty()) {
+            damage = rect;
+        } else {
+            damage = Rect(std::min(damage.left(), rect.left()),
+                          std::min(damage.top(), rect.top()),
+                          std::max(damage.right(), rect.right()),
+                          std::max(damage.bottom(), rect.bottom()));
+        }
+    }
+    damage = damage.intersected(Rect(0, 0, width(), height()));
+    if (damage.isEmpty()) {
+        return;
+    }
+
+    cairo_t *c = cairo_create(contentSurface_.get());
+    cairo_rectangle(c, damage.left(), damage.top(), damage.width(),
+                    damage.height());
+    cairo_clip(c);
+    paint(c, width(), height());
+    cairo_destroy(c);
+    render(damage);
 }
 
 void XCBMenu::update() {
@@ -423,8 +457,7 @@ void XCBMenu::update() {
     // Pass 1: get max size of all items, and set size.
     for (auto *action : actions) {
         auto &item = items_[i];
-        item.isHighlight_ =
-            hoveredIndex_ >= 0 ? (hoveredIndex_ == i) : (subMenuIndex_ == i);
+        item.isHighlight_ = isHighlight(i);
         i++;
         item.hasSubMenu_ = action->menu() != nullptr;
         item.isSeparator_ = action->isSeparator();
@@ -505,7 +538,13 @@ void XCBMenu::update() {
     resize(width, height);
 
     cairo_t *c = cairo_create(prerender());
+    paint(c, width, height);
+    cairo_destroy(c);
+    render();
+}
 
+void XCBMenu::paint(cairo_t *c, int width, int height) {
+    auto &theme = ui_->parent()->theme();
     cairo_set_operator(c, CAIRO_OPERATOR_SOURCE);
     theme.paint(c, *theme.menu->background, width, height, /*alpha=*/1.0,
                 /*scale=*/1.0);
@@ -560,9 +599,6 @@ void XCBMenu::update() {
         pango_cairo_show_layout(c, item.layout_.get());
         cairo_restore(c);
     }
-
-    cairo_destroy(c);
-    render();
 }
 
 void XCBMenu::postCreateWindow() {
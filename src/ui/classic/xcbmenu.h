@@ -33,7 +33,7 @@ struct MenuItem {
 
 enum class ConstrainAdjustment { Slide, Flip };
 
-class XCBMenu : public XCBWindow, public TrackableObject<XCBMenu> {
+class XCBMenu : public XCBWindow, public LocalTrackableObject<XCBMenu> {
 public:
     XCBMenu(XCBUI *ui, MenuPool *pool, Menu *menu);
     ~XCBMenu();
@@ -75,6 +75,10 @@ private:
     void hideTillMenuHasMouseOrTopLevelHelper();
     InputContext *lastRelevantIc();
     void update();
+    // Only repaint the items that highlight is changed.
+    void updateHighlight();
+    bool isHighlight(int index) const;
+    void paint(cairo_t *c, int width, int height);
     void setHoveredIndex(int idx);
     void setChild(XCBMenu *child);
     void updateDPI(int x, int y);
@@ -82,17 +86,15 @@ private:
 
     MenuPool *pool_;
 
-    GObjectUniquePtr<PangoFontMap> fontMap_;
     GObjectUniquePtr<PangoContext> context_;
     std::vector<MenuItem> items_;
 
     ScopedConnection destroyed_;
     TrackableObjectReference<InputContext> lastRelevantIc_;
     Menu *menu_;
-    TrackableObjectReference<XCBMenu> parent_;
-    TrackableObjectReference<XCBMenu> child_;
+    LocalTrackableObjectReference<XCBMenu> parent_;
+    LocalTrackableObjectReference<XCBMenu> child_;
     int dpi_ = -1;
-    double fontMapDefaultDPI_ = 96.0;
     int x_ = 0;
     int y_ = 0;
     bool hasMouse_ = false;
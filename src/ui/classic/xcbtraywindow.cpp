@@ -333,8 +333,7 @@ void XCBTrayWindow::postCreateWindow() {
     }
 }
 
-void XCBTrayWindow::paint(cairo_t *c) {
-    auto &theme = ui_->parent()->theme();
+std::pair<std::string, std::string> XCBTrayWindow::iconAndLabel() const {
     auto *instance = ui_->parent()->instance();
     auto *ic = ui_->parent()->instance()->lastFocusedInputContext();
     std::string icon = "input-keyboard";
@@ -347,7 +346,12 @@ void XCBTrayWindow::paint(cairo_t *c) {
     if (entry) {
         label = entry->label();
     }
+    return {std::move(icon), std::move(label)};
+}
 
+void XCBTrayWindow::paint(cairo_t *c, const std::string &icon,
+                          const std::string &label) {
+    auto &theme = ui_->parent()->theme();
     const auto &image = theme.loadImage(
         icon, label, std::min(height(), width()), ui_->parent());
 
@@ -377,10 +381,20 @@ void XCBTrayWindow::update() {
         return;
     }
 
+    // Status is updated far more often than the icon really changes.
+    auto [icon, label] = iconAndLabel();
+    auto key = std::make_tuple(icon, label, width(), height(),
+                               ui_->parent()->themeSerial());
+    if (contentSurface_ && paintedIcon_ == key) {
+        render();
+        return;
+    }
+
     if (auto *surface = prerender()) {
         cairo_t *c = cairo_create(surface);
-        paint(c);
+        paint(c, icon, label);
         cairo_destroy(c);
+        paintedIcon_ = std::move(key);
         render();
     }
 }
@@ -7,6 +7,10 @@
 #ifndef _FCITX_UI_CLASSIC_XCBTRAYWINDOW_H_
 #define _FCITX_UI_CLASSIC_XCBTRAYWINDOW_H_
 
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
 #include "fcitx/menu.h"
 #include "xcbmenu.h"
 #include "xcbwindow.h"
@@ -23,6 +27,8 @@ public:
     void resume();
     void suspend();
     void update();
+    // Paint the icon again on next update, e.g. icon theme is changed.
+    void invalidate() { paintedIcon_.reset(); }
     void postCreateWindow() override;
 
     void updateMenu();
@@ -37,7 +43,8 @@ private:
     void refreshDockWindow();
     xcb_visualid_t trayVisual();
     bool trayOrientation();
-    void paint(cairo_t *cr);
+    std::pair<std::string, std::string> iconAndLabel() const;
+    void paint(cairo_t *cr, const std::string &icon, const std::string &label);
     void createTrayWindow();
     void resizeTrayWindow();
 
@@ -71,6 +78,9 @@ private:
     bool isHorizontal_ = true;
     int hintWidth_ = 0;
     int hintHeight_ = 0;
+    // Icon, label, size and theme serial of the content surface.
+    std::optional<std::tuple<std::string, std::string, int, int, uint64_t>>
+        paintedIcon_;
 
     Menu groupMenu_;
     std::list<SimpleAction> groupActions_;
@@ -6,6 +6,7 @@
  */
 
 #include "xcbui.h"
+#include <sys/socket.h>
 #include <cairo.h>
 #include <xcb/randr.h>
 #include <xcb/xcb_aux.h>
@@ -38,6 +39,23 @@ xcb_visualid_t findVisual(xcb_screen_t *screen) {
     return visual->visual_id;
 }
 
+// MIT-SHM only works when the server is on the same machine.
+bool canUseShm(xcb_connection_t *conn) {
+    struct sockaddr_storage address;
+    socklen_t length = sizeof(address);
+    if (getsockname(xcb_get_file_descriptor(conn),
+                    reinterpret_cast<struct sockaddr *>(&address),
+                    &length) != 0 ||
+        address.ss_family != AF_UNIX) {
+        return false;
+    }
+    static const char name[] = "MIT-SHM";
+    auto cookie = xcb_query_extension(conn, sizeof(name) - 1, name);
+    auto reply =
+        makeUniqueCPtr(xcb_query_extension_reply(conn, cookie, nullptr));
+    return reply && reply->present;
+}
+
 XCBFontOption forcedDpi(xcb_connection_t *conn, xcb_screen_t *screen) {
     int offset = 0;
     std::vector<char> resources;
@@ -203,6 +221,7 @@ XCBUI::XCBUI(ClassicUI *parent, const std::string &name, xcb_connection_t *conn,
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 10000, 0,
         [this](EventSourceTime *, uint64_t) {
             initScreen();
+            scheduleFlush();
             return true;
         });
     initScreenEvent_->setEnabled(false);
@@ -288,6 +307,8 @@ XCBUI::XCBUI(ClassicUI *parent, const std::string &name, xcb_connection_t *conn,
     root_ = screen->root;
     fontOption_ = forcedDpi(conn_, screen);
     CLASSICUI_DEBUG() << "Xft.dpi: " << fontOption_.dpi;
+    useShm_ = canUseShm(conn_);
+    CLASSICUI_DEBUG() << "Use MIT-SHM: " << useShm_;
     initScreen();
     refreshCompositeManager();
     trayWindow_->initTray();
@@ -656,6 +677,7 @@ void XCBUI::readXSettings() {
             if (name == "Net/IconThemeName" && !value.empty()) {
                 iconThemeName_ = value;
                 if (parent()->theme().setIconTheme(iconThemeName_)) {
+                    trayWindow_->invalidate();
                     trayWindow_->update();
                 }
             }
@@ -686,16 +708,19 @@ void XCBUI::update(UserInterfaceComponent component,
                    InputContext *inputContext) {
     if (component == UserInterfaceComponent::InputPanel) {
         inputWindow_->update(inputContext);
+        scheduleFlush();
     }
 }
 
 void XCBUI::updateCursor(InputContext *inputContext) {
     inputWindow_->updatePosition(inputContext);
+    scheduleFlush();
 }
 
 void XCBUI::updateCurrentInputMethod(InputContext *inputContext) {
     FCITX_UNUSED(inputContext);
     trayWindow_->update();
+    scheduleFlush();
 }
 
 int XCBUI::dpiByPosition(int x, int y) {
@@ -756,6 +781,7 @@ void XCBUI::updateTray() {
     } else {
         trayWindow_->suspend();
     }
+    scheduleFlush();
 }
 
 void XCBUI::setEnableTray(bool enable) {
@@ -791,9 +817,14 @@ void XCBUI::ungrabPointer() {
     if (pointerGrabber_) {
         xcb_ungrab_pointer(conn_, XCB_TIME_CURRENT_TIME);
         pointerGrabber_ = nullptr;
+        scheduleFlush();
     }
 }
 
+void XCBUI::scheduleFlush() {
+    parent_->xcb()->call<IXCBModule::scheduleFlush>(displayName_);
+}
+
 void XCBUI::destroyCairoDevice(cairo_device_t *device) {
     if (!device) {
         return;
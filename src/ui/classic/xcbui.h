@@ -63,10 +63,15 @@ public:
     int dpiByPosition(int x, int y);
     int scaledDPI(int dpi);
     const XCBFontOption &fontOption() const { return fontOption_; }
+    // Whether image surfaces can be sent to the server with shared memory.
+    bool useShm() const { return useShm_; }
 
     bool grabPointer(XCBWindow *window);
     void ungrabPointer();
     XCBWindow *pointerGrabber() const { return pointerGrabber_; }
+    // Flush the requests written outside of an xcb event filter at the end
+    // of current main loop iteration.
+    void scheduleFlush();
 
 private:
     void refreshCompositeManager();
@@ -107,6 +112,7 @@ private:
     int maxDpi_ = -1;
     int primaryDpi_ = -1;
     int screenDpi_ = 96;
+    bool useShm_ = false;
     MultiScreenExtension multiScreen_ = MultiScreenExtension::EXTNone;
     int xrandrFirstEvent_ = 0;
     std::unique_ptr<EventSourceTime> initScreenEvent_;
@@ -135,18 +135,25 @@ void XCBWindow::resize(unsigned int width, unsigned int height) {
 }
 
 cairo_surface_t *XCBWindow::prerender() {
-#if 1
-    contentSurface_.reset(cairo_surface_create_similar(
-        surface_.get(), CAIRO_CONTENT_COLOR_ALPHA, width(), height()));
-#else
-    contentSurface_.reset(
-        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height()));
-#endif
+    if (ui_->useShm()) {
+        // Paint locally, cairo-xcb backs the image with shared memory, so
+        // render() does not send the pixels over the socket.
+        contentSurface_.reset(cairo_surface_create_similar_image(
+            surface_.get(), CAIRO_FORMAT_ARGB32, width(), height()));
+    } else {
+        // Keep the content on the server for remote display.
+        contentSurface_.reset(cairo_surface_create_similar(
+            surface_.get(), CAIRO_CONTENT_COLOR_ALPHA, width(), height()));
+    }
     return contentSurface_.get();
 }
 
-void XCBWindow::render() {
+void XCBWindow::render() { render(Rect(0, 0, width(), height())); }
+
+void XCBWindow::render(const Rect &rect) {
     auto *cr = cairo_create(surface_.get());
+    cairo_rectangle(cr, rect.left(), rect.top(), rect.width(), rect.height());
+    cairo_clip(cr);
     cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
     cairo_set_source_surface(cr, contentSurface_.get(), 0, 0);
     cairo_paint(cr);
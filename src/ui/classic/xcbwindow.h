@@ -9,6 +9,7 @@
 
 #include <cairo/cairo.h>
 #include <xcb/xcb.h>
+#include "fcitx-utils/rect.h"
 #include "window.h"
 #include "xcbui.h"
 
@@ -27,6 +28,8 @@ public:
 
     cairo_surface_t *prerender() override;
     void render() override;
+    // Only copy rect of the content to the window.
+    void render(const Rect &rect);
 
     virtual bool filterEvent(xcb_generic_event_t *event) = 0;
 
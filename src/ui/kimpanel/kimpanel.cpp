@@ -21,6 +21,7 @@
 #include "fcitx/instance.h"
 #include "fcitx/menu.h"
 #include "fcitx/misc_p.h"
+#include "fcitx/statusarea.h"
 #include "fcitx/userinterfacemanager.h"
 #include "dbus_public.h"
 
@@ -35,6 +36,29 @@ enum class CursorRectMethod {
     SetRelativeSpotRectV2
 };
 
+struct KimpanelLookupTable {
+    std::vector<std::string> labels;
+    std::vector<std::string> texts;
+    std::vector<std::string> attrs;
+    bool hasPrev = false;
+    bool hasNext = false;
+    int pos = -1;
+    int layout = 0;
+};
+
+// State of the input panel that is sent to the panel for one update. Lookup
+// table and its visibility are only sent when updateLookupTable is true.
+struct KimpanelInputPanel {
+    std::string preedit;
+    int preeditCaret = 0;
+    std::string aux;
+    bool showPreedit = false;
+    bool showAux = false;
+    bool updateLookupTable = true;
+    KimpanelLookupTable lookupTable;
+    bool showLookupTable = false;
+};
+
 class KimpanelProxy : public dbus::ObjectVTable<KimpanelProxy> {
 
 public:
@@ -83,6 +107,43 @@ public:
         msg.send();
     }
 
+    // Send the whole input panel with a single SetInputPanel call if the
+    // panel supports it, otherwise fallback to the individual signals and
+    // SetLookupTable.
+    void updateInputPanel(const KimpanelInputPanel &state, bool batched) {
+        if (batched) {
+            auto msg =
+                bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
+                                       "org.kde.impanel2", "SetInputPanel");
+            // Signature: sisbbbasasasbbiib
+            msg << state.preedit << state.preeditCaret << state.aux;
+            msg << state.showPreedit << state.showAux;
+            msg << state.updateLookupTable;
+            appendLookupTable(msg, state.lookupTable);
+            msg << state.showLookupTable;
+            msg.send();
+            return;
+        }
+
+        if (state.showPreedit || state.showAux) {
+            updateAux(state.aux, "");
+            updatePreeditText(state.preedit, "");
+            if (state.showPreedit) {
+                updatePreeditCaret(state.preeditCaret);
+            }
+        }
+        showPreedit(state.showPreedit);
+        showAux(state.showAux);
+        if (state.updateLookupTable) {
+            auto msg =
+                bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
+                                       "org.kde.impanel2", "SetLookupTable");
+            appendLookupTable(msg, state.lookupTable);
+            msg.send();
+            showLookupTable(state.showLookupTable);
+        }
+    }
+
     FCITX_OBJECT_VTABLE_SIGNAL(execDialog, "ExecDialog", "s");
     FCITX_OBJECT_VTABLE_SIGNAL(execMenu, "ExecMenu", "as");
     FCITX_OBJECT_VTABLE_SIGNAL(registerProperties, "RegisterProperties", "as");
@@ -101,6 +162,12 @@ public:
     FCITX_OBJECT_VTABLE_SIGNAL(enable, "Enable", "b");
 
 private:
+    static void appendLookupTable(dbus::Message &msg,
+                                  const KimpanelLookupTable &table) {
+        msg << table.labels << table.texts << table.attrs;
+        msg << table.hasPrev << table.hasNext << table.pos << table.layout;
+    }
+
     dbus::Bus *bus_;
     std::unique_ptr<dbus::Slot> slot_;
     std::unique_ptr<dbus::Slot> slot2_;
@@ -124,37 +191,53 @@ void Kimpanel::reloadConfig() { readAsIni(config_, "conf/kimpanel.conf"); }
 
 void Kimpanel::suspend() {
     eventHandlers_.clear();
+    deferedFocusIn_.reset();
+    pendingFocusIn_.unwatch();
     proxy_.reset();
     bus_->releaseName("org.kde.kimpanel.inputmethod");
     hasRelative_ = false;
     hasRelativeV2_ = false;
+    lookupTableValid_ = false;
 }
 
 const Configuration *Kimpanel::getConfig() const { return &config_; }
 
+namespace {
+
+std::string actionStateToStatus(const StatusAreaActionState &state) {
+    // Same as Kimpanel::actionToStatus.
+    const char *type = "";
+    if (state.action->menu()) {
+        type = "menu";
+    }
+    return stringutils::concat("/Fcitx/", state.action->name(), ":",
+                               state.shortText, ":",
+                               IconTheme::iconName(state.icon), ":",
+                               state.longText, ":", type);
+}
+
+} // namespace
+
 void Kimpanel::registerAllProperties(InputContext *ic) {
     std::vector<std::string> props;
     if (!ic) {
         ic = instance_->lastFocusedInputContext();
     }
-    if (ic) {
-        for (auto *action :
-             ic->statusArea().actions(StatusGroup::BeforeInputMethod)) {
-            props.push_back(actionToStatus(action, ic));
-        }
-    }
-
     const auto imStatus = inputMethodStatus(ic);
-    props.push_back(imStatus);
-
+    bool imStatusAdded = false;
     if (ic) {
-        for (auto group :
-             {StatusGroup::InputMethod, StatusGroup::AfterInputMethod}) {
-            for (auto *action : ic->statusArea().actions(group)) {
-                props.push_back(actionToStatus(action, ic));
+        for (const auto &state : ic->statusArea().actionStates()) {
+            if (!imStatusAdded &&
+                state.group != StatusGroup::BeforeInputMethod) {
+                props.push_back(imStatus);
+                imStatusAdded = true;
             }
+            props.push_back(actionStateToStatus(state));
         }
     }
+    if (!imStatusAdded) {
+        props.push_back(imStatus);
+    }
 
     proxy_->registerProperties(props);
     proxy_->updateProperty(imStatus);
@@ -198,11 +281,26 @@ void Kimpanel::resume() {
                 if (s.find("SetRelativeSpotRectV2") != std::string::npos) {
                     hasRelativeV2_ = true;
                 }
+                if (s.find("SetInputPanel") != std::string::npos) {
+                    hasInputPanel_ = true;
+                }
             }
             return true;
         });
     }
 
+    deferedFocusIn_ =
+        instance_->eventLoop().addDeferEvent([this](EventSource *) {
+            auto *ic = pendingFocusIn_.get();
+            pendingFocusIn_.unwatch();
+            if (ic && ic->hasFocus() && proxy_) {
+                registerAllProperties(ic);
+                updateCurrentInputMethod(ic);
+            }
+            return true;
+        });
+    deferedFocusIn_->setEnabled(false);
+
     auto check = [this](Event &event) {
         if (!proxy_) {
             return;
@@ -245,8 +343,8 @@ void Kimpanel::resume() {
         [this](Event &event) {
             // Difference IC has difference set of actions.
             auto &icEvent = static_cast<InputContextEvent &>(event);
-            registerAllProperties(icEvent.inputContext());
-            updateCurrentInputMethod(icEvent.inputContext());
+            pendingFocusIn_ = icEvent.inputContext()->watch();
+            deferedFocusIn_->setOneShot();
         }));
     eventHandlers_.emplace_back(instance_->watchEvent(
         EventType::FocusGroupFocusChanged, EventWatcherPhase::Default,
@@ -255,9 +353,7 @@ void Kimpanel::resume() {
                 static_cast<FocusGroupFocusChangedEvent &>(event);
             if (!focusEvent.newFocus() &&
                 lastInputContext_.get() == focusEvent.oldFocus()) {
-                proxy_->showAux(false);
-                proxy_->showPreedit(false);
-                proxy_->showLookupTable(false);
+                hideInputPanel();
                 bus_->flush();
             }
         }));
@@ -276,9 +372,7 @@ void Kimpanel::update(UserInterfaceComponent component,
               stringutils::startsWith(inputContext->display(), "x11:") &&
               xcb()->call<IXCBModule::isXWayland>(
                   inputContext->display().substr(4))))) {
-            proxy_->showAux(false);
-            proxy_->showPreedit(false);
-            proxy_->showLookupTable(false);
+            hideInputPanel();
             static_cast<UserInterface *>(classicui())
                 ->update(component, inputContext);
             lastInputContext_ = inputContext->watch();
@@ -291,9 +385,23 @@ void Kimpanel::update(UserInterfaceComponent component,
 }
 
 void Kimpanel::updateInputPanel(InputContext *inputContext) {
-    lastInputContext_ = inputContext->watch();
     auto *instance = this->instance();
     auto &inputPanel = inputContext->inputPanel();
+    const auto dirty = inputPanel.dirtyComponents();
+    KimpanelInputPanel state;
+    // Lookup table is only resent if anything shown in it is changed, and a
+    // moved cursor alone is sent with UpdateLookupTableCursor.
+    const bool reuseLookupTable = lookupTableValid_ &&
+                                  lastInputContext_.get() == inputContext &&
+                                  dirty;
+    state.updateLookupTable =
+        !reuseLookupTable ||
+        !!(dirty & InputPanelComponents{InputPanelComponent::AuxDown,
+                                        InputPanelComponent::CandidateList,
+                                        InputPanelComponent::CandidatePage});
+    const bool updateCursor = !state.updateLookupTable &&
+                              dirty.test(InputPanelComponent::CandidateCursor);
+    lastInputContext_ = inputContext->watch();
 
     auto preedit = instance->outputFilter(inputContext, inputPanel.preedit());
     auto auxUp = instance->outputFilter(inputContext, inputPanel.auxUp());
@@ -306,100 +414,93 @@ void Kimpanel::updateInputPanel(InputContext *inputContext) {
             auto cursor = preedit.cursor() + auxUpString.size();
             auto utf8Cursor = utf8::lengthValidated(
                 text.begin(), std::next(text.begin(), cursor));
-            proxy_->updateAux("", "");
-            proxy_->updatePreeditText(text, "");
+            state.preedit = std::move(text);
             if (utf8Cursor != utf8::INVALID_LENGTH) {
-                proxy_->updatePreeditCaret(utf8Cursor);
-            } else {
-                proxy_->updatePreeditCaret(0);
+                state.preeditCaret = utf8Cursor;
             }
-            proxy_->showPreedit(true);
-            proxy_->showAux(false);
+            state.showPreedit = true;
         } else {
-            proxy_->updateAux(text, "");
-            proxy_->updatePreeditText("", "");
-            proxy_->showPreedit(false);
-            proxy_->showAux(true);
+            state.aux = std::move(text);
+            state.showAux = true;
         }
-    } else {
-        proxy_->showAux(false);
-        proxy_->showPreedit(false);
     }
 
-    auto auxDown = instance->outputFilter(inputContext, inputPanel.auxDown());
-    auto auxDownString = auxDown.toString();
-    auto candidateList = inputPanel.candidateList();
-
-    auto msg = bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
-                                      "org.kde.impanel2", "SetLookupTable");
-    auto visible =
-        !auxDownString.empty() || (candidateList && candidateList->size());
-    if (visible) {
-        std::vector<std::string> labels;
-        std::vector<std::string> texts;
-        std::vector<std::string> attrs;
-        bool hasPrev = false, hasNext = false;
-        int pos = -1;
-        int layout = static_cast<int>(CandidateLayoutHint::NotSet);
-        if (!auxDownString.empty()) {
-            labels.emplace_back("");
-            texts.push_back(auxDownString);
-            attrs.emplace_back("");
-        }
-        auxDownIsEmpty_ = auxDownString.empty();
-        if (candidateList) {
-            for (int i = 0, e = candidateList->size(); i < e; i++) {
-                const auto &candidate = candidateList->candidate(i);
-                if (candidate.isPlaceHolder()) {
-                    continue;
-                }
-                Text labelText = candidate.hasCustomLabel()
-                                     ? candidate.customLabel()
-                                     : candidateList->label(i);
-
-                labelText = instance->outputFilter(inputContext, labelText);
-                labels.push_back(labelText.toString());
-                auto candidateText = instance->outputFilter(
-                    inputContext, candidate.textWithComment());
-                texts.push_back(candidateText.toString());
-                attrs.emplace_back("");
-            }
-            if (auto *pageable = candidateList->toPageable()) {
-                hasPrev = pageable->hasPrev();
-                hasNext = pageable->hasNext();
+    if (state.updateLookupTable) {
+        auto auxDown =
+            instance->outputFilter(inputContext, inputPanel.auxDown());
+        auto auxDownString = auxDown.toString();
+        auto candidateList = inputPanel.candidateList();
+        auto &table = state.lookupTable;
+        state.showLookupTable =
+            !auxDownString.empty() || (candidateList && candidateList->size());
+        if (state.showLookupTable) {
+            table.layout = static_cast<int>(CandidateLayoutHint::NotSet);
+            if (!auxDownString.empty()) {
+                table.labels.emplace_back("");
+                table.texts.push_back(auxDownString);
+                table.attrs.emplace_back("");
             }
-            pos = candidateList->cursorIndex();
-            if (pos >= 0) {
-                pos += (auxDownString.empty() ? 0 : 1);
+            auxDownIsEmpty_ = auxDownString.empty();
+            if (candidateList) {
+                for (int i = 0, e = candidateList->size(); i < e; i++) {
+                    const auto &candidate = candidateList->candidate(i);
+                    if (candidate.isPlaceHolder()) {
+                        continue;
+                    }
+                    Text labelText = candidate.hasCustomLabel()
+                                         ? candidate.customLabel()
+                                         : candidateList->label(i);
+
+                    labelText = instance->outputFilter(inputContext, labelText);
+                    table.labels.push_back(labelText.toString());
+                    auto candidateText = instance->outputFilter(
+                        inputContext, candidate.textWithComment());
+                    table.texts.push_back(candidateText.toString());
+                    table.attrs.emplace_back("");
+                }
+                if (auto *pageable = candidateList->toPageable()) {
+                    table.hasPrev = pageable->hasPrev();
+                    table.hasNext = pageable->hasNext();
+                }
+                table.pos = candidateList->cursorIndex();
+                if (table.pos >= 0) {
+                    table.pos += (auxDownString.empty() ? 0 : 1);
+                }
+                table.layout = static_cast<int>(candidateList->layoutHint());
             }
-            layout = static_cast<int>(candidateList->layoutHint());
         }
+        lookupTableValid_ = true;
+    }
 
-        msg << labels << texts << attrs;
-        msg << hasPrev << hasNext << pos << layout;
-    } else {
-        std::vector<std::string> labels;
-        std::vector<std::string> texts;
-        std::vector<std::string> attrs;
-        msg << labels << texts << attrs;
-        msg << false << false << -1 << 0;
+    proxy_->updateInputPanel(state, hasInputPanel_);
+    if (updateCursor) {
+        if (auto candidateList = inputPanel.candidateList()) {
+            auto pos = candidateList->cursorIndex();
+            if (pos >= 0 && !auxDownIsEmpty_) {
+                pos += 1;
+            }
+            proxy_->updateLookupTableCursor(pos);
+        }
     }
-    msg.send();
-    proxy_->showLookupTable(visible);
     bus_->flush();
 }
 
+void Kimpanel::hideInputPanel() {
+    proxy_->updateInputPanel(KimpanelInputPanel(), hasInputPanel_);
+    lookupTableValid_ = false;
+}
+
 // This is heuristic, but we guranteed that we don't do crazy things with label.
 std::string extractTextForLabel(const std::string &label) {
     if (label.empty()) {
         return "";
     }
-    auto texts = stringutils::split(label, FCITX_WHITESPACE);
-    if (texts.empty()) {
+    auto texts = stringutils::tokenize(label);
+    if (texts.begin() == texts.end()) {
         return "";
     }
 
-    return texts[0];
+    return std::string(*texts.begin());
 }
 
 std::string Kimpanel::inputMethodStatus(InputContext *ic) {
@@ -563,6 +664,7 @@ void Kimpanel::msgV1Handler(dbus::Message &msg) {
         if (!available_) {
             setAvailable(true);
         }
+        lookupTableValid_ = false;
         registerAllProperties();
     }
 }
@@ -572,6 +674,7 @@ void Kimpanel::msgV2Handler(dbus::Message &msg) {
         if (!available_) {
             setAvailable(true);
         }
+        lookupTableValid_ = false;
         registerAllProperties();
     }
 }
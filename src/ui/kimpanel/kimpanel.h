@@ -57,6 +57,7 @@ public:
 
 private:
     void setAvailable(bool available);
+    void hideInputPanel();
 
     FCITX_ADDON_DEPENDENCY_LOADER(dbus, instance_->addonManager());
     FCITX_ADDON_DEPENDENCY_LOADER(classicui, instance_->addonManager());
@@ -71,11 +72,19 @@ private:
         eventHandlers_;
     TrackableObjectReference<InputContext> lastInputContext_;
     bool auxDownIsEmpty_ = true;
+    // The panel shows the lookup table of lastInputContext_.
+    bool lookupTableValid_ = false;
     std::unique_ptr<EventSourceTime> timeEvent_;
+    // Properties of the last focused input context are sent once after a
+    // burst of focus changes.
+    std::unique_ptr<EventSource> deferedFocusIn_;
+    TrackableObjectReference<InputContext> pendingFocusIn_;
     bool available_ = false;
     std::unique_ptr<dbus::Slot> relativeQuery_;
     bool hasRelative_ = false;
     bool hasRelativeV2_ = false;
+    // Panel accepts the whole input panel in one SetInputPanel call.
+    bool hasInputPanel_ = false;
     KimpanelConfig config_;
 };
 } // namespace fcitx
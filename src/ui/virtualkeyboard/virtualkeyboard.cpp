@@ -6,6 +6,7 @@
  */
 
 #include "virtualkeyboard.h"
+#include <algorithm>
 #include "fcitx-utils/dbus/message.h"
 #include "fcitx-utils/dbus/objectvtable.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
@@ -57,6 +58,11 @@ static const char VirtualKeyboardBackendInterfaceName[] =
 static const char VirtualKeyboardName[] = "org.fcitx.Fcitx5.VirtualKeyboard";
 static const char VirtualKeyboardInterfaceName[] =
     "org.fcitx.Fcitx5.VirtualKeyboard1";
+// Number of bulk candidates sent with UpdateBulkCandidateArea, the rest are
+// fetched by virtual keyboard with GetBulkCandidates.
+constexpr int bulkCandidateWindowSize = 50;
+// Maximum number of candidates returned by one GetBulkCandidates call.
+constexpr int maxBulkCandidateCount = 500;
 
 class VirtualKeyboardBackend
     : public dbus::ObjectVTable<VirtualKeyboardBackend> {
@@ -101,6 +107,25 @@ public:
 
     void nextPage();
 
+    std::vector<std::string> getBulkCandidates(int start, int count) {
+        if (start < 0 || count < 0) {
+            throw dbus::MethodCallError(
+                "org.freedesktop.DBus.Error.InvalidArgs",
+                "The argument start or count is invalid.");
+        }
+        auto *inputContext = parent_->instance()->mostRecentInputContext();
+        if (inputContext == nullptr) {
+            return {};
+        }
+        auto candidateList = inputContext->inputPanel().candidateList();
+        if (candidateList == nullptr || !candidateList->toBulk()) {
+            return {};
+        }
+        return parent_->makeBulkCandidateTextList(
+            inputContext, candidateList, start,
+            std::min(count, maxBulkCandidateCount));
+    }
+
 private:
     PageableCandidateList *getPageableCandidateList();
 
@@ -118,6 +143,9 @@ private:
 
     FCITX_OBJECT_VTABLE_METHOD(nextPage, "NextPage", "", "");
 
+    FCITX_OBJECT_VTABLE_METHOD(getBulkCandidates, "GetBulkCandidates", "ii",
+                               "as");
+
     VirtualKeyboard *parent_;
 };
 
@@ -214,6 +242,13 @@ VirtualKeyboard::VirtualKeyboard(Instance *instance)
         VirtualKeyboardName, [this](const std::string &, const std::string &,
                                     const std::string &newOwner) {
             FCITX_INFO() << "VirtualKeyboard new owner: " << newOwner;
+            candidateAreaValid_ = false;
+            hasCandidateCursor_ = false;
+            hasBulkCandidateArea_ = false;
+            capabilityQuery_.reset();
+            if (!newOwner.empty()) {
+                queryCapability();
+            }
             setAvailable(!newOwner.empty());
 
             setVisible(false);
@@ -234,6 +269,7 @@ void VirtualKeyboard::suspend() {
     eventHandlers_.clear();
     proxy_.reset();
     bus_->releaseName(VirtualKeyboardBackendName);
+    candidateAreaValid_ = false;
 }
 
 void VirtualKeyboard::resume() {
@@ -337,14 +373,35 @@ void VirtualKeyboard::toggleVirtualKeyboard() {
 
 void VirtualKeyboard::updateInputPanel(InputContext *inputContext) {
     auto &inputPanel = inputContext->inputPanel();
-    auto preedit = instance_->outputFilter(inputContext, inputPanel.preedit());
-    auto preeditString = preedit.toString();
-    updatePreeditArea(preeditString);
-
-    auto cursorIndex = calcPreeditCursor(preedit);
-    updatePreeditCaret(cursorIndex);
+    const auto dirty = inputPanel.dirtyComponents();
+    // Only the changed parts are resent if virtual keyboard already shows
+    // this input context.
+    const bool incremental = lastInputContext_.get() == inputContext && dirty;
+    lastInputContext_ = inputContext->watch();
+
+    if (!incremental || dirty.test(InputPanelComponent::Preedit)) {
+        auto preedit =
+            instance_->outputFilter(inputContext, inputPanel.preedit());
+        auto preeditString = preedit.toString();
+        updatePreeditArea(preeditString);
+
+        auto cursorIndex = calcPreeditCursor(preedit);
+        updatePreeditCaret(cursorIndex);
+    }
 
-    updateCandidate(inputContext);
+    const bool cursorDirty = dirty.test(InputPanelComponent::CandidateCursor);
+    if (!incremental || !candidateAreaValid_ ||
+        !!(dirty & InputPanelComponents{InputPanelComponent::CandidateList,
+                                        InputPanelComponent::CandidatePage}) ||
+        (cursorDirty && !hasCandidateCursor_)) {
+        updateCandidate(inputContext);
+        candidateAreaValid_ = true;
+    } else if (cursorDirty) {
+        auto candidateList = inputPanel.candidateList();
+        updateCandidateCursor(candidateList->toBulk()
+                                  ? globalCursorIndex(candidateList)
+                                  : candidateList->cursorIndex());
+    }
 }
 
 void VirtualKeyboard::initVirtualKeyboardService() {
@@ -428,7 +485,8 @@ std::vector<std::string> VirtualKeyboard::makeCandidateTextList(
 }
 
 std::vector<std::string> VirtualKeyboard::makeBulkCandidateTextList(
-    InputContext *inputContext, std::shared_ptr<CandidateList> candidateList) {
+    InputContext *inputContext, std::shared_ptr<CandidateList> candidateList,
+    int start, int count) {
     if (candidateList == nullptr || candidateList->empty()) {
         return {};
     }
@@ -437,7 +495,10 @@ std::vector<std::string> VirtualKeyboard::makeBulkCandidateTextList(
 
     const auto *bulkCandidateList = candidateList->toBulk();
     auto totalSize = bulkCandidateList->totalSize();
-    for (int index = 0; (totalSize < 0) || (index < totalSize); index++) {
+    for (int index = start;
+         ((totalSize < 0) || (index < totalSize)) &&
+         ((count < 0) || (index - start < count));
+         index++) {
         Text candidateText;
         try {
             const auto &candidate = bulkCandidateList->candidateFromAll(index);
@@ -487,7 +548,16 @@ void VirtualKeyboard::updateCandidate(InputContext *inputContext) {
         return;
     }
 
-    if (inputPanel.candidateList()->toBulk()) {
+    if (const auto *bulk = inputPanel.candidateList()->toBulk()) {
+        if (hasBulkCandidateArea_) {
+            auto candidateTextList = makeBulkCandidateTextList(
+                inputContext, inputPanel.candidateList(), 0,
+                bulkCandidateWindowSize);
+            updateBulkCandidateArea(
+                candidateTextList, bulk->totalSize(),
+                globalCursorIndex(inputPanel.candidateList()));
+            return;
+        }
         auto candidateTextList =
             makeBulkCandidateTextList(inputContext, inputPanel.candidateList());
         updateCandidateArea(candidateTextList, false, false, -1,
@@ -505,6 +575,40 @@ void VirtualKeyboard::updateCandidate(InputContext *inputContext) {
     }
 }
 
+void VirtualKeyboard::updateBulkCandidateArea(
+    const std::vector<std::string> &candidateTextList, int totalSize,
+    int globalCursorIndex) {
+    auto msg = bus_->createMethodCall(
+        VirtualKeyboardName, "/org/fcitx/virtualkeyboard/impanel",
+        VirtualKeyboardInterfaceName, "UpdateBulkCandidateArea");
+    msg << candidateTextList << totalSize << globalCursorIndex;
+    msg.send();
+}
+
+void VirtualKeyboard::updateCandidateCursor(int globalCursorIndex) {
+    auto msg = bus_->createMethodCall(
+        VirtualKeyboardName, "/org/fcitx/virtualkeyboard/impanel",
+        VirtualKeyboardInterfaceName, "UpdateCandidateCursor");
+    msg << globalCursorIndex;
+    msg.send();
+}
+
+void VirtualKeyboard::queryCapability() {
+    auto msg = bus_->createMethodCall(
+        VirtualKeyboardName, "/org/fcitx/virtualkeyboard/impanel",
+        "org.freedesktop.DBus.Introspectable", "Introspect");
+    capabilityQuery_ = msg.callAsync(0, [this](dbus::Message &reply) {
+        std::string s;
+        if (reply >> s) {
+            hasCandidateCursor_ =
+                s.find("UpdateCandidateCursor") != std::string::npos;
+            hasBulkCandidateArea_ =
+                s.find("UpdateBulkCandidateArea") != std::string::npos;
+        }
+        return true;
+    });
+}
+
 void VirtualKeyboard::notifyIMActivated(const std::string &uniqueName) {
     auto msg = bus_->createMethodCall(
         VirtualKeyboardName, "/org/fcitx/virtualkeyboard/impanel",
@@ -8,6 +8,7 @@
 #define _FCITX_UI_VIRTUALKEYBOARD_VIRTUALKEYBOARD_H_
 
 #include "fcitx-utils/dbus/servicewatcher.h"
+#include "fcitx-utils/trackableobject.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
@@ -44,6 +45,13 @@ public:
 
     void updateInputPanel(InputContext *inputContext);
 
+    // Text of count candidates from start of a bulk candidate list, count < 0
+    // means all the rest.
+    std::vector<std::string>
+    makeBulkCandidateTextList(InputContext *inputContext,
+                              std::shared_ptr<CandidateList> candidateList,
+                              int start = 0, int count = -1);
+
 private:
     void initVirtualKeyboardService();
 
@@ -58,14 +66,16 @@ private:
     std::vector<std::string>
     makeCandidateTextList(InputContext *inputContext,
                           std::shared_ptr<CandidateList> candidateList);
-    std::vector<std::string>
-    makeBulkCandidateTextList(InputContext *inputContext,
-                              std::shared_ptr<CandidateList> candidateList);
     int globalCursorIndex(std::shared_ptr<CandidateList> candidateList) const;
     void updateCandidateArea(const std::vector<std::string> &candidateTextList,
                              bool hasPrev, bool hasNext, int pageIndex,
                              int globalCursorIndex);
     void updateCandidate(InputContext *inputContext);
+    void
+    updateBulkCandidateArea(const std::vector<std::string> &candidateTextList,
+                            int totalSize, int globalCursorIndex);
+    void updateCandidateCursor(int globalCursorIndex);
+    void queryCapability();
 
     void notifyIMActivated(const std::string &uniqueName);
     void notifyIMDeactivated(const std::string &uniqueName);
@@ -84,6 +94,15 @@ private:
         eventHandlers_;
     bool available_ = false;
     bool visible_ = false;
+    std::unique_ptr<dbus::Slot> capabilityQuery_;
+    // Virtual keyboard accepts UpdateCandidateCursor.
+    bool hasCandidateCursor_ = false;
+    // Virtual keyboard accepts UpdateBulkCandidateArea, and fetches the rest
+    // of bulk candidates with GetBulkCandidates.
+    bool hasBulkCandidateArea_ = false;
+    TrackableObjectReference<InputContext> lastInputContext_;
+    // Virtual keyboard shows the candidates of lastInputContext_.
+    bool candidateAreaValid_ = false;
 };
 } // namespace fcitx
 
@@ -0,0 +1,358 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2024 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+// Replay a key trace on a few input contexts of testfrontend, with the real
+// keyboard engine, spell and quickphrase loaded, and report the throughput,
+// latency and allocations per key.
+//
+// The trace is a text file with one key per line in the format of
+// Key::toString, empty lines and lines starting with # are ignored. A press
+// and a release is sent for each key.
+//
+// A binary trace recorded by Instance::startKeyTrace can be replayed with
+// --key-trace instead, with one input context per recorded input context,
+// either as fast as possible, or with the recorded delay with --realtime.
+
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/key.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/testing.h"
+#include "fcitx/addonmanager.h"
+#include "fcitx/inputmethodmanager.h"
+#include "fcitx/instance.h"
+#include "fcitx/keytrace_p.h"
+#include "keyboard.h"
+#include "testdir.h"
+#include "testfrontend_public.h"
+
+namespace {
+
+std::atomic<size_t> allocationCount{0};
+
+} // namespace
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+using namespace fcitx;
+
+namespace {
+
+struct BenchOptions {
+    std::string trace;
+    std::string keyTrace;
+    bool realtime = false;
+    std::string inputMethod = "keyboard-us";
+    int inputContexts = 4;
+    int repeat = 10;
+};
+
+const char defaultTrace[] = "Control+Alt+h\n"
+                            "h\ne\nl\nl\no\nspace\n"
+                            "w\no\nr\nl\nd\nBackSpace\nd\nspace\n"
+                            "a\np\np\nl\ne\nminus\ng\nr\ne\ne\nn\nReturn\n"
+                            "Control+Alt+h\n";
+
+std::vector<Key> parseTrace(std::istream &in) {
+    std::vector<Key> keys;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto trimmed = stringutils::trimView(line);
+        if (trimmed.empty() || trimmed[0] == '#') {
+            continue;
+        }
+        Key key{std::string(trimmed)};
+        if (!key.isValid()) {
+            FCITX_WARN() << "Invalid key in trace: " << trimmed;
+            continue;
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+void usage(std::ostream &out) {
+    out << "Usage: fcitx5-bench [OPTION]\n"
+           "\t-t, --trace FILE\tkey trace to replay\n"
+           "\t-k, --key-trace FILE\tbinary key trace to replay\n"
+           "\t-R, --realtime\t\treplay binary trace with recorded delay\n"
+           "\t-i, --input-method NAME\tinput method, default keyboard-us\n"
+           "\t-n, --input-contexts N\tnumber of input contexts, default 4\n"
+           "\t-r, --repeat N\t\tnumber of times to replay, default 10\n"
+           "\t-h, --help\t\tshow this help\n";
+}
+
+void setupInputMethod(Instance *instance, const BenchOptions &options) {
+    for (const auto *addon : {"spell", "quickphrase"}) {
+        if (!instance->addonManager().addon(addon, true)) {
+            FCITX_WARN() << "Failed to load " << addon;
+        }
+    }
+    InputMethodGroup group("Bench");
+    // Make sure custom xkb does not kick in.
+    group.setDefaultLayout("us");
+    group.inputMethodList().push_back(
+        InputMethodGroupItem(options.inputMethod));
+    instance->inputMethodManager().addEmptyGroup("Bench");
+    instance->inputMethodManager().setGroup(group);
+    instance->inputMethodManager().setCurrentGroup("Bench");
+}
+
+void report(std::vector<uint64_t> latencies, size_t inputContexts,
+            int64_t elapsed, size_t allocations) {
+    if (latencies.empty()) {
+        FCITX_WARN() << "No key is replayed.";
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto count = latencies.size();
+    FCITX_INFO() << "Replayed " << count << " keys on " << inputContexts
+                 << " input contexts in " << elapsed / 1000.0 << "ms";
+    FCITX_INFO() << "Keys per second: "
+                 << (elapsed ? count * 1000000.0 / elapsed : 0.0);
+    FCITX_INFO() << "Latency p50: " << latencies[count / 2] / 1000.0
+                 << "us p99: " << latencies[count * 99 / 100] / 1000.0
+                 << "us max: " << latencies.back() / 1000.0 << "us";
+    FCITX_INFO() << "Allocations per key: "
+                 << static_cast<double>(allocations) / count;
+}
+
+void replay(Instance *instance, const BenchOptions &options,
+            const std::vector<Key> &keys) {
+    setupInputMethod(instance, options);
+    auto *testfrontend = instance->addonManager().addon("testfrontend");
+    std::vector<ICUUID> uuids;
+    for (int i = 0; i < options.inputContexts; i++) {
+        uuids.push_back(
+            testfrontend->call<ITestFrontend::createInputContext>("bench"));
+    }
+
+    // testfrontend logs every key.
+    Log::setLogRule("default=3");
+    std::vector<uint64_t> latencies;
+    latencies.reserve(keys.size() * uuids.size() * options.repeat);
+    const auto allocationStart = allocationCount.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.repeat; i++) {
+        for (const auto &key : keys) {
+            for (const auto &uuid : uuids) {
+                const auto keyStart = std::chrono::steady_clock::now();
+                testfrontend->call<ITestFrontend::sendKeyEvent>(uuid, key,
+                                                                false);
+                testfrontend->call<ITestFrontend::sendKeyEvent>(uuid, key,
+                                                                true);
+                latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - keyStart)
+                        .count());
+            }
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    const auto allocations = allocationCount.load() - allocationStart;
+    Log::setLogRule("default=4");
+
+    for (const auto &uuid : uuids) {
+        testfrontend->call<ITestFrontend::destroyInputContext>(uuid);
+    }
+
+    report(std::move(latencies), uuids.size(), elapsed, allocations);
+}
+
+void replayKeyTrace(Instance *instance, const BenchOptions &options,
+                    const std::vector<KeyTraceEvent> &events) {
+    setupInputMethod(instance, options);
+    auto *testfrontend = instance->addonManager().addon("testfrontend");
+    // Create the input contexts up front, with the program it is recorded.
+    std::vector<ICUUID> uuids;
+    for (const auto &event : events) {
+        while (uuids.size() <= event.inputContext) {
+            uuids.push_back(
+                testfrontend->call<ITestFrontend::createInputContext>(
+                    std::string(event.program)));
+        }
+    }
+
+    Log::setLogRule("default=3");
+    std::vector<uint64_t> latencies;
+    latencies.reserve(events.size() * options.repeat);
+    const auto allocationStart = allocationCount.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.repeat; i++) {
+        for (const auto &event : events) {
+            if (options.realtime && event.delay) {
+                std::this_thread::sleep_for(
+                    std::chrono::microseconds(event.delay));
+            }
+            const auto keyStart = std::chrono::steady_clock::now();
+            testfrontend->call<ITestFrontend::sendKeyEvent>(
+                uuids[event.inputContext], event.key, event.isRelease);
+            latencies.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - keyStart)
+                    .count());
+        }
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    const auto allocations = allocationCount.load() - allocationStart;
+    Log::setLogRule("default=4");
+
+    for (const auto &uuid : uuids) {
+        testfrontend->call<ITestFrontend::destroyInputContext>(uuid);
+    }
+
+    report(std::move(latencies), uuids.size(), elapsed, allocations);
+}
+
+bool readKeyTrace(const std::string &path, std::string &data,
+                  std::vector<KeyTraceEvent> &events) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        FCITX_ERROR() << "Failed to open " << path;
+        return false;
+    }
+    std::ostringstream content;
+    content << in.rdbuf();
+    data = content.str();
+    KeyTraceReader reader(data);
+    KeyTraceEvent event;
+    while (reader.next(event)) {
+        events.push_back(event);
+    }
+    if (!reader.isValid()) {
+        FCITX_ERROR() << "Invalid key trace: " << path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    struct option longOptions[] = {
+        {"trace", required_argument, nullptr, 't'},
+        {"key-trace", required_argument, nullptr, 'k'},
+        {"realtime", no_argument, nullptr, 'R'},
+        {"input-method", required_argument, nullptr, 'i'},
+        {"input-contexts", required_argument, nullptr, 'n'},
+        {"repeat", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "t:k:Ri:n:r:h", longOptions,
+                            nullptr)) != EOF) {
+        switch (c) {
+        case 't':
+            options.trace = optarg;
+            break;
+        case 'k':
+            options.keyTrace = optarg;
+            break;
+        case 'R':
+            options.realtime = true;
+            break;
+        case 'i':
+            options.inputMethod = optarg;
+            break;
+        case 'n':
+            options.inputContexts = std::max(1, std::atoi(optarg));
+            break;
+        case 'r':
+            options.repeat = std::max(1, std::atoi(optarg));
+            break;
+        case 'h':
+            usage(std::cout);
+            return 0;
+        default:
+            usage(std::cerr);
+            return 1;
+        }
+    }
+
+    std::vector<Key> keys;
+    // Events point into the content of key trace.
+    std::string keyTraceData;
+    std::vector<KeyTraceEvent> keyTraceEvents;
+    if (!options.keyTrace.empty()) {
+        if (!readKeyTrace(options.keyTrace, keyTraceData, keyTraceEvents)) {
+            return 1;
+        }
+    } else if (options.trace.empty()) {
+        std::istringstream in(defaultTrace);
+        keys = parseTrace(in);
+    } else {
+        std::ifstream in(options.trace);
+        if (!in) {
+            FCITX_ERROR() << "Failed to open " << options.trace;
+            return 1;
+        }
+        keys = parseTrace(in);
+    }
+
+    setupTestingEnvironment(
+        FCITX5_BINARY_DIR,
+        {"src/modules/spell", "src/modules/quickphrase", "testing/testfrontend",
+         "testing/testui", "testing/testim"},
+        {"test", "src/modules", FCITX5_SOURCE_DIR "/src/modules"});
+
+    static KeyboardEngineFactory keyboardFactory;
+    StaticAddonRegistry staticAddon = {
+        std::make_pair<std::string, AddonFactory *>("keyboard",
+                                                    &keyboardFactory)};
+
+    char arg0[] = "fcitx5-bench";
+    char arg1[] = "--disable=all";
+    char arg2[] = "--enable=keyboard,testfrontend,testim,spell,quickphrase,"
+                  "testui";
+    char *instanceArgv[] = {arg0, arg1, arg2};
+    Instance instance(FCITX_ARRAY_SIZE(instanceArgv), instanceArgv);
+    instance.addonManager().registerDefaultLoader(&staticAddon);
+    EventDispatcher dispatcher;
+    dispatcher.attach(&instance.eventLoop());
+    dispatcher.schedule([&]() {
+        if (options.keyTrace.empty()) {
+            replay(&instance, options, keys);
+        } else {
+            replayKeyTrace(&instance, options, keyTraceEvents);
+        }
+        dispatcher.schedule([&dispatcher, &instance]() {
+            dispatcher.detach();
+            instance.exit();
+        });
+    });
+    instance.exec();
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+// Measure the key to preedit and key to commit latency seen by a real XIM
+// client, run it with an X server, e.g.
+//   xvfb_wrapper.sh Xvfb ./fcitx5-xim-bench --keys 2000
+//
+// The client sends one key at a time with xcb-imdkit. testim shows the key as
+// preedit on press, and commits it on release. Press is timed until the
+// preedit arrives, and release until the commit arrives.
+
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xcb-imdkit/encoding.h>
+#include <xcb-imdkit/imclient.h>
+#include <xcb/xcb_aux.h>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/key.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/testing.h"
+#include "fcitx/addonmanager.h"
+#include "fcitx/inputcontext.h"
+#include "fcitx/inputpanel.h"
+#include "fcitx/instance.h"
+#include "fcitx/text.h"
+#include "testdir.h"
+#include "testim_public.h"
+
+using namespace fcitx;
+
+namespace {
+
+constexpr char xmodifiers[] = "@im=testxim";
+// Keycode of a to l on the home row with the default keymap of Xvfb.
+constexpr uint8_t firstKeycode = 38;
+constexpr uint8_t lastKeycode = 46;
+
+using Clock = std::chrono::steady_clock;
+
+void printLatency(const char *name, std::vector<uint64_t> latencies) {
+    if (latencies.empty()) {
+        std::cout << name << ": no sample" << std::endl;
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto count = latencies.size();
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    std::cout << name << ": count " << count << " min "
+              << us(latencies.front()) << "us p50 "
+              << us(latencies[count / 2]) << "us p90 "
+              << us(latencies[count * 90 / 100]) << "us p99 "
+              << us(latencies[count * 99 / 100]) << "us max "
+              << us(latencies.back()) << "us" << std::endl;
+}
+
+class XIMBench {
+public:
+    XIMBench(EventDispatcher *dispatcher, Instance *instance, int keys)
+        : dispatcher_(dispatcher), instance_(instance), keys_(keys) {}
+
+    static void run(XIMBench *self) { self->runClient(); }
+
+    static void open_callback(xcb_xim_t *, void *user_data) {
+        static_cast<XIMBench *>(user_data)->openCallback();
+    }
+
+    static void create_ic_callback(xcb_xim_t *, xcb_xic_t ic, void *user_data) {
+        static_cast<XIMBench *>(user_data)->createICCallback(ic);
+    }
+
+    static void commit_string_callback(xcb_xim_t *, xcb_xic_t, uint32_t,
+                                       char *, uint32_t, uint32_t *, size_t,
+                                       void *user_data) {
+        static_cast<XIMBench *>(user_data)->commitString();
+    }
+
+    static void preedit_draw_callback(xcb_xim_t *, xcb_xic_t,
+                                      xcb_im_preedit_draw_fr_t *frame,
+                                      void *user_data) {
+        // Clearing the preedit before the commit also draws.
+        if (frame->length_of_preedit_string) {
+            static_cast<XIMBench *>(user_data)->preeditDraw();
+        }
+    }
+
+    static void forward_event_callback(xcb_xim_t *, xcb_xic_t,
+                                       xcb_key_press_event_t *,
+                                       void *user_data) {
+        // A key is not handled, treat it as done.
+        static_cast<XIMBench *>(user_data)->commitString();
+    }
+
+    static void logger(const char *fmt, ...) {
+        va_list argp;
+        va_start(argp, fmt);
+        vfprintf(stderr, fmt, argp);
+        va_end(argp);
+    }
+
+    void openCallback() {
+        w_ = xcb_generate_id(connection_.get());
+        xcb_create_window(connection_.get(), XCB_COPY_FROM_PARENT, w_,
+                          screen_->root, 0, 0, 1, 1, 1,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, screen_->root_visual,
+                          0, nullptr);
+        uint32_t inputStyle = XCB_IM_PreeditCallbacks | XCB_IM_StatusNothing;
+        xcb_xim_create_ic(im_.get(), create_ic_callback, this,
+                          XCB_XIM_XNInputStyle, &inputStyle,
+                          XCB_XIM_XNClientWindow, &w_, XCB_XIM_XNFocusWindow,
+                          &w_, nullptr);
+    }
+
+    void createICCallback(xcb_xic_t ic) {
+        ic_ = ic;
+        xcb_xim_set_ic_focus(im_.get(), ic_);
+        sendKey(false);
+    }
+
+    void sendKey(bool release) {
+        xcb_key_press_event_t event{};
+        event.response_type = release ? XCB_KEY_RELEASE : XCB_KEY_PRESS;
+        event.detail =
+            firstKeycode + (sent_ % (lastKeycode - firstKeycode + 1));
+        event.time = XCB_CURRENT_TIME;
+        event.root = screen_->root;
+        event.event = w_;
+        event.same_screen = 1;
+        release_ = release;
+        keyStart_ = Clock::now();
+        xcb_xim_forward_event(im_.get(), ic_, &event);
+        xcb_flush(connection_.get());
+    }
+
+    uint64_t elapsed() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now() - keyStart_)
+            .count();
+    }
+
+    void preeditDraw() {
+        if (!release_) {
+            preeditLatencies_.push_back(elapsed());
+            sendKey(true);
+        }
+    }
+
+    void commitString() {
+        if (!release_) {
+            // Press is not shown as preedit, still send the release.
+            sendKey(true);
+            return;
+        }
+        commitLatencies_.push_back(elapsed());
+        if (++sent_ >= keys_) {
+            end_ = true;
+            return;
+        }
+        sendKey(false);
+    }
+
+    void setupInputMethod() {
+        auto *testim = instance_->addonManager().addon("testim", true);
+        FCITX_ASSERT(testim);
+        testim->call<ITestIM::setHandler>(
+            [](const InputMethodEntry &, KeyEvent &keyEvent) {
+                auto text = Key::keySymToUTF8(keyEvent.key().sym());
+                if (text.empty()) {
+                    return;
+                }
+                auto *ic = keyEvent.inputContext();
+                if (keyEvent.isRelease()) {
+                    ic->inputPanel().setClientPreedit(Text());
+                    ic->updatePreedit();
+                    ic->commitString(text);
+                } else {
+                    ic->inputPanel().setClientPreedit(
+                        Text(text, TextFormatFlag::Underline));
+                    ic->updatePreedit();
+                }
+                keyEvent.filterAndAccept();
+            });
+        FCITX_ASSERT(instance_->addonManager().addon("xim", true));
+    }
+
+    void runClient() {
+        dispatcher_->schedule([this]() {
+            setupInputMethod();
+            std::lock_guard<std::mutex> lock(mutex_);
+            started_ = true;
+            condition_.notify_all();
+        });
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait_for(lock, std::chrono::seconds(10),
+                                [this] { return started_; });
+        }
+
+        int screenDefaultNbr;
+        connection_.reset(xcb_connect(nullptr, &screenDefaultNbr));
+        screen_ = xcb_aux_get_screen(connection_.get(), screenDefaultNbr);
+        if (screen_) {
+            im_.reset(xcb_xim_create(connection_.get(), screenDefaultNbr,
+                                     xmodifiers));
+            xcb_xim_im_callback callback{};
+            callback.commit_string = commit_string_callback;
+            callback.preedit_draw = preedit_draw_callback;
+            callback.forward_event = forward_event_callback;
+            xcb_xim_set_im_callback(im_.get(), &callback, this);
+            xcb_xim_set_log_handler(im_.get(), logger);
+            FCITX_ASSERT(xcb_xim_open(im_.get(), open_callback, true, this));
+
+            xcb_generic_event_t *event;
+            while (!end_ && (event = xcb_wait_for_event(connection_.get()))) {
+                xcb_xim_filter_event(im_.get(), event);
+                free(event);
+            }
+            xcb_xim_close(im_.get());
+        } else {
+            std::cerr << "Failed to connect to X server." << std::endl;
+        }
+
+        printLatency("XIM key to preedit", preeditLatencies_);
+        printLatency("XIM key to commit", commitLatencies_);
+        dispatcher_->schedule([this]() { instance_->exit(); });
+    }
+
+private:
+    EventDispatcher *dispatcher_;
+    Instance *instance_;
+    const int keys_;
+    UniqueCPtr<xcb_connection_t, xcb_disconnect> connection_;
+    UniqueCPtr<xcb_xim_t, xcb_xim_destroy> im_;
+    xcb_screen_t *screen_ = nullptr;
+    xcb_window_t w_ = XCB_NONE;
+    xcb_xic_t ic_ = XCB_NONE;
+    std::condition_variable condition_;
+    std::mutex mutex_;
+    bool started_ = false;
+    bool end_ = false;
+    bool release_ = false;
+    int sent_ = 0;
+    Clock::time_point keyStart_;
+    std::vector<uint64_t> preeditLatencies_;
+    std::vector<uint64_t> commitLatencies_;
+};
+
+void usage(std::ostream &out) {
+    out << "Usage: fcitx5-xim-bench [OPTION]\n"
+           "\t-k, --keys N\tnumber of keys to send, default 1000\n"
+           "\t-h, --help\tshow this help\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    int keys = 1000;
+    struct option longOptions[] = {{"keys", required_argument, nullptr, 'k'},
+                                   {"help", no_argument, nullptr, 'h'},
+                                   {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "k:h", longOptions, nullptr)) != EOF) {
+        switch (c) {
+        case 'k':
+            keys = std::max(1, std::atoi(optarg));
+            break;
+        case 'h':
+            usage(std::cout);
+            return 0;
+        default:
+            usage(std::cerr);
+            return 1;
+        }
+    }
+
+    setenv("XMODIFIERS", xmodifiers, 1);
+    setupTestingEnvironment(
+        FCITX5_BINARY_DIR,
+        {"src/frontend/xim", "src/modules/xcb", "testing/testui",
+         "testing/testim"},
+        {"test", "src/modules", FCITX5_SOURCE_DIR "/test/addon/fcitx5"});
+
+    char arg0[] = "fcitx5-xim-bench";
+    char arg1[] = "--disable=all";
+    char arg2[] = "--enable=testim,xim,xcb,testui";
+    char *instanceArgv[] = {arg0, arg1, arg2};
+    Instance instance(FCITX_ARRAY_SIZE(instanceArgv), instanceArgv);
+    instance.addonManager().registerDefaultLoader(nullptr);
+    // testim logs every key.
+    Log::setLogRule("default=3");
+    EventDispatcher dispatcher;
+    dispatcher.attach(&instance.eventLoop());
+    XIMBench bench(&dispatcher, &instance, keys);
+    std::thread thread(XIMBench::run, &bench);
+    instance.exec();
+    thread.join();
+    return 0;
+}
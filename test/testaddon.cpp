@@ -19,6 +19,8 @@ int main() {
     setenv("SKIP_FCITX_PATH", "1", 1);
     setenv("XDG_DATA_DIRS", FCITX5_SOURCE_DIR "/test/addon2", 1);
     setenv("FCITX_ADDON_DIRS", FCITX5_BINARY_DIR "/test/addon", 1);
+    // Keep the addon metadata snapshot out of the user cache.
+    setenv("XDG_CACHE_HOME", FCITX5_BINARY_DIR "/test/addon/cache", 1);
     fcitx::AddonManager manager;
     manager.registerDefaultLoader(nullptr);
     manager.load();
@@ -5,6 +5,8 @@
  *
  */
 
+#include <cstdlib>
+#include <new>
 #include <stdexcept>
 #include "fcitx-utils/log.h"
 #include "fcitx/candidateaction.h"
@@ -12,6 +14,19 @@
 
 using namespace fcitx;
 int selected = 0;
+size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
 
 class TestCandidateWord : public CandidateWord {
 public:
@@ -328,6 +343,142 @@ void test_cursor() {
     FCITX_ASSERT(candidatelist.toBulkCursor()->globalCursorIndex(), 5);
 }
 
+void test_lazy() {
+    int generated = 0;
+    LazyCandidateList candidatelist(
+        [&generated]() -> std::unique_ptr<CandidateWord> {
+            if (generated >= 100000) {
+                return nullptr;
+            }
+            auto number = generated++;
+            if (number == 4) {
+                return std::make_unique<PlaceHolderCandidateWord>(number);
+            }
+            return std::make_unique<TestCandidateWord>(number);
+        });
+    FCITX_ASSERT(generated == 0);
+    candidatelist.setPageSize(3);
+    candidatelist.setSelectionKey(
+        Key::keyListFromString("1 2 3 4 5 6 7 8 9 0"));
+
+    // First page and one lookahead.
+    FCITX_ASSERT(candidatelist.size() == 3);
+    FCITX_ASSERT(generated == 4);
+    FCITX_ASSERT(candidatelist.label(0).toString() == "1. ");
+    FCITX_ASSERT(candidatelist.candidate(2).text().toString() == "2");
+    FCITX_ASSERT(!candidatelist.hasPrev());
+    FCITX_ASSERT(candidatelist.hasNext());
+    FCITX_ASSERT(candidatelist.totalPages() == -1);
+    FCITX_ASSERT(candidatelist.totalSize() == -1);
+
+    candidatelist.next();
+    FCITX_ASSERT(candidatelist.usedNextBefore());
+    FCITX_ASSERT(candidatelist.currentPage() == 1);
+    FCITX_ASSERT(candidatelist.candidate(0).text().toString() == "3");
+    FCITX_ASSERT(generated == 7);
+    candidatelist.prev();
+    FCITX_ASSERT(candidatelist.candidate(0).text().toString() == "0");
+    FCITX_ASSERT(generated == 7);
+
+    // Cursor skips place holder and pages with it.
+    candidatelist.setGlobalCursorIndex(3);
+    FCITX_ASSERT(candidatelist.cursorIndex() == -1);
+    candidatelist.setPage(1);
+    FCITX_ASSERT(candidatelist.cursorIndex() == 0);
+    candidatelist.nextCandidate();
+    FCITX_ASSERT(candidatelist.globalCursorIndex() == 5);
+    candidatelist.nextCandidate();
+    FCITX_ASSERT(candidatelist.globalCursorIndex() == 6);
+    FCITX_ASSERT(candidatelist.currentPage() == 2);
+    candidatelist.prevCandidate();
+    candidatelist.prevCandidate();
+    FCITX_ASSERT(candidatelist.globalCursorIndex() == 3);
+    FCITX_ASSERT(candidatelist.currentPage() == 1);
+
+    // Bulk access only creates what is asked.
+    FCITX_ASSERT(candidatelist.candidateFromAll(20).text().toString() ==
+                 "20");
+    FCITX_ASSERT(candidatelist.loadedSize() == 21);
+    FCITX_ASSERT(generated == 21);
+
+    // Out of range.
+    bool thrown = false;
+    try {
+        candidatelist.candidateFromAll(100000);
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    FCITX_ASSERT(thrown);
+    FCITX_ASSERT(candidatelist.totalSize() == 100000);
+    FCITX_ASSERT(candidatelist.totalPages() == 33334);
+    candidatelist.setPage(33333);
+    FCITX_ASSERT(candidatelist.size() == 1);
+    FCITX_ASSERT(!candidatelist.hasNext());
+    candidatelist.nextCandidate();
+    FCITX_ASSERT(candidatelist.globalCursorIndex() == 99999);
+    candidatelist.nextCandidate();
+    FCITX_ASSERT(candidatelist.globalCursorIndex() == 99999);
+
+    LazyCandidateList empty([]() { return nullptr; });
+    FCITX_ASSERT(empty.empty());
+    FCITX_ASSERT(empty.totalSize() == 0);
+    FCITX_ASSERT(!empty.hasNext());
+
+    int count = 0;
+    LazyCandidateList paging([&count]() -> std::unique_ptr<CandidateWord> {
+        if (count >= 10) {
+            return nullptr;
+        }
+        return std::make_unique<TestCandidateWord>(count++);
+    });
+    paging.setPageSize(3);
+    paging.setCursorPositionAfterPaging(
+        CursorPositionAfterPaging::ResetToFirst);
+    paging.setGlobalCursorIndex(1);
+    paging.next();
+    FCITX_ASSERT(paging.globalCursorIndex() == 3);
+    paging.setCursorPositionAfterPaging(CursorPositionAfterPaging::SameAsLast);
+    paging.setCursorIndex(2);
+    // Last page only has one candidate.
+    paging.setPage(3);
+    FCITX_ASSERT(paging.globalCursorIndex() == 9);
+    paging.prev();
+    FCITX_ASSERT(paging.globalCursorIndex() == 6);
+}
+
+void test_allocation() {
+    constexpr int rounds = 3;
+    constexpr int candidates = 100;
+    size_t total = 0;
+    for (int i = 0; i < rounds; i++) {
+        // Candidates are recreated for every key stroke.
+        auto before = allocations;
+        CommonCandidateList candidatelist;
+        for (int j = 0; j < candidates; j++) {
+            candidatelist.append<TestCandidateWord>(j);
+        }
+        total += allocations - before;
+    }
+    const auto perCandidate =
+        static_cast<double>(total) / (rounds * candidates);
+    // Candidate, its private data, and one fragment text. Empty comment and
+    // custom label should not allocate.
+    FCITX_ASSERT(perCandidate < 4.1) << perCandidate;
+
+    auto before = allocations;
+    Text empty;
+    Text copy = empty;
+    copy.clear();
+    copy.setCursor();
+    FCITX_ASSERT(allocations == before);
+    FCITX_ASSERT(copy.empty());
+    FCITX_ASSERT(copy.toString().empty());
+    FCITX_ASSERT(copy.cursor() == -1);
+    copy.setCursor(0);
+    FCITX_ASSERT(copy.cursor() == 0);
+    FCITX_ASSERT(copy.empty());
+}
+
 void test_candidateaction() {
     CandidateAction action;
     action.setText("Test");
@@ -365,6 +516,8 @@ int main() {
     test_label();
     test_comment();
     test_cursor();
+    test_lazy();
+    test_allocation();
     test_candidateaction();
     return 0;
 }
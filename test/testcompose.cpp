@@ -83,11 +83,13 @@ int main() {
     char *argv[] = {arg0, arg1, arg2};
     try {
         MyInstance instance(FCITX_ARRAY_SIZE(argv), argv);
-        instance.privateData()->xkbComposeTable_.reset(
+        UniqueCPtr<xkb_compose_table, xkb_compose_table_unref> table(
             xkb_compose_table_new_from_buffer(
                 instance.privateData()->xkbContext_.get(), testCompose,
                 FCITX_ARRAY_SIZE(testCompose), "", XKB_COMPOSE_FORMAT_TEXT_V1,
                 XKB_COMPOSE_COMPILE_NO_FLAGS));
+        instance.privateData()->composeTable_ =
+            ComposeTable::create(table.get());
         instance.addonManager().registerDefaultLoader(&staticAddon);
         EventDispatcher dispatcher;
         dispatcher.attach(&instance.eventLoop());
@@ -6,11 +6,19 @@
  */
 
 #include "testconfig.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <functional>
 #include <vector>
 #include <fcitx-config/configuration.h>
 #include <fcitx-config/enum.h>
+#include <fcitx-config/flatrawconfig.h>
 #include <fcitx-config/iniparser.h>
+#include "fcitx-utils/fs.h"
 #include "fcitx-utils/log.h"
+#include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/unixfd.h"
+#include "testdir.h"
 
 using namespace fcitx;
 
@@ -203,6 +211,190 @@ void testCopyConfiguration() {
     FCITX_ASSERT(*copy.intValue == 7);
 }
 
+void testIniParser() {
+    constexpr std::string_view data = "# comment\n"
+                                      "Global=1\n"
+                                      "\r\n"
+                                      "[Group/Sub]\n"
+                                      "  A=\"quoted value\"  \r\n"
+                                      "B=a\\nb\n"
+                                      "Invalid line\n"
+                                      "[Group]\n"
+                                      "A=2\n"
+                                      "[]\n"
+                                      "Top=3";
+    RawConfig config;
+    readFromIni(config, data);
+    FCITX_ASSERT(*config.valueByPath("Global") == "1");
+    FCITX_ASSERT(config.get("Global")->lineNumber() == 2);
+    FCITX_ASSERT(*config.valueByPath("Group/Sub/A") == "quoted value");
+    FCITX_ASSERT(*config.valueByPath("Group/Sub/B") == "a\nb");
+    FCITX_ASSERT(config.get("Group")->lineNumber() == 4);
+    FCITX_ASSERT(config.get("Group/Sub")->lineNumber() == 4);
+    FCITX_ASSERT(*config.valueByPath("Group/A") == "2");
+    FCITX_ASSERT(*config.valueByPath("Top") == "3");
+    FCITX_ASSERT(config.get("Top")->lineNumber() == 11);
+    FCITX_ASSERT(!config.get("Invalid line"));
+
+    // Reading from file gives the same result.
+    RawConfig fileConfig;
+    UniqueFilePtr file(fmemopen(const_cast<char *>(data.data()), data.size(),
+                                "r"));
+    readFromIni(fileConfig, file.get());
+    FCITX_ASSERT(fileConfig == config);
+}
+
+void testIniParserTree() {
+    std::vector<std::string> contents;
+    std::function<void(const std::string &)> scan =
+        [&scan, &contents](const std::string &path) {
+            UniqueCPtr<DIR, closedir> dir(opendir(path.c_str()));
+            if (!dir) {
+                return;
+            }
+            while (auto *entry = readdir(dir.get())) {
+                std::string name = entry->d_name;
+                if (name.empty() || name[0] == '.') {
+                    continue;
+                }
+                auto fullPath = stringutils::joinPath(path, name);
+                if (fs::isdir(fullPath)) {
+                    scan(fullPath);
+                } else if (name.find(".conf") != std::string::npos) {
+                    // *.conf, *.conf.in and *.conf.in.in, including themes.
+                    UnixFD fd = UnixFD::own(open(fullPath.c_str(), O_RDONLY));
+                    std::string content;
+                    char buffer[4096];
+                    ssize_t size;
+                    while ((size = fs::safeRead(fd.fd(), buffer,
+                                                sizeof(buffer))) > 0) {
+                        content.append(buffer, size);
+                    }
+                    contents.push_back(std::move(content));
+                }
+            }
+        };
+    scan(stringutils::joinPath(FCITX5_SOURCE_DIR, "src"));
+    scan(stringutils::joinPath(FCITX5_SOURCE_DIR, "data"));
+    FCITX_ASSERT(!contents.empty());
+
+    // Every in-tree file reads the same from a buffer and from a file.
+    for (auto &content : contents) {
+        if (content.empty()) {
+            continue;
+        }
+        RawConfig config;
+        readFromIni(config, content);
+        RawConfig fileConfig;
+        UniqueFilePtr file(fmemopen(content.data(), content.size(), "r"));
+        readFromIni(fileConfig, file.get());
+        FCITX_ASSERT(fileConfig == config);
+    }
+}
+
+void testFlatRawConfig() {
+    TestConfig config;
+    I18NString str;
+    str.set("A", "zh_CN");
+    str.set("ABCD");
+    config.i18nStringValue.setValue(str);
+    config.intValue.setValue(5);
+    config.enumValue.setValue(TestEnum::EnumB);
+    config.subConfigValue.mutableValue()->intValue.setValue(3);
+    RawConfig rawConfig;
+    config.save(rawConfig);
+    rawConfig.get("IntOption")->setLineNumber(7);
+
+    FlatRawConfig flatConfig(rawConfig);
+    FCITX_ASSERT(flatConfig.toRawConfig() == rawConfig);
+    auto node = flatConfig.find("SubConfigOption/IntOption");
+    FCITX_ASSERT(node != FlatRawConfig::npos);
+    FCITX_ASSERT(flatConfig.value(node) == "3");
+    FCITX_ASSERT(flatConfig.name(node) == "IntOption");
+    FCITX_ASSERT(flatConfig.parent(node) ==
+                 flatConfig.find("SubConfigOption"));
+    FCITX_ASSERT(flatConfig.parent(FlatRawConfig::root) == FlatRawConfig::npos);
+    FCITX_ASSERT(flatConfig.lineNumber(flatConfig.find("IntOption")) == 7);
+    FCITX_ASSERT(flatConfig.comment(flatConfig.find("IntOption")) ==
+                 rawConfig.get("IntOption")->comment());
+    FCITX_ASSERT(flatConfig.find("SubConfigOption/None") ==
+                 FlatRawConfig::npos);
+    FCITX_ASSERT(flatConfig.find("IntOption/None") == FlatRawConfig::npos);
+
+    // Children keep the original order.
+    auto subItems = rawConfig.subItems();
+    FCITX_ASSERT(flatConfig.childCount(FlatRawConfig::root) ==
+                 subItems.size());
+    for (size_t i = 0; i < subItems.size(); i++) {
+        FCITX_ASSERT(flatConfig.name(flatConfig.child(
+                         FlatRawConfig::root, i)) == subItems[i]);
+    }
+
+    // Copy and move keep the content.
+    FlatRawConfig copy = flatConfig;
+    FlatRawConfig moved = std::move(copy);
+    FCITX_ASSERT(moved.toRawConfig() == rawConfig);
+    FCITX_ASSERT(moved.size() == flatConfig.size());
+    FCITX_ASSERT(FlatRawConfig().size() == 1);
+
+    TestConfig loaded;
+    loaded.load(flatConfig);
+    FCITX_ASSERT(loaded == config);
+    FCITX_ASSERT(loaded.i18nStringValue->match("zh_CN") == "A");
+    FCITX_ASSERT(loaded.i18nStringValue->match("") == "ABCD");
+
+    // Missing options are reset unless partial.
+    RawConfig partialConfig;
+    partialConfig.setValueByPath("BoolOption", "False");
+    loaded.load(FlatRawConfig(partialConfig), true);
+    FCITX_ASSERT(*loaded.intValue == 5);
+    FCITX_ASSERT(!*loaded.boolValue);
+    loaded.load(FlatRawConfig(partialConfig));
+    FCITX_ASSERT(*loaded.intValue == 0);
+    FCITX_ASSERT(!*loaded.boolValue);
+}
+
+void testOptionChanged() {
+    TestConfig config;
+    std::vector<const OptionBase *> changed;
+    auto watcher = config.watchOptionChanged(
+        [&changed](const OptionBase &option) { changed.push_back(&option); });
+
+    RawConfig rawConfig;
+    config.save(rawConfig);
+    config.load(rawConfig);
+    FCITX_ASSERT(changed.empty());
+
+    // Sub option and localized value are compared too.
+    rawConfig.setValueByPath("IntOption", "3");
+    rawConfig.setValueByPath("SubConfigOption/IntOption", "4");
+    rawConfig.setValueByPath("I18NString[zh_CN]", "A");
+    config.load(rawConfig);
+    FCITX_ASSERT((changed == std::vector<const OptionBase *>{
+                                 &config.intValue, &config.i18nStringValue,
+                                 &config.subConfigValue}));
+
+    changed.clear();
+    config.load(FlatRawConfig(rawConfig));
+    FCITX_ASSERT(changed.empty());
+
+    // Missing option is reset only if not partial.
+    RawConfig partialConfig;
+    partialConfig.setValueByPath("BoolOption", "False");
+    config.load(partialConfig, true);
+    FCITX_ASSERT(changed == std::vector<const OptionBase *>{&config.boolValue});
+    changed.clear();
+    config.load(FlatRawConfig(partialConfig));
+    FCITX_ASSERT((changed == std::vector<const OptionBase *>{
+                                 &config.intValue, &config.i18nStringValue,
+                                 &config.subConfigValue}));
+
+    watcher.reset();
+    changed.clear();
+    config.load(rawConfig);
+    FCITX_ASSERT(changed.empty());
+}
+
 int main() {
     testBasics();
     testMove();
@@ -211,5 +403,9 @@ int main() {
     testSyncDefaultToCurrent();
     testExtend();
     testCopyConfiguration();
+    testIniParser();
+    testIniParserTree();
+    testFlatRawConfig();
+    testOptionChanged();
     return 0;
 }
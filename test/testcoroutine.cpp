@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <unistd.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "fcitx-utils/coroutine.h"
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/log.h"
+
+using namespace fcitx;
+
+AsyncTask<int> square(EventLoop &loop, int value) {
+    co_await asyncSleep(loop, 1000);
+    co_await asyncDefer(loop);
+    co_return value * value;
+}
+
+AsyncTask<> failure(EventLoop &loop) {
+    co_await asyncDefer(loop);
+    throw std::runtime_error("failure");
+}
+
+AsyncTask<> sum(EventLoop &loop, std::vector<int> &results) {
+    for (int i = 0; i < 3; i++) {
+        results.push_back(co_await square(loop, i));
+    }
+    try {
+        co_await failure(loop);
+    } catch (const std::runtime_error &) {
+        results.push_back(-1);
+    }
+    loop.exit();
+}
+
+void testBasic() {
+    EventLoop loop;
+    std::vector<int> results;
+    auto task = sum(loop, results);
+    FCITX_ASSERT(!task.done());
+    task.start();
+    FCITX_ASSERT(!task.done());
+    loop.exec();
+    FCITX_ASSERT(task.done());
+    task.result();
+    FCITX_ASSERT(results == std::vector<int>({0, 1, 4, -1}));
+}
+
+void testCancel() {
+    EventLoop loop;
+    bool resumed = false;
+    auto task = [](EventLoop &loop, bool &resumed) -> AsyncTask<> {
+        co_await asyncSleep(loop, 1000);
+        resumed = true;
+    }(loop, resumed);
+    task.start();
+    task.reset();
+    FCITX_ASSERT(task.done());
+    auto timer = loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 10000, 0,
+        [&loop](EventSourceTime *, uint64_t) {
+            loop.exit();
+            return true;
+        });
+    loop.exec();
+    FCITX_ASSERT(!resumed);
+}
+
+void testIO() {
+    EventLoop loop;
+    int pipefd[2];
+    FCITX_ASSERT(pipe(pipefd) == 0);
+    IOEventFlags result;
+    auto task = [](EventLoop &loop, int fd,
+                   IOEventFlags &result) -> AsyncTask<> {
+        result = co_await asyncWaitIO(loop, fd, IOEventFlag::In);
+        loop.exit();
+    }(loop, pipefd[0], result);
+    task.start();
+    FCITX_ASSERT(write(pipefd[1], "a", 1) == 1);
+    loop.exec();
+    FCITX_ASSERT(task.done());
+    FCITX_ASSERT(result.test(IOEventFlag::In));
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+int main() {
+    testBasic();
+    testCancel();
+    testIO();
+    return 0;
+}
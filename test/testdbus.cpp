@@ -5,11 +5,13 @@
  *
  */
 
+#include <string_view>
 #include <thread>
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/variant.h"
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/log.h"
+#include "fcitx-utils/stringutils.h"
 
 using namespace fcitx::dbus;
 using namespace fcitx;
@@ -57,6 +59,9 @@ class TestObject : public ObjectVTable<TestObject> {
         }
         return "";
     }
+    std::string test6(std::string_view str, int32_t i) {
+        return stringutils::concat(str, i);
+    }
 
 private:
     int prop2 = 1;
@@ -65,6 +70,7 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(test3, "test3", "i", "iu");
     FCITX_OBJECT_VTABLE_METHOD(test4, "test4", "v", "v");
     FCITX_OBJECT_VTABLE_METHOD(test5, "test5", "a{ss}", "s");
+    FCITX_OBJECT_VTABLE_METHOD_BORROWED(test6, "test6", "si", "s");
     FCITX_OBJECT_VTABLE_METHOD(testError, "testError", "", "b");
     FCITX_OBJECT_VTABLE_SIGNAL(testSignal, "testSignal", "a(si)");
     FCITX_OBJECT_VTABLE_PROPERTY(testProperty, "testProperty", "i",
@@ -140,6 +146,26 @@ void client() {
                 << reply.errorMessage();
             return false;
         }));
+    std::unique_ptr<EventSourceTime> s10(loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 250000, 0,
+        [&clientBus](EventSource *, uint64_t) {
+            FCITX_INFO() << "Client sends test2 to fallback";
+            auto msg = clientBus.createMethodCall(
+                TEST_SERVICE, "/fallback/1", TEST_INTERFACE, "test2");
+            msg << 7;
+            auto reply = msg.call(0);
+            FCITX_ASSERT(reply.type() == MessageType::Reply);
+            std::string ret;
+            reply >> ret;
+            FCITX_ASSERT(ret == "7");
+
+            auto missing = clientBus.createMethodCall(
+                TEST_SERVICE, "/fallback/2", TEST_INTERFACE, "test2");
+            missing << 7;
+            auto errorReply = missing.call(0);
+            FCITX_ASSERT(errorReply.type() == MessageType::Error);
+            return false;
+        }));
     std::unique_ptr<EventSourceTime> s4(loop.addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 300000, 0,
         [&clientBus](EventSource *, uint64_t) {
@@ -177,6 +203,21 @@ void client() {
             FCITX_ASSERT(s == "defg");
             return false;
         }));
+    std::unique_ptr<EventSourceTime> s8(loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 450000, 0,
+        [&clientBus](EventSource *, uint64_t) {
+            FCITX_INFO() << "Client sends test6";
+            auto msg = clientBus.createMethodCall(TEST_SERVICE, "/test",
+                                                  TEST_INTERFACE, "test6");
+            msg << "abc" << 1;
+            auto reply = msg.call(0);
+            FCITX_ASSERT(reply.type() == MessageType::Reply);
+            std::string_view ret;
+            reply >> ret;
+            FCITX_ASSERT(reply);
+            FCITX_ASSERT(ret == "abc1");
+            return false;
+        }));
     std::unique_ptr<EventSourceTime> s6(loop.addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 500000, 0,
         [&clientBus](EventSource *, uint64_t) {
@@ -211,7 +252,28 @@ void client() {
                               FCITX_ASSERT(ret.dataAs<int32_t>() == 5);
                               return false;
                           }));
+    // A burst of calls, every one of them is replied when the server drains
+    // several queued messages in one wakeup.
+    constexpr int burstSize = 100;
+    int burstReplies = 0;
+    std::vector<std::unique_ptr<Slot>> burstSlots;
+    std::unique_ptr<EventSourceTime> s9(loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 300000, 0,
+        [&](EventSource *, uint64_t) {
+            for (int i = 0; i < burstSize; i++) {
+                auto msg = clientBus.createMethodCall(TEST_SERVICE, "/test",
+                                                      TEST_INTERFACE, "test1");
+                burstSlots.push_back(
+                    msg.callAsync(0, [&](dbus::Message &reply) {
+                        FCITX_ASSERT(reply.type() == MessageType::Reply);
+                        ++burstReplies;
+                        return true;
+                    }));
+            }
+            return false;
+        }));
     loop.exec();
+    FCITX_ASSERT(burstReplies == burstSize);
 }
 
 int main() {
@@ -222,12 +284,22 @@ int main() {
     EventLoop loop;
     bus.attachEventLoop(&loop);
     FCITX_ASSERT(&loop == bus.eventLoop());
+    bus.setMethodStatisticsEnabled(true);
+    FCITX_ASSERT(bus.isMethodStatisticsEnabled());
     if (!bus.requestName(TEST_SERVICE, {RequestNameFlag::AllowReplacement,
                                         RequestNameFlag::ReplaceExisting})) {
         return 1;
     }
     TestObject obj;
     FCITX_ASSERT(bus.addObjectVTable("/test", TEST_INTERFACE, obj));
+    TestObject fallbackObj;
+    bus.bindObjectVTable("/fallback/1", TEST_INTERFACE, fallbackObj);
+    auto fallbackSlot = bus.addObjectVTableFallback(
+        "/fallback", TEST_INTERFACE, fallbackObj,
+        [&fallbackObj](const std::string &path) -> ObjectVTableBase * {
+            return path == "/fallback/1" ? &fallbackObj : nullptr;
+        });
+    FCITX_ASSERT(fallbackSlot);
     std::unique_ptr<EventSourceTime> s(loop.addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 2000000, 0,
         [&bus, &loop](EventSource *, uint64_t) {
@@ -237,6 +309,26 @@ int main() {
             auto reply = msg.call(0);
             std::string s;
             reply >> s;
+            bool hasTest1 = false;
+            bool hasTestError = false;
+            for (const auto &stat : bus.methodStatistics()) {
+                FCITX_INFO() << stat.interface << "." << stat.method << " "
+                             << stat.callCount << " calls "
+                             << stat.totalTime << "us";
+                FCITX_ASSERT(stat.interface == TEST_INTERFACE);
+                if (stat.method == "test1") {
+                    hasTest1 = true;
+                    FCITX_ASSERT(stat.callCount == 1000);
+                    FCITX_ASSERT(stat.errorCount == 0);
+                } else if (stat.method == "testError") {
+                    hasTestError = true;
+                    FCITX_ASSERT(stat.callCount == 1);
+                    FCITX_ASSERT(stat.errorCount == 1);
+                }
+            }
+            FCITX_ASSERT(hasTest1 && hasTestError);
+            bus.resetMethodStatistics();
+            FCITX_ASSERT(bus.methodStatistics().empty());
             loop.exit();
             return false;
         }));
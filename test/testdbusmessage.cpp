@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/message.h"
+#include "fcitx-utils/dbus/objectvtable.h"
 #include "fcitx-utils/dbus/variant.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/metastring.h"
@@ -62,6 +63,18 @@ int main() {
                              std::string, std::vector<uint32_t>>>::value,
         "Type is not same");
 
+    static_assert(std::is_same<MethodArgsSignature<const std::string &,
+                                                   uint32_t, std::string_view>,
+                               fcitxMakeMetaString("sus")>::value,
+                  "Signature is not same");
+    static_assert(
+        std::is_same<MethodArgsSignature<const std::vector<DictEntry<
+                         std::string, Variant>> &>,
+                     fcitxMakeMetaString("a{sv}")>::value,
+        "Signature is not same");
+    static_assert(std::is_same<MethodArgsSignature<>, MetaString<>>::value,
+                  "Signature is not same");
+
     // interface name must has dot
     {
         auto msg = bus.createSignal("/test", "test.a.b.c", "test");
@@ -133,6 +146,13 @@ int main() {
         dbus::Variant var2(var);
         FCITX_INFO() << var;
         FCITX_INFO() << var2;
+        FCITX_ASSERT(&var.dataAs<std::string>() ==
+                     &var2.dataAs<std::string>());
+        // Setting new data doesn't affect the copy.
+        var.setData(1);
+        FCITX_ASSERT(var.signature() == "i");
+        FCITX_ASSERT(var2.signature() == "s");
+        FCITX_ASSERT(var2.dataAs<std::string>() == "abcd");
     }
 
 #if 0
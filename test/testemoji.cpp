@@ -5,8 +5,12 @@
  *
  */
 #include <fcntl.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <fcitx-utils/log.h>
 #include <fcitx-utils/standardpath.h>
+#include <fcitx-utils/stringutils.h>
 #include <fcitx-utils/testing.h>
 #include <fcitx/addonmanager.h>
 #include "emoji_public.h"
@@ -31,11 +35,48 @@ int main() {
     FCITX_ASSERT(std::find(emojis.begin(), emojis.end(), "\xf0\x9f\x8d\x86") !=
                  emojis.end())
         << emojis;
+    // Filtered by the no space rule of en.
+    FCITX_ASSERT(emoji->call<IEmoji::query>("en", "face with tears of joy",
+                                            false)
+                     .empty());
+    // Falls back to en.
+    FCITX_ASSERT(!emoji->call<IEmoji::query>("xx", "eggplant", true).empty());
+
+    std::vector<std::string> keys;
+    auto collector = [&keys](const std::string &key,
+                             const std::vector<std::string> &values) {
+        FCITX_ASSERT(!values.empty());
+        keys.push_back(key);
+        return true;
+    };
+    emoji->call<IEmoji::prefix>("en", "egg", false, collector);
+    FCITX_ASSERT(std::is_sorted(keys.begin(), keys.end())) << keys;
+    FCITX_ASSERT(std::find(keys.begin(), keys.end(), "eggplant") != keys.end())
+        << keys;
+    for (const auto &key : keys) {
+        FCITX_ASSERT(stringutils::startsWith(key, "egg")) << key;
+    }
+
+    keys.clear();
+    emoji->call<IEmoji::search>("en", "egg", false, 2, false, collector);
+    FCITX_ASSERT(keys.size() == 2) << keys;
+    FCITX_ASSERT(keys[0] == "egg") << keys;
+    keys.clear();
+    emoji->call<IEmoji::search>("en", "eggplnt", false, 5, true, collector);
+    FCITX_ASSERT(std::find(keys.begin(), keys.end(), "eggplant") != keys.end())
+        << keys;
+    keys.clear();
+    emoji->call<IEmoji::search>("en", "eggplnt", false, 5, false, collector);
+    FCITX_ASSERT(keys.empty()) << keys;
 
     auto files = StandardPath::global().multiOpen(StandardPath::Type::PkgData,
                                                   "emoji/data", O_RDONLY,
                                                   filter::Suffix(".dict"));
-    // Check if all languages are loadable.
+    // Check if the index is generated, and all languages are loadable.
+    FCITX_ASSERT(!StandardPath::global()
+                      .locate(StandardPath::Type::PkgData,
+                              "emoji/data/emoji.index")
+                      .empty());
     for (const auto &[name, __] : files) {
         std::string lang = name.substr(0, name.size() - 5);
         FCITX_ASSERT(emoji->call<IEmoji::check>(lang, false))
@@ -6,8 +6,12 @@
  */
 
 #include <unistd.h>
+#include <cstdint>
 #include <ctime>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 #include <fcitx-utils/event.h>
 #include "fcitx-utils/eventdispatcher.h"
 #include "fcitx-utils/log.h"
@@ -177,10 +181,177 @@ void test_post_io() {
     thread.join();
 }
 
+void test_many_timers() {
+    EventLoop e;
+    constexpr int numTimers = 10000;
+    constexpr int rounds = 3;
+    std::vector<std::unique_ptr<EventSourceTime>> timers;
+    timers.reserve(numTimers);
+    int fired = 0;
+    int remaining = numTimers;
+    uint64_t last = 0;
+
+    const auto base = now(CLOCK_MONOTONIC);
+    for (int i = 0; i < numTimers; i++) {
+        auto round = std::make_shared<int>(0);
+        timers.push_back(e.addTimeEvent(
+            CLOCK_MONOTONIC, base + 300000 + (i % 97) * 1000, 0,
+            [&, round](EventSourceTime *source, uint64_t time) {
+                const auto current = now(CLOCK_MONOTONIC);
+                FCITX_ASSERT(current >= time);
+                // Timers are fired in the order of their deadline.
+                FCITX_ASSERT(source->time() + 1000 >= last);
+                last = source->time();
+                ++fired;
+                if (++(*round) < rounds) {
+                    source->setNextInterval(10000 + (*round) * 1000);
+                    source->setOneShot();
+                } else if (--remaining == 0) {
+                    e.exit();
+                }
+                return true;
+            }));
+    }
+
+    // Reschedule everything once before the loop starts.
+    for (int i = 0; i < numTimers; i++) {
+        timers[i]->setTime(base + 100000 + (i % 89) * 1000);
+    }
+
+    // Timers that are deleted or disabled must not fire.
+    for (int i = 0; i < numTimers; i += 1000) {
+        timers[i]->setEnabled(false);
+        timers[i + 1].reset();
+        remaining -= 2;
+    }
+
+    auto guard = e.addTimeEvent(CLOCK_MONOTONIC, base + 10000000, 0,
+                                [](EventSourceTime *, uint64_t) {
+                                    FCITX_ASSERT(false) << "Timeout";
+                                    return true;
+                                });
+    e.exec();
+    FCITX_ASSERT(fired == (numTimers - 20) * rounds) << fired;
+}
+
+void test_statistics() {
+    EventLoop e;
+    FCITX_ASSERT(!e.isStatisticsEnabled());
+    // Sources created before statistics is enabled are recorded too.
+    auto before = e.addDeferEvent(
+        [](EventSource *source) {
+            source->setEnabled(false);
+            return true;
+        },
+        "Test/Before");
+    e.setStatisticsEnabled(true);
+    FCITX_ASSERT(e.isStatisticsEnabled());
+    int count = 0;
+    auto defer = e.addDeferEvent(
+        [&count](EventSource *source) {
+            if (++count == 3) {
+                source->setEnabled(false);
+            }
+            return true;
+        },
+        "Test/Defer");
+    defer->setEnabled(true);
+    auto exit = e.addTimeEvent(CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 50000,
+                               0, [&e](EventSource *, uint64_t) {
+                                   e.exit();
+                                   return true;
+                               });
+    e.exec();
+    FCITX_ASSERT(count == 3);
+
+    bool foundBefore = false;
+    bool foundDefer = false;
+    bool foundTime = false;
+    for (const auto &statistic : e.statistics()) {
+        FCITX_INFO() << statistic.tag << " " << statistic.dispatchCount << " "
+                     << statistic.totalTime;
+        if (statistic.tag == "Test/Defer") {
+            FCITX_ASSERT(statistic.dispatchCount == 3);
+            FCITX_ASSERT(statistic.lastDispatchTime != 0);
+            foundDefer = true;
+        } else if (statistic.tag == "Test/Before") {
+            FCITX_ASSERT(statistic.dispatchCount == 1);
+            foundBefore = true;
+        } else if (statistic.tag == "time") {
+            FCITX_ASSERT(statistic.dispatchCount == 1);
+            foundTime = true;
+        }
+    }
+    FCITX_ASSERT(foundBefore && foundDefer && foundTime);
+
+    e.resetStatistics();
+    FCITX_ASSERT(e.statistics().empty());
+}
+
+void test_priority() {
+    EventLoop e;
+    std::vector<std::string> order;
+    auto record = [&order, &e](std::string name) {
+        order.push_back(std::move(name));
+        if (order.size() == 2) {
+            e.exit();
+        }
+    };
+
+    int lowPipe[2];
+    int highPipe[2];
+    FCITX_ASSERT(pipe(lowPipe) == 0);
+    FCITX_ASSERT(pipe(highPipe) == 0);
+    FCITX_ASSERT(write(lowPipe[1], "a", 1) == 1);
+    FCITX_ASSERT(write(highPipe[1], "a", 1) == 1);
+    auto lowIO = e.addIOEvent(
+        lowPipe[0], IOEventFlag::In,
+        [&record](EventSourceIO *source, int, IOEventFlags) {
+            source->setEnabled(false);
+            record("low");
+            return true;
+        });
+    auto highIO = e.addIOEvent(
+        highPipe[0], IOEventFlag::In,
+        [&record](EventSourceIO *source, int, IOEventFlags) {
+            source->setEnabled(false);
+            record("high");
+            return true;
+        });
+    e.setPriority(lowIO.get(), EventPriority::Low);
+    e.setPriority(highIO.get(), EventPriority::High);
+    e.exec();
+    FCITX_ASSERT(order == std::vector<std::string>{"high", "low"}) << order;
+    for (int fd : {lowPipe[0], lowPipe[1], highPipe[0], highPipe[1]}) {
+        close(fd);
+    }
+
+    // Timers of different priority are served by different native timers.
+    order.clear();
+    const auto time = now(CLOCK_MONOTONIC) + 10000;
+    auto lowTime = e.addTimeEvent(CLOCK_MONOTONIC, time, 0,
+                                  [&record](EventSourceTime *, uint64_t) {
+                                      record("low");
+                                      return true;
+                                  });
+    auto highTime = e.addTimeEvent(CLOCK_MONOTONIC, time, 0,
+                                   [&record](EventSourceTime *, uint64_t) {
+                                       record("high");
+                                       return true;
+                                   });
+    e.setPriority(lowTime.get(), EventPriority::Low);
+    e.setPriority(highTime.get(), EventPriority::High);
+    e.exec();
+    FCITX_ASSERT(order == std::vector<std::string>{"high", "low"}) << order;
+}
+
 int main() {
     test_basic();
     test_source_deleted();
     test_post_time();
     test_post_io();
+    test_many_timers();
+    test_statistics();
+    test_priority();
     return 0;
 }
@@ -5,11 +5,14 @@
  *
  */
 #include <unistd.h>
+#include <array>
 #include <atomic>
+#include <memory>
 #include <thread>
 #include <vector>
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/eventloopthread_p.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/trackableobject.h"
 
@@ -56,6 +59,26 @@ void testOrder() {
     }
 }
 
+void testBatch() {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+    std::vector<int> value;
+    std::vector<Task> tasks;
+    for (int i = 0; i < 100; i++) {
+        tasks.emplace_back([i, &value]() { value.push_back(i); });
+    }
+    tasks.emplace_back();
+    dispatcher.scheduleBatch(std::move(tasks));
+    dispatcher.scheduleBatch({});
+    dispatcher.schedule([&loop]() { loop.exit(); });
+    loop.exec();
+    FCITX_ASSERT(value.size() == 100);
+    for (int i = 0; i < 100; i++) {
+        FCITX_ASSERT(i == value[i]) << i << " " << value[i];
+    }
+}
+
 void recursiveSchedule() {
     EventDispatcher dispatcher;
     EventLoop loop;
@@ -102,10 +125,122 @@ void withContext() {
     FCITX_ASSERT(!invalidCalled);
 }
 
+void multiProducer() {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+    constexpr int numThreads = 4;
+    constexpr int numEvents = 10000;
+    std::vector<int> last(numThreads, -1);
+    int total = 0;
+    bool ordered = true;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < numEvents; i++) {
+                dispatcher.schedule([&, t, i]() {
+                    ordered = ordered && last[t] + 1 == i;
+                    last[t] = i;
+                    if (++total == numThreads * numEvents) {
+                        loop.exit();
+                    }
+                });
+            }
+        });
+    }
+    loop.exec();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    FCITX_ASSERT(ordered);
+    FCITX_ASSERT(total == numThreads * numEvents) << total;
+}
+
+void moveOnlyTask() {
+    EventDispatcher dispatcher;
+    EventLoop loop;
+    dispatcher.attach(&loop);
+    int value = 0;
+    auto data = std::make_unique<int>(42);
+    dispatcher.schedule([data = std::move(data), &value]() { value = *data; });
+    // Larger than inline storage.
+    std::array<int, 64> large;
+    large.fill(1);
+    int sum = 0;
+    dispatcher.schedule([large, &sum]() {
+        for (auto v : large) {
+            sum += v;
+        }
+    });
+    TestObject object;
+    auto counter = std::make_unique<int>(0);
+    dispatcher.scheduleWithContext(
+        object.watch(), [counter = std::move(counter), &loop]() mutable {
+            ++*counter;
+            loop.exit();
+        });
+    loop.exec();
+    FCITX_ASSERT(value == 42);
+    FCITX_ASSERT(sum == 64);
+
+    Task task;
+    FCITX_ASSERT(!task);
+    task = [&value]() { value = 1; };
+    Task other = std::move(task);
+    FCITX_ASSERT(!task);
+    FCITX_ASSERT(other);
+    other();
+    FCITX_ASSERT(value == 1);
+    FCITX_ASSERT(!Task(std::function<void()>()));
+    static_assert(sizeof(Task) <= 64);
+}
+
+void sharedThread() {
+    EventLoopThread thread;
+    FCITX_ASSERT(!thread.isCurrentThread());
+    int fds[2][2];
+    FCITX_ASSERT(pipe(fds[0]) == 0);
+    FCITX_ASSERT(pipe(fds[1]) == 0);
+    // Watch multiple fds on the same thread.
+    std::atomic<int> readable{0};
+    std::vector<std::unique_ptr<EventSourceIO>> events;
+    thread.call([&]() {
+        FCITX_ASSERT(thread.isCurrentThread());
+        for (auto &fd : fds) {
+            events.push_back(thread.eventLoop().addIOEvent(
+                fd[0], IOEventFlag::In,
+                [&readable](EventSource *source, int, IOEventFlags) {
+                    source->setEnabled(false);
+                    ++readable;
+                    return true;
+                }));
+        }
+    });
+    for (auto &fd : fds) {
+        FCITX_ASSERT(write(fd[1], "a", 1) == 1);
+    }
+    while (readable != 2) {
+        std::this_thread::yield();
+    }
+    int value = 0;
+    thread.schedule([&value]() { value = 1; });
+    thread.call([&events]() { events.clear(); });
+    // call waits for everything scheduled before.
+    FCITX_ASSERT(value == 1);
+    for (auto &fd : fds) {
+        close(fd[0]);
+        close(fd[1]);
+    }
+}
+
 int main() {
     basicTest();
     testOrder();
+    testBatch();
+    multiProducer();
     recursiveSchedule();
     withContext();
+    moveOnlyTask();
+    sharedThread();
     return 0;
 }
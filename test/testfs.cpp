@@ -5,12 +5,17 @@
  *
  */
 
+#include <fcntl.h>
 #include <libgen.h>
 #include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <utility>
 #include <fcitx-utils/stringutils.h>
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/misc.h"
+#include "fcitx-utils/unixfd.h"
 
 using namespace fcitx::fs;
 using namespace fcitx;
@@ -45,6 +50,45 @@ UniqueCPtr<char> cdUp(const char *path) {
         FCITX_ASSERT(cleanStr == r);                                           \
     } while (0);
 
+void testFileView() {
+    FCITX_ASSERT(!FileView().isValid());
+    FCITX_ASSERT(!FileView(-1).isValid());
+
+    char name[] = "testfileview_XXXXXX";
+    auto fd = UnixFD::own(mkstemp(name));
+    FCITX_ASSERT(fd.isValid());
+    unlink(name);
+    {
+        FileView empty(fd.fd());
+        FCITX_ASSERT(empty.isValid());
+        FCITX_ASSERT(empty.size() == 0);
+    }
+    std::string content(100000, 'a');
+    content.back() = 'b';
+    FCITX_ASSERT(safeWrite(fd.fd(), content.data(), content.size()) ==
+                 static_cast<ssize_t>(content.size()));
+    // Always from the beginning, regardless of the offset.
+    FileView file(fd.fd());
+    fd.reset();
+    FCITX_ASSERT(file.isValid());
+    FCITX_ASSERT(file.view() == content);
+
+    FileView moved(std::move(file));
+    FCITX_ASSERT(!file.isValid());
+    FCITX_ASSERT(moved.view() == content);
+
+    int pipeFd[2];
+    FCITX_ASSERT(pipe(pipeFd) == 0);
+    auto readEnd = UnixFD::own(pipeFd[0]);
+    auto writeEnd = UnixFD::own(pipeFd[1]);
+    FCITX_ASSERT(safeWrite(writeEnd.fd(), "abc", 3) == 3);
+    writeEnd.reset();
+    FileView pipeView(readEnd.fd());
+    FCITX_ASSERT(pipeView.isValid());
+    FCITX_ASSERT(!pipeView.isMapped());
+    FCITX_ASSERT(pipeView.view() == "abc");
+}
+
 int main() {
     TEST_PATH("/a", "/a");
     TEST_PATH("/a/b", "/a/b");
@@ -117,5 +161,7 @@ int main() {
     FCITX_ASSERT(rmdir("a/b") == 0);
     FCITX_ASSERT(rmdir("a") == 0);
 
+    testFileView();
+
     return 0;
 }
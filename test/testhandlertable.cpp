@@ -53,6 +53,63 @@ int main() {
 
     entry.reset();
 
+    {
+        auto pool = std::make_shared<HandlerPool<Callback>>();
+        PooledHandlerTable<Callback> table(pool);
+        int called = 0;
+        entry = table.add([&called]() { called++; });
+        FCITX_ASSERT(table.size() == 1);
+        FCITX_ASSERT(!entry->handler());
+        auto handle =
+            static_cast<PooledHandlerTableEntry<Callback> *>(entry.get())
+                ->handle();
+        FCITX_ASSERT(pool->get(handle));
+        entry.reset();
+        FCITX_ASSERT(table.empty());
+        FCITX_ASSERT(!pool->get(handle));
+
+        // Slot is reused, but the old handle stays invalid.
+        entry = table.add([&called]() { called++; });
+        FCITX_ASSERT(!pool->get(handle));
+
+        std::unique_ptr<HandlerTableEntry<Callback>> added;
+        auto *current = &table;
+        std::unique_ptr<HandlerTableEntry<Callback>> entries[] = {
+            table.add([&]() {
+                called++;
+                auto *e = entries;
+                for (int i = 0; i < 3; i++) {
+                    e[i].reset();
+                }
+                added = current->add([&called]() { called++; });
+            }),
+            table.add([&called]() { called++; }),
+            table.add([&called]() { called++; }),
+        };
+
+        // Shares the pool.
+        PooledHandlerTable<Callback> otherTable(pool);
+        auto other = otherTable.add([]() {});
+        FCITX_ASSERT(table.size() == 4);
+
+        auto table2 = std::move(table);
+        current = &table2;
+        table2.forEach([](Callback &callback) { callback(); });
+        FCITX_ASSERT(called == 2) << called;
+        FCITX_ASSERT(table2.size() == 2);
+        table2.forEach([](Callback &callback) { callback(); });
+        FCITX_ASSERT(called == 4) << called;
+
+        int visited = 0;
+        table2.forEach([&visited](Callback &) {
+            visited++;
+            return false;
+        });
+        FCITX_ASSERT(visited == 1);
+    }
+
+    entry.reset();
+
     {
         MultiHandlerTable<std::string, Callback> table2(
             [](const std::string &key) {
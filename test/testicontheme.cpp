@@ -4,12 +4,83 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "fcitx-utils/fs.h"
 #include "fcitx-utils/log.h"
+#include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx/icontheme.h"
 
 using namespace fcitx;
 
+void writeFile(const std::string &path, const std::string &content) {
+    auto fd = UnixFD::own(open(path.c_str(), O_WRONLY | O_CREAT, 0644));
+    FCITX_ASSERT(fd.isValid());
+    FCITX_ASSERT(fs::safeWrite(fd.fd(), content.data(), content.size()) ==
+                 static_cast<ssize_t>(content.size()));
+}
+
+void testCache() {
+    char tmpl[] = "/tmp/fcitx-icontheme-XXXXXX";
+    const char *tmp = mkdtemp(tmpl);
+    FCITX_ASSERT(tmp);
+    // Paths to remove, in reverse order.
+    std::vector<std::string> paths{tmp, stringutils::joinPath(tmp, "icons")};
+    auto addTheme = [tmp, &paths](const std::string &name,
+                                  const std::string &inherits) {
+        const auto themeDir =
+            stringutils::joinPath(tmp, "icons", name, "48x48/apps");
+        FCITX_ASSERT(fs::makePath(themeDir));
+        paths.push_back(stringutils::joinPath(tmp, "icons", name));
+        paths.push_back(stringutils::joinPath(tmp, "icons", name, "48x48"));
+        paths.push_back(themeDir);
+        const auto index =
+            stringutils::joinPath(tmp, "icons", name, "index.theme");
+        writeFile(index, "[Icon Theme]\nName=Test\nDirectories=48x48/apps\n"
+                         "Inherits=" +
+                             inherits +
+                             "\n[48x48/apps]\nSize=48\nType=Fixed\n");
+        paths.push_back(index);
+        const auto icon =
+            stringutils::joinPath(themeDir, stringutils::concat(name, ".png"));
+        writeFile(icon, "");
+        paths.push_back(icon);
+        return icon;
+    };
+    const auto iconPath = addTheme("test", "testbase");
+    const auto baseIconPath = addTheme("testbase", "");
+
+    FCITX_ASSERT(setenv("XDG_DATA_DIRS", tmp, 1) == 0);
+    StandardPath standardPath(true, true);
+    IconTheme theme("test", standardPath);
+    FCITX_ASSERT(theme.findIcon("test", 48, 1, {".png"}) == iconPath);
+    // Cached, and still valid.
+    FCITX_ASSERT(theme.findIcon("test", 48, 1, {".png"}) == iconPath);
+    // Dash fallback.
+    FCITX_ASSERT(theme.findIcon("test-extra", 48, 1, {".png"}) == iconPath);
+    // Found in inherited theme.
+    FCITX_ASSERT(theme.findIcon("testbase", 48, 1, {".png"}) == baseIconPath);
+    FCITX_ASSERT(theme.inherits().size() == 2);
+    FCITX_ASSERT(theme.inherits()[0].internalName() == "testbase");
+    FCITX_ASSERT(theme.inherits()[1].internalName() == "hicolor");
+    // Removed file is not returned from cache.
+    FCITX_ASSERT(unlink(iconPath.c_str()) == 0);
+    paths.erase(std::find(paths.begin(), paths.end(), iconPath));
+    FCITX_ASSERT(theme.findIcon("test", 48, 1, {".png"}).empty());
+
+    for (auto iter = paths.rbegin(); iter != paths.rend(); ++iter) {
+        FCITX_ASSERT(remove(iter->c_str()) == 0) << *iter;
+    }
+}
+
 int main() {
+
     IconTheme theme("breeze");
     FCITX_INFO() << IconTheme::defaultIconThemeName();
     FCITX_INFO() << theme.name().match();
@@ -43,5 +114,7 @@ int main() {
 
     FCITX_INFO() << theme.findIcon("fcitx-pinyin", 32, 1);
 
+    testCache();
+
     return 0;
 }
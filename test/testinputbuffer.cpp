@@ -4,14 +4,23 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <random>
+#include <string>
+#include <vector>
 #include "fcitx-utils/inputbuffer.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/utf8.h"
 
-void test_basic(bool ascii) {
+void test_basic(bool ascii, bool gap = false) {
     using namespace fcitx;
-    InputBuffer buffer(InputBufferOptions(ascii ? InputBufferOption::AsciiOnly
-                                                : InputBufferOption::NoOption));
+    InputBufferOptions options;
+    if (ascii) {
+        options |= InputBufferOption::AsciiOnly;
+    }
+    if (gap) {
+        options |= InputBufferOption::GapBuffer;
+    }
+    InputBuffer buffer(options);
     FCITX_ASSERT(buffer.empty());
     FCITX_ASSERT(buffer.cursor() == 0);
     FCITX_ASSERT(buffer.cursorByChar() == 0);
@@ -113,9 +122,60 @@ void test_utf8_issue_965() {
     }
 }
 
+void test_gap_buffer() {
+    using namespace fcitx;
+    InputBuffer buffer;
+    InputBuffer gapBuffer(InputBufferOption::GapBuffer);
+    const std::vector<std::string> inputs = {
+        "a", "bc", "\xe4\xbd\xa0", "\xe5\xa5\xbd"
+                                  "d",
+        "\xf0\x9f\x98\x80"};
+    std::mt19937 gen(0);
+    for (int i = 0; i < 5000; i++) {
+        auto op = gen() % 4;
+        if (op == 0 && !buffer.empty()) {
+            size_t from = gen() % buffer.size();
+            size_t to =
+                from + 1 + gen() % std::min<size_t>(3, buffer.size() - from);
+            buffer.erase(from, to);
+            gapBuffer.erase(from, to);
+        } else if (op == 1) {
+            size_t cursor = gen() % (buffer.size() + 1);
+            buffer.setCursor(cursor);
+            gapBuffer.setCursor(cursor);
+        } else {
+            const auto &input = inputs[gen() % inputs.size()];
+            buffer.type(input);
+            gapBuffer.type(input);
+        }
+        FCITX_ASSERT(buffer.size() == gapBuffer.size());
+        FCITX_ASSERT(buffer.cursor() == gapBuffer.cursor());
+        FCITX_ASSERT(buffer.cursorByChar() == gapBuffer.cursorByChar());
+        if (i % 7 == 0) {
+            FCITX_ASSERT(buffer.userInput() == gapBuffer.userInput());
+            for (size_t j = 0; j < buffer.size(); j++) {
+                FCITX_ASSERT(buffer.rangeAt(j) == gapBuffer.rangeAt(j));
+                FCITX_ASSERT(buffer.viewAt(j) == gapBuffer.viewAt(j));
+                FCITX_ASSERT(buffer.charAt(j) == gapBuffer.charAt(j));
+                FCITX_ASSERT(buffer.sizeAt(j) == gapBuffer.sizeAt(j));
+            }
+        }
+        if (i % 1000 == 999) {
+            gapBuffer.shrinkToFit();
+            FCITX_ASSERT(buffer.userInput() == gapBuffer.userInput());
+        }
+    }
+    gapBuffer.clear();
+    FCITX_ASSERT(gapBuffer.empty());
+    FCITX_ASSERT(gapBuffer.userInput().empty());
+}
+
 int main() {
     test_basic(true);
     test_basic(false);
+    test_basic(true, true);
+    test_basic(false, true);
+    test_gap_buffer();
     test_utf8();
     test_utf8_issue_965();
     return 0;
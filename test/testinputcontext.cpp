@@ -5,18 +5,27 @@
  *
  */
 
+#include <unistd.h>
+#include <cstdlib>
 #include <stdexcept>
 #include <vector>
+#include "fcitx-config/rawconfig.h"
 #include "fcitx-utils/capabilityflags.h"
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/fs.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/testing.h"
+#include "fcitx-utils/unixfd.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/candidatelist.h"
 #include "fcitx/focusgroup.h"
+#include "fcitx/globalconfig.h"
 #include "fcitx/inputcontext.h"
 #include "fcitx/inputcontextmanager.h"
 #include "fcitx/inputcontextproperty.h"
+#include "fcitx/inputpanel.h"
 #include "fcitx/instance.h"
+#include "fcitx/keytrace_p.h"
 #include "fcitx/userinterface.h"
 #include "testdir.h"
 #include "testfrontend_public.h"
@@ -233,6 +242,218 @@ void test_property() {
     FCITX_ASSERT(testProperty2->num() == 0);
 }
 
+void test_property_on_demand() {
+    InputContextManager manager;
+    int created = 0;
+    FactoryFor<TestSharedProperty> testFactory([&created](InputContext &) {
+        created++;
+        return new TestSharedProperty;
+    });
+    testFactory.setCreateOnDemand(true);
+    FCITX_ASSERT(testFactory.createOnDemand());
+    manager.registerProperty("test", &testFactory);
+    manager.setPropertyPropagatePolicy(PropertyPropagatePolicy::All);
+
+    std::vector<std::unique_ptr<InputContext>> ic;
+    for (int i = 0; i < 3; i++) {
+        ic.emplace_back(new TestInputContext(manager));
+    }
+    FCITX_ASSERT(created == 0);
+    auto *property = ic[0]->propertyFor(&testFactory);
+    FCITX_ASSERT(created == 1);
+    FCITX_ASSERT(property == ic[0]->propertyFor(&testFactory));
+    FCITX_ASSERT(property == ic[0]->property("test"));
+
+    // Created property copies the shared state from existing one.
+    property->setNum(3);
+    FCITX_ASSERT(ic[1]->propertyFor(&testFactory)->num() == 3);
+    FCITX_ASSERT(created == 2);
+    ic.emplace_back(new TestInputContext(manager));
+    FCITX_ASSERT(created == 2);
+    FCITX_ASSERT(ic.back()->propertyFor(&testFactory)->num() == 3);
+    FCITX_ASSERT(created == 3);
+
+    // Propagation only updates created ones, others copy it on creation.
+    property->setNum(5);
+    ic[0]->updateProperty(&testFactory);
+    FCITX_ASSERT(created == 3);
+    FCITX_ASSERT(ic[1]->propertyFor(&testFactory)->num() == 5);
+    FCITX_ASSERT(ic[2]->propertyFor(&testFactory)->num() == 5);
+    FCITX_ASSERT(created == 4);
+
+    // Registered after input contexts are created.
+    FactoryFor<TestProperty> lateFactory(
+        [](InputContext &) { return new TestProperty; });
+    lateFactory.setCreateOnDemand(true);
+    manager.registerProperty("late", &lateFactory);
+    FCITX_ASSERT(ic[2]->propertyFor(&lateFactory)->num() == 0);
+    lateFactory.unregister();
+    FCITX_ASSERT(ic[2]->propertyFor(&testFactory)->num() == 5);
+}
+
+void test_recycle() {
+    InputContextManager manager;
+    FactoryFor<TestProperty> testFactory(
+        [](InputContext &) { return new TestProperty; });
+    manager.registerProperty("test", &testFactory);
+    // The dummy input context.
+    FCITX_ASSERT(manager.inputContextCount() == 1);
+    const auto created = manager.createdInputContextCount();
+
+    std::vector<std::unique_ptr<InputContext>> ic;
+    for (int i = 0; i < 4; i++) {
+        ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    }
+    FCITX_ASSERT(manager.inputContextCount() == 5);
+    ic[0]->propertyFor(&testFactory)->setNum(1);
+    ic.clear();
+    FCITX_ASSERT(manager.inputContextCount() == 1);
+    FCITX_ASSERT(manager.peakInputContextCount() == 5);
+
+    const auto recycled = manager.recycledInputContextCount();
+    for (int i = 0; i < 4; i++) {
+        ic.emplace_back(new TestInputContext(manager, "Firefox"));
+        // Recycled slots are always clean.
+        FCITX_ASSERT(ic.back()->propertyFor(&testFactory)->num() == 0);
+    }
+    FCITX_ASSERT(manager.recycledInputContextCount() == recycled + 4);
+    FCITX_ASSERT(manager.createdInputContextCount() == created + 8);
+    FCITX_ASSERT(manager.peakInputContextCount() == 5);
+}
+
+void test_property_usage() {
+    InputContextManager manager;
+    FactoryFor<TestProperty> testFactory(
+        [](InputContext &) { return new TestProperty; });
+    FCITX_ASSERT(testFactory.propertySize() == sizeof(TestProperty));
+    testFactory.setCreateOnDemand(true);
+    manager.registerProperty("test", &testFactory);
+
+    std::vector<std::unique_ptr<InputContext>> ic;
+    for (int i = 0; i < 3; i++) {
+        ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    }
+    const auto empty = manager.propertyMemoryUsage(*ic[0]);
+    ic[0]->propertyFor(&testFactory);
+    ic[1]->propertyFor(&testFactory);
+    FCITX_ASSERT(manager.propertyMemoryUsage(*ic[0]) ==
+                 empty + sizeof(TestProperty));
+    FCITX_ASSERT(manager.propertyMemoryUsage(*ic[2]) == empty);
+
+    auto usage = manager.propertyUsage();
+    FCITX_ASSERT(usage.size() == 1);
+    FCITX_ASSERT(usage[0].name == "test");
+    FCITX_ASSERT(usage[0].count == 2);
+    FCITX_ASSERT(usage[0].bytes == 2 * sizeof(TestProperty));
+}
+
+void test_lookup() {
+    InputContextManager manager;
+    FactoryFor<TestSharedProperty> testFactory(
+        [](InputContext &) { return new TestSharedProperty; });
+    manager.registerProperty("test", &testFactory);
+    manager.setPropertyPropagatePolicy(PropertyPropagatePolicy::Program);
+
+    const std::string programs[] = {"Firefox", "Chrome", "Konsole", ""};
+    std::vector<std::unique_ptr<InputContext>> ic;
+    for (int i = 0; i < 400; i++) {
+        ic.emplace_back(new TestInputContext(
+            manager, programs[i % FCITX_ARRAY_SIZE(programs)]));
+    }
+    for (const auto &inputContext : ic) {
+        FCITX_ASSERT(manager.findByUUID(inputContext->uuid()) ==
+                     inputContext.get());
+    }
+
+    // Remove every other one, remaining ones must still be found.
+    std::vector<ICUUID> removed;
+    for (size_t i = 0; i < ic.size(); i++) {
+        if (i % 2 == 0) {
+            removed.push_back(ic[i]->uuid());
+            ic[i].reset();
+        }
+    }
+    for (const auto &uuid : removed) {
+        FCITX_ASSERT(!manager.findByUUID(uuid));
+    }
+    for (const auto &inputContext : ic) {
+        if (inputContext) {
+            FCITX_ASSERT(manager.findByUUID(inputContext->uuid()) ==
+                         inputContext.get());
+        }
+    }
+
+    // Program wide propagation only reaches the same program.
+    ic[1]->propertyFor(&testFactory)->setNum(7);
+    ic[1]->updateProperty(&testFactory);
+    for (size_t i = 1; i < ic.size(); i += 2) {
+        const bool sameProgram = ic[i]->program() == ic[1]->program();
+        FCITX_ASSERT((ic[i]->propertyFor(&testFactory)->num() == 7) ==
+                     sameProgram);
+    }
+    ic.emplace_back(new TestInputContext(manager, ic[1]->program()));
+    FCITX_ASSERT(ic.back()->propertyFor(&testFactory)->num() == 7);
+}
+
+void test_input_panel_dirty() {
+    InputContextManager manager;
+    auto ic = std::make_unique<TestInputContext>(manager, "Firefox");
+    auto &inputPanel = ic->inputPanel();
+    FCITX_ASSERT(!inputPanel.dirtyComponents());
+
+    inputPanel.setPreedit(Text("abc"));
+    inputPanel.setAuxUp(Text("A"));
+    FCITX_ASSERT(inputPanel.dirtyComponents() ==
+                 InputPanelComponents{InputPanelComponent::Preedit,
+                                      InputPanelComponent::AuxUp});
+    inputPanel.clearDirtyComponents();
+
+    // Same value is not a change.
+    inputPanel.setPreedit(Text("abc"));
+    FCITX_ASSERT(!inputPanel.dirtyComponents());
+    Text preedit("abc");
+    preedit.setCursor(1);
+    inputPanel.setPreedit(preedit);
+    FCITX_ASSERT(inputPanel.dirtyComponents() == InputPanelComponent::Preedit);
+    inputPanel.clearDirtyComponents();
+
+    auto candidateList = std::make_unique<CommonCandidateList>();
+    candidateList->setPageSize(3);
+    for (int i = 0; i < 10; i++) {
+        candidateList->append<DisplayOnlyCandidateWord>(
+            Text(std::to_string(i)));
+    }
+    candidateList->setGlobalCursorIndex(0);
+    auto *list = candidateList.get();
+    inputPanel.setCandidateList(std::move(candidateList));
+    FCITX_ASSERT(inputPanel.dirtyComponents() ==
+                 InputPanelComponent::CandidateList);
+    inputPanel.clearDirtyComponents();
+
+    list->nextCandidate();
+    FCITX_ASSERT(inputPanel.dirtyComponents() ==
+                 InputPanelComponent::CandidateCursor);
+    inputPanel.clearDirtyComponents();
+
+    list->next();
+    FCITX_ASSERT(inputPanel.dirtyComponents().test(
+        InputPanelComponent::CandidatePage));
+    inputPanel.clearDirtyComponents();
+
+    // Modified in place, cursor stays the same.
+    list->replace(list->globalCursorIndex(),
+                  std::make_unique<DisplayOnlyCandidateWord>(Text("X")));
+    FCITX_ASSERT(inputPanel.dirtyComponents() ==
+                 InputPanelComponent::CandidatePage);
+    inputPanel.clearDirtyComponents();
+
+    inputPanel.reset();
+    FCITX_ASSERT(inputPanel.dirtyComponents() ==
+                 InputPanelComponents{InputPanelComponent::Preedit,
+                                      InputPanelComponent::AuxUp,
+                                      InputPanelComponent::CandidateList});
+}
+
 void test_preedit_override() {
     InputContextManager manager;
     auto ic = std::make_unique<TestInputContext>(manager, "Firefox");
@@ -294,6 +515,47 @@ void test_event_blocking() {
     FCITX_ASSERT(!ic->hasPendingEventsStrictOrder());
 }
 
+class CountingInputContext : public TestInputContext {
+public:
+    using TestInputContext::TestInputContext;
+
+    void commitStringImpl(const std::string &text) override {
+        committed_ += text.size();
+    }
+    void forwardKeyImpl(const ForwardKeyEvent &) override { forwarded_++; }
+    void updatePreeditImpl() override { preedit_++; }
+
+    size_t committed_ = 0;
+    size_t forwarded_ = 0;
+    size_t preedit_ = 0;
+};
+
+void test_event_blocking_order() {
+    constexpr int rounds = 3;
+    constexpr int keysPerRound = 8;
+    InputContextManager manager;
+    auto ic = std::make_unique<CountingInputContext>(manager, "Firefox");
+    ic->setCapabilityFlags(CapabilityFlag::Preedit);
+    ic->inputPanel().setClientPreedit(Text("a"));
+
+    // Every key produces a commit and a preedit update while the client is
+    // blocked, all of them are delivered once unblocked.
+    for (int i = 0; i < rounds; i++) {
+        ic->setBlockEventToClient(true);
+        for (int j = 0; j < keysPerRound; j++) {
+            ic->commitString("a");
+            ic->updatePreedit();
+        }
+        ic->forwardKey(Key(FcitxKey_BackSpace));
+        FCITX_ASSERT(ic->hasPendingEventsStrictOrder());
+        ic->setBlockEventToClient(false);
+        FCITX_ASSERT(!ic->hasPendingEvents());
+    }
+    FCITX_ASSERT(ic->committed_ == static_cast<size_t>(rounds * keysPerRound));
+    FCITX_ASSERT(ic->forwarded_ == rounds);
+    FCITX_ASSERT(ic->preedit_ == static_cast<size_t>(rounds * keysPerRound));
+}
+
 void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([dispatcher, instance]() {
         auto *testfrontend = instance->addonManager().addon("testfrontend");
@@ -325,6 +587,169 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
             ic->updateUserInterface(UserInterfaceComponent::InputPanel, true);
             FCITX_ASSERT(customUICallbackCalled);
         }
+        {
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), false);
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), true);
+            auto recent = instance->recentKeyEvents();
+            FCITX_INFO() << recent;
+            FCITX_ASSERT(recent.find("frontend:testfrontend key:a handler:") !=
+                         std::string::npos);
+            FCITX_ASSERT(recent.find("key:a release") != std::string::npos);
+        }
+        {
+            char name[] = "testkeytrace_XXXXXX";
+            UnixFD fd = UnixFD::own(mkstemp(name));
+            FCITX_ASSERT(fd.isValid());
+            FCITX_ASSERT(instance->startKeyTrace(name));
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), false);
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), true);
+            testfrontend->call<ITestFrontend::keyEvent>(
+                uuid, Key("Control+b"), false);
+            instance->stopKeyTrace();
+            // Not recorded after stop.
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("c"), false);
+            unlink(name);
+
+            fs::FileView view(fd.fd());
+            KeyTraceReader reader(view.view());
+            FCITX_ASSERT(reader.isValid());
+            std::vector<KeyTraceEvent> events;
+            KeyTraceEvent event;
+            while (reader.next(event)) {
+                events.push_back(event);
+            }
+            FCITX_ASSERT(reader.isValid());
+            FCITX_ASSERT(events.size() == 3) << events.size();
+            FCITX_ASSERT(events[0].key == Key("a"));
+            FCITX_ASSERT(!events[0].isRelease);
+            FCITX_ASSERT(events[1].isRelease);
+            FCITX_ASSERT(events[2].key == Key("Control+b"));
+            for (const auto &event : events) {
+                FCITX_ASSERT(event.inputContext == 0);
+                FCITX_ASSERT(event.program == "testapp");
+                FCITX_ASSERT(event.frontend == "testfrontend");
+            }
+            FCITX_ASSERT(!KeyTraceReader("garbage").isValid());
+        }
+        {
+            int changed = 0;
+            auto handler = instance->watchEvent(
+                EventType::InputContextCursorRectChanged,
+                EventWatcherPhase::Default, [&changed](Event &) { changed++; });
+            RawConfig config;
+            config.setValueByPath("Behavior/CursorRectThreshold", "4");
+            instance->globalConfig().load(config, true);
+            ic->setCursorRect(Rect(10, 10, 20, 30));
+            ic->flushNotifications();
+            FCITX_ASSERT(changed == 1);
+            ic->setCursorRect(Rect(12, 11, 22, 31));
+            ic->flushNotifications();
+            FCITX_ASSERT(changed == 1);
+            FCITX_ASSERT(ic->cursorRect() == Rect(10, 10, 20, 30));
+            ic->setCursorRect(Rect(12, 11, 22, 32));
+            ic->flushNotifications();
+            FCITX_ASSERT(changed == 2);
+            ic->setCursorRect(Rect(16, 11, 26, 32));
+            ic->flushNotifications();
+            FCITX_ASSERT(changed == 3);
+            config.setValueByPath("Behavior/CursorRectThreshold", "0");
+            instance->globalConfig().load(config, true);
+        }
+        {
+            // A burst of updates is delivered once, before the next key.
+            int surroundingText = 0;
+            int cursorRect = 0;
+            std::vector<EventType> order;
+            std::vector<std::unique_ptr<HandlerTableEntry<EventHandler>>>
+                handlers;
+            handlers.emplace_back(instance->watchEvent(
+                EventType::InputContextSurroundingTextUpdated,
+                EventWatcherPhase::Default,
+                [&surroundingText, &order](Event &event) {
+                    surroundingText++;
+                    order.push_back(event.type());
+                }));
+            handlers.emplace_back(instance->watchEvent(
+                EventType::InputContextCursorRectChanged,
+                EventWatcherPhase::Default,
+                [&cursorRect, &order](Event &event) {
+                    cursorRect++;
+                    order.push_back(event.type());
+                }));
+            handlers.emplace_back(instance->watchEvent(
+                EventType::InputContextKeyEvent,
+                EventWatcherPhase::PreInputMethod,
+                [&order](Event &event) { order.push_back(event.type()); }));
+            ic->focusIn();
+            for (int i = 0; i < 3; i++) {
+                ic->surroundingText().setText("abc", i, i);
+                ic->updateSurroundingText();
+                ic->setCursorRect(Rect(i, 0, i + 10, 10));
+            }
+            FCITX_ASSERT(surroundingText == 0);
+            FCITX_ASSERT(cursorRect == 0);
+            KeyEvent event(ic, Key("a"));
+            ic->keyEvent(event);
+            FCITX_ASSERT(surroundingText == 1);
+            FCITX_ASSERT(cursorRect == 1);
+            FCITX_ASSERT(order.size() == 3);
+            FCITX_ASSERT(order.back() == EventType::InputContextKeyEvent);
+            ic->flushNotifications();
+            FCITX_ASSERT(order.size() == 3);
+        }
+        {
+            ic->focusIn();
+            KeyEventResultCallback deferred;
+            auto handler = instance->watchEvent(
+                EventType::InputContextKeyEvent,
+                EventWatcherPhase::PreInputMethod, [&deferred](Event &event) {
+                    auto &keyEvent = static_cast<KeyEvent &>(event);
+                    deferred = keyEvent.inputContext()->deferKeyEvent();
+                    keyEvent.filterAndAccept();
+                });
+            int result = -1;
+            KeyEvent event(ic, Key("b"));
+            ic->keyEventAsync(event,
+                              [&result](bool accepted) { result = accepted; });
+            FCITX_ASSERT(result == -1);
+            FCITX_ASSERT(deferred);
+            FCITX_ASSERT(!ic->deferKeyEvent());
+            // Commit is held until the deferred key is resolved.
+            ic->commitString("b");
+            FCITX_ASSERT(ic->hasPendingEvents());
+            deferred(false);
+            FCITX_ASSERT(result == 0);
+            FCITX_ASSERT(!ic->hasPendingEvents());
+
+            // Only keyEventAsync can be deferred.
+            KeyEvent syncEvent(ic, Key("c"));
+            FCITX_ASSERT(ic->keyEvent(syncEvent));
+            FCITX_ASSERT(!deferred);
+        }
+        {
+            bool accept = false;
+            auto handler = instance->watchEvent(
+                EventType::InputContextKeyEvent,
+                EventWatcherPhase::PreInputMethod, [&accept](Event &event) {
+                    auto &keyEvent = static_cast<KeyEvent &>(event);
+                    keyEvent.inputContext()->setKeyRepeatPassThrough(true);
+                    if (accept) {
+                        keyEvent.filterAndAccept();
+                    }
+                });
+            KeyEvent event(ic, Key("d"));
+            FCITX_ASSERT(!ic->keyEvent(event));
+            FCITX_ASSERT(ic->isKeyRepeatPassThrough());
+            // Accepted key is never passed through.
+            accept = true;
+            FCITX_ASSERT(ic->keyEvent(event));
+            FCITX_ASSERT(!ic->isKeyRepeatPassThrough());
+            accept = false;
+            FCITX_ASSERT(!ic->keyEvent(event));
+            ic->focusOut();
+            FCITX_ASSERT(!ic->isKeyRepeatPassThrough());
+            ic->focusIn();
+        }
 
         dispatcher->schedule([dispatcher, instance]() {
             dispatcher->detach();
@@ -392,8 +817,14 @@ void test_ic_v2() {
 int main() {
     test_simple();
     test_property();
+    test_property_on_demand();
+    test_recycle();
+    test_property_usage();
+    test_lookup();
+    test_input_panel_dirty();
     test_preedit_override();
     test_event_blocking();
+    test_event_blocking_order();
     test_custom_panel();
     test_ic_v2();
 
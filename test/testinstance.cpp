@@ -28,6 +28,69 @@ void testCheckUpdate(EventDispatcher *dispatcher, Instance *instance) {
     });
 }
 
+void testEventDispatchOrder(EventDispatcher *dispatcher, Instance *instance) {
+    dispatcher->schedule([instance]() {
+        std::vector<int> order;
+        std::unique_ptr<HandlerTableEntry<EventHandler>> post, pre, im;
+        post = instance->watchEvent(
+            EventType::CheckUpdate, EventWatcherPhase::PostInputMethod,
+            [&order](Event &) { order.push_back(3); });
+        im = instance->watchEvent(EventType::CheckUpdate,
+                                  EventWatcherPhase::InputMethod,
+                                  [&order, &post](Event &) {
+                                      order.push_back(2);
+                                      // Remove a handler during dispatch.
+                                      post.reset();
+                                  });
+        pre = instance->watchEvent(EventType::CheckUpdate,
+                                   EventWatcherPhase::PreInputMethod,
+                                   [&order](Event &) { order.push_back(1); });
+        FCITX_ASSERT(!instance->checkUpdate());
+        FCITX_ASSERT(order == std::vector<int>({1, 2})) << order;
+        order.clear();
+        FCITX_ASSERT(!instance->checkUpdate());
+        FCITX_ASSERT(order == std::vector<int>({1, 2})) << order;
+        order.clear();
+        pre.reset();
+        im.reset();
+        FCITX_ASSERT(!instance->checkUpdate());
+        FCITX_ASSERT(order.empty()) << order;
+    });
+}
+
+void testStartupTimeline(EventDispatcher *dispatcher, Instance *instance) {
+    dispatcher->schedule([instance]() {
+        auto timeline = instance->startupTimeline();
+        FCITX_INFO() << timeline;
+        // Input method is preloaded later, so it is still in progress.
+        FCITX_ASSERT(timeline.find("(in progress)") != std::string::npos);
+        FCITX_ASSERT(timeline.find("AddonManager/Load") != std::string::npos);
+        FCITX_ASSERT(timeline.find("  Addon/testim") != std::string::npos);
+        FCITX_ASSERT(timeline.find("InputMethodManager/Load") !=
+                     std::string::npos);
+    });
+}
+
+void testXkbKeymapCache(EventDispatcher *dispatcher, Instance *instance) {
+    dispatcher->schedule([instance]() {
+        auto *keymap =
+            instance->xkbKeymapFromNames("evdev", "pc105", "us", "", "");
+        // Same names share the compiled keymap.
+        FCITX_ASSERT(keymap == instance->xkbKeymapFromNames("evdev", "pc105",
+                                                            "us", "", ""));
+        const auto usage = instance->xkbKeymapCacheUsage();
+        FCITX_INFO() << "Keymap cache: " << usage.first << " "
+                     << usage.second;
+        if (keymap) {
+            FCITX_ASSERT(usage.first >= 1);
+            FCITX_ASSERT(usage.second > 0);
+        }
+        // Invalid keymap is not cached.
+        FCITX_ASSERT(!instance->xkbKeymapFromString("invalid keymap"));
+        FCITX_ASSERT(instance->xkbKeymapCacheUsage() == usage);
+    });
+}
+
 void testReloadGlobalConfig(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([instance]() {
         bool globalConfigReloadedEventFired = false;
@@ -62,6 +125,9 @@ int main() {
     EventDispatcher dispatcher;
     dispatcher.attach(&instance.eventLoop());
     testCheckUpdate(&dispatcher, &instance);
+    testEventDispatchOrder(&dispatcher, &instance);
+    testStartupTimeline(&dispatcher, &instance);
+    testXkbKeymapCache(&dispatcher, &instance);
     testReloadGlobalConfig(&dispatcher, &instance);
     instance.exec();
     return 0;
@@ -5,6 +5,7 @@
  *
  */
 #include "config.h"
+#include "fcitx-utils/log.h"
 #include "im/keyboard/isocodes.h"
 
 using namespace fcitx;
@@ -15,5 +16,10 @@ int main() {
     const auto *entry = isocodes.entry("eng");
     FCITX_ASSERT(entry);
     FCITX_ASSERT(entry->iso_639_1_code == "en");
+    FCITX_ASSERT(isocodes.entry("ger") == isocodes.entry("deu"));
+    FCITX_ASSERT(!isocodes.entry("xxxx"));
+    const auto *country = isocodes.country("FR");
+    FCITX_ASSERT(country);
+    FCITX_ASSERT(*country == "France");
     return 0;
 }
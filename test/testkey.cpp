@@ -5,6 +5,7 @@
  *
  */
 
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include "fcitx-utils/key.h"
@@ -18,6 +19,64 @@
         FCITX_ASSERT(COMPARE_FUNC(ARRAY[i], ARRAY[i + 1])) << i;               \
     }
 
+void test_key_matcher() {
+    using namespace fcitx;
+    const KeyList keys[] = {
+        Key::keyListFromString("Control+space Zenkaku_Hankaku Hangul"),
+        Key::keyListFromString("Shift_L Control+Shift_L"),
+        Key::keyListFromString("Super+space Super+Shift+space <50>"),
+        Key::keyListFromString("Control+Alt+Shift+Super+a Control+A"),
+        Key::keyListFromString("Control+space"),
+        {Key(), Key(FcitxKey_VoidSymbol)},
+    };
+    KeyMatcher matcher;
+    for (size_t i = 0; i < FCITX_ARRAY_SIZE(keys); i++) {
+        matcher.addKeys(i, keys[i]);
+    }
+
+    std::vector<Key> pressed = {
+        Key(),
+        Key(FcitxKey_VoidSymbol),
+        Key(FcitxKey_Shift_L, KeyState::Shift),
+        Key(FcitxKey_Shift_L, KeyState::Ctrl),
+        Key(FcitxKey_Shift_L, KeyStates{KeyState::Ctrl, KeyState::Shift}),
+        Key(FcitxKey_Shift_L),
+        Key(FcitxKey_a, KeyStates{KeyState::Ctrl, KeyState::Alt,
+                                  KeyState::Shift, KeyState::Super2}),
+        Key(FcitxKey_A, KeyStates{KeyState::Ctrl, KeyState::NumLock}),
+        Key(FcitxKey_space, KeyStates{KeyState::Super, KeyState::Shift}),
+        Key(FcitxKey_space, KeyState::Ctrl),
+        Key(FcitxKey_Hangul),
+    };
+    pressed.push_back(Key::fromKeyCode(50));
+    pressed.push_back(Key::fromKeyCode(50, KeyState::Ctrl));
+    for (const auto &key : pressed) {
+        uint64_t expected = 0;
+        for (size_t i = 0; i < FCITX_ARRAY_SIZE(keys); i++) {
+            if (key.checkKeyList(keys[i])) {
+                expected |= (1ULL << i);
+            }
+        }
+        FCITX_ASSERT(matcher.match(key) == expected) << key;
+    }
+    FCITX_ASSERT(matcher.match(Key(FcitxKey_space, KeyState::Ctrl), 0));
+    FCITX_ASSERT(matcher.match(Key(FcitxKey_space, KeyState::Ctrl), 4));
+    FCITX_ASSERT(!matcher.match(Key(FcitxKey_space, KeyState::Ctrl), 1));
+    matcher.clear();
+    FCITX_ASSERT(!matcher.match(Key(FcitxKey_space, KeyState::Ctrl)));
+}
+
+void test_unicode_lookup() {
+    for (const auto &item : fcitx::keysym_to_unicode_tab) {
+        FCITX_ASSERT(fcitx::Key::keySymToUnicode(
+                         static_cast<fcitx::KeySym>(item.keysym)) == item.ucs);
+        FCITX_ASSERT(fcitx::Key::keySymToUnicode(
+                         fcitx::Key::keySymFromUnicode(item.ucs)) == item.ucs);
+    }
+    FCITX_ASSERT(fcitx::Key::keySymFromUnicode(0x10000) ==
+                 static_cast<fcitx::KeySym>(0x1010000));
+}
+
 int main() {
 #define _STRING_LESS(A, B) (strcmp((A), (B)) < 0)
 #define _STRING_LESS_2(A, B) (strcmp((A).name, (B).name) < 0)
@@ -37,6 +96,18 @@ int main() {
         FCITX_ASSERT(fcitx::Key::keySymFromString(keyNameList[i]) ==
                      keyValueByNameOffset[i]);
     }
+    for (const auto &item : keyNameOffsetByValue) {
+        FCITX_ASSERT(fcitx::Key::keySymToString(
+                         static_cast<fcitx::KeySym>(item.sym)) ==
+                     keyNameList[item.offset]);
+    }
+    // Names and values not in the table.
+    FCITX_ASSERT(fcitx::Key::keySymFromString("NotAKeyName") ==
+                 FcitxKey_None);
+    FCITX_ASSERT(fcitx::Key::keySymFromString("") == FcitxKey_None);
+    FCITX_ASSERT(
+        fcitx::Key::keySymToString(static_cast<fcitx::KeySym>(0x7fffffff))
+            .empty());
 
     const std::pair<FcitxKeySym, uint32_t> keySymUnicode[]{
         {FcitxKey_BackSpace, '\b'}, {FcitxKey_Tab, '\t'},
@@ -154,5 +225,8 @@ int main() {
     FCITX_ASSERT(fcitx::Key::keySymToUnicode(
                      static_cast<fcitx::KeySym>(0x120fdd7)) == 0);
 
+    test_key_matcher();
+    test_unicode_lookup();
+
     return 0;
 }
@@ -4,10 +4,66 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <unistd.h>
+#include <fstream>
 #include <sstream>
+#include <thread>
 #include <fcitx-utils/log.h>
 #include <fcitx-utils/metastring.h>
 
+void testAsyncLog() {
+    char fname[] = "testlogXXXXXX";
+    int fd = mkstemp(fname);
+    FCITX_ASSERT(fd != -1);
+    close(fd);
+
+    constexpr int numThreads = 4;
+    constexpr int numMessages = 2000;
+    FCITX_ASSERT(fcitx::Log::startAsyncLog(fcitx::LogSink::File, fname, 64));
+    FCITX_ASSERT(fcitx::Log::isAsyncLog());
+    auto dropped = fcitx::Log::droppedLogMessages();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back([i]() {
+            for (int j = 0; j < numMessages; j++) {
+                FCITX_INFO() << "ASYNC " << i << " " << j;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    fcitx::Log::stopAsyncLog();
+    FCITX_ASSERT(!fcitx::Log::isAsyncLog());
+    dropped = fcitx::Log::droppedLogMessages() - dropped;
+
+    std::ifstream file(fname);
+    std::string line;
+    uint64_t count = 0;
+    while (std::getline(file, line)) {
+        if (line.find("] ASYNC ") != std::string::npos) {
+            count++;
+        } else {
+            FCITX_ASSERT(dropped && line.find("dropped") != std::string::npos)
+                << line;
+        }
+    }
+    FCITX_ASSERT(count + dropped == numThreads * numMessages)
+        << count << " " << dropped;
+    unlink(fname);
+}
+
+void testCallSiteCache() {
+    // The same call site need to follow the change of log level.
+    for (int level : {4, 5, 4, 5}) {
+        fcitx::Log::setLogRule("default=" + std::to_string(level));
+        bool logged = false;
+        FCITX_DEBUG() << (logged = true);
+        FCITX_ASSERT(logged == (level == 5));
+    }
+    fcitx::Log::setLogRule("default=4");
+}
+
 int main() {
     int a = 0;
     fcitx::Log::setLogRule("*=5");
@@ -34,5 +90,8 @@ int main() {
 
     FCITX_ASSERT(s.str().find("ABCD") != std::string::npos);
 
+    testCallSiteCache();
+    testAsyncLog();
+
     return 0;
 }
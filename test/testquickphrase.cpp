@@ -4,17 +4,31 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <unistd.h>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/misc.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/testing.h"
 #include "fcitx/addonmanager.h"
 #include "fcitx/instance.h"
 #include "quickphrase_public.h"
+#include "quickphrasestore.h"
 #include "testdir.h"
 #include "testfrontend_public.h"
 
 using namespace fcitx;
 
 std::unique_ptr<HandlerTableEntry<QuickPhraseProviderCallback>> handle;
+std::unique_ptr<HandlerTableEntry<QuickPhraseAsyncProviderCallback>>
+    asyncHandle;
 
 void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([instance]() {
@@ -35,7 +49,7 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
         auto *testfrontend = instance->addonManager().addon("testfrontend");
         for (const auto *expectation :
              {"TEST", "abc", "abcd", "DEF", "abcd", "DEF1", "test1", "CALLBACK",
-              "AUTOCOMMIT"}) {
+              "AUTOCOMMIT", "ASYNC"}) {
             testfrontend->call<ITestFrontend::pushCommitExpectation>(
                 expectation);
         }
@@ -151,7 +165,29 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("t"), false);
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("o"), false);
 
+        asyncHandle = quickphrase->call<IQuickPhrase::addAsyncProvider>(
+            [](InputContext *, const std::string &text,
+               const QuickPhraseAddCandidateCallback &addCandidate,
+               const std::function<void()> &done) {
+                if (text == "async") {
+                    // Duplicated one is only shown once.
+                    addCandidate("ASYNC", "", QuickPhraseAction::Commit);
+                    addCandidate("ASYNC", "", QuickPhraseAction::Commit);
+                    // Not selectable, ignored.
+                    addCandidate("", "", QuickPhraseAction::AlphaSelection);
+                }
+                done();
+                return QuickPhraseCancelCallback();
+            });
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("Super+grave"),
+                                                    false);
+        for (const auto *key : {"a", "s", "y", "n", "c"}) {
+            testfrontend->call<ITestFrontend::keyEvent>(uuid, Key(key), false);
+        }
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("1"), false);
+
         dispatcher->schedule([dispatcher, instance]() {
+            asyncHandle.reset();
             handle.reset();
             dispatcher->detach();
             instance->exit();
@@ -159,7 +195,80 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     });
 }
 
+void testStore() {
+    // Same lookup result as using a multimap.
+    constexpr int numPhrases = 2000;
+    QuickPhraseStore store;
+    std::multimap<std::string, std::string> map;
+    for (int i = 0; i < numPhrases; i++) {
+        auto key = stringutils::concat("k", (i * 7919) % 500);
+        auto value = stringutils::concat("phrase", i);
+        store.add(key, value);
+        map.emplace(std::move(key), std::move(value));
+    }
+    store.build();
+    FCITX_ASSERT(store.size() == map.size());
+
+    std::vector<std::string> prefixes;
+    for (int i = 0; i < 100; i++) {
+        prefixes.push_back(stringutils::concat("k", i * 7));
+    }
+    prefixes.push_back("");
+    prefixes.push_back("x");
+
+    for (const auto &prefix : prefixes) {
+        std::vector<std::pair<std::string, std::string>> storeResult;
+        store.forEachPrefix(prefix, [&storeResult](std::string_view key,
+                                                   std::string_view value) {
+            storeResult.emplace_back(key, value);
+        });
+        std::vector<std::pair<std::string, std::string>> mapResult;
+        for (auto iter = map.lower_bound(prefix);
+             iter != map.end() && stringutils::startsWith(iter->first, prefix);
+             ++iter) {
+            mapResult.emplace_back(iter->first, iter->second);
+        }
+        FCITX_ASSERT(storeResult == mapResult) << prefix;
+    }
+}
+
+void testStoreCache() {
+    QuickPhraseStore store;
+    store.add("abc", "1");
+    store.add("ab", "2");
+    store.add("abc", "3");
+    store.add("b", "4");
+    store.build(123, 456);
+    FCITX_ASSERT(store.matches(123, 456));
+    FCITX_ASSERT(!store.matches(123, 457));
+
+    UniqueFilePtr file{std::tmpfile()};
+    FCITX_ASSERT(file);
+    auto content = store.serialize();
+    FCITX_ASSERT(fs::safeWrite(fileno(file.get()), content.data(),
+                               content.size()) ==
+                 static_cast<ssize_t>(content.size()));
+    auto mapped = QuickPhraseStore::map(fileno(file.get()));
+    FCITX_ASSERT(mapped);
+    FCITX_ASSERT(mapped->matches(123, 456));
+    std::vector<std::pair<std::string, std::string>> result;
+    mapped->forEachPrefix("ab", [&result](std::string_view key,
+                                          std::string_view value) {
+        result.emplace_back(key, value);
+    });
+    const std::vector<std::pair<std::string, std::string>> expect = {
+        {"ab", "2"}, {"abc", "1"}, {"abc", "3"}};
+    FCITX_ASSERT(result == expect);
+
+    // Truncated cache is rejected.
+    FCITX_ASSERT(ftruncate(fileno(file.get()), 10) == 0);
+    FCITX_ASSERT(!QuickPhraseStore::map(fileno(file.get())));
+}
+
 int main() {
+    testStore();
+    testStoreCache();
+
     setupTestingEnvironment(
         FCITX5_BINARY_DIR,
         {"src/modules/quickphrase", "testing/testfrontend", "testing/testui",
@@ -42,5 +42,32 @@ int main() {
 
     FCITX_ASSERT(bus.releaseName(TEST_SERVICE));
     loop.exec();
+
+    const auto uniqueName = bus.uniqueName();
+    auto uniqueNameEntry = watcher.watchService(
+        uniqueName,
+        [&loop, &uniqueName](const std::string &name, const std::string &,
+                             const std::string &newOwner) {
+            FCITX_ASSERT(name == uniqueName);
+            FCITX_ASSERT(newOwner == uniqueName);
+            loop.exit();
+        });
+    loop.exec();
+
+    // The owner is cached now, but the callback is still not called before
+    // watchService returns.
+    ServiceWatcher anotherWatcher(bus);
+    bool called = false;
+    auto anotherEntry = anotherWatcher.watchService(
+        uniqueName, [&loop, &uniqueName, &called](const std::string &,
+                                                  const std::string &,
+                                                  const std::string &newOwner) {
+            FCITX_ASSERT(newOwner == uniqueName);
+            called = true;
+            loop.exit();
+        });
+    FCITX_ASSERT(!called);
+    loop.exec();
+    FCITX_ASSERT(called);
     return 0;
 }
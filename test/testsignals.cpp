@@ -5,6 +5,8 @@
  *
  */
 
+#include <string>
+#include <vector>
 #include "fcitx-utils/connectableobject.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/metastring.h"
@@ -161,6 +163,55 @@ void test_self_removal() {
     FCITX_ASSERT(!connection.connected());
 }
 
+void test_modify_during_emit() {
+    fcitx::Signal<void()> signal;
+    std::vector<int> called;
+    std::vector<fcitx::Connection> added;
+    fcitx::Connection second;
+    auto first = signal.connect([&]() {
+        called.push_back(1);
+        second.disconnect();
+        added.push_back(signal.connect([&called]() { called.push_back(3); }));
+    });
+    second = signal.connect([&called]() { called.push_back(2); });
+
+    // Handler added by a slot is not invoked by the ongoing emission, and
+    // removed one is skipped.
+    signal();
+    FCITX_ASSERT(called == std::vector<int>{1}) << called;
+    called.clear();
+    first.disconnect();
+    signal();
+    FCITX_ASSERT(called == std::vector<int>{3}) << called;
+
+    // Nested emission.
+    called.clear();
+    bool nested = false;
+    auto reentrant = signal.connect([&]() {
+        if (!nested) {
+            nested = true;
+            signal();
+        }
+    });
+    signal();
+    FCITX_ASSERT(called == (std::vector<int>{3, 3})) << called;
+}
+
+void test_emit_all() {
+    constexpr int numHandlers = 16;
+    constexpr int rounds = 3;
+    int counter = 0;
+    fcitx::Signal<void()> signal;
+    std::vector<fcitx::ScopedConnection> connections;
+    for (int i = 0; i < numHandlers; i++) {
+        connections.emplace_back(signal.connect([&counter]() { counter++; }));
+    }
+    for (int i = 0; i < rounds; i++) {
+        signal();
+    }
+    FCITX_ASSERT(counter == numHandlers * rounds) << counter;
+}
+
 int main() {
     test_simple_signal();
     test_combiner();
@@ -170,6 +221,8 @@ int main() {
     test_reference();
     test_move();
     test_self_removal();
+    test_modify_during_emit();
+    test_emit_all();
 
     return 0;
 }
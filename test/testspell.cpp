@@ -4,21 +4,33 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <algorithm>
+#include <string>
 #include "fcitx-utils/eventdispatcher.h"
 #include "fcitx-utils/testing.h"
 #include "fcitx/addonmanager.h"
 #include "fcitx/inputmethodmanager.h"
 #include "fcitx/instance.h"
 #include "keyboard.h"
+#include "spell_public.h"
 #include "testdir.h"
 #include "testfrontend_public.h"
 
 using namespace fcitx;
 
+void testCustomHint(AddonInstance *spell) {
+    auto hints = spell->call<ISpell::hintWithProvider>(
+        "en", SpellProvider::Custom, "aple", 10);
+    FCITX_ASSERT(std::find(hints.begin(), hints.end(), "apple") !=
+                 hints.end())
+        << hints;
+}
+
 void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([instance]() {
         auto *spell = instance->addonManager().addon("spell", true);
         FCITX_ASSERT(spell);
+        testCustomHint(spell);
         InputMethodGroup group("Test");
         // Make sure custom xkb does not kick in.
         group.setDefaultLayout("us");
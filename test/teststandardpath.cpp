@@ -6,6 +6,8 @@
  */
 
 #include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
 #include <cstdlib>
 #include <set>
 #include <string>
@@ -25,13 +27,18 @@ void test_basic() {
                         "/TEST/PATH1/:/TEST/PATH2:/TEST/PATH2/:/TEST/PATH1",
                         1) == 0);
     FCITX_ASSERT(setenv("XDG_DATA_DIRS", TEST_ADDON_DIR, 1) == 0);
+    FCITX_ASSERT(setenv("FCITX_CACHE_DIRS", "/TEST/CACHE1:/TEST/CACHE2/",
+                        1) == 0);
     StandardPath standardPath(true);
+    FCITX_ASSERT(unsetenv("FCITX_CACHE_DIRS") == 0);
 
     FCITX_ASSERT(standardPath.userDirectory(StandardPath::Type::Config) ==
                  "/TEST/PATH");
     // The order to the path should be kept for their first appearance.
     FCITX_ASSERT(standardPath.directories(StandardPath::Type::Config) ==
                  std::vector<std::string>({"/TEST/PATH1", "/TEST/PATH2"}));
+    FCITX_ASSERT(standardPath.directories(StandardPath::Type::Cache) ==
+                 std::vector<std::string>({"/TEST/CACHE1", "/TEST/CACHE2"}));
 
     {
         auto result = standardPath.multiOpen(
@@ -94,6 +101,7 @@ void test_nouser() {
 
     FCITX_ASSERT(
         standardPath.userDirectory(StandardPath::Type::Config).empty());
+    FCITX_ASSERT(standardPath.directories(StandardPath::Type::Cache).empty());
     FCITX_ASSERT(standardPath.directories(StandardPath::Type::Config) ==
                  std::vector<std::string>({"/TEST/PATH1", "/TEST/PATH2"}));
 
@@ -149,9 +157,116 @@ void test_custom() {
         << path.directories(fcitx::StandardPath::Type::Data);
 }
 
+void test_cache() {
+    char tmpl[] = "/tmp/teststandardpathXXXXXX";
+    const char *tmp = mkdtemp(tmpl);
+    FCITX_ASSERT(tmp);
+    const std::string dir = tmp;
+    FCITX_ASSERT(setenv("XDG_DATA_HOME", (dir + "/user").data(), 1) == 0);
+    FCITX_ASSERT(setenv("XDG_DATA_DIRS", (dir + "/system").data(), 1) == 0);
+    StandardPath standardPath(true);
+
+    auto writeFile = [](const std::string &path) {
+        FCITX_ASSERT(fs::makePath(fs::dirName(path)));
+        int fd = ::open(path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        FCITX_ASSERT(fd >= 0);
+        close(fd);
+    };
+    auto names = [&standardPath]() {
+        std::set<std::string> result;
+        for (const auto &item :
+             standardPath.locate(StandardPath::Type::PkgData, "cache",
+                                 filter::Suffix(".conf"))) {
+            result.insert(item.first);
+        }
+        return result;
+    };
+
+    // Look up before anything exists, so the cache remembers it is missing.
+    FCITX_ASSERT(
+        standardPath.locate(StandardPath::Type::PkgData, "cache/a.conf")
+            .empty());
+    FCITX_ASSERT(names().empty());
+
+    const auto systemFile = dir + "/system/fcitx5/cache/a.conf";
+    const auto userFile = dir + "/user/fcitx5/cache/a.conf";
+    writeFile(systemFile);
+    FCITX_ASSERT(standardPath.locate(StandardPath::Type::PkgData,
+                                     "cache/a.conf") == systemFile);
+    writeFile(userFile);
+    FCITX_ASSERT(standardPath.locate(StandardPath::Type::PkgData,
+                                     "cache/a.conf") == userFile);
+    FCITX_ASSERT(
+        standardPath.locateAll(StandardPath::Type::PkgData, "cache/a.conf") ==
+        std::vector<std::string>({userFile, systemFile}));
+
+    writeFile(dir + "/system/fcitx5/cache/b.conf");
+    FCITX_ASSERT(names() == std::set<std::string>({"a.conf", "b.conf"}))
+        << names();
+
+    FCITX_ASSERT(unlink(userFile.data()) == 0);
+    FCITX_ASSERT(standardPath.locate(StandardPath::Type::PkgData,
+                                     "cache/a.conf") == systemFile);
+    FCITX_ASSERT(rename(systemFile.data(),
+                        (dir + "/system/fcitx5/cache/c.conf").data()) == 0);
+    FCITX_ASSERT(
+        standardPath.open(StandardPath::Type::PkgData, "cache/a.conf", O_RDONLY)
+            .fd() < 0);
+    FCITX_ASSERT(names() == std::set<std::string>({"b.conf", "c.conf"}))
+        << names();
+
+    // A file replaced by a directory is no longer a match.
+    FCITX_ASSERT(unlink((dir + "/system/fcitx5/cache/b.conf").data()) == 0);
+    FCITX_ASSERT(fs::makePath(dir + "/system/fcitx5/cache/b.conf"));
+    FCITX_ASSERT(
+        standardPath.locate(StandardPath::Type::PkgData, "cache/b.conf")
+            .empty());
+
+    FCITX_ASSERT(system(("rm -rf " + dir).data()) == 0);
+}
+
+void test_queue_save() {
+    char tmpl[] = "/tmp/teststandardpathXXXXXX";
+    const char *tmp = mkdtemp(tmpl);
+    FCITX_ASSERT(tmp);
+    const std::string dir = tmp;
+    FCITX_ASSERT(setenv("XDG_CONFIG_HOME", dir.data(), 1) == 0);
+    const auto read = [](const StandardPathFile &file) {
+        FCITX_ASSERT(file.isValid());
+        std::string content(16, '\0');
+        auto size = fs::safeRead(file.fd(), content.data(), content.size());
+        FCITX_ASSERT(size >= 0);
+        content.resize(size);
+        return content;
+    };
+    {
+        StandardPath standardPath(true);
+        for (int i = 0; i < 100; i++) {
+            standardPath.queueSave(StandardPath::Type::PkgConfig, "queue/a",
+                                   std::to_string(i));
+        }
+        // Opening a queued file waits for the latest content.
+        FCITX_ASSERT(read(standardPath.open(StandardPath::Type::PkgConfig,
+                                            "queue/a", O_RDONLY)) == "99");
+        standardPath.queueSave(StandardPath::Type::PkgConfig, "queue/b", "b");
+        standardPath.flushSaves();
+        FCITX_ASSERT(read(standardPath.openUser(StandardPath::Type::PkgConfig,
+                                                "queue/b", O_RDONLY)) == "b");
+        // Written before it is destroyed.
+        standardPath.queueSave(StandardPath::Type::PkgConfig, "queue/c", "c");
+    }
+    StandardPath standardPath(true);
+    FCITX_ASSERT(read(standardPath.open(StandardPath::Type::PkgConfig,
+                                        "queue/c", O_RDONLY)) == "c");
+
+    FCITX_ASSERT(system(("rm -rf " + dir).data()) == 0);
+}
+
 int main() {
     test_basic();
     test_nouser();
     test_custom();
+    test_cache();
+    test_queue_save();
     return 0;
 }
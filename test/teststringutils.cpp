@@ -5,6 +5,10 @@
  *
  */
 
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "fcitx-utils/charutils.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/macros.h"
@@ -115,6 +119,35 @@ int main() {
         stringutils::split("", ",", stringutils::SplitBehavior::KeepEmpty) ==
         (std::vector<std::string>{""}));
 
+    for (const auto &[str, delim] :
+         std::vector<std::pair<std::string, std::string>>{
+             {"a  b c", FCITX_WHITESPACE},
+             {" a b ", FCITX_WHITESPACE},
+             {" ", FCITX_WHITESPACE},
+             {"", ","},
+             {",dvorak,,", ","},
+             {"dvorak", ","},
+             {",,a,,b", ",;"}}) {
+        for (auto behavior : {stringutils::SplitBehavior::KeepEmpty,
+                              stringutils::SplitBehavior::SkipEmpty}) {
+            std::vector<std::string> pieces;
+            for (auto piece : stringutils::splitView(str, delim, behavior)) {
+                pieces.emplace_back(piece);
+            }
+            FCITX_ASSERT(pieces == stringutils::split(str, delim, behavior))
+                << str;
+        }
+    }
+    auto tokens = stringutils::tokenize("\ta  b\n c ");
+    FCITX_ASSERT((std::vector<std::string_view>(tokens.begin(), tokens.end()) ==
+                  std::vector<std::string_view>{"a", "b", "c"}));
+    FCITX_ASSERT(stringutils::tokenize(" ").begin() ==
+                 stringutils::tokenize(" ").end());
+
+    FCITX_ASSERT(stringutils::join({"a", "b", "c"}, ",") == "a,b,c");
+    FCITX_ASSERT(stringutils::join(std::vector<std::string>{}, ",").empty());
+    FCITX_ASSERT(stringutils::join(std::vector<std::string>{"a"}, ",") == "a");
+
     FCITX_ASSERT(stringutils::escapeForValue("\"") == R"("\"")");
     FCITX_ASSERT(stringutils::escapeForValue("\"\"\n") == R"("\"\"\n")");
     FCITX_ASSERT(stringutils::escapeForValue("abc") == R"(abc)");
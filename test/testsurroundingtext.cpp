@@ -10,6 +10,138 @@
 
 using namespace fcitx;
 
+void test_replace() {
+    SurroundingText surroundingText;
+    FCITX_ASSERT(!surroundingText.replace(0, 0, "a"));
+    FCITX_ASSERT(surroundingText.byteOffset(0) == std::string::npos);
+
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += "\xe4\xbd\xa0"
+                "a";
+    }
+    // cursor is after the 100th character, anchor after 150th.
+    surroundingText.setText(text, 100, 150);
+    FCITX_ASSERT(surroundingText.byteOffset(0) == 0);
+    FCITX_ASSERT(surroundingText.byteOffset(100) == 200);
+    FCITX_ASSERT(surroundingText.byteOffset(151) == 303);
+    FCITX_ASSERT(surroundingText.byteOffset(400) == text.size());
+    FCITX_ASSERT(surroundingText.byteOffset(401) == std::string::npos);
+
+    // Before cursor.
+    FCITX_ASSERT(surroundingText.replace(10, 12, "bcd"));
+    FCITX_ASSERT(surroundingText.cursor() == 101);
+    FCITX_ASSERT(surroundingText.anchor() == 151);
+    FCITX_ASSERT(surroundingText.byteOffset(10) == 20);
+    FCITX_ASSERT(surroundingText.byteOffset(13) == 23);
+    FCITX_ASSERT(surroundingText.byteOffset(101) == 199);
+    FCITX_ASSERT(surroundingText.byteOffset(401) == text.size() - 1);
+
+    // Covers anchor.
+    FCITX_ASSERT(surroundingText.replace(140, 160, ""));
+    FCITX_ASSERT(surroundingText.cursor() == 101);
+    FCITX_ASSERT(surroundingText.anchor() == 140);
+    FCITX_ASSERT(surroundingText.byteOffset(381) == 759);
+    FCITX_ASSERT(surroundingText.byteOffset(382) == std::string::npos);
+
+    FCITX_ASSERT(!surroundingText.replace(0, 1, "\xe4"));
+    FCITX_ASSERT(!surroundingText.replace(2, 1, "a"));
+    FCITX_ASSERT(!surroundingText.replace(0, 382, "a"));
+
+    std::string expect = text.substr(0, 20) + "bcd" + text.substr(24, 255) +
+                         text.substr(319);
+    FCITX_ASSERT(surroundingText.text() == expect);
+    FCITX_ASSERT(surroundingText.selectedText() == expect.substr(199, 79));
+
+    auto deleteEnd = surroundingText.byteOffset(304);
+    surroundingText.setCursor(5, 5);
+    surroundingText.deleteText(-1, 300);
+    FCITX_ASSERT(surroundingText.cursor() == 4);
+    FCITX_ASSERT(surroundingText.text() ==
+                 expect.substr(0, 8) + expect.substr(deleteEnd));
+    FCITX_ASSERT(surroundingText.byteOffset(4) == 8);
+    FCITX_ASSERT(surroundingText.byteOffset(81) ==
+                 surroundingText.text().size());
+}
+
+void test_byte_offset() {
+    SurroundingText surroundingText;
+    // Invalid position.
+    surroundingText.setTextWithByteOffset("\xe3\x81\x82" "b", 1, 1);
+    FCITX_ASSERT(!surroundingText.isValid());
+    surroundingText.setTextWithByteOffset("\xe3\x81\x82" "b", 3, 4);
+    FCITX_ASSERT(surroundingText.isValid());
+    FCITX_ASSERT(surroundingText.cursor() == 1);
+    FCITX_ASSERT(surroundingText.anchor() == 2);
+
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text.append(i % 2 ? "a" : "\xe3\x81\x82");
+    }
+    surroundingText.setTextWithByteOffset(text, 400, 400);
+    FCITX_ASSERT(surroundingText.cursor() == 200);
+    // Only the cursor is moved.
+    surroundingText.setTextWithByteOffset(text, 200, 4);
+    FCITX_ASSERT(surroundingText.cursor() == 100);
+    FCITX_ASSERT(surroundingText.anchor() == 2);
+
+    // Replace a character in the middle with another one sharing the
+    // leading byte.
+    auto changed = text;
+    changed.replace(200, 3, "\xe3\x81\x84");
+    surroundingText.setTextWithByteOffset(changed, 203, 203);
+    FCITX_ASSERT(surroundingText.text() == changed);
+    FCITX_ASSERT(surroundingText.cursor() == 101);
+    FCITX_ASSERT(surroundingText.byteOffset(150) == 300);
+
+    // Insert and delete.
+    changed.insert(0, "xy");
+    changed.erase(changed.size() - 4);
+    surroundingText.setTextWithByteOffset(changed, changed.size(), 2);
+    FCITX_ASSERT(surroundingText.text() == changed);
+    FCITX_ASSERT(surroundingText.cursor() == 200);
+    FCITX_ASSERT(surroundingText.anchor() == 2);
+
+    // Changed part is not valid.
+    auto invalid = changed;
+    invalid[100] = '\xff';
+    surroundingText.setTextWithByteOffset(invalid, 0, 0);
+    FCITX_ASSERT(!surroundingText.isValid());
+    surroundingText.setTextWithByteOffset(changed, 0, 0);
+    FCITX_ASSERT(surroundingText.isValid());
+    FCITX_ASSERT(surroundingText.text() == changed);
+    surroundingText.setTextWithByteOffset(changed, changed.size() + 1, 0);
+    FCITX_ASSERT(!surroundingText.isValid());
+}
+
+void test_window() {
+    SurroundingText surroundingText;
+    FCITX_ASSERT(surroundingText.setTextInWindow("abcdef", 3, 3, 0) == 0);
+    FCITX_ASSERT(surroundingText.text() == "abcdef");
+
+    FCITX_ASSERT(surroundingText.setTextInWindow("abcdef", 3, 3, 2) == 1);
+    FCITX_ASSERT(surroundingText.text() == "bcde");
+    FCITX_ASSERT(surroundingText.cursor() == 2);
+    FCITX_ASSERT(surroundingText.anchor() == 2);
+
+    // Window around the selection, the skipped prefix is not validated.
+    FCITX_ASSERT(surroundingText.setTextInWindow("\xff\xe3\x81\x82"
+                                                 "bcdあef",
+                                                 5, 3, 1) == 2);
+    FCITX_ASSERT(surroundingText.text() == "bcdあ");
+    FCITX_ASSERT(surroundingText.cursor() == 3);
+    FCITX_ASSERT(surroundingText.anchor() == 1);
+
+    FCITX_ASSERT(surroundingText.setTextInWindow("abc", 0, 3, 10) == 0);
+    FCITX_ASSERT(surroundingText.text() == "abc");
+    FCITX_ASSERT(surroundingText.anchor() == 3);
+
+    surroundingText.setTextInWindow("abc", 4, 4, 1);
+    FCITX_ASSERT(!surroundingText.isValid());
+    surroundingText.setTextInWindow("abc\xff", 1, 1, 3);
+    FCITX_ASSERT(!surroundingText.isValid());
+}
+
 int main() {
     SurroundingText surroundingText;
     FCITX_ASSERT(!surroundingText.isValid());
@@ -45,5 +177,9 @@ int main() {
     FCITX_ASSERT(surroundingText.text() == "abcd");
     FCITX_ASSERT(surroundingText.cursor() == 1);
     FCITX_ASSERT(surroundingText.anchor() == 1);
+
+    test_replace();
+    test_byte_offset();
+    test_window();
     return 0;
 }
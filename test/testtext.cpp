@@ -67,8 +67,50 @@ void test_normalize() {
     FCITX_ASSERT(normalizedEmpty.empty()) << normalizedEmpty;
 }
 
+void test_fragments() {
+    Text text("A", TextFormatFlag::Bold);
+    FCITX_ASSERT(text.size() == 1);
+    text.append("B", TextFormatFlag::Underline);
+    text.append("C");
+    Text copy = text;
+    FCITX_ASSERT(copy.size() == 3);
+    FCITX_ASSERT(copy.stringAt(0) == "A");
+    FCITX_ASSERT(copy.formatAt(0) == TextFormatFlag::Bold);
+    FCITX_ASSERT(copy.stringAt(1) == "B");
+    FCITX_ASSERT(copy.formatAt(1) == TextFormatFlag::Underline);
+    FCITX_ASSERT(copy.stringAt(2) == "C");
+
+    Text joined("X");
+    joined.append(std::move(copy));
+    FCITX_ASSERT(joined.size() == 4);
+    FCITX_ASSERT(joined.toString() == "XABC");
+    FCITX_ASSERT(joined.formatAt(1) == TextFormatFlag::Bold);
+
+    joined.clear();
+    FCITX_ASSERT(joined.empty());
+    joined.append("D");
+    FCITX_ASSERT(joined.size() == 1);
+    FCITX_ASSERT(joined.toString() == "D");
+}
+
+void test_equal() {
+    Text text("A", TextFormatFlag::Underline);
+    text.append("B");
+    Text other("A", TextFormatFlag::Underline);
+    other.append("B");
+    FCITX_ASSERT(text == other);
+    other.setCursor(1);
+    FCITX_ASSERT(text != other);
+    other = Text("A");
+    other.append("B");
+    FCITX_ASSERT(text != other);
+    FCITX_ASSERT(Text() == Text());
+}
+
 int main() {
     test_basic();
     test_normalize();
+    test_fragments();
+    test_equal();
     return 0;
 }
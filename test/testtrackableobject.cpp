@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <memory>
+#include <utility>
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/trackableobject.h"
+
+using namespace fcitx;
+
+class Object : public TrackableObject<Object> {};
+class LocalObject : public LocalTrackableObject<LocalObject> {};
+
+template <typename T>
+void test() {
+    auto obj = std::make_unique<T>();
+    auto ref = obj->watch();
+    FCITX_ASSERT(ref.isValid());
+    FCITX_ASSERT(!ref.isNull());
+    FCITX_ASSERT(ref.get() == obj.get());
+
+    auto copy = ref;
+    auto moved = std::move(copy);
+    FCITX_ASSERT(moved.get() == obj.get());
+    const T *constObj = obj.get();
+    auto constRef = constObj->watch();
+    FCITX_ASSERT(constRef.get() == constObj);
+
+    decltype(ref) empty;
+    FCITX_ASSERT(empty.isNull());
+    FCITX_ASSERT(!empty.isValid());
+    FCITX_ASSERT(empty.get() == nullptr);
+
+    auto unwatched = ref;
+    unwatched.unwatch();
+    FCITX_ASSERT(unwatched.isNull());
+    FCITX_ASSERT(unwatched.get() == nullptr);
+
+    obj.reset();
+    FCITX_ASSERT(!ref.isValid());
+    FCITX_ASSERT(!ref.isNull());
+    FCITX_ASSERT(ref.get() == nullptr);
+    FCITX_ASSERT(moved.get() == nullptr);
+    FCITX_ASSERT(constRef.get() == nullptr);
+
+    // The reference may also go away before the object.
+    auto other = std::make_unique<T>();
+    {
+        auto otherRef = other->watch();
+        ref = otherRef;
+    }
+    FCITX_ASSERT(ref.get() == other.get());
+}
+
+int main() {
+    test<Object>();
+    test<LocalObject>();
+    return 0;
+}
@@ -15,17 +15,19 @@ using namespace fcitx;
 
 void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([instance]() {
-        auto *unicode = instance->addonManager().addon("unicode", true);
-        FCITX_ASSERT(unicode);
+        // Unicode is loaded by its trigger key.
+        FCITX_ASSERT(!instance->addonManager().lookupAddon("unicode"));
     });
     dispatcher->schedule([dispatcher, instance]() {
         auto *testfrontend = instance->addonManager().addon("testfrontend");
         testfrontend->call<ITestFrontend::pushCommitExpectation>("🍏");
         testfrontend->call<ITestFrontend::pushCommitExpectation>("’");
+        testfrontend->call<ITestFrontend::pushCommitExpectation>("🔥");
         auto uuid =
             testfrontend->call<ITestFrontend::createInputContext>("testapp");
         testfrontend->call<ITestFrontend::keyEvent>(
             uuid, Key("Control+Alt+Shift+u"), false);
+        FCITX_ASSERT(instance->addonManager().lookupAddon("unicode"));
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), false);
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("p"), false);
         testfrontend->call<ITestFrontend::keyEvent>(
@@ -64,6 +66,15 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("9"), false);
         testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("space"), false);
 
+        // Exact name match comes before other characters mentioning fire.
+        testfrontend->call<ITestFrontend::keyEvent>(
+            uuid, Key("Control+Alt+Shift+u"), false);
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("f"), false);
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("i"), false);
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("r"), false);
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("e"), false);
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("Alt+1"), false);
+
         dispatcher->schedule([dispatcher, instance]() {
             dispatcher->detach();
             instance->exit();
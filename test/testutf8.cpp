@@ -5,14 +5,97 @@
  *
  */
 
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <random>
+#include <string>
+#include <vector>
 #include "fcitx-utils/cutf8.h"
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/utf8.h"
 
 #define BUF_SIZE 9
 
+namespace {
+
+// Character at a time implementation, used as a reference.
+size_t referenceLengthValidated(const char *str, size_t byte) {
+    size_t len = 0;
+    while (byte && *str) {
+        int charLen = 0;
+        uint32_t chr = fcitx_utf8_get_char_validated(
+            str, (byte > FCITX_UTF8_MAX_LENGTH ? FCITX_UTF8_MAX_LENGTH : byte),
+            &charLen);
+        if (chr == fcitx::utf8::NOT_ENOUGH_SPACE ||
+            chr == fcitx::utf8::INVALID_CHAR) {
+            return fcitx::utf8::INVALID_LENGTH;
+        }
+        str += charLen;
+        byte -= charLen;
+        len++;
+    }
+    return len;
+}
+
+size_t referenceLength(const char *str, size_t byte) {
+    size_t len = 0;
+    while (byte && *str) {
+        uint32_t chr;
+        const char *next = fcitx_utf8_get_char(str, &chr);
+        size_t diff = next - str;
+        if (byte < diff) {
+            break;
+        }
+        byte -= diff;
+        str = next;
+        len++;
+    }
+    return len;
+}
+
+void test_length_fast_path() {
+    const std::vector<std::string> pieces = {
+        "a",
+        "abcdefgh",
+        "\xc3\xa9",
+        "\xe4\xbd\xa0",
+        "\xf0\x9f\x98\x80",
+        // U+0800, U+D7FF, surrogate, overlong, overlong.
+        "\xe0\xa0\x80",
+        "\xed\x9f\xbf",
+        "\xed\xa0\x80",
+        "\xe0\x80\x80",
+        "\xc0\xaf",
+        "\x80",
+        "\xff",
+        std::string(1, '\0'),
+        "\xe4\xbd",
+    };
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<size_t> dist(0, pieces.size() - 1);
+    for (int round = 0; round < 20000; round++) {
+        std::string str;
+        for (int i = 0, e = round % 24; i < e; i++) {
+            str += pieces[dist(gen)];
+        }
+        // Check different alignment and truncation.
+        for (size_t offset = 0; offset < std::min<size_t>(str.size(), 8);
+             offset++) {
+            const char *s = str.data() + offset;
+            size_t byte = str.size() - offset;
+            FCITX_ASSERT(fcitx_utf8_strnlen_validated(s, byte) ==
+                         referenceLengthValidated(s, byte));
+            FCITX_ASSERT(fcitx_utf8_strnlen(s, byte) ==
+                         referenceLength(s, byte));
+            FCITX_ASSERT(fcitx_utf8_strnlen(s, byte / 2) ==
+                         referenceLength(s, byte / 2));
+        }
+    }
+}
+
+} // namespace
+
 int main() {
     char buf[BUF_SIZE];
     const char string[] = "\xe4\xbd\xa0\xe5\xa5\xbd\xe6\xb5"
@@ -97,5 +180,7 @@ int main() {
     FCITX_ASSERT(fcitx::utf8::UCS4IsValid(0xffff));
     FCITX_ASSERT(!fcitx::utf8::UCS4IsValid(0x200000));
 
+    test_length_fast_path();
+
     return 0;
 }
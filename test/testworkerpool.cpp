@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/trackableobject.h"
+#include "fcitx-utils/workerpool.h"
+
+using namespace fcitx;
+
+class Context : public TrackableObject<Context> {};
+
+void testContinuation() {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+    WorkerPool pool(&dispatcher, 2);
+    FCITX_ASSERT(pool.maxThreads() == 2);
+
+    Context context;
+    auto mainThread = std::this_thread::get_id();
+    std::vector<int> results;
+    for (int i = 0; i < 10; i++) {
+        pool.run(
+            WorkPriority::Interactive, context.watch(),
+            [i, mainThread]() {
+                FCITX_ASSERT(std::this_thread::get_id() != mainThread);
+                return i * i;
+            },
+            [&results, &loop, mainThread](int result) {
+                FCITX_ASSERT(std::this_thread::get_id() == mainThread);
+                results.push_back(result);
+                if (results.size() == 10) {
+                    loop.exit();
+                }
+            });
+    }
+    loop.exec();
+    FCITX_ASSERT(results.size() == 10);
+    int sum = 0;
+    for (auto result : results) {
+        sum += result;
+    }
+    FCITX_ASSERT(sum == 285) << sum;
+}
+
+void testContextGone() {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+    WorkerPool pool(&dispatcher, 1);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool started = false;
+    bool release = false;
+    bool called = false;
+    auto context = std::make_unique<Context>();
+    pool.run(
+        WorkPriority::Interactive, context->watch(),
+        [&]() {
+            std::unique_lock lock(mutex);
+            started = true;
+            condition.notify_all();
+            condition.wait(lock, [&release]() { return release; });
+        },
+        [&called]() { called = true; });
+    {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [&started]() { return started; });
+    }
+    context.reset();
+    {
+        std::lock_guard lock(mutex);
+        release = true;
+    }
+    condition.notify_all();
+    while (pool.pending()) {
+        std::this_thread::yield();
+    }
+    dispatcher.schedule([&loop]() { loop.exit(); });
+    loop.exec();
+    FCITX_ASSERT(!called);
+}
+
+void testPriority() {
+    EventLoop loop;
+    EventDispatcher dispatcher;
+    dispatcher.attach(&loop);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool release = false;
+    std::atomic<int> prefetchRunning = 0;
+    std::atomic<bool> interactiveDone = false;
+    {
+        WorkerPool pool(&dispatcher, 2);
+        // Prefetch work never takes the last thread.
+        for (int i = 0; i < 2; i++) {
+            pool.run(WorkPriority::Prefetch, [&]() {
+                prefetchRunning++;
+                std::unique_lock lock(mutex);
+                condition.wait(lock, [&release]() { return release; });
+            });
+        }
+        while (prefetchRunning == 0) {
+            std::this_thread::yield();
+        }
+        pool.run(WorkPriority::Interactive,
+                 [&interactiveDone]() { interactiveDone = true; });
+        while (!interactiveDone) {
+            std::this_thread::yield();
+        }
+        FCITX_ASSERT(prefetchRunning == 1);
+        {
+            std::lock_guard lock(mutex);
+            release = true;
+        }
+        condition.notify_all();
+        while (pool.pending()) {
+            std::this_thread::yield();
+        }
+    }
+    FCITX_ASSERT(prefetchRunning == 2);
+}
+
+int main() {
+    testContinuation();
+    testContextGone();
+    testPriority();
+    return 0;
+}
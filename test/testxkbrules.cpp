@@ -6,11 +6,54 @@
  */
 
 #include "config.h"
+#include "fcitx-utils/log.h"
 #include "im/keyboard/xkbrules.h"
 
+void testSnapshot(const fcitx::XkbRules &xkbRules) {
+    fcitx::MetadataSnapshot::Writer writer;
+    xkbRules.save(writer);
+    fcitx::MetadataSnapshot::Reader reader(writer.data());
+    fcitx::XkbRules loaded;
+    FCITX_ASSERT(loaded.load(reader));
+    FCITX_ASSERT(reader.atEnd());
+    FCITX_ASSERT(loaded.version() == xkbRules.version());
+    FCITX_ASSERT(loaded.layoutInfos().size() == xkbRules.layoutInfos().size());
+    for (const auto &[name, layoutInfo] : xkbRules.layoutInfos()) {
+        const auto *loadedInfo = loaded.findByName(name);
+        FCITX_ASSERT(loadedInfo);
+        FCITX_ASSERT(loadedInfo->description == layoutInfo.description);
+        FCITX_ASSERT(loadedInfo->shortDescription ==
+                     layoutInfo.shortDescription);
+        FCITX_ASSERT(loadedInfo->languages == layoutInfo.languages);
+        FCITX_ASSERT(loadedInfo->variantInfos.size() ==
+                     layoutInfo.variantInfos.size());
+        for (size_t i = 0; i < layoutInfo.variantInfos.size(); i++) {
+            FCITX_ASSERT(loadedInfo->variantInfos[i].name ==
+                         layoutInfo.variantInfos[i].name);
+            FCITX_ASSERT(loadedInfo->variantInfos[i].languages ==
+                         layoutInfo.variantInfos[i].languages);
+        }
+    }
+    FCITX_ASSERT(loaded.modelInfos().size() == xkbRules.modelInfos().size());
+    FCITX_ASSERT(loaded.optionGroupInfos().size() ==
+                 xkbRules.optionGroupInfos().size());
+    for (size_t i = 0; i < xkbRules.optionGroupInfos().size(); i++) {
+        FCITX_ASSERT(loaded.optionGroupInfos()[i].exclusive ==
+                     xkbRules.optionGroupInfos()[i].exclusive);
+        FCITX_ASSERT(loaded.optionGroupInfos()[i].optionInfos.size() ==
+                     xkbRules.optionGroupInfos()[i].optionInfos.size());
+    }
+
+    // Truncated data is rejected.
+    fcitx::MetadataSnapshot::Reader truncated(
+        std::string_view(writer.data()).substr(0, writer.data().size() / 2));
+    FCITX_ASSERT(!loaded.load(truncated));
+}
+
 int main() {
     fcitx::XkbRules xkbRules;
     xkbRules.read({XKEYBOARDCONFIG_XKBBASE}, DEFAULT_XKB_RULES, {});
     xkbRules.dump();
+    testSnapshot(xkbRules);
     return 0;
 }